@@ -28,6 +28,7 @@
 #include "asyncfatfs.h"
 #include "fat_standard.h"
 #include "Blackbox/sd.h"
+#include "Comun/buffer_anillo.h"
 #include "Comun/util.h"
 #include "Comun/matematicas.h"
 
@@ -94,6 +95,28 @@
 
 #define AFATFS_INTROSPEC_LOG_FILENAME "ASYNCFAT.LOG"
 
+#ifdef AFATFS_USE_FREEFILE
+/*
+ * A new contiguous append file (mode "as") is streamed: fwrite() copies into a ring of sectors instead of the sector
+ * cache, runs of whole sectors go from the ring to the card with one multiple block write, superclusters are taken
+ * from the freefile in memory ahead of the data and the FAT/directory entries are brought up to date later, batched.
+ * The sector cache is then only used for metadata.
+ */
+#define AFATFS_USE_STREAM
+
+// Size of the ring (must be a power of two)
+#define AFATFS_STREAM_RING_SECTORS 64
+
+// Wait for this many sectors before starting a write, unless we're flushing or closing
+#define AFATFS_STREAM_MIN_WRITE_SECTORS 8
+
+/*
+ * The FAT and directory entries of allocated superclusters are only written while the ring is less than half full,
+ * unless this many superclusters are pending.
+ */
+#define AFATFS_STREAM_MAX_LAZY_SUPERCLUSTERS 2
+#endif
+
 typedef enum {
     AFATFS_SAVE_DIRECTORY_NORMAL,
     AFATFS_SAVE_DIRECTORY_FOR_CLOSE,
@@ -422,6 +445,21 @@ typedef enum {
     AFATFS_INITIALIZATION_DONE
 } afatfsInitializationPhase_e;
 
+#ifdef AFATFS_USE_STREAM
+typedef struct afatfsStream_t {
+    afatfsFile_t *file;          // The file being streamed, or NULL
+
+    bufferAnillo_t ring;         // Data of the file that hasn't reached the card yet, starting on a sector boundary
+
+    uint32_t sectorsWritten;     // Sectors of the file that are on the card
+    uint32_t sectorsInFlight;    // Sectors of the write the card is transmitting, 0 if none
+    uint32_t fatChainEndCluster; // Clusters before this one have their FAT entries written (or queued to be)
+
+    bool forceWrite;             // Write out whole sectors even if there are fewer than AFATFS_STREAM_MIN_WRITE_SECTORS
+    bool closing;                // The tail has been padded to a sector and no more data will arrive
+} afatfsStream_t;
+#endif
+
 typedef struct afatfs_t {
     fatFilesystemType_e filesystemType;
 
@@ -453,6 +491,10 @@ typedef struct afatfs_t {
     afatfsFile_t freeFile;
 #endif
 
+#ifdef AFATFS_USE_STREAM
+    afatfsStream_t stream;
+#endif
+
 #ifdef AFATFS_USE_INTROSPECTIVE_LOGGING
     afatfsFile_t introSpecLog;
 #endif
@@ -494,9 +536,23 @@ typedef struct afatfs_t {
 static DMA_RW_AXI uint8_t afatfs_cache[AFATFS_SECTOR_SIZE * AFATFS_NUM_CACHE_SECTORS] __attribute__((aligned(32)));
 #endif
 
+#ifdef AFATFS_USE_STREAM
+#ifdef STM32H7
+static DMA_RW_AXI uint8_t afatfs_streamMemory[AFATFS_SECTOR_SIZE * AFATFS_STREAM_RING_SECTORS] __attribute__((aligned(32)));
+#else
+static uint8_t afatfs_streamMemory[AFATFS_SECTOR_SIZE * AFATFS_STREAM_RING_SECTORS] __attribute__((aligned(32)));
+#endif
+
+// Kept outside of afatfs so that it survives afatfs_destroy()
+static bool afatfs_streamDisabled;
+#endif
+
 static afatfs_t afatfs;
 
 static void afatfs_fileOperationContinue(afatfsFile_t *file);
+#ifdef AFATFS_USE_STREAM
+static uint32_t afatfs_streamQueuedSectors(void);
+#endif
 static uint8_t* afatfs_fileLockCursorSectorForWrite(afatfsFilePtr_t file);
 static uint8_t* afatfs_fileRetainCursorSectorForRead(afatfsFilePtr_t file);
 
@@ -725,6 +781,14 @@ bool afatfs_sectorCacheInSync(void)
             return false;
         }
     }
+
+#ifdef AFATFS_USE_STREAM
+    if (afatfs.stream.file != NULL && (afatfs.stream.sectorsInFlight > 0 || afatfs_streamQueuedSectors() > 0)) {
+        afatfs.stream.forceWrite = true;
+        return false;
+    }
+#endif
+
     return true;
 }
 
@@ -1771,6 +1835,272 @@ static afatfsOperationStatus_e afatfs_appendSupercluster(afatfsFilePtr_t file)
 
 #endif
 
+#ifdef AFATFS_USE_STREAM
+
+/**
+ * Start streaming the given file, which must be a newly created (empty) contiguous append file.
+ */
+static void afatfs_streamBegin(afatfsFile_t *file)
+{
+    afatfsStream_t *stream = &afatfs.stream;
+
+    memset(stream, 0, sizeof(*stream));
+    iniciarBufferAnillo(&stream->ring, afatfs_streamMemory, sizeof(afatfs_streamMemory));
+    stream->file = file;
+}
+
+static bool afatfs_fileIsStreamed(afatfsFilePtr_t file)
+{
+    return file == afatfs.stream.file;
+}
+
+/**
+ * Number of whole sectors in the ring that haven't been handed to the card yet.
+ */
+static uint32_t afatfs_streamQueuedSectors(void)
+{
+    return (bytesOcupadosBufferAnillo(&afatfs.stream.ring) / AFATFS_SECTOR_SIZE) - afatfs.stream.sectorsInFlight;
+}
+
+/**
+ * Copy data to the end of the streamed file. Never blocks on the card or the filesystem, bytes that don't fit in the
+ * ring are dropped.
+ */
+static uint32_t afatfs_streamWrite(afatfsFile_t *file, const uint8_t *buffer, uint32_t len)
+{
+    if (afatfs.stream.closing) {
+        return 0;
+    }
+
+    // Once the freefile is exhausted only the space already allocated can be filled
+    if (afatfs.filesystemFull) {
+        len = MIN(len, file->physicalSize - MIN(file->cursorOffset, file->physicalSize));
+    }
+
+    uint32_t writtenBytes = escribirBufferAnillo(&afatfs.stream.ring, buffer, len);
+
+    file->cursorOffset += writtenBytes;
+
+    return writtenBytes;
+}
+
+/**
+ * Take the first supercluster of the freefile for the streamed file. Only the in-memory state is changed, the FAT
+ * and directory entries are written later by afatfs_streamQueueMetadata().
+ */
+static bool afatfs_streamAllocateSupercluster(afatfsFile_t *file)
+{
+    uint32_t superClusterSize = afatfs_superClusterSize();
+
+    if (afatfs.freeFile.logicalSize < superClusterSize) {
+        afatfs.filesystemFull = true;
+        return false;
+    }
+
+    if (file->firstCluster == 0) {
+        file->firstCluster = afatfs.freeFile.firstCluster;
+        file->cursorCluster = file->firstCluster;
+        afatfs.stream.fatChainEndCluster = file->firstCluster;
+    }
+
+    afatfs.freeFile.firstCluster += afatfs_fatEntriesPerSector();
+    afatfs.freeFile.logicalSize -= superClusterSize;
+    afatfs.freeFile.physicalSize -= superClusterSize;
+
+    file->physicalSize += superClusterSize;
+
+    return true;
+}
+
+/**
+ * Queue the FAT and directory updates for all the superclusters allocated since the last update, as one
+ * AFATFS_FILE_OPERATION_APPEND_SUPERCLUSTER operation which begins after its INIT phase.
+ */
+static void afatfs_streamQueueMetadata(afatfsFile_t *file)
+{
+    afatfsAppendSupercluster_t *opState = &file->operation.state.appendSupercluster;
+    afatfsStream_t *stream = &afatfs.stream;
+
+    if (stream->fatChainEndCluster == file->firstCluster) {
+        opState->fatRewriteStartCluster = file->firstCluster;
+    } else {
+        // The old terminator must become a link to the new superclusters
+        opState->fatRewriteStartCluster = stream->fatChainEndCluster - afatfs_fatEntriesPerSector();
+    }
+    opState->fatRewriteEndCluster = afatfs.freeFile.firstCluster;
+    opState->previousCluster = 0;
+    opState->phase = AFATFS_APPEND_SUPERCLUSTER_PHASE_UPDATE_FREEFILE_DIRECTORY;
+
+    file->operation.operation = AFATFS_FILE_OPERATION_APPEND_SUPERCLUSTER;
+    stream->fatChainEndCluster = afatfs.freeFile.firstCluster;
+
+    afatfs_appendSuperclusterContinue(file);
+}
+
+/**
+ * Called by the SD card driver when the transmission of a stream write completes.
+ */
+static void afatfs_streamWriteComplete(operacionBloqueSD_e operation, uint32_t sectorIndex, uint8_t *buffer, uint32_t callbackData)
+{
+    afatfsStream_t *stream = &afatfs.stream;
+
+    (void) operation;
+    (void) sectorIndex;
+    (void) callbackData;
+
+    if (stream->sectorsInFlight == 0) {
+        return;
+    }
+
+    // On failure the sectors stay in the ring and are sent again
+    if (buffer != NULL) {
+        consumirBufferAnillo(&stream->ring, stream->sectorsInFlight * AFATFS_SECTOR_SIZE);
+        stream->sectorsWritten += stream->sectorsInFlight;
+    }
+
+    stream->sectorsInFlight = 0;
+}
+
+/**
+ * Allocate space ahead of the data, keep the metadata up to date and send the next run of whole sectors to the card.
+ */
+static void afatfs_streamContinue(void)
+{
+    afatfsStream_t *stream = &afatfs.stream;
+    afatfsFile_t *file = stream->file;
+    const uint8_t *data;
+
+    if (file == NULL || stream->sectorsInFlight > 0) {
+        return;
+    }
+
+    uint32_t queuedSectors = afatfs_streamQueuedSectors();
+    uint32_t allocatedSectors = file->physicalSize / AFATFS_SECTOR_SIZE;
+
+    /*
+     * Keep a whole ring of space allocated beyond the data so that the metadata can be written before the data
+     * reaches the new supercluster. No allocation while a metadata update is using the freefile position.
+     */
+    uint32_t neededSectors = stream->sectorsWritten + queuedSectors + (stream->closing ? 0 : AFATFS_STREAM_RING_SECTORS);
+
+    if (!afatfs_fileIsBusy(file) && neededSectors > allocatedSectors) {
+        if (afatfs_streamAllocateSupercluster(file)) {
+            allocatedSectors = file->physicalSize / AFATFS_SECTOR_SIZE;
+        }
+    }
+
+    if (!afatfs_fileIsBusy(file) && file->firstCluster != 0 && stream->fatChainEndCluster != afatfs.freeFile.firstCluster) {
+        uint32_t pendingSuperclusters = (afatfs.freeFile.firstCluster - stream->fatChainEndCluster) / afatfs_fatEntriesPerSector();
+
+        if (stream->closing || pendingSuperclusters >= AFATFS_STREAM_MAX_LAZY_SUPERCLUSTERS
+                || bytesOcupadosBufferAnillo(&stream->ring) < sizeof(afatfs_streamMemory) / 2) {
+            afatfs_streamQueueMetadata(file);
+        }
+    }
+
+    if (queuedSectors == 0 || (queuedSectors < AFATFS_STREAM_MIN_WRITE_SECTORS && !stream->forceWrite && !stream->closing)) {
+        return;
+    }
+
+    // Sectors are only written into allocated space, and a single write can't wrap around the end of the ring
+    uint32_t sectors = MIN(bloqueBufferAnillo(&stream->ring, &data) / AFATFS_SECTOR_SIZE, allocatedSectors - stream->sectorsWritten);
+    sectors = MIN(sectors, maxBloquesEscrituraSD());
+
+    if (sectors == 0) {
+        return;
+    }
+
+    uint32_t physicalSector = afatfs_fileClusterToPhysical(file->firstCluster, stream->sectorsWritten);
+    estadoOperacionSD_e status;
+
+    if (maxBloquesEscrituraSD() == 1) {
+        // One block per command (SPI): let the card stream the consecutive blocks
+        iniciarEscrituraBloquesSD(physicalSector, queuedSectors);
+        status = escribirBloqueSD(physicalSector, (uint8_t *) data, afatfs_streamWriteComplete, 0);
+    } else {
+        // Multi-block drivers keep the stream on their own path even for a lone sector
+        status = escribirBloquesSD(physicalSector, (uint8_t *) data, sectors, afatfs_streamWriteComplete, 0);
+    }
+
+    switch (status) {
+        case SD_OPERACION_EN_PROGRESO:
+            stream->sectorsInFlight = sectors;
+            stream->forceWrite = false;
+            break;
+
+        case SD_OPERACION_EXITO:
+            stream->sectorsInFlight = sectors;
+            afatfs_streamWriteComplete(SD_OPERACION_BLOQUE_ESCRIBIR, physicalSector, (uint8_t *) data, 0);
+            break;
+
+        case SD_OPERACION_OCUPADO:
+        case SD_OPERACION_FALLO:
+        default:
+            ;
+    }
+}
+
+/**
+ * Pad the file out to a whole sector and drain the ring. Returns true once all the data and metadata of the file
+ * have been handed over (to the card or the sector cache) and the file is no longer streamed.
+ */
+static bool afatfs_streamFinish(afatfsFile_t *file)
+{
+    afatfsStream_t *stream = &afatfs.stream;
+
+    if (!stream->closing) {
+        uint32_t padding = (AFATFS_SECTOR_SIZE - file->cursorOffset % AFATFS_SECTOR_SIZE) % AFATFS_SECTOR_SIZE;
+        uint8_t *tail;
+
+        if (padding > 0) {
+            // The padding never wraps since the ring holds a whole number of sectors
+            if (reservarBufferAnillo(&stream->ring, &tail, padding) < padding) {
+                return false;
+            }
+            memset(tail, 0, padding);
+            publicarBufferAnillo(&stream->ring, padding);
+        }
+
+        stream->closing = true;
+    }
+
+    if (stream->sectorsInFlight > 0 || afatfs_fileIsBusy(file)) {
+        return false;
+    }
+
+    // Data that doesn't fit on the full disk is dropped
+    if (afatfs.filesystemFull && stream->sectorsWritten * AFATFS_SECTOR_SIZE >= file->physicalSize) {
+        vaciarBufferAnillo(&stream->ring);
+        file->cursorOffset = MIN(file->cursorOffset, file->physicalSize);
+    }
+
+    if (bytesOcupadosBufferAnillo(&stream->ring) > 0
+            || (file->firstCluster != 0 && stream->fatChainEndCluster != afatfs.freeFile.firstCluster)) {
+        return false;
+    }
+
+    stream->file = NULL;
+    stream->closing = false;
+
+    return true;
+}
+
+/**
+ * Stop streaming the file, dropping the data that hasn't been written. Returns false while a write is in flight.
+ */
+static bool afatfs_streamAbort(void)
+{
+    if (afatfs.stream.sectorsInFlight > 0) {
+        return false;
+    }
+
+    afatfs.stream.file = NULL;
+
+    return true;
+}
+
+#endif
+
 /**
  * Queue an operation to add a cluster of free space to the end of the file. Must be called when the file's cursor
  * is beyond the last allocated cluster.
@@ -2120,7 +2450,7 @@ afatfsOperationStatus_e afatfs_fseek(afatfsFilePtr_t file, int32_t offset, afatf
         break;
 
         case AFATFS_SEEK_SET:
-            FALLTHROUGH;
+        break;
     }
 
     // Now we have a SEEK_SET with a positive offset. Begin by seeking to the start of the file
@@ -2688,6 +3018,12 @@ static void afatfs_createFileContinue(afatfsFile_t *file)
                     } else {
                         // Lock the freefile for our exclusive access
                         afatfs.freeFile.operation.operation = AFATFS_FILE_OPERATION_LOCKED;
+
+#ifdef AFATFS_USE_STREAM
+                        if ((file->mode & AFATFS_FILE_MODE_APPEND) != 0 && afatfs.stream.file == NULL && !afatfs_streamDisabled) {
+                            afatfs_streamBegin(file);
+                        }
+#endif
                     }
                 }
 #endif
@@ -2760,6 +3096,12 @@ bool afatfs_funlink(afatfsFilePtr_t file, afatfsCallback_t callback)
         return true;
     }
 
+#ifdef AFATFS_USE_STREAM
+    if (afatfs_fileIsStreamed(file) && !afatfs_streamAbort()) {
+        return false;
+    }
+#endif
+
     /*
      * Internally an unlink is implemented by first doing a ftruncate(), marking the directory entry as deleted,
      * then doing a fclose() operation.
@@ -2895,6 +3237,10 @@ bool afatfs_fclose(afatfsFilePtr_t file, afatfsCallback_t callback)
         return true;
     } else if (afatfs_fileIsBusy(file)) {
         return false;
+#ifdef AFATFS_USE_STREAM
+    } else if (afatfs_fileIsStreamed(file) && !afatfs_streamFinish(file)) {
+        return false;
+#endif
     } else {
         afatfs_fileUpdateFilesize(file);
 
@@ -3076,6 +3422,13 @@ uint32_t afatfs_fwrite(afatfsFilePtr_t file, const uint8_t *buffer, uint32_t len
         return 0;
     }
 
+#ifdef AFATFS_USE_STREAM
+    // Streamed files don't wait for their metadata operations
+    if (afatfs_fileIsStreamed(file)) {
+        return afatfs_streamWrite(file, buffer, len);
+    }
+#endif
+
     if (afatfs_fileIsBusy(file)) {
         // There might be a seek pending
         return 0;
@@ -3534,7 +3887,16 @@ void afatfs_poll(void)
 {
     // Only attempt to continue FS operations if the card is present & ready, otherwise we would just be wasting time
     if (sondearSD()) {
+#ifdef AFATFS_USE_STREAM
+        // The stream goes first when it is running out of ring, otherwise dirty metadata sectors go first
+        if (bytesOcupadosBufferAnillo(&afatfs.stream.ring) >= sizeof(afatfs_streamMemory) / 2) {
+            afatfs_streamContinue();
+        }
+#endif
         afatfs_flush();
+#ifdef AFATFS_USE_STREAM
+        afatfs_streamContinue();
+#endif
 
         switch (afatfs.filesystemState) {
             case AFATFS_FILESYSTEM_STATE_INITIALIZATION:
@@ -3685,11 +4047,27 @@ bool afatfs_destroy(bool dirty)
     return true;
 }
 
+#ifdef AFATFS_USE_STREAM
+/**
+ * Choose whether new contiguous append files are streamed (the default) or written through the sector cache.
+ */
+void afatfs_setStreamingEnabled(bool enabled)
+{
+    afatfs_streamDisabled = !enabled;
+}
+#endif
+
 /**
  * Get a pessimistic estimate of the amount of buffer space that we have available to write to immediately.
  */
 uint32_t afatfs_getFreeBufferSpace(void)
 {
+#ifdef AFATFS_USE_STREAM
+    if (afatfs.stream.file != NULL) {
+        return bytesLibresBufferAnillo(&afatfs.stream.ring);
+    }
+#endif
+
     uint32_t result = 0;
     for (int i = 0; i < AFATFS_NUM_CACHE_SECTORS; i++) {
         if (!afatfs.cacheDescriptor[i].locked && (afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_EMPTY || afatfs.cacheDescriptor[i].state == AFATFS_CACHE_STATE_IN_SYNC)) {
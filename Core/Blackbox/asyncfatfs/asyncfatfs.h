@@ -76,3 +76,4 @@ bool afatfs_isFull(void);
 afatfsFilesystemState_e afatfs_getFilesystemState(void);
 afatfsError_e afatfs_getLastError(void);
 bool afatfs_sectorCacheInSync(void);
+void afatfs_setStreamingEnabled(bool enabled);
@@ -26,11 +26,13 @@
 ** AREA DE INCLUDES                                                                   **
 ****************************************************************************************/
 #include <string.h>
+#include <math.h>
 
 #include "blackbox.h"
 
 #ifdef USAR_BLACKBOX
 #include "blackbox_sd.h"
+#include "codificacion_blackbox.h"
 #include "GP/gp_blackbox.h"
 #include "Drivers/tiempo.h"
 #include "Drivers/rtc.h"
@@ -40,6 +42,7 @@
 #include "Sensores/Magnetometro/magnetometro.h"
 #include "Sensores/IMU/imu.h"
 #include "Sensores/GPS/gps.h"
+#include "Motores/motor.h"
 #include "Comun/util.h"
 #include "sd.h"
 #include "asyncfatfs/asyncfatfs.h"
@@ -76,12 +79,39 @@ typedef enum {
     BLACKBOX_NUM_DRIVERS_GPS,
 } numDriversBlackbox_e;
 
+typedef enum {
+    BLACKBOX_CAMPO_ITERACION = 0,
+    BLACKBOX_CAMPO_TIEMPO,
+    BLACKBOX_CAMPO_GIRO,
+    BLACKBOX_CAMPO_ACEL,
+    BLACKBOX_CAMPO_MAG,
+    BLACKBOX_CAMPO_PRESION,
+    BLACKBOX_CAMPO_TEMPERATURA,
+    BLACKBOX_CAMPO_RADIO,
+    BLACKBOX_CAMPO_MOTOR,
+    BLACKBOX_CAMPO_SATELITES,
+    BLACKBOX_CAMPO_LATITUD,
+    BLACKBOX_CAMPO_LONGITUD,
+    BLACKBOX_CAMPO_ALTITUD_GPS,
+    BLACKBOX_CAMPO_VEL_GPS,
+    BLACKBOX_CAMPO_VEL_ANG_GPS,
+} fuenteCampoBlackbox_e;
+
 typedef struct {
     const char *nombre;
     int8_t indiceNombreCampo;
     numDriversBlackbox_e numDrivers;
+    fuenteCampoBlackbox_e fuente;
+    codificacionCampoBlackbox_e codificacion;
+    uint32_t escala;                       // Los valores en coma flotante se guardan como valor * escala
 } defCabCampoBlackbox_t;
 
+typedef struct {
+    uint8_t numCampos;
+    uint8_t codificacion[NUM_MAX_CAMPOS_BLACKBOX];
+    int32_t previos[NUM_MAX_CAMPOS_BLACKBOX];
+} estadoFrameBlackbox_t;
+
 typedef struct {
     uint32_t indiceCabecera;
     uint8_t indiceCampo;
@@ -95,6 +125,7 @@ typedef struct {
     uint16_t intervaloRapido;
     uint16_t intervaloLento;
     bool logEmpezado;
+    uint32_t contadorFrames;               // Frames rapidos desde el ultimo I
 } blackbox_t;
 
 
@@ -106,66 +137,71 @@ static datosTXblackbox_t datosTXblackbox;
 static uint32_t iteradorBlackbox;
 static int32_t iteradorRapidoBlackbox = 0;
 static int32_t iteradorLentoBlackbox = 0;
+static estadoFrameBlackbox_t frameRapidoBlackbox;
+static estadoFrameBlackbox_t frameLentoBlackbox;
+static uint8_t bufferFrameBlackbox[MAX_BYTES_FRAME_BLACKBOX];
 
 static const char cabeceraBlackbox[] =
     "C Bienvenido al grabador de datos URpilot\n"
-    "C Version Blackbox: 1\n";
+    "C Version Blackbox: 2\n";
 
 static const char* const nombresCabCampoBlackbox[] = {
     "nombre",
     "drivers",
+    "codificacion",
+    "escala",
 };
 
 static const defCabCampoBlackbox_t camposRapidosBlackbox[] = {
-    {"iteracion", -1,    BLACKBOX_1_DRIVER},
-    {"tiempo",    -1,    BLACKBOX_1_DRIVER},
+    {"iteracion", -1,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_ITERACION,    BLACKBOX_COD_VB_SIN_SIGNO, 1},
+    {"tiempo",    -1,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_TIEMPO,       BLACKBOX_COD_VB_SIN_SIGNO, 1},
 #ifdef USAR_IMU
-    {"giro",       0,    BLACKBOX_NUM_DRIVERS_IMU},
-    {"giro",       1,    BLACKBOX_NUM_DRIVERS_IMU},
-    {"giro",       2,    BLACKBOX_NUM_DRIVERS_IMU},
-    {"acel",       0,    BLACKBOX_NUM_DRIVERS_IMU},
-    {"acel",       1,    BLACKBOX_NUM_DRIVERS_IMU},
-    {"acel",       2,    BLACKBOX_NUM_DRIVERS_IMU},
+    {"giro",       0,    BLACKBOX_NUM_DRIVERS_IMU,    BLACKBOX_CAMPO_GIRO,         BLACKBOX_COD_FIJO_16,      10},
+    {"giro",       1,    BLACKBOX_NUM_DRIVERS_IMU,    BLACKBOX_CAMPO_GIRO,         BLACKBOX_COD_FIJO_16,      10},
+    {"giro",       2,    BLACKBOX_NUM_DRIVERS_IMU,    BLACKBOX_CAMPO_GIRO,         BLACKBOX_COD_FIJO_16,      10},
+    {"acel",       0,    BLACKBOX_NUM_DRIVERS_IMU,    BLACKBOX_CAMPO_ACEL,         BLACKBOX_COD_VB_CON_SIGNO, 1000},
+    {"acel",       1,    BLACKBOX_NUM_DRIVERS_IMU,    BLACKBOX_CAMPO_ACEL,         BLACKBOX_COD_VB_CON_SIGNO, 1000},
+    {"acel",       2,    BLACKBOX_NUM_DRIVERS_IMU,    BLACKBOX_CAMPO_ACEL,         BLACKBOX_COD_VB_CON_SIGNO, 1000},
 #endif
 #ifdef USAR_MAG
-    {"mag",        0,    BLACKBOX_NUM_DRIVERS_MAG},
-    {"mag",        1,    BLACKBOX_NUM_DRIVERS_MAG},
-    {"mag",        2,    BLACKBOX_NUM_DRIVERS_MAG},
+    {"mag",        0,    BLACKBOX_NUM_DRIVERS_MAG,    BLACKBOX_CAMPO_MAG,          BLACKBOX_COD_VB_CON_SIGNO, 10},
+    {"mag",        1,    BLACKBOX_NUM_DRIVERS_MAG,    BLACKBOX_CAMPO_MAG,          BLACKBOX_COD_VB_CON_SIGNO, 10},
+    {"mag",        2,    BLACKBOX_NUM_DRIVERS_MAG,    BLACKBOX_CAMPO_MAG,          BLACKBOX_COD_VB_CON_SIGNO, 10},
 #endif
 #ifdef USAR_BARO
-    {"BaroP",      -1,   BLACKBOX_NUM_DRIVERS_BARO},
-    {"BaroT",      -1,   BLACKBOX_NUM_DRIVERS_BARO},
+    {"BaroP",      -1,   BLACKBOX_NUM_DRIVERS_BARO,   BLACKBOX_CAMPO_PRESION,      BLACKBOX_COD_VB_CON_SIGNO, 100},
+    {"BaroT",      -1,   BLACKBOX_NUM_DRIVERS_BARO,   BLACKBOX_CAMPO_TEMPERATURA,  BLACKBOX_COD_VB_CON_SIGNO, 100},
 #endif
 #ifdef USAR_RADIO
-    {"radio",      0,    BLACKBOX_1_DRIVER},
-    {"radio",      1,    BLACKBOX_1_DRIVER},
-    {"radio",      2,    BLACKBOX_1_DRIVER},
-    {"radio",      3,    BLACKBOX_1_DRIVER},
-    {"radio",      4,    BLACKBOX_1_DRIVER},
-    {"radio",      5,    BLACKBOX_1_DRIVER},
-    {"radio",      6,    BLACKBOX_1_DRIVER},
-    {"radio",      7,    BLACKBOX_1_DRIVER},
+    {"radio",      0,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_RADIO,        BLACKBOX_COD_VB_CON_SIGNO, 1},
+    {"radio",      1,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_RADIO,        BLACKBOX_COD_VB_CON_SIGNO, 1},
+    {"radio",      2,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_RADIO,        BLACKBOX_COD_VB_CON_SIGNO, 1},
+    {"radio",      3,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_RADIO,        BLACKBOX_COD_VB_CON_SIGNO, 1},
+    {"radio",      4,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_RADIO,        BLACKBOX_COD_VB_CON_SIGNO, 1},
+    {"radio",      5,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_RADIO,        BLACKBOX_COD_VB_CON_SIGNO, 1},
+    {"radio",      6,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_RADIO,        BLACKBOX_COD_VB_CON_SIGNO, 1},
+    {"radio",      7,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_RADIO,        BLACKBOX_COD_VB_CON_SIGNO, 1},
 #endif
 #ifdef USAR_MOTORES
-    {"motor",      0,    BLACKBOX_1_DRIVER},
-    {"motor",      1,    BLACKBOX_1_DRIVER},
-    {"motor",      2,    BLACKBOX_1_DRIVER},
-    {"motor",      3,    BLACKBOX_1_DRIVER},
-    {"motor",      4,    BLACKBOX_1_DRIVER},
-    {"motor",      5,    BLACKBOX_1_DRIVER},
-    {"motor",      6,    BLACKBOX_1_DRIVER},
-    {"motor",      7,    BLACKBOX_1_DRIVER},
+    {"motor",      0,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_MOTOR,        BLACKBOX_COD_VB_CON_SIGNO, 1000},
+    {"motor",      1,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_MOTOR,        BLACKBOX_COD_VB_CON_SIGNO, 1000},
+    {"motor",      2,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_MOTOR,        BLACKBOX_COD_VB_CON_SIGNO, 1000},
+    {"motor",      3,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_MOTOR,        BLACKBOX_COD_VB_CON_SIGNO, 1000},
+    {"motor",      4,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_MOTOR,        BLACKBOX_COD_VB_CON_SIGNO, 1000},
+    {"motor",      5,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_MOTOR,        BLACKBOX_COD_VB_CON_SIGNO, 1000},
+    {"motor",      6,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_MOTOR,        BLACKBOX_COD_VB_CON_SIGNO, 1000},
+    {"motor",      7,    BLACKBOX_1_DRIVER,           BLACKBOX_CAMPO_MOTOR,        BLACKBOX_COD_VB_CON_SIGNO, 1000},
 #endif
 };
 
 static const defCabCampoBlackbox_t camposLentosBlackbox[] = {
 #ifdef USAR_GPS
-    {"satelites", -1,    BLACKBOX_NUM_DRIVERS_GPS},
-    {"latitud",   -1,    BLACKBOX_NUM_DRIVERS_GPS},
-    {"longitud",  -1,    BLACKBOX_NUM_DRIVERS_GPS},
-    {"altGPS",    -1,    BLACKBOX_NUM_DRIVERS_GPS},
-    {"velGPS",    -1,    BLACKBOX_NUM_DRIVERS_GPS},
-    {"velAngGPS", -1,    BLACKBOX_NUM_DRIVERS_GPS},
+    {"satelites", -1,    BLACKBOX_NUM_DRIVERS_GPS,    BLACKBOX_CAMPO_SATELITES,    BLACKBOX_COD_VB_SIN_SIGNO, 1},
+    {"latitud",   -1,    BLACKBOX_NUM_DRIVERS_GPS,    BLACKBOX_CAMPO_LATITUD,      BLACKBOX_COD_VB_CON_SIGNO, 10000000},
+    {"longitud",  -1,    BLACKBOX_NUM_DRIVERS_GPS,    BLACKBOX_CAMPO_LONGITUD,     BLACKBOX_COD_VB_CON_SIGNO, 10000000},
+    {"altGPS",    -1,    BLACKBOX_NUM_DRIVERS_GPS,    BLACKBOX_CAMPO_ALTITUD_GPS,  BLACKBOX_COD_VB_CON_SIGNO, 100},
+    {"velGPS",    -1,    BLACKBOX_NUM_DRIVERS_GPS,    BLACKBOX_CAMPO_VEL_GPS,      BLACKBOX_COD_VB_CON_SIGNO, 100},
+    {"velAngGPS", -1,    BLACKBOX_NUM_DRIVERS_GPS,    BLACKBOX_CAMPO_VEL_ANG_GPS,  BLACKBOX_COD_VB_CON_SIGNO, 100},
 #endif
 };
 
@@ -177,10 +213,14 @@ void ajustarEstadoBlackbox(estadoBlackbox_e estado);
 void resetearIteradoresBlackbox(void);
 void lanzarBlackbox(void);
 void actualizarIteradoresBlackbox(void);
-bool enviarDefCampoBlackbox(char identificador, const void *defCampo, const void *segundaDefcampo, uint8_t numCampos, const uint8_t *numDrivers, const uint8_t *segundoNumDrivers);
+bool enviarDefCampoBlackbox(char identificador, const defCabCampoBlackbox_t *defCampo, uint8_t numCampos);
 bool escribirInfoSistemaBlackbox(void);
 char *obtenerFechaHoraBlackbox(char *buf);
 uint8_t numDriversBlackbox(numDriversBlackbox_e numDrivers);
+void prepararFrameBlackbox(estadoFrameBlackbox_t *frame, const defCabCampoBlackbox_t *defCampo, uint8_t numCampos);
+uint8_t capturarFrameBlackbox(int32_t *valores, const defCabCampoBlackbox_t *defCampo, uint8_t numCampos, uint32_t tiempoActual);
+int32_t valorCampoBlackbox(const defCabCampoBlackbox_t *def, uint8_t driver, uint32_t tiempoActual);
+bool escribirFrameBlackbox(char marcador, estadoFrameBlackbox_t *frame, const int32_t *valores, bool completo);
 void iterarLogBlackbox(uint32_t tiempoActual);
 bool necesarioEscribirLogRapidoBlackbox(void);
 bool necesarioEscribirLogLentoBlackbox(void);
@@ -316,6 +356,7 @@ void ajustarEstadoBlackbox(estadoBlackbox_e estado)
 
         case BLACKBOX_ESTADO_CORRIENDO:
         	iteradorLentoBlackbox = blackbox.intervaloLento; // Fuerza el iterador lento para escribirlo la primera vez
+        	blackbox.contadorFrames = 0;                      // Tras arrancar o reanudar el primer frame es completo
             break;
 
         case BLACKBOX_ESTADO_APAGANDO:
@@ -332,14 +373,13 @@ void ajustarEstadoBlackbox(estadoBlackbox_e estado)
 
 /***************************************************************************************
 **  Nombre:         void actualizarBlackbox(uint32_t tiempoActual)
-**  Descripcion:    Actualiza la blackbox
+**  Descripcion:    Actualiza la blackbox. Es el productor: mientras se registra solo
+**                  codifica frames en la cola, sin esperar a la SD
 **  Parametros:     Tiempo actual en us
 **  Retorno:        Ninguno
 ****************************************************************************************/
 void actualizarBlackbox(uint32_t tiempoActual)
 {
-	afatfs_poll();
-
     switch (blackbox.estado) {
         case BLACKBOX_ESTADO_PARADO:
             if (blackbox.arrancar) {
@@ -371,17 +411,14 @@ void actualizarBlackbox(uint32_t tiempoActual)
         case BLACKBOX_ESTADO_ENVIAR_CABECERA_CAMPO:
         	calcularBytesLibresCabBlackbox();
 
-            if (!enviarDefCampoBlackbox('R', camposRapidosBlackbox, camposRapidosBlackbox + 1, LONG_ARRAY(camposRapidosBlackbox),
-                &camposRapidosBlackbox[0].numDrivers, &camposRapidosBlackbox[1].numDrivers)) {
+            if (!enviarDefCampoBlackbox('R', camposRapidosBlackbox, LONG_ARRAY(camposRapidosBlackbox)))
             	ajustarEstadoBlackbox(BLACKBOX_ESTADO_ENVIAR_CABECERA_LENTA);
-            }
             break;
 
         case BLACKBOX_ESTADO_ENVIAR_CABECERA_LENTA:
         	calcularBytesLibresCabBlackbox();
 
-            if (!enviarDefCampoBlackbox('L', camposLentosBlackbox, camposLentosBlackbox + 1, LONG_ARRAY(camposLentosBlackbox),
-                &camposLentosBlackbox[0].numDrivers, &camposLentosBlackbox[1].numDrivers))
+            if (!enviarDefCampoBlackbox('L', camposLentosBlackbox, LONG_ARRAY(camposLentosBlackbox)))
             	ajustarEstadoBlackbox(BLACKBOX_ESTADO_ENVIAR_INFO_SISTEMA);
             break;
 
@@ -428,6 +465,11 @@ void actualizarBlackbox(uint32_t tiempoActual)
             break;
 
         case BLACKBOX_ESTADO_APAGANDO:
+            // La cola la vacia vaciarBlackbox. Un log sin empezar o lo que no se haya volcado al
+            // agotar el tiempo se pierde
+            if (!blackbox.logEmpezado || millis() > datosTXblackbox.tiempoInicio + TIMEOUT_APAGAR_MS_BLACKBOX)
+                solicitarDescarteBlackbox();
+
             if (finalizarLogBlackbox(blackbox.logEmpezado) && (millis() > datosTXblackbox.tiempoInicio + TIMEOUT_APAGAR_MS_BLACKBOX || forzarFlushBlackbox()))
             	ajustarEstadoBlackbox(BLACKBOX_ESTADO_PARADO);
             break;
@@ -441,6 +483,23 @@ void actualizarBlackbox(uint32_t tiempoActual)
 }
 
 
+/***************************************************************************************
+**  Nombre:         void vaciarBlackbox(uint32_t tiempoActual)
+**  Descripcion:    Vuelca la cola de la blackbox al fichero y avanza asyncfatfs. Es el
+**                  consumidor de la cola y debe ir en una tarea de menos prioridad que
+**                  actualizarBlackbox
+**  Parametros:     Tiempo actual en us
+**  Retorno:        Ninguno
+****************************************************************************************/
+void vaciarBlackbox(uint32_t tiempoActual)
+{
+    UNUSED(tiempoActual);
+
+    volcarColaBlackbox();
+    afatfs_poll();
+}
+
+
 /***************************************************************************************
 **  Nombre:         void lanzarBlackbox(void)
 **  Descripcion:    Lanza el proceso de la blackbox
@@ -455,6 +514,8 @@ void lanzarBlackbox(void)
     }
 
     resetearIteradoresBlackbox();
+    prepararFrameBlackbox(&frameRapidoBlackbox, camposRapidosBlackbox, LONG_ARRAY(camposRapidosBlackbox));
+    prepararFrameBlackbox(&frameLentoBlackbox, camposLentosBlackbox, LONG_ARRAY(camposLentosBlackbox));
     ajustarEstadoBlackbox(BLACKBOX_ESTADO_PREPARAR_FICHERO_LOG);
 }
 
@@ -474,25 +535,20 @@ void actualizarIteradoresBlackbox(void)
 
 
 /***************************************************************************************
-**  Nombre:         bool enviarDefCampoBlackbox(char identificador, const void *defCampo, const void *segundaDefcampo, uint8_t numCampos, const uint8_t *numDrivers, const uint8_t *segundoNumDrivers)
-**  Descripcion:    Envia la definicion del campo de este estilo: C campo R nombre: a,b,c // C campo R drivers: 2,3,1
-**  Parametros:     Letra identificador, definicion de campo, segunda definicion de campo, numero de campos, numero de drivers, segundo numero de drivers
+**  Nombre:         bool enviarDefCampoBlackbox(char identificador, const defCabCampoBlackbox_t *defCampo, uint8_t numCampos)
+**  Descripcion:    Envia la definicion del campo de este estilo: C Campo R nombre: a,b,c // C Campo R drivers: 2,3,1
+**  Parametros:     Letra identificador, definicion de los campos, numero de campos
 **  Retorno:        True si todavia queda una cabecera por transmitir
 ****************************************************************************************/
-bool enviarDefCampoBlackbox(char identificador, const void *defCampo, const void *segundaDefcampo, uint8_t numCampos, const uint8_t *numDrivers, const uint8_t *segundoNumDrivers)
+bool enviarDefCampoBlackbox(char identificador, const defCabCampoBlackbox_t *defCampo, uint8_t numCampos)
 {
-    char stringEscritura[20];
-    const defCabCampoBlackbox_t *def;
     static bool necesitaComa = false;
     uint8_t numCabeceras = LONG_ARRAY(nombresCabCampoBlackbox);
-    size_t pasoDefCampo = (char*) segundaDefcampo - (char*) defCampo;
-    size_t pasoNumDrivers = (char*) numDrivers - (char*) segundoNumDrivers;
-    uint8_t drivers;
 
     // Troceamos la cabecera para no exceder el ratio de transmision. Por eso es necesario llamar la funcion varias veces
 
     // En la primera llamada se escribe el nombre y la coma
-    if (datosTXblackbox.indiceCampo == -1) {
+    if (datosTXblackbox.indiceCampo == (uint8_t)-1) {
         if (datosTXblackbox.indiceCabecera >= numCabeceras)
             return false;
 
@@ -501,16 +557,15 @@ bool enviarDefCampoBlackbox(char identificador, const void *defCampo, const void
         if (!comprobarEspacioBlackbox(charsParaEscribir))
             return true;   // Se intentara otra vez
 
-        bytesLibresCabBlackbox = printfBlackbox("C Campo %c %s:", identificador, nombresCabCampoBlackbox[datosTXblackbox.indiceCabecera]);
-        bytesLibresCabBlackbox -= escribirStringBlackbox(stringEscritura);
+        bytesLibresCabBlackbox -= printfBlackbox("C Campo %c %s:", identificador, nombresCabCampoBlackbox[datosTXblackbox.indiceCabecera]);
 
         datosTXblackbox.indiceCampo++;
         necesitaComa = false;
     }
 
     for (; datosTXblackbox.indiceCampo < numCampos; datosTXblackbox.indiceCampo++) {
-        def = (const defCabCampoBlackbox_t*) ((const char*)defCampo + pasoDefCampo * datosTXblackbox.indiceCampo);
-        drivers = numDriversBlackbox(numDrivers[pasoNumDrivers * datosTXblackbox.indiceCampo]);
+        const defCabCampoBlackbox_t *def = &defCampo[datosTXblackbox.indiceCampo];
+        uint8_t drivers = numDriversBlackbox(def->numDrivers);
 
         if (drivers != 0) {
             int32_t bytesParaEscribir = 1; // Para la coma
@@ -519,7 +574,7 @@ bool enviarDefCampoBlackbox(char identificador, const void *defCampo, const void
             if (datosTXblackbox.indiceCabecera == 0)
                 bytesParaEscribir += strlen(def->nombre) + strlen("[]") + 2;
             else
-                bytesParaEscribir += 2;   // Las otras cabeceras son enteros de como maximo 2 digitos
+                bytesParaEscribir += 10;  // Las otras cabeceras son enteros de 32 bits
 
             if (!comprobarEspacioBlackbox(bytesParaEscribir))
                 return true;
@@ -531,15 +586,27 @@ bool enviarDefCampoBlackbox(char identificador, const void *defCampo, const void
             else
                 necesitaComa = true;
 
-            if (datosTXblackbox.indiceCabecera == 0) {
-            	escribirStringBlackbox(def->nombre);
+            switch (datosTXblackbox.indiceCabecera) {
+                case 0:
+                    escribirStringBlackbox(def->nombre);
+
+                    // Comprobamos si se necesita pintar el indice entre corchetes
+                    if (def->indiceNombreCampo != -1)
+                        printfBlackbox("[%d]", def->indiceNombreCampo);
+                    break;
+
+                case 1:
+                    printfBlackbox("%d", drivers);
+                    break;
+
+                case 2:
+                    printfBlackbox("%d", def->codificacion);
+                    break;
 
-                // Comprobamos si se necesita pintar el indice entre corchetes
-                if (def->indiceNombreCampo != -1)
-                	printfBlackbox("[%d]", def->indiceNombreCampo);
+                default:
+                    printfBlackbox("%lu", (unsigned long)def->escala);
+                    break;
             }
-            else
-            	printfBlackbox("%d", drivers);
         }
     }
 
@@ -651,32 +718,37 @@ void escribirLogEventoBlackbox(logEvento_e evento, logEventoDatos_u *datos)
     if (!(blackbox.estado == BLACKBOX_ESTADO_CORRIENDO || blackbox.estado == BLACKBOX_ESTADO_PAUSADO))
         return;
 
-    escribirBlackbox('E');
-    escribirBlackbox(evento);
+    uint16_t n = 0;
+
+    bufferFrameBlackbox[n++] = MARCADOR_EVENTO_BLACKBOX;
+    bufferFrameBlackbox[n++] = evento;
 
     switch (evento) {
         case BLACKBOX_LOG_EVENTO_DESARMAR:
-        	printfBlackbox("%f", datos->eventoDesarmar.razon);
+            n += escribirVarintBlackbox(&bufferFrameBlackbox[n], datos->eventoDesarmar.razon);
             break;
 
         case BLACKBOX_LOG_EVENTO_MODO:
-        	printfBlackbox("%f", datos->eventoModo.flags);
-        	printfBlackbox("%f", datos->eventoModo.ultimosFlags);
+            n += escribirVarintBlackbox(&bufferFrameBlackbox[n], datos->eventoModo.flags);
+            n += escribirVarintBlackbox(&bufferFrameBlackbox[n], datos->eventoModo.ultimosFlags);
             break;
 
         case BLACKBOX_LOG_EVENTO_LOG_REANUDAR:
-        	printfBlackbox("%f", datos->eventoReanudarLog.logIteracion);
-        	printfBlackbox("%f", datos->eventoReanudarLog.horaActual);
+            n += escribirVarintBlackbox(&bufferFrameBlackbox[n], datos->eventoReanudarLog.logIteracion);
+            n += escribirVarintBlackbox(&bufferFrameBlackbox[n], datos->eventoReanudarLog.horaActual);
             break;
 
         case BLACKBOX_LOG_EVENTO_LOG_FIN:
-        	escribirStringBlackbox("Fin del log");
-        	escribirBlackbox(0);
+            // El texto va en el mismo frame para que el evento entre o se descarte entero
+            memcpy(&bufferFrameBlackbox[n], "Fin del log", sizeof("Fin del log"));
+            n += sizeof("Fin del log");
             break;
 
         default:
             break;
     }
+
+    escribirBufferBlackbox(bufferFrameBlackbox, n);
 }
 
 
@@ -732,54 +804,23 @@ bool necesarioEscribirLogLentoBlackbox(void)
 
 /***************************************************************************************
 **  Nombre:         void escribirLogRapidoBlackbox(uint32_t tiempoActual)
-**  Descripcion:    Escribe los datos del log rapido
+**  Descripcion:    Escribe los datos del log rapido. Cada INTERVALO_FRAME_I_BLACKBOX frames
+**                  se escribe uno completo y el resto son deltas
 **  Parametros:     Tiempo actual
 **  Retorno:        Ninguno
 ****************************************************************************************/
 void escribirLogRapidoBlackbox(uint32_t tiempoActual)
 {
-	escribirBlackbox('R');
+    int32_t valores[NUM_MAX_CAMPOS_BLACKBOX];
+    const bool completo = (blackbox.contadorFrames % INTERVALO_FRAME_I_BLACKBOX) == 0;
 
-	printfBlackbox("%f", iteradorBlackbox);
-	printfBlackbox("%f", tiempoActual);
+    capturarFrameBlackbox(valores, camposRapidosBlackbox, LONG_ARRAY(camposRapidosBlackbox), tiempoActual);
 
-#ifdef USAR_IMU
-	uint8_t numIMUs = numIMUsConectadas();
-    for (uint8_t i = 0; i < numIMUs; i++) {
-    	float gIMU[3];
-    	giroNumIMU(i, gIMU);
-        for (uint8_t j = 0; j < 3; j++)
-        	printfBlackbox("%.2f", gIMU[i]);
-    }
-
-    for (uint8_t i = 0; i < numIMUs; i++) {
-        float aIMU[3];
-        acelNumIMU(i, aIMU);
-        for (uint8_t j = 0; j < 3; j++)
-        	printfBlackbox("%.2f", aIMU[i]);
-    }
-#endif
-
-#ifdef USAR_MAG
-    uint8_t numMags = numMagsConectados();
-    for (uint8_t i = 0; i < numMags; i++) {
-        float cMag[3];
-        campoNumMag(i, cMag);
-        for (uint8_t j = 0; j < 3; j++)
-        	printfBlackbox("%.2f", cMag[j]);
-    }
-#endif
-#ifdef USAR_BARO
-    uint8_t numBaros = numBarosConectados();
-    for (uint8_t i = 0; i < numBaros; i++) {
-    	printfBlackbox("%.2f", presionNumBaro(i));
-    	printfBlackbox("%.2f", temperaturaNumBaro(i));
-    }
-#endif
-#ifdef USAR_RADIO
-    for (uint8_t i = 0; i < 8; i++)
-    	printfBlackbox("%f", canalRadio(i));
-#endif
+    // Los P que siguen a un frame descartado no se podrian decodificar: el siguiente es un I
+    if (escribirFrameBlackbox(completo ? MARCADOR_FRAME_I_BLACKBOX : MARCADOR_FRAME_P_BLACKBOX, &frameRapidoBlackbox, valores, completo))
+        blackbox.contadorFrames++;
+    else
+        blackbox.contadorFrames = 0;
 
     blackbox.logEmpezado = true;
 }
@@ -793,37 +834,177 @@ void escribirLogRapidoBlackbox(uint32_t tiempoActual)
 ****************************************************************************************/
 void escribirLogLentoBlackbox(void)
 {
-	escribirBlackbox('L');
+    int32_t valores[NUM_MAX_CAMPOS_BLACKBOX];
 
-#ifdef USAR_GPS
-	uint8_t numGPS = numGPSconectados();
-    for (uint8_t i = 0; i < numGPS; i++)
-    	printfBlackbox("%f", satelitesNumGPS(i));
+    capturarFrameBlackbox(valores, camposLentosBlackbox, LONG_ARRAY(camposLentosBlackbox), 0);
+    escribirFrameBlackbox(MARCADOR_FRAME_LENTO_BLACKBOX, &frameLentoBlackbox, valores, true);
+
+    blackbox.logEmpezado = true;
+}
 
-    localizacion_t loc;
-    for (uint8_t i = 0; i < numGPS; i++) {
-    	localizacionNumGPS(i, &loc);
-    	printfBlackbox("%f", loc.latitud);
-    }
 
-    for (uint8_t i = 0; i < numGPS; i++) {
-    	localizacionNumGPS(i, &loc);
-    	printfBlackbox("%f", loc.longitud);
+/***************************************************************************************
+**  Nombre:         void prepararFrameBlackbox(estadoFrameBlackbox_t *frame, const defCabCampoBlackbox_t *defCampo,
+**                                             uint8_t numCampos)
+**  Descripcion:    Expande la definicion de los campos con el numero de drivers conectados
+**                  en el mismo orden que la cabecera
+**  Parametros:     Frame a preparar, definicion de los campos, numero de campos
+**  Retorno:        Ninguno
+****************************************************************************************/
+void prepararFrameBlackbox(estadoFrameBlackbox_t *frame, const defCabCampoBlackbox_t *defCampo, uint8_t numCampos)
+{
+    frame->numCampos = 0;
+
+    for (uint8_t i = 0; i < numCampos; i++) {
+        const uint8_t drivers = numDriversBlackbox(defCampo[i].numDrivers);
+
+        for (uint8_t j = 0; j < drivers && frame->numCampos < NUM_MAX_CAMPOS_BLACKBOX; j++)
+            frame->codificacion[frame->numCampos++] = defCampo[i].codificacion;
     }
 
-    for (uint8_t i = 0; i < numGPS; i++) {
-    	localizacionNumGPS(i, &loc);
-    	printfBlackbox("%f", loc.altitud);
+    memset(frame->previos, 0, sizeof(frame->previos));
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t capturarFrameBlackbox(int32_t *valores, const defCabCampoBlackbox_t *defCampo,
+**                                                uint8_t numCampos, uint32_t tiempoActual)
+**  Descripcion:    Lee los valores de los campos en el orden de la cabecera: cada campo
+**                  seguido de sus drivers
+**  Parametros:     Valores leidos, definicion de los campos, numero de campos, tiempo actual
+**  Retorno:        Numero de valores
+****************************************************************************************/
+uint8_t capturarFrameBlackbox(int32_t *valores, const defCabCampoBlackbox_t *defCampo, uint8_t numCampos, uint32_t tiempoActual)
+{
+    uint8_t n = 0;
+
+    for (uint8_t i = 0; i < numCampos; i++) {
+        const uint8_t drivers = numDriversBlackbox(defCampo[i].numDrivers);
+
+        for (uint8_t j = 0; j < drivers && n < NUM_MAX_CAMPOS_BLACKBOX; j++)
+            valores[n++] = valorCampoBlackbox(&defCampo[i], j, tiempoActual);
     }
 
-    for (uint8_t i = 0; i < numGPS; i++)
-    	printfBlackbox("%.2f", vel2dNumGPS(i));
+    return n;
+}
 
-    for (uint8_t i = 0; i < numGPS; i++)
-    	printfBlackbox("%.2f", velAngularNumGPS(i));
+
+/***************************************************************************************
+**  Nombre:         int32_t valorCampoBlackbox(const defCabCampoBlackbox_t *def, uint8_t driver, uint32_t tiempoActual)
+**  Descripcion:    Obtiene el valor entero de un campo. Las magnitudes en coma flotante se
+**                  multiplican por la escala del campo
+**  Parametros:     Definicion del campo, driver, tiempo actual
+**  Retorno:        Valor del campo
+****************************************************************************************/
+int32_t valorCampoBlackbox(const defCabCampoBlackbox_t *def, uint8_t driver, uint32_t tiempoActual)
+{
+    float valor;
+#if defined(USAR_IMU) || defined(USAR_MAG)
+    float v[3];
+#endif
+#ifdef USAR_GPS
+    localizacion_t loc;
 #endif
 
-    blackbox.logEmpezado = true;
+    switch (def->fuente) {
+        case BLACKBOX_CAMPO_ITERACION:
+            return (int32_t)iteradorBlackbox;
+
+        case BLACKBOX_CAMPO_TIEMPO:
+            return (int32_t)tiempoActual;
+
+#ifdef USAR_IMU
+        case BLACKBOX_CAMPO_GIRO:
+            giroNumIMU(driver, v);
+            valor = v[def->indiceNombreCampo];
+            break;
+
+        case BLACKBOX_CAMPO_ACEL:
+            acelNumIMU(driver, v);
+            valor = v[def->indiceNombreCampo];
+            break;
+#endif
+
+#ifdef USAR_MAG
+        case BLACKBOX_CAMPO_MAG:
+            campoNumMag(driver, v);
+            valor = v[def->indiceNombreCampo];
+            break;
+#endif
+
+#ifdef USAR_BARO
+        case BLACKBOX_CAMPO_PRESION:
+            valor = presionNumBaro(driver);
+            break;
+
+        case BLACKBOX_CAMPO_TEMPERATURA:
+            valor = temperaturaNumBaro(driver);
+            break;
+#endif
+
+#ifdef USAR_RADIO
+        case BLACKBOX_CAMPO_RADIO:
+            return canalRadio(def->indiceNombreCampo);
+#endif
+
+#ifdef USAR_MOTORES
+        case BLACKBOX_CAMPO_MOTOR:
+            valor = valorMotor(def->indiceNombreCampo);
+            break;
+#endif
+
+#ifdef USAR_GPS
+        case BLACKBOX_CAMPO_SATELITES:
+            return satelitesNumGPS(driver);
+
+        case BLACKBOX_CAMPO_LATITUD:
+            localizacionNumGPS(driver, &loc);
+            return loc.latitud;
+
+        case BLACKBOX_CAMPO_LONGITUD:
+            localizacionNumGPS(driver, &loc);
+            return loc.longitud;
+
+        case BLACKBOX_CAMPO_ALTITUD_GPS:
+            localizacionNumGPS(driver, &loc);
+            return loc.altitud;
+
+        case BLACKBOX_CAMPO_VEL_GPS:
+            valor = vel2dNumGPS(driver);
+            break;
+
+        case BLACKBOX_CAMPO_VEL_ANG_GPS:
+            valor = velAngularNumGPS(driver);
+            break;
+#endif
+
+        default:
+            return 0;
+    }
+
+    return (int32_t)lrintf(valor * def->escala);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool escribirFrameBlackbox(char marcador, estadoFrameBlackbox_t *frame, const int32_t *valores,
+**                                             bool completo)
+**  Descripcion:    Codifica un frame directamente en la cola y lo publica de una vez
+**  Parametros:     Marcador del frame, estado del frame, valores, frame completo o delta
+**  Retorno:        True si el frame ha entrado en la cola
+****************************************************************************************/
+bool escribirFrameBlackbox(char marcador, estadoFrameBlackbox_t *frame, const int32_t *valores, bool completo)
+{
+    uint8_t *destino = reservarFrameBlackbox(MAX_BYTES_FRAME_BLACKBOX);
+
+    if (destino == NULL)
+        return false;
+
+    destino[0] = marcador;
+    const uint16_t longitud = codificarFrameBlackbox(&destino[1], frame->codificacion, frame->previos, valores,
+                                                     frame->numCampos, completo);
+
+    return publicarFrameBlackbox(longitud + 1);
 }
 
 #endif
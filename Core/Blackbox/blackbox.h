@@ -83,6 +83,7 @@ void finalizarBlackbox(void);
 void arrancarBlackbox(void);
 void pausarBlackbox(void);
 void actualizarBlackbox(uint32_t tiempoActual);
+void vaciarBlackbox(uint32_t tiempoActual);
 void escribirLogEventoBlackbox(logEvento_e evento, logEventoDatos_u *datos);
 
 #endif // __BLACKBOX_H
@@ -34,6 +34,7 @@
 
 #ifdef USAR_BLACKBOX
 #include "sd.h"
+#include "codificacion_blackbox.h"
 #include "asyncfatfs/asyncfatfs.h"
 #include "Comun/matematicas.h"
 
@@ -74,6 +75,11 @@ typedef struct {
 static blackboxSD_t blackboxSD;
 int32_t bytesLibresCabBlackbox;
 
+static colaBlackbox_t colaBlackbox;
+static uint8_t bufferColaBlackbox[TAM_COLA_BLACKBOX];
+static uint8_t frameTemporalBlackbox[MAX_BYTES_FRAME_BLACKBOX];
+static volatile bool descarteSolicitadoBlackbox;    // El productor pide tirar la cola al cerrar
+
 
 /***************************************************************************************
 ** AREA DE PROTOTIPOS DE FUNCION                                                      **
@@ -81,6 +87,7 @@ int32_t bytesLibresCabBlackbox;
 void directorioLogCreadoBlackbox(afatfsFilePtr_t directorio);
 void ficheroLogCreadoBlackbox(afatfsFilePtr_t fichero);
 void crearFicheroLogBlackbox(void);
+void descartarPendientesBlackbox(void);
 
 
 /***************************************************************************************
@@ -98,7 +105,10 @@ bool abrirBlackbox(void)
     if (afatfs_getFilesystemState() == AFATFS_FILESYSTEM_STATE_FATAL || afatfs_getFilesystemState() == AFATFS_FILESYSTEM_STATE_UNKNOWN || afatfs_isFull())
         return false;
 
-    return true;
+    // Cada log empieza con la cola vacia y los contadores a cero
+    descarteSolicitadoBlackbox = false;
+    return iniciarColaBlackbox(&colaBlackbox, bufferColaBlackbox, sizeof(bufferColaBlackbox), frameTemporalBlackbox,
+                               sizeof(frameTemporalBlackbox));
 }
 
 
@@ -171,17 +181,36 @@ bool iniciarLogBlackbox(void)
 }
 
 
+/***************************************************************************************
+**  Nombre:         void solicitarDescarteBlackbox(void)
+**  Descripcion:    Pide a la tarea de vaciado que tire lo que queda en la cola en vez de
+**                  volcarlo. Lo llama el productor al cerrar un log sin empezar o al agotar
+**                  el tiempo de cierre
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void solicitarDescarteBlackbox(void)
+{
+    descarteSolicitadoBlackbox = true;
+}
+
+
 /***************************************************************************************
 **  Nombre:         bool finalizarLogBlackbox(bool logEmpezado)
-**  Descripcion:    Finaliza el log en la blackbox
+**  Descripcion:    Finaliza el log en la blackbox. No toca la cola: espera a que la tarea
+**                  de vaciado la vuelque o la tire
 **  Parametros:     Log empezado
 **  Retorno:        True si OK
 ****************************************************************************************/
 bool finalizarLogBlackbox(bool logEmpezado)
 {
+    if (bytesPendientesColaBlackbox(&colaBlackbox) > 0)
+        return false;
+
     if ((logEmpezado && afatfs_fclose(blackboxSD.ficheroLog, NULL)) || (!logEmpezado && afatfs_funlink(blackboxSD.ficheroLog, NULL))) {
         blackboxSD.ficheroLog = NULL;
         blackboxSD.estado = BLACKBOX_SD_LISTO_PARA_CREAR_LOG;
+        descarteSolicitadoBlackbox = false;
         return true;
     }
 
@@ -191,13 +220,26 @@ bool finalizarLogBlackbox(bool logEmpezado)
 
 /***************************************************************************************
 **  Nombre:         void escribirBlackbox(uint8_t valor)
-**  Descripcion:    Escribe un dato en la blackbox
+**  Descripcion:    Escribe un byte suelto de la cabecera en la cola de la blackbox
 **  Parametros:     Dato a escribir
 **  Retorno:        Ninguno
 ****************************************************************************************/
 void escribirBlackbox(uint8_t valor)
 {
-    afatfs_fputc(blackboxSD.ficheroLog, valor);
+    escribirBytesColaBlackbox(&colaBlackbox, &valor, 1);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void escribirBufferBlackbox(const uint8_t *buffer, uint32_t longitud)
+**  Descripcion:    Escribe un frame ya formado en la cola de la blackbox. Si no cabe
+**                  entero se descarta
+**  Parametros:     Datos a escribir, longitud
+**  Retorno:        Ninguno
+****************************************************************************************/
+void escribirBufferBlackbox(const uint8_t *buffer, uint32_t longitud)
+{
+    escribirColaBlackbox(&colaBlackbox, buffer, longitud);
 }
 
 
@@ -212,12 +254,96 @@ uint32_t escribirStringBlackbox(const char *s)
     uint32_t longitud;
 
     longitud = strlen(s);
-    afatfs_fwrite(blackboxSD.ficheroLog, (const uint8_t*) s, longitud);
+    escribirBytesColaBlackbox(&colaBlackbox, (const uint8_t*) s, longitud);
 
     return longitud;
 }
 
 
+/***************************************************************************************
+**  Nombre:         uint8_t *reservarFrameBlackbox(uint32_t longitudMax)
+**  Descripcion:    Reserva en la cola el sitio donde codificar un frame
+**  Parametros:     Longitud maxima del frame
+**  Retorno:        Destino del frame o NULL
+****************************************************************************************/
+CODIGO_RAPIDO uint8_t *reservarFrameBlackbox(uint32_t longitudMax)
+{
+    return reservarColaBlackbox(&colaBlackbox, longitudMax);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool publicarFrameBlackbox(uint32_t longitud)
+**  Descripcion:    Publica el frame reservado para que se vuelque a la SD
+**  Parametros:     Longitud real del frame
+**  Retorno:        True si cabe. Si no, se descarta entero
+****************************************************************************************/
+CODIGO_RAPIDO bool publicarFrameBlackbox(uint32_t longitud)
+{
+    return publicarColaBlackbox(&colaBlackbox, longitud);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void volcarColaBlackbox(void)
+**  Descripcion:    Pasa al fichero lo que quepa de la cola o la tira si el productor lo
+**                  ha pedido al cerrar. Es el consumidor de la cola: solo se llama desde
+**                  la tarea de vaciado
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void volcarColaBlackbox(void)
+{
+    const uint8_t *bloque;
+    uint32_t longitud;
+
+    if (descarteSolicitadoBlackbox) {
+        descartarPendientesBlackbox();
+        return;
+    }
+
+    if (blackboxSD.ficheroLog == NULL)
+        return;
+
+    // Como mucho dos tramos por la vuelta del anillo. Se para cuando asyncfatfs se llena
+    while ((longitud = bloqueColaBlackbox(&colaBlackbox, &bloque)) > 0) {
+        const uint32_t escritos = afatfs_fwrite(blackboxSD.ficheroLog, bloque, longitud);
+
+        consumirColaBlackbox(&colaBlackbox, escritos);
+        if (escritos < longitud)
+            break;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void descartarPendientesBlackbox(void)
+**  Descripcion:    Tira lo que queda en la cola y lo cuenta como descartado. Solo desde el
+**                  consumidor y con el productor cerrando el log, que ya no escribe
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void descartarPendientesBlackbox(void)
+{
+    const uint32_t pendientes = bytesPendientesColaBlackbox(&colaBlackbox);
+
+    colaBlackbox.bytesDescartados += pendientes;
+    consumirColaBlackbox(&colaBlackbox, pendientes);
+}
+
+
+/***************************************************************************************
+**  Nombre:         const colaBlackbox_t *colaLogBlackbox(void)
+**  Descripcion:    Devuelve la cola para leer los descartes y el maximo ocupado
+**  Parametros:     Ninguno
+**  Retorno:        Cola del log
+****************************************************************************************/
+const colaBlackbox_t *colaLogBlackbox(void)
+{
+    return &colaBlackbox;
+}
+
+
 /***************************************************************************************
 **  Nombre:         void printfBlackbox(const char *fmt, ...)
 **  Descripcion:    Escribe un string con datos variables en la blackbox
@@ -231,7 +357,7 @@ uint32_t printfBlackbox(const char *fmt, ...)
 
     va_start(va, fmt);
 
-    sprintf(stringEscritura, fmt, va);
+    vsnprintf(stringEscritura, sizeof(stringEscritura), fmt, va);
     uint32_t bytesEscritos = escribirStringBlackbox(stringEscritura);
 
     va_end(va);
@@ -249,6 +375,7 @@ uint32_t printfBlackbox(const char *fmt, ...)
 void escribirLineaCabeceraBlackbox(const char *nombre, const char *fmt, ...)
 {
     va_list va;
+    char stringEscritura[64];
 
     escribirBlackbox('C');
     escribirBlackbox(' ');
@@ -257,7 +384,8 @@ void escribirLineaCabeceraBlackbox(const char *nombre, const char *fmt, ...)
 
     va_start(va, fmt);
 
-    uint32_t bytesEscritos = printfBlackbox(fmt, va);
+    vsnprintf(stringEscritura, sizeof(stringEscritura), fmt, va);
+    uint32_t bytesEscritos = escribirStringBlackbox(stringEscritura);
 
     va_end(va);
 
@@ -274,7 +402,7 @@ void escribirLineaCabeceraBlackbox(const char *nombre, const char *fmt, ...)
 ****************************************************************************************/
 void calcularBytesLibresCabBlackbox(void)
 {
-    int32_t espacioLibre = afatfs_getFreeBufferSpace();
+    int32_t espacioLibre = bytesLibresBufferAnillo(&colaBlackbox.anillo);
 
     bytesLibresCabBlackbox = MIN(MIN(espacioLibre, bytesLibresCabBlackbox + BYTES_LIBRES_CAB_POR_ITERACION_BLACKBOX), NUM_MAX_BYTES_LIBRES_BLACKBOX);
 }
@@ -294,13 +422,14 @@ bool blackboxLlena(void)
 
 /***************************************************************************************
 **  Nombre:         bool forzarFlushCompletoBlackbox(void)
-**  Descripcion:    Hace unflush en la SD y retorna true cuando el sync es completo
+**  Descripcion:    Hace unflush en la SD y retorna true cuando la cola esta volcada y el
+**                  sync es completo
 **  Parametros:     Ninguno
 **  Retorno:        True si OK
 ****************************************************************************************/
 bool forzarFlushCompletoBlackbox(void)
 {
-    if (afatfs_sectorCacheInSync()) {
+    if (bytesPendientesColaBlackbox(&colaBlackbox) == 0 && afatfs_sectorCacheInSync()) {
         return true;
 	}
     else {
@@ -32,6 +32,7 @@
 #include <stdbool.h>
 
 #include "Sistema/plataforma.h"
+#include "cola_blackbox.h"
 
 
 /***************************************************************************************
@@ -62,9 +63,15 @@ extern int32_t bytesLibresCabBlackbox;
 // Funciones del driver
 bool abrirBlackbox(void);
 bool iniciarLogBlackbox(void);
+void solicitarDescarteBlackbox(void);
 bool finalizarLogBlackbox(bool logEmpezado);
 void escribirBlackbox(uint8_t valor);
+void escribirBufferBlackbox(const uint8_t *buffer, uint32_t longitud);
 uint32_t escribirStringBlackbox(const char *s);
+uint8_t *reservarFrameBlackbox(uint32_t longitudMax);
+bool publicarFrameBlackbox(uint32_t longitud);
+void volcarColaBlackbox(void);
+const colaBlackbox_t *colaLogBlackbox(void);
 uint32_t printfBlackbox(const char *fmt, ...);
 void escribirLineaCabeceraBlackbox(const char *nombre, const char *fmt, ...);
 void calcularBytesLibresCabBlackbox(void);
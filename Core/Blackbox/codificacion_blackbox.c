@@ -0,0 +1,247 @@
+/***************************************************************************************
+**  codificacion_blackbox.c - Codificacion binaria de los frames de la blackbox
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "codificacion_blackbox.h"
+
+#if defined(USAR_BLACKBOX) || defined(SITL)
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+int16_t saturarFijo16Blackbox(int32_t valor);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         uint32_t zigzagBlackbox(int32_t valor)
+**  Descripcion:    Intercala positivos y negativos para que los valores pequenios ocupen
+**                  pocos bytes: 0, -1, 1, -2... pasan a 0, 1, 2, 3...
+**  Parametros:     Valor con signo
+**  Retorno:        Valor sin signo
+****************************************************************************************/
+CODIGO_RAPIDO uint32_t zigzagBlackbox(int32_t valor)
+{
+    return ((uint32_t)valor << 1) ^ (uint32_t)(valor >> 31);
+}
+
+
+/***************************************************************************************
+**  Nombre:         int32_t deshacerZigzagBlackbox(uint32_t valor)
+**  Descripcion:    Inversa de zigzagBlackbox
+**  Parametros:     Valor sin signo
+**  Retorno:        Valor con signo
+****************************************************************************************/
+int32_t deshacerZigzagBlackbox(uint32_t valor)
+{
+    return (int32_t)((valor >> 1) ^ (0U - (valor & 1)));
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t escribirVarintBlackbox(uint8_t *buffer, uint32_t valor)
+**  Descripcion:    Escribe un valor en grupos de 7 bits, primero los de menor peso. El bit
+**                  alto de cada byte indica que sigue otro
+**  Parametros:     Buffer de al menos MAX_BYTES_CAMPO_BLACKBOX bytes, valor
+**  Retorno:        Bytes escritos
+****************************************************************************************/
+CODIGO_RAPIDO uint8_t escribirVarintBlackbox(uint8_t *buffer, uint32_t valor)
+{
+    uint8_t n = 0;
+
+    while (valor > 0x7F) {
+        buffer[n++] = (uint8_t)(valor | 0x80);
+        valor >>= 7;
+    }
+
+    buffer[n++] = (uint8_t)valor;
+    return n;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t leerVarintBlackbox(const uint8_t *buffer, uint32_t longitud, uint32_t *valor)
+**  Descripcion:    Lee un valor escrito con escribirVarintBlackbox
+**  Parametros:     Buffer, bytes disponibles, valor leido
+**  Retorno:        Bytes leidos. 0 si el varint esta incompleto o es demasiado largo
+****************************************************************************************/
+uint8_t leerVarintBlackbox(const uint8_t *buffer, uint32_t longitud, uint32_t *valor)
+{
+    uint32_t resultado = 0;
+
+    for (uint8_t i = 0; i < MAX_BYTES_CAMPO_BLACKBOX && i < longitud; i++) {
+        resultado |= (uint32_t)(buffer[i] & 0x7F) << (7 * i);
+
+        if ((buffer[i] & 0x80) == 0) {
+            *valor = resultado;
+            return i + 1;
+        }
+    }
+
+    return 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         int16_t saturarFijo16Blackbox(int32_t valor)
+**  Descripcion:    Limita un valor al rango de 16 bits
+**  Parametros:     Valor
+**  Retorno:        Valor saturado
+****************************************************************************************/
+CODIGO_RAPIDO int16_t saturarFijo16Blackbox(int32_t valor)
+{
+    if (valor > INT16_MAX)
+        return INT16_MAX;
+    else if (valor < INT16_MIN)
+        return INT16_MIN;
+    else
+        return (int16_t)valor;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t codificarFrameBlackbox(uint8_t *buffer, const uint8_t *codificacion, int32_t *previos,
+**                                                  const int32_t *valores, uint8_t numCampos, bool completo)
+**  Descripcion:    Codifica los campos de un frame. En los frames delta se escribe la
+**                  diferencia con el valor que reconstruira el decodificador, de forma que
+**                  la saturacion de los campos de 16 bits no acumula error
+**  Parametros:     Buffer de al menos numCampos * MAX_BYTES_CAMPO_BLACKBOX bytes,
+**                  codificacion de cada campo, valores del frame anterior (se actualizan),
+**                  valores, numero de campos, frame completo o delta
+**  Retorno:        Bytes escritos
+****************************************************************************************/
+CODIGO_RAPIDO uint16_t codificarFrameBlackbox(uint8_t *buffer, const uint8_t *codificacion, int32_t *previos,
+                                              const int32_t *valores, uint8_t numCampos, bool completo)
+{
+    uint16_t n = 0;
+
+    for (uint8_t i = 0; i < numCampos; i++) {
+        // La resta sin signo da la diferencia modulo 2^32, que tambien deshace el decodificador
+        const int32_t dato = completo ? valores[i] : (int32_t)((uint32_t)valores[i] - (uint32_t)previos[i]);
+
+        switch (codificacion[i]) {
+            case BLACKBOX_COD_VB_SIN_SIGNO:
+                n += escribirVarintBlackbox(&buffer[n], (uint32_t)dato);
+                previos[i] = valores[i];
+                break;
+
+            case BLACKBOX_COD_FIJO_16: {
+                const int16_t saturado = saturarFijo16Blackbox(dato);
+
+                buffer[n++] = (uint8_t)saturado;
+                buffer[n++] = (uint8_t)((uint16_t)saturado >> 8);
+                previos[i] = completo ? saturado : (int32_t)((uint32_t)previos[i] + (uint32_t)saturado);
+                break;
+            }
+
+            case BLACKBOX_COD_VB_CON_SIGNO:
+            default:
+                n += escribirVarintBlackbox(&buffer[n], zigzagBlackbox(dato));
+                previos[i] = valores[i];
+                break;
+        }
+    }
+
+    return n;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t decodificarFrameBlackbox(const uint8_t *buffer, uint32_t longitud, const uint8_t *codificacion,
+**                                                    int32_t *previos, uint8_t numCampos, bool completo)
+**  Descripcion:    Decodifica los campos de un frame sobre los valores del frame anterior
+**  Parametros:     Buffer sin el marcador, bytes disponibles, codificacion de cada campo,
+**                  valores del frame anterior (se sustituyen por los del frame), numero de
+**                  campos, frame completo o delta
+**  Retorno:        Bytes leidos. 0 si el frame esta incompleto o corrupto
+****************************************************************************************/
+uint32_t decodificarFrameBlackbox(const uint8_t *buffer, uint32_t longitud, const uint8_t *codificacion, int32_t *previos,
+                                  uint8_t numCampos, bool completo)
+{
+    int32_t valores[NUM_MAX_CAMPOS_BLACKBOX];
+    uint32_t n = 0;
+
+    if (numCampos > NUM_MAX_CAMPOS_BLACKBOX)
+        return 0;
+
+    for (uint8_t i = 0; i < numCampos; i++) {
+        uint32_t dato;
+        uint8_t leidos;
+
+        switch (codificacion[i]) {
+            case BLACKBOX_COD_VB_SIN_SIGNO:
+            case BLACKBOX_COD_VB_CON_SIGNO:
+                leidos = leerVarintBlackbox(&buffer[n], longitud - n, &dato);
+                if (leidos == 0)
+                    return 0;
+
+                if (codificacion[i] == BLACKBOX_COD_VB_CON_SIGNO)
+                    dato = (uint32_t)deshacerZigzagBlackbox(dato);
+
+                n += leidos;
+                break;
+
+            case BLACKBOX_COD_FIJO_16:
+                if (longitud - n < 2)
+                    return 0;
+
+                dato = (uint32_t)(int32_t)(int16_t)(buffer[n] | (buffer[n + 1] << 8));
+                n += 2;
+                break;
+
+            default:
+                return 0;
+        }
+
+        valores[i] = completo ? (int32_t)dato : (int32_t)((uint32_t)previos[i] + dato);
+    }
+
+    for (uint8_t i = 0; i < numCampos; i++)
+        previos[i] = valores[i];
+
+    return n;
+}
+
+#endif // USAR_BLACKBOX || SITL
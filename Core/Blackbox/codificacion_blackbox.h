@@ -0,0 +1,95 @@
+/***************************************************************************************
+**  codificacion_blackbox.h - Codificacion binaria de los frames de la blackbox
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __CODIFICACION_BLACKBOX_H
+#define __CODIFICACION_BLACKBOX_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Formato del log (version 2). La cabecera es de texto: lineas "C ..." con la
+ * informacion del sistema y, por cada tipo de frame (R rapido, L lento), la lista de
+ * campos con su nombre, numero de drivers, codificacion y escala. Un campo con varios
+ * drivers ocupa tantas posiciones consecutivas en el frame como drivers tenga.
+ *
+ * Despues de la cabecera todo es binario. Cada frame empieza por un byte marcador:
+ *   'I'  Frame rapido completo. Cada campo lleva su valor
+ *   'P'  Frame rapido delta. Cada campo lleva la diferencia con el frame anterior
+ *   'L'  Frame lento. Siempre completo
+ *   'E'  Evento: tipo y sus datos en varint sin signo
+ *
+ * Los valores son enteros: las magnitudes en coma flotante se multiplican por la escala
+ * del campo. Los P solo se pueden decodificar a partir del ultimo I, que se repite cada
+ * INTERVALO_FRAME_I_BLACKBOX frames para poder recuperar el log tras un error
+ */
+#define VERSION_FORMATO_BLACKBOX          2
+#define INTERVALO_FRAME_I_BLACKBOX        32
+#define MAX_BYTES_CAMPO_BLACKBOX          5
+#define NUM_MAX_CAMPOS_BLACKBOX           96
+#define MAX_BYTES_FRAME_BLACKBOX          (1 + NUM_MAX_CAMPOS_BLACKBOX * MAX_BYTES_CAMPO_BLACKBOX)   // Con el marcador
+
+#define MARCADOR_FRAME_I_BLACKBOX         'I'
+#define MARCADOR_FRAME_P_BLACKBOX         'P'
+#define MARCADOR_FRAME_LENTO_BLACKBOX     'L'
+#define MARCADOR_EVENTO_BLACKBOX          'E'
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef enum {
+    BLACKBOX_COD_VB_SIN_SIGNO = 0,         // Varint. Para contadores que solo crecen
+    BLACKBOX_COD_VB_CON_SIGNO,             // Zig-zag y varint
+    BLACKBOX_COD_FIJO_16,                  // Entero de 16 bits saturado. Tamanio de frame constante
+} codificacionCampoBlackbox_e;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+uint32_t zigzagBlackbox(int32_t valor);
+int32_t deshacerZigzagBlackbox(uint32_t valor);
+uint8_t escribirVarintBlackbox(uint8_t *buffer, uint32_t valor);
+uint8_t leerVarintBlackbox(const uint8_t *buffer, uint32_t longitud, uint32_t *valor);
+uint16_t codificarFrameBlackbox(uint8_t *buffer, const uint8_t *codificacion, int32_t *previos, const int32_t *valores,
+                                uint8_t numCampos, bool completo);
+uint32_t decodificarFrameBlackbox(const uint8_t *buffer, uint32_t longitud, const uint8_t *codificacion, int32_t *previos,
+                                  uint8_t numCampos, bool completo);
+
+#endif // __CODIFICACION_BLACKBOX_H
@@ -0,0 +1,250 @@
+/***************************************************************************************
+**  cola_blackbox.c - Cola entre la escritura de frames de la blackbox y la SD
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "cola_blackbox.h"
+
+#if defined(USAR_BLACKBOX) || defined(SITL)
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+static inline void actualizarMaxOcupadosColaBlackbox(colaBlackbox_t *cola);
+static inline void descartarColaBlackbox(colaBlackbox_t *cola, uint32_t longitud);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool iniciarColaBlackbox(colaBlackbox_t *cola, uint8_t *buffer, uint32_t tam, uint8_t *temporal,
+**                                           uint32_t tamTemporal)
+**  Descripcion:    Inicia la cola vacia y con los contadores a cero
+**  Parametros:     Cola, buffer del anillo, tamanio (potencia de 2), buffer temporal para
+**                  los frames partidos y su tamanio (el de un frame maximo)
+**  Retorno:        True si ok
+****************************************************************************************/
+bool iniciarColaBlackbox(colaBlackbox_t *cola, uint8_t *buffer, uint32_t tam, uint8_t *temporal, uint32_t tamTemporal)
+{
+    if (!iniciarBufferAnillo(&cola->anillo, buffer, tam))
+        return false;
+
+    cola->temporal = temporal;
+    cola->tamTemporal = temporal != NULL ? tamTemporal : 0;
+    resetearColaBlackbox(cola);
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void resetearColaBlackbox(colaBlackbox_t *cola)
+**  Descripcion:    Descarta los datos pendientes y pone a cero los contadores. Solo con el
+**                  productor y el consumidor parados, por ejemplo al empezar un log
+**  Parametros:     Cola
+**  Retorno:        Ninguno
+****************************************************************************************/
+void resetearColaBlackbox(colaBlackbox_t *cola)
+{
+    vaciarBufferAnillo(&cola->anillo);
+    cola->reserva = NULL;
+    cola->framesDescartados = 0;
+    cola->bytesDescartados = 0;
+    cola->maxOcupados = 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t *reservarColaBlackbox(colaBlackbox_t *cola, uint32_t longitudMax)
+**  Descripcion:    Da donde codificar el siguiente frame: en el anillo si hay un tramo
+**                  contiguo libre para el tamanio maximo y si no en el buffer temporal.
+**                  No comprueba si el frame va a caber, eso se decide al publicar con su
+**                  longitud real
+**  Parametros:     Cola, longitud maxima del frame
+**  Retorno:        Destino del frame o NULL si no cabe ni en el temporal
+****************************************************************************************/
+CODIGO_RAPIDO uint8_t *reservarColaBlackbox(colaBlackbox_t *cola, uint32_t longitudMax)
+{
+    uint8_t *bloque;
+
+    if (reservarBufferAnillo(&cola->anillo, &bloque, longitudMax) >= longitudMax)
+        cola->reserva = bloque;
+    else if (longitudMax <= cola->tamTemporal)
+        cola->reserva = cola->temporal;
+    else {
+        cola->reserva = NULL;
+        cola->framesDescartados++;
+    }
+
+    return cola->reserva;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool publicarColaBlackbox(colaBlackbox_t *cola, uint32_t longitud)
+**  Descripcion:    Publica el frame reservado entero o, si no cabe, lo descarta entero
+**  Parametros:     Cola, longitud real del frame
+**  Retorno:        True si se ha publicado
+****************************************************************************************/
+CODIGO_RAPIDO bool publicarColaBlackbox(colaBlackbox_t *cola, uint32_t longitud)
+{
+    uint8_t *reserva = cola->reserva;
+
+    cola->reserva = NULL;
+    if (reserva == NULL)
+        return false;
+
+    if (reserva != cola->temporal)
+        publicarBufferAnillo(&cola->anillo, longitud);
+    else if (longitud <= bytesLibresBufferAnillo(&cola->anillo))
+        escribirBufferAnillo(&cola->anillo, reserva, longitud);
+    else {
+        descartarColaBlackbox(cola, longitud);
+        return false;
+    }
+
+    actualizarMaxOcupadosColaBlackbox(cola);
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool escribirColaBlackbox(colaBlackbox_t *cola, const uint8_t *datos, uint32_t longitud)
+**  Descripcion:    Copia un frame ya formado (un evento) entero o lo descarta entero
+**  Parametros:     Cola, datos, longitud
+**  Retorno:        True si se ha escrito
+****************************************************************************************/
+CODIGO_RAPIDO bool escribirColaBlackbox(colaBlackbox_t *cola, const uint8_t *datos, uint32_t longitud)
+{
+    if (escribirBytesColaBlackbox(cola, datos, longitud))
+        return true;
+
+    cola->framesDescartados++;
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool escribirBytesColaBlackbox(colaBlackbox_t *cola, const uint8_t *datos, uint32_t longitud)
+**  Descripcion:    Copia unos bytes sueltos (texto de la cabecera) enteros o los descarta.
+**                  No son un frame, asi que solo cuentan como bytes descartados
+**  Parametros:     Cola, datos, longitud
+**  Retorno:        True si se han escrito
+****************************************************************************************/
+CODIGO_RAPIDO bool escribirBytesColaBlackbox(colaBlackbox_t *cola, const uint8_t *datos, uint32_t longitud)
+{
+    if (longitud > bytesLibresBufferAnillo(&cola->anillo)) {
+        cola->bytesDescartados += longitud;
+        return false;
+    }
+
+    escribirBufferAnillo(&cola->anillo, datos, longitud);
+    actualizarMaxOcupadosColaBlackbox(cola);
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t bloqueColaBlackbox(colaBlackbox_t *cola, const uint8_t **bloque)
+**  Descripcion:    Da el tramo contiguo de datos pendientes. Los frames partidos salen en
+**                  dos tramos
+**  Parametros:     Cola, puntero al tramo
+**  Retorno:        Bytes del tramo
+****************************************************************************************/
+uint32_t bloqueColaBlackbox(colaBlackbox_t *cola, const uint8_t **bloque)
+{
+    return bloqueBufferAnillo(&cola->anillo, bloque);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void consumirColaBlackbox(colaBlackbox_t *cola, uint32_t longitud)
+**  Descripcion:    Libera los bytes ya entregados a la SD
+**  Parametros:     Cola, bytes entregados
+**  Retorno:        Ninguno
+****************************************************************************************/
+void consumirColaBlackbox(colaBlackbox_t *cola, uint32_t longitud)
+{
+    consumirBufferAnillo(&cola->anillo, longitud);
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t bytesPendientesColaBlackbox(const colaBlackbox_t *cola)
+**  Descripcion:    Devuelve los bytes publicados que no se han entregado a la SD
+**  Parametros:     Cola
+**  Retorno:        Numero de bytes
+****************************************************************************************/
+uint32_t bytesPendientesColaBlackbox(const colaBlackbox_t *cola)
+{
+    return bytesOcupadosBufferAnillo(&cola->anillo);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void actualizarMaxOcupadosColaBlackbox(colaBlackbox_t *cola)
+**  Descripcion:    Actualiza el maximo de bytes pendientes tras publicar
+**  Parametros:     Cola
+**  Retorno:        Ninguno
+****************************************************************************************/
+static inline void actualizarMaxOcupadosColaBlackbox(colaBlackbox_t *cola)
+{
+    const uint32_t ocupados = bytesOcupadosBufferAnillo(&cola->anillo);
+
+    if (ocupados > cola->maxOcupados)
+        cola->maxOcupados = ocupados;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void descartarColaBlackbox(colaBlackbox_t *cola, uint32_t longitud)
+**  Descripcion:    Cuenta un frame que no cabe
+**  Parametros:     Cola, longitud del frame
+**  Retorno:        Ninguno
+****************************************************************************************/
+static inline void descartarColaBlackbox(colaBlackbox_t *cola, uint32_t longitud)
+{
+    cola->framesDescartados++;
+    cola->bytesDescartados += longitud;
+}
+
+#endif
@@ -0,0 +1,91 @@
+/***************************************************************************************
+**  cola_blackbox.h - Cola entre la escritura de frames de la blackbox y la SD
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __COLA_BLACKBOX_H
+#define __COLA_BLACKBOX_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+#include "Comun/buffer_anillo.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Un unico productor (el log, en la tarea del blackbox o en una interrupcion) y un unico
+ * consumidor (la tarea que vuelca a la SD) sobre un bufferAnillo_t, sin memoria dinamica
+ * ni secciones criticas. El productor reserva el tamanio maximo de un frame, lo codifica
+ * en su sitio y lo publica entero o lo descarta entero, asi que el coste no depende de lo
+ * que tarde la SD. Si el tramo libre hasta el final del buffer no llega, el frame se
+ * codifica en un buffer temporal y se copia en dos trozos al publicar.
+ *
+ * Con 16 KB y frames de unos 100 bytes a 1 kHz caben unos 160 ms de SD ocupada. El maximo
+ * de bytes ocupados permite ajustar el tamanio con logs reales
+ */
+#define TAM_COLA_BLACKBOX                 16384     // Potencia de 2
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    bufferAnillo_t anillo;
+    uint8_t *temporal;                    // Frames que no caben antes del final del buffer
+    uint32_t tamTemporal;
+    uint8_t *reserva;                     // Destino del frame reservado
+    uint32_t framesDescartados;
+    uint32_t bytesDescartados;
+    uint32_t maxOcupados;                 // Bytes pendientes maximos desde el reseteo
+} colaBlackbox_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool iniciarColaBlackbox(colaBlackbox_t *cola, uint8_t *buffer, uint32_t tam, uint8_t *temporal, uint32_t tamTemporal);
+void resetearColaBlackbox(colaBlackbox_t *cola);
+
+// Productor
+uint8_t *reservarColaBlackbox(colaBlackbox_t *cola, uint32_t longitudMax);
+bool publicarColaBlackbox(colaBlackbox_t *cola, uint32_t longitud);
+bool escribirColaBlackbox(colaBlackbox_t *cola, const uint8_t *datos, uint32_t longitud);
+bool escribirBytesColaBlackbox(colaBlackbox_t *cola, const uint8_t *datos, uint32_t longitud);
+
+// Consumidor
+uint32_t bloqueColaBlackbox(colaBlackbox_t *cola, const uint8_t **bloque);
+void consumirColaBlackbox(colaBlackbox_t *cola, uint32_t longitud);
+uint32_t bytesPendientesColaBlackbox(const colaBlackbox_t *cola);
+
+#endif // __COLA_BLACKBOX_H
@@ -7,7 +7,7 @@
 **
 **  Autor: Ramon Rico
 **  Fecha de creacion: 12/09/2019
-**  Fecha de modificacion: 03/08/2020
+**  Fecha de modificacion: 17/10/2026
 **
 **  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
 **  bajo ningun concepto.
@@ -230,4 +230,31 @@ estadoOperacionSD_e escribirBloqueSD(uint32_t indice, uint8_t *buffer, callbackO
 }
 
 
+/***************************************************************************************
+**  Nombre:         estadoOperacionSD_e escribirBloquesSD(uint32_t indice, uint8_t *buffer, uint16_t numBloques,
+**                                                        callbackOpCompletaSD_c callback, uint32_t datoCallback)
+**  Descripcion:    Escribe varios bloques consecutivos con un solo comando directamente desde
+**                  el buffer, sin pasar por la cache del driver
+**  Parametros:     Indice del primer bloque, buffer de escritura de los datos, numero de
+**                  bloques (como mucho maxBloquesEscrituraSD), funcion de callback, dato de callback
+**  Retorno:        Estado de la operacion
+****************************************************************************************/
+estadoOperacionSD_e escribirBloquesSD(uint32_t indice, uint8_t *buffer, uint16_t numBloques, callbackOpCompletaSD_c callback, uint32_t datoCallback)
+{
+    return tablaFnSD->escribirBloquesSD(indice, buffer, numBloques, callback, datoCallback);
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t maxBloquesEscrituraSD(void)
+**  Descripcion:    Devuelve los bloques que se pueden escribir con un solo comando
+**  Parametros:     Ninguno
+**  Retorno:        Numero de bloques
+****************************************************************************************/
+uint16_t maxBloquesEscrituraSD(void)
+{
+    return tablaFnSD ? tablaFnSD->maxBloquesEscritura : 1;
+}
+
+
 #endif
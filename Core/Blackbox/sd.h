@@ -7,7 +7,7 @@
 **
 **  Autor: Ramon Rico
 **  Fecha de creacion: 12/09/2019
-**  Fecha de modificacion: 03/08/2020
+**  Fecha de modificacion: 17/10/2026
 **
 **  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
 **  bajo ningun concepto.
@@ -34,7 +34,7 @@
 #include "Sistema/plataforma.h"
 #include "sd_estandar.h"
 #include "GP/gp.h"
-#include "drivers/bus.h"
+#include "Drivers/bus.h"
 
 
 /***************************************************************************************
@@ -108,6 +108,8 @@ typedef struct {
     bool (*leerBloqueSD)(uint32_t indice, uint8_t *buffer, callbackOpCompletaSD_c callback, uint32_t datoCallback);
     estadoOperacionSD_e (*iniciarEscrituraBloquesSD)(uint32_t indice, uint32_t numBloques);
     estadoOperacionSD_e (*escribirBloqueSD)(uint32_t indice, uint8_t *buffer, callbackOpCompletaSD_c callback, uint32_t datoCallback);
+    estadoOperacionSD_e (*escribirBloquesSD)(uint32_t indice, uint8_t *buffer, uint16_t numBloques, callbackOpCompletaSD_c callback, uint32_t datoCallback);
+    uint16_t maxBloquesEscritura;       // Bloques que acepta escribirBloquesSD en un solo comando
 } tablaFnSD_t;
 
 typedef struct {
@@ -156,5 +158,7 @@ bool sondearSD(void);
 bool leerBloqueSD(uint32_t indice, uint8_t *buffer, callbackOpCompletaSD_c callback, uint32_t datoCallback);
 estadoOperacionSD_e iniciarEscrituraBloquesSD(uint32_t indice, uint32_t numBloques);
 estadoOperacionSD_e escribirBloqueSD(uint32_t indice, uint8_t *buffer, callbackOpCompletaSD_c callback, uint32_t datoCallback);
+estadoOperacionSD_e escribirBloquesSD(uint32_t indice, uint8_t *buffer, uint16_t numBloques, callbackOpCompletaSD_c callback, uint32_t datoCallback);
+uint16_t maxBloquesEscrituraSD(void);
 
 #endif // __SD_H
@@ -7,7 +7,7 @@
 **
 **  Autor: Ramon Rico
 **  Fecha de creacion: 02/05/2020
-**  Fecha de modificacion: 03/08/2020
+**  Fecha de modificacion: 17/10/2026
 **
 **  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
 **  bajo ningun concepto.
@@ -42,6 +42,9 @@
 // Esto se usa para acelerar la escritura en la SD. Asyncfatfs tiene soporte limitado para escritura multibloque
 #define TAM_BLOQUE_CACHE_FATFS_SD_SDIO      16
 
+// Bloques de una escritura directa con CMD25 (el DMA del SDMMC no tiene limite practico)
+#define MAX_BLOQUES_ESCRITURA_SD_SDIO       128
+
 
 /***************************************************************************************
 ** AREA DE DEFINICION DE TIPOS                                                        **
@@ -64,6 +67,7 @@ bool sondearSDsdio(void);
 bool leerBloqueSDsdio(uint32_t indiceBloque, uint8_t *buffer, callbackOpCompletaSD_c callback, uint32_t datoCallback);
 estadoOperacionSD_e iniciarEscrituraBloquesSDsdio(uint32_t indiceBloque, uint32_t numBloques);
 estadoOperacionSD_e escribirBloqueSDsdio(uint32_t indiceBloque, uint8_t *buffer, callbackOpCompletaSD_c callback, uint32_t datoCallback);
+estadoOperacionSD_e escribirBloquesSDsdio(uint32_t indiceBloque, uint8_t *buffer, uint16_t numBloques, callbackOpCompletaSD_c callback, uint32_t datoCallback);
 
 // Funciones auxiliares
 bool inicializacionCompletaSDsdio(void);
@@ -74,6 +78,7 @@ bool leerRegistroCIDsdSDIO(void);
 estadoOperacionSD_e finalizarEscrituraBloquesSDsdio(void);
 estadoRecepcionBloqueSD_e recibirBloqueDatosSDsdio(uint8_t *buffer, uint16_t tam);
 void resetearCacheSDsdio(void);
+bool vaciarCacheSDsdio(void);
 void escribirCacheSDsdio(uint8_t *buffer);
 uint16_t obtenerContadorCacheSDsdio(void);
 
@@ -413,6 +418,58 @@ estadoOperacionSD_e escribirBloqueSDsdio(uint32_t indiceBloque, uint8_t *buffer,
 }
 
 
+/***************************************************************************************
+**  Nombre:         estadoOperacionSD_e escribirBloquesSDsdio(uint32_t indiceBloque, uint8_t *buffer, uint16_t numBloques,
+**                                                            callbackOpCompletaSD_c callback, uint32_t datoCallback)
+**  Descripcion:    Escribe numBloques bloques consecutivos con una sola transferencia DMA (CMD25)
+**                  leyendo directamente del buffer, sin copiarlos a la cache. Si habia una escritura
+**                  de bloques multiples a medias se finaliza antes. El callback se llama una vez al
+**                  terminar la transmision de todos los bloques
+**  Parametros:     Indice del primer bloque, buffer (alineado a 4 bytes), numero de bloques,
+**                  callback, dato del callback
+**  Retorno:        Igual que escribirBloqueSDsdio
+****************************************************************************************/
+estadoOperacionSD_e escribirBloquesSDsdio(uint32_t indiceBloque, uint8_t *buffer, uint16_t numBloques, callbackOpCompletaSD_c callback, uint32_t datoCallback)
+{
+    sd_t *driver = punteroSD();
+
+    if (numBloques == 0 || numBloques > MAX_BLOQUES_ESCRITURA_SD_SDIO)
+        return SD_OPERACION_FALLO;
+
+    // Los bloques de una escritura multiple que siguen en la cache se envian antes. Al
+    // terminar la tarjeta vuelve a READY y se puede repetir la llamada
+    if (driver->estado == SD_ESTADO_READY && driver->usarCache && obtenerContadorCacheSDsdio() > 0)
+        return vaciarCacheSDsdio() ? SD_OPERACION_OCUPADO : SD_OPERACION_FALLO;
+
+    if (driver->estado == SD_ESTADO_ESCRIBIENDO_MULTIPLES_BLOQUES && finalizarEscrituraBloquesSDsdio() != SD_OPERACION_EXITO)
+        return SD_OPERACION_OCUPADO;
+
+    if (driver->estado != SD_ESTADO_READY)
+        return SD_OPERACION_OCUPADO;
+
+    driver->operacionPendiente.buffer = buffer;
+    driver->operacionPendiente.indiceBloque = indiceBloque;
+    driver->operacionPendiente.callback = callback;
+    driver->operacionPendiente.datoCallback = datoCallback;
+    driver->operacionPendiente.indiceTrozo = 1;
+    driver->bloquesRestantesMultiEscritura = 0;             // Al terminar de programar vuelve a READY
+    driver->estado = SD_ESTADO_ENVIANDO_ESCRITURA;
+
+    if (escribirBloquesSDMMC(indiceBloque, (uint32_t*) buffer, 512, numBloques) != SD_OK) {
+    	resetearSDsdio();
+
+        if (driver->operacionPendiente.callback) {
+        	driver->operacionPendiente.callback(SD_OPERACION_BLOQUE_ESCRIBIR, driver->operacionPendiente.indiceBloque,
+            NULL, driver->operacionPendiente.datoCallback);
+        }
+
+        return SD_OPERACION_FALLO;
+    }
+
+    return SD_OPERACION_EN_PROGRESO;
+}
+
+
 /***************************************************************************************
 **  Nombre:         bool inicializacionCompletaSDsdio(void)
 **  Descripcion:    Comprueba si la tarjeta SD ha completado su secuencia de inicio
@@ -593,6 +650,38 @@ void resetearCacheSDsdio(void)
 }
 
 
+/***************************************************************************************
+**  Nombre:         bool vaciarCacheSDsdio(void)
+**  Descripcion:    Envia los bloques acumulados en la cache a partir del primero que le
+**                  corresponde y da por terminada la escritura de bloques multiples
+**  Parametros:     Ninguno
+**  Retorno:        True si se ha lanzado la escritura
+****************************************************************************************/
+bool vaciarCacheSDsdio(void)
+{
+    sd_t *driver = punteroSD();
+    const uint16_t bloques = obtenerContadorCacheSDsdio();
+
+    driver->operacionPendiente.buffer = escrituraCacheSDsdio;
+    driver->operacionPendiente.indiceBloque = driver->siguienteBloqueMultiEscritura - bloques;
+    driver->operacionPendiente.callback = NULL;
+    driver->operacionPendiente.datoCallback = 0;
+    driver->operacionPendiente.indiceTrozo = 1;
+    driver->bloquesRestantesMultiEscritura = 0;
+    driver->estado = SD_ESTADO_ENVIANDO_ESCRITURA;
+
+    // La cache no se vuelve a llenar hasta que la tarjeta este en READY, con el DMA ya terminado
+    resetearCacheSDsdio();
+
+    if (escribirBloquesSDMMC(driver->operacionPendiente.indiceBloque, (uint32_t*) escrituraCacheSDsdio, 512, bloques) != SD_OK) {
+    	resetearSDsdio();
+        return false;
+    }
+
+    return true;
+}
+
+
 /***************************************************************************************
 **  Nombre:         void escribirCacheSDsdio(uint8_t *buffer)
 **  Descripcion:    Escribe en la cache un buffer
@@ -631,6 +720,8 @@ tablaFnSD_t tablaFnSDsdio = {
     leerBloqueSDsdio,
     iniciarEscrituraBloquesSDsdio,
     escribirBloqueSDsdio,
+    escribirBloquesSDsdio,
+    MAX_BLOQUES_ESCRITURA_SD_SDIO,
 };
 
 
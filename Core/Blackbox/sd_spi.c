@@ -7,7 +7,7 @@
 **
 **  Autor: Ramon Rico
 **  Fecha de creacion: 13/09/2019
-**  Fecha de modificacion: 03/08/2020
+**  Fecha de modificacion: 17/10/2026
 **
 **  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
 **  bajo ningun concepto.
@@ -73,6 +73,7 @@ bool sondearSDspi(void);
 bool leerBloqueSDspi(uint32_t indiceBloque, uint8_t *buffer, callbackOpCompletaSD_c callback, uint32_t datoCallback);
 estadoOperacionSD_e iniciarEscrituraBloquesSDspi(uint32_t indiceBloque, uint32_t numBloques);
 estadoOperacionSD_e escribirBloqueSDspi(uint32_t indiceBloque, uint8_t *buffer, callbackOpCompletaSD_c callback, uint32_t datoCallback);
+estadoOperacionSD_e escribirBloquesSDspi(uint32_t indiceBloque, uint8_t *buffer, uint16_t numBloques, callbackOpCompletaSD_c callback, uint32_t datoCallback);
 
 // Funciones auxiliares
 bool inicializacionCompletaSDspi(void);
@@ -518,6 +519,23 @@ estadoOperacionSD_e escribirBloqueSDspi(uint32_t indiceBloque, uint8_t *buffer,
 }
 
 
+/***************************************************************************************
+**  Nombre:         estadoOperacionSD_e escribirBloquesSDspi(uint32_t indiceBloque, uint8_t *buffer, uint16_t numBloques,
+**                                                           callbackOpCompletaSD_c callback, uint32_t datoCallback)
+**  Descripcion:    En SPI cada bloque lleva su token, asi que solo se acepta un bloque por llamada.
+**                  Para encadenarlos se usa iniciarEscrituraBloquesSDspi antes
+**  Parametros:     Indice de bloque, buffer, numero de bloques (1), callback, dato del callback
+**  Retorno:        Igual que escribirBloqueSDspi
+****************************************************************************************/
+estadoOperacionSD_e escribirBloquesSDspi(uint32_t indiceBloque, uint8_t *buffer, uint16_t numBloques, callbackOpCompletaSD_c callback, uint32_t datoCallback)
+{
+    if (numBloques != 1)
+        return SD_OPERACION_FALLO;
+
+    return escribirBloqueSDspi(indiceBloque, buffer, callback, datoCallback);
+}
+
+
 /***************************************************************************************
 **  Nombre:         bool inicializacionCompletaSDspi(void)
 **  Descripcion:    Comprueba si la tarjeta SD ha completado su secuencia de inicio
@@ -975,6 +993,8 @@ tablaFnSD_t tablaFnSDspi = {
     leerBloqueSDspi,
     iniciarEscrituraBloquesSDspi,
     escribirBloqueSDspi,
+    escribirBloquesSDspi,
+    1,
 };
 
 #endif
@@ -0,0 +1,120 @@
+/***************************************************************************************
+**  base_tiempos.c - Base de tiempos sobre un contador de ciclos de 32 bits
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "base_tiempos.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void calcularMultiplicadorBaseTiempos(uint32_t frecCiclos, uint32_t unidadesPorSegundo, uint32_t *mult, uint8_t *desp);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         void iniciarBaseTiempos(baseTiempos_t *base, uint32_t frecCiclos, uint32_t frecPaso,
+**                                          uint32_t ciclos, uint64_t ns)
+**  Descripcion:    Inicia la base con la referencia en un tick. La frecuencia del contador
+**                  tiene que ser multiplo de la de los pasos
+**  Parametros:     Base de tiempos, frecuencia del contador, frecuencia de los ticks,
+**                  contador y tiempo en el ultimo tick
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarBaseTiempos(baseTiempos_t *base, uint32_t frecCiclos, uint32_t frecPaso, uint32_t ciclos, uint64_t ns)
+{
+    base->ciclosPorPaso = frecCiclos / frecPaso;
+    base->usPorPaso = 1000000 / frecPaso;
+    base->nsPorPaso = 1000000000 / frecPaso;
+
+    calcularMultiplicadorBaseTiempos(frecCiclos, 1000000, &base->multUs, &base->despUs);
+    calcularMultiplicadorBaseTiempos(frecCiclos, 1000000000, &base->multNs, &base->despNs);
+
+    base->marca[0].ciclos = ciclos;
+    base->marca[0].us = (uint32_t)(ns / 1000);
+    base->marca[0].ns = ns;
+    base->version = 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void avanzarBaseTiempos(baseTiempos_t *base)
+**  Descripcion:    Avanza la referencia un paso. Se llama en cada tick y como mucho puede
+**                  pasar 2^32 ciclos sin llamarse
+**  Parametros:     Base de tiempos
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void avanzarBaseTiempos(baseTiempos_t *base)
+{
+    const uint32_t version = base->version;
+    const volatile marcaBaseTiempos_t *actual = &base->marca[version & 1];
+    volatile marcaBaseTiempos_t *siguiente = &base->marca[(version + 1) & 1];
+
+    siguiente->ciclos = actual->ciclos + base->ciclosPorPaso;
+    siguiente->us = actual->us + base->usPorPaso;
+    siguiente->ns = actual->ns + base->nsPorPaso;
+    base->version = version + 1;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void calcularMultiplicadorBaseTiempos(uint32_t frecCiclos, uint32_t unidadesPorSegundo,
+**                                                        uint32_t *mult, uint8_t *desp)
+**  Descripcion:    Calcula el multiplicador de 32 bits con el mayor desplazamiento posible.
+**                  Se redondea hacia abajo para que el tiempo no retroceda al cambiar de
+**                  referencia
+**  Parametros:     Frecuencia del contador, unidades por segundo, multiplicador, desplazamiento
+**  Retorno:        Ninguno
+****************************************************************************************/
+void calcularMultiplicadorBaseTiempos(uint32_t frecCiclos, uint32_t unidadesPorSegundo, uint32_t *mult, uint8_t *desp)
+{
+    uint8_t d = 0;
+
+    while (d < 63 && ((uint64_t)unidadesPorSegundo << (d + 1)) >> (d + 1) == unidadesPorSegundo &&
+           ((uint64_t)unidadesPorSegundo << (d + 1)) / frecCiclos <= UINT32_MAX)
+        d++;
+
+    *mult = (uint32_t)(((uint64_t)unidadesPorSegundo << d) / frecCiclos);
+    *desp = d;
+}
@@ -0,0 +1,136 @@
+/***************************************************************************************
+**  base_tiempos.h - Base de tiempos sobre un contador de ciclos de 32 bits
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __BASE_TIEMPOS_H
+#define __BASE_TIEMPOS_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * La base guarda un instante de referencia (ciclos, us, ns) que se avanza un paso exacto
+ * en cada tick (1 ms con el SysTick), sin leer el contador ni acumular redondeos. La
+ * lectura suma a la referencia los ciclos transcurridos convertidos con una multiplicacion
+ * de 32x32 bits y un desplazamiento, sin divisiones. Hay dos referencias: el tick escribe
+ * la que no esta en uso y despues cambia la version, asi que se puede leer desde cualquier
+ * interrupcion sin secciones criticas. Solo se repite la lectura si entre medias han
+ * pasado dos ticks
+ */
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef uint32_t (*leerCiclosBaseTiempos)(void);
+
+typedef struct {
+    uint32_t ciclos;                      // Contador de ciclos en la referencia
+    uint32_t us;                          // Desborda a los 70 minutos, igual que micros()
+    uint64_t ns;
+} marcaBaseTiempos_t;
+
+typedef struct {
+    volatile marcaBaseTiempos_t marca[2];
+    volatile uint32_t version;            // La referencia valida es marca[version & 1]
+    uint32_t ciclosPorPaso;
+    uint32_t usPorPaso;
+    uint32_t nsPorPaso;
+    uint32_t multUs;                      // us = (ciclos * multUs) >> despUs
+    uint32_t multNs;                      // ns = (ciclos * multNs) >> despNs
+    uint8_t despUs;
+    uint8_t despNs;
+} baseTiempos_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void iniciarBaseTiempos(baseTiempos_t *base, uint32_t frecCiclos, uint32_t frecPaso, uint32_t ciclos, uint64_t ns);
+void avanzarBaseTiempos(baseTiempos_t *base);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         uint64_t nanosBaseTiempos(const baseTiempos_t *base, leerCiclosBaseTiempos leerCiclos)
+**  Descripcion:    Devuelve el tiempo en ns. leerCiclos debe ser una funcion inline para
+**                  que la lectura se quede en unas pocas instrucciones
+**  Parametros:     Base de tiempos, funcion que lee el contador de ciclos
+**  Retorno:        Nanosegundos transcurridos
+****************************************************************************************/
+static inline uint64_t nanosBaseTiempos(const baseTiempos_t *base, leerCiclosBaseTiempos leerCiclos)
+{
+    uint32_t version;
+    uint64_t ns;
+
+    do {
+        version = base->version;
+        const volatile marcaBaseTiempos_t *marca = &base->marca[version & 1];
+        const uint32_t ciclos = leerCiclos() - marca->ciclos;
+
+        ns = marca->ns + (((uint64_t)ciclos * base->multNs) >> base->despNs);
+    } while (base->version - version >= 2);
+
+    return ns;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t microsBaseTiempos(const baseTiempos_t *base, leerCiclosBaseTiempos leerCiclos)
+**  Descripcion:    Devuelve el tiempo en us (maximo 70 minutos)
+**  Parametros:     Base de tiempos, funcion que lee el contador de ciclos
+**  Retorno:        Microsegundos transcurridos
+****************************************************************************************/
+static inline uint32_t microsBaseTiempos(const baseTiempos_t *base, leerCiclosBaseTiempos leerCiclos)
+{
+    uint32_t version, us;
+
+    do {
+        version = base->version;
+        const volatile marcaBaseTiempos_t *marca = &base->marca[version & 1];
+        const uint32_t ciclos = leerCiclos() - marca->ciclos;
+
+        us = marca->us + (uint32_t)(((uint64_t)ciclos * base->multUs) >> base->despUs);
+    } while (base->version - version >= 2);
+
+    return us;
+}
+
+#endif // __BASE_TIEMPOS_H
@@ -0,0 +1,255 @@
+/***************************************************************************************
+**  buffer_anillo.c - Buffer en anillo de bytes para un productor y un consumidor
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <string.h>
+
+#include "buffer_anillo.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool iniciarBufferAnillo(bufferAnillo_t *anillo, uint8_t *buffer, uint32_t tam)
+**  Descripcion:    Inicia el anillo sobre un buffer
+**  Parametros:     Anillo, buffer, tamanio del buffer (potencia de 2)
+**  Retorno:        True si ok
+****************************************************************************************/
+bool iniciarBufferAnillo(bufferAnillo_t *anillo, uint8_t *buffer, uint32_t tam)
+{
+    if (tam == 0 || (tam & (tam - 1)) != 0)
+        return false;
+
+    anillo->buffer = buffer;
+    anillo->mascara = tam - 1;
+    anillo->cabeza = 0;
+    anillo->cola = 0;
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void vaciarBufferAnillo(bufferAnillo_t *anillo)
+**  Descripcion:    Descarta los bytes pendientes. Lo llama el consumidor
+**  Parametros:     Anillo
+**  Retorno:        Ninguno
+****************************************************************************************/
+void vaciarBufferAnillo(bufferAnillo_t *anillo)
+{
+    anillo->cola = anillo->cabeza;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t bytesOcupadosBufferAnillo(const bufferAnillo_t *anillo)
+**  Descripcion:    Devuelve los bytes publicados pendientes de consumir
+**  Parametros:     Anillo
+**  Retorno:        Numero de bytes
+****************************************************************************************/
+CODIGO_RAPIDO uint32_t bytesOcupadosBufferAnillo(const bufferAnillo_t *anillo)
+{
+    return anillo->cabeza - anillo->cola;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t bytesLibresBufferAnillo(const bufferAnillo_t *anillo)
+**  Descripcion:    Devuelve los bytes que se pueden escribir
+**  Parametros:     Anillo
+**  Retorno:        Numero de bytes
+****************************************************************************************/
+CODIGO_RAPIDO uint32_t bytesLibresBufferAnillo(const bufferAnillo_t *anillo)
+{
+    return anillo->mascara + 1 - (anillo->cabeza - anillo->cola);
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t reservarBufferAnillo(bufferAnillo_t *anillo, uint8_t **bloque, uint32_t longitud)
+**  Descripcion:    Da un tramo contiguo libre desde la cabeza para escribir en el. Puede
+**                  ser mas corto que lo pedido si se llega al final del buffer o se llena
+**  Parametros:     Anillo, puntero al tramo, bytes que se quieren escribir
+**  Retorno:        Bytes disponibles en el tramo
+****************************************************************************************/
+CODIGO_RAPIDO uint32_t reservarBufferAnillo(bufferAnillo_t *anillo, uint8_t **bloque, uint32_t longitud)
+{
+    const uint32_t cabeza = anillo->cabeza;
+    const uint32_t posicion = cabeza & anillo->mascara;
+    const uint32_t libres = anillo->mascara + 1 - (cabeza - anillo->cola);
+    const uint32_t hastaFinal = anillo->mascara + 1 - posicion;
+
+    *bloque = &anillo->buffer[posicion];
+
+    if (longitud > libres)
+        longitud = libres;
+
+    return longitud < hastaFinal ? longitud : hastaFinal;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void publicarBufferAnillo(bufferAnillo_t *anillo, uint32_t longitud)
+**  Descripcion:    Hace visibles al consumidor los bytes escritos en el tramo reservado
+**  Parametros:     Anillo, bytes escritos
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void publicarBufferAnillo(bufferAnillo_t *anillo, uint32_t longitud)
+{
+    // Los datos tienen que estar en memoria antes de que el consumidor vea la cabeza
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    anillo->cabeza += longitud;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t escribirBufferAnillo(bufferAnillo_t *anillo, const uint8_t *dato, uint32_t longitud)
+**  Descripcion:    Copia los datos en como mucho dos tramos y los publica de una vez. Lo
+**                  que no cabe se descarta
+**  Parametros:     Anillo, datos, longitud
+**  Retorno:        Bytes escritos
+****************************************************************************************/
+CODIGO_RAPIDO uint32_t escribirBufferAnillo(bufferAnillo_t *anillo, const uint8_t *dato, uint32_t longitud)
+{
+    const uint32_t cabeza = anillo->cabeza;
+    const uint32_t posicion = cabeza & anillo->mascara;
+    const uint32_t libres = anillo->mascara + 1 - (cabeza - anillo->cola);
+    const uint32_t hastaFinal = anillo->mascara + 1 - posicion;
+
+    if (longitud > libres)
+        longitud = libres;
+
+    // Si se pasa del final del buffer el resto va al principio
+    if (longitud <= hastaFinal)
+        memcpy(&anillo->buffer[posicion], dato, longitud);
+    else {
+        memcpy(&anillo->buffer[posicion], dato, hastaFinal);
+        memcpy(anillo->buffer, dato + hastaFinal, longitud - hastaFinal);
+    }
+
+    publicarBufferAnillo(anillo, longitud);
+    return longitud;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t bloqueBufferAnillo(const bufferAnillo_t *anillo, const uint8_t **bloque)
+**  Descripcion:    Da el tramo contiguo de bytes publicados desde la cola
+**  Parametros:     Anillo, puntero al tramo
+**  Retorno:        Bytes del tramo
+****************************************************************************************/
+CODIGO_RAPIDO uint32_t bloqueBufferAnillo(const bufferAnillo_t *anillo, const uint8_t **bloque)
+{
+    const uint32_t cola = anillo->cola;
+    const uint32_t ocupados = anillo->cabeza - cola;
+    const uint32_t posicion = cola & anillo->mascara;
+    const uint32_t hastaFinal = anillo->mascara + 1 - posicion;
+
+    // La cabeza se lee antes que los datos
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+    *bloque = &anillo->buffer[posicion];
+    return ocupados < hastaFinal ? ocupados : hastaFinal;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void consumirBufferAnillo(bufferAnillo_t *anillo, uint32_t longitud)
+**  Descripcion:    Libera los bytes ya procesados del tramo obtenido con bloqueBufferAnillo
+**  Parametros:     Anillo, bytes procesados
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void consumirBufferAnillo(bufferAnillo_t *anillo, uint32_t longitud)
+{
+    // Los datos se han terminado de leer antes de devolver el espacio al productor
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    anillo->cola += longitud;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t sincronizarCabezaBufferAnillo(bufferAnillo_t *anillo, uint32_t posicion)
+**  Descripcion:    Publica lo que un productor circular ha escrito hasta su posicion. Si ha
+**                  alcanzado a la cola, los bytes pisados se descartan. Lo llama el consumidor
+**  Parametros:     Anillo, posicion de escritura del productor en el buffer
+**  Retorno:        Bytes nuevos
+****************************************************************************************/
+CODIGO_RAPIDO uint32_t sincronizarCabezaBufferAnillo(bufferAnillo_t *anillo, uint32_t posicion)
+{
+    const uint32_t nuevos = (posicion - anillo->cabeza) & anillo->mascara;
+
+    publicarBufferAnillo(anillo, nuevos);
+
+    if (anillo->cabeza - anillo->cola > anillo->mascara + 1)
+        anillo->cola = anillo->cabeza - (anillo->mascara + 1);
+
+    return nuevos;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t entregarBufferAnillo(bufferAnillo_t *anillo, entregaBufferAnillo entrega)
+**  Descripcion:    Pasa byte a byte todo lo publicado a una funcion y lo consume
+**  Parametros:     Anillo, funcion que recibe los bytes
+**  Retorno:        Bytes entregados
+****************************************************************************************/
+CODIGO_RAPIDO uint32_t entregarBufferAnillo(bufferAnillo_t *anillo, entregaBufferAnillo entrega)
+{
+    const uint8_t *bloque;
+    uint32_t total = 0, longitud;
+
+    // Como mucho dos tramos: hasta el final del buffer y desde el principio
+    while ((longitud = bloqueBufferAnillo(anillo, &bloque)) != 0) {
+        for (uint32_t i = 0; i < longitud; i++)
+            entrega(bloque[i]);
+
+        consumirBufferAnillo(anillo, longitud);
+        total += longitud;
+    }
+
+    return total;
+}
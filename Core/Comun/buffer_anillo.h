@@ -0,0 +1,89 @@
+/***************************************************************************************
+**  buffer_anillo.h - Buffer en anillo de bytes para un productor y un consumidor
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __BUFFER_ANILLO_H
+#define __BUFFER_ANILLO_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * El tamanio es potencia de 2 y los indices corren libres: la posicion es el indice con
+ * la mascara y los bytes ocupados la resta de los dos, asi que se usa todo el buffer. La
+ * cabeza solo la escribe el productor y la cola solo el consumidor, por lo que no hacen
+ * falta secciones criticas si cada uno esta en un contexto (tarea e interrupcion). El
+ * productor reserva un tramo contiguo, escribe en el directamente y lo publica con una
+ * barrera. El consumidor obtiene tramos contiguos para entregarlos sin copia (USB, DMA).
+ * Un productor circular que no mira la cola (DMA de recepcion) escribe por su cuenta y
+ * el consumidor publica hasta su posicion con sincronizarCabezaBufferAnillo. Las vueltas
+ * completas entre dos sincronizaciones no se pueden detectar
+ */
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    uint8_t *buffer;
+    uint32_t mascara;
+    volatile uint32_t cabeza;             // Bytes publicados desde el inicio
+    volatile uint32_t cola;               // Bytes consumidos desde el inicio
+} bufferAnillo_t;
+
+typedef void (*entregaBufferAnillo)(uint8_t dato);
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool iniciarBufferAnillo(bufferAnillo_t *anillo, uint8_t *buffer, uint32_t tam);
+void vaciarBufferAnillo(bufferAnillo_t *anillo);
+uint32_t bytesOcupadosBufferAnillo(const bufferAnillo_t *anillo);
+uint32_t bytesLibresBufferAnillo(const bufferAnillo_t *anillo);
+
+uint32_t reservarBufferAnillo(bufferAnillo_t *anillo, uint8_t **bloque, uint32_t longitud);
+void publicarBufferAnillo(bufferAnillo_t *anillo, uint32_t longitud);
+uint32_t escribirBufferAnillo(bufferAnillo_t *anillo, const uint8_t *dato, uint32_t longitud);
+
+uint32_t bloqueBufferAnillo(const bufferAnillo_t *anillo, const uint8_t **bloque);
+void consumirBufferAnillo(bufferAnillo_t *anillo, uint32_t longitud);
+
+uint32_t sincronizarCabezaBufferAnillo(bufferAnillo_t *anillo, uint32_t posicion);
+uint32_t entregarBufferAnillo(bufferAnillo_t *anillo, entregaBufferAnillo entrega);
+
+#endif // __BUFFER_ANILLO_H
@@ -27,10 +27,19 @@
 ****************************************************************************************/
 #include "crc.h"
 
+#ifdef USAR_CRC_HW
+#include "Drivers/crc_hw.h"
+#endif
+
 
 /***************************************************************************************
 ** AREA DE PREPROCESADOR                                                              **
 ****************************************************************************************/
+#define POLINOMIO_CRC16               0x1021
+
+#if CRC16_BYTES_POR_PASO != 4 && CRC16_BYTES_POR_PASO != 8
+#error "CRC16_BYTES_POR_PASO debe ser 4 u 8"
+#endif
 
 
 /***************************************************************************************
@@ -41,12 +50,16 @@
 /***************************************************************************************
 ** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
+// tablaCRC16[k][n]: CRC del byte n seguido de k bytes a cero. Se generan en la primera llamada
+static RAM_RAPIDA_INI uint16_t tablaCRC16[CRC16_BYTES_POR_PASO][256];
+static bool tablaCRC16Iniciada;
 
 
 /***************************************************************************************
 ** AREA DE PROTOTIPOS DE FUNCION                                                      **
 ****************************************************************************************/
 uint16_t actualizarCRC16(uint16_t crc, uint8_t dato);
+void iniciarTablaCRC16(void);
 
 
 /***************************************************************************************
@@ -104,6 +117,26 @@ uint16_t actualizarCRC16(uint16_t crc, uint8_t dato)
 }
 
 
+/***************************************************************************************
+**  Nombre:         void iniciarTablaCRC16(void)
+**  Descripcion:    Genera las tablas del CRC16
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarTablaCRC16(void)
+{
+    for (uint16_t n = 0; n < 256; n++)
+        tablaCRC16[0][n] = actualizarCRC16(0, n);
+
+    for (uint8_t k = 1; k < CRC16_BYTES_POR_PASO; k++) {
+        for (uint16_t n = 0; n < 256; n++)
+            tablaCRC16[k][n] = (tablaCRC16[k - 1][n] << 8) ^ tablaCRC16[0][tablaCRC16[k - 1][n] >> 8];
+    }
+
+    tablaCRC16Iniciada = true;
+}
+
+
 /***************************************************************************************
 **  Nombre:         uint16_t calcularCRC16(uint16_t crc, const void *dato, uint32_t longitud)
 **  Descripcion:    Actualiza el CRC
@@ -111,6 +144,23 @@ uint16_t actualizarCRC16(uint16_t crc, uint8_t dato)
 **  Retorno:        CRC
 ****************************************************************************************/
 uint16_t calcularCRC16(uint16_t crc, const void *dato, uint32_t longitud)
+{
+#ifdef USAR_CRC_HW
+    if (longitud >= LONGITUD_MIN_CRC16_HW)
+        return calcularCRC16HW(crc, dato, longitud);
+#endif
+
+    return calcularCRC16Slice(crc, dato, longitud);
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t calcularCRC16Bit(uint16_t crc, const void *dato, uint32_t longitud)
+**  Descripcion:    Actualiza el CRC bit a bit. Es la referencia de las demas versiones
+**  Parametros:     CRC, dato a actualizar, longitud de los datos
+**  Retorno:        CRC
+****************************************************************************************/
+uint16_t calcularCRC16Bit(uint16_t crc, const void *dato, uint32_t longitud)
 {
     const uint8_t *p = (const uint8_t *)dato;
     const uint8_t *pFin = p + longitud;
@@ -123,3 +173,55 @@ uint16_t calcularCRC16(uint16_t crc, const void *dato, uint32_t longitud)
     return crc;
 }
 
+
+/***************************************************************************************
+**  Nombre:         uint16_t calcularCRC16Tabla(uint16_t crc, const void *dato, uint32_t longitud)
+**  Descripcion:    Actualiza el CRC byte a byte con una tabla
+**  Parametros:     CRC, dato a actualizar, longitud de los datos
+**  Retorno:        CRC
+****************************************************************************************/
+uint16_t calcularCRC16Tabla(uint16_t crc, const void *dato, uint32_t longitud)
+{
+    const uint8_t *p = (const uint8_t *)dato;
+    const uint8_t *pFin = p + longitud;
+
+    if (!tablaCRC16Iniciada)
+        iniciarTablaCRC16();
+
+    while (p != pFin) {
+        crc = (crc << 8) ^ tablaCRC16[0][(crc >> 8) ^ *p];
+        p++;
+    }
+
+    return crc;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t calcularCRC16Slice(uint16_t crc, const void *dato, uint32_t longitud)
+**  Descripcion:    Actualiza el CRC de CRC16_BYTES_POR_PASO bytes en cada iteracion. El CRC
+**                  se suma a los dos primeros bytes y cada byte del bloque pasa por la
+**                  tabla de los bytes que le quedan detras
+**  Parametros:     CRC, dato a actualizar, longitud de los datos
+**  Retorno:        CRC
+****************************************************************************************/
+uint16_t calcularCRC16Slice(uint16_t crc, const void *dato, uint32_t longitud)
+{
+    const uint8_t *p = (const uint8_t *)dato;
+
+    if (!tablaCRC16Iniciada)
+        iniciarTablaCRC16();
+
+    for (; longitud >= CRC16_BYTES_POR_PASO; longitud -= CRC16_BYTES_POR_PASO, p += CRC16_BYTES_POR_PASO) {
+        const uint16_t x = crc ^ ((uint16_t)p[0] << 8 | p[1]);
+
+#if CRC16_BYTES_POR_PASO == 8
+        crc = tablaCRC16[7][x >> 8] ^ tablaCRC16[6][x & 0xFF] ^ tablaCRC16[5][p[2]] ^ tablaCRC16[4][p[3]] ^
+              tablaCRC16[3][p[4]] ^ tablaCRC16[2][p[5]] ^ tablaCRC16[1][p[6]] ^ tablaCRC16[0][p[7]];
+#else
+        crc = tablaCRC16[3][x >> 8] ^ tablaCRC16[2][x & 0xFF] ^ tablaCRC16[1][p[2]] ^ tablaCRC16[0][p[3]];
+#endif
+    }
+
+    return calcularCRC16Tabla(crc, p, longitud);
+}
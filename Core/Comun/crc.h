@@ -31,10 +31,18 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include "Sistema/plataforma.h"
+
 
 /***************************************************************************************
 ** AREA DE PREPROCESADOR                                                              **
 ****************************************************************************************/
+// CRC-CCITT (polinomio 0x1021, sin reflejar). calcularCRC16 usa la unidad CRC del micro
+// si esta disponible y si no las tablas de CRC16_BYTES_POR_PASO bytes por iteracion
+#ifndef CRC16_BYTES_POR_PASO
+#define CRC16_BYTES_POR_PASO          8        // 4 u 8
+#endif
+#define LONGITUD_MIN_CRC16_HW         16       // Por debajo se usan las tablas
 
 
 /***************************************************************************************
@@ -52,5 +60,8 @@
 ****************************************************************************************/
 uint16_t calcularCRC4(uint16_t *dato);
 uint16_t calcularCRC16(uint16_t crc, const void *dato, uint32_t longitud);
+uint16_t calcularCRC16Bit(uint16_t crc, const void *dato, uint32_t longitud);
+uint16_t calcularCRC16Tabla(uint16_t crc, const void *dato, uint32_t longitud);
+uint16_t calcularCRC16Slice(uint16_t crc, const void *dato, uint32_t longitud);
 
 #endif // __CRC_H
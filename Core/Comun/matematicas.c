@@ -189,6 +189,30 @@ inline float envolverFloat360(const float angulo, float unidadMod)
 }
 
 
+/***************************************************************************************
+**  Nombre:         void senoCosenoRapido(float angulo, float *seno, float *coseno)
+**  Descripcion:    Seno y coseno con un polinomio de grado 9 en [-pi/2, pi/2]. El error es
+**                  del orden de 3e-6, suficiente para los coeficientes de los filtros y mucho
+**                  mas barato que sinf y cosf
+**  Parametros:     Angulo en radianes, seno, coseno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void senoCosenoRapido(float angulo, float *seno, float *coseno)
+{
+    // Reduccion a [-pi, pi]
+    const float x = angulo - 2.0f * M_PIf * floorf(angulo * (0.5f / M_PIf) + 0.5f);
+
+    // sen(x) = sen(pi - x) y cos(x) = sen(pi/2 - |x|) dejan los dos en [-pi/2, pi/2]
+    const float xs = x > 0.5f * M_PIf ? M_PIf - x : (x < -0.5f * M_PIf ? -M_PIf - x : x);
+    const float xc = 0.5f * M_PIf - fabsf(x);
+    const float xs2 = xs * xs;
+    const float xc2 = xc * xc;
+
+    *seno = xs * (1.0f + xs2 * (-0.1666666664f + xs2 * (0.0083333315f + xs2 * (-0.0001984090f + xs2 * 0.0000027526f))));
+    *coseno = xc * (1.0f + xc2 * (-0.1666666664f + xc2 * (0.0083333315f + xc2 * (-0.0001984090f + xc2 * 0.0000027526f))));
+}
+
+
 /***************************************************************************************
 **  Nombre:         bool esPotenciaDeDos(uint32_t x)
 **  Descripcion:    Comprueba si la entrada es potencia de dos
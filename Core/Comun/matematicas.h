@@ -82,6 +82,7 @@ float moduloVector3(float *vector);
 void productoCruzado3F(float *vector1, float *vector2, float *resultado);
 float envolverInt360(const int32_t angulo, float unidadMod);
 float envolverFloat360(const float angulo, float unidadMod);
+void senoCosenoRapido(float angulo, float *seno, float *coseno);
 bool esPotenciaDeDos(uint32_t x);
 void normalizar3Array(float *a);
 void normalizar4Array(float *a);
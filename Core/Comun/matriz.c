@@ -106,7 +106,7 @@ void multiplicarEscalarMatriz(matriz_t A, float B, matriz_t *R, uint8_t dim)
 
 /***************************************************************************************
 **  Nombre:         void multiplicarMatrices(matriz_t A, matriz_t B, matriz_t *R, uint8_t dim)
-**  Descripcion:    Multiplica una matriz por un escalar
+**  Descripcion:    Multiplica dos matrices
 **  Parametros:     Primera matriz, segunda matriz, resultado, dimension de la matriz
 **  Retorno:        Ninguno
 ****************************************************************************************/
@@ -114,8 +114,11 @@ void multiplicarMatrices(matriz_t A, matriz_t B, matriz_t *R, uint8_t dim)
 {
     for (uint8_t i = 0; i < dim; i++) {
         for (uint8_t j = 0; j < dim; j++) {
+            float suma = 0.0f;
             for (uint8_t k = 0; k < dim; k++)
-                R->m[i][j] += A.m[i][k] * B.m[k][j];
+                suma += A.m[i][k] * B.m[k][j];
+
+            R->m[i][j] = suma;
         }
     }
 }
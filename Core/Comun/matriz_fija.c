@@ -0,0 +1,514 @@
+/***************************************************************************************
+**  matriz_fija.c - Matrices pequenias de dimension fija pasadas por puntero
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <string.h>
+#include <math.h>
+#include <float.h>
+
+#include "matriz_fija.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+// Los nucleos se escriben una vez con la dimension como parametro y se fuerzan en linea
+// en cada funcion generada, donde la dimension es una constante
+#define NUCLEO_MATRIZ_FIJA         static inline __attribute__((always_inline))
+
+#define DEFINIR_MATRIZ_FIJA(n)                                                                                    \
+    void resetearMatriz ## n(matriz ## n ## _t *M)                                                                \
+        { memset(M, 0, sizeof(*M)); }                                                                             \
+    void identidadMatriz ## n(matriz ## n ## _t *M)                                                               \
+        { identidadMatrizFija(&M->m[0][0], n); }                                                                  \
+    void copiarMatriz ## n(const matriz ## n ## _t *A, matriz ## n ## _t *R)                                      \
+        { *R = *A; }                                                                                              \
+    void sumarMatrices ## n(const matriz ## n ## _t *A, const matriz ## n ## _t *B, matriz ## n ## _t *R)         \
+        { sumarMatricesFija(&A->m[0][0], 1.0f, &B->m[0][0], &R->m[0][0], n); }                                    \
+    void restarMatrices ## n(const matriz ## n ## _t *A, const matriz ## n ## _t *B, matriz ## n ## _t *R)        \
+        { sumarMatricesFija(&A->m[0][0], -1.0f, &B->m[0][0], &R->m[0][0], n); }                                   \
+    void escalarMatriz ## n(const matriz ## n ## _t *A, float k, matriz ## n ## _t *R)                            \
+        { escalarMatrizFija(&A->m[0][0], k, &R->m[0][0], n); }                                                    \
+    void multiplicarMatrices ## n(const matriz ## n ## _t *A, const matriz ## n ## _t *B, matriz ## n ## _t *R)   \
+        { multiplicarMatricesFija(&A->m[0][0], &B->m[0][0], &R->m[0][0], n); }                                    \
+    void multiplicarMatrizVector ## n(const matriz ## n ## _t *A, const float *x, float *y)                       \
+        { multiplicarMatrizVectorFija(&A->m[0][0], x, y, n); }                                                    \
+    void traspuestaMatriz ## n(matriz ## n ## _t *M)                                                              \
+        { traspuestaMatrizFija(&M->m[0][0], n); }                                                                 \
+    void completarSimetricaMatriz ## n(matriz ## n ## _t *M)                                                      \
+        { completarSimetricaMatrizFija(&M->m[0][0], n); }                                                         \
+    void rango1Matriz ## n(matriz ## n ## _t *M, float alfa, const float *v)                                      \
+        { rango1MatrizFija(&M->m[0][0], alfa, v, n); }                                                            \
+    bool factorizarCholeskyMatriz ## n(matriz ## n ## _t *M)                                                      \
+        { return factorizarCholeskyMatrizFija(&M->m[0][0], n); }                                                  \
+    void resolverCholeskyMatriz ## n(const matriz ## n ## _t *L, float *b)                                        \
+        { resolverCholeskyMatrizFija(&L->m[0][0], b, n); }                                                        \
+    bool factorizarLDLMatriz ## n(matriz ## n ## _t *M)                                                           \
+        { return factorizarLDLMatrizFija(&M->m[0][0], n); }                                                       \
+    void resolverLDLMatriz ## n(const matriz ## n ## _t *LD, float *b)                                            \
+        { resolverLDLMatrizFija(&LD->m[0][0], b, n); }                                                            \
+    void iniciarMinCuadrados ## n(minCuadrados ## n ## _t *mc)                                                    \
+        { memset(mc, 0, sizeof(*mc)); }                                                                           \
+    void anadirFilaMinCuadrados ## n(minCuadrados ## n ## _t *mc, const float *fila, float y)                     \
+        { mc->residuo2 += anadirFilaGivensFija(&mc->R.m[0][0], mc->qtb, fila, y, n); mc->filas++; }               \
+    bool resolverMinCuadrados ## n(const minCuadrados ## n ## _t *mc, float *x)                                   \
+        { return resolverTriangularFija(&mc->R.m[0][0], mc->qtb, x, n); }                                         \
+    bool resolverHouseholderMatriz ## n(float (*A)[n], float *b, uint16_t filas, float *x)                        \
+        { return resolverHouseholderMatrizFija(&A[0][0], b, filas, x, n); }
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA void identidadMatrizFija(float *m, uint8_t n);
+NUCLEO_MATRIZ_FIJA void sumarMatricesFija(const float *a, float signo, const float *b, float *r, uint8_t n);
+NUCLEO_MATRIZ_FIJA void escalarMatrizFija(const float *a, float k, float *r, uint8_t n);
+NUCLEO_MATRIZ_FIJA void multiplicarMatricesFija(const float *a, const float *b, float *r, uint8_t n);
+NUCLEO_MATRIZ_FIJA void multiplicarMatrizVectorFija(const float *a, const float *x, float *y, uint8_t n);
+NUCLEO_MATRIZ_FIJA void traspuestaMatrizFija(float *m, uint8_t n);
+NUCLEO_MATRIZ_FIJA void completarSimetricaMatrizFija(float *m, uint8_t n);
+NUCLEO_MATRIZ_FIJA void rango1MatrizFija(float *m, float alfa, const float *v, uint8_t n);
+NUCLEO_MATRIZ_FIJA bool factorizarCholeskyMatrizFija(float *m, uint8_t n);
+NUCLEO_MATRIZ_FIJA void resolverCholeskyMatrizFija(const float *l, float *b, uint8_t n);
+NUCLEO_MATRIZ_FIJA bool factorizarLDLMatrizFija(float *m, uint8_t n);
+NUCLEO_MATRIZ_FIJA void resolverLDLMatrizFija(const float *ld, float *b, uint8_t n);
+NUCLEO_MATRIZ_FIJA float anadirFilaGivensFija(float *r, float *qtb, const float *fila, float y, uint8_t n);
+NUCLEO_MATRIZ_FIJA bool resolverTriangularFija(const float *r, const float *qtb, float *x, uint8_t n);
+NUCLEO_MATRIZ_FIJA bool resolverHouseholderMatrizFija(float *a, float *b, uint16_t filas, float *x, uint8_t n);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+DEFINIR_MATRIZ_FIJA(3)
+DEFINIR_MATRIZ_FIJA(4)
+DEFINIR_MATRIZ_FIJA(6)
+DEFINIR_MATRIZ_FIJA(9)
+
+
+/***************************************************************************************
+**  Nombre:         void identidadMatrizFija(float *m, uint8_t n)
+**  Descripcion:    Asigna la identidad
+**  Parametros:     Matriz, dimension
+**  Retorno:        Ninguno
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA void identidadMatrizFija(float *m, uint8_t n)
+{
+    for (uint8_t i = 0; i < n; i++) {
+        for (uint8_t j = 0; j < n; j++)
+            m[i * n + j] = i == j ? 1.0f : 0.0f;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void sumarMatricesFija(const float *a, float signo, const float *b, float *r, uint8_t n)
+**  Descripcion:    Calcula A + signo * B. El resultado puede ser A o B
+**  Parametros:     Primera matriz, signo, segunda matriz, resultado, dimension
+**  Retorno:        Ninguno
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA void sumarMatricesFija(const float *a, float signo, const float *b, float *r, uint8_t n)
+{
+    for (uint8_t i = 0; i < n * n; i++)
+        r[i] = a[i] + signo * b[i];
+}
+
+
+/***************************************************************************************
+**  Nombre:         void escalarMatrizFija(const float *a, float k, float *r, uint8_t n)
+**  Descripcion:    Multiplica una matriz por un escalar. El resultado puede ser A
+**  Parametros:     Matriz, escalar, resultado, dimension
+**  Retorno:        Ninguno
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA void escalarMatrizFija(const float *a, float k, float *r, uint8_t n)
+{
+    for (uint8_t i = 0; i < n * n; i++)
+        r[i] = a[i] * k;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void multiplicarMatricesFija(const float *a, const float *b, float *r, uint8_t n)
+**  Descripcion:    Calcula A * B fila a fila. El resultado puede ser A pero no B
+**  Parametros:     Primera matriz, segunda matriz, resultado, dimension
+**  Retorno:        Ninguno
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA void multiplicarMatricesFija(const float *a, const float *b, float *r, uint8_t n)
+{
+    float fila[n];
+
+    // Orden i-k-j: la fila de B se recorre seguida y el bucle interior se vectoriza
+    for (uint8_t i = 0; i < n; i++) {
+        for (uint8_t j = 0; j < n; j++)
+            fila[j] = a[i * n] * b[j];
+
+        for (uint8_t k = 1; k < n; k++) {
+            const float aik = a[i * n + k];
+            for (uint8_t j = 0; j < n; j++)
+                fila[j] += aik * b[k * n + j];
+        }
+
+        memcpy(&r[i * n], fila, sizeof(fila));
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void multiplicarMatrizVectorFija(const float *a, const float *x, float *y, uint8_t n)
+**  Descripcion:    Calcula y = A * x. El resultado no puede ser x
+**  Parametros:     Matriz, vector, resultado, dimension
+**  Retorno:        Ninguno
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA void multiplicarMatrizVectorFija(const float *a, const float *x, float *y, uint8_t n)
+{
+    for (uint8_t i = 0; i < n; i++) {
+        float suma = 0.0f;
+        for (uint8_t k = 0; k < n; k++)
+            suma += a[i * n + k] * x[k];
+
+        y[i] = suma;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void traspuestaMatrizFija(float *m, uint8_t n)
+**  Descripcion:    Traspone en el sitio
+**  Parametros:     Matriz, dimension
+**  Retorno:        Ninguno
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA void traspuestaMatrizFija(float *m, uint8_t n)
+{
+    for (uint8_t i = 1; i < n; i++) {
+        for (uint8_t j = 0; j < i; j++) {
+            const float temp = m[i * n + j];
+            m[i * n + j] = m[j * n + i];
+            m[j * n + i] = temp;
+        }
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void completarSimetricaMatrizFija(float *m, uint8_t n)
+**  Descripcion:    Copia el triangulo inferior en el superior
+**  Parametros:     Matriz, dimension
+**  Retorno:        Ninguno
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA void completarSimetricaMatrizFija(float *m, uint8_t n)
+{
+    for (uint8_t i = 1; i < n; i++) {
+        for (uint8_t j = 0; j < i; j++)
+            m[j * n + i] = m[i * n + j];
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void rango1MatrizFija(float *m, float alfa, const float *v, uint8_t n)
+**  Descripcion:    Suma alfa * v * v' al triangulo inferior. Sirve para acumular J'J
+**  Parametros:     Matriz, escalar, vector, dimension
+**  Retorno:        Ninguno
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA void rango1MatrizFija(float *m, float alfa, const float *v, uint8_t n)
+{
+    for (uint8_t i = 0; i < n; i++) {
+        const float av = alfa * v[i];
+
+        for (uint8_t j = 0; j <= i; j++)
+            m[i * n + j] += av * v[j];
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool factorizarCholeskyMatrizFija(float *m, uint8_t n)
+**  Descripcion:    Factoriza M = L * L' con M simetrica definida positiva. Solo usa el
+**                  triangulo inferior, que se sobreescribe con L
+**  Parametros:     Matriz, dimension
+**  Retorno:        False si M no es definida positiva
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA bool factorizarCholeskyMatrizFija(float *m, uint8_t n)
+{
+    for (uint8_t j = 0; j < n; j++) {
+        float diagonal = m[j * n + j];
+        for (uint8_t k = 0; k < j; k++)
+            diagonal -= m[j * n + k] * m[j * n + k];
+
+        // Tambien descarta los NaN
+        if (!(diagonal > 0.0f))
+            return false;
+
+        const float raiz = sqrtf(diagonal);
+        const float inversa = 1.0f / raiz;
+        m[j * n + j] = raiz;
+
+        for (uint8_t i = j + 1; i < n; i++) {
+            float suma = m[i * n + j];
+            for (uint8_t k = 0; k < j; k++)
+                suma -= m[i * n + k] * m[j * n + k];
+
+            m[i * n + j] = suma * inversa;
+        }
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void resolverCholeskyMatrizFija(const float *l, float *b, uint8_t n)
+**  Descripcion:    Resuelve L * L' * x = b con el factor de factorizarCholeskyMatrizFija
+**  Parametros:     Factor L, termino independiente que se sobreescribe con x, dimension
+**  Retorno:        Ninguno
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA void resolverCholeskyMatrizFija(const float *l, float *b, uint8_t n)
+{
+    // L * y = b
+    for (uint8_t i = 0; i < n; i++) {
+        for (uint8_t k = 0; k < i; k++)
+            b[i] -= l[i * n + k] * b[k];
+
+        b[i] /= l[i * n + i];
+    }
+
+    // L' * x = y
+    for (int8_t i = n - 1; i >= 0; i--) {
+        for (uint8_t k = i + 1; k < n; k++)
+            b[i] -= l[k * n + i] * b[k];
+
+        b[i] /= l[i * n + i];
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool factorizarLDLMatrizFija(float *m, uint8_t n)
+**  Descripcion:    Factoriza M = L * D * L' con M simetrica, sin raices. Vale para
+**                  matrices indefinidas si ningun menor principal es nulo. Solo usa el
+**                  triangulo inferior: debajo de la diagonal queda L (diagonal unidad) y
+**                  en la diagonal queda D
+**  Parametros:     Matriz, dimension
+**  Retorno:        False si algun pivote es nulo o no finito
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA bool factorizarLDLMatrizFija(float *m, uint8_t n)
+{
+    float ld[n];
+
+    for (uint8_t j = 0; j < n; j++) {
+        float d = m[j * n + j];
+
+        // ld[k] = L(j,k) * D(k)
+        for (uint8_t k = 0; k < j; k++) {
+            ld[k] = m[j * n + k] * m[k * n + k];
+            d -= m[j * n + k] * ld[k];
+        }
+
+        if (!isfinite(d) || fabsf(d) < FLT_MIN)
+            return false;
+
+        m[j * n + j] = d;
+        const float inversa = 1.0f / d;
+
+        for (uint8_t i = j + 1; i < n; i++) {
+            float suma = m[i * n + j];
+            for (uint8_t k = 0; k < j; k++)
+                suma -= m[i * n + k] * ld[k];
+
+            m[i * n + j] = suma * inversa;
+        }
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void resolverLDLMatrizFija(const float *ld, float *b, uint8_t n)
+**  Descripcion:    Resuelve L * D * L' * x = b con el resultado de factorizarLDLMatrizFija
+**  Parametros:     Factores, termino independiente que se sobreescribe con x, dimension
+**  Retorno:        Ninguno
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA void resolverLDLMatrizFija(const float *ld, float *b, uint8_t n)
+{
+    // L * z = b
+    for (uint8_t i = 1; i < n; i++) {
+        for (uint8_t k = 0; k < i; k++)
+            b[i] -= ld[i * n + k] * b[k];
+    }
+
+    // D * y = z
+    for (uint8_t i = 0; i < n; i++)
+        b[i] /= ld[i * n + i];
+
+    // L' * x = y
+    for (int8_t i = n - 2; i >= 0; i--) {
+        for (uint8_t k = i + 1; k < n; k++)
+            b[i] -= ld[k * n + i] * b[k];
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         float anadirFilaGivensFija(float *r, float *qtb, const float *fila, float y, uint8_t n)
+**  Descripcion:    Incorpora la ecuacion fila * x = y a la R triangular superior con
+**                  rotaciones de Givens, una por columna no nula de la fila
+**  Parametros:     R, Q' * y, fila, termino independiente, dimension
+**  Retorno:        Residuo al cuadrado que deja la fila
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA float anadirFilaGivensFija(float *r, float *qtb, const float *fila, float y, uint8_t n)
+{
+    float a[n];
+
+    memcpy(a, fila, sizeof(a));
+
+    for (uint8_t k = 0; k < n; k++) {
+        if (a[k] == 0.0f)
+            continue;
+
+        const float rkk = r[k * n + k];
+        const float h = sqrtf(rkk * rkk + a[k] * a[k]);
+        const float c = rkk / h;
+        const float s = a[k] / h;
+
+        r[k * n + k] = h;
+
+        for (uint8_t j = k + 1; j < n; j++) {
+            const float rkj = r[k * n + j];
+            r[k * n + j] = c * rkj + s * a[j];
+            a[j] = c * a[j] - s * rkj;
+        }
+
+        const float qk = qtb[k];
+        qtb[k] = c * qk + s * y;
+        y = c * y - s * qk;
+    }
+
+    return y * y;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool resolverTriangularFija(const float *r, const float *qtb, float *x, uint8_t n)
+**  Descripcion:    Resuelve R * x = Q' * y por sustitucion hacia atras
+**  Parametros:     R triangular superior, Q' * y, solucion, dimension
+**  Retorno:        False si R es singular (rango incompleto)
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA bool resolverTriangularFija(const float *r, const float *qtb, float *x, uint8_t n)
+{
+    float maxDiagonal = 0.0f;
+
+    for (uint8_t i = 0; i < n; i++) {
+        const float diagonal = fabsf(r[i * n + i]);
+        if (diagonal > maxDiagonal)
+            maxDiagonal = diagonal;
+    }
+
+    if (!(maxDiagonal > 0.0f))
+        return false;
+
+    // Pivotes relativos por debajo del redondeo indican columnas dependientes
+    const float umbral = n * FLT_EPSILON * maxDiagonal;
+
+    for (int8_t i = n - 1; i >= 0; i--) {
+        const float diagonal = r[i * n + i];
+        float suma = qtb[i];
+
+        if (!(fabsf(diagonal) > umbral))
+            return false;
+
+        for (uint8_t k = i + 1; k < n; k++)
+            suma -= r[i * n + k] * x[k];
+
+        x[i] = suma / diagonal;
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool resolverHouseholderMatrizFija(float *a, float *b, uint16_t filas, float *x, uint8_t n)
+**  Descripcion:    Minimos cuadrados de A * x = b (filas x n) con reflexiones de
+**                  Householder. A y b se sobreescriben: en A queda R arriba y en b queda
+**                  Q' * b, cuyas ultimas filas - n componentes son el residuo
+**  Parametros:     Matriz, termino independiente, numero de filas, solucion, dimension
+**  Retorno:        False si hay menos filas que incognitas o A no tiene rango completo
+****************************************************************************************/
+NUCLEO_MATRIZ_FIJA bool resolverHouseholderMatrizFija(float *a, float *b, uint16_t filas, float *x, uint8_t n)
+{
+    if (filas < n)
+        return false;
+
+    for (uint8_t k = 0; k < n; k++) {
+        float norma2 = 0.0f;
+        for (uint16_t i = k; i < filas; i++)
+            norma2 += a[i * n + k] * a[i * n + k];
+
+        if (!(norma2 > 0.0f))
+            return false;
+
+        // v = columna + signo * norma * e_k, con el signo que evita la cancelacion
+        const float akk = a[k * n + k];
+        const float norma = sqrtf(norma2);
+        const float rkk = akk >= 0.0f ? -norma : norma;
+        const float tau = 1.0f / (norma * (norma + fabsf(akk)));
+
+        a[k * n + k] = akk - rkk;
+
+        for (uint8_t j = k + 1; j < n; j++) {
+            float suma = 0.0f;
+            for (uint16_t i = k; i < filas; i++)
+                suma += a[i * n + k] * a[i * n + j];
+
+            suma *= tau;
+            for (uint16_t i = k; i < filas; i++)
+                a[i * n + j] -= suma * a[i * n + k];
+        }
+
+        float suma = 0.0f;
+        for (uint16_t i = k; i < filas; i++)
+            suma += a[i * n + k] * b[i];
+
+        suma *= tau;
+        for (uint16_t i = k; i < filas; i++)
+            b[i] -= suma * a[i * n + k];
+
+        a[k * n + k] = rkk;
+    }
+
+    return resolverTriangularFija(a, b, x, n);
+}
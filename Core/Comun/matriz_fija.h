@@ -0,0 +1,99 @@
+/***************************************************************************************
+**  matriz_fija.h - Matrices pequenias de dimension fija pasadas por puntero
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __MATRIZ_FIJA_H
+#define __MATRIZ_FIJA_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Matrices cuadradas de dimension fija generadas con macros para 3, 4, 6 y 9. A
+ * diferencia de matriz_t (10x10 por valor) se pasan por puntero, ocupan solo lo que
+ * necesitan y el compilador conoce la dimension, por lo que desenrolla los bucles. Las
+ * funciones llevan la dimension al final del nombre: factorizarCholeskyMatriz9, etc.
+ *
+ * Las factorizaciones son en el sitio y solo usan el triangulo inferior. Para minimos
+ * cuadrados hay dos opciones: Givens fila a fila sobre R triangular (minCuadradosN_t),
+ * que no necesita guardar las filas, y Householder sobre un bloque de filas ya guardado
+ */
+#define DECLARAR_MATRIZ_FIJA(n)                                                                             \
+    typedef struct {                                                                                        \
+        float m[n][n];                                                                                      \
+    } matriz ## n ## _t;                                                                                    \
+                                                                                                            \
+    typedef struct {                                                                                        \
+        matriz ## n ## _t R;              /* Triangular superior */                                        \
+        float qtb[n];                     /* Q' * y */                                                     \
+        float residuo2;                   /* Suma de residuos al cuadrado */                               \
+        uint16_t filas;                                                                                     \
+    } minCuadrados ## n ## _t;                                                                              \
+                                                                                                            \
+    void resetearMatriz ## n(matriz ## n ## _t *M);                                                         \
+    void identidadMatriz ## n(matriz ## n ## _t *M);                                                        \
+    void copiarMatriz ## n(const matriz ## n ## _t *A, matriz ## n ## _t *R);                               \
+    void sumarMatrices ## n(const matriz ## n ## _t *A, const matriz ## n ## _t *B, matriz ## n ## _t *R);  \
+    void restarMatrices ## n(const matriz ## n ## _t *A, const matriz ## n ## _t *B, matriz ## n ## _t *R); \
+    void escalarMatriz ## n(const matriz ## n ## _t *A, float k, matriz ## n ## _t *R);                     \
+    void multiplicarMatrices ## n(const matriz ## n ## _t *A, const matriz ## n ## _t *B, matriz ## n ## _t *R); \
+    void multiplicarMatrizVector ## n(const matriz ## n ## _t *A, const float *x, float *y);                \
+    void traspuestaMatriz ## n(matriz ## n ## _t *M);                                                       \
+    void completarSimetricaMatriz ## n(matriz ## n ## _t *M);                                               \
+    void rango1Matriz ## n(matriz ## n ## _t *M, float alfa, const float *v);                               \
+    bool factorizarCholeskyMatriz ## n(matriz ## n ## _t *M);                                               \
+    void resolverCholeskyMatriz ## n(const matriz ## n ## _t *L, float *b);                                 \
+    bool factorizarLDLMatriz ## n(matriz ## n ## _t *M);                                                    \
+    void resolverLDLMatriz ## n(const matriz ## n ## _t *LD, float *b);                                     \
+    void iniciarMinCuadrados ## n(minCuadrados ## n ## _t *mc);                                             \
+    void anadirFilaMinCuadrados ## n(minCuadrados ## n ## _t *mc, const float *fila, float y);              \
+    bool resolverMinCuadrados ## n(const minCuadrados ## n ## _t *mc, float *x);                            \
+    bool resolverHouseholderMatriz ## n(float (*A)[n], float *b, uint16_t filas, float *x);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+DECLARAR_MATRIZ_FIJA(3)
+DECLARAR_MATRIZ_FIJA(4)
+DECLARAR_MATRIZ_FIJA(6)
+DECLARAR_MATRIZ_FIJA(9)
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+
+#endif // __MATRIZ_FIJA_H
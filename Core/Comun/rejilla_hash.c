@@ -0,0 +1,214 @@
+/***************************************************************************************
+**  rejilla_hash.c - Indice espacial de puntos 3D en una rejilla con tabla hash
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <math.h>
+
+#include "rejilla_hash.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+// La celda es un poco mayor que la distancia para que el redondeo no deje vecinos a dos celdas
+#define MARGEN_CELDA_REJILLA_HASH       0.999f
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void celdaRejillaHash(const rejillaHash_t *rejilla, const float *punto, int32_t *celda);
+uint16_t cubetaRejillaHash(const rejillaHash_t *rejilla, int32_t x, int32_t y, int32_t z);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool iniciarRejillaHash(rejillaHash_t *rejilla, const float (*puntos)[3],
+**                                          uint16_t maxPuntos, uint16_t *siguientes,
+**                                          uint16_t *cabezas, uint16_t numCubetas)
+**  Descripcion:    Inicia la rejilla sobre el array de puntos del usuario
+**  Parametros:     Rejilla, puntos, tamanio del array de puntos, enlaces (uno por punto),
+**                  cubetas, numero de cubetas (potencia de 2)
+**  Retorno:        True si ok
+****************************************************************************************/
+bool iniciarRejillaHash(rejillaHash_t *rejilla, const float (*puntos)[3], uint16_t maxPuntos, uint16_t *siguientes,
+                        uint16_t *cabezas, uint16_t numCubetas)
+{
+    if (numCubetas == 0 || (numCubetas & (numCubetas - 1)) != 0 || maxPuntos == NINGUNO_REJILLA_HASH)
+        return false;
+
+    rejilla->puntos = puntos;
+    rejilla->maxPuntos = maxPuntos;
+    rejilla->siguientes = siguientes;
+    rejilla->cabezas = cabezas;
+    rejilla->mascaraCubetas = numCubetas - 1;
+
+    vaciarRejillaHash(rejilla, 1.0f);
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void vaciarRejillaHash(rejillaHash_t *rejilla, float distanciaMin)
+**  Descripcion:    Quita todos los puntos y ajusta la distancia minima, que fija el
+**                  tamanio de la celda
+**  Parametros:     Rejilla, distancia minima entre puntos
+**  Retorno:        Ninguno
+****************************************************************************************/
+void vaciarRejillaHash(rejillaHash_t *rejilla, float distanciaMin)
+{
+    if (!(distanciaMin > 0.0f))
+        distanciaMin = 1.0f;
+
+    rejilla->inversaCelda = MARGEN_CELDA_REJILLA_HASH / distanciaMin;
+    rejilla->distanciaMin2 = distanciaMin * distanciaMin;
+
+    for (uint32_t i = 0; i <= rejilla->mascaraCubetas; i++)
+        rejilla->cabezas[i] = NINGUNO_REJILLA_HASH;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void insertarRejillaHash(rejillaHash_t *rejilla, uint16_t indice)
+**  Descripcion:    Anade un punto del array. No puede estar ya en la rejilla
+**  Parametros:     Rejilla, indice del punto
+**  Retorno:        Ninguno
+****************************************************************************************/
+void insertarRejillaHash(rejillaHash_t *rejilla, uint16_t indice)
+{
+    int32_t celda[3];
+
+    if (indice >= rejilla->maxPuntos)
+        return;
+
+    celdaRejillaHash(rejilla, rejilla->puntos[indice], celda);
+    const uint16_t cubeta = cubetaRejillaHash(rejilla, celda[0], celda[1], celda[2]);
+
+    rejilla->siguientes[indice] = rejilla->cabezas[cubeta];
+    rejilla->cabezas[cubeta] = indice;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void quitarRejillaHash(rejillaHash_t *rejilla, uint16_t indice)
+**  Descripcion:    Quita un punto. Sus coordenadas tienen que ser las de cuando se inserto
+**  Parametros:     Rejilla, indice del punto
+**  Retorno:        Ninguno
+****************************************************************************************/
+void quitarRejillaHash(rejillaHash_t *rejilla, uint16_t indice)
+{
+    int32_t celda[3];
+
+    if (indice >= rejilla->maxPuntos)
+        return;
+
+    celdaRejillaHash(rejilla, rejilla->puntos[indice], celda);
+    uint16_t *enlace = &rejilla->cabezas[cubetaRejillaHash(rejilla, celda[0], celda[1], celda[2])];
+
+    while (*enlace != NINGUNO_REJILLA_HASH) {
+        if (*enlace == indice) {
+            *enlace = rejilla->siguientes[indice];
+            return;
+        }
+
+        enlace = &rejilla->siguientes[*enlace];
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool hayVecinoRejillaHash(const rejillaHash_t *rejilla, const float *punto,
+**                                            uint16_t indiceIgnorado)
+**  Descripcion:    Comprueba si algun punto de la rejilla esta a menos de la distancia
+**                  minima. Solo se miran la celda del punto y las de alrededor
+**  Parametros:     Rejilla, punto, indice a ignorar (NINGUNO_REJILLA_HASH para ninguno)
+**  Retorno:        True si hay algun punto demasiado cerca
+****************************************************************************************/
+bool hayVecinoRejillaHash(const rejillaHash_t *rejilla, const float *punto, uint16_t indiceIgnorado)
+{
+    int32_t celda[3];
+
+    celdaRejillaHash(rejilla, punto, celda);
+
+    for (int32_t x = celda[0] - 1; x <= celda[0] + 1; x++) {
+        for (int32_t y = celda[1] - 1; y <= celda[1] + 1; y++) {
+            for (int32_t z = celda[2] - 1; z <= celda[2] + 1; z++) {
+                uint16_t i = rejilla->cabezas[cubetaRejillaHash(rejilla, x, y, z)];
+
+                for (; i != NINGUNO_REJILLA_HASH; i = rejilla->siguientes[i]) {
+                    const float dx = punto[0] - rejilla->puntos[i][0];
+                    const float dy = punto[1] - rejilla->puntos[i][1];
+                    const float dz = punto[2] - rejilla->puntos[i][2];
+
+                    if (i != indiceIgnorado && dx * dx + dy * dy + dz * dz < rejilla->distanciaMin2)
+                        return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void celdaRejillaHash(const rejillaHash_t *rejilla, const float *punto, int32_t *celda)
+**  Descripcion:    Calcula la celda de un punto
+**  Parametros:     Rejilla, punto, celda
+**  Retorno:        Ninguno
+****************************************************************************************/
+void celdaRejillaHash(const rejillaHash_t *rejilla, const float *punto, int32_t *celda)
+{
+    for (uint8_t i = 0; i < 3; i++)
+        celda[i] = (int32_t)floorf(punto[i] * rejilla->inversaCelda);
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t cubetaRejillaHash(const rejillaHash_t *rejilla, int32_t x, int32_t y, int32_t z)
+**  Descripcion:    Lleva una celda a su cubeta mezclando las coordenadas con primos grandes
+**  Parametros:     Rejilla, celda
+**  Retorno:        Cubeta
+****************************************************************************************/
+uint16_t cubetaRejillaHash(const rejillaHash_t *rejilla, int32_t x, int32_t y, int32_t z)
+{
+    const uint32_t hash = ((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u) ^ ((uint32_t)z * 83492791u);
+
+    return (hash ^ (hash >> 16)) & rejilla->mascaraCubetas;
+}
@@ -0,0 +1,81 @@
+/***************************************************************************************
+**  rejilla_hash.h - Indice espacial de puntos 3D en una rejilla con tabla hash
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __REJILLA_HASH_H
+#define __REJILLA_HASH_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Responde si hay algun punto a menos de una distancia minima sin recorrer todos. El
+ * espacio se divide en celdas cubicas del lado de esa distancia, asi que los vecinos de un
+ * punto solo pueden estar en su celda o en las 26 de alrededor. Cada celda se lleva a una
+ * cubeta de una tabla hash de tamanio fijo y los puntos de la misma cubeta forman una
+ * lista enlazada por indices. Los puntos no se copian: la rejilla guarda indices del array
+ * del usuario, que tiene que avisar al insertar y al quitar. Las colisiones de cubeta solo
+ * anaden candidatos, porque la distancia siempre se comprueba
+ */
+#define NINGUNO_REJILLA_HASH            UINT16_MAX
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    const float (*puntos)[3];
+    uint16_t *cabezas;                    // Primer punto de cada cubeta
+    uint16_t *siguientes;                 // Siguiente punto de la misma cubeta
+    uint16_t mascaraCubetas;
+    uint16_t maxPuntos;
+    float inversaCelda;
+    float distanciaMin2;
+} rejillaHash_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool iniciarRejillaHash(rejillaHash_t *rejilla, const float (*puntos)[3], uint16_t maxPuntos, uint16_t *siguientes,
+                        uint16_t *cabezas, uint16_t numCubetas);
+void vaciarRejillaHash(rejillaHash_t *rejilla, float distanciaMin);
+void insertarRejillaHash(rejillaHash_t *rejilla, uint16_t indice);
+void quitarRejillaHash(rejillaHash_t *rejilla, uint16_t indice);
+bool hayVecinoRejillaHash(const rejillaHash_t *rejilla, const float *punto, uint16_t indiceIgnorado);
+
+#endif // __REJILLA_HASH_H
@@ -50,6 +50,7 @@
 #include "AHRS/ahrs.h"
 #include "FC/mixer.h"
 #include "Drivers/usb.h"
+#include "Telemetria/telemetria.h"
 
 
 /***************************************************************************************
@@ -93,12 +94,17 @@ void iniciarPlaca(void)
 
 
     // Configuracion -------------------------------------------------------------
+#if defined(SITL)
+    // En SITL no hay flash. Se parte siempre de la configuracion por defecto
+    resetearTodosGP();
+#else
     // Se inicia la configuracion de la flash
     iniciarConfigFlash();
 
     bool estado = cargarConfigFlash();
     if (!estado || !versionValidaConfigFlash() || strncasecmp(configSistema()->identificadorPlaca, NOMBRE_PLACA, sizeof(NOMBRE_PLACA)))
     	resetearConfigFlash();
+#endif
 
     estadoSistema |= ESTADO_SIS_CONFIG_CARGADA;
 
@@ -182,6 +188,9 @@ void iniciarPlaca(void)
     iniciarAHRS();
     iniciarFC();
     iniciarMixer();
+#ifdef USAR_TELEMETRIA
+    iniciarTelemetria();
+#endif
 
 
     // Scheduler ---------------------------------------------------------------
@@ -25,10 +25,13 @@
 /***************************************************************************************
 ** AREA DE INCLUDES                                                                   **
 ****************************************************************************************/
-#include "sistema/plataforma.h"
+#include "Sistema/plataforma.h"
 #include "inicializacion.h"
 #include "Scheduler/scheduler.h"
 
+// En SITL el punto de entrada esta en SITL/main_sitl.c
+#if !defined(SITL)
+
 
 /***************************************************************************************
 ** AREA DE PREPROCESADOR                                                              **
@@ -80,3 +83,5 @@ void run(void)
     while (1)
         scheduler();
 }
+
+#endif
@@ -42,8 +42,10 @@
 /***************************************************************************************
 ** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
+#if !defined(SITL)
 extern char _estack;            // Fin del stack declarado en el linker
 extern char _Min_Stack_Size;    // Declarado en el linker
+#endif
 static uint32_t stackUsado;
 
 
@@ -72,6 +74,7 @@ void chequearStack(uint32_t tiempoActual)
 {
     UNUSED(tiempoActual);
 
+#if !defined(SITL)
     char * const memAlta = &_estack;
     const uint32_t tam = (uint32_t)&_Min_Stack_Size;
     char * const memBaja = memAlta - tam;
@@ -84,6 +87,7 @@ void chequearStack(uint32_t tiempoActual)
     }
 
     stackUsado = (uint32_t)memAlta - (uint32_t)p;
+#endif
 }
 
 
@@ -107,6 +111,10 @@ uint32_t tamUsadoStack(void)
 ****************************************************************************************/
 uint32_t tamanioStack(void)
 {
+#if defined(SITL)
+    return 0;       // En SITL el stack lo gestiona el sistema operativo
+#else
     return (uint32_t)(intptr_t)&_Min_Stack_Size;
+#endif
 }
 
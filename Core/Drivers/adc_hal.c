@@ -178,6 +178,9 @@ bool iniciarDriverADC(numADC_e numADC)
             return false;
     }
 
+    if (!reservarDMA(identificadorDMA(driver->hal.hdma.Instance), DMA_ADC, numADC))
+        return false;
+
     iniciarDMA(identificadorDMA(driver->hal.hdma.Instance));
 
     driver->hal.hdma.Init.Direction = DMA_PERIPH_TO_MEMORY;
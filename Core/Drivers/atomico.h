@@ -41,8 +41,13 @@
  * La barrera de memoria se situa en el inicio y el fin. Se utiliza __unused__ attribute
  * para que no salte el CLang warning
  */
+#if defined(SITL)
+// En SITL no hay interrupciones. El bloque se ejecuta una vez sin tocar el BASEPRI
+#define BLOQUE_ATOMICO(prio) for ( uint8_t __ToDo = ((void)(prio), 1); __ToDo ; __ToDo = 0 )
+#else
 #define BLOQUE_ATOMICO(prio) for ( uint8_t __basepri_save __attribute__ ((__cleanup__ (restaurarBasepriMem), __unused__)) = __get_BASEPRI(), \
                                   __ToDo = ajustarBasepriMax(prio); __ToDo ; __ToDo = 0 )
+#endif
 
 
 /***************************************************************************************
@@ -63,6 +68,7 @@
 /***************************************************************************************
 ** AREA DE DEFINICION DE FUNCIONES                                                    **
 ****************************************************************************************/
+#if !defined(SITL)
 /*
  * Funciones de manipulacion del BASEPRI
  * Las librerias solo implementan set_BASEPRI. El resto de funciones se tienen que
@@ -92,6 +98,6 @@ static inline uint8_t ajustarBasepriMax(uint8_t prio)
     __set_BASEPRI_MAX(prio);
     return 1;
 }
-
+#endif
 
 #endif // __ATOMICO_H
@@ -30,6 +30,9 @@
 #if defined(USAR_SPI) || defined(USAR_I2C)
 #include "spi_bus.h"
 #include "i2c_bus.h"
+#if defined(USAR_SPI) && defined(USAR_COLA_SPI)
+#include "cola_spi.h"
+#endif
 
 
 /***************************************************************************************
@@ -50,6 +53,7 @@
 /***************************************************************************************
 ** AREA DE PROTOTIPOS DE FUNCION                                                      **
 ****************************************************************************************/
+bool esperarColaBus(const bus_t *bus);
 
 
 /***************************************************************************************
@@ -144,6 +148,9 @@ CODIGO_RAPIDO bool escribirBufferRegistroBus(const bus_t *bus, uint8_t reg, uint
     UNUSED(datoTx);
     UNUSED(longitud);
 #endif
+    if (!esperarColaBus(bus))
+        return false;
+
     if (busOcupado(bus))
         return false;
 
@@ -196,6 +203,9 @@ CODIGO_RAPIDO bool leerBufferRegistroBus(const bus_t *bus, uint8_t reg, uint8_t
     UNUSED(longitud);
 #endif
 
+    if (!esperarColaBus(bus))
+        return false;
+
     if (busOcupado(bus))
         return false;
 
@@ -215,4 +225,44 @@ CODIGO_RAPIDO bool leerBufferRegistroBus(const bus_t *bus, uint8_t reg, uint8_t
     }
 }
 
+
+/***************************************************************************************
+**  Nombre:         bool encolarTransaccionBus(transaccionBus_t *transaccion)
+**  Descripcion:    Encola una transaccion asincrona. Solo el SPI tiene cola, con el I2C
+**                  se retorna false y el driver debe usar las funciones bloqueantes
+**  Parametros:     Transaccion
+**  Retorno:        True si se ha encolado
+****************************************************************************************/
+CODIGO_RAPIDO bool encolarTransaccionBus(transaccionBus_t *transaccion)
+{
+    switch (transaccion->bus->tipo) {
+#if defined(USAR_SPI) && defined(USAR_COLA_SPI)
+        case BUS_SPI:
+            return encolarTransaccionSPI(transaccion);
+#endif
+        default:
+            return false;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool esperarColaBus(const bus_t *bus)
+**  Descripcion:    Las operaciones bloqueantes esperan a que el puerto vacie su cola de
+**                  transacciones para no mezclarse con las del DMA
+**  Parametros:     Bus
+**  Retorno:        True si el puerto esta libre
+****************************************************************************************/
+CODIGO_RAPIDO bool esperarColaBus(const bus_t *bus)
+{
+#if defined(USAR_SPI) && defined(USAR_COLA_SPI)
+    if (bus->tipo == BUS_SPI)
+        return esperarColaSPI(bus->bus_u.spi.numSPI, TIMEOUT_COLA_SPI);
+#else
+    UNUSED(bus);
+#endif
+
+    return true;
+}
+
 #endif
@@ -64,6 +64,36 @@ typedef struct {
     } bus_u;
 } bus_t;
 
+typedef enum {
+    TRANSACCION_BUS_LIBRE = 0,
+    TRANSACCION_BUS_PENDIENTE,
+    TRANSACCION_BUS_EN_CURSO,
+    TRANSACCION_BUS_COMPLETADA,
+    TRANSACCION_BUS_ERROR,
+} estadoTransaccionBus_e;
+
+typedef struct {
+    uint8_t *datoTx;                       // NULL si solo se lee
+    uint8_t *datoRx;                       // NULL si solo se escribe
+    uint16_t longitud;
+    bool liberarCS;                        // Sube el CS al terminar aunque queden segmentos
+} segmentoBus_t;
+
+struct transaccionBus_s;
+typedef void (*callbackTransaccionBus)(struct transaccionBus_s *transaccion, bool ok);
+
+typedef struct transaccionBus_s {
+    const bus_t *bus;
+    segmentoBus_t *segmentos;
+    uint8_t numSegmentos;
+    callbackTransaccionBus callback;       // Se llama desde la interrupcion al terminar
+    void *datoCallback;
+    volatile estadoTransaccionBus_e estado;
+    uint8_t segmentoActual;
+    uint32_t tiempoEncolado;
+    struct transaccionBus_s *siguiente;
+} transaccionBus_t;
+
 
 /***************************************************************************************
 ** AREA DE DECLARACION DE VARIABLES                                                   **
@@ -79,5 +109,6 @@ bool escribirRegistroBus(const bus_t *bus, uint8_t reg, uint8_t byteTx);
 bool escribirBufferRegistroBus(const bus_t *bus, uint8_t reg, uint8_t *datoTx, uint8_t longitud);
 bool leerRegistroBus(const bus_t *bus, uint8_t reg, uint8_t *byteRx);
 bool leerBufferRegistroBus(const bus_t *bus, uint8_t reg, uint8_t *datoRx, uint8_t longitud);
+bool encolarTransaccionBus(transaccionBus_t *transaccion);
 
 #endif // __BUS_H
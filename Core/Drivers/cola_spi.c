@@ -0,0 +1,301 @@
+/***************************************************************************************
+**  cola_spi.c - Cola de transacciones asincronas de los puertos SPI
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <string.h>
+
+#include "cola_spi.h"
+
+#if defined(USAR_SPI) && defined(USAR_COLA_SPI)
+#include "io.h"
+#include "nvic.h"
+#include "atomico.h"
+#include "tiempo.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    transaccionBus_t *primera;             // Transaccion en curso
+    transaccionBus_t *ultima;
+    volatile bool activa;                  // Hay una transaccion en curso o en su callback
+    bool csBajo;
+    volatile bool enArranque;              // Se esta lanzando un segmento
+    volatile bool finPendiente;            // El segmento ha terminado antes de salir del arranque
+    volatile bool okPendiente;
+    estadisticasColaSPI_t estadisticas;
+} colaSPI_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static colaSPI_t colaSPI[NUM_MAX_SPI];
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void avanzarColaSPI(numSPI_e numSPI);
+bool completarSegmentoColaSPI(numSPI_e numSPI, bool ok);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         void iniciarColaSPI(numSPI_e numSPI)
+**  Descripcion:    Vacia la cola del puerto
+**  Parametros:     Dispositivo
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarColaSPI(numSPI_e numSPI)
+{
+    memset(&colaSPI[numSPI], 0, sizeof(colaSPI[numSPI]));
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool encolarTransaccionSPI(transaccionBus_t *transaccion)
+**  Descripcion:    Anade una transaccion al final de la cola de su puerto y la lanza si
+**                  el puerto esta libre. Se puede llamar desde el callback de otra
+**                  transaccion del mismo puerto
+**  Parametros:     Transaccion
+**  Retorno:        True si se ha encolado
+****************************************************************************************/
+CODIGO_RAPIDO bool encolarTransaccionSPI(transaccionBus_t *transaccion)
+{
+    if (transaccion == NULL || transaccion->bus == NULL || transaccion->bus->tipo != BUS_SPI ||
+        transaccion->segmentos == NULL || transaccion->numSegmentos == 0)
+        return false;
+
+    if (transaccion->estado == TRANSACCION_BUS_PENDIENTE || transaccion->estado == TRANSACCION_BUS_EN_CURSO)
+        return false;
+
+    const numSPI_e numSPI = transaccion->bus->bus_u.spi.numSPI;
+    if (numSPI < SPI_1 || numSPI >= NUM_MAX_SPI)
+        return false;
+
+    colaSPI_t *cola = &colaSPI[numSPI];
+    bool arrancar = false;
+
+    transaccion->estado = TRANSACCION_BUS_PENDIENTE;
+    transaccion->segmentoActual = 0;
+    transaccion->siguiente = NULL;
+    transaccion->tiempoEncolado = microsISR();
+
+    BLOQUE_ATOMICO(NVIC_PRIO_SPI_DMA) {
+        if (cola->ultima == NULL)
+            cola->primera = transaccion;
+        else
+            cola->ultima->siguiente = transaccion;
+
+        cola->ultima = transaccion;
+
+        if (!cola->activa) {
+            cola->activa = true;
+            arrancar = true;
+        }
+    }
+
+    if (arrancar)
+        avanzarColaSPI(numSPI);
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void avanzarColaSPI(numSPI_e numSPI)
+**  Descripcion:    Lanza el segmento actual de la primera transaccion. Si el segmento
+**                  termina durante el arranque (puerto sin DMA) se procesa aqui en bucle
+**                  para no anidar llamadas
+**  Parametros:     Dispositivo
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void avanzarColaSPI(numSPI_e numSPI)
+{
+    colaSPI_t *cola = &colaSPI[numSPI];
+    bool terminado, ok;
+
+    do {
+        transaccionBus_t *transaccion = cola->primera;
+        const segmentoBus_t *segmento = &transaccion->segmentos[transaccion->segmentoActual];
+
+        transaccion->estado = TRANSACCION_BUS_EN_CURSO;
+        if (!cola->csBajo) {
+            escribirIO(transaccion->bus->bus_u.spi.pinCS, false);
+            cola->csBajo = true;
+        }
+
+        cola->enArranque = true;
+        const bool lanzado = transferirBufferAsincronoSPI(numSPI, segmento->datoTx, segmento->datoRx, segmento->longitud);
+
+        BLOQUE_ATOMICO(NVIC_PRIO_SPI_DMA) {
+            cola->enArranque = false;
+            terminado = !lanzado || cola->finPendiente;
+            ok = lanzado && cola->okPendiente;
+            cola->finPendiente = false;
+        }
+
+        // El final del segmento lo procesara la interrupcion
+        if (!terminado)
+            return;
+
+    } while (completarSegmentoColaSPI(numSPI, ok));
+}
+
+
+/***************************************************************************************
+**  Nombre:         void finTransferenciaAsincronaSPI(numSPI_e numSPI, bool ok)
+**  Descripcion:    Aviso del final de un segmento. Se llama desde la interrupcion del DMA
+**  Parametros:     Dispositivo, resultado de la transferencia
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void finTransferenciaAsincronaSPI(numSPI_e numSPI, bool ok)
+{
+    colaSPI_t *cola = &colaSPI[numSPI];
+
+    if (cola->enArranque) {
+        cola->okPendiente = ok;
+        cola->finPendiente = true;
+        return;
+    }
+
+    if (cola->primera == NULL)
+        return;
+
+    if (completarSegmentoColaSPI(numSPI, ok))
+        avanzarColaSPI(numSPI);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool completarSegmentoColaSPI(numSPI_e numSPI, bool ok)
+**  Descripcion:    Gestiona el CS al terminar un segmento y, si es el ultimo o ha fallado,
+**                  saca la transaccion de la cola y ejecuta su callback
+**  Parametros:     Dispositivo, resultado del segmento
+**  Retorno:        True si queda algun segmento por lanzar
+****************************************************************************************/
+CODIGO_RAPIDO bool completarSegmentoColaSPI(numSPI_e numSPI, bool ok)
+{
+    colaSPI_t *cola = &colaSPI[numSPI];
+    transaccionBus_t *transaccion = cola->primera;
+    const segmentoBus_t *segmento = &transaccion->segmentos[transaccion->segmentoActual++];
+    const bool ultimo = transaccion->segmentoActual >= transaccion->numSegmentos;
+    bool continuar;
+
+    if (!ok || ultimo || segmento->liberarCS) {
+        escribirIO(transaccion->bus->bus_u.spi.pinCS, true);
+        cola->csBajo = false;
+    }
+
+    if (ok && !ultimo)
+        return true;
+
+    // La transaccion sale de la cola antes del callback para que pueda volver a encolarse
+    BLOQUE_ATOMICO(NVIC_PRIO_SPI_DMA) {
+        cola->primera = transaccion->siguiente;
+        if (cola->primera == NULL)
+            cola->ultima = NULL;
+    }
+
+    const uint32_t latencia = microsISR() - transaccion->tiempoEncolado;
+    cola->estadisticas.numTransacciones++;
+    cola->estadisticas.latenciaAcumulada += latencia;
+    if (latencia > cola->estadisticas.latenciaMax)
+        cola->estadisticas.latenciaMax = latencia;
+
+    if (!ok)
+        cola->estadisticas.numErrores++;
+
+    transaccion->estado = ok ? TRANSACCION_BUS_COMPLETADA : TRANSACCION_BUS_ERROR;
+    if (transaccion->callback != NULL)
+        transaccion->callback(transaccion, ok);
+
+    BLOQUE_ATOMICO(NVIC_PRIO_SPI_DMA) {
+        continuar = cola->primera != NULL;
+        if (!continuar)
+            cola->activa = false;
+    }
+
+    return continuar;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool colaSPIocupada(numSPI_e numSPI)
+**  Descripcion:    Comprueba si el puerto tiene transacciones pendientes
+**  Parametros:     Dispositivo
+**  Retorno:        True si ocupada
+****************************************************************************************/
+CODIGO_RAPIDO bool colaSPIocupada(numSPI_e numSPI)
+{
+    return colaSPI[numSPI].activa;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool esperarColaSPI(numSPI_e numSPI, uint32_t timeout)
+**  Descripcion:    Espera a que el puerto vacie la cola. Solo se puede llamar desde las
+**                  tareas, nunca desde una interrupcion
+**  Parametros:     Dispositivo, timeout en us
+**  Retorno:        True si la cola esta vacia
+****************************************************************************************/
+bool esperarColaSPI(numSPI_e numSPI, uint32_t timeout)
+{
+    for (uint32_t i = 0; colaSPIocupada(numSPI); i++) {
+        if (i >= timeout)
+            return false;
+
+        delayMicroseconds(1);
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void estadisticasColaSPI(numSPI_e numSPI, estadisticasColaSPI_t *estadisticas)
+**  Descripcion:    Copia las estadisticas de la cola
+**  Parametros:     Dispositivo, estadisticas
+**  Retorno:        Ninguno
+****************************************************************************************/
+void estadisticasColaSPI(numSPI_e numSPI, estadisticasColaSPI_t *estadisticas)
+{
+    BLOQUE_ATOMICO(NVIC_PRIO_SPI_DMA) {
+        *estadisticas = colaSPI[numSPI].estadisticas;
+    }
+}
+
+#endif // USAR_SPI && USAR_COLA_SPI
@@ -0,0 +1,81 @@
+/***************************************************************************************
+**  cola_spi.h - Cola de transacciones asincronas de los puertos SPI
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __COLA_SPI_H
+#define __COLA_SPI_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "bus.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Cada puerto SPI tiene su propia cola de transacciones (transaccionBus_t). La memoria
+ * de las transacciones y de los buffers es del llamante y no se puede tocar hasta que
+ * se ejecute el callback. La cola baja el CS al empezar la transaccion, lanza los
+ * segmentos uno detras de otro y sube el CS al terminar el ultimo o cuando el segmento
+ * lo pide. El callback se ejecuta desde la interrupcion del DMA y puede encolar otra
+ * transaccion para encadenar lecturas.
+ *
+ * El modulo no usa la HAL. La transferencia de cada segmento se delega en
+ * transferirBufferAsincronoSPI (spi_hal.c en el micro y SITL/spi_sitl.c en el PC), que
+ * avisa del final con finTransferenciaAsincronaSPI
+ */
+#define TIMEOUT_COLA_SPI                   1000     // us que esperan las operaciones bloqueantes
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    uint32_t numTransacciones;
+    uint32_t numErrores;
+    uint32_t latenciaMax;                  // us desde que se encola hasta el callback
+    uint64_t latenciaAcumulada;
+} estadisticasColaSPI_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void iniciarColaSPI(numSPI_e numSPI);
+bool encolarTransaccionSPI(transaccionBus_t *transaccion);
+bool colaSPIocupada(numSPI_e numSPI);
+bool esperarColaSPI(numSPI_e numSPI, uint32_t timeout);
+void finTransferenciaAsincronaSPI(numSPI_e numSPI, bool ok);
+void estadisticasColaSPI(numSPI_e numSPI, estadisticasColaSPI_t *estadisticas);
+
+#endif // __COLA_SPI_H
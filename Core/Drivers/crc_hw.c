@@ -0,0 +1,94 @@
+/***************************************************************************************
+**  crc_hw.c - Calculo del CRC16 con la unidad CRC del microcontrolador
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "crc_hw.h"
+
+#ifdef USAR_CRC_HW
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define POLINOMIO_CRC16_HW            0x1021
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static bool crcHWIniciado;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         uint16_t calcularCRC16HW(uint16_t crc, const void *dato, uint32_t longitud)
+**  Descripcion:    Actualiza el CRC-CCITT con la unidad CRC. Los bytes hasta la alineacion
+**                  y el final se escriben de uno en uno y el resto por palabras. La unidad
+**                  procesa la palabra desde el bit 31, por lo que se invierte el orden de
+**                  los bytes para que entren en el orden de la memoria
+**  Parametros:     CRC, dato a actualizar, longitud de los datos
+**  Retorno:        CRC
+****************************************************************************************/
+uint16_t calcularCRC16HW(uint16_t crc, const void *dato, uint32_t longitud)
+{
+    const uint8_t *p = (const uint8_t *)dato;
+
+    if (!crcHWIniciado) {
+        __HAL_RCC_CRC_CLK_ENABLE();
+        CRC->POL = POLINOMIO_CRC16_HW;
+        CRC->CR = CRC_CR_POLYSIZE_0;              // Polinomio de 16 bits sin inversion de entrada ni salida
+        crcHWIniciado = true;
+    }
+
+    CRC->INIT = crc;
+    CRC->CR |= CRC_CR_RESET;
+
+    for (; longitud > 0 && ((uint32_t)p & 3); longitud--, p++)
+        *(__IO uint8_t *)&CRC->DR = *p;
+
+    for (; longitud >= 4; longitud -= 4, p += 4)
+        CRC->DR = __REV(*(const uint32_t *)p);
+
+    for (; longitud > 0; longitud--, p++)
+        *(__IO uint8_t *)&CRC->DR = *p;
+
+    return (uint16_t)CRC->DR;
+}
+
+#endif
@@ -105,6 +105,45 @@ void iniciarDMA(identificadorDMA_e identificador)
 }
 
 
+/***************************************************************************************
+**  Nombre:         bool reservarDMA(identificadorDMA_e identificador, propietarioDMA_e propietario, uint8_t indice)
+**  Descripcion:    Asigna el stream a un periferico. Un stream solo puede tener un propietario:
+**                  si ya lo tiene otro, el que llega despues debe renunciar al DMA
+**  Parametros:     Identificador, tipo de periferico, indice del periferico
+**  Retorno:        True si el stream estaba libre o ya era suyo
+****************************************************************************************/
+bool reservarDMA(identificadorDMA_e identificador, propietarioDMA_e propietario, uint8_t indice)
+{
+    if (identificador == DMA_NINGUNO || identificador > DMA_ULTIMO_HANDLER)
+        return false;
+
+    descriptorCanalDMA_t *descriptor = &descriptorDMA[IDENTIFICADOR_A_INDICE_DMA(identificador)];
+
+    if (descriptor->propietario == DMA_LIBRE) {
+        descriptor->propietario = propietario;
+        descriptor->indicePropietario = indice;
+        return true;
+    }
+
+    return descriptor->propietario == propietario && descriptor->indicePropietario == indice;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void liberarDMA(identificadorDMA_e identificador)
+**  Descripcion:    Deja el stream sin propietario
+**  Parametros:     Identificador
+**  Retorno:        Ninguno
+****************************************************************************************/
+void liberarDMA(identificadorDMA_e identificador)
+{
+    if (identificador == DMA_NINGUNO || identificador > DMA_ULTIMO_HANDLER)
+        return;
+
+    descriptorDMA[IDENTIFICADOR_A_INDICE_DMA(identificador)].propietario = DMA_LIBRE;
+}
+
+
 /***************************************************************************************
 **  Nombre:         void ajustarHandlerDMA(identificadorDMA_e identificador, callbackHandlerFuncPtrDMA callback, uint32_t prioridad, uint32_t parametros)
 **  Descripcion:    Ajusta el handler del DMA
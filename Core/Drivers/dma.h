@@ -47,6 +47,8 @@
     .flagsShift = f,                    \
     .irqN = d ## _Stream ## s ## _IRQn, \
     .paramUsuario = 0,                  \
+    .propietario = DMA_LIBRE,           \
+    .indicePropietario = 0,             \
     }
 
 #define DEFINIR_IRQ_HANDLER_DMA(d, s, i) void DMA ## d ## _Stream ## s ## _IRQHandler(void) { \
@@ -68,6 +70,19 @@
 /***************************************************************************************
 ** AREA DE DEFINICION DE TIPOS                                                        **
 ****************************************************************************************/
+typedef enum {
+    DMA_LIBRE = 0,
+    DMA_ADC,
+    DMA_UART_TX,
+    DMA_UART_RX,
+    DMA_SPI_TX,
+    DMA_SPI_RX,
+    DMA_SDMMC_TX,
+    DMA_SDMMC_RX,
+    DMA_MOTOR,                            // Stream del canal de un motor (indice del motor)
+    DMA_TIMER_UP,                         // Stream de update en burst (indice del timer)
+} propietarioDMA_e;
+
 struct descriptorCanalDMA_s;
 typedef void (*callbackHandlerFuncPtrDMA)(struct descriptorCanalDMA_s *descriptorCanal);
 
@@ -80,6 +95,8 @@ typedef struct descriptorCanalDMA_s{
     IRQn_Type irqN;
     uint32_t paramUsuario;
     uint32_t completeFlag;
+    propietarioDMA_e propietario;
+    uint8_t indicePropietario;
 } descriptorCanalDMA_t;
 
 typedef enum {
@@ -118,6 +135,8 @@ typedef struct {
 ** AREA DE PROTOTIPOS DE FUNCION                                                      **
 ****************************************************************************************/
 void iniciarDMA(identificadorDMA_e identificador);
+bool reservarDMA(identificadorDMA_e identificador, propietarioDMA_e propietario, uint8_t indice);
+void liberarDMA(identificadorDMA_e identificador);
 void ajustarHandlerDMA(identificadorDMA_e identifier, callbackHandlerFuncPtrDMA callback, uint32_t prioridad, uint32_t parametros);
 identificadorDMA_e identificadorDMA(const DMA_Stream_TypeDef* stream);
 
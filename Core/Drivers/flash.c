@@ -55,14 +55,14 @@
 /***************************************************************************************
 ** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
-extern uint8_t inicioRegionConfig;       // Definido en el Linker
 
 
 /***************************************************************************************
 ** AREA DE PROTOTIPOS DE FUNCION                                                      **
 ****************************************************************************************/
-uint32_t sectorParaConfigGrabadorFlash(void);
+uint32_t sectorFlash(uintptr_t dir);
 int32_t escribirWordGrabadorFlash(grabadorFlash_t *grabador, uint32_t valor);
+void invalidarCacheFlash(uintptr_t dir, uint32_t tam);
 
 
 /***************************************************************************************
@@ -165,6 +165,53 @@ int32_t flushGrabadorFlash(grabadorFlash_t *grabador)
 }
 
 
+/***************************************************************************************
+**  Nombre:         int32_t borrarSectorFlash(uintptr_t dir)
+**  Descripcion:    Borra el sector que contiene una direccion
+**  Parametros:     Direccion dentro del sector
+**  Retorno:        Codigo de error: 0 no error, -1 fallo en el borrado
+****************************************************************************************/
+int32_t borrarSectorFlash(uintptr_t dir)
+{
+    FLASH_EraseInitTypeDef inicioBorrado = {
+        .TypeErase = FLASH_TYPEERASE_SECTORS,
+        .VoltageRange = FLASH_VOLTAGE_RANGE_3,     // 2.7-3.6V
+        .NbSectors = 1
+    };
+    inicioBorrado.Sector = sectorFlash(dir);
+
+    uint32_t errorSector;
+    HAL_FLASH_Unlock();
+    const HAL_StatusTypeDef estado = HAL_FLASHEx_Erase(&inicioBorrado, &errorSector);
+    HAL_FLASH_Lock();
+
+    invalidarCacheFlash(dir & ~(FLASH_PAGE_SIZE - 1), FLASH_PAGE_SIZE);
+    return estado == HAL_OK ? 0 : -1;
+}
+
+
+/***************************************************************************************
+**  Nombre:         int32_t programarFlash(uintptr_t dir, const uint32_t *dato, uint32_t numWords)
+**  Descripcion:    Programa words en una zona ya borrada, sin borrar nada
+**  Parametros:     Direccion alineada a word, datos, numero de words
+**  Retorno:        Codigo de error: 0 no error, -2 Fallo al grabar
+****************************************************************************************/
+int32_t programarFlash(uintptr_t dir, const uint32_t *dato, uint32_t numWords)
+{
+    int32_t error = 0;
+
+    HAL_FLASH_Unlock();
+    for (uint32_t i = 0; i < numWords && error == 0; i++) {
+        if (HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, dir + i * sizeof(uint32_t), dato[i]) != HAL_OK)
+            error = -2;
+    }
+    HAL_FLASH_Lock();
+
+    invalidarCacheFlash(dir, numWords * sizeof(uint32_t));
+    return error;
+}
+
+
 #if defined(STM32F767xx)
 /*
 Sector 0    0x08000000 - 0x08007FFF 32 Kbytes
@@ -183,36 +230,36 @@ Sector 10   0x08180000 - 0x081BFFFF 256 Kbytes
 Sector 11   0x081C0000 - 0x081FFFFF 256 Kbytes
 */
 /***************************************************************************************
-**  Nombre:         uint32_t sectorParaConfigGrabadorFlash(void)
-**  Descripcion:    Obtiene el sector de la flash
-**  Parametros:     Ninguno
+**  Nombre:         uint32_t sectorFlash(uintptr_t dir)
+**  Descripcion:    Obtiene el sector de la flash que contiene una direccion
+**  Parametros:     Direccion
 **  Retorno:        Sector de la flash
 ****************************************************************************************/
-uint32_t sectorParaConfigGrabadorFlash(void)
+uint32_t sectorFlash(uintptr_t dir)
 {
-    if ((uint32_t)&inicioRegionConfig <= 0x08007FFF)
+    if (dir <= 0x08007FFF)
         return FLASH_SECTOR_0;
-    if ((uint32_t)&inicioRegionConfig <= 0x0800FFFF)
+    if (dir <= 0x0800FFFF)
         return FLASH_SECTOR_1;
-    if ((uint32_t)&inicioRegionConfig <= 0x08017FFF)
+    if (dir <= 0x08017FFF)
         return FLASH_SECTOR_2;
-    if ((uint32_t)&inicioRegionConfig <= 0x0801FFFF)
+    if (dir <= 0x0801FFFF)
         return FLASH_SECTOR_3;
-    if ((uint32_t)&inicioRegionConfig <= 0x0803FFFF)
+    if (dir <= 0x0803FFFF)
         return FLASH_SECTOR_4;
-    if ((uint32_t)&inicioRegionConfig <= 0x0807FFFF)
+    if (dir <= 0x0807FFFF)
         return FLASH_SECTOR_5;
-    if ((uint32_t)&inicioRegionConfig <= 0x080BFFFF)
+    if (dir <= 0x080BFFFF)
         return FLASH_SECTOR_6;
-    if ((uint32_t)&inicioRegionConfig <= 0x080FFFFF)
+    if (dir <= 0x080FFFFF)
         return FLASH_SECTOR_7;
-    if ((uint32_t)&inicioRegionConfig <= 0x0813FFFF)
+    if (dir <= 0x0813FFFF)
         return FLASH_SECTOR_8;
-    if ((uint32_t)&inicioRegionConfig <= 0x0817FFFF)
+    if (dir <= 0x0817FFFF)
         return FLASH_SECTOR_9;
-    if ((uint32_t)&inicioRegionConfig <= 0x081BFFFF)
+    if (dir <= 0x081BFFFF)
         return FLASH_SECTOR_10;
-    if ((uint32_t)&inicioRegionConfig <= 0x081FFFFF)
+    if (dir <= 0x081FFFFF)
         return FLASH_SECTOR_11;
 
 
@@ -233,28 +280,28 @@ Sector 6    0x08040000 - 0x0805FFFF 128 Kbytes
 Sector 7    0x08060000 - 0x0807FFFF 128 Kbytes
 */
 /***************************************************************************************
-**  Nombre:         uint32_t sectorParaConfigGrabadorFlash(void)
-**  Descripcion:    Obtiene el sector de la flash
-**  Parametros:     Ninguno
+**  Nombre:         uint32_t sectorFlash(uintptr_t dir)
+**  Descripcion:    Obtiene el sector de la flash que contiene una direccion
+**  Parametros:     Direccion
 **  Retorno:        Sector de la flash
 ****************************************************************************************/
-uint32_t sectorParaConfigGrabadorFlash(void)
+uint32_t sectorFlash(uintptr_t dir)
 {
-    if ((uint32_t)&inicioRegionConfig <= 0x08003FFF)
+    if (dir <= 0x08003FFF)
         return FLASH_SECTOR_0;
-    if ((uint32_t)&inicioRegionConfig <= 0x08007FFF)
+    if (dir <= 0x08007FFF)
         return FLASH_SECTOR_1;
-    if ((uint32_t)&inicioRegionConfig <= 0x0800BFFF)
+    if (dir <= 0x0800BFFF)
         return FLASH_SECTOR_2;
-    if ((uint32_t)&inicioRegionConfig <= 0x0800FFFF)
+    if (dir <= 0x0800FFFF)
         return FLASH_SECTOR_3;
-    if ((uint32_t)&inicioRegionConfig <= 0x0801FFFF)
+    if (dir <= 0x0801FFFF)
         return FLASH_SECTOR_4;
-    if ((uint32_t)&inicioRegionConfig <= 0x0803FFFF)
+    if (dir <= 0x0803FFFF)
         return FLASH_SECTOR_5;
-    if ((uint32_t)&inicioRegionConfig <= 0x0805FFFF)
+    if (dir <= 0x0805FFFF)
         return FLASH_SECTOR_6;
-    if ((uint32_t)&inicioRegionConfig <= 0x0807FFFF)
+    if (dir <= 0x0807FFFF)
         return FLASH_SECTOR_7;
 
 
@@ -283,7 +330,7 @@ int32_t escribirWordGrabadorFlash(grabadorFlash_t *grabador, uint32_t valor)
             .VoltageRange = FLASH_VOLTAGE_RANGE_3,     // 2.7-3.6V
             .NbSectors = 1
         };
-        inicioBorrado.Sector = sectorParaConfigGrabadorFlash();
+        inicioBorrado.Sector = sectorFlash(grabador->dir);
 
         uint32_t errorSector;
         const HAL_StatusTypeDef estado = HAL_FLASHEx_Erase(&inicioBorrado, &errorSector);
@@ -299,3 +346,16 @@ int32_t escribirWordGrabadorFlash(grabadorFlash_t *grabador, uint32_t valor)
     return 0;
 }
 
+
+/***************************************************************************************
+**  Nombre:         void invalidarCacheFlash(uintptr_t dir, uint32_t tam)
+**  Descripcion:    Invalida la D-Cache de una zona de la flash despues de borrarla o
+**                  programarla para que las lecturas vean lo grabado
+**  Parametros:     Direccion, tamanio
+**  Retorno:        Ninguno
+****************************************************************************************/
+void invalidarCacheFlash(uintptr_t dir, uint32_t tam)
+{
+    const uint32_t dirAlineada = dir & ~0x1F;
+    SCB_InvalidateDCache_by_Addr((uint32_t *)dirAlineada, tam + (dir - dirAlineada));
+}
@@ -70,4 +70,7 @@ int32_t bloquearGrabadorFlash(grabadorFlash_t *grabador);
 int32_t escribirGrabadorFlash(grabadorFlash_t *grabador, const uint8_t *p, uint32_t tam);
 int32_t flushGrabadorFlash(grabadorFlash_t *grabador);
 
+int32_t borrarSectorFlash(uintptr_t dir);
+int32_t programarFlash(uintptr_t dir, const uint32_t *dato, uint32_t numWords);
+
 #endif // __FLASH_H
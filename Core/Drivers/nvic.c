@@ -172,8 +172,7 @@ void SysTick_Handler(void)
 {
     BLOQUE_ATOMICO(NVIC_PRIO_MAX) {
         tiempoSysTick++;                  // Variable usada en la funcion millis
-        ciclosSysTick = SysTick->VAL;
-        sysTickPendiente = 0;
+        actualizarBaseTiempos();          // Referencia de micros() y nanos()
         (void)(SysTick->CTRL);
     }
 
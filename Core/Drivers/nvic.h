@@ -51,6 +51,7 @@
 #define NVIC_PRIO_SERIALUART8              CONSTRUIR_PRIORIDAD_NVIC(1, 2)
 #define NVIC_PRIO_SDMMC1                   CONSTRUIR_PRIORIDAD_NVIC(1, 0)
 #define NVIC_PRIO_SDMMC2                   CONSTRUIR_PRIORIDAD_NVIC(1, 0)
+#define NVIC_PRIO_SPI_DMA                  CONSTRUIR_PRIORIDAD_NVIC(2, 0)
 
 // Macros para generar o partir la prioridad
 #define CONSTRUIR_PRIORIDAD_NVIC(base,sub)      (((((base) << (__NVIC_PRIO_BITS - (7 - (NVIC_PRIORITYGROUP_2)))) | ((sub) & (0x0F >> (7 - (NVIC_PRIORITYGROUP_2))))) << __NVIC_PRIO_BITS) & 0xf0)
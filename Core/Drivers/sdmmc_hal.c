@@ -112,6 +112,11 @@ bool iniciarDriverSDMMC(void)
     driver->hal.hsdmmc.Init.ClockDiv = 0;
 
 #ifdef USAR_DMA_SDMMC
+    // Las transferencias del SDMMC son siempre por DMA, sin los streams no hay SD
+    if (!reservarDMA(identificadorDMA(driver->hal.hdmaTx.Instance), DMA_SDMMC_TX, 0) ||
+        !reservarDMA(identificadorDMA(driver->hal.hdmaRx.Instance), DMA_SDMMC_RX, 0))
+        return false;
+
     // Configuracion del DMA para el envio
     iniciarDMA(identificadorDMA(driver->hal.hdmaTx.Instance));
 
@@ -32,6 +32,9 @@
 
 #ifdef USAR_SPI
 #include "io.h"
+#ifdef USAR_COLA_SPI
+#include "cola_spi.h"
+#endif
 
 
 /***************************************************************************************
@@ -91,6 +94,9 @@ bool iniciarSPI(numSPI_e numSPI)
     memset(driver, 0, sizeof(*driver));
     resetearContadorErrorSPI(numSPI);
     driver->iniciado = false;
+#ifdef USAR_COLA_SPI
+    iniciarColaSPI(numSPI);
+#endif
 
     if (iniciarDriverSPI(numSPI)) {
         driver->iniciado = true;
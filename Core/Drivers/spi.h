@@ -68,6 +68,14 @@ typedef struct {
     pin_t pinSCK;
     pin_t pinMISO;
     pin_t pinMOSI;
+#ifdef USAR_COLA_SPI
+    bool usarDMA;
+    DMA_HandleTypeDef hdmaTx;
+    DMA_HandleTypeDef hdmaRx;
+    uint8_t *bufferRxDMA;                 // Buffer a invalidar en la cache al terminar
+    uint16_t longitudRxDMA;
+    uint8_t IRQ;
+#endif
 } halSPI_t;
 
 typedef struct {
@@ -104,5 +112,8 @@ bool leerSPI(numSPI_e numSPI, uint8_t *byteRx);
 bool leerBufferSPI(numSPI_e numSPI, uint8_t *datoRx, uint16_t longitud);
 bool transferirSPI(numSPI_e numSPI, uint8_t byteTx, uint8_t *byteRx);
 bool transferirBufferSPI(numSPI_e numSPI, uint8_t *datoTx, uint8_t *datoRx, uint16_t longitud);
+#ifdef USAR_COLA_SPI
+bool transferirBufferAsincronoSPI(numSPI_e numSPI, uint8_t *datoTx, uint8_t *datoRx, uint16_t longitud);
+#endif
 
 #endif // __SPI_H
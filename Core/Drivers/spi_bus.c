@@ -30,6 +30,9 @@
 #if defined(USAR_SPI)
 #include "bus.h"
 #include "io.h"
+#ifdef USAR_COLA_SPI
+#include "cola_spi.h"
+#endif
 
 
 /***************************************************************************************
@@ -64,6 +67,11 @@
 ****************************************************************************************/
 bool ocupadoBusSPI(const bus_t *bus)
 {
+#ifdef USAR_COLA_SPI
+    if (colaSPIocupada(bus->bus_u.spi.numSPI))
+        return true;
+#endif
+
     return ocupadoSPI(bus->bus_u.spi.numSPI);
 }
 
@@ -33,12 +33,21 @@
 #include "GP/gp_spi.h"
 #include "io.h"
 #include "Comun/matematicas.h"
+#ifdef USAR_COLA_SPI
+#include "dma.h"
+#include "nvic.h"
+#include "cola_spi.h"
+#if defined(USAR_MOTORES) && defined(USAR_DSHOT)
+#include "Motores/motor.h"
+#endif
+#endif
 
 
 /***************************************************************************************
 ** AREA DE PREPROCESADOR                                                              **
 ****************************************************************************************/
 #define TIMEOUT_DEFECTO_SPI     10
+#define TAM_LINEA_CACHE         32
 
 
 /***************************************************************************************
@@ -57,6 +66,12 @@
 void ajustarPrescalerBaudrateSPI(SPI_TypeDef *SPIx, uint32_t BaudRate);
 uint32_t nivelFifoTxSPI(SPI_TypeDef *SPIx);
 void habilitarRelojSPI(numSPI_e numSPI);
+#ifdef USAR_COLA_SPI
+bool iniciarDMAspi(numSPI_e numSPI);
+void irqHandlerDMAspi(descriptorCanalDMA_t *descriptor);
+numSPI_e numSPIhandle(SPI_HandleTypeDef *hspi);
+void finDMAspi(SPI_HandleTypeDef *hspi, bool ok);
+#endif
 
 
 /***************************************************************************************
@@ -111,10 +126,260 @@ bool iniciarDriverSPI(numSPI_e numSPI)
     if (HAL_SPI_Init(&driver->hal.hspi) != HAL_OK)
         return false;
 
+#ifdef USAR_COLA_SPI
+    if (driver->hal.usarDMA && !iniciarDMAspi(numSPI))
+        return false;
+#endif
+
+    return true;
+}
+
+
+#ifdef USAR_COLA_SPI
+/***************************************************************************************
+**  Nombre:         bool iniciarDMAspi(numSPI_e numSPI)
+**  Descripcion:    Configura los streams de DMA de la cola de transacciones. Si alguno
+**                  esta ocupado se deja el puerto sin DMA
+**  Parametros:     Dispositivo
+**  Retorno:        True si ok
+****************************************************************************************/
+bool iniciarDMAspi(numSPI_e numSPI)
+{
+    spi_t *driver = punteroSPI(numSPI);
+    const identificadorDMA_e dmaTx = identificadorDMA(driver->hal.hdmaTx.Instance);
+    const identificadorDMA_e dmaRx = identificadorDMA(driver->hal.hdmaRx.Instance);
+
+#if defined(USAR_MOTORES) && defined(USAR_DSHOT)
+    // Los motores se inician despues y con DShot por canal necesitan DMA1_Stream3/Stream4
+    if (dshotPorCanalMotores() && (dmaTx == DMA1_ST4_HANDLER || dmaRx == DMA1_ST3_HANDLER)) {
+        driver->hal.usarDMA = false;
+        return true;
+    }
+#endif
+
+    // Si otro periferico tiene alguno de los streams la cola usa transferencias bloqueantes
+    if (!reservarDMA(dmaTx, DMA_SPI_TX, numSPI))
+        driver->hal.usarDMA = false;
+    else if (!reservarDMA(dmaRx, DMA_SPI_RX, numSPI)) {
+        liberarDMA(dmaTx);
+        driver->hal.usarDMA = false;
+    }
+
+    if (!driver->hal.usarDMA)
+        return true;
+
+    // Configuracion del DMA para el envio
+    iniciarDMA(dmaTx);
+
+    driver->hal.hdmaTx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    driver->hal.hdmaTx.Init.PeriphInc = DMA_PINC_DISABLE;
+    driver->hal.hdmaTx.Init.MemInc = DMA_MINC_ENABLE;
+    driver->hal.hdmaTx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    driver->hal.hdmaTx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    driver->hal.hdmaTx.Init.Mode = DMA_NORMAL;
+    driver->hal.hdmaTx.Init.Priority = DMA_PRIORITY_HIGH;
+    driver->hal.hdmaTx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+
+    if (HAL_DMA_Init(&driver->hal.hdmaTx) != HAL_OK)
+        return false;
+
+    __HAL_LINKDMA(&driver->hal.hspi, hdmatx, driver->hal.hdmaTx);
+
+    // Configuracion del DMA para la recepcion
+    iniciarDMA(dmaRx);
+
+    driver->hal.hdmaRx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    driver->hal.hdmaRx.Init.PeriphInc = DMA_PINC_DISABLE;
+    driver->hal.hdmaRx.Init.MemInc = DMA_MINC_ENABLE;
+    driver->hal.hdmaRx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+    driver->hal.hdmaRx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+    driver->hal.hdmaRx.Init.Mode = DMA_NORMAL;
+    driver->hal.hdmaRx.Init.Priority = DMA_PRIORITY_VERY_HIGH;
+    driver->hal.hdmaRx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+
+    if (HAL_DMA_Init(&driver->hal.hdmaRx) != HAL_OK)
+        return false;
+
+    __HAL_LINKDMA(&driver->hal.hspi, hdmarx, driver->hal.hdmaRx);
+
+    // Las interrupciones de ambos streams llegan al handler de la HAL
+    ajustarHandlerDMA(dmaTx, irqHandlerDMAspi, NVIC_PRIO_SPI_DMA, (uint32_t)&driver->hal.hdmaTx);
+    ajustarHandlerDMA(dmaRx, irqHandlerDMAspi, NVIC_PRIO_SPI_DMA, (uint32_t)&driver->hal.hdmaRx);
+
+    // Interrupcion de errores del SPI (overrun, modo)
+    HAL_NVIC_SetPriority(driver->hal.IRQ, PRIORIDAD_BASE_NVIC(NVIC_PRIO_SPI_DMA), PRIORIDAD_SUB_NVIC(NVIC_PRIO_SPI_DMA));
+    HAL_NVIC_EnableIRQ(driver->hal.IRQ);
+
     return true;
 }
 
 
+/***************************************************************************************
+**  Nombre:         bool transferirBufferAsincronoSPI(numSPI_e numSPI, uint8_t *datoTx, uint8_t *datoRx,
+**                                                    uint16_t longitud)
+**  Descripcion:    Lanza una transferencia por DMA. Al terminar se avisa a la cola con
+**                  finTransferenciaAsincronaSPI. Sin DMA la transferencia es bloqueante y
+**                  el aviso se da antes de retornar
+**  Parametros:     Dispositivo, buffer a enviar (NULL solo lectura), buffer a recibir (NULL
+**                  solo escritura), longitud
+**  Retorno:        True si se ha lanzado
+****************************************************************************************/
+CODIGO_RAPIDO bool transferirBufferAsincronoSPI(numSPI_e numSPI, uint8_t *datoTx, uint8_t *datoRx, uint16_t longitud)
+{
+    spi_t *driver = punteroSPI(numSPI);
+    SPI_HandleTypeDef *hspi = &driver->hal.hspi;
+    HAL_StatusTypeDef estado;
+
+    if (!driver->hal.usarDMA) {
+        bool ok;
+
+        if (datoRx == NULL)
+            ok = escribirBufferSPI(numSPI, datoTx, longitud);
+        else if (datoTx == NULL)
+            ok = leerBufferSPI(numSPI, datoRx, longitud);
+        else
+            ok = transferirBufferSPI(numSPI, datoTx, datoRx, longitud);
+
+        finTransferenciaAsincronaSPI(numSPI, ok);
+        return true;
+    }
+
+    // El DMA no pasa por la cache de datos. Los buffers en RAM_RAPIDA (DTCM) no se cachean
+    if (datoTx != NULL) {
+        const uint32_t dirAlineada = (uint32_t)datoTx & ~(TAM_LINEA_CACHE - 1);
+        SCB_CleanDCache_by_Addr((uint32_t *)dirAlineada, longitud + ((uint32_t)datoTx - dirAlineada));
+    }
+
+    if (datoRx != NULL) {
+        const uint32_t dirAlineada = (uint32_t)datoRx & ~(TAM_LINEA_CACHE - 1);
+        SCB_CleanInvalidateDCache_by_Addr((uint32_t *)dirAlineada, longitud + ((uint32_t)datoRx - dirAlineada));
+    }
+
+    driver->hal.bufferRxDMA = datoRx;
+    driver->hal.longitudRxDMA = longitud;
+
+    if (datoRx == NULL)
+        estado = HAL_SPI_Transmit_DMA(hspi, datoTx, longitud);
+    else if (datoTx == NULL)
+        estado = HAL_SPI_Receive_DMA(hspi, datoRx, longitud);
+    else
+        estado = HAL_SPI_TransmitReceive_DMA(hspi, datoTx, datoRx, longitud);
+
+    if (estado != HAL_OK) {
+        errorCallbackSPI(numSPI);
+        return false;
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void irqHandlerDMAspi(descriptorCanalDMA_t *descriptor)
+**  Descripcion:    Handler de las interrupciones de los streams del SPI
+**  Parametros:     Descriptor del canal
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void irqHandlerDMAspi(descriptorCanalDMA_t *descriptor)
+{
+    HAL_DMA_IRQHandler((DMA_HandleTypeDef *)descriptor->paramUsuario);
+}
+
+
+/***************************************************************************************
+**  Nombre:         numSPI_e numSPIhandle(SPI_HandleTypeDef *hspi)
+**  Descripcion:    Obtiene el numero de SPI a partir del handle de la HAL
+**  Parametros:     Handle del SPI
+**  Retorno:        Numero de SPI
+****************************************************************************************/
+CODIGO_RAPIDO numSPI_e numSPIhandle(SPI_HandleTypeDef *hspi)
+{
+    for (uint8_t i = 0; i < NUM_MAX_SPI; i++) {
+        if (&punteroSPI(i)->hal.hspi == hspi)
+            return i;
+    }
+
+    return SPI_NINGUNO;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void finDMAspi(SPI_HandleTypeDef *hspi, bool ok)
+**  Descripcion:    Invalida la cache del buffer recibido y avisa a la cola
+**  Parametros:     Handle del SPI, resultado de la transferencia
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void finDMAspi(SPI_HandleTypeDef *hspi, bool ok)
+{
+    const numSPI_e numSPI = numSPIhandle(hspi);
+
+    if (numSPI == SPI_NINGUNO)
+        return;
+
+    spi_t *driver = punteroSPI(numSPI);
+
+    if (driver->hal.bufferRxDMA != NULL) {
+        const uint32_t dirAlineada = (uint32_t)driver->hal.bufferRxDMA & ~(TAM_LINEA_CACHE - 1);
+        SCB_InvalidateDCache_by_Addr((uint32_t *)dirAlineada, driver->hal.longitudRxDMA + ((uint32_t)driver->hal.bufferRxDMA - dirAlineada));
+        driver->hal.bufferRxDMA = NULL;
+    }
+
+    if (!ok)
+        errorCallbackSPI(numSPI);
+
+    finTransferenciaAsincronaSPI(numSPI, ok);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+**  Descripcion:    Callback de la HAL al terminar una transferencia por DMA
+**  Parametros:     Handle del SPI
+**  Retorno:        Ninguno
+****************************************************************************************/
+void HAL_SPI_TxRxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    finDMAspi(hspi, true);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+**  Descripcion:    Callback de la HAL al terminar un envio por DMA
+**  Parametros:     Handle del SPI
+**  Retorno:        Ninguno
+****************************************************************************************/
+void HAL_SPI_TxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    finDMAspi(hspi, true);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi)
+**  Descripcion:    Callback de la HAL al terminar una recepcion por DMA
+**  Parametros:     Handle del SPI
+**  Retorno:        Ninguno
+****************************************************************************************/
+void HAL_SPI_RxCpltCallback(SPI_HandleTypeDef *hspi)
+{
+    finDMAspi(hspi, true);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+**  Descripcion:    Callback de la HAL cuando falla una transferencia por DMA
+**  Parametros:     Handle del SPI
+**  Retorno:        Ninguno
+****************************************************************************************/
+void HAL_SPI_ErrorCallback(SPI_HandleTypeDef *hspi)
+{
+    finDMAspi(hspi, false);
+}
+#endif
+
+
 /***************************************************************************************
 **  Nombre:         bool escribirSPI(numSPI_e numSPI, uint8_t byteTx)
 **  Descripcion:    Escribe un dato en el SPI
@@ -328,4 +593,80 @@ void habilitarRelojSPI(numSPI_e numSPI)
     }
 }
 
+
+#ifdef USAR_COLA_SPI
+/***************************************************************************************
+**  Nombre:         void SPI1_IRQHandler(void)
+**  Descripcion:    Interrupcion de errores del SPI1
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void SPI1_IRQHandler(void)
+{
+    HAL_SPI_IRQHandler(&punteroSPI(SPI_1)->hal.hspi);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void SPI2_IRQHandler(void)
+**  Descripcion:    Interrupcion de errores del SPI2
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void SPI2_IRQHandler(void)
+{
+    HAL_SPI_IRQHandler(&punteroSPI(SPI_2)->hal.hspi);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void SPI3_IRQHandler(void)
+**  Descripcion:    Interrupcion de errores del SPI3
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void SPI3_IRQHandler(void)
+{
+    HAL_SPI_IRQHandler(&punteroSPI(SPI_3)->hal.hspi);
+}
+
+
+#if defined(STM32F767xx)
+/***************************************************************************************
+**  Nombre:         void SPI4_IRQHandler(void)
+**  Descripcion:    Interrupcion de errores del SPI4
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void SPI4_IRQHandler(void)
+{
+    HAL_SPI_IRQHandler(&punteroSPI(SPI_4)->hal.hspi);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void SPI5_IRQHandler(void)
+**  Descripcion:    Interrupcion de errores del SPI5
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void SPI5_IRQHandler(void)
+{
+    HAL_SPI_IRQHandler(&punteroSPI(SPI_5)->hal.hspi);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void SPI6_IRQHandler(void)
+**  Descripcion:    Interrupcion de errores del SPI6
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void SPI6_IRQHandler(void)
+{
+    HAL_SPI_IRQHandler(&punteroSPI(SPI_6)->hal.hspi);
+}
+#endif
+#endif
+
 #endif
@@ -30,12 +30,14 @@
 #ifdef USAR_SPI
 #include "GP/gp_spi.h"
 #include "io.h"
+#include "dma.h"
 
 
 /***************************************************************************************
 ** AREA DE PREPROCESADOR                                                              **
 ****************************************************************************************/
 #define NUM_MAX_PIN_SEL_SPI     5
+#define NUM_MAX_STREAM_DMA_SPI  2
 
 
 /***************************************************************************************
@@ -47,6 +49,9 @@ typedef struct {
     pin_t pinSCK[NUM_MAX_PIN_SEL_SPI];
     pin_t pinMISO[NUM_MAX_PIN_SEL_SPI];
     pin_t pinMOSI[NUM_MAX_PIN_SEL_SPI];
+    canalStreamDMA_t dmaTx[NUM_MAX_STREAM_DMA_SPI];
+    canalStreamDMA_t dmaRx[NUM_MAX_STREAM_DMA_SPI];
+    uint8_t IRQ;
 } hardwareSPI_t;
 
 
@@ -72,6 +77,15 @@ static const hardwareSPI_t hardwareSPI[] = {
             { DEFIO_TAG(PB5), GPIO_AF5_SPI1 },
             { DEFIO_TAG(PD7), GPIO_AF5_SPI1 },
         },
+        .dmaTx = {
+            { DMA2_Stream3, DMA_CHANNEL_3 },
+            { DMA2_Stream5, DMA_CHANNEL_3 },
+        },
+        .dmaRx = {
+            { DMA2_Stream0, DMA_CHANNEL_3 },
+            { DMA2_Stream2, DMA_CHANNEL_3 },
+        },
+        .IRQ = SPI1_IRQn,
     },
     {
         .numSPI = SPI_2,
@@ -92,6 +106,13 @@ static const hardwareSPI_t hardwareSPI[] = {
             { DEFIO_TAG(PC1), GPIO_AF5_SPI2  },
             { DEFIO_TAG(PC3), GPIO_AF5_SPI2  },
         },
+        .dmaTx = {
+            { DMA1_Stream4, DMA_CHANNEL_0 },
+        },
+        .dmaRx = {
+            { DMA1_Stream3, DMA_CHANNEL_0 },
+        },
+        .IRQ = SPI2_IRQn,
     },
     {
         .numSPI = SPI_3,
@@ -110,6 +131,15 @@ static const hardwareSPI_t hardwareSPI[] = {
             { DEFIO_TAG(PC12), GPIO_AF6_SPI3 },
             { DEFIO_TAG(PD6), GPIO_AF5_SPI3  },
         },
+        .dmaTx = {
+            { DMA1_Stream5, DMA_CHANNEL_0 },
+            { DMA1_Stream7, DMA_CHANNEL_0 },
+        },
+        .dmaRx = {
+            { DMA1_Stream0, DMA_CHANNEL_0 },
+            { DMA1_Stream2, DMA_CHANNEL_0 },
+        },
+        .IRQ = SPI3_IRQn,
     },
 #if defined(STM32F767xx)
     {
@@ -127,6 +157,15 @@ static const hardwareSPI_t hardwareSPI[] = {
             { DEFIO_TAG(PE6), GPIO_AF5_SPI4  },
             { DEFIO_TAG(PE14), GPIO_AF5_SPI4 },
         },
+        .dmaTx = {
+            { DMA2_Stream1, DMA_CHANNEL_4 },
+            { DMA2_Stream4, DMA_CHANNEL_5 },
+        },
+        .dmaRx = {
+            { DMA2_Stream0, DMA_CHANNEL_4 },
+            { DMA2_Stream3, DMA_CHANNEL_5 },
+        },
+        .IRQ = SPI4_IRQn,
     },
     {
         .numSPI = SPI_5,
@@ -141,6 +180,15 @@ static const hardwareSPI_t hardwareSPI[] = {
             { DEFIO_TAG(PF9), GPIO_AF5_SPI5  },
             { DEFIO_TAG(PF11), GPIO_AF5_SPI5 },
         },
+        .dmaTx = {
+            { DMA2_Stream4, DMA_CHANNEL_2 },
+            { DMA2_Stream6, DMA_CHANNEL_7 },
+        },
+        .dmaRx = {
+            { DMA2_Stream3, DMA_CHANNEL_2 },
+            { DMA2_Stream5, DMA_CHANNEL_7 },
+        },
+        .IRQ = SPI5_IRQn,
     },
     {
         .numSPI = SPI_6,
@@ -160,6 +208,13 @@ static const hardwareSPI_t hardwareSPI[] = {
             { DEFIO_TAG(PB5), GPIO_AF8_SPI6  },
             { DEFIO_TAG(PG14), GPIO_AF5_SPI6 },
         },
+        .dmaTx = {
+            { DMA2_Stream5, DMA_CHANNEL_1 },
+        },
+        .dmaRx = {
+            { DMA2_Stream6, DMA_CHANNEL_1 },
+        },
+        .IRQ = SPI6_IRQn,
     },
 #endif
 };
@@ -169,6 +224,8 @@ static const hardwareSPI_t hardwareSPI[] = {
 ** AREA DE PROTOTIPOS DE FUNCION                                                      **
 ****************************************************************************************/
 bool pinSPI(numSPI_e numSPI, uint8_t pinBusqueda, pin_t *pinDriver);
+bool comprobarStreamDMAspi(const canalStreamDMA_t *tabla, DMA_Stream_TypeDef *DMAy_Streamx);
+uint32_t canalStreamDMAspi(const canalStreamDMA_t *tabla, DMA_Stream_TypeDef *DMAy_Streamx);
 
 
 /***************************************************************************************
@@ -197,6 +254,26 @@ bool asignarHALspi(numSPI_e numSPI)
 
     // Asignamos la instancia
     driver->hal.hspi.Instance = hardwareSPI[numSPI].reg;
+
+#ifdef USAR_COLA_SPI
+    // Asignamos el DMA. Sin streams configurados la cola usa las transferencias bloqueantes
+    driver->hal.usarDMA = false;
+    if (configSPI(numSPI)->streamDMAtx != NULL && configSPI(numSPI)->streamDMArx != NULL) {
+        if (!comprobarStreamDMAspi(hardwareSPI[numSPI].dmaTx, configSPI(numSPI)->streamDMAtx) ||
+            !comprobarStreamDMAspi(hardwareSPI[numSPI].dmaRx, configSPI(numSPI)->streamDMArx))
+            return false;
+
+        driver->hal.hdmaTx.Instance = configSPI(numSPI)->streamDMAtx;
+        driver->hal.hdmaTx.Init.Channel = canalStreamDMAspi(hardwareSPI[numSPI].dmaTx, configSPI(numSPI)->streamDMAtx);
+
+        driver->hal.hdmaRx.Instance = configSPI(numSPI)->streamDMArx;
+        driver->hal.hdmaRx.Init.Channel = canalStreamDMAspi(hardwareSPI[numSPI].dmaRx, configSPI(numSPI)->streamDMArx);
+
+        driver->hal.IRQ = hardwareSPI[numSPI].IRQ;
+        driver->hal.usarDMA = true;
+    }
+#endif
+
     return true;
 }
 
@@ -232,4 +309,38 @@ bool pinSPI(numSPI_e numSPI, uint8_t pinBusqueda, pin_t *pinDriver)
     return false;
 }
 
+
+/***************************************************************************************
+**  Nombre:         bool comprobarStreamDMAspi(const canalStreamDMA_t *tabla, DMA_Stream_TypeDef *DMAy_Streamx)
+**  Descripcion:    Comprueba si el DMA asignado es correcto
+**  Parametros:     Tabla de streams validos, DMA configurado
+**  Retorno:        True si ok
+****************************************************************************************/
+bool comprobarStreamDMAspi(const canalStreamDMA_t *tabla, DMA_Stream_TypeDef *DMAy_Streamx)
+{
+    for (uint8_t i = 0; i < NUM_MAX_STREAM_DMA_SPI; i++) {
+        if (tabla[i].DMAy_Streamx != NULL && tabla[i].DMAy_Streamx == DMAy_Streamx)
+            return true;
+    }
+
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t canalStreamDMAspi(const canalStreamDMA_t *tabla, DMA_Stream_TypeDef *DMAy_Streamx)
+**  Descripcion:    Devuelve el canal del stream asignado
+**  Parametros:     Tabla de streams validos, DMA configurado
+**  Retorno:        Canal del DMA
+****************************************************************************************/
+uint32_t canalStreamDMAspi(const canalStreamDMA_t *tabla, DMA_Stream_TypeDef *DMAy_Streamx)
+{
+    for (uint8_t i = 0; i < NUM_MAX_STREAM_DMA_SPI; i++) {
+        if (tabla[i].DMAy_Streamx == DMAy_Streamx)
+            return tabla[i].canal;
+    }
+
+    return 0;
+}
+
 #endif // USAR_SPI
@@ -26,8 +26,12 @@
 ** AREA DE INCLUDES                                                                   **
 ****************************************************************************************/
 #include "tiempo.h"
+
+// En SITL la base de tiempos es el reloj virtual del simulador (ver SITL/tiempo_sitl.c)
+#if !defined(SITL)
 #include "atomico.h"
 #include "nvic.h"
+#include "Comun/base_tiempos.h"
 
 
 /***************************************************************************************
@@ -43,15 +47,14 @@
 /***************************************************************************************
 ** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
-static uint32_t usTicks = 0;                       // Ciclos por microsegundo
 volatile uint32_t tiempoSysTick = 0;               // Variable que se incrementa cada ms en la interrupcion del systick timer
-volatile uint32_t ciclosSysTick = 0;               // Valor del systick en la interrupcion
-volatile int32_t sysTickPendiente = 0;
+static RAM_RAPIDA_INI baseTiempos_t baseTiempos;   // Referencia en el ultimo tick del SysTick sobre el DWT->CYCCNT
 
 
 /***************************************************************************************
 ** AREA DE PROTOTIPOS DE FUNCION                                                      **
 ****************************************************************************************/
+static inline uint32_t leerCiclosDWT(void);
 
 
 /***************************************************************************************
@@ -60,43 +63,77 @@ volatile int32_t sysTickPendiente = 0;
 
 /***************************************************************************************
 **  Nombre:         void iniciarContadorCiclos(void)
-**  Descripcion:    Inicia la variable que dicta los ciclos por microsegundo. Variable
-**                  utilizada en las funciones de tiempo
+**  Descripcion:    Arranca el contador de ciclos del DWT y fija la referencia de la base de
+**                  tiempos en el ultimo tick del SysTick. Se llama con el SysTick en marcha
 **  Parametros:     Ninguno
 **  Retorno:        Ninguno
 ****************************************************************************************/
 void iniciarContadorCiclos(void)
 {
-    usTicks = HAL_RCC_GetSysClockFreq() / 1000000;
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->LAR = 0xC5ACCE55;                         // El Cortex-M7 bloquea el DWT tras el reset
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+    BLOQUE_ATOMICO(NVIC_PRIO_MAX) {
+        // El SysTick va con el reloj del sistema, igual que el DWT
+        const uint32_t ciclosPorTick = HAL_RCC_GetSysClockFreq() / 1000;
+        const uint32_t ms = tiempoSysTick;
+        uint32_t ciclos = leerCiclosDWT();
+        uint32_t cntSysTick = SysTick->VAL;
+        uint32_t ultimoTick;
+
+        // Si el SysTick ha dado la vuelta su interrupcion esta pendiente: ms es todavia el
+        // del tick anterior y al atenderla se avanzaran ms y la referencia. La referencia
+        // se fija en ese tick anterior, un tick antes de la vuelta
+        if (SCB->ICSR & SCB_ICSR_PENDSTSET_Msk) {
+            ciclos = leerCiclosDWT();
+            cntSysTick = SysTick->VAL;
+            ultimoTick = ciclos - (SysTick->LOAD - cntSysTick) - ciclosPorTick;
+        }
+        else
+            ultimoTick = ciclos - (SysTick->LOAD - cntSysTick);
+
+        iniciarBaseTiempos(&baseTiempos, HAL_RCC_GetSysClockFreq(), 1000, ultimoTick, (uint64_t)ms * 1000000);
+    }
 }
 
 
 /***************************************************************************************
-**  Nombre:         uint32_t microsISR(void)
-**  Descripcion:    Retorna los microsegundos cuando se esta ejecutando una interrupcion
-**                  (maximo 70 minutos)
+**  Nombre:         void actualizarBaseTiempos(void)
+**  Descripcion:    Avanza la referencia de la base de tiempos. Se llama en cada tick
 **  Parametros:     Ninguno
-**  Retorno:        Microsegundos transcurridos
+**  Retorno:        Ninguno
 ****************************************************************************************/
-uint32_t microsISR(void)
+CODIGO_RAPIDO void actualizarBaseTiempos(void)
 {
-    register uint32_t ms, pendiente, cntCiclos;
+    avanzarBaseTiempos(&baseTiempos);
+}
 
-    BLOQUE_ATOMICO(NVIC_PRIO_MAX) {
-        cntCiclos = SysTick->VAL;
 
-        if (SysTick->CTRL & SysTick_CTRL_COUNTFLAG_Msk) {
-            // Hay pendiente una interrupcion del SysTick
-            sysTickPendiente = 1;
+/***************************************************************************************
+**  Nombre:         uint32_t leerCiclosDWT(void)
+**  Descripcion:    Lee el contador de ciclos del nucleo
+**  Parametros:     Ninguno
+**  Retorno:        Ciclos
+****************************************************************************************/
+static inline uint32_t leerCiclosDWT(void)
+{
+    return DWT->CYCCNT;
+}
 
-            // Lee el valor del SysTick para asegurar que leemos el valor despues del rollover.
-            cntCiclos = SysTick->VAL;
-        }
-        ms = tiempoSysTick;
-        pendiente = sysTickPendiente;
-    }
 
-    return ((ms + pendiente) * 1000) + (usTicks * 1000 - cntCiclos) / usTicks;
+/***************************************************************************************
+**  Nombre:         uint32_t microsISR(void)
+**  Descripcion:    Retorna los microsegundos cuando se esta ejecutando una interrupcion
+**                  (maximo 70 minutos). La base de tiempos no necesita seccion critica,
+**                  se mantiene por compatibilidad
+**  Parametros:     Ninguno
+**  Retorno:        Microsegundos transcurridos
+****************************************************************************************/
+CODIGO_RAPIDO uint32_t microsISR(void)
+{
+    return microsBaseTiempos(&baseTiempos, leerCiclosDWT);
 }
 
 
@@ -106,20 +143,22 @@ uint32_t microsISR(void)
 **  Parametros:     Ninguno
 **  Retorno:        Microsegundos transcurridos
 ****************************************************************************************/
-uint32_t micros(void)
+CODIGO_RAPIDO uint32_t micros(void)
 {
-    register uint32_t ms, cntCiclos;
-
-    // Llama a microsISR() si estamos dentro de una interrupcion
-    if ((SCB->ICSR & SCB_ICSR_VECTACTIVE_Msk) || (__get_BASEPRI()))
-        return microsISR();
+    return microsBaseTiempos(&baseTiempos, leerCiclosDWT);
+}
 
-    do {
-        ms = tiempoSysTick;
-        cntCiclos = SysTick->VAL;
-    } while (ms != tiempoSysTick || cntCiclos > ciclosSysTick);
 
-    return (ms * 1000) + (usTicks * 1000 - cntCiclos) / usTicks;
+/***************************************************************************************
+**  Nombre:         uint64_t nanos(void)
+**  Descripcion:    Retorna los nanosegundos desde el arranque. No desborda en la practica
+**                  (584 anios) y se puede llamar desde interrupciones
+**  Parametros:     Ninguno
+**  Retorno:        Nanosegundos transcurridos
+****************************************************************************************/
+CODIGO_RAPIDO uint64_t nanos(void)
+{
+    return nanosBaseTiempos(&baseTiempos, leerCiclosDWT);
 }
 
 
@@ -171,3 +210,5 @@ void HAL_Delay(uint32_t Delay)
 {
     delay(Delay);
 }
+
+#endif
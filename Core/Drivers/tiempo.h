@@ -48,16 +48,16 @@
 ** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
 extern volatile uint32_t tiempoSysTick;           // Variable que se incrementa cada ms en la interrupcion del systick timer
-extern volatile uint32_t ciclosSysTick;           // Valor del systick en la interrupcion
-extern volatile int32_t sysTickPendiente;
 
 
 /***************************************************************************************
 ** AREA DE PROTOTIPOS DE FUNCION                                                      **
 ****************************************************************************************/
-void iniciarContadorCiclos(void);                // Inicia la variable que dicta los ciclos por microsegundo. Variable utilizada en las funciones de tiempo
+void iniciarContadorCiclos(void);                // Arranca el contador de ciclos y la base de tiempos de micros() y nanos()
+void actualizarBaseTiempos(void);                // Avanza la base de tiempos en cada tick del SysTick
 uint32_t microsISR(void);                        // Retorna los microsegundos cuando se esta ejecutando una interrupcion (maximo 70 minutos)
 uint32_t micros(void);
+uint64_t nanos(void);                            // Marca de tiempo en ns sin desbordamiento
 uint32_t millis(void);
 void delayMicroseconds(uint32_t us);
 void delay(uint32_t ms);
@@ -308,7 +308,7 @@ static const hardwareTimer_t hardwareTimer[] = {
 };
 
 static const hardwareDMAcanalTimer_t hardwareDMAcanalTimer[] = {
-    { .tim = TIM1,  .canal = TIM_CHANNEL_1,  .DMAy_Streamx = DMA2_Stream6,  .canalDMA = DMA_CHANNEL_0,  .dmaTimIrqHandler = DMA2_ST6_HANDLER },
+    { .tim = TIM1,  .canal = TIM_CHANNEL_1,  .DMAy_Streamx = DMA2_Stream1,  .canalDMA = DMA_CHANNEL_6,  .dmaTimIrqHandler = DMA2_ST1_HANDLER },
     { .tim = TIM1,  .canal = TIM_CHANNEL_2,  .DMAy_Streamx = DMA2_Stream2,  .canalDMA = DMA_CHANNEL_6,  .dmaTimIrqHandler = DMA2_ST2_HANDLER },
     { .tim = TIM1,  .canal = TIM_CHANNEL_3,  .DMAy_Streamx = DMA2_Stream6,  .canalDMA = DMA_CHANNEL_6,  .dmaTimIrqHandler = DMA2_ST6_HANDLER },
     { .tim = TIM1,  .canal = TIM_CHANNEL_4,  .DMAy_Streamx = DMA2_Stream4,  .canalDMA = DMA_CHANNEL_6,  .dmaTimIrqHandler = DMA2_ST4_HANDLER },
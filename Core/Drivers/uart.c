@@ -46,7 +46,8 @@
 /***************************************************************************************
 ** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
-static uart_t uart[NUM_MAX_UART];
+// Los buffers los lee y escribe el DMA. En la DTCM no pasan por la cache de datos
+static RAM_RAPIDA_INI uart_t uart[NUM_MAX_UART];
 static configIniUART_t configuracionUART[NUM_MAX_UART];
 
 
@@ -89,6 +90,8 @@ bool iniciarUART(numUART_e numUART, configIniUART_t configInicial, uartRxCallbac
     uart_t *driver = &uart[numUART];
 
 	memset(driver, 0, sizeof(*driver));
+    iniciarBufferAnillo(&driver->anilloRx, driver->rxBuffer, TAMANIO_BUFFER_RX_UART);
+    iniciarBufferAnillo(&driver->anilloTx, driver->txBuffer, TAMANIO_BUFFER_TX_UART);
     resetearContadorErrorUART(numUART);
     driver->iniciado = false;
     driver->rxCallback = rxCall;
@@ -132,10 +135,8 @@ bool ajustarBaudRateUART(numUART_e numUART, uint32_t baudrate)
 	uart_t *driver = &uart[numUART];
 
     // Resetea el Buffer
-    driver->cabezaRxBuffer = 0;
-    driver->colaRxBuffer = 0;
-    driver->cabezaTxBuffer = 0;
-    driver->colaTxBuffer = 0;
+    iniciarBufferAnillo(&driver->anilloRx, driver->rxBuffer, TAMANIO_BUFFER_RX_UART);
+    iniciarBufferAnillo(&driver->anilloTx, driver->txBuffer, TAMANIO_BUFFER_TX_UART);
 
     configuracionUART[numUART].baudrate = baudrate;
     return iniciarDriverUART(numUART, configuracionUART[numUART]);
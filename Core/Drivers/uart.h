@@ -32,6 +32,7 @@
 #include <stdbool.h>
 
 #include "Sistema/plataforma.h"
+#include "Comun/buffer_anillo.h"
 #include "io.h"
 
 
@@ -44,6 +45,7 @@
   #define NUM_MAX_UART               6
 #endif
 
+// Los buffers son anillos de bytes (ver Comun/buffer_anillo.h) con tamanio potencia de 2
 #ifndef TAMANIO_BUFFER_RX_UART
   #define TAMANIO_BUFFER_RX_UART     512
 #endif
@@ -51,6 +53,10 @@
   #define TAMANIO_BUFFER_TX_UART     256
 #endif
 
+#if (TAMANIO_BUFFER_RX_UART & (TAMANIO_BUFFER_RX_UART - 1)) || (TAMANIO_BUFFER_TX_UART & (TAMANIO_BUFFER_TX_UART - 1))
+  #error "El tamanio de los buffers de la UART tiene que ser potencia de 2"
+#endif
+
 
 /***************************************************************************************
 ** AREA DE DEFINICION DE TIPOS                                                        **
@@ -95,8 +101,11 @@ typedef struct {
     bool asignado;
 	UART_HandleTypeDef huart;
 #ifdef USAR_DMA_UART
+    bool usarDMAtx;
+    bool usarDMArx;
     DMA_HandleTypeDef hdmaTx;
     DMA_HandleTypeDef hdmaRx;
+    volatile uint16_t longitudTxDMA;      // Bytes del envio en curso. 0 si el DMA esta libre
 #endif
     uint8_t IRQ;
     uint8_t prioridadIRQ;
@@ -110,12 +119,10 @@ typedef struct {
 	bool iniciado;
     halUART_t hal;
     uartRxCallback rxCallback;
-    volatile uint16_t rxBuffer[TAMANIO_BUFFER_RX_UART];
-    volatile uint16_t txBuffer[TAMANIO_BUFFER_TX_UART];
-    volatile uint16_t cabezaRxBuffer;
-    volatile uint16_t colaRxBuffer;
-    volatile uint16_t cabezaTxBuffer;
-    volatile uint16_t colaTxBuffer;
+    uint8_t rxBuffer[TAMANIO_BUFFER_RX_UART];
+    uint8_t txBuffer[TAMANIO_BUFFER_TX_UART];
+    bufferAnillo_t anilloRx;              // Productor: interrupcion o DMA. Consumidor: tareas o IDLE
+    bufferAnillo_t anilloTx;              // Productor: tareas. Consumidor: interrupcion o DMA
     volatile uint16_t numErrores;
 } uart_t;
 
@@ -139,9 +146,11 @@ uint16_t contadorErrorUART(numUART_e numUART);
 void resetearContadorErrorUART(numUART_e numUART);
 
 void escribirUART(numUART_e numUART, uint8_t byteTx);
-void escribirBufferUART(numUART_e numUART, uint8_t *datoTx, uint16_t longitud);
+uint16_t escribirBufferUART(numUART_e numUART, const uint8_t *datoTx, uint16_t longitud);
 int16_t leerUART(numUART_e numUART);
-void leerBufferUART(numUART_e numUART, int16_t *datoRx, uint16_t longitud);
+uint16_t leerBufferUART(numUART_e numUART, uint8_t *datoRx, uint16_t longitud);
+uint16_t bloqueRecibidoUART(numUART_e numUART, const uint8_t **bloque);
+void consumirBloqueUART(numUART_e numUART, uint16_t longitud);
 uint16_t bytesRecibidosUART(numUART_e numUART);
 bool bufferTxVacioUART(numUART_e numUART);
 uint16_t bytesLibresBufferTxUART(numUART_e numUART);
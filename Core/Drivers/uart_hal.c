@@ -25,12 +25,18 @@
 /***************************************************************************************
 ** AREA DE INCLUDES                                                                   **
 ****************************************************************************************/
+#include <string.h>
+
 #include "uart.h"
 
 #ifdef USAR_UART
 #include "io.h"
 #include "nvic.h"
+#include "dma.h"
 #include "GP/gp_uart.h"
+#if defined(USAR_MOTORES) && defined(USAR_DSHOT)
+#include "Motores/motor.h"
+#endif
 
 
 /***************************************************************************************
@@ -53,6 +59,14 @@
 ****************************************************************************************/
 void handlerIrqUART(numUART_e numUART);
 void habilitarRelojUART(numUART_e numUART);
+void iniciarEnvioUART(uart_t *driver);
+#ifdef USAR_DMA_UART
+bool iniciarDMAuart(numUART_e numUART);
+void actualizarCabezaRxDMAuart(uart_t *driver);
+void irqHandlerDMAuart(descriptorCanalDMA_t *descriptor);
+void finEnvioDMAuart(DMA_HandleTypeDef *hdma);
+void errorEnvioDMAuart(DMA_HandleTypeDef *hdma);
+#endif
 
 
 /***************************************************************************************
@@ -85,6 +99,17 @@ bool iniciarDriverUART(numUART_e numUART, configIniUART_t configInicial)
 
     HAL_NVIC_DisableIRQ(driver->hal.IRQ);
 
+#ifdef USAR_DMA_UART
+    // Paramos los DMA en curso antes de reconfigurar (cambio de baudrate)
+    if (driver->hal.hdmaRx.State == HAL_DMA_STATE_BUSY)
+        HAL_DMA_Abort(&driver->hal.hdmaRx);
+
+    if (driver->hal.hdmaTx.State == HAL_DMA_STATE_BUSY)
+        HAL_DMA_Abort(&driver->hal.hdmaTx);
+
+    driver->hal.longitudTxDMA = 0;
+#endif
+
     // Configuramos el dispositivo
     driver->hal.huart.Init.BaudRate = configInicial.baudrate;
     if (configInicial.paridad == UART_PARIDAD_EVEN || configInicial.lWord == UART_LONGITUD_WORD_9)
@@ -117,6 +142,11 @@ bool iniciarDriverUART(numUART_e numUART, configIniUART_t configInicial)
         return false;
 
 
+#ifdef USAR_DMA_UART
+    if (!iniciarDMAuart(numUART))
+        return false;
+#endif
+
     HAL_NVIC_SetPriority(driver->hal.IRQ, PRIORIDAD_BASE_NVIC(driver->hal.prioridadIRQ), PRIORIDAD_SUB_NVIC(driver->hal.prioridadIRQ));
     HAL_NVIC_EnableIRQ(driver->hal.IRQ);
 
@@ -128,6 +158,19 @@ bool iniciarDriverUART(numUART_e numUART, configIniUART_t configInicial)
     // Habilitamos la interrupcion por error de: (Frame error, noise error, overrun error)
     __HAL_UART_ENABLE_IT(&driver->hal.huart, UART_IT_ERR);
 
+#ifdef USAR_DMA_UART
+    if (driver->hal.usarDMArx) {
+        // El DMA llena el buffer sin interrupciones. Con callback se entregan los bytes
+        // cuando la linea queda inactiva, una vez por trama en lugar de una por byte
+        if (driver->rxCallback != NULL) {
+            __HAL_UART_CLEAR_IT(&driver->hal.huart, UART_CLEAR_IDLEF);
+            __HAL_UART_ENABLE_IT(&driver->hal.huart, UART_IT_IDLE);
+        }
+
+        return true;
+    }
+#endif
+
     // Habilitamos la interrupcion de registro de datos recibidos no vacio
     __HAL_UART_ENABLE_IT(&driver->hal.huart, UART_IT_RXNE);
 
@@ -135,6 +178,136 @@ bool iniciarDriverUART(numUART_e numUART, configIniUART_t configInicial)
 }
 
 
+#ifdef USAR_DMA_UART
+/***************************************************************************************
+**  Nombre:         bool iniciarDMAuart(numUART_e numUART)
+**  Descripcion:    Configura la recepcion circular y el envio por DMA de la UART
+**  Parametros:     Dispositivo
+**  Retorno:        True si ok
+****************************************************************************************/
+bool iniciarDMAuart(numUART_e numUART)
+{
+    uart_t *driver = punteroUART(numUART);
+
+#if defined(USAR_MOTORES) && defined(USAR_DSHOT)
+    // Los motores se inician despues y con DShot por canal sus timers ocupan streams del DMA1
+    if (driver->hal.usarDMArx && dshotPorCanalMotores() && identificadorDMA(driver->hal.hdmaRx.Instance) <= DMA1_ST7_HANDLER)
+        driver->hal.usarDMArx = false;
+#endif
+
+    // Con el stream ocupado por otro periferico se usan las interrupciones de la UART
+    if (driver->hal.usarDMArx && !reservarDMA(identificadorDMA(driver->hal.hdmaRx.Instance), DMA_UART_RX, numUART))
+        driver->hal.usarDMArx = false;
+
+    if (driver->hal.usarDMAtx && !reservarDMA(identificadorDMA(driver->hal.hdmaTx.Instance), DMA_UART_TX, numUART))
+        driver->hal.usarDMAtx = false;
+
+    if (driver->hal.usarDMArx) {
+        iniciarDMA(identificadorDMA(driver->hal.hdmaRx.Instance));
+
+        driver->hal.hdmaRx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+        driver->hal.hdmaRx.Init.PeriphInc = DMA_PINC_DISABLE;
+        driver->hal.hdmaRx.Init.MemInc = DMA_MINC_ENABLE;
+        driver->hal.hdmaRx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+        driver->hal.hdmaRx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+        driver->hal.hdmaRx.Init.Mode = DMA_CIRCULAR;
+        driver->hal.hdmaRx.Init.Priority = DMA_PRIORITY_MEDIUM;
+        driver->hal.hdmaRx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+
+        if (HAL_DMA_Init(&driver->hal.hdmaRx) != HAL_OK)
+            return false;
+
+        // La cabeza del anillo se calcula con los bytes que le quedan al DMA hasta dar la vuelta
+        iniciarBufferAnillo(&driver->anilloRx, driver->rxBuffer, TAMANIO_BUFFER_RX_UART);
+        if (HAL_DMA_Start(&driver->hal.hdmaRx, (uint32_t)&driver->hal.huart.Instance->RDR, (uint32_t)driver->rxBuffer, TAMANIO_BUFFER_RX_UART) != HAL_OK)
+            return false;
+
+        SET_BIT(driver->hal.huart.Instance->CR3, USART_CR3_DMAR);
+    }
+
+    if (driver->hal.usarDMAtx) {
+        iniciarDMA(identificadorDMA(driver->hal.hdmaTx.Instance));
+
+        driver->hal.hdmaTx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+        driver->hal.hdmaTx.Init.PeriphInc = DMA_PINC_DISABLE;
+        driver->hal.hdmaTx.Init.MemInc = DMA_MINC_ENABLE;
+        driver->hal.hdmaTx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+        driver->hal.hdmaTx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+        driver->hal.hdmaTx.Init.Mode = DMA_NORMAL;
+        driver->hal.hdmaTx.Init.Priority = DMA_PRIORITY_MEDIUM;
+        driver->hal.hdmaTx.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+
+        if (HAL_DMA_Init(&driver->hal.hdmaTx) != HAL_OK)
+            return false;
+
+        driver->hal.hdmaTx.Parent = driver;
+        driver->hal.hdmaTx.XferCpltCallback = finEnvioDMAuart;
+        driver->hal.hdmaTx.XferErrorCallback = errorEnvioDMAuart;
+
+        ajustarHandlerDMA(identificadorDMA(driver->hal.hdmaTx.Instance), irqHandlerDMAuart, driver->hal.prioridadIRQ, (uint32_t)&driver->hal.hdmaTx);
+        SET_BIT(driver->hal.huart.Instance->CR3, USART_CR3_DMAT);
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void actualizarCabezaRxDMAuart(uart_t *driver)
+**  Descripcion:    Publica en el anillo de recepcion lo escrito por el DMA segun su contador
+**  Parametros:     Driver
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void actualizarCabezaRxDMAuart(uart_t *driver)
+{
+    sincronizarCabezaBufferAnillo(&driver->anilloRx, TAMANIO_BUFFER_RX_UART - __HAL_DMA_GET_COUNTER(&driver->hal.hdmaRx));
+}
+
+
+/***************************************************************************************
+**  Nombre:         void irqHandlerDMAuart(descriptorCanalDMA_t *descriptor)
+**  Descripcion:    Interrupcion del stream de envio
+**  Parametros:     Descriptor del canal
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void irqHandlerDMAuart(descriptorCanalDMA_t *descriptor)
+{
+    HAL_DMA_IRQHandler((DMA_HandleTypeDef *)descriptor->paramUsuario);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void finEnvioDMAuart(DMA_HandleTypeDef *hdma)
+**  Descripcion:    Libera el tramo enviado del buffer y lanza el siguiente
+**  Parametros:     Handle del DMA de envio
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void finEnvioDMAuart(DMA_HandleTypeDef *hdma)
+{
+    uart_t *driver = (uart_t *)hdma->Parent;
+
+    consumirBufferAnillo(&driver->anilloTx, driver->hal.longitudTxDMA);
+    driver->hal.longitudTxDMA = 0;
+    iniciarEnvioUART(driver);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void errorEnvioDMAuart(DMA_HandleTypeDef *hdma)
+**  Descripcion:    Descarta el tramo que fallaba y sigue con el resto del buffer
+**  Parametros:     Handle del DMA de envio
+**  Retorno:        Ninguno
+****************************************************************************************/
+void errorEnvioDMAuart(DMA_HandleTypeDef *hdma)
+{
+    uart_t *driver = (uart_t *)hdma->Parent;
+
+    errorCallbackUART((numUART_e)(driver - punteroUART(UART_1)));
+    finEnvioDMAuart(hdma);
+}
+#endif
+
+
 /***************************************************************************************
 **  Nombre:         void flushUART(numUART_e numUART)
 **  Descripcion:    Borra el Buffer de recepcion de la UART
@@ -145,11 +318,13 @@ CODIGO_RAPIDO void flushUART(numUART_e numUART)
 {
     uart_t *driver = punteroUART(numUART);
 
-    driver->colaRxBuffer = 0;
-    driver->cabezaRxBuffer = 0;
+#ifdef USAR_DMA_UART
+    // El DMA sigue escribiendo en su posicion. Se descarta lo recibido hasta ahora
+    if (driver->hal.usarDMArx)
+        actualizarCabezaRxDMAuart(driver);
+#endif
 
-    for (uint16_t i = 0; i < TAMANIO_BUFFER_RX_UART; i++)
-    	driver->rxBuffer[i] = 0;
+    vaciarBufferAnillo(&driver->anilloRx);
 }
 
 
@@ -163,24 +338,62 @@ CODIGO_RAPIDO void escribirUART(numUART_e numUART, uint8_t byteTx)
 {
     uart_t *driver = punteroUART(numUART);
 
-    driver->txBuffer[driver->cabezaTxBuffer] = byteTx;
-    driver->cabezaTxBuffer = (driver->cabezaTxBuffer + 1) % TAMANIO_BUFFER_TX_UART;
-
-    // Habilitamos la interrupcion par registro de datos de transmision vacio
-    __HAL_UART_ENABLE_IT(&driver->hal.huart, UART_IT_TXE);
+    if (escribirBufferAnillo(&driver->anilloTx, &byteTx, 1) != 0)
+        iniciarEnvioUART(driver);
 }
 
 
 /***************************************************************************************
-**  Nombre:         void escribirBufferUART(numUART_e numUART, uint8_t *datoTx, uint16_t longitud)
-**  Descripcion:    Escribe un buffer en la UART
+**  Nombre:         uint16_t escribirBufferUART(numUART_e numUART, const uint8_t *datoTx, uint16_t longitud)
+**  Descripcion:    Escribe un buffer en la UART. Se copia al anillo en como mucho dos tramos
+**                  y se lanza el envio una sola vez. Lo que no cabe en el espacio libre no
+**                  se copia, para no pisar los bytes pendientes de enviar
 **  Parametros:     Dispositivo, buffer, longitud del buffer
+**  Retorno:        Bytes aceptados
+****************************************************************************************/
+CODIGO_RAPIDO uint16_t escribirBufferUART(numUART_e numUART, const uint8_t *datoTx, uint16_t longitud)
+{
+    uart_t *driver = punteroUART(numUART);
+
+    longitud = escribirBufferAnillo(&driver->anilloTx, datoTx, longitud);
+    if (longitud != 0)
+        iniciarEnvioUART(driver);
+
+    return longitud;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void iniciarEnvioUART(uart_t *driver)
+**  Descripcion:    Arranca el envio de lo pendiente en el buffer si la UART esta parada.
+**                  Con DMA se envia el tramo contiguo mas largo desde la cola
+**  Parametros:     Driver
 **  Retorno:        Ninguno
 ****************************************************************************************/
-CODIGO_RAPIDO void escribirBufferUART(numUART_e numUART, uint8_t *datoTx, uint16_t longitud)
+CODIGO_RAPIDO void iniciarEnvioUART(uart_t *driver)
 {
-    for (uint16_t i = 0; i < longitud; i++)
-        escribirUART(numUART, datoTx[i]);
+#ifdef USAR_DMA_UART
+    if (driver->hal.usarDMAtx) {
+        // El fin del DMA en curso vuelve a llamar a esta funcion con la cabeza actualizada
+        if (driver->hal.longitudTxDMA != 0)
+            return;
+
+        const uint8_t *bloque;
+        const uint16_t longitud = bloqueBufferAnillo(&driver->anilloTx, &bloque);
+
+        if (longitud == 0)
+            return;
+
+        driver->hal.longitudTxDMA = longitud;
+        if (HAL_DMA_Start_IT(&driver->hal.hdmaTx, (uint32_t)bloque, (uint32_t)&driver->hal.huart.Instance->TDR, longitud) != HAL_OK)
+            driver->hal.longitudTxDMA = 0;
+
+        return;
+    }
+#endif
+
+    // Habilitamos la interrupcion par registro de datos de transmision vacio
+    __HAL_UART_ENABLE_IT(&driver->hal.huart, UART_IT_TXE);
 }
 
 
@@ -192,34 +405,77 @@ CODIGO_RAPIDO void escribirBufferUART(numUART_e numUART, uint8_t *datoTx, uint16
 ****************************************************************************************/
 CODIGO_RAPIDO int16_t leerUART(numUART_e numUART)
 {
-    int16_t byteRx;
-    uart_t *driver = punteroUART(numUART);
+    const uint8_t *bloque;
 
-    if (driver->cabezaRxBuffer != driver->colaRxBuffer) {
-        byteRx = driver->rxBuffer[driver->colaRxBuffer];
+    if (bloqueRecibidoUART(numUART, &bloque) == 0)
+        return -1;
 
-        if (driver->colaRxBuffer + 1 >= TAMANIO_BUFFER_RX_UART)
-        	driver->colaRxBuffer = 0;
-        else
-        	driver->colaRxBuffer++;
+    const int16_t byteRx = *bloque;
+    consumirBloqueUART(numUART, 1);
+    return byteRx;
+}
 
-        return byteRx;
+
+/***************************************************************************************
+**  Nombre:         uint16_t leerBufferUART(numUART_e numUART, uint8_t *datoRx, uint16_t longitud)
+**  Descripcion:    Copia en el buffer los bytes recibidos, como mucho la longitud indicada
+**  Parametros:     Dispositivo, buffer, longitud del buffer
+**  Retorno:        Numero de bytes leidos
+****************************************************************************************/
+CODIGO_RAPIDO uint16_t leerBufferUART(numUART_e numUART, uint8_t *datoRx, uint16_t longitud)
+{
+    const uint8_t *bloque;
+    uint16_t leidos = 0;
+
+    // Como mucho dos tramos: hasta el final del anillo y desde el principio
+    while (leidos < longitud) {
+        uint16_t numBytes = bloqueRecibidoUART(numUART, &bloque);
+
+        if (numBytes == 0)
+            break;
+
+        if (numBytes > longitud - leidos)
+            numBytes = longitud - leidos;
+
+        memcpy(&datoRx[leidos], bloque, numBytes);
+        consumirBloqueUART(numUART, numBytes);
+        leidos += numBytes;
     }
-    else
-      return -1;
+
+    return leidos;
 }
 
 
 /***************************************************************************************
-**  Nombre:         void leerBufferUART(numUART_e numUART, int16_t *datoRx, uint16_t longitud)
-**  Descripcion:    Lee un buffer de la UART
-**  Parametros:     Dispositivo, buffer, longitud del buffer
+**  Nombre:         uint16_t bloqueRecibidoUART(numUART_e numUART, const uint8_t **bloque)
+**  Descripcion:    Da acceso sin copia al tramo contiguo de bytes recibidos desde la cola.
+**                  Si los datos dan la vuelta al anillo el resto se obtiene tras consumir
+**                  este tramo
+**  Parametros:     Dispositivo, puntero al inicio del tramo
+**  Retorno:        Numero de bytes del tramo
+****************************************************************************************/
+CODIGO_RAPIDO uint16_t bloqueRecibidoUART(numUART_e numUART, const uint8_t **bloque)
+{
+    uart_t *driver = punteroUART(numUART);
+
+#ifdef USAR_DMA_UART
+    if (driver->hal.usarDMArx)
+        actualizarCabezaRxDMAuart(driver);
+#endif
+
+    return bloqueBufferAnillo(&driver->anilloRx, bloque);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void consumirBloqueUART(numUART_e numUART, uint16_t longitud)
+**  Descripcion:    Libera los bytes procesados del tramo devuelto por bloqueRecibidoUART
+**  Parametros:     Dispositivo, bytes procesados
 **  Retorno:        Ninguno
 ****************************************************************************************/
-CODIGO_RAPIDO void leerBufferUART(numUART_e numUART, int16_t *datoRx, uint16_t longitud)
+CODIGO_RAPIDO void consumirBloqueUART(numUART_e numUART, uint16_t longitud)
 {
-    for (uint16_t i = 0; i < longitud; i++)
-        datoRx[i] = leerUART(numUART);
+    consumirBufferAnillo(&punteroUART(numUART)->anilloRx, longitud);
 }
 
 
@@ -233,10 +489,12 @@ CODIGO_RAPIDO uint16_t bytesRecibidosUART(numUART_e numUART)
 {
     uart_t *driver = punteroUART(numUART);
 
-    if (driver->cabezaRxBuffer >= driver->colaRxBuffer)
-        return driver->cabezaRxBuffer - driver->colaRxBuffer;
-    else
-        return TAMANIO_BUFFER_RX_UART + driver->cabezaRxBuffer - driver->colaRxBuffer;
+#ifdef USAR_DMA_UART
+    if (driver->hal.usarDMArx)
+        actualizarCabezaRxDMAuart(driver);
+#endif
+
+    return bytesOcupadosBufferAnillo(&driver->anilloRx);
 }
 
 
@@ -248,8 +506,7 @@ CODIGO_RAPIDO uint16_t bytesRecibidosUART(numUART_e numUART)
 ****************************************************************************************/
 CODIGO_RAPIDO bool bufferTxVacioUART(numUART_e numUART)
 {
-    uart_t *driver = punteroUART(numUART);
-    return driver->colaTxBuffer == driver->cabezaTxBuffer;
+    return bytesOcupadosBufferAnillo(&punteroUART(numUART)->anilloTx) == 0;
 }
 
 
@@ -261,12 +518,7 @@ CODIGO_RAPIDO bool bufferTxVacioUART(numUART_e numUART)
 ****************************************************************************************/
 CODIGO_RAPIDO uint16_t bytesLibresBufferTxUART(numUART_e numUART)
 {
-    uart_t *driver = punteroUART(numUART);
-
-    if (driver->cabezaTxBuffer >= driver->colaTxBuffer)
-        return TAMANIO_BUFFER_TX_UART - 1 - driver->cabezaTxBuffer + driver->colaTxBuffer;
-
-    return driver->colaTxBuffer - driver->cabezaTxBuffer - 1;
+    return bytesLibresBufferAnillo(&punteroUART(numUART)->anilloTx);
 }
 
 
@@ -280,16 +532,23 @@ CODIGO_RAPIDO void handlerIrqUART(numUART_e numUART)
 {
     uart_t *driver = punteroUART(numUART);
 
+#ifdef USAR_DMA_UART
+    // Linea inactiva con recepcion por DMA: se entrega la trama al callback -------------
+    if (__HAL_UART_GET_IT(&driver->hal.huart, UART_IT_IDLE) != RESET && __HAL_UART_GET_IT_SOURCE(&driver->hal.huart, UART_IT_IDLE) != RESET) {
+        __HAL_UART_CLEAR_IT(&driver->hal.huart, UART_CLEAR_IDLEF);
+        actualizarCabezaRxDMAuart(driver);
+        entregarBufferAnillo(&driver->anilloRx, driver->rxCallback);
+    }
+#endif
+
     // UART en modo recepcion ----------------------------------------------------------
-    if ((__HAL_UART_GET_IT(&driver->hal.huart, UART_IT_RXNE) != RESET)) {
+    if (__HAL_UART_GET_IT(&driver->hal.huart, UART_IT_RXNE) != RESET && __HAL_UART_GET_IT_SOURCE(&driver->hal.huart, UART_IT_RXNE) != RESET) {
         uint8_t rxByte = (uint8_t)(driver->hal.huart.Instance->RDR & (uint8_t) 0xff);
 
         if (driver->rxCallback)
             driver->rxCallback(rxByte);
-        else {
-            driver->rxBuffer[driver->cabezaRxBuffer] = rxByte;
-            driver->cabezaRxBuffer = (driver->cabezaRxBuffer + 1) % TAMANIO_BUFFER_RX_UART;
-        }
+        else
+            escribirBufferAnillo(&driver->anilloRx, &rxByte, 1);
 
         CLEAR_BIT(driver->hal.huart.Instance->CR1, (USART_CR1_PEIE));
         CLEAR_BIT(driver->hal.huart.Instance->CR3, USART_CR3_EIE);
@@ -322,9 +581,11 @@ CODIGO_RAPIDO void handlerIrqUART(numUART_e numUART)
     }
 
     // UART en modo transmision ----------------------------------------------------------
-    if (__HAL_UART_GET_IT(&driver->hal.huart, UART_IT_TXE) != RESET) {
+    if (__HAL_UART_GET_IT(&driver->hal.huart, UART_IT_TXE) != RESET && __HAL_UART_GET_IT_SOURCE(&driver->hal.huart, UART_IT_TXE) != RESET) {
+
+        const uint8_t *bloque;
 
-        if (driver->colaTxBuffer == driver->cabezaTxBuffer) {
+        if (bloqueBufferAnillo(&driver->anilloTx, &bloque) == 0) {
         	driver->hal.huart.TxXferCount = 0;
             // Deshabilitamos la interrupcion por TDR vacio
             __HAL_UART_DISABLE_IT(&driver->hal.huart, UART_IT_TXE);
@@ -333,12 +594,8 @@ CODIGO_RAPIDO void handlerIrqUART(numUART_e numUART)
             __HAL_UART_ENABLE_IT(&driver->hal.huart, UART_IT_TC);
         }
         else {
-            if ((driver->hal.huart.Init.WordLength == UART_WORDLENGTH_9B) && (driver->hal.huart.Init.Parity == UART_PARITY_NONE))
-            	driver->hal.huart.Instance->TDR = (((uint16_t) driver->txBuffer[driver->colaTxBuffer]) & (uint16_t) 0x01FFU);
-            else
-            	driver->hal.huart.Instance->TDR = (uint8_t)(driver->txBuffer[driver->colaTxBuffer]);
-
-            driver->colaTxBuffer = (driver->colaTxBuffer + 1) % TAMANIO_BUFFER_TX_UART;
+            driver->hal.huart.Instance->TDR = *bloque;
+            consumirBufferAnillo(&driver->anilloTx, 1);
         }
     }
 
@@ -269,7 +269,8 @@ static const hardwareUART_t hardwareUART[NUM_MAX_UART] = {
 ****************************************************************************************/
 bool comprobarConfigHardwareUART(numUART_e numUART);
 bool comprobarPinUART(numUART_e numUART, uint8_t pin);
-bool comprobarStreamDMAuart(numUART_e numUART, DMA_Stream_TypeDef *DMAy_Streamx);
+bool comprobarStreamDMAuart(const canalStreamDMA_t *tabla, DMA_Stream_TypeDef *DMAy_Streamx);
+uint32_t canalStreamDMAuart(const canalStreamDMA_t *tabla, DMA_Stream_TypeDef *DMAy_Streamx);
 bool pinUART(numUART_e numUART, uint8_t pinBusqueda, pin_t *pinDriver);
 
 
@@ -304,6 +305,26 @@ bool asignarHALuart(numUART_e numUART)
     driver->hal.IRQ = hardwareUART[numUART].IRQ;
     driver->hal.prioridadIRQ = hardwareUART[numUART].prioridadIRQ;
 
+#ifdef USAR_DMA_UART
+    // Asignamos el DMA. Cada sentido sin stream configurado funciona por interrupciones
+    driver->hal.usarDMAtx = false;
+    driver->hal.usarDMArx = false;
+
+    if (configUART(numUART)->usarDMA) {
+        if (configUART(numUART)->dmaTx != NULL) {
+            driver->hal.hdmaTx.Instance = configUART(numUART)->dmaTx;
+            driver->hal.hdmaTx.Init.Channel = canalStreamDMAuart(hardwareUART[numUART].dmaTx, configUART(numUART)->dmaTx);
+            driver->hal.usarDMAtx = true;
+        }
+
+        if (configUART(numUART)->dmaRx != NULL) {
+            driver->hal.hdmaRx.Instance = configUART(numUART)->dmaRx;
+            driver->hal.hdmaRx.Init.Channel = canalStreamDMAuart(hardwareUART[numUART].dmaRx, configUART(numUART)->dmaRx);
+            driver->hal.usarDMArx = true;
+        }
+    }
+#endif
+
     return true;
 }
 
@@ -324,10 +345,10 @@ bool comprobarConfigHardwareUART(numUART_e numUART)
 
 #ifdef USAR_DMA_UART
     if (configUART(numUART)->usarDMA) {
-        if (!comprobarStreamDMAuart(numUART, configUART(numUART)->dmaTx))
+        if (configUART(numUART)->dmaTx != NULL && !comprobarStreamDMAuart(hardwareUART[numUART].dmaTx, configUART(numUART)->dmaTx))
             return false;
 
-        if (!comprobarStreamDMAuart(numUART, configUART(numUART)->dmaRx))
+        if (configUART(numUART)->dmaRx != NULL && !comprobarStreamDMAuart(hardwareUART[numUART].dmaRx, configUART(numUART)->dmaRx))
             return false;
     }
 #endif
@@ -354,15 +375,15 @@ bool comprobarPinUART(numUART_e numUART, uint8_t pin)
 
 
 /***************************************************************************************
-**  Nombre:         bool comprobarStreamDMAuart(numUART_e numUART, DMA_Stream_TypeDef *DMAy_Streamx)
+**  Nombre:         bool comprobarStreamDMAuart(const canalStreamDMA_t *tabla, DMA_Stream_TypeDef *DMAy_Streamx)
 **  Descripcion:    Comprueba si el DMA asignado es correcto
-**  Parametros:     Numero del driver, DMA configurado
+**  Parametros:     Tabla de streams validos, DMA configurado
 **  Retorno:        True si ok
 ****************************************************************************************/
-bool comprobarStreamDMAuart(numUART_e numUART, DMA_Stream_TypeDef *DMAy_Streamx)
+bool comprobarStreamDMAuart(const canalStreamDMA_t *tabla, DMA_Stream_TypeDef *DMAy_Streamx)
 {
     for (uint8_t i = 0; i < NUM_STREAMS_DMA_UART; i++) {
-        if (DMAy_Streamx == hardwareUART[numUART].dmaTx[i].DMAy_Streamx || DMAy_Streamx == hardwareUART[numUART].dmaRx[i].DMAy_Streamx)
+        if (tabla[i].DMAy_Streamx != NULL && tabla[i].DMAy_Streamx == DMAy_Streamx)
             return true;
     }
 
@@ -370,6 +391,23 @@ bool comprobarStreamDMAuart(numUART_e numUART, DMA_Stream_TypeDef *DMAy_Streamx)
 }
 
 
+/***************************************************************************************
+**  Nombre:         uint32_t canalStreamDMAuart(const canalStreamDMA_t *tabla, DMA_Stream_TypeDef *DMAy_Streamx)
+**  Descripcion:    Devuelve el canal del DMA asociado al stream
+**  Parametros:     Tabla de streams validos, DMA configurado
+**  Retorno:        Canal del DMA
+****************************************************************************************/
+uint32_t canalStreamDMAuart(const canalStreamDMA_t *tabla, DMA_Stream_TypeDef *DMAy_Streamx)
+{
+    for (uint8_t i = 0; i < NUM_STREAMS_DMA_UART; i++) {
+        if (tabla[i].DMAy_Streamx == DMAy_Streamx)
+            return tabla[i].canal;
+    }
+
+    return 0;
+}
+
+
 /***************************************************************************************
 **  Nombre:         bool pinUART(numUART_e numUART, uint8_t pinBusqueda, pin_t *pinDriver)
 **  Descripcion:    Encuentra el pin de la tabla de hardware
@@ -86,6 +86,7 @@ bool iniciarUSB(void)
 
 	memset(driver, 0, sizeof(*driver));
     driver->iniciado = false;
+    iniciarBufferAnillo(&driver->anilloTx, driver->txBuffer, TAMANIO_BUFFER_TX_USB);
 
     if (iniciarDriverUSB()) {
     	driver->iniciado = true;
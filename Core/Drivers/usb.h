@@ -33,6 +33,7 @@
 
 #include "Sistema/plataforma.h"
 #include "io.h"
+#include "Comun/buffer_anillo.h"
 #include "usbd_def.h"
 #include "usbd_cdc.h"
 
@@ -47,6 +48,10 @@
   #define TAMANIO_BUFFER_TX_USB     2048
 #endif
 
+#if (TAMANIO_BUFFER_TX_USB & (TAMANIO_BUFFER_TX_USB - 1)) != 0
+  #error "TAMANIO_BUFFER_TX_USB debe ser potencia de 2"
+#endif
+
 
 /***************************************************************************************
 ** AREA DE DEFINICION DE TIPOS                                                        **
@@ -67,9 +72,9 @@ typedef struct {
     bool puertoAbierto;
     uint8_t recepcion[TAMANIO_BUFFER_RX_USB];
     volatile uint8_t rxBuffer[TAMANIO_BUFFER_RX_USB];
-    volatile uint8_t txBuffer[TAMANIO_BUFFER_TX_USB];
-    volatile uint32_t cabezaTxBuffer;
-    volatile uint32_t colaTxBuffer;
+    uint8_t txBuffer[TAMANIO_BUFFER_TX_USB];
+    bufferAnillo_t anilloTx;              // Productor: tareas. Consumidor: timer de envio
+    uint32_t longitudTx;                  // Bytes entregados al endpoint en curso
     uint32_t cabezaRxBuffer;
     uint32_t colaRxBuffer;
 } usb_t;
@@ -94,7 +99,9 @@ bool usbConfigurado(void);
 bool usbConectado(void);
 
 void escribirUSB(uint8_t byteTx);
-void escribirBufferUSB(uint8_t *datoTx, uint32_t longitud);
+uint32_t escribirBufferUSB(const uint8_t *datoTx, uint32_t longitud);
+uint32_t reservarBufferTxUSB(uint8_t **bloque, uint32_t longitud);
+void publicarBufferTxUSB(uint32_t longitud);
 int16_t leerUSB(void);
 void leerBufferUSB(int16_t *datoRx, uint16_t longitud);
 void flushUSB(void);
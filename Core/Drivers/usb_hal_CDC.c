@@ -109,7 +109,7 @@ int8_t iniciarCDC(void)
     configurarBaseTiempoTimer(configUSB()->timer, true, periodo, hz);
     asignarCallbackPeriodoTimer(configUSB()->timer, enviarDatoUSB);
 
-    USBD_CDC_SetTxBuffer(&driver->hal.hUSB, (uint8_t *)driver->txBuffer, 0);
+    USBD_CDC_SetTxBuffer(&driver->hal.hUSB, driver->txBuffer, 0);
     USBD_CDC_SetRxBuffer(&driver->hal.hUSB, (uint8_t *)driver->recepcion);
 
     return USBD_OK;
@@ -245,28 +245,51 @@ int8_t transmisionCompletaCDC(uint8_t *buff, uint32_t *lon, uint8_t epNum)
 ****************************************************************************************/
 CODIGO_RAPIDO void escribirUSB(uint8_t byteTx)
 {
-	usb_t *driver = punteroUSB();
+    escribirBufferUSB(&byteTx, 1);
+}
+
 
+/***************************************************************************************
+**  Nombre:         uint32_t escribirBufferUSB(const uint8_t *datoTx, uint32_t longitud)
+**  Descripcion:    Envia un buffer por el USB. Se copia de una vez al anillo de transmision
+**                  y lo que no cabe se descarta. Solo se puede llamar desde las tareas
+**  Parametros:     Datos a enviar, longitud de los datos
+**  Retorno:        Bytes encolados
+****************************************************************************************/
+CODIGO_RAPIDO uint32_t escribirBufferUSB(const uint8_t *datoTx, uint32_t longitud)
+{
     if (!(usbConectado() && usbConfigurado() && usbAbierto()))
-        return;
+        return 0;
 
-    BLOQUE_ATOMICO(NVIC_PRIO_USB) {
-        driver->txBuffer[driver->cabezaTxBuffer] = byteTx;
-        driver->cabezaTxBuffer = (driver->cabezaTxBuffer + 1) % TAMANIO_BUFFER_TX_USB;
-    }
+    return escribirBufferAnillo(&punteroUSB()->anilloTx, datoTx, longitud);
 }
 
 
 /***************************************************************************************
-**  Nombre:         void escribirBufferUSB(uint8_t *datoTx, uint32_t longitud)
-**  Descripcion:    Envia un buffer por el USB
-**  Parametros:     Datos a enviar, longitud de los datos
+**  Nombre:         uint32_t reservarBufferTxUSB(uint8_t **bloque, uint32_t longitud)
+**  Descripcion:    Da un tramo contiguo del anillo de transmision para componer los datos
+**                  directamente en el. Se envian al llamar a publicarBufferTxUSB
+**  Parametros:     Puntero al tramo, bytes que se quieren escribir
+**  Retorno:        Bytes disponibles en el tramo (0 si el puerto no esta abierto)
+****************************************************************************************/
+CODIGO_RAPIDO uint32_t reservarBufferTxUSB(uint8_t **bloque, uint32_t longitud)
+{
+    if (!(usbConectado() && usbConfigurado() && usbAbierto()))
+        return 0;
+
+    return reservarBufferAnillo(&punteroUSB()->anilloTx, bloque, longitud);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void publicarBufferTxUSB(uint32_t longitud)
+**  Descripcion:    Encola los bytes escritos en el tramo reservado
+**  Parametros:     Bytes escritos
 **  Retorno:        Ninguno
 ****************************************************************************************/
-CODIGO_RAPIDO void escribirBufferUSB(uint8_t *datoTx, uint32_t longitud)
+CODIGO_RAPIDO void publicarBufferTxUSB(uint32_t longitud)
 {
-    for (uint16_t i = 0; i < longitud; i++)
-        escribirUSB(datoTx[i]);
+    publicarBufferAnillo(&punteroUSB()->anilloTx, longitud);
 }
 
 
@@ -357,14 +380,7 @@ CODIGO_RAPIDO uint32_t bytesRecibidosUSB(void)
 ****************************************************************************************/
 CODIGO_RAPIDO bool bufferTxVacioUSB(void)
 {
-	usb_t *driver = punteroUSB();
-    bool bufVacio;
-
-	BLOQUE_ATOMICO(NVIC_PRIO_USB) {
-		bufVacio = driver->colaTxBuffer == driver->cabezaTxBuffer;
-	}
-
-    return bufVacio;
+    return bytesOcupadosBufferAnillo(&punteroUSB()->anilloTx) == 0;
 }
 
 
@@ -376,62 +392,40 @@ CODIGO_RAPIDO bool bufferTxVacioUSB(void)
 ****************************************************************************************/
 CODIGO_RAPIDO uint32_t bytesLibresBufferTxUSB(void)
 {
-	usb_t *driver = punteroUSB();
-
-    if (driver->cabezaTxBuffer >= driver->colaTxBuffer)
-        return TAMANIO_BUFFER_TX_USB - 1 - driver->cabezaTxBuffer + driver->colaTxBuffer;
-
-    return driver->colaTxBuffer - driver->cabezaTxBuffer - 1;
+    return bytesLibresBufferAnillo(&punteroUSB()->anilloTx);
 }
 
 
 /***************************************************************************************
 **  Nombre:         void enviarDatoUSB(void)
-**  Descripcion:    Envia datos por el USB
+**  Descripcion:    Entrega al endpoint el tramo contiguo pendiente del anillo, sin copias
 **  Parametros:     Ninguno
 **  Retorno:        Ninguno
 ****************************************************************************************/
 CODIGO_RAPIDO void enviarDatoUSB(void)
 {
-    uint32_t tamBuff;
-    static uint32_t ultimoTamBuff = 0;
-
     usb_t *driver = punteroUSB();
     USBD_CDC_HandleTypeDef *hcdc = (USBD_CDC_HandleTypeDef*)driver->hal.hUSB.pClassData;
+    const uint8_t *bloque;
 
-    if (hcdc->TxState == 0) {
-        // El endpoint ha terminado transmitiendo el bloque previo
-        if (ultimoTamBuff) {
-            bool needZeroLengthPacket = ultimoTamBuff % 64 == 0;
-
-            // Mueve la cola del bufer de anillo en funcion de la transmision exitosa anterior
-            driver->colaTxBuffer += ultimoTamBuff;
-            if (driver->colaTxBuffer == TAMANIO_BUFFER_TX_USB)
-            	driver->colaTxBuffer = 0;
-
-            ultimoTamBuff = 0;
-
-            if (needZeroLengthPacket) {
-                USBD_CDC_SetTxBuffer(&driver->hal.hUSB, (uint8_t*)&driver->txBuffer[driver->colaTxBuffer], 0);
-                return;
-            }
-        }
+    if (hcdc->TxState != 0)
+        return;
 
-        if (driver->colaTxBuffer != driver->cabezaTxBuffer) {
-            if (driver->colaTxBuffer > driver->cabezaTxBuffer)
-            	tamBuff = TAMANIO_BUFFER_TX_USB - driver->colaTxBuffer;
-            else
-            	tamBuff = driver->cabezaTxBuffer - driver->colaTxBuffer;
+    // El endpoint ha terminado el bloque previo. El paquete vacio de cierre cuando la
+    // longitud es multiplo de 64 lo envia la clase CDC antes de liberar TxState
+    if (driver->longitudTx) {
+        consumirBufferAnillo(&driver->anilloTx, driver->longitudTx);
+        driver->longitudTx = 0;
+    }
 
-            if (tamBuff > TAMANIO_BUFFER_TX_USB)
-            	tamBuff = TAMANIO_BUFFER_TX_USB;
+    const uint32_t longitud = bloqueBufferAnillo(&driver->anilloTx, &bloque);
+    if (longitud == 0)
+        return;
 
-            USBD_CDC_SetTxBuffer(&driver->hal.hUSB, (uint8_t*)&driver->txBuffer[driver->colaTxBuffer], tamBuff);
+    USBD_CDC_SetTxBuffer(&driver->hal.hUSB, (uint8_t *)bloque, longitud);
 
-            if (USBD_CDC_TransmitPacket(&driver->hal.hUSB) == USBD_OK)
-            	ultimoTamBuff = tamBuff;
-        }
-    }
+    if (USBD_CDC_TransmitPacket(&driver->hal.hUSB) == USBD_OK)
+        driver->longitudTx = longitud;
 }
 
 #endif
@@ -140,8 +140,6 @@ extern bool iniR;
 ****************************************************************************************/
 void actualizarRC(uint32_t tiempoActual)
 {
-    UNUSED(tiempoActual);
-
     if (reaction.id == 'B' && iniR) {
     	reaction.id = 'C';
     }
@@ -156,6 +154,9 @@ void actualizarRC(uint32_t tiempoActual)
         return;
     }
 
+    // Tiempo desde que llego la trama hasta que se usan sus canales
+    medirLatenciaRadio(tiempoActual);
+
     // Solo se actualizan las referencias y los modos cuando la radio esta OK y ha llegado una nueva entrada
     //if (nuevaEntradaRadioValida()) {
 
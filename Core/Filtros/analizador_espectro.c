@@ -0,0 +1,362 @@
+/***************************************************************************************
+**  analizador_espectro.c - Analizador de espectro del giroscopo por FFT
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <string.h>
+#include <math.h>
+
+#include "analizador_espectro.h"
+#include "Sistema/plataforma.h"
+#include "Comun/util.h"
+#include "Comun/matematicas.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define NUM_COMPLEJOS_ANALIZADOR     (TAM_FFT_ANALIZADOR_ESPECTRO / 2)
+#define UMBRAL_PICO_ANALIZADOR       2.0f    // Relacion minima entre un pico y la media del rango
+#define ALPHA_PICO_ANALIZADOR        0.3f    // Suavizado de la frecuencia dominante
+#define MARGEN_DIEZMADO_ANALIZADOR   2.5f    // Muestras diezmadas por periodo de la frecuencia maxima
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void aplicarVentanaAnalizadorEspectro(analizadorEspectro_t *analizador);
+void permutarAnalizadorEspectro(analizadorEspectro_t *analizador);
+bool mariposasAnalizadorEspectro(analizadorEspectro_t *analizador);
+void calcularEspectroAnalizadorEspectro(analizadorEspectro_t *analizador);
+void buscarPicosAnalizadorEspectro(analizadorEspectro_t *analizador);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool iniciarAnalizadorEspectro(analizadorEspectro_t *analizador, float frecMuestreo, float frecMin, float frecMax)
+**  Descripcion:    Inicia el analizador. El diezmado se elige para que la frecuencia
+**                  maxima quede por debajo de Nyquist con margen
+**  Parametros:     Puntero al analizador, frecuencia de las muestras, rango de busqueda
+**  Retorno:        True si el rango es valido
+****************************************************************************************/
+bool iniciarAnalizadorEspectro(analizadorEspectro_t *analizador, float frecMuestreo, float frecMin, float frecMax)
+{
+    memset(analizador, 0, sizeof(analizadorEspectro_t));
+
+    if (frecMuestreo <= 0 || frecMin <= 0 || frecMax <= frecMin)
+        return false;
+
+    const float diezmado = floorf(frecMuestreo / (MARGEN_DIEZMADO_ANALIZADOR * frecMax));
+    analizador->diezmado = limitarFloat(diezmado, 1, 255);
+    analizador->frecMuestreo = frecMuestreo / analizador->diezmado;
+    analizador->resolucion = analizador->frecMuestreo / TAM_FFT_ANALIZADOR_ESPECTRO;
+    analizador->frecMin = frecMin;
+    analizador->frecMax = MIN(frecMax, 0.5f * analizador->frecMuestreo);
+
+    const float binMin = ceilf(analizador->frecMin / analizador->resolucion);
+    const float binMax = floorf(analizador->frecMax / analizador->resolucion);
+    analizador->binMin = limitarFloat(binMin, 1, NUM_COMPLEJOS_ANALIZADOR - 1);
+    analizador->binMax = limitarFloat(binMax, 1, NUM_COMPLEJOS_ANALIZADOR - 1);
+    if (analizador->binMax <= analizador->binMin)
+        return false;
+
+    for (uint16_t i = 0; i < TAM_FFT_ANALIZADOR_ESPECTRO; i++)
+        analizador->ventana[i] = 0.5f - 0.5f * cosf(2.0f * PI * i / (TAM_FFT_ANALIZADOR_ESPECTRO - 1));
+
+    for (uint16_t i = 0; i < NUM_COMPLEJOS_ANALIZADOR; i++) {
+        analizador->cosW[i] = cosf(2.0f * PI * i / TAM_FFT_ANALIZADOR_ESPECTRO);
+        analizador->senW[i] = sinf(2.0f * PI * i / TAM_FFT_ANALIZADOR_ESPECTRO);
+    }
+
+    analizador->operativo = true;
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void anadirMuestraAnalizadorEspectro(analizadorEspectro_t *analizador, const float muestra[3])
+**  Descripcion:    Acumula una muestra de los tres ejes y la guarda al completar el diezmado
+**  Parametros:     Puntero al analizador, muestra
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void anadirMuestraAnalizadorEspectro(analizadorEspectro_t *analizador, const float muestra[3])
+{
+    if (!analizador->operativo)
+        return;
+
+    for (uint8_t i = 0; i < 3; i++)
+        analizador->acumulado[i] += muestra[i];
+
+    if (++analizador->cntDiezmado < analizador->diezmado)
+        return;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        analizador->muestras[i][analizador->indice] = analizador->acumulado[i] / analizador->diezmado;
+        analizador->acumulado[i] = 0;
+    }
+
+    analizador->cntDiezmado = 0;
+    analizador->indice = (analizador->indice + 1) % TAM_FFT_ANALIZADOR_ESPECTRO;
+    if (analizador->indice == 0)
+        analizador->bufferLleno = true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool actualizarAnalizadorEspectro(analizadorEspectro_t *analizador, uint8_t *eje)
+**  Descripcion:    Ejecuta el siguiente paso del analisis
+**  Parametros:     Puntero al analizador, eje con nuevos picos
+**  Retorno:        True si se ha terminado el analisis de un eje
+****************************************************************************************/
+CODIGO_RAPIDO bool actualizarAnalizadorEspectro(analizadorEspectro_t *analizador, uint8_t *eje)
+{
+    if (!analizador->operativo || !analizador->bufferLleno)
+        return false;
+
+    switch (analizador->paso) {
+        case PASO_VENTANA_ANALIZADOR:
+            aplicarVentanaAnalizadorEspectro(analizador);
+            analizador->paso = PASO_PERMUTACION_ANALIZADOR;
+            break;
+
+        case PASO_PERMUTACION_ANALIZADOR:
+            permutarAnalizadorEspectro(analizador);
+            analizador->etapa = 1;
+            analizador->paso = PASO_MARIPOSAS_ANALIZADOR;
+            break;
+
+        case PASO_MARIPOSAS_ANALIZADOR:
+            if (mariposasAnalizadorEspectro(analizador))
+                analizador->paso = PASO_ESPECTRO_ANALIZADOR;
+            break;
+
+        case PASO_ESPECTRO_ANALIZADOR:
+            calcularEspectroAnalizadorEspectro(analizador);
+            analizador->paso = PASO_PICOS_ANALIZADOR;
+            break;
+
+        case PASO_PICOS_ANALIZADOR:
+            buscarPicosAnalizadorEspectro(analizador);
+            *eje = analizador->eje;
+            analizador->eje = (analizador->eje + 1) % 3;
+            analizador->paso = PASO_VENTANA_ANALIZADOR;
+            if (analizador->eje == 0)
+                analizador->numAnalisis++;
+            return true;
+    }
+
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void aplicarVentanaAnalizadorEspectro(analizadorEspectro_t *analizador)
+**  Descripcion:    Copia las ultimas muestras del eje en orden, con la ventana aplicada. Las
+**                  muestras pares e impares forman la parte real e imaginaria de la FFT
+**                  compleja de la mitad de tamanio
+**  Parametros:     Puntero al analizador
+**  Retorno:        Ninguno
+****************************************************************************************/
+void aplicarVentanaAnalizadorEspectro(analizadorEspectro_t *analizador)
+{
+    const float *muestras = analizador->muestras[analizador->eje];
+    float media = 0;
+
+    for (uint16_t i = 0; i < TAM_FFT_ANALIZADOR_ESPECTRO; i++)
+        media += muestras[i];
+    media /= TAM_FFT_ANALIZADOR_ESPECTRO;
+
+    // Se quita la media para que la continua no se escape por la ventana a los primeros bins
+    for (uint16_t i = 0, j = analizador->indice; i < TAM_FFT_ANALIZADOR_ESPECTRO; i++) {
+        analizador->datos[i] = (muestras[j] - media) * analizador->ventana[i];
+        j = (j + 1) % TAM_FFT_ANALIZADOR_ESPECTRO;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void permutarAnalizadorEspectro(analizadorEspectro_t *analizador)
+**  Descripcion:    Ordena los complejos en orden de bits invertido
+**  Parametros:     Puntero al analizador
+**  Retorno:        Ninguno
+****************************************************************************************/
+void permutarAnalizadorEspectro(analizadorEspectro_t *analizador)
+{
+    float *datos = analizador->datos;
+
+    for (uint16_t i = 1, j = 0; i < NUM_COMPLEJOS_ANALIZADOR; i++) {
+        uint16_t bit = NUM_COMPLEJOS_ANALIZADOR >> 1;
+
+        for (; j & bit; bit >>= 1)
+            j ^= bit;
+        j ^= bit;
+
+        if (i < j) {
+            float tmp = datos[2 * i];
+            datos[2 * i] = datos[2 * j];
+            datos[2 * j] = tmp;
+            tmp = datos[2 * i + 1];
+            datos[2 * i + 1] = datos[2 * j + 1];
+            datos[2 * j + 1] = tmp;
+        }
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool mariposasAnalizadorEspectro(analizadorEspectro_t *analizador)
+**  Descripcion:    Ejecuta las siguientes etapas de mariposas radix 2
+**  Parametros:     Puntero al analizador
+**  Retorno:        True si se ha completado la FFT compleja
+****************************************************************************************/
+bool mariposasAnalizadorEspectro(analizadorEspectro_t *analizador)
+{
+    float *datos = analizador->datos;
+
+    for (uint8_t n = 0; n < ETAPAS_POR_PASO_ANALIZADOR_ESPECTRO; n++) {
+        const uint16_t mitad = 1 << (analizador->etapa - 1);
+        const uint16_t salto = TAM_FFT_ANALIZADOR_ESPECTRO / (2 * mitad);   // Indice en la tabla de N puntos
+
+        if (2 * mitad > NUM_COMPLEJOS_ANALIZADOR)
+            return true;
+
+        for (uint16_t k = 0; k < mitad; k++) {
+            const float wr = analizador->cosW[k * salto];
+            const float wi = -analizador->senW[k * salto];
+
+            for (uint16_t i = k; i < NUM_COMPLEJOS_ANALIZADOR; i += 2 * mitad) {
+                const uint16_t j = i + mitad;
+                const float tr = wr * datos[2 * j] - wi * datos[2 * j + 1];
+                const float ti = wr * datos[2 * j + 1] + wi * datos[2 * j];
+
+                datos[2 * j] = datos[2 * i] - tr;
+                datos[2 * j + 1] = datos[2 * i + 1] - ti;
+                datos[2 * i] += tr;
+                datos[2 * i + 1] += ti;
+            }
+        }
+
+        analizador->etapa++;
+    }
+
+    return 2 * (1 << (analizador->etapa - 1)) > NUM_COMPLEJOS_ANALIZADOR;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void calcularEspectroAnalizadorEspectro(analizadorEspectro_t *analizador)
+**  Descripcion:    Separa el espectro de la senial real a partir de la FFT compleja y
+**                  calcula la magnitud de los bins del rango de busqueda y sus vecinos
+**  Parametros:     Puntero al analizador
+**  Retorno:        Ninguno
+****************************************************************************************/
+void calcularEspectroAnalizadorEspectro(analizadorEspectro_t *analizador)
+{
+    const float *datos = analizador->datos;
+
+    for (uint16_t k = analizador->binMin - 1; k <= analizador->binMax + 1 && k < NUM_COMPLEJOS_ANALIZADOR; k++) {
+        const uint16_t m = (NUM_COMPLEJOS_ANALIZADOR - k) % NUM_COMPLEJOS_ANALIZADOR;
+        const float ar = datos[2 * k], ai = datos[2 * k + 1];
+        const float br = datos[2 * m], bi = -datos[2 * m + 1];
+
+        // X[k] = Fpar[k] + W^k * Fimpar[k]
+        const float parR = 0.5f * (ar + br);
+        const float parI = 0.5f * (ai + bi);
+        const float imparR = 0.5f * (ai - bi);
+        const float imparI = -0.5f * (ar - br);
+        const float c = analizador->cosW[k];
+        const float s = analizador->senW[k];
+        const float xr = parR + c * imparR + s * imparI;
+        const float xi = parI + c * imparI - s * imparR;
+
+        analizador->magnitud[k] = sqrtf(xr * xr + xi * xi);
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void buscarPicosAnalizadorEspectro(analizadorEspectro_t *analizador)
+**  Descripcion:    Busca los maximos locales del rango que destacan sobre la media,
+**                  interpola su frecuencia con una parabola y suaviza el dominante
+**  Parametros:     Puntero al analizador
+**  Retorno:        Ninguno
+****************************************************************************************/
+void buscarPicosAnalizadorEspectro(analizadorEspectro_t *analizador)
+{
+    const float *mag = analizador->magnitud;
+    picoEspectro_t *picos = analizador->picos[analizador->eje];
+    uint8_t numPicos = 0;
+    float media = 0;
+
+    for (uint16_t k = analizador->binMin; k <= analizador->binMax; k++)
+        media += mag[k];
+    media /= analizador->binMax - analizador->binMin + 1;
+
+    for (uint16_t k = analizador->binMin; k <= analizador->binMax; k++) {
+        if (mag[k] <= mag[k - 1] || mag[k] < mag[k + 1] || mag[k] < UMBRAL_PICO_ANALIZADOR * media)
+            continue;
+
+        // Insercion ordenada por magnitud
+        int8_t pos = numPicos < NUM_PICOS_ANALIZADOR_ESPECTRO ? numPicos : NUM_PICOS_ANALIZADOR_ESPECTRO - 1;
+        if (pos == NUM_PICOS_ANALIZADOR_ESPECTRO - 1 && numPicos == NUM_PICOS_ANALIZADOR_ESPECTRO && mag[k] <= picos[pos].magnitud)
+            continue;
+
+        for (; pos > 0 && picos[pos - 1].magnitud < mag[k]; pos--)
+            picos[pos] = picos[pos - 1];
+
+        const float den = mag[k - 1] - 2.0f * mag[k] + mag[k + 1];
+        const float delta = den != 0 ? 0.5f * (mag[k - 1] - mag[k + 1]) / den : 0;
+
+        picos[pos].frecuencia = (k + delta) * analizador->resolucion;
+        picos[pos].magnitud = mag[k];
+        if (numPicos < NUM_PICOS_ANALIZADOR_ESPECTRO)
+            numPicos++;
+    }
+
+    analizador->numPicos[analizador->eje] = numPicos;
+
+    // Si no hay picos se mantiene la ultima frecuencia para no mover los notch con ruido
+    if (numPicos > 0) {
+        float *dominante = &analizador->frecDominante[analizador->eje];
+
+        if (*dominante == 0)
+            *dominante = picos[0].frecuencia;
+        else
+            *dominante += (picos[0].frecuencia - *dominante) * ALPHA_PICO_ANALIZADOR;
+    }
+}
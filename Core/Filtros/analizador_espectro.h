@@ -0,0 +1,111 @@
+/***************************************************************************************
+**  analizador_espectro.h - Analizador de espectro del giroscopo por FFT
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __ANALIZADOR_ESPECTRO_H
+#define __ANALIZADOR_ESPECTRO_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Las muestras de cada eje se diezman promediando y se guardan en un buffer circular.
+ * Cada llamada a actualizarAnalizadorEspectro hace un solo paso de la FFT real (con
+ * ventana de Hann) de un eje: ventana, permutacion, un par de etapas de mariposas,
+ * espectro y busqueda de picos. Asi el coste por tick esta acotado y los ejes se
+ * analizan por turnos
+ */
+#define TAM_FFT_ANALIZADOR_ESPECTRO           128     // Muestras reales por FFT (potencia de 2)
+#define NUM_PICOS_ANALIZADOR_ESPECTRO         3
+#define ETAPAS_POR_PASO_ANALIZADOR_ESPECTRO   2       // Etapas de mariposas por llamada
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef enum {
+    PASO_VENTANA_ANALIZADOR = 0,
+    PASO_PERMUTACION_ANALIZADOR,
+    PASO_MARIPOSAS_ANALIZADOR,
+    PASO_ESPECTRO_ANALIZADOR,
+    PASO_PICOS_ANALIZADOR,
+} pasoAnalizadorEspectro_e;
+
+typedef struct {
+    float frecuencia;                    // Hz
+    float magnitud;
+} picoEspectro_t;
+
+typedef struct {
+    bool operativo;
+    float frecMuestreo;                  // Frecuencia de las muestras diezmadas
+    float resolucion;                    // Hz por bin
+    float frecMin, frecMax;
+    uint8_t diezmado;
+    uint8_t binMin, binMax;
+
+    // Diezmado y buffer circular
+    float acumulado[3];
+    uint8_t cntDiezmado;
+    float muestras[3][TAM_FFT_ANALIZADOR_ESPECTRO];
+    uint8_t indice;
+    bool bufferLleno;
+
+    // FFT en curso
+    pasoAnalizadorEspectro_e paso;
+    uint8_t eje;
+    uint8_t etapa;
+    float datos[TAM_FFT_ANALIZADOR_ESPECTRO];      // Parte real e imaginaria intercaladas de N/2 complejos
+    float magnitud[TAM_FFT_ANALIZADOR_ESPECTRO / 2 + 1];
+    float ventana[TAM_FFT_ANALIZADOR_ESPECTRO];
+    float cosW[TAM_FFT_ANALIZADOR_ESPECTRO / 2];
+    float senW[TAM_FFT_ANALIZADOR_ESPECTRO / 2];
+
+    // Resultados
+    picoEspectro_t picos[3][NUM_PICOS_ANALIZADOR_ESPECTRO];   // Ordenados por magnitud
+    uint8_t numPicos[3];
+    float frecDominante[3];              // Pico principal suavizado, 0 si no hay
+    uint32_t numAnalisis;
+} analizadorEspectro_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool iniciarAnalizadorEspectro(analizadorEspectro_t *analizador, float frecMuestreo, float frecMin, float frecMax);
+void anadirMuestraAnalizadorEspectro(analizadorEspectro_t *analizador, const float muestra[3]);
+bool actualizarAnalizadorEspectro(analizadorEspectro_t *analizador, uint8_t *eje);
+
+#endif // __ANALIZADOR_ESPECTRO_H
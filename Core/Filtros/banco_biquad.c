@@ -0,0 +1,263 @@
+/***************************************************************************************
+**  banco_biquad.c - Banco de filtros biquad para varios canales
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <string.h>
+#include <math.h>
+
+#include "banco_biquad.h"
+#include "filtro_notch.h"
+#include "Sistema/plataforma.h"
+#include "Comun/util.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+// En el M7 la FPU de simple precision no tiene instrucciones SIMD, pero puede emitir dos
+// instrucciones por ciclo. Se procesan 4 canales a la vez para que las cadenas de
+// multiplicaciones y sumas de cada canal sean independientes y no esperen a la anterior
+#if defined(__ARM_ARCH_7EM__) && defined(__ARM_FP)
+#define CANALES_BLOQUE_BANCO_BIQUAD   4
+#else
+#define CANALES_BLOQUE_BANCO_BIQUAD   1
+#endif
+
+#define PASO_BANCO_BIQUAD(e, c, x)  do {                                              \
+        const float entrada = (x)[c];                                                 \
+        const float salida = (e)->b0[c] * entrada + (e)->estado1[c];                  \
+        (e)->estado1[c] = (e)->b1[c] * entrada - (e)->a1[c] * salida + (e)->estado2[c]; \
+        (e)->estado2[c] = (e)->b2[c] * entrada - (e)->a2[c] * salida;                 \
+        (x)[c] = salida;                                                              \
+    } while (0)
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void asignarCoefBancoBiquad(bancoBiquad_t *banco, uint8_t etapa, uint8_t canal, uint8_t numCanales,
+                            float b0, float b1, float b2, float a1, float a2);
+void actualizarEtapaBancoBiquad(etapaBancoBiquad_t *etapa, uint8_t canal, uint8_t numCanales, float *muestras);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool iniciarBancoBiquad(bancoBiquad_t *banco, uint8_t numCanales, uint8_t numEtapas)
+**  Descripcion:    Inicia el banco con todas las etapas sin filtrar y el estado a cero
+**  Parametros:     Puntero al banco, numero de canales, numero de etapas en cascada
+**  Retorno:        True si el banco cabe en los limites
+****************************************************************************************/
+bool iniciarBancoBiquad(bancoBiquad_t *banco, uint8_t numCanales, uint8_t numEtapas)
+{
+    memset(banco, 0, sizeof(bancoBiquad_t));
+
+    if (numCanales > NUM_MAX_CANALES_BANCO_BIQUAD || numEtapas > NUM_MAX_ETAPAS_BANCO_BIQUAD)
+        return false;
+
+    banco->numCanales = numCanales;
+    banco->numEtapas = numEtapas;
+
+    for (uint8_t i = 0; i < numEtapas; i++)
+        ajustarPasoBancoBiquad(banco, i, 0, numCanales);
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void asignarCoefBancoBiquad(bancoBiquad_t *banco, uint8_t etapa, uint8_t canal, uint8_t numCanales,
+**                                              float b0, float b1, float b2, float a1, float a2)
+**  Descripcion:    Copia los coeficientes normalizados a un rango de canales de una etapa
+**  Parametros:     Puntero al banco, etapa, primer canal, numero de canales, coeficientes
+**  Retorno:        Ninguno
+****************************************************************************************/
+void asignarCoefBancoBiquad(bancoBiquad_t *banco, uint8_t etapa, uint8_t canal, uint8_t numCanales,
+                            float b0, float b1, float b2, float a1, float a2)
+{
+    if (etapa >= banco->numEtapas || canal + numCanales > banco->numCanales)
+        return;
+
+    etapaBancoBiquad_t *e = &banco->etapa[etapa];
+
+    for (uint8_t i = canal; i < canal + numCanales; i++) {
+        e->b0[i] = b0;
+        e->b1[i] = b1;
+        e->b2[i] = b2;
+        e->a1[i] = a1;
+        e->a2[i] = a2;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void ajustarPasoBancoBiquad(bancoBiquad_t *banco, uint8_t etapa, uint8_t canal, uint8_t numCanales)
+**  Descripcion:    Deja pasar la senial sin filtrar por una etapa de un rango de canales
+**  Parametros:     Puntero al banco, etapa, primer canal, numero de canales
+**  Retorno:        Ninguno
+****************************************************************************************/
+void ajustarPasoBancoBiquad(bancoBiquad_t *banco, uint8_t etapa, uint8_t canal, uint8_t numCanales)
+{
+    asignarCoefBancoBiquad(banco, etapa, canal, numCanales, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void ajustarPasaBajoBancoBiquad(bancoBiquad_t *banco, uint8_t etapa, uint8_t canal, uint8_t numCanales,
+**                                                  float frecCorte, float frecMuestreo)
+**  Descripcion:    Ajusta un pasa bajo Butterworth de 2 polos, igual que filtroPasaBajo2P_t
+**  Parametros:     Puntero al banco, etapa, primer canal, numero de canales, frecuencia de
+**                  corte, frecuencia de muestreo
+**  Retorno:        Ninguno
+****************************************************************************************/
+void ajustarPasaBajoBancoBiquad(bancoBiquad_t *banco, uint8_t etapa, uint8_t canal, uint8_t numCanales,
+                                float frecCorte, float frecMuestreo)
+{
+    if (frecCorte <= 0 || frecMuestreo <= 0 || frecCorte >= 0.5f * frecMuestreo) {
+        ajustarPasoBancoBiquad(banco, etapa, canal, numCanales);
+        return;
+    }
+
+    const float ohm = tanf(PI * frecCorte / frecMuestreo);
+    const float c = 1.0f + 2.0f * cosf(PI / 4.0f) * ohm + ohm * ohm;
+    const float b0 = ohm * ohm / c;
+
+    asignarCoefBancoBiquad(banco, etapa, canal, numCanales, b0, 2.0f * b0, b0, 2.0f * (ohm * ohm - 1.0f) / c,
+                           (1.0f - 2.0f * cosf(PI / 4.0f) * ohm + ohm * ohm) / c);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void ajustarNotchBancoBiquad(bancoBiquad_t *banco, uint8_t etapa, uint8_t canal, uint8_t numCanales,
+**                                               float frecCentral, float frecMuestreo, float anchoBandaHz, float atenuacionDB)
+**  Descripcion:    Ajusta un notch con la misma respuesta que filtroNotch_t. Se puede llamar
+**                  en vuelo para mover la frecuencia sin resetear el estado
+**  Parametros:     Puntero al banco, etapa, primer canal, numero de canales, frecuencia
+**                  central, frecuencia de muestreo, ancho de banda, atenuacion del filtro
+**  Retorno:        Ninguno
+****************************************************************************************/
+void ajustarNotchBancoBiquad(bancoBiquad_t *banco, uint8_t etapa, uint8_t canal, uint8_t numCanales,
+                             float frecCentral, float frecMuestreo, float anchoBandaHz, float atenuacionDB)
+{
+    float A, Q;
+
+    calcularAQfiltroNotch(frecCentral, anchoBandaHz, atenuacionDB, &A, &Q);
+    if (frecCentral <= 0 || frecCentral >= 0.5f * frecMuestreo || Q <= 0.0f) {
+        ajustarPasoBancoBiquad(banco, etapa, canal, numCanales);
+        return;
+    }
+
+    const float omega = 2.0f * PI * frecCentral / frecMuestreo;
+    const float alpha = sinf(omega) / (2.0f * Q);
+    const float a0Inv = 1.0f / (1.0f + alpha);
+    const float b1 = -2.0f * cosf(omega) * a0Inv;
+
+    asignarCoefBancoBiquad(banco, etapa, canal, numCanales, (1.0f + alpha * A * A) * a0Inv, b1,
+                           (1.0f - alpha * A * A) * a0Inv, b1, (1.0f - alpha) * a0Inv);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void resetearBancoBiquad(bancoBiquad_t *banco)
+**  Descripcion:    Pone a cero el estado de todos los canales
+**  Parametros:     Puntero al banco
+**  Retorno:        Ninguno
+****************************************************************************************/
+void resetearBancoBiquad(bancoBiquad_t *banco)
+{
+    for (uint8_t i = 0; i < banco->numEtapas; i++) {
+        memset(banco->etapa[i].estado1, 0, sizeof(banco->etapa[i].estado1));
+        memset(banco->etapa[i].estado2, 0, sizeof(banco->etapa[i].estado2));
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void actualizarEtapaBancoBiquad(etapaBancoBiquad_t *etapa, uint8_t canal, uint8_t numCanales, float *muestras)
+**  Descripcion:    Filtra una muestra de cada canal de un rango por una etapa
+**  Parametros:     Puntero a la etapa, primer canal, numero de canales, muestras (se
+**                  sustituyen por las filtradas)
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void actualizarEtapaBancoBiquad(etapaBancoBiquad_t *etapa, uint8_t canal, uint8_t numCanales, float *muestras)
+{
+    const uint8_t fin = canal + numCanales;
+    uint8_t i = canal;
+
+#if CANALES_BLOQUE_BANCO_BIQUAD == 4
+    for (; i + 4 <= fin; i += 4) {
+        PASO_BANCO_BIQUAD(etapa, i, muestras - canal);
+        PASO_BANCO_BIQUAD(etapa, i + 1, muestras - canal);
+        PASO_BANCO_BIQUAD(etapa, i + 2, muestras - canal);
+        PASO_BANCO_BIQUAD(etapa, i + 3, muestras - canal);
+    }
+#endif
+
+    for (; i < fin; i++)
+        PASO_BANCO_BIQUAD(etapa, i, muestras - canal);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void actualizarCanalesBancoBiquad(bancoBiquad_t *banco, uint8_t canal, uint8_t numCanales, float *muestras)
+**  Descripcion:    Filtra una muestra de un rango de canales por todas las etapas. Sirve
+**                  para sensores que comparten banco pero se leen en momentos distintos
+**  Parametros:     Puntero al banco, primer canal, numero de canales, muestras del rango
+**                  (se sustituyen por las filtradas)
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void actualizarCanalesBancoBiquad(bancoBiquad_t *banco, uint8_t canal, uint8_t numCanales, float *muestras)
+{
+    if (canal + numCanales > banco->numCanales)
+        return;
+
+    for (uint8_t i = 0; i < banco->numEtapas; i++)
+        actualizarEtapaBancoBiquad(&banco->etapa[i], canal, numCanales, muestras);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void actualizarBancoBiquad(bancoBiquad_t *banco, float *muestras)
+**  Descripcion:    Filtra una muestra de todos los canales por todas las etapas
+**  Parametros:     Puntero al banco, muestras (se sustituyen por las filtradas)
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void actualizarBancoBiquad(bancoBiquad_t *banco, float *muestras)
+{
+    actualizarCanalesBancoBiquad(banco, 0, banco->numCanales, muestras);
+}
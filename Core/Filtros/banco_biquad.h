@@ -0,0 +1,88 @@
+/***************************************************************************************
+**  banco_biquad.h - Banco de filtros biquad para varios canales
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __BANCO_BIQUAD_H
+#define __BANCO_BIQUAD_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Cada etapa es un biquad por canal en forma directa II transpuesta con a0 = 1. Las
+ * etapas se aplican en cascada. Los coeficientes y el estado se guardan por separado
+ * en arrays contiguos (un array por coeficiente) para recorrer todos los canales de
+ * una muestra seguidos. Una etapa sin ajustar deja pasar la senial
+ */
+#ifndef NUM_MAX_CANALES_BANCO_BIQUAD
+#define NUM_MAX_CANALES_BANCO_BIQUAD          32
+#endif
+#define NUM_MAX_ETAPAS_BANCO_BIQUAD           4
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    float b0[NUM_MAX_CANALES_BANCO_BIQUAD];
+    float b1[NUM_MAX_CANALES_BANCO_BIQUAD];
+    float b2[NUM_MAX_CANALES_BANCO_BIQUAD];
+    float a1[NUM_MAX_CANALES_BANCO_BIQUAD];
+    float a2[NUM_MAX_CANALES_BANCO_BIQUAD];
+    float estado1[NUM_MAX_CANALES_BANCO_BIQUAD];
+    float estado2[NUM_MAX_CANALES_BANCO_BIQUAD];
+} etapaBancoBiquad_t;
+
+typedef struct {
+    uint8_t numCanales;
+    uint8_t numEtapas;
+    etapaBancoBiquad_t etapa[NUM_MAX_ETAPAS_BANCO_BIQUAD];
+} bancoBiquad_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool iniciarBancoBiquad(bancoBiquad_t *banco, uint8_t numCanales, uint8_t numEtapas);
+void ajustarPasoBancoBiquad(bancoBiquad_t *banco, uint8_t etapa, uint8_t canal, uint8_t numCanales);
+void ajustarPasaBajoBancoBiquad(bancoBiquad_t *banco, uint8_t etapa, uint8_t canal, uint8_t numCanales,
+                                float frecCorte, float frecMuestreo);
+void ajustarNotchBancoBiquad(bancoBiquad_t *banco, uint8_t etapa, uint8_t canal, uint8_t numCanales,
+                             float frecCentral, float frecMuestreo, float anchoBandaHz, float atenuacionDB);
+void resetearBancoBiquad(bancoBiquad_t *banco);
+void actualizarCanalesBancoBiquad(bancoBiquad_t *banco, uint8_t canal, uint8_t numCanales, float *muestras);
+void actualizarBancoBiquad(bancoBiquad_t *banco, float *muestras);
+
+#endif // __BANCO_BIQUAD_H
@@ -0,0 +1,230 @@
+/***************************************************************************************
+**  banco_notch_rpm.c - Banco de notch que siguen los armonicos de giro de los motores
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <string.h>
+
+#include "banco_notch_rpm.h"
+#include "filtro_notch.h"
+#include "Sistema/plataforma.h"
+#include "Comun/matematicas.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define LIMITE_NYQUIST_NOTCH_RPM      0.48f
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void ajustarNotchBancoNotchRPM(bancoNotchRPM_t *banco, uint8_t notch, float frecuencia);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool iniciarBancoNotchRPM(bancoNotchRPM_t *banco, uint8_t numCanales, uint8_t numMotores,
+**                                            uint8_t armonicos, float frecMuestreo, float frecMin, float anchoBanda,
+**                                            float atenuacionDB, uint8_t ajustesPorPaso, fnFrecuenciaRotor_t fuente)
+**  Descripcion:    Inicia el banco con todos los notch sin filtrar
+**  Parametros:     Puntero al banco, numero de canales, numero de motores, mascara de
+**                  armonicos, frecuencia de muestreo, frecuencia minima de los notch,
+**                  ancho de banda en tanto por uno de la frecuencia, atenuacion, notch
+**                  reajustados en cada paso, fuente de la frecuencia de giro
+**  Retorno:        True si el banco cabe en los limites y hay algun notch
+****************************************************************************************/
+bool iniciarBancoNotchRPM(bancoNotchRPM_t *banco, uint8_t numCanales, uint8_t numMotores, uint8_t armonicos,
+                          float frecMuestreo, float frecMin, float anchoBanda, float atenuacionDB,
+                          uint8_t ajustesPorPaso, fnFrecuenciaRotor_t fuente)
+{
+    memset(banco, 0, sizeof(bancoNotchRPM_t));
+
+    if (numCanales > NUM_MAX_CANALES_NOTCH_RPM || numMotores > NUM_MAX_MOTORES_NOTCH_RPM || frecMuestreo <= 0 ||
+        anchoBanda <= 0 || anchoBanda >= 2.0f || fuente == NULL)
+        return false;
+
+    for (uint8_t i = 0; i < NUM_MAX_ARMONICOS_NOTCH_RPM; i++) {
+        if ((1U << i) & armonicos)
+            banco->armonico[banco->numArmonicos++] = i + 1;
+    }
+
+    // Con el ancho proporcional a la frecuencia A y Q no dependen de la frecuencia
+    float A, Q;
+    calcularAQfiltroNotch(1.0f, anchoBanda, atenuacionDB, &A, &Q);
+
+    banco->numCanales = numCanales;
+    banco->numMotores = numMotores;
+    banco->numNotch = numMotores * banco->numArmonicos;
+    banco->ajustesPorPaso = ajustesPorPaso > 0 ? ajustesPorPaso : 1;
+    banco->frecMuestreo = frecMuestreo;
+    banco->frecMin = frecMin;
+    banco->frecMax = LIMITE_NYQUIST_NOTCH_RPM * frecMuestreo;
+    banco->A2 = A * A;
+    banco->inv2Q = 1.0f / (2.0f * Q);
+    banco->fuente = fuente;
+
+    return banco->numNotch > 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t ajustarBancoNotchRPM(bancoNotchRPM_t *banco)
+**  Descripcion:    Reajusta por turnos los siguientes notch con la frecuencia de giro
+**                  actual de su motor
+**  Parametros:     Puntero al banco
+**  Retorno:        Numero de notch reajustados
+****************************************************************************************/
+CODIGO_RAPIDO uint8_t ajustarBancoNotchRPM(bancoNotchRPM_t *banco)
+{
+    const uint8_t ajustes = banco->ajustesPorPaso < banco->numNotch ? banco->ajustesPorPaso : banco->numNotch;
+
+    for (uint8_t i = 0; i < ajustes; i++) {
+        const uint8_t notch = banco->siguiente;
+        const uint8_t motor = notch / banco->numArmonicos;
+        float frecuencia;
+
+        if (banco->fuente(motor, &frecuencia))
+            frecuencia *= banco->armonico[notch - motor * banco->numArmonicos];
+        else
+            frecuencia = 0;
+
+        ajustarNotchBancoNotchRPM(banco, notch, frecuencia);
+        banco->siguiente = notch + 1 < banco->numNotch ? notch + 1 : 0;
+    }
+
+    banco->ajustes += ajustes;
+    return ajustes;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void ajustarNotchBancoNotchRPM(bancoNotchRPM_t *banco, uint8_t notch, float frecuencia)
+**  Descripcion:    Calcula los coeficientes de un notch. Fuera de rango deja pasar la
+**                  senial. Al activarse empieza con el estado a cero
+**  Parametros:     Puntero al banco, notch, frecuencia central
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void ajustarNotchBancoNotchRPM(bancoNotchRPM_t *banco, uint8_t notch, float frecuencia)
+{
+    if (frecuencia < banco->frecMin || frecuencia <= 0 || frecuencia >= banco->frecMax) {
+        banco->activo[notch] = false;
+        return;
+    }
+
+    float seno, coseno;
+    senoCosenoRapido(2.0f * M_PIf * frecuencia / banco->frecMuestreo, &seno, &coseno);
+
+    const float alpha = seno * banco->inv2Q;
+    const float a0Inv = 1.0f / (1.0f + alpha);
+
+    banco->b0[notch] = (1.0f + alpha * banco->A2) * a0Inv;
+    banco->b1[notch] = -2.0f * coseno * a0Inv;
+    banco->b2[notch] = (1.0f - alpha * banco->A2) * a0Inv;
+    banco->a2[notch] = (1.0f - alpha) * a0Inv;
+
+    if (!banco->activo[notch]) {
+        memset(banco->estado1[notch], 0, sizeof(banco->estado1[notch]));
+        memset(banco->estado2[notch], 0, sizeof(banco->estado2[notch]));
+        banco->activo[notch] = true;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void resetearBancoNotchRPM(bancoNotchRPM_t *banco)
+**  Descripcion:    Pone a cero el estado de todos los notch
+**  Parametros:     Puntero al banco
+**  Retorno:        Ninguno
+****************************************************************************************/
+void resetearBancoNotchRPM(bancoNotchRPM_t *banco)
+{
+    memset(banco->estado1, 0, sizeof(banco->estado1));
+    memset(banco->estado2, 0, sizeof(banco->estado2));
+}
+
+
+/***************************************************************************************
+**  Nombre:         void actualizarCanalesBancoNotchRPM(bancoNotchRPM_t *banco, uint8_t canal, uint8_t numCanales, float *muestras)
+**  Descripcion:    Filtra una muestra de un rango de canales por todos los notch activos.
+**                  Los canales de un mismo notch son independientes y se calculan seguidos
+**  Parametros:     Puntero al banco, primer canal, numero de canales, muestras del rango
+**                  (se sustituyen por las filtradas)
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void actualizarCanalesBancoNotchRPM(bancoNotchRPM_t *banco, uint8_t canal, uint8_t numCanales, float *muestras)
+{
+    if (canal + numCanales > banco->numCanales)
+        return;
+
+    for (uint8_t n = 0; n < banco->numNotch; n++) {
+        if (!banco->activo[n])
+            continue;
+
+        const float b0 = banco->b0[n], b1 = banco->b1[n], b2 = banco->b2[n], a2 = banco->a2[n];
+        float *estado1 = &banco->estado1[n][canal];
+        float *estado2 = &banco->estado2[n][canal];
+
+        for (uint8_t c = 0; c < numCanales; c++) {
+            const float entrada = muestras[c];
+            const float salida = b0 * entrada + estado1[c];
+
+            estado1[c] = b1 * (entrada - salida) + estado2[c];
+            estado2[c] = b2 * entrada - a2 * salida;
+            muestras[c] = salida;
+        }
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t notchActivosBancoNotchRPM(const bancoNotchRPM_t *banco)
+**  Descripcion:    Cuenta los notch que estan filtrando
+**  Parametros:     Puntero al banco
+**  Retorno:        Notch activos
+****************************************************************************************/
+uint8_t notchActivosBancoNotchRPM(const bancoNotchRPM_t *banco)
+{
+    uint8_t activos = 0;
+
+    for (uint8_t n = 0; n < banco->numNotch; n++)
+        activos += banco->activo[n];
+
+    return activos;
+}
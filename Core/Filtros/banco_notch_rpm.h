@@ -0,0 +1,104 @@
+/***************************************************************************************
+**  banco_notch_rpm.h - Banco de notch que siguen los armonicos de giro de los motores
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __BANCO_NOTCH_RPM_H
+#define __BANCO_NOTCH_RPM_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Un notch por motor y armonico, en cascada sobre cada canal (ejes del giro). Todos los
+ * canales comparten los coeficientes de cada notch y el estado es propio de cada canal.
+ * El ancho de banda es proporcional a la frecuencia, asi que A y Q son constantes y al
+ * mover un notch solo hay que calcular el seno y el coseno de su frecuencia, con la
+ * aproximacion de senoCosenoRapido. En cada paso se reajustan como mucho ajustesPorPaso
+ * notch, por turnos, para que el coste no crezca con el numero de motores. Un notch cuya
+ * frecuencia no es valida o esta por debajo del minimo deja pasar la senial y no se
+ * calcula
+ */
+#define NUM_MAX_MOTORES_NOTCH_RPM             12
+#define NUM_MAX_ARMONICOS_NOTCH_RPM           3
+#define NUM_MAX_NOTCH_RPM                     (NUM_MAX_MOTORES_NOTCH_RPM * NUM_MAX_ARMONICOS_NOTCH_RPM)
+#ifndef NUM_MAX_CANALES_NOTCH_RPM
+#define NUM_MAX_CANALES_NOTCH_RPM             15
+#endif
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+// Frecuencia de giro de un motor en Hz. Devuelve false si no hay dato valido
+typedef bool (*fnFrecuenciaRotor_t)(uint8_t motor, float *frecuencia);
+
+typedef struct {
+    uint8_t numCanales;
+    uint8_t numMotores;
+    uint8_t numArmonicos;
+    uint8_t numNotch;
+    uint8_t armonico[NUM_MAX_ARMONICOS_NOTCH_RPM];          // Multiplo de la frecuencia de giro
+    uint8_t ajustesPorPaso;
+    uint8_t siguiente;                                      // Proximo notch a reajustar
+    float frecMuestreo;
+    float frecMin;
+    float frecMax;                                          // Limite de Nyquist
+    float A2;                                               // Cuadrado de la atenuacion
+    float inv2Q;
+    fnFrecuenciaRotor_t fuente;
+    uint32_t ajustes;
+
+    bool activo[NUM_MAX_NOTCH_RPM];
+    float b0[NUM_MAX_NOTCH_RPM];                            // a0 = 1 y a1 = b1
+    float b1[NUM_MAX_NOTCH_RPM];
+    float b2[NUM_MAX_NOTCH_RPM];
+    float a2[NUM_MAX_NOTCH_RPM];
+    float estado1[NUM_MAX_NOTCH_RPM][NUM_MAX_CANALES_NOTCH_RPM];
+    float estado2[NUM_MAX_NOTCH_RPM][NUM_MAX_CANALES_NOTCH_RPM];
+} bancoNotchRPM_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool iniciarBancoNotchRPM(bancoNotchRPM_t *banco, uint8_t numCanales, uint8_t numMotores, uint8_t armonicos,
+                          float frecMuestreo, float frecMin, float anchoBanda, float atenuacionDB,
+                          uint8_t ajustesPorPaso, fnFrecuenciaRotor_t fuente);
+uint8_t ajustarBancoNotchRPM(bancoNotchRPM_t *banco);
+void resetearBancoNotchRPM(bancoNotchRPM_t *banco);
+void actualizarCanalesBancoNotchRPM(bancoNotchRPM_t *banco, uint8_t canal, uint8_t numCanales, float *muestras);
+uint8_t notchActivosBancoNotchRPM(const bancoNotchRPM_t *banco);
+
+#endif // __BANCO_NOTCH_RPM_H
@@ -50,7 +50,6 @@
 /***************************************************************************************
 ** AREA DE PROTOTIPOS DE FUNCION                                                      **
 ****************************************************************************************/
-void calcularAQfiltroNotch(float frecCentral, float anchoBandaHz, float atenuacionDB, float *A, float *Q);
 void ajustarFiltroNotchConAQ(filtroNotch_t *filtro, float frecMuestreo, float frecCentral, float A, float Q);
 
 
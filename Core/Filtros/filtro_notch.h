@@ -74,6 +74,7 @@ typedef struct {
 /***************************************************************************************
 ** AREA DE PROTOTIPOS DE FUNCION                                                      **
 ****************************************************************************************/
+void calcularAQfiltroNotch(float frecCentral, float anchoBandaHz, float atenuacionDB, float *A, float *Q);
 void ajustarFiltroNotch(filtroNotch_t *filtro, float frecCentral, float frecMuestreo, float anchoBandaHz, float atenuacionDB);
 void actualizarFrecFiltroNotch(filtroNotch_t *filtro, float frecCentral);
 void resetearFiltroNotch(filtroNotch_t *filtro);
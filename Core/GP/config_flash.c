@@ -27,9 +27,8 @@
 ** AREA DE INCLUDES                                                                   **
 ****************************************************************************************/
 #include "config_flash.h"
-#include "gp.h"
+#include "diario_config.h"
 #include "Comun/util.h"
-#include "Comun/crc.h"
 #include "Drivers/flash.h"
 #include "Core/fallo_sistema.h"
 
@@ -37,48 +36,24 @@
 /***************************************************************************************
 ** AREA DE PREPROCESADOR                                                              **
 ****************************************************************************************/
-#define MASCARA_CLASIFICACION_CR_CONFIG_FLASH  0x03
-#define VALOR_INICIO_CRC_CONFIG_FLASH          0xFFFF
-#define VALOR_CHEQUEO_CRC_CONFIG_FLASH         0x1D0F   // Valor pre-calculado del CRC que lo incluye a si mismo
 
 
 /***************************************************************************************
 ** AREA DE DEFINICION DE TIPOS                                                        **
 ****************************************************************************************/
-typedef struct {                         // Cabecera de la zona de configuracion
-    uint8_t versionFlashConfig;
-    uint8_t magicoBE;                    // Numero magico, debe ser 0xBE
-} PACKED cabeceraConfig_t;
-
-typedef struct {                         // Cabecera de cada GP
-    uint16_t tam;
-    uint16_t gpn;
-    uint8_t version;
-    uint8_t flags;                       // Los 2 bits mas bajos indican el sistema o el numero del perfil, ver MASCARA_CLASIFICACION_CR_CONFIG_FLASH
-    uint8_t gp[];
-} PACKED configRegistro_t;
-
-typedef struct {                         // Terminacion de la zona de configuracion
-    uint16_t terminador;
-} PACKED terminacionConfig_t;            // El checksum se aplica despues de esto, no se incluye el terminador en el calculo
-
 typedef struct {
     uint8_t byte;
     uint32_t word;
 } PACKED packingTest_t;
 
-typedef enum {
-    SISTEMA_CLASIFICACION_CR = 0,
-    ULTIMO_PERFIL_CLASIFICACION_CR = SISTEMA_CLASIFICACION_CR,
-} flagsConfigRegistro_e;
-
 
 /***************************************************************************************
 ** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
 extern uint8_t inicioRegionConfig;       // Variables del Linker
 extern uint8_t finRegionConfig;
-static uint16_t tamConfigFlash;
+static dispositivoDiarioConfig_t dispositivoConfig;
+static diarioConfig_t diarioConfig;
 
 
 /***************************************************************************************
@@ -86,8 +61,8 @@ static uint16_t tamConfigFlash;
 ****************************************************************************************/
 void escribirConfigEnFlash(void);
 bool escribirAjustesEnFlash(void);
-bool estructuraFlashConfigValida(void);
-const configRegistro_t *encontrarRegFlashConfig(const registroGP_t *reg, flagsConfigRegistro_e clasificacion);
+int32_t borrarSectorConfigFlash(uint8_t numSector);
+int32_t programarConfigFlash(const uint8_t *dir, const uint32_t *dato, uint32_t numWords);
 
 
 /***************************************************************************************
@@ -96,8 +71,8 @@ const configRegistro_t *encontrarRegFlashConfig(const registroGP_t *reg, flagsCo
 
 /***************************************************************************************
 **  Nombre:         void iniciarConfigFlash(void)
-**  Descripcion:    Comprueba la estructura de la flash de los GP y testea el
-**                  tamanio de los datos
+**  Descripcion:    Abre el diario de la zona de configuracion y testea el tamanio de los
+**                  datos
 **  Parametros:     Ninguno
 **  Retorno:        Ninguno
 ****************************************************************************************/
@@ -107,10 +82,16 @@ void iniciarConfigFlash(void)
     STATIC_ASSERT(offsetof(packingTest_t, byte) == 0, test_byte_packing_fallido);
     STATIC_ASSERT(offsetof(packingTest_t, word) == 1, test_word_packing_fallido);
     STATIC_ASSERT(sizeof(packingTest_t) == 5, fallo_packing_general);
-    STATIC_ASSERT(sizeof(terminacionConfig_t) == 2, fallo_tamanio_terminador);
-    STATIC_ASSERT(sizeof(configRegistro_t) == 6, fallo_tamanio_registro);
 
-    if (estructuraFlashConfigValida())
+    // La zona de configuracion son dos sectores de la flash
+    const uint32_t tamSector = (&finRegionConfig - &inicioRegionConfig) / 2;
+    dispositivoConfig.sector[0] = &inicioRegionConfig;
+    dispositivoConfig.sector[1] = &inicioRegionConfig + tamSector;
+    dispositivoConfig.tamSector = tamSector;
+    dispositivoConfig.borrar = borrarSectorConfigFlash;
+    dispositivoConfig.programar = programarConfigFlash;
+
+    if (abrirDiarioConfig(&diarioConfig, &dispositivoConfig, VERSION_CONFIG_FLASH))
         return;
 
     resetearConfigFlash();
@@ -119,7 +100,7 @@ void iniciarConfigFlash(void)
 
 /***************************************************************************************
 **  Nombre:         bool cargarConfigFlash(void)
-**  Descripcion:    Inicia todos los pregistros. Se escanea uno a uno y se cargan en el programa
+**  Descripcion:    Inicia todos los pregistros con su registro vivo del diario
 **  Parametros:     Ninguno
 **  Retorno:        True si ok
 ****************************************************************************************/
@@ -128,9 +109,11 @@ bool cargarConfigFlash(void)
     bool estado = true;
 
     POR_CADA_GP(reg) {
-        const configRegistro_t *rec = encontrarRegFlashConfig(reg, SISTEMA_CLASIFICACION_CR);
-        if (rec) {
-            if (!cargarGP(reg, rec->gp, rec->tam - offsetof(configRegistro_t, gp), rec->version))
+        uint16_t tam;
+        uint8_t version;
+        const uint8_t *dato = leerDiarioConfig(&diarioConfig, numeroGP(reg), &tam, &version);
+        if (dato) {
+            if (!cargarGP(reg, dato, tam, version))
                 estado = false;
         }
         else {
@@ -164,166 +147,98 @@ void resetearConfigFlash(void)
 ****************************************************************************************/
 bool versionValidaConfigFlash(void)
 {
-    const uint8_t *p = &inicioRegionConfig;
-    const cabeceraConfig_t *cabecera = (const cabeceraConfig_t *)p;
+    // Solo se abren sectores de esta version
+    return diarioConfig.abierto && diarioConfig.version == VERSION_CONFIG_FLASH;
+}
 
-    if (cabecera->versionFlashConfig != VERSION_CONFIG_FLASH)
-        return false;
 
-    return true;
+/***************************************************************************************
+**  Nombre:         bool guardarGPConfigFlash(const registroGP_t *reg, bool permitirBorrado)
+**  Descripcion:    Anade el GP al diario si ha cambiado. Sin permiso para borrar solo se
+**                  programan unas words, por lo que se puede llamar con los motores en marcha
+**  Parametros:     Registro a guardar, permitir borrar un sector si hay que compactar
+**  Retorno:        True si el GP queda guardado
+****************************************************************************************/
+bool guardarGPConfigFlash(const registroGP_t *reg, bool permitirBorrado)
+{
+    const estadoDiarioConfig_e estado = escribirDiarioConfig(&diarioConfig, numeroGP(reg), versionGP(reg), reg->dir,
+                                                             tamanioGP(reg), permitirBorrado);
+
+    return estado != DIARIO_CONFIG_LLENO && estado != DIARIO_CONFIG_ERROR;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool guardarConfigFlash(bool permitirBorrado)
+**  Descripcion:    Anade al diario los GP que han cambiado
+**  Parametros:     Permitir borrar un sector si hay que compactar
+**  Retorno:        True si quedan todos guardados
+****************************************************************************************/
+bool guardarConfigFlash(bool permitirBorrado)
+{
+    bool estado = true;
+
+    POR_CADA_GP(reg) {
+        if (!guardarGPConfigFlash(reg, permitirBorrado))
+            estado = false;
+    }
+
+    return estado;
 }
 
 
 /***************************************************************************************
 **  Nombre:         void escribirConfigEnFlash(void)
-**  Descripcion:    Escribe la configuracion en la flash y comprueba la version y la estructura
+**  Descripcion:    Escribe la configuracion en un diario nuevo
 **  Parametros:     Ninguno
 **  Retorno:        Ninguno
 ****************************************************************************************/
 void escribirConfigEnFlash(void)
 {
-    bool estado = false;
-
-    for (uint8_t i = 0; i < 3 && !estado; i++) {
+    for (uint8_t i = 0; i < 3; i++) {
         if (escribirAjustesEnFlash())
-            estado = true;
+            return;
     }
 
-    if (estado && versionValidaConfigFlash() && estructuraFlashConfigValida())
-        return;
-
     // Fallo en la escritura de la Flash
     falloSistema(FALLO_ESCRITURA_FLASH);
-
 }
 
 
 /***************************************************************************************
 **  Nombre:         bool escribirAjustesEnFlash(void)
-**  Descripcion:    Escribe los ajustes en la flash
+**  Descripcion:    Empieza un diario vacio y escribe todos los GP
 **  Parametros:     Ninguno
 **  Retorno:        True si ok
 ****************************************************************************************/
 bool escribirAjustesEnFlash(void)
 {
-    grabadorFlash_t grabador;
-
-    resetearGrabadorFlash(&grabador);
-    desbloquearGrabadorFlash(&grabador, (uintptr_t)&inicioRegionConfig, &finRegionConfig - &inicioRegionConfig);
-
-    cabeceraConfig_t cabecera = {
-        .versionFlashConfig = VERSION_CONFIG_FLASH,
-        .magicoBE = 0xBE,
-    };
-
-    escribirGrabadorFlash(&grabador, (uint8_t *)&cabecera, sizeof(cabecera));
-    uint16_t crc = VALOR_INICIO_CRC_CONFIG_FLASH;
-    crc = calcularCRC16(crc, (uint8_t *)&cabecera, sizeof(cabecera));
-    POR_CADA_GP(reg) {
-        const uint16_t tamReg = tamanioGP(reg);
-        configRegistro_t registro = {
-            .tam = sizeof(configRegistro_t) + tamReg,
-            .gpn = numeroGP(reg),
-            .version = versionGP(reg),
-            .flags = 0
-        };
-
-        registro.flags |= SISTEMA_CLASIFICACION_CR;
-        escribirGrabadorFlash(&grabador, (uint8_t *)&registro, sizeof(registro));
-        crc = calcularCRC16(crc, (uint8_t *)&registro, sizeof(registro));
-        escribirGrabadorFlash(&grabador, reg->dir, tamReg);
-        crc = calcularCRC16(crc, reg->dir, tamReg);
-    }
-
-    terminacionConfig_t terminador = {
-        .terminador = 0,
-    };
-
-    escribirGrabadorFlash(&grabador, (uint8_t *)&terminador, sizeof(terminador));
-    crc = calcularCRC16(crc, (uint8_t *)&terminador, sizeof(terminador));
-
-    // Incluye el CRC invertido en big endian
-    const uint16_t crcInvertidoBigEndian = ~(((crc & 0xFF) << 8) | (crc >> 8));
-    escribirGrabadorFlash(&grabador, (uint8_t *)&crcInvertidoBigEndian, sizeof(crc));
-
-    flushGrabadorFlash(&grabador);
-
-    const bool estado = bloquearGrabadorFlash(&grabador) == 0;
-    return estado;
+    if (!formatearDiarioConfig(&diarioConfig))
+        return false;
 
+    return guardarConfigFlash(true);
 }
 
 
 /***************************************************************************************
-**  Nombre:         bool estructuraFlashConfigValida(void)
-**  Descripcion:    Comprueba la estructura de la zona de configuracion
-**  Parametros:     Ninguno
-**  Retorno:        True si ok
+**  Nombre:         int32_t borrarSectorConfigFlash(uint8_t numSector)
+**  Descripcion:    Borra uno de los sectores de la zona de configuracion
+**  Parametros:     Numero de sector
+**  Retorno:        0 si ok
 ****************************************************************************************/
-bool estructuraFlashConfigValida(void)
+int32_t borrarSectorConfigFlash(uint8_t numSector)
 {
-    const uint8_t *p = &inicioRegionConfig;
-    const cabeceraConfig_t *cabecera = (const cabeceraConfig_t *)p;
-
-    if (cabecera->magicoBE != 0xBE)
-        return false;
-
-    uint16_t crc = VALOR_INICIO_CRC_CONFIG_FLASH;
-    crc = calcularCRC16(crc, cabecera, sizeof(*cabecera));
-    p += sizeof(*cabecera);
-
-    while (1) {
-        const configRegistro_t *registro = (const configRegistro_t *)p;
-
-        // Encontrado el fin
-        if (registro->tam == 0)
-            break;
-
-        // Muy alto o muy pequeno
-        if (p + registro->tam >= &finRegionConfig || registro->tam < sizeof(*registro))
-            return false;
-
-        crc = calcularCRC16(crc, p, registro->tam);
-        p += registro->tam;
-    }
-
-    const terminacionConfig_t *terminacion = (const terminacionConfig_t *)p;
-    crc = calcularCRC16(crc, terminacion, sizeof(*terminacion));
-    p += sizeof(*terminacion);
-
-    // Incluye el CRC guardado en el calculo
-    const uint16_t *crcGuardado = (const uint16_t *)p;
-    crc = calcularCRC16(crc, crcGuardado, sizeof(*crcGuardado));
-    p += sizeof(crcGuardado);
-
-    tamConfigFlash = p - &inicioRegionConfig;
-
-    return crc == VALOR_CHEQUEO_CRC_CONFIG_FLASH;
+    return borrarSectorFlash((uintptr_t)dispositivoConfig.sector[numSector]);
 }
 
 
 /***************************************************************************************
-**  Nombre:         configRegistro_t *encontrarRegFlashConfig(const registroGP_t *reg, flagsConfigRegistro_e clasificacion)
-**  Descripcion:    Encuentra un registro en la zona de configuracion
-**  Parametros:     Registro a encontrar, clasificacion
-**  Retorno:        Registro de configuracion
+**  Nombre:         int32_t programarConfigFlash(const uint8_t *dir, const uint32_t *dato, uint32_t numWords)
+**  Descripcion:    Programa words en la zona de configuracion
+**  Parametros:     Direccion, datos, numero de words
+**  Retorno:        0 si ok
 ****************************************************************************************/
-const configRegistro_t *encontrarRegFlashConfig(const registroGP_t *reg, flagsConfigRegistro_e clasificacion)
+int32_t programarConfigFlash(const uint8_t *dir, const uint32_t *dato, uint32_t numWords)
 {
-    const uint8_t *p = &inicioRegionConfig;
-
-    p += sizeof(cabeceraConfig_t);
-    while (1) {
-        const configRegistro_t *rec = (const configRegistro_t *)p;
-        if (rec->tam == 0 || p + rec->tam >= &finRegionConfig || rec->tam < sizeof(*rec))
-            break;
-
-        if (numeroGP(reg) == rec->gpn && (rec->flags & MASCARA_CLASIFICACION_CR_CONFIG_FLASH) == clasificacion)
-            return rec;
-
-        p += rec->tam;
-    }
-    // Registro no encontrado
-    return NULL;
+    return programarFlash((uintptr_t)dir, dato, numWords);
 }
-
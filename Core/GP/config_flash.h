@@ -32,12 +32,13 @@
 #include <stdbool.h>
 
 #include "Sistema/plataforma.h"
+#include "gp.h"
 
 
 /***************************************************************************************
 ** AREA DE PREPROCESADOR                                                              **
 ****************************************************************************************/
-#define VERSION_CONFIG_FLASH           1
+#define VERSION_CONFIG_FLASH           2
 
 
 /***************************************************************************************
@@ -57,6 +58,8 @@ void iniciarConfigFlash(void);
 bool cargarConfigFlash(void);
 void resetearConfigFlash(void);
 bool versionValidaConfigFlash(void);
+bool guardarGPConfigFlash(const registroGP_t *reg, bool permitirBorrado);
+bool guardarConfigFlash(bool permitirBorrado);
 
 #endif // __CONFIG_FLASH_H
 
@@ -0,0 +1,530 @@
+/***************************************************************************************
+**  diario_config.c - Diario de registros de configuracion con nivelacion de desgaste
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stddef.h>
+#include <string.h>
+
+#include "diario_config.h"
+#include "Comun/util.h"
+#include "Comun/crc.h"
+#include "Comun/matematicas.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define MAGICO_DIARIO_CONFIG            0xBE
+#define SELLO_DIARIO_CONFIG             0x5E11AD05
+#define CONFIRMACION_DIARIO_CONFIG      0xC0F1AD05
+#define VALOR_INICIO_CRC_DIARIO_CONFIG  0xFFFF
+#define WORD_BORRADA_DIARIO_CONFIG      0xFFFFFFFF
+#define WORDS_BLOQUE_DIARIO_CONFIG      16
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {                         // Cabecera de cada sector
+    uint8_t versionFlashConfig;
+    uint8_t magicoBE;                    // Numero magico, debe ser 0xBE
+    uint16_t generacion;                 // El sector con la mayor es el activo
+    uint32_t sello;                      // SELLO_DIARIO_CONFIG cuando el sector esta completo
+} PACKED cabeceraDiarioConfig_t;
+
+typedef struct {                         // Cabecera de cada registro. Los datos van detras
+    uint16_t tam;                        // Bytes de datos
+    uint16_t gpn;
+    uint8_t version;
+    uint8_t flags;
+    uint16_t crc;                        // De la cabecera sin el CRC y de los datos
+    uint32_t secuencia;
+    uint32_t confirmacion;               // CONFIRMACION_DIARIO_CONFIG cuando los datos estan completos
+    uint8_t dato[];
+} PACKED registroDiarioConfig_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool sectorValidoDiarioConfig(const diarioConfig_t *diario, uint8_t numSector);
+void escanearSectorDiarioConfig(diarioConfig_t *diario);
+bool nuevoSectorDiarioConfig(diarioConfig_t *diario, bool copiarVivos);
+bool programarRegistroDiarioConfig(diarioConfig_t *diario, uint8_t numSector, uint32_t offset,
+                                   const registroDiarioConfig_t *cabecera, const uint8_t *dato);
+int16_t indiceGPDiarioConfig(diarioConfig_t *diario, uint16_t gpn, bool crear);
+uint16_t crcRegistroDiarioConfig(const registroDiarioConfig_t *cabecera, const uint8_t *dato);
+bool zonaBorradaDiarioConfig(const uint8_t *dir, uint32_t tam);
+static inline const cabeceraDiarioConfig_t *cabeceraDiarioConfig(const diarioConfig_t *diario, uint8_t numSector);
+static inline const registroDiarioConfig_t *registroDiarioConfig(const diarioConfig_t *diario, uint32_t offset);
+static inline uint32_t tamRegistroDiarioConfig(uint16_t tam);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool abrirDiarioConfig(diarioConfig_t *diario, const dispositivoDiarioConfig_t *dispositivo, uint8_t version)
+**  Descripcion:    Busca el sector activo y lo recorre una vez para indexar el registro vivo
+**                  de cada GP
+**  Parametros:     Diario, dispositivo de flash, version de la zona de configuracion
+**  Retorno:        True si hay un sector activo
+****************************************************************************************/
+bool abrirDiarioConfig(diarioConfig_t *diario, const dispositivoDiarioConfig_t *dispositivo, uint8_t version)
+{
+    STATIC_ASSERT(sizeof(cabeceraDiarioConfig_t) == 8, fallo_tamanio_cabecera_diario);
+    STATIC_ASSERT(sizeof(registroDiarioConfig_t) == 16, fallo_tamanio_registro_diario);
+
+    memset(diario, 0, sizeof(*diario));
+    diario->dispositivo = dispositivo;
+    diario->version = version;
+
+    const bool valido[2] = {
+        sectorValidoDiarioConfig(diario, 0),
+        sectorValidoDiarioConfig(diario, 1),
+    };
+
+    if (!valido[0] && !valido[1])
+        return false;
+
+    // Si los dos estan sellados el activo es el de la generacion mas reciente
+    if (valido[0] && valido[1])
+        diario->activo = (int16_t)(cabeceraDiarioConfig(diario, 1)->generacion - cabeceraDiarioConfig(diario, 0)->generacion) > 0;
+    else
+        diario->activo = valido[1];
+
+    diario->generacion = cabeceraDiarioConfig(diario, diario->activo)->generacion;
+    diario->abierto = true;
+    escanearSectorDiarioConfig(diario);
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool formatearDiarioConfig(diarioConfig_t *diario)
+**  Descripcion:    Empieza un diario vacio en el sector que no esta activo
+**  Parametros:     Diario
+**  Retorno:        True si ok
+****************************************************************************************/
+bool formatearDiarioConfig(diarioConfig_t *diario)
+{
+    return nuevoSectorDiarioConfig(diario, false);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool compactarDiarioConfig(diarioConfig_t *diario)
+**  Descripcion:    Copia los registros vivos al otro sector. Es la unica operacion que borra
+**  Parametros:     Diario
+**  Retorno:        True si ok
+****************************************************************************************/
+bool compactarDiarioConfig(diarioConfig_t *diario)
+{
+    if (!nuevoSectorDiarioConfig(diario, true))
+        return false;
+
+    diario->compactaciones++;
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         const uint8_t *leerDiarioConfig(const diarioConfig_t *diario, uint16_t gpn, uint16_t *tam, uint8_t *version)
+**  Descripcion:    Devuelve los datos del registro vivo de un GP
+**  Parametros:     Diario, numero del GP, tamanio de los datos, version del GP
+**  Retorno:        Puntero a los datos en la flash o NULL si no hay registro
+****************************************************************************************/
+const uint8_t *leerDiarioConfig(const diarioConfig_t *diario, uint16_t gpn, uint16_t *tam, uint8_t *version)
+{
+    if (!diario->abierto)
+        return NULL;
+
+    for (uint8_t i = 0; i < diario->numGP; i++) {
+        if (diario->gpn[i] != gpn || diario->offset[i] == 0)
+            continue;
+
+        const registroDiarioConfig_t *registro = registroDiarioConfig(diario, diario->offset[i]);
+        *tam = registro->tam;
+        *version = registro->version;
+        return registro->dato;
+    }
+
+    return NULL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         estadoDiarioConfig_e escribirDiarioConfig(diarioConfig_t *diario, uint16_t gpn, uint8_t version,
+**                                                            const void *dato, uint16_t tam, bool permitirBorrado)
+**  Descripcion:    Anade un registro al final del diario si los datos han cambiado. Si no
+**                  cabe compacta antes, solo si se permite borrar
+**  Parametros:     Diario, numero del GP, version del GP, datos, tamanio, permitir borrar
+**  Retorno:        Estado de la escritura
+****************************************************************************************/
+estadoDiarioConfig_e escribirDiarioConfig(diarioConfig_t *diario, uint16_t gpn, uint8_t version, const void *dato,
+                                          uint16_t tam, bool permitirBorrado)
+{
+    if (!diario->abierto || tam > TAM_MAX_DATO_DIARIO_CONFIG)
+        return DIARIO_CONFIG_ERROR;
+
+    const int16_t indice = indiceGPDiarioConfig(diario, gpn, true);
+    if (indice < 0)
+        return DIARIO_CONFIG_ERROR;
+
+    // No se gasta flash si el registro vivo ya tiene esos datos
+    if (diario->offset[indice] != 0) {
+        const registroDiarioConfig_t *vivo = registroDiarioConfig(diario, diario->offset[indice]);
+        if (vivo->version == version && vivo->tam == tam && memcmp(vivo->dato, dato, tam) == 0)
+            return DIARIO_CONFIG_SIN_CAMBIOS;
+    }
+
+    estadoDiarioConfig_e estado = DIARIO_CONFIG_ESCRITO;
+    const uint32_t tamRegistro = tamRegistroDiarioConfig(tam);
+
+    if (diario->libre + tamRegistro > diario->dispositivo->tamSector) {
+        if (!permitirBorrado)
+            return DIARIO_CONFIG_LLENO;
+
+        if (!compactarDiarioConfig(diario) || diario->libre + tamRegistro > diario->dispositivo->tamSector)
+            return DIARIO_CONFIG_ERROR;
+
+        estado = DIARIO_CONFIG_COMPACTADO;
+    }
+
+    registroDiarioConfig_t cabecera = {
+        .tam = tam,
+        .gpn = gpn,
+        .version = version,
+        .flags = 0,
+        .secuencia = diario->secuencia,
+        .confirmacion = CONFIRMACION_DIARIO_CONFIG,
+    };
+    cabecera.crc = crcRegistroDiarioConfig(&cabecera, dato);
+
+    // Lo programado no se puede reutilizar aunque falle la escritura
+    const uint32_t offset = diario->libre;
+    diario->libre += tamRegistro;
+    diario->secuencia++;
+
+    if (!programarRegistroDiarioConfig(diario, diario->activo, offset, &cabecera, dato)) {
+        // Se cierra el sector para que la siguiente escritura compacte
+        diario->libre = diario->dispositivo->tamSector;
+        return DIARIO_CONFIG_ERROR;
+    }
+
+    diario->offset[indice] = offset;
+    return estado;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t bytesLibresDiarioConfig(const diarioConfig_t *diario)
+**  Descripcion:    Devuelve los bytes que quedan en el sector activo
+**  Parametros:     Diario
+**  Retorno:        Bytes libres
+****************************************************************************************/
+uint32_t bytesLibresDiarioConfig(const diarioConfig_t *diario)
+{
+    if (!diario->abierto)
+        return 0;
+
+    return diario->dispositivo->tamSector - diario->libre;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool sectorValidoDiarioConfig(const diarioConfig_t *diario, uint8_t numSector)
+**  Descripcion:    Comprueba la cabecera y el sello de un sector
+**  Parametros:     Diario, numero de sector
+**  Retorno:        True si el sector esta completo y es de esta version
+****************************************************************************************/
+bool sectorValidoDiarioConfig(const diarioConfig_t *diario, uint8_t numSector)
+{
+    const cabeceraDiarioConfig_t *cabecera = cabeceraDiarioConfig(diario, numSector);
+
+    return cabecera->magicoBE == MAGICO_DIARIO_CONFIG && cabecera->versionFlashConfig == diario->version &&
+           cabecera->sello == SELLO_DIARIO_CONFIG;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void escanearSectorDiarioConfig(diarioConfig_t *diario)
+**  Descripcion:    Recorre el sector activo, indexa el registro vivo de cada GP y busca el
+**                  final del diario
+**  Parametros:     Diario
+**  Retorno:        Ninguno
+****************************************************************************************/
+void escanearSectorDiarioConfig(diarioConfig_t *diario)
+{
+    const uint8_t *sector = diario->dispositivo->sector[diario->activo];
+    const uint32_t tamSector = diario->dispositivo->tamSector;
+    uint32_t offset = sizeof(cabeceraDiarioConfig_t);
+    bool primero = true;
+
+    while (offset + sizeof(registroDiarioConfig_t) <= tamSector) {
+        const registroDiarioConfig_t *registro = (const registroDiarioConfig_t *)(sector + offset);
+
+        // Final del diario
+        if (zonaBorradaDiarioConfig(sector + offset, sizeof(*registro)))
+            break;
+
+        // Con la cabecera rota no se sabe donde sigue. Se cierra el sector y la siguiente
+        // escritura compacta
+        const uint32_t tamRegistro = tamRegistroDiarioConfig(registro->tam);
+        if (registro->tam > TAM_MAX_DATO_DIARIO_CONFIG || offset + tamRegistro > tamSector) {
+            offset = tamSector;
+            break;
+        }
+
+        // Un registro cortado por una perdida de alimentacion se salta. Sin la confirmacion
+        // el CRC de 16 bits dejaria pasar uno de cada 65536
+        if (registro->confirmacion != CONFIRMACION_DIARIO_CONFIG ||
+            registro->crc != crcRegistroDiarioConfig(registro, registro->dato)) {
+            diario->descartados++;
+            offset += tamRegistro;
+            continue;
+        }
+
+        const int16_t indice = indiceGPDiarioConfig(diario, registro->gpn, true);
+        if (indice >= 0) {
+            const uint32_t vivo = diario->offset[indice];
+            if (vivo == 0 || (int32_t)(registro->secuencia - registroDiarioConfig(diario, vivo)->secuencia) > 0)
+                diario->offset[indice] = offset;
+        }
+
+        if (primero || (int32_t)(registro->secuencia - diario->secuencia) >= 0)
+            diario->secuencia = registro->secuencia + 1;
+
+        primero = false;
+        offset += tamRegistro;
+    }
+
+    diario->libre = offset;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool nuevoSectorDiarioConfig(diarioConfig_t *diario, bool copiarVivos)
+**  Descripcion:    Borra el sector que no esta activo, copia en el los registros vivos si se
+**                  pide y lo sella. Hasta el sello sigue valiendo el sector anterior
+**  Parametros:     Diario, copiar los registros vivos
+**  Retorno:        True si ok
+****************************************************************************************/
+bool nuevoSectorDiarioConfig(diarioConfig_t *diario, bool copiarVivos)
+{
+    const dispositivoDiarioConfig_t *dispositivo = diario->dispositivo;
+    const uint8_t destino = diario->abierto ? diario->activo ^ 1 : 0;
+    const uint8_t *sector = dispositivo->sector[destino];
+    uint32_t offsetNuevo[NUM_MAX_GP_DIARIO_CONFIG];
+    uint32_t libre = sizeof(cabeceraDiarioConfig_t);
+
+    if (dispositivo->borrar(destino) != 0 || !zonaBorradaDiarioConfig(sector, dispositivo->tamSector))
+        return false;
+
+    const cabeceraDiarioConfig_t cabecera = {
+        .versionFlashConfig = diario->version,
+        .magicoBE = MAGICO_DIARIO_CONFIG,
+        .generacion = diario->generacion + 1,
+        .sello = WORD_BORRADA_DIARIO_CONFIG,
+    };
+
+    uint32_t word;
+    memcpy(&word, &cabecera, sizeof(word));
+    if (dispositivo->programar(sector, &word, 1) != 0)
+        return false;
+
+    for (uint8_t i = 0; i < diario->numGP; i++) {
+        offsetNuevo[i] = 0;
+        if (!copiarVivos || !diario->abierto || diario->offset[i] == 0)
+            continue;
+
+        const registroDiarioConfig_t *registro = registroDiarioConfig(diario, diario->offset[i]);
+        if (!programarRegistroDiarioConfig(diario, destino, libre, registro, registro->dato))
+            return false;
+
+        offsetNuevo[i] = libre;
+        libre += tamRegistroDiarioConfig(registro->tam);
+    }
+
+    // El sello se graba el ultimo
+    word = SELLO_DIARIO_CONFIG;
+    if (dispositivo->programar(sector + offsetof(cabeceraDiarioConfig_t, sello), &word, 1) != 0 ||
+        !sectorValidoDiarioConfig(diario, destino))
+        return false;
+
+    diario->activo = destino;
+    diario->generacion = cabecera.generacion;
+    diario->abierto = true;
+    diario->libre = libre;
+    memcpy(diario->offset, offsetNuevo, diario->numGP * sizeof(offsetNuevo[0]));
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool programarRegistroDiarioConfig(diarioConfig_t *diario, uint8_t numSector, uint32_t offset,
+**                                                     const registroDiarioConfig_t *cabecera, const uint8_t *dato)
+**  Descripcion:    Programa un registro por bloques de words, despues su confirmacion y
+**                  comprueba lo grabado
+**  Parametros:     Diario, numero de sector, offset en el sector, cabecera, datos
+**  Retorno:        True si ok
+****************************************************************************************/
+bool programarRegistroDiarioConfig(diarioConfig_t *diario, uint8_t numSector, uint32_t offset,
+                                   const registroDiarioConfig_t *cabecera, const uint8_t *dato)
+{
+    const dispositivoDiarioConfig_t *dispositivo = diario->dispositivo;
+    const uint8_t *dir = dispositivo->sector[numSector] + offset;
+    uint32_t bloque[WORDS_BLOQUE_DIARIO_CONFIG];
+    uint8_t *b = (uint8_t *)bloque;
+    const uint8_t *p = dato;
+    uint32_t pendiente = cabecera->tam;
+    uint32_t enBloque = sizeof(*cabecera);
+
+    // Los datos pueden no estar alineados. Se pasan por RAM y se rellena la ultima word
+    memcpy(b, cabecera, sizeof(*cabecera));
+    bloque[offsetof(registroDiarioConfig_t, confirmacion) / 4] = WORD_BORRADA_DIARIO_CONFIG;
+    while (pendiente > 0 || enBloque > 0) {
+        const uint32_t num = MIN(pendiente, sizeof(bloque) - enBloque);
+        memcpy(b + enBloque, p, num);
+        p += num;
+        pendiente -= num;
+        enBloque += num;
+
+        const uint32_t numWords = (enBloque + 3) / 4;
+        memset(b + enBloque, 0, numWords * 4 - enBloque);
+        if (dispositivo->programar(dir, bloque, numWords) != 0)
+            return false;
+
+        dir += numWords * 4;
+        enBloque = 0;
+    }
+
+    // Los programados siguen un orden, asi que con la confirmacion grabada el resto esta completo
+    const uint32_t confirmacion = CONFIRMACION_DIARIO_CONFIG;
+    dir = dispositivo->sector[numSector] + offset + offsetof(registroDiarioConfig_t, confirmacion);
+    if (dispositivo->programar(dir, &confirmacion, 1) != 0)
+        return false;
+
+    const registroDiarioConfig_t *grabado = (const registroDiarioConfig_t *)(dispositivo->sector[numSector] + offset);
+    return memcmp(grabado, cabecera, sizeof(*cabecera)) == 0 && memcmp(grabado->dato, dato, cabecera->tam) == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         int16_t indiceGPDiarioConfig(diarioConfig_t *diario, uint16_t gpn, bool crear)
+**  Descripcion:    Busca la entrada de un GP en el indice
+**  Parametros:     Diario, numero del GP, crear la entrada si no existe
+**  Retorno:        Indice o -1 si no esta y no se puede crear
+****************************************************************************************/
+int16_t indiceGPDiarioConfig(diarioConfig_t *diario, uint16_t gpn, bool crear)
+{
+    for (uint8_t i = 0; i < diario->numGP; i++) {
+        if (diario->gpn[i] == gpn)
+            return i;
+    }
+
+    if (!crear || diario->numGP == NUM_MAX_GP_DIARIO_CONFIG)
+        return -1;
+
+    diario->gpn[diario->numGP] = gpn;
+    diario->offset[diario->numGP] = 0;
+    return diario->numGP++;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t crcRegistroDiarioConfig(const registroDiarioConfig_t *cabecera, const uint8_t *dato)
+**  Descripcion:    Calcula el CRC de un registro
+**  Parametros:     Cabecera, datos
+**  Retorno:        CRC
+****************************************************************************************/
+uint16_t crcRegistroDiarioConfig(const registroDiarioConfig_t *cabecera, const uint8_t *dato)
+{
+    uint16_t crc = calcularCRC16(VALOR_INICIO_CRC_DIARIO_CONFIG, cabecera, offsetof(registroDiarioConfig_t, crc));
+    crc = calcularCRC16(crc, &cabecera->secuencia, sizeof(cabecera->secuencia));
+    return calcularCRC16(crc, dato, cabecera->tam);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool zonaBorradaDiarioConfig(const uint8_t *dir, uint32_t tam)
+**  Descripcion:    Comprueba que una zona alineada a words esta borrada
+**  Parametros:     Direccion, tamanio
+**  Retorno:        True si todas las words estan borradas
+****************************************************************************************/
+bool zonaBorradaDiarioConfig(const uint8_t *dir, uint32_t tam)
+{
+    const uint32_t *p = (const uint32_t *)dir;
+
+    for (uint32_t i = 0; i < tam / 4; i++) {
+        if (p[i] != WORD_BORRADA_DIARIO_CONFIG)
+            return false;
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         const cabeceraDiarioConfig_t *cabeceraDiarioConfig(const diarioConfig_t *diario, uint8_t numSector)
+**  Descripcion:    Devuelve la cabecera de un sector
+**  Parametros:     Diario, numero de sector
+**  Retorno:        Cabecera
+****************************************************************************************/
+static inline const cabeceraDiarioConfig_t *cabeceraDiarioConfig(const diarioConfig_t *diario, uint8_t numSector)
+{
+    return (const cabeceraDiarioConfig_t *)diario->dispositivo->sector[numSector];
+}
+
+
+/***************************************************************************************
+**  Nombre:         const registroDiarioConfig_t *registroDiarioConfig(const diarioConfig_t *diario, uint32_t offset)
+**  Descripcion:    Devuelve un registro del sector activo
+**  Parametros:     Diario, offset en el sector
+**  Retorno:        Registro
+****************************************************************************************/
+static inline const registroDiarioConfig_t *registroDiarioConfig(const diarioConfig_t *diario, uint32_t offset)
+{
+    return (const registroDiarioConfig_t *)(diario->dispositivo->sector[diario->activo] + offset);
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t tamRegistroDiarioConfig(uint16_t tam)
+**  Descripcion:    Devuelve lo que ocupa en la flash un registro con sus datos
+**  Parametros:     Bytes de datos
+**  Retorno:        Bytes alineados a word
+****************************************************************************************/
+static inline uint32_t tamRegistroDiarioConfig(uint16_t tam)
+{
+    return sizeof(registroDiarioConfig_t) + ((tam + 3) & ~3u);
+}
@@ -0,0 +1,105 @@
+/***************************************************************************************
+**  diario_config.h - Diario de registros de configuracion con nivelacion de desgaste
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __DIARIO_CONFIG_H
+#define __DIARIO_CONFIG_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * La zona de configuracion se divide en dos sectores. El activo es un diario: cada vez que
+ * se guarda un GP se anade al final un registro con su numero, version, numero de secuencia
+ * y CRC propio, y el que vale es el ultimo. Cada registro lleva una confirmacion que se
+ * graba despues de los datos, asi que uno cortado a medias nunca se da por bueno. Al
+ * arrancar se recorre una vez el sector activo y se apunta en RAM el registro vivo de cada
+ * GP. Solo cuando se llena se copian los vivos al otro sector (compactacion), que es la
+ * unica operacion que borra. La cabecera de cada sector lleva un numero de generacion y un
+ * sello que se graba al terminar la copia, de forma que un corte de alimentacion en
+ * cualquier punto deja el sector anterior como activo
+ */
+#define NUM_MAX_GP_DIARIO_CONFIG        48
+#define TAM_MAX_DATO_DIARIO_CONFIG      0x0FFF   // Igual que GPR_TAMANIO_MASCARA
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef enum {
+    DIARIO_CONFIG_SIN_CAMBIOS = 0,       // El registro vivo ya tiene esos datos
+    DIARIO_CONFIG_ESCRITO,
+    DIARIO_CONFIG_COMPACTADO,            // Se ha escrito despues de compactar
+    DIARIO_CONFIG_LLENO,                 // Hace falta compactar y no se permite borrar
+    DIARIO_CONFIG_ERROR,
+} estadoDiarioConfig_e;
+
+typedef struct {
+    const uint8_t *sector[2];            // Sectores mapeados en memoria para la lectura
+    uint32_t tamSector;
+    int32_t (*borrar)(uint8_t numSector);                                          // 0 si ok
+    int32_t (*programar)(const uint8_t *dir, const uint32_t *dato, uint32_t numWords);   // 0 si ok
+} dispositivoDiarioConfig_t;
+
+typedef struct {
+    const dispositivoDiarioConfig_t *dispositivo;
+    uint8_t version;                     // Version de la zona de configuracion
+    bool abierto;                        // Hay un sector activo
+    uint8_t activo;
+    uint16_t generacion;
+    uint32_t libre;                      // Offset del primer byte libre del sector activo
+    uint32_t secuencia;                  // Numero de secuencia del siguiente registro
+    uint8_t numGP;
+    uint16_t gpn[NUM_MAX_GP_DIARIO_CONFIG];
+    uint32_t offset[NUM_MAX_GP_DIARIO_CONFIG];   // Registro vivo de cada GP en el sector activo
+    uint32_t descartados;                // Registros con CRC erroneo encontrados al abrir
+    uint32_t compactaciones;
+} diarioConfig_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool abrirDiarioConfig(diarioConfig_t *diario, const dispositivoDiarioConfig_t *dispositivo, uint8_t version);
+bool formatearDiarioConfig(diarioConfig_t *diario);
+bool compactarDiarioConfig(diarioConfig_t *diario);
+const uint8_t *leerDiarioConfig(const diarioConfig_t *diario, uint16_t gpn, uint16_t *tam, uint8_t *version);
+estadoDiarioConfig_e escribirDiarioConfig(diarioConfig_t *diario, uint16_t gpn, uint8_t version, const void *dato,
+                                          uint16_t tam, bool permitirBorrado);
+uint32_t bytesLibresDiarioConfig(const diarioConfig_t *diario);
+
+#endif // __DIARIO_CONFIG_H
@@ -38,8 +38,19 @@
 /***************************************************************************************
 ** AREA DE PREPROCESADOR                                                              **
 ****************************************************************************************/
+#if defined(SITL)
+// En el PC no hay linker script. El linker genera los simbolos __start_ y __stop_ de las
+// secciones cuyo nombre es un identificador valido de C
+#define ATRIBUTOS_REGISTRO_GP         __attribute__  ((section("registroGP"), used, aligned(4)))
+#define ATRIBUTOS_RESET_GP            __attribute__  ((section("resetGP"), used, aligned(2)))
+#define _sregistroGP                  __start_registroGP
+#define _eregistroGP                  __stop_registroGP
+#define _sresetGP                     __start_resetGP
+#define _eresetGP                     __stop_resetGP
+#else
 #define ATRIBUTOS_REGISTRO_GP         __attribute__  ((section(".registroGP"), used, aligned(4)))
 #define ATRIBUTOS_RESET_GP            __attribute__  ((section(".resetGP"), used, aligned(2)))
+#endif
 
 // Macro para iterar todos los grupos de parametros
 #define POR_CADA_GP(nombreGP) \
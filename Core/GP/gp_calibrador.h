@@ -43,6 +43,7 @@
 ****************************************************************************************/
 #define FREC_ACTUALIZAR_CALIBRADOR_IMU_HZ    20
 #define FREC_ACTUALIZAR_CALIBRADOR_MAG_HZ    20
+#define FREC_AJUSTE_CALIBRADOR_MAG_HZ        500      // Mientras se filtra y se ajusta
 
 
 /***************************************************************************************
@@ -64,5 +64,8 @@
 #define GP_CONFIGURACION_PID             116
 #define GP_CONFIGURACION_CAL_IMU         117
 #define GP_CONFIGURACION_CAL_MAG         118
+#define GP_CONFIGURACION_NOTCH_DINAMICO  119
+#define GP_CONFIGURACION_TELEMETRIA      120
+#define GP_CONFIGURACION_NOTCH_RPM       121
 
 #endif // __GP_IDS_H
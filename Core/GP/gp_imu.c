@@ -37,6 +37,19 @@
 #define FREC_FILTRO_ACEL_IMU        50.0f
 #define FREC_FILTRO_GIRO_IMU        50.0f
 
+#define HAB_NOTCH_DINAMICO          true
+#define ARMONICOS_NOTCH_DINAMICO    0x03
+#define FREC_MIN_NOTCH_DINAMICO     60.0f
+#define FREC_MAX_NOTCH_DINAMICO     240.0f
+#define ANCHO_NOTCH_DINAMICO        0.25f
+#define ATENUACION_NOTCH_DINAMICO   40.0f
+
+#define HAB_NOTCH_RPM               true
+#define ARMONICOS_NOTCH_RPM         0x07
+#define FREC_MIN_NOTCH_RPM          80.0f
+#define ANCHO_NOTCH_RPM             0.2f
+#define ATENUACION_NOTCH_RPM        40.0f
+
 #ifndef TIPO_IMU_1
   #define TIPO_IMU_1                IMU_NINGUNO
 #endif
@@ -237,6 +250,26 @@
 ** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
 REGISTRAR_ARRAY_GP_CON_FN_RESET(configIMU_t, NUM_MAX_IMU, configIMU, GP_CONFIGURACION_IMU, 1);
+REGISTRAR_GP_CON_TEMPLATE_RESET(configNotchDinamico_t, configNotchDinamico, GP_CONFIGURACION_NOTCH_DINAMICO, 1);
+
+TEMPLATE_RESET_GP(configNotchDinamico_t, configNotchDinamico,
+    .habilitado = HAB_NOTCH_DINAMICO,
+    .armonicos = ARMONICOS_NOTCH_DINAMICO,
+    .frecMin = FREC_MIN_NOTCH_DINAMICO,
+    .frecMax = FREC_MAX_NOTCH_DINAMICO,
+    .anchoBanda = ANCHO_NOTCH_DINAMICO,
+    .atenuacionDB = ATENUACION_NOTCH_DINAMICO,
+);
+
+REGISTRAR_GP_CON_TEMPLATE_RESET(configNotchRPM_t, configNotchRPM, GP_CONFIGURACION_NOTCH_RPM, 1);
+
+TEMPLATE_RESET_GP(configNotchRPM_t, configNotchRPM,
+    .habilitado = HAB_NOTCH_RPM,
+    .armonicos = ARMONICOS_NOTCH_RPM,
+    .frecMin = FREC_MIN_NOTCH_RPM,
+    .anchoBanda = ANCHO_NOTCH_RPM,
+    .atenuacionDB = ATENUACION_NOTCH_RPM,
+);
 
 static const configIMU_t configIMUdefecto[] = {
     { TIPO_IMU_1, AUX_IMU_1, TIPO_BUS_IMU_1, DISP_BUS_IMU_1, DEFIO_TAG(CS_SPI_BUS_IMU_1), DIR_I2C_BUS_IMU_1, DEFIO_TAG(DRDY_IMU_1), FREC_FILTRO_ACEL_IMU, FREC_FILTRO_GIRO_IMU, {ROTACION_IMU_1, VOLTEADO_IMU_1}, FREC_ACTUALIZAR_IMU_HZ, FREC_LEER_IMU_HZ},
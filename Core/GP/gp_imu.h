@@ -43,6 +43,7 @@
 #define FREC_ACTUALIZAR_IMU_HZ      1000
 #define FREC_LEER_IMU_HZ            500
 #define LEER_IMU_SCHEDULER              // El sheduler se encarga de llamar a la lectura del sensor. Sino lo hace otra funcion
+#define FREC_ACTUALIZAR_NOTCH_DINAMICO_HZ   500
 
 
 /***************************************************************************************
@@ -63,11 +64,30 @@ typedef struct {
     uint16_t frecLeer;
 } configIMU_t;
 
+typedef struct {
+    bool habilitado;
+    uint8_t armonicos;                   // Mascara de armonicos del pico dominante a filtrar
+    float frecMin;                       // Rango de busqueda de picos en Hz
+    float frecMax;
+    float anchoBanda;                    // Ancho de banda de cada notch en tanto por uno de su frecuencia
+    float atenuacionDB;
+} configNotchDinamico_t;
+
+typedef struct {
+    bool habilitado;
+    uint8_t armonicos;                   // Mascara de armonicos de la frecuencia de giro de cada motor
+    float frecMin;                       // Por debajo los notch dejan pasar la senial
+    float anchoBanda;                    // Ancho de banda de cada notch en tanto por uno de su frecuencia
+    float atenuacionDB;
+} configNotchRPM_t;
+
 
 /***************************************************************************************
 ** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
 DECLARAR_ARRAY_GP(configIMU_t, NUM_MAX_IMU, configIMU);
+DECLARAR_GP(configNotchDinamico_t, configNotchDinamico);
+DECLARAR_GP(configNotchRPM_t, configNotchRPM);
 
 
 /***************************************************************************************
@@ -34,13 +34,20 @@
 /***************************************************************************************
 ** AREA DE PREPROCESADOR                                                              **
 ****************************************************************************************/
-#define PROTOCOLO_MOTOR         PWM_TIPO_ESTANDAR
+#ifndef PROTOCOLO_MOTOR
+  #define PROTOCOLO_MOTOR       PWM_TIPO_ESTANDAR
+#endif
+
 #define INVERSION_MOTOR         MOTOR_SALIDA_ESTANDAR
 #define FREC_ACT_PWM_MOTOR      480
 
 #define USAR_BURST_DSHOT        false
 #define USAR_TELEM_DSHOT        false
 
+#ifndef POLOS_MOTOR
+  #define POLOS_MOTOR           14
+#endif
+
 #ifndef NUM_MOTORES
   #define NUM_MOTORES           0
 #endif
@@ -150,7 +157,7 @@
 /***************************************************************************************
 ** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
-REGISTRAR_GP_CON_TEMPLATE_RESET(configMotor_t, configMotor, GP_CONFIGURACION_MOTORES, 1);
+REGISTRAR_GP_CON_TEMPLATE_RESET(configMotor_t, configMotor, GP_CONFIGURACION_MOTORES, 2);
 
 TEMPLATE_RESET_GP(configMotor_t, configMotor,
     .protocolo = PROTOCOLO_MOTOR,
@@ -184,6 +191,7 @@ TEMPLATE_RESET_GP(configMotor_t, configMotor,
 #ifdef USAR_DSHOT
 	.usarBurstDshot = USAR_BURST_DSHOT,
 	.usarTelemetriaDshot = USAR_TELEM_DSHOT,
+	.polosMotor = POLOS_MOTOR,
 #endif
 );
 
@@ -52,7 +52,8 @@ typedef struct {
     pinConfigTimer_t pinMotor[NUM_MAX_MOTORES];
 #ifdef USAR_DSHOT
     bool usarBurstDshot;
-    bool usarTelemetriaDshot;
+    bool usarTelemetriaDshot;                   // DSHOT bidireccional con eRPM
+    uint8_t polosMotor;
 #endif
 } configMotor_t;
 
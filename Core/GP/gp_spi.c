@@ -130,6 +130,56 @@
   #define LEADING_EDGE_SPI_6    false
 #endif
 
+#ifdef USAR_COLA_SPI
+#ifndef DMA_TX_SPI_1
+  #define DMA_TX_SPI_1         NULL
+#endif
+
+#ifndef DMA_RX_SPI_1
+  #define DMA_RX_SPI_1         NULL
+#endif
+
+#ifndef DMA_TX_SPI_2
+  #define DMA_TX_SPI_2         NULL
+#endif
+
+#ifndef DMA_RX_SPI_2
+  #define DMA_RX_SPI_2         NULL
+#endif
+
+#ifndef DMA_TX_SPI_3
+  #define DMA_TX_SPI_3         NULL
+#endif
+
+#ifndef DMA_RX_SPI_3
+  #define DMA_RX_SPI_3         NULL
+#endif
+
+#ifndef DMA_TX_SPI_4
+  #define DMA_TX_SPI_4         NULL
+#endif
+
+#ifndef DMA_RX_SPI_4
+  #define DMA_RX_SPI_4         NULL
+#endif
+
+#ifndef DMA_TX_SPI_5
+  #define DMA_TX_SPI_5         NULL
+#endif
+
+#ifndef DMA_RX_SPI_5
+  #define DMA_RX_SPI_5         NULL
+#endif
+
+#ifndef DMA_TX_SPI_6
+  #define DMA_TX_SPI_6         NULL
+#endif
+
+#ifndef DMA_RX_SPI_6
+  #define DMA_RX_SPI_6         NULL
+#endif
+#endif
+
 
 /***************************************************************************************
 ** AREA DE DEFINICION DE TIPOS                                                        **
@@ -139,15 +189,39 @@
 /***************************************************************************************
 ** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
-REGISTRAR_ARRAY_GP_CON_FN_RESET(configSPI_t, NUM_MAX_SPI, configSPI, GP_CONFIGURACION_SPI, 1);
+REGISTRAR_ARRAY_GP_CON_FN_RESET(configSPI_t, NUM_MAX_SPI, configSPI, GP_CONFIGURACION_SPI, 2);
 
 static const configSPI_t configSPIdefecto[] = {
-    { DEFIO_TAG(PIN_SCK_SPI_1), DEFIO_TAG(PIN_MISO_SPI_1), DEFIO_TAG(PIN_MOSI_SPI_1), LEADING_EDGE_SPI_1},
-    { DEFIO_TAG(PIN_SCK_SPI_2), DEFIO_TAG(PIN_MISO_SPI_2), DEFIO_TAG(PIN_MOSI_SPI_2), LEADING_EDGE_SPI_2},
-    { DEFIO_TAG(PIN_SCK_SPI_3), DEFIO_TAG(PIN_MISO_SPI_3), DEFIO_TAG(PIN_MOSI_SPI_3), LEADING_EDGE_SPI_3},
-    { DEFIO_TAG(PIN_SCK_SPI_4), DEFIO_TAG(PIN_MISO_SPI_4), DEFIO_TAG(PIN_MOSI_SPI_4), LEADING_EDGE_SPI_4},
-    { DEFIO_TAG(PIN_SCK_SPI_5), DEFIO_TAG(PIN_MISO_SPI_5), DEFIO_TAG(PIN_MOSI_SPI_5), LEADING_EDGE_SPI_5},
-    { DEFIO_TAG(PIN_SCK_SPI_6), DEFIO_TAG(PIN_MISO_SPI_6), DEFIO_TAG(PIN_MOSI_SPI_6), LEADING_EDGE_SPI_6},
+    { DEFIO_TAG(PIN_SCK_SPI_1), DEFIO_TAG(PIN_MISO_SPI_1), DEFIO_TAG(PIN_MOSI_SPI_1), LEADING_EDGE_SPI_1,
+#ifdef USAR_COLA_SPI
+      DMA_TX_SPI_1, DMA_RX_SPI_1,
+#endif
+    },
+    { DEFIO_TAG(PIN_SCK_SPI_2), DEFIO_TAG(PIN_MISO_SPI_2), DEFIO_TAG(PIN_MOSI_SPI_2), LEADING_EDGE_SPI_2,
+#ifdef USAR_COLA_SPI
+      DMA_TX_SPI_2, DMA_RX_SPI_2,
+#endif
+    },
+    { DEFIO_TAG(PIN_SCK_SPI_3), DEFIO_TAG(PIN_MISO_SPI_3), DEFIO_TAG(PIN_MOSI_SPI_3), LEADING_EDGE_SPI_3,
+#ifdef USAR_COLA_SPI
+      DMA_TX_SPI_3, DMA_RX_SPI_3,
+#endif
+    },
+    { DEFIO_TAG(PIN_SCK_SPI_4), DEFIO_TAG(PIN_MISO_SPI_4), DEFIO_TAG(PIN_MOSI_SPI_4), LEADING_EDGE_SPI_4,
+#ifdef USAR_COLA_SPI
+      DMA_TX_SPI_4, DMA_RX_SPI_4,
+#endif
+    },
+    { DEFIO_TAG(PIN_SCK_SPI_5), DEFIO_TAG(PIN_MISO_SPI_5), DEFIO_TAG(PIN_MOSI_SPI_5), LEADING_EDGE_SPI_5,
+#ifdef USAR_COLA_SPI
+      DMA_TX_SPI_5, DMA_RX_SPI_5,
+#endif
+    },
+    { DEFIO_TAG(PIN_SCK_SPI_6), DEFIO_TAG(PIN_MISO_SPI_6), DEFIO_TAG(PIN_MOSI_SPI_6), LEADING_EDGE_SPI_6,
+#ifdef USAR_COLA_SPI
+      DMA_TX_SPI_6, DMA_RX_SPI_6,
+#endif
+    },
 };
 
 
@@ -174,6 +248,10 @@ void fnResetGP_configSPI(configSPI_t *configSPI)
     	configSPI[i].pinMISO = configSPIdefecto[i].pinMISO;
     	configSPI[i].pinMOSI = configSPIdefecto[i].pinMOSI;
     	configSPI[i].leadingEdge = configSPIdefecto[i].leadingEdge;
+#ifdef USAR_COLA_SPI
+    	configSPI[i].streamDMAtx = configSPIdefecto[i].streamDMAtx;
+    	configSPI[i].streamDMArx = configSPIdefecto[i].streamDMArx;
+#endif
     }
 }
 
@@ -44,6 +44,10 @@ typedef struct {
     uint8_t pinMISO;
     uint8_t pinMOSI;
     bool leadingEdge;
+#ifdef USAR_COLA_SPI
+    DMA_Stream_TypeDef *streamDMAtx;
+    DMA_Stream_TypeDef *streamDMArx;
+#endif
 } configSPI_t;
 
 
@@ -0,0 +1,67 @@
+/***************************************************************************************
+**  gp_telemetria.h - Grupo de parametros de la telemetria
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "gp_telemetria.h"
+
+#ifdef USAR_TELEMETRIA
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#ifndef DIVISOR_ACTITUD_TELEMETRIA
+  #define DIVISOR_ACTITUD_TELEMETRIA         5         // 200 Hz
+#endif
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+REGISTRAR_GP_CON_TEMPLATE_RESET(configTelemetria_t, configTelemetria, GP_CONFIGURACION_TELEMETRIA, 1);
+
+TEMPLATE_RESET_GP(configTelemetria_t, configTelemetria,
+    .divisor = {
+        [CANAL_TELEMETRIA_ACTITUD] = DIVISOR_ACTITUD_TELEMETRIA,
+    },
+);
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+#endif
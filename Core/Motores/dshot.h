@@ -44,10 +44,19 @@
 #define TAMANIO_BUFFER_DMA_DSHOT            18    // resolucion + reset trama (2us)
 #define TAMANIO_BUFFER_DMA_PROSHOT          6     // resolucion + reset trama (2us)
 
+#define BIT_0_MOTOR                         7     // Ticks en alto de un 0
+#define BIT_1_MOTOR                         14    // Ticks en alto de un 1
+#define LONGITUD_BIT_MOTOR                  20    // Ticks por bit
+
 #define SIMBOLO_BASE_PROSHOT                24    // 1uS
 #define MOTOR_LONGITUD_NIBBLE_PROSHOT       96    // 4uS
 #define ANCHO_BIT_PROSHOT                   3
 
+// La etapa de salida y la telemetria no usan la HAL y se compilan tambien en SITL para probarlas
+#if defined(USAR_MOTORES) && (defined(USAR_DSHOT) || defined(SITL))
+  #define USAR_SALIDA_DSHOT
+#endif
+
 
 /***************************************************************************************
 ** AREA DE DEFINICION DE TIPOS                                                        **
@@ -97,10 +106,11 @@ typedef struct {
     TIM_HandleTypeDef htim;
     DMA_Stream_TypeDef *dmaBurst;
     DMA_HandleTypeDef hdma;
-    uint16_t longBurstDMA;
-    uint32_t *bufferBurstDMA;
     uint16_t fuentesDMAtimer;
     uint32_t direccionEntrada;
+    uint8_t canalesTrama;                       // Canales enviados en la ultima trama
+    volatile uint8_t canalesEnviando;           // Canales con la trama todavia en curso
+    volatile bool capturando;                   // Contando libre para capturar las respuestas
 } motorDshotTimer_t;
 
 typedef struct {
@@ -116,7 +126,9 @@ typedef struct {
     uint8_t indice;
     motorDshotTimer_t *motorTimer;
     volatile bool solicitarTelemetria;
-    uint32_t *bufferDMA;
+    uint8_t ccmrSalida;                         // Campo del canal en CCMRx como salida
+    uint8_t ccerSalida;                         // Campo del canal en CCER como salida
+    volatile bool capturando;
 } motorDshot_t;
 
 
@@ -125,6 +137,7 @@ typedef struct {
 ****************************************************************************************/
 extern motorDshot_t motoresDshot[NUM_MAX_MOTORES];
 extern bool usarBurstDshot;
+extern bool usarDshotBidireccional;
 
 
 /***************************************************************************************
@@ -134,8 +147,6 @@ void configurarHardwareDshot(tim_t *tim, uint8_t indice, protocoloMotor_e protoc
 motorDshot_t *motorDshot(uint8_t indice);
 void escribirPWMdshot(uint8_t indice, float valor);
 void actualizarPWMdshot(uint8_t numMotores);
-uint8_t cargarBufferDMAdshot(uint32_t *bufferDMA, uint8_t paso, uint16_t paquete);
-uint8_t cargarBufferDMAproshot(uint32_t *bufferDMA, uint8_t paso, uint16_t paquete);
 
 bool comandoDshotSiendoProcesado(void);
 uint8_t comandoDshot(uint8_t indice);
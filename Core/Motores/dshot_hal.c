@@ -32,6 +32,8 @@
 
 #ifdef USAR_DSHOT
 #include "motor.h"
+#include "salida_motores.h"
+#include "telemetria_dshot.h"
 #include "Drivers/io.h"
 #include "Drivers/dma.h"
 #include "Drivers/nvic.h"
@@ -46,11 +48,11 @@
 #define DSHOT300_HZ                   MHZ_A_HZ(6)
 #define DSHOT150_HZ                   MHZ_A_HZ(3)
 
-#define BIT_0_MOTOR                   7
-#define BIT_1_MOTOR                   14
-#define LONGITUD_BIT_MOTOR            20
+#define FILTRO_CAPTURA_DSHOT          2            // Muestras iguales para aceptar un flanco de la respuesta
 
-#define NUM_MAX_DMA_TIMERS_MOTOR      8
+// Campos del canal en CCMRx y CCER para capturar ambos flancos de la respuesta
+#define CCMR_CAPTURA_DSHOT            (TIM_ICSELECTION_DIRECTTI | TIM_ICPSC_DIV1 | (FILTRO_CAPTURA_DSHOT << TIM_CCMR1_IC1F_Pos))
+#define CCER_CAPTURA_DSHOT            (TIM_CCER_CC1E | TIM_INPUTCHANNELPOLARITY_BOTHEDGE)
 
 
 /***************************************************************************************
@@ -61,12 +63,12 @@
 /***************************************************************************************
 ** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
-static uint32_t bufferDshotDMA[NUM_MAX_MOTORES][TAMANIO_BUFFER_DMA_DSHOT];
-static uint32_t bufferBurstDMA[NUM_MAX_DMA_TIMERS_MOTOR][TAMANIO_BUFFER_DMA_DSHOT * 4];
 static uint8_t contadorMotorDshot = 0;
 static motorDshotTimer_t motoresDshotTimer[NUM_MAX_MOTORES];
+static uint16_t bufferCapturaDshot[NUM_MAX_MOTORES][NUM_MAX_FLANCOS_RESPUESTA_DSHOT] RAM_RAPIDA_INI;
 motorDshot_t motoresDshot[NUM_MAX_MOTORES];
 bool usarBurstDshot = false;
+bool usarDshotBidireccional = false;
 
 
 /***************************************************************************************
@@ -77,7 +79,11 @@ uint8_t indiceTimer(TIM_TypeDef *timer);
 void iniciarPWMcanalDMA(TIM_HandleTypeDef *htim, uint32_t canal, uint32_t *pDato, uint16_t lon);
 void pararPWMcanalDMA(TIM_HandleTypeDef *htim, uint32_t canal);
 void iniciarPWMburstDMA(TIM_HandleTypeDef *htim, uint32_t dirBaseBurst, uint32_t fuenteSolicitudBurst, uint32_t unidadBurst, uint32_t* bufferBurst, uint32_t lonBurst);
-uint16_t prepararPaqueteDshot(motorDshot_t *const motor);
+void configurarDMAcanalDshot(motorDshot_t *const motor);
+void cambiarDireccionCanalDshot(motorDshot_t *const motor, bool captura);
+void iniciarCapturaTimerDshot(motorDshotTimer_t *motorTimer);
+void iniciarCapturaDshot(uint8_t indice);
+void terminarCapturaDshot(uint8_t indice);
 void motor_DMA_IRQHandler(descriptorCanalDMA_t* descriptor);
 
 
@@ -110,8 +116,24 @@ void configurarHardwareDshot(tim_t *tim, uint8_t indice, protocoloMotor_e protoc
     const uint8_t indiceTimer = indiceTimer(tim->hal.htim.Instance);
     const bool confTimer = (indiceTimer == contadorMotorDshot - 1);
 
+    if (indiceTimer >= NUM_MAX_TIMERS_SALIDA_MOTORES || !asignarSalidaMotor(indice, indiceTimer, tim->canal >> 2))
+        return;
+
+    // En burst los motores del timer comparten el stream de update. Si lo tiene otro
+    // periferico el motor se queda sin configurar
+    if (usarBurstDshot) {
+        if (!reservarDMA(identificadorDMA(sDMA), DMA_TIMER_UP, indiceTimer))
+            return;
+    }
+    else if (!reservarDMA(identificadorDMA(sDMA), DMA_MOTOR, indice))
+        return;
+
+    // En bidireccional la linea esta en alto en reposo y el ESC la usa para responder
+    if (usarDshotBidireccional)
+        inversion ^= TIMER_SALIDA_INVERTIDA;
+
     // Configuramos el GPIO
-    configurarIO(tim->hal.pin.pin, CONFIG_IO(GPIO_MODE_AF_PP, GPIO_SPEED_FREQ_VERY_HIGH, GPIO_PULLDOWN), tim->hal.pin.af);
+    configurarIO(tim->hal.pin.pin, CONFIG_IO(GPIO_MODE_AF_PP, GPIO_SPEED_FREQ_VERY_HIGH, usarDshotBidireccional ? GPIO_PULLUP : GPIO_PULLDOWN), tim->hal.pin.af);
 
     // Configuracion de la base de tiempo
     if (confTimer) {
@@ -179,9 +201,6 @@ void configurarHardwareDshot(tim_t *tim, uint8_t indice, protocoloMotor_e protoc
         motor->motorTimer->hdma.Init.MemBurst = DMA_MBURST_SINGLE;
         motor->motorTimer->hdma.Init.FIFOThreshold = DMA_FIFO_THRESHOLD_FULL;
 
-        motor->motorTimer->bufferBurstDMA = &bufferBurstDMA[indiceTimer][0];
-        memset(motor->motorTimer->bufferBurstDMA, 0, TAMANIO_BUFFER_DMA_DSHOT * 4 * sizeof(uint32_t));
-
         motor->motorTimer->htim = motor->htim;
         motor->motorTimer->hdma.Instance = tim->halTimUP.DMAy_Streamx;
 
@@ -190,27 +209,11 @@ void configurarHardwareDshot(tim_t *tim, uint8_t indice, protocoloMotor_e protoc
             return;
     }
     else {
-        motor->hdma.Init.Direction = DMA_MEMORY_TO_PERIPH;
-        motor->hdma.Init.PeriphInc = DMA_PINC_DISABLE;
-        motor->hdma.Init.MemInc = DMA_MINC_ENABLE;
-        motor->hdma.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD ;
-        motor->hdma.Init.MemDataAlignment = DMA_MDATAALIGN_WORD ;
-        motor->hdma.Init.Mode = DMA_NORMAL;
-        motor->hdma.Init.Priority = DMA_PRIORITY_HIGH;
-        motor->hdma.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
-        motor->hdma.Init.PeriphBurst = DMA_PBURST_SINGLE;
-        motor->hdma.Init.MemBurst = DMA_MBURST_SINGLE;
-        motor->hdma.Init.FIFOThreshold = DMA_FIFO_THRESHOLD_FULL;
-
-        motor->bufferDMA = &bufferDshotDMA[indice][0];
-        motor->bufferDMA[TAMANIO_BUFFER_DMA_DSHOT - 2] = 0;
-        motor->bufferDMA[TAMANIO_BUFFER_DMA_DSHOT - 1] = 0;
-
+        motor->motorTimer->htim.Instance = tim->hal.htim.Instance;
         motor->hdma.Instance = tim->halTim.DMAy_Streamx;
 
         __HAL_LINKDMA(&motor->htim, hdma[motor->indiceDMAtimer], motor->hdma);
-        if (HAL_DMA_Init(motor->htim.hdma[motor->indiceDMAtimer]) != HAL_OK)
-            return;
+        configurarDMAcanalDshot(motor);
     }
 
     if (usarBurstDshot) {
@@ -233,10 +236,141 @@ void configurarHardwareDshot(tim_t *tim, uint8_t indice, protocoloMotor_e protoc
             return;
     }
 
+    // Campos del canal como salida para volver a ellos tras capturar la respuesta
+    const uint32_t desplazamientoCCMR = (tim->canal & TIM_CHANNEL_2) ? 8 : 0;
+    motor->ccmrSalida = ((tim->canal < TIM_CHANNEL_3 ? motor->htim.Instance->CCMR1 : motor->htim.Instance->CCMR2) >> desplazamientoCCMR) & 0xFF;
+    motor->ccerSalida = (motor->htim.Instance->CCER >> tim->canal) & 0xF;
+
     motor->configurado = true;
 }
 
 
+/***************************************************************************************
+**  Nombre:         void configurarDMAcanalDshot(motorDshot_t *const motor)
+**  Descripcion:    Configura el stream del canal para enviar la trama. Para capturar la
+**                  respuesta solo cambia la direccion (ver cambiarDireccionCanalDshot)
+**  Parametros:     Motor
+**  Retorno:        Ninguno
+****************************************************************************************/
+void configurarDMAcanalDshot(motorDshot_t *const motor)
+{
+    motor->hdma.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    motor->hdma.Init.PeriphInc = DMA_PINC_DISABLE;
+    motor->hdma.Init.MemInc = DMA_MINC_ENABLE;
+    motor->hdma.Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    motor->hdma.Init.MemDataAlignment = DMA_MDATAALIGN_WORD;
+    motor->hdma.Init.Mode = DMA_NORMAL;
+    motor->hdma.Init.Priority = DMA_PRIORITY_HIGH;
+    motor->hdma.Init.FIFOMode = DMA_FIFOMODE_DISABLE;
+    motor->hdma.Init.PeriphBurst = DMA_PBURST_SINGLE;
+    motor->hdma.Init.MemBurst = DMA_MBURST_SINGLE;
+    motor->hdma.Init.FIFOThreshold = DMA_FIFO_THRESHOLD_FULL;
+
+    HAL_DMA_Init(&motor->hdma);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void cambiarDireccionCanalDshot(motorDshot_t *const motor, bool captura)
+**  Descripcion:    Pasa el canal y su stream de enviar la trama a capturar la respuesta o al
+**                  reves escribiendo solo los registros que cambian. Se llama con el
+**                  stream parado: al terminar la trama o tras abortar la captura
+**  Parametros:     Motor, true para capturar la respuesta
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void cambiarDireccionCanalDshot(motorDshot_t *const motor, bool captura)
+{
+    TIM_TypeDef *const tim = motor->htim.Instance;
+    const uint32_t canal = motor->timer->canal;
+    volatile uint32_t *const ccmr = canal < TIM_CHANNEL_3 ? &tim->CCMR1 : &tim->CCMR2;
+    const uint32_t desplazamientoCCMR = (canal & TIM_CHANNEL_2) ? 8 : 0;
+
+    // CCxS solo se puede escribir con el canal apagado
+    tim->CCER &= ~(0xFU << canal);
+    *ccmr = (*ccmr & ~(0xFFU << desplazamientoCCMR)) | ((captura ? CCMR_CAPTURA_DSHOT : motor->ccmrSalida) << desplazamientoCCMR);
+    tim->CCER |= (captura ? CCER_CAPTURA_DSHOT : motor->ccerSalida) << canal;
+
+    // Captura de 16 bits desde CCRx o trama de 32 bits hacia CCRx. La HAL elige PAR y M0AR
+    // en HAL_DMA_Start_IT segun Init.Direction
+    uint32_t cr = motor->hdma.Instance->CR & ~(DMA_SxCR_DIR | DMA_SxCR_PSIZE | DMA_SxCR_MSIZE);
+
+    if (captura) {
+        cr |= DMA_PERIPH_TO_MEMORY | DMA_PDATAALIGN_HALFWORD | DMA_MDATAALIGN_HALFWORD;
+        motor->hdma.Init.Direction = DMA_PERIPH_TO_MEMORY;
+    }
+    else {
+        cr |= DMA_MEMORY_TO_PERIPH | DMA_PDATAALIGN_WORD | DMA_MDATAALIGN_WORD;
+        motor->hdma.Init.Direction = DMA_MEMORY_TO_PERIPH;
+    }
+
+    motor->hdma.Instance->CR = cr;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void iniciarCapturaTimerDshot(motorDshotTimer_t *motorTimer)
+**  Descripcion:    Pasa el timer a contar libre y sus canales de la ultima trama a captura.
+**                  Se llama cuando han terminado todos, porque el auto-reload es comun y
+**                  cambiarlo antes cortaria las tramas de los demas canales
+**  Parametros:     Timer
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void iniciarCapturaTimerDshot(motorDshotTimer_t *motorTimer)
+{
+    __HAL_TIM_SET_AUTORELOAD(&motorTimer->htim, 0xFFFF);
+    motorTimer->capturando = true;
+
+    for (uint8_t i = 0; i < NUM_MAX_MOTORES; i++) {
+        motorDshot_t *const motor = &motoresDshot[i];
+
+        if (motor->configurado && motor->motorTimer == motorTimer && (motorTimer->canalesTrama & (1 << (motor->timer->canal >> 2))))
+            iniciarCapturaDshot(i);
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void iniciarCapturaDshot(uint8_t indice)
+**  Descripcion:    Pasa el canal a captura de ambos flancos al terminar la trama. El timer
+**                  ya cuenta libre para medir los tramos de la respuesta
+**  Parametros:     Motor
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void iniciarCapturaDshot(uint8_t indice)
+{
+    motorDshot_t *const motor = &motoresDshot[indice];
+
+    cambiarDireccionCanalDshot(motor, true);
+    HAL_DMA_Start_IT(&motor->hdma, (uint32_t)(&motor->htim.Instance->CCR1 + (motor->timer->canal >> 2)),
+                     (uint32_t)bufferCapturaDshot[indice], NUM_MAX_FLANCOS_RESPUESTA_DSHOT);
+    __HAL_TIM_ENABLE_DMA(&motor->htim, motor->fuenteDMAtimer);
+
+    motor->capturando = true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void terminarCapturaDshot(uint8_t indice)
+**  Descripcion:    Para la captura, decodifica la respuesta y vuelve a dejar el canal como
+**                  salida para la siguiente trama
+**  Parametros:     Motor
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void terminarCapturaDshot(uint8_t indice)
+{
+    motorDshot_t *const motor = &motoresDshot[indice];
+
+    __HAL_TIM_DISABLE_DMA(&motor->htim, motor->fuenteDMAtimer);
+    const uint8_t numFlancos = NUM_MAX_FLANCOS_RESPUESTA_DSHOT - __HAL_DMA_GET_COUNTER(&motor->hdma);
+    HAL_DMA_Abort(&motor->hdma);
+    motor->capturando = false;
+
+    procesarRespuestaDshot(indice, bufferCapturaDshot[indice], numFlancos, TICKS_BIT_RESPUESTA_DSHOT);
+
+    cambiarDireccionCanalDshot(motor, false);
+}
+
+
 /***************************************************************************************
 **  Nombre:         motorDshot_t *motorDshot(uint8_t indice)
 **  Descripcion:    Obtiene la estructura motoresDshot
@@ -297,7 +431,7 @@ uint8_t indiceTimer(TIM_TypeDef *tim)
 
 /***************************************************************************************
 **  Nombre:         void escribirPWMdshot(uint8_t indice, float valor)
-**  Descripcion:    Escribe el valor del PWM en dshot
+**  Descripcion:    Prepara el valor del PWM en dshot. Se envia al confirmar la salida
 **  Parametros:     Indice del motor, valor a escribir
 **  Retorno:        Ninguno
 ****************************************************************************************/
@@ -320,23 +454,14 @@ void escribirPWMdshot(uint8_t indice, float valor)
 
     motor->valor = valor;
 
-    uint16_t paquete = prepararPaqueteDshot(motor);
-    uint8_t tamBuffer;
-
-    if (usarBurstDshot) {
-        tamBuffer = cargarBufferDMA(&motor->motorTimer->bufferBurstDMA[motor->timer->canal >> 2], 4, paquete);
-        motor->motorTimer->longBurstDMA = tamBuffer * 4;
-    }
-    else {
-        tamBuffer = cargarBufferDMA(motor->bufferDMA, 1, paquete);
-        iniciarPWMcanalDMA(&motor->htim, motor->timer->canal, motor->bufferDMA, tamBuffer);
-    }
+    prepararSalidaMotor(indice, prepararPaqueteDshot(motor->valor, motor->solicitarTelemetria, usarDshotBidireccional));
+    motor->solicitarTelemetria = false;
 }
 
 
 /***************************************************************************************
 **  Nombre:         void actualizarPWMdshot(uint8_t numMotores)
-**  Descripcion:    Actualizacion completa del PWM
+**  Descripcion:    Envia los valores preparados con un arranque del DMA por timer
 **  Parametros:     Numero de motores
 **  Retorno:        Ninguno
 ****************************************************************************************/
@@ -347,14 +472,57 @@ void actualizarPWMdshot(uint8_t numMotores)
             return;
     }
 
+    confirmarSalidaMotores();
+}
+
+
+/***************************************************************************************
+**  Nombre:         void arrancarDMAsalidaMotores(uint8_t indiceTimer, const timerSalidaMotores_t *timer)
+**  Descripcion:    Arranca el DMA de un timer con canales preparados. En burst se transfieren
+**                  CCR1 a CCR4 con un solo stream y en modo canal cada canal tiene el suyo
+**  Parametros:     Indice del timer, estado del timer en la etapa de salida
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void arrancarDMAsalidaMotores(uint8_t indiceTimer, const timerSalidaMotores_t *timer)
+{
+    motorDshotTimer_t *motorTimer = &motoresDshotTimer[indiceTimer];
+
     if (usarBurstDshot) {
-        for (uint8_t i = 0; i < contadorMotorDshot; i++) {
-            motorDshotTimer_t *burstDMAtimer = &motoresDshotTimer[i];
+        iniciarPWMburstDMA(&motorTimer->htim, TIM_DMABASE_CCR1, TIM_DMA_UPDATE, TIM_DMABURSTLENGTH_4TRANSFERS,
+                           timer->buffer, timer->longitud);
+        return;
+    }
 
-            // Transfiere CCR1 a CCR4 por cada Burst
-            iniciarPWMburstDMA(&burstDMAtimer->htim, TIM_DMABASE_CCR1, TIM_DMA_UPDATE, TIM_DMABURSTLENGTH_4TRANSFERS,
-            (uint32_t*)burstDMAtimer->bufferBurstDMA, burstDMAtimer->longBurstDMA);
+    // Las respuestas a la trama anterior ya han llegado. El timer vuelve a salida una sola
+    // vez y antes de arrancar ninguno de sus canales
+    if (motorTimer->capturando) {
+        for (uint8_t i = 0; i < NUM_MAX_MOTORES; i++) {
+            if (motoresDshot[i].capturando && motoresDshot[i].motorTimer == motorTimer)
+                terminarCapturaDshot(i);
         }
+
+        __HAL_TIM_SET_AUTORELOAD(&motorTimer->htim, LONGITUD_BIT_MOTOR);
+        __HAL_TIM_SET_COUNTER(&motorTimer->htim, 0);
+        motorTimer->capturando = false;
+    }
+
+    uint8_t canales = 0;
+    for (uint8_t i = 0; i < NUM_MAX_MOTORES; i++) {
+        motorDshot_t *const motor = &motoresDshot[i];
+
+        if (motor->configurado && motor->motorTimer == motorTimer)
+            canales |= timer->canalesPreparados & (1 << (motor->timer->canal >> 2));
+    }
+
+    // La mascara se fija antes de arrancar para que el fin del primer canal no la vea vacia
+    motorTimer->canalesTrama = canales;
+    motorTimer->canalesEnviando = canales;
+
+    for (uint8_t i = 0; i < NUM_MAX_MOTORES; i++) {
+        motorDshot_t *const motor = &motoresDshot[i];
+
+        if (motor->configurado && motor->motorTimer == motorTimer && (canales & (1 << (motor->timer->canal >> 2))))
+            iniciarPWMcanalDMA(&motor->htim, motor->timer->canal, bufferSalidaMotor(i), timer->longitud);
     }
 }
 
@@ -447,71 +615,6 @@ void iniciarPWMburstDMA(TIM_HandleTypeDef *htim, uint32_t dirBaseBurst, uint32_t
 }
 
 
-/***************************************************************************************
-**  Nombre:         uint8_t cargarBufferDMAdshot(uint32_t *bufferDMA, uint8_t paso, uint16_t paquete)
-**  Descripcion:    Carga en el buffer del DMA los valores
-**  Parametros:     Buffer, paso, paquete
-**  Retorno:        Tamanio del buffer
-****************************************************************************************/
-CODIGO_RAPIDO uint8_t cargarBufferDMAdshot(uint32_t *bufferDMA, uint8_t paso, uint16_t paquete)
-{
-    for (uint8_t i = 0; i < 16; i++) {
-        bufferDMA[i * paso] = (paquete & 0x8000) ? BIT_1_MOTOR : BIT_0_MOTOR;  // MSB primero
-        paquete <<= 1;
-    }
-    bufferDMA[16 * paso] = 0;
-    bufferDMA[17 * paso] = 0;
-
-    return TAMANIO_BUFFER_DMA_DSHOT;
-}
-
-
-/***************************************************************************************
-**  Nombre:         uint8_t cargarBufferDMAproshot(uint32_t *bufferDMA, uint8_t paso, uint16_t paquete)
-**  Descripcion:    Carga en el buffer del DMA los valores
-**  Parametros:     Buffer, paso, paquete
-**  Retorno:        Tamanio del buffer
-****************************************************************************************/
-uint8_t cargarBufferDMAproshot(uint32_t *bufferDMA, uint8_t paso, uint16_t paquete)
-{
-    for (uint8_t i = 0; i < 4; i++) {
-        bufferDMA[i * paso] = SIMBOLO_BASE_PROSHOT + ((paquete & 0xF000) >> 12) * ANCHO_BIT_PROSHOT;  // Primer cuarteto mas relevante
-        paquete <<= 4;   // Desplazamos 4 bits
-    }
-    bufferDMA[4 * paso] = 0;
-    bufferDMA[5 * paso] = 0;
-
-    return TAMANIO_BUFFER_DMA_PROSHOT;
-}
-
-
-/***************************************************************************************
-**  Nombre:         uint16_t prepararPaqueteDshot(motorDshot_t *const motor)
-**  Descripcion:    Prepara el paquete de la trama
-**  Parametros:     Puntero a la estructura Dshot
-**  Retorno:        Paquete
-****************************************************************************************/
-CODIGO_RAPIDO uint16_t prepararPaqueteDshot(motorDshot_t *const motor)
-{
-    uint16_t paquete = (motor->valor << 1) | (motor->solicitarTelemetria ? 1 : 0);
-    motor->solicitarTelemetria = false;
-
-    // Calculamos el checksum
-    int32_t csum = 0;
-    int32_t datoCsum = paquete;
-
-    for (uint8_t i = 0; i < 3; i++) {
-        csum ^=  datoCsum;   // XOR por cuartetos
-        datoCsum >>= 4;
-    }
-
-    csum &= 0xf;
-    paquete = (paquete << 4) | csum;
-
-    return paquete;
-}
-
-
 /***************************************************************************************
 **  Nombre:         void motor_DMA_IRQHandler(descriptorCanalDMA_t* descriptor)
 **  Descripcion:    Interrupcion del DMA
@@ -530,8 +633,22 @@ void motor_DMA_IRQHandler(descriptorCanalDMA_t* descriptor)
         else {
             motorDshot_t * const motor = &motoresDshot[descriptor->paramUsuario];
 
-            pararPWMcanalDMA(&motor->htim, motor->timer->canal);
+            // Con la captura llena no queda nada que hacer hasta la siguiente trama
+            if (motor->capturando)
+                __HAL_TIM_DISABLE_DMA(&motor->htim, motor->fuenteDMAtimer);
+            else
+                pararPWMcanalDMA(&motor->htim, motor->timer->canal);
+
             HAL_DMA_IRQHandler(motor->htim.hdma[motor->indiceDMAtimer]);
+
+            // El timer pasa a captura cuando han terminado todos sus canales
+            if (usarDshotBidireccional && !motor->capturando) {
+                motorDshotTimer_t *motorTimer = motor->motorTimer;
+
+                motorTimer->canalesEnviando &= ~(1 << (motor->timer->canal >> 2));
+                if (motorTimer->canalesEnviando == 0)
+                    iniciarCapturaTimerDshot(motorTimer);
+            }
         }
 
         LIMPIAR_FLAG_DMA(descriptor, DMA_IT_TCIF);
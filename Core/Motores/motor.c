@@ -34,8 +34,14 @@
 #include "GP/gp_motor.h"
 #include "FC/mixer.h"
 #include "dshot.h"
+#include "salida_motores.h"
+#include "telemetria_dshot.h"
 #include "Drivers/timer.h"
 #include "Drivers/io.h"
+#if defined(SITL)
+#include "SITL/modelo_quad.h"
+#include "SITL/telemetria_dshot_sitl.h"
+#endif
 
 
 /***************************************************************************************
@@ -57,12 +63,9 @@ static motor_t motor[NUM_MAX_MOTORES];
 static fnEscribirPWM *escribirPWM = NULL;
 static fnActualizarPWM *actualizarPWM = NULL;
 static bool esDshot;
-
-#ifdef USAR_DSHOT
-static fnCargarBufferDMA *cargarBufferDMA = NULL;
-#endif
 static bool motoresHabilitados = false;
 static bool motoresIniciados = false;
+static uint32_t tiempoConfirmacion;                           // us del ultimo envio PWM a los motores
 
 
 /***************************************************************************************
@@ -72,9 +75,11 @@ void actualizarPWMnoUsado(uint8_t numMotores);
 void actualizarPWMoneshot(uint8_t numMotores);
 void escribirPWMnoUsado(uint8_t indice, float valor);
 void escribirPWMestandar(uint8_t indice, float valor);
+void prepararMotor(uint8_t indice, float valor);
 
-#ifdef USAR_DSHOT
-void escribirPWMdshot(uint8_t indice, uint16_t valor);
+#if defined(SITL)
+bool iniciarMotoresSITL(void);
+void escribirPWMsitl(uint8_t indice, float valor);
 #endif
 
 
@@ -90,7 +95,7 @@ void escribirPWMdshot(uint8_t indice, uint16_t valor);
 ****************************************************************************************/
 bool iniciarMotores(void)
 {
-    memset(motores, 0, sizeof(motores));
+    memset(motor, 0, sizeof(motor));
 
     bool usarPWMnoSincronizado = false;
     float sMin = 0;
@@ -98,6 +103,11 @@ bool iniciarMotores(void)
     esDshot = false;
 
     switch (configMotor()->protocolo) {
+#if defined(SITL)
+        case PWM_TIPO_SITL:
+            return iniciarMotoresSITL();
+#endif
+
         case PWM_TIPO_ESTANDAR:
             sMin = 1e-3f;
             sLon = 1e-3f;
@@ -123,8 +133,8 @@ bool iniciarMotores(void)
         case PWM_TIPO_PROSHOT1000:
             esDshot = true;
             escribirPWM = &escribirPWMdshot;
-            cargarBufferDMA = &cargarBufferDMAproshot;
             actualizarPWM = &actualizarPWMdshot;
+            iniciarSalidaMotores(SALIDA_MOTORES_PROSHOT, false);
             break;
 
         case PWM_TIPO_DSHOT150:
@@ -132,11 +142,16 @@ bool iniciarMotores(void)
         case PWM_TIPO_DSHOT600:
         case PWM_TIPO_DSHOT1200:
             escribirPWM = &escribirPWMdshot;
-            cargarBufferDMA = &cargarBufferDMAdshot;
             actualizarPWM = &actualizarPWMdshot;
             esDshot = true;
-            if (configMotor()->usarBurstDshot)
+            // La respuesta se captura por el canal de cada motor, asi que excluye el burst
+            if (configMotor()->usarTelemetriaDshot) {
+                usarDshotBidireccional = true;
+                iniciarTelemetriaDshot(configMotor()->polosMotor);
+            }
+            else if (configMotor()->usarBurstDshot)
                 usarBurstDshot = true;
+            iniciarSalidaMotores(SALIDA_MOTORES_DSHOT, usarBurstDshot);
             break;
 #endif
     }
@@ -283,6 +298,21 @@ motor_t *motores(void)
 }
 
 
+/***************************************************************************************
+**  Nombre:         float valorMotor(uint8_t indice)
+**  Descripcion:    Devuelve el ultimo valor escrito en un motor
+**  Parametros:     Motor
+**  Retorno:        Valor del motor
+****************************************************************************************/
+float valorMotor(uint8_t indice)
+{
+    if (indice < NUM_MAX_MOTORES)
+        return motor[indice].valor;
+    else
+        return 0;
+}
+
+
 /***************************************************************************************
 **  Nombre:         bool esProtocoloMotorDshot(void)
 **  Descripcion:    Retorna si el protocolo es dshot
@@ -295,6 +325,46 @@ bool esProtocoloMotorDshot(void)
 }
 
 
+#ifdef USAR_DSHOT
+/***************************************************************************************
+**  Nombre:         bool dshotPorCanalMotores(void)
+**  Descripcion:    Retorna si la configuracion pide un stream DMA por motor. Se puede
+**                  llamar antes de iniciar los motores
+**  Parametros:     Ninguno
+**  Retorno:        True si DShot bidireccional, DShot sin burst o ProShot
+****************************************************************************************/
+bool dshotPorCanalMotores(void)
+{
+    switch (configMotor()->protocolo) {
+        case PWM_TIPO_PROSHOT1000:
+            return true;
+
+        case PWM_TIPO_DSHOT150:
+        case PWM_TIPO_DSHOT300:
+        case PWM_TIPO_DSHOT600:
+        case PWM_TIPO_DSHOT1200:
+            return configMotor()->usarTelemetriaDshot || !configMotor()->usarBurstDshot;
+
+        default:
+            return false;
+    }
+}
+#endif
+
+
+/***************************************************************************************
+**  Nombre:         void prepararMotor(uint8_t indice, float valor)
+**  Descripcion:    Deja el valor de un motor en los registros o buffers sin enviarlo
+**  Parametros:     Motor a escribir, valor
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void prepararMotor(uint8_t indice, float valor)
+{
+    motor[indice].valor = valor;
+    escribirPWM(indice, valor);
+}
+
+
 /***************************************************************************************
 **  Nombre:         void escribirMotor(uint8_t indice, float valor)
 **  Descripcion:    Escribe un valor en un motor
@@ -304,7 +374,7 @@ bool esProtocoloMotorDshot(void)
 void escribirMotor(uint8_t indice, float valor)
 {
 	if (estanMotoresHabilitados()) {
-        escribirPWM(indice, valor);
+        prepararMotor(indice, valor);
         actualizarMotores();
 	}
 }
@@ -312,17 +382,16 @@ void escribirMotor(uint8_t indice, float valor)
 
 /***************************************************************************************
 **  Nombre:         void escribirMotores(float *valor)
-**  Descripcion:    Escribe un valor en todos los motores
-**  Parametros:     Valor a escribir
+**  Descripcion:    Escribe un valor en cada motor. Se preparan todos y se envian juntos
+**  Parametros:     Valores a escribir
 **  Retorno:        Ninguno
 ****************************************************************************************/
-void escribirMotores(float *valor)
+CODIGO_RAPIDO void escribirMotores(float *valor)
 {
-
     if (estanMotoresHabilitados()) {
         uint8_t numeroMotores = numMotores();
         for (uint8_t i = 0; i < numeroMotores; i++)
-    	    escribirMotor(i, valor[i]);
+            prepararMotor(i, valor[i]);
 
         actualizarMotores();
     }
@@ -331,7 +400,7 @@ void escribirMotores(float *valor)
 
 /***************************************************************************************
 **  Nombre:         void escribirValorTodosMotores(float valor)
-**  Descripcion:    Escribe un valor en todos los motores
+**  Descripcion:    Escribe un valor en todos los motores. Se preparan todos y se envian juntos
 **  Parametros:     Valor a escribir
 **  Retorno:        Ninguno
 ****************************************************************************************/
@@ -340,7 +409,9 @@ void escribirValorTodosMotores(float valor)
     if (estanMotoresHabilitados()) {
         uint8_t numeroMotores = numMotores();
         for (uint8_t i = 0; i < numeroMotores; i++)
-    	    escribirMotor(i, valor);
+            prepararMotor(i, valor);
+
+        actualizarMotores();
     }
 }
 
@@ -376,13 +447,26 @@ void actualizarMotores(void)
 
     actualizarPWM(numMotores());
 
+    // Con DShot el envio lo marca la etapa de salida, que sabe si ha arrancado algun DMA
+    if (!esDshot)
+        tiempoConfirmacion = micros();
+}
 
 
+/***************************************************************************************
+**  Nombre:         uint32_t tiempoConfirmacionMotores(void)
+**  Descripcion:    Devuelve el instante del ultimo envio a los motores para medir latencias
+**  Parametros:     Ninguno
+**  Retorno:        Tiempo en us
+****************************************************************************************/
+uint32_t tiempoConfirmacionMotores(void)
+{
+#ifdef USAR_SALIDA_DSHOT
+    if (esDshot)
+        return tiempoConfirmacionSalidaMotores();
+#endif
 
-
-
-
-
+    return tiempoConfirmacion;
 }
 
 
@@ -451,16 +535,38 @@ void escribirPWMestandar(uint8_t indice, float valor)
 }
 
 
-#ifdef USAR_DSHOT
+#if defined(SITL)
+/***************************************************************************************
+**  Nombre:         bool iniciarMotoresSITL(void)
+**  Descripcion:    Conecta los motores al modelo del vehiculo. No hay timers que configurar
+**  Parametros:     Ninguno
+**  Retorno:        True si ok
+****************************************************************************************/
+bool iniciarMotoresSITL(void)
+{
+    escribirPWM = &escribirPWMsitl;
+    actualizarPWM = &actualizarPWMnoUsado;
+    iniciarTelemetriaDshot(POLOS_DEFECTO_MOTOR);
+
+    for (uint8_t i = 0; i < NUM_MAX_MOTORES && i < configMotor()->numMotores; i++)
+        motor[i].habilitado = true;
+
+    motoresIniciados = true;
+    return true;
+}
+
+
 /***************************************************************************************
-**  Nombre:         void escribirPWMdshot(uint8_t indice, float valor)
-**  Descripcion:    Funcion de escritura de los motores dshot
+**  Nombre:         void escribirPWMsitl(uint8_t indice, float valor)
+**  Descripcion:    Funcion de escritura de los motores simulados. El ESC simulado responde
+**                  con la velocidad del rotor como en DSHOT bidireccional
 **  Parametros:     Motor a escribir, valor entre 0 y 1
 **  Retorno:        Ninguno
 ****************************************************************************************/
-CODIGO_RAPIDO void escribirPWMdshot(uint8_t indice, float valor)
+void escribirPWMsitl(uint8_t indice, float valor)
 {
-    escribirPWMdshot(indice, valor);
+    escribirMandoModeloQuad(indice, valor);
+    responderDshotSITL(indice, frecuenciaRotorModeloQuad(indice));
 }
 #endif
 
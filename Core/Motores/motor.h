@@ -78,6 +78,9 @@ typedef enum {
     PWM_TIPO_DSHOT1200,
     PWM_TIPO_PROSHOT1000,
 #endif
+#if defined(SITL)
+    PWM_TIPO_SITL,
+#endif
 } protocoloMotor_e;
 
 typedef enum {
@@ -91,19 +94,13 @@ typedef struct {
     float offsetPulso;
     bool forzarOverflow;
     uint8_t habilitado;
+    float valor;                     // Ultimo valor escrito
 } motor_t;
 
-#ifdef USAR_DSHOT
-typedef uint8_t fnCargarBufferDMA(uint32_t *bufferDMA, uint8_t paso, uint16_t paquete);
-#endif
-
 
 /***************************************************************************************
 ** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
-#ifdef USAR_DSHOT
-extern fnCargarBufferDMA *cargarBufferDMA;
-#endif
 
 
 /***************************************************************************************
@@ -115,11 +112,16 @@ void habilitarMotores(void);
 bool estanMotoresHabilitados(void);
 bool estaMotorHabilitado(uint8_t numMotor);
 motor_t *motores(void);
+float valorMotor(uint8_t indice);
 bool esProtocoloMotorDshot(void);
+#ifdef USAR_DSHOT
+bool dshotPorCanalMotores(void);
+#endif
 
 void escribirMotor(uint8_t indice, float valor);
 void escribirMotores(float *valor);
 void escribirValorTodosMotores(float valor);
 void actualizarMotores(void);
+uint32_t tiempoConfirmacionMotores(void);
 
 #endif // __MOTOR_H_
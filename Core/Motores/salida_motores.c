@@ -0,0 +1,284 @@
+/***************************************************************************************
+**  salida_motores.c - Etapa de salida por lotes de los motores DSHOT/PROSHOT
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <string.h>
+
+#include "salida_motores.h"
+
+#ifdef USAR_SALIDA_DSHOT
+#include "Drivers/tiempo.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    uint32_t *buffer;                   // Primera palabra del motor en el buffer del DMA
+    uint8_t paso;                       // Palabras entre bits: 4 en burst y 1 en modo canal
+    uint8_t indiceTimer;
+    uint8_t mascaraCanal;
+    bool asignado;
+} salidaMotor_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static uint32_t bufferBurstDMA[NUM_MAX_TIMERS_SALIDA_MOTORES][TAM_BUFFER_BURST_SALIDA_MOTORES] RAM_RAPIDA_INI;
+static uint32_t bufferCanalDMA[NUM_MAX_MOTORES][TAMANIO_BUFFER_DMA_DSHOT] RAM_RAPIDA_INI;
+
+static timerSalidaMotores_t timerSalida[NUM_MAX_TIMERS_SALIDA_MOTORES];
+static salidaMotor_t salidaMotor[NUM_MAX_MOTORES];
+static uint8_t timersPendientes;                    // Mascara de timers con canales preparados
+static bool salidaBurst;
+static uint8_t (*cargarBufferDMA)(uint32_t *bufferDMA, uint8_t paso, uint16_t paquete) = cargarBufferDMAdshot;
+static estadisticasSalidaMotores_t estadisticasSalida;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         void iniciarSalidaMotores(codificacionSalidaMotores_e codificacion, bool burst)
+**  Descripcion:    Borra las asignaciones y los buffers y elige la codificacion
+**  Parametros:     Codificacion de los paquetes, true para un burst por timer
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarSalidaMotores(codificacionSalidaMotores_e codificacion, bool burst)
+{
+    memset(bufferBurstDMA, 0, sizeof(bufferBurstDMA));
+    memset(bufferCanalDMA, 0, sizeof(bufferCanalDMA));
+    memset(timerSalida, 0, sizeof(timerSalida));
+    memset(salidaMotor, 0, sizeof(salidaMotor));
+    memset(&estadisticasSalida, 0, sizeof(estadisticasSalida));
+
+    timersPendientes = 0;
+    salidaBurst = burst;
+    cargarBufferDMA = codificacion == SALIDA_MOTORES_PROSHOT ? cargarBufferDMAproshot : cargarBufferDMAdshot;
+
+    const uint8_t longitud = codificacion == SALIDA_MOTORES_PROSHOT ? TAMANIO_BUFFER_DMA_PROSHOT : TAMANIO_BUFFER_DMA_DSHOT;
+    for (uint8_t i = 0; i < NUM_MAX_TIMERS_SALIDA_MOTORES; i++) {
+        timerSalida[i].buffer = burst ? bufferBurstDMA[i] : NULL;
+        timerSalida[i].longitud = burst ? longitud * NUM_CANALES_TIMER_SALIDA_MOTORES : longitud;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool asignarSalidaMotor(uint8_t indice, uint8_t indiceTimer, uint8_t canal)
+**  Descripcion:    Asocia un motor a un canal de un timer
+**  Parametros:     Motor, indice del timer, canal (0 a 3)
+**  Retorno:        True si ok
+****************************************************************************************/
+bool asignarSalidaMotor(uint8_t indice, uint8_t indiceTimer, uint8_t canal)
+{
+    if (indice >= NUM_MAX_MOTORES || indiceTimer >= NUM_MAX_TIMERS_SALIDA_MOTORES || canal >= NUM_CANALES_TIMER_SALIDA_MOTORES)
+        return false;
+
+    salidaMotor_t *salida = &salidaMotor[indice];
+    timerSalidaMotores_t *timer = &timerSalida[indiceTimer];
+
+    if (salida->asignado || (timer->canalesAsignados & (1 << canal)))
+        return false;
+
+    salida->buffer = salidaBurst ? &bufferBurstDMA[indiceTimer][canal] : bufferCanalDMA[indice];
+    salida->paso = salidaBurst ? NUM_CANALES_TIMER_SALIDA_MOTORES : 1;
+    salida->indiceTimer = indiceTimer;
+    salida->mascaraCanal = 1 << canal;
+    salida->asignado = true;
+    timer->canalesAsignados |= salida->mascaraCanal;
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t *bufferSalidaMotor(uint8_t indice)
+**  Descripcion:    Devuelve el buffer del DMA de un motor en modo canal
+**  Parametros:     Motor
+**  Retorno:        Buffer o NULL si el motor no esta asignado o se usa burst
+****************************************************************************************/
+uint32_t *bufferSalidaMotor(uint8_t indice)
+{
+    if (indice >= NUM_MAX_MOTORES || !salidaMotor[indice].asignado || salidaBurst)
+        return NULL;
+
+    return bufferCanalDMA[indice];
+}
+
+
+/***************************************************************************************
+**  Nombre:         void prepararSalidaMotor(uint8_t indice, uint16_t paquete)
+**  Descripcion:    Codifica el paquete en el buffer del motor sin arrancar el DMA
+**  Parametros:     Motor, paquete con el checksum
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void prepararSalidaMotor(uint8_t indice, uint16_t paquete)
+{
+    if (indice >= NUM_MAX_MOTORES || !salidaMotor[indice].asignado)
+        return;
+
+    const salidaMotor_t *salida = &salidaMotor[indice];
+    cargarBufferDMA(salida->buffer, salida->paso, paquete);
+    timerSalida[salida->indiceTimer].canalesPreparados |= salida->mascaraCanal;
+    timersPendientes |= 1 << salida->indiceTimer;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t confirmarSalidaMotores(void)
+**  Descripcion:    Arranca una vez el DMA de cada timer con canales preparados
+**  Parametros:     Ninguno
+**  Retorno:        Numero de arranques
+****************************************************************************************/
+CODIGO_RAPIDO uint8_t confirmarSalidaMotores(void)
+{
+    uint8_t arranques = 0;
+
+    estadisticasSalida.confirmaciones++;
+
+    while (timersPendientes) {
+        const uint8_t i = __builtin_ctz(timersPendientes);
+        timerSalidaMotores_t *timer = &timerSalida[i];
+
+        timersPendientes &= ~(1 << i);
+        arrancarDMAsalidaMotores(i, timer);
+        timer->canalesPreparados = 0;
+        arranques++;
+    }
+
+    if (arranques > 0) {
+        estadisticasSalida.arranquesDMA += arranques;
+        estadisticasSalida.tiempoConfirmacion = micros();
+    }
+
+    return arranques;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void estadisticasSalidaMotores(estadisticasSalidaMotores_t *estadisticas)
+**  Descripcion:    Copia los contadores de la etapa de salida
+**  Parametros:     Estadisticas leidas
+**  Retorno:        Ninguno
+****************************************************************************************/
+void estadisticasSalidaMotores(estadisticasSalidaMotores_t *estadisticas)
+{
+    *estadisticas = estadisticasSalida;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t tiempoConfirmacionSalidaMotores(void)
+**  Descripcion:    Devuelve el instante de la ultima confirmacion que arranco algun DMA
+**  Parametros:     Ninguno
+**  Retorno:        Tiempo en us
+****************************************************************************************/
+uint32_t tiempoConfirmacionSalidaMotores(void)
+{
+    return estadisticasSalida.tiempoConfirmacion;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t prepararPaqueteDshot(uint16_t valor, bool telemetria, bool bidireccional)
+**  Descripcion:    Prepara el paquete de la trama con el bit de telemetria y el checksum
+**  Parametros:     Valor o comando (11 bits), solicitud de telemetria, true si el ESC debe
+**                  responder con el eRPM (el checksum va invertido)
+**  Retorno:        Paquete
+****************************************************************************************/
+CODIGO_RAPIDO uint16_t prepararPaqueteDshot(uint16_t valor, bool telemetria, bool bidireccional)
+{
+    uint16_t paquete = (valor << 1) | (telemetria ? 1 : 0);
+
+    // Calculamos el checksum
+    int32_t csum = 0;
+    int32_t datoCsum = paquete;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        csum ^=  datoCsum;   // XOR por cuartetos
+        datoCsum >>= 4;
+    }
+
+    if (bidireccional)
+        csum = ~csum;
+
+    csum &= 0xf;
+    paquete = (paquete << 4) | csum;
+
+    return paquete;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t cargarBufferDMAdshot(uint32_t *bufferDMA, uint8_t paso, uint16_t paquete)
+**  Descripcion:    Carga en el buffer del DMA los valores
+**  Parametros:     Buffer, paso, paquete
+**  Retorno:        Tamanio del buffer
+****************************************************************************************/
+CODIGO_RAPIDO uint8_t cargarBufferDMAdshot(uint32_t *bufferDMA, uint8_t paso, uint16_t paquete)
+{
+    for (uint8_t i = 0; i < 16; i++) {
+        bufferDMA[i * paso] = (paquete & 0x8000) ? BIT_1_MOTOR : BIT_0_MOTOR;  // MSB primero
+        paquete <<= 1;
+    }
+    bufferDMA[16 * paso] = 0;
+    bufferDMA[17 * paso] = 0;
+
+    return TAMANIO_BUFFER_DMA_DSHOT;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t cargarBufferDMAproshot(uint32_t *bufferDMA, uint8_t paso, uint16_t paquete)
+**  Descripcion:    Carga en el buffer del DMA los valores
+**  Parametros:     Buffer, paso, paquete
+**  Retorno:        Tamanio del buffer
+****************************************************************************************/
+uint8_t cargarBufferDMAproshot(uint32_t *bufferDMA, uint8_t paso, uint16_t paquete)
+{
+    for (uint8_t i = 0; i < 4; i++) {
+        bufferDMA[i * paso] = SIMBOLO_BASE_PROSHOT + ((paquete & 0xF000) >> 12) * ANCHO_BIT_PROSHOT;  // Primer cuarteto mas relevante
+        paquete <<= 4;   // Desplazamos 4 bits
+    }
+    bufferDMA[4 * paso] = 0;
+    bufferDMA[5 * paso] = 0;
+
+    return TAMANIO_BUFFER_DMA_PROSHOT;
+}
+
+#endif
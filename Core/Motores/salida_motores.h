@@ -0,0 +1,101 @@
+/***************************************************************************************
+**  salida_motores.h - Etapa de salida por lotes de los motores DSHOT/PROSHOT
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __SALIDA_MOTORES_H
+#define __SALIDA_MOTORES_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "dshot.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * La escritura de los motores se hace en dos fases. Preparar codifica el paquete de un
+ * motor en el buffer del DMA de su timer (intercalado CCR1..CCR4 en modo burst o propio
+ * del canal) y solo marca el canal como pendiente. Confirmar arranca una vez el DMA de
+ * cada timer con canales pendientes, de modo que con 12 motores en 4 timers hay 4
+ * arranques por iteracion del lazo en lugar de uno por motor.
+ *
+ * El modulo no usa la HAL. El arranque se delega en arrancarDMAsalidaMotores
+ * (dshot_hal.c en el micro y SITL/salida_motores_sitl.c en el PC). Los buffers estan en
+ * la DTCM, que no pasa por la cache de datos, asi que no hay que limpiarla antes del DMA
+ */
+#define NUM_MAX_TIMERS_SALIDA_MOTORES       8
+#define NUM_CANALES_TIMER_SALIDA_MOTORES    4
+#define TAM_BUFFER_BURST_SALIDA_MOTORES     (TAMANIO_BUFFER_DMA_DSHOT * NUM_CANALES_TIMER_SALIDA_MOTORES)
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef enum {
+    SALIDA_MOTORES_DSHOT = 0,
+    SALIDA_MOTORES_PROSHOT,
+} codificacionSalidaMotores_e;
+
+typedef struct {
+    uint32_t *buffer;                   // Buffer del burst o NULL en modo canal
+    uint16_t longitud;                  // Palabras a transferir (del burst o de cada canal)
+    uint8_t canalesAsignados;           // Mascara de canales con motor
+    uint8_t canalesPreparados;          // Mascara de canales escritos desde la ultima confirmacion
+} timerSalidaMotores_t;
+
+typedef struct {
+    uint32_t confirmaciones;
+    uint32_t arranquesDMA;
+    uint32_t tiempoConfirmacion;        // us de la ultima confirmacion con algun arranque
+} estadisticasSalidaMotores_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void iniciarSalidaMotores(codificacionSalidaMotores_e codificacion, bool burst);
+bool asignarSalidaMotor(uint8_t indice, uint8_t indiceTimer, uint8_t canal);
+uint32_t *bufferSalidaMotor(uint8_t indice);
+void prepararSalidaMotor(uint8_t indice, uint16_t paquete);
+uint8_t confirmarSalidaMotores(void);
+void estadisticasSalidaMotores(estadisticasSalidaMotores_t *estadisticas);
+uint32_t tiempoConfirmacionSalidaMotores(void);
+
+uint16_t prepararPaqueteDshot(uint16_t valor, bool telemetria, bool bidireccional);
+uint8_t cargarBufferDMAdshot(uint32_t *bufferDMA, uint8_t paso, uint16_t paquete);
+uint8_t cargarBufferDMAproshot(uint32_t *bufferDMA, uint8_t paso, uint16_t paquete);
+
+// Implementada por el driver del micro o por el entorno SITL
+void arrancarDMAsalidaMotores(uint8_t indiceTimer, const timerSalidaMotores_t *timer);
+
+#endif // __SALIDA_MOTORES_H
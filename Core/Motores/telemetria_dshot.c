@@ -0,0 +1,262 @@
+/***************************************************************************************
+**  telemetria_dshot.c - Telemetria de eRPM de DSHOT bidireccional
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <string.h>
+
+#include "telemetria_dshot.h"
+
+#ifdef USAR_SALIDA_DSHOT
+#include "Drivers/tiempo.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define GCR_INVALIDO_DSHOT                  0x10         // Marca de quinteto invalido en la tabla
+#define PERIODO_PARADO_DSHOT                0x0FFF
+#define US_POR_MINUTO                       60000000
+#define VENTANA_TASA_ERROR_DSHOT            250          // Respuestas por calculo de la tasa de error
+#define TIMEOUT_TELEMETRIA_DSHOT_US         20000        // Sin respuestas validas la frecuencia deja de publicarse
+#define TASA_ERROR_MAX_DSHOT                100          // Por mil. Por encima no se publica la frecuencia
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+// Quinteto GCR a cuarteto
+static const uint8_t tablaGCRdshot[32] = {
+    GCR_INVALIDO_DSHOT, GCR_INVALIDO_DSHOT, GCR_INVALIDO_DSHOT, GCR_INVALIDO_DSHOT,
+    GCR_INVALIDO_DSHOT, GCR_INVALIDO_DSHOT, GCR_INVALIDO_DSHOT, GCR_INVALIDO_DSHOT,
+    GCR_INVALIDO_DSHOT, 0x9,                0xA,                0xB,
+    GCR_INVALIDO_DSHOT, 0xD,                0xE,                0xF,
+    GCR_INVALIDO_DSHOT, GCR_INVALIDO_DSHOT, 0x2,                0x3,
+    GCR_INVALIDO_DSHOT, 0x5,                0x6,                0x7,
+    GCR_INVALIDO_DSHOT, 0x0,                0x8,                0x1,
+    GCR_INVALIDO_DSHOT, 0x4,                0xC,                GCR_INVALIDO_DSHOT,
+};
+
+static telemetriaMotorDshot_t telemetriaMotor[NUM_MAX_MOTORES];
+static uint16_t erroresVentana[NUM_MAX_MOTORES];
+static uint16_t respuestasVentana[NUM_MAX_MOTORES];
+static float rpmPorErpm = 2.0f / POLOS_DEFECTO_MOTOR;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         void iniciarTelemetriaDshot(uint8_t polos)
+**  Descripcion:    Borra la telemetria de los motores
+**  Parametros:     Numero de polos de los motores
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarTelemetriaDshot(uint8_t polos)
+{
+    memset(telemetriaMotor, 0, sizeof(telemetriaMotor));
+    memset(erroresVentana, 0, sizeof(erroresVentana));
+    memset(respuestasVentana, 0, sizeof(respuestasVentana));
+
+    rpmPorErpm = 2.0f / (polos >= 2 ? polos : POLOS_DEFECTO_MOTOR);
+}
+
+
+/***************************************************************************************
+**  Nombre:         resultadoRespuestaDshot_e decodificarRespuestaDshot(const uint16_t *flancos,
+**                                      uint8_t numFlancos, uint16_t ticksBit, uint32_t *erpm)
+**  Descripcion:    Decodifica la respuesta a partir de los tiempos de sus flancos. El primer
+**                  flanco es el del bit de arranque y el ultimo tramo llega hasta el bit 21.
+**                  Los tiempos pueden desbordar el contador de 16 bits
+**  Parametros:     Tiempos de captura del timer, numero de flancos, ticks por bit, eRPM
+**  Retorno:        Resultado de la decodificacion
+****************************************************************************************/
+CODIGO_RAPIDO resultadoRespuestaDshot_e decodificarRespuestaDshot(const uint16_t *flancos, uint8_t numFlancos, uint16_t ticksBit, uint32_t *erpm)
+{
+    if (numFlancos == 0)
+        return RESPUESTA_DSHOT_SIN_RESPUESTA;
+
+    // Cada tramo entre flancos aporta un 1 (el cambio) seguido de ceros
+    const uint16_t mitadBit = ticksBit / 2;
+    uint32_t valor = 0;
+    uint8_t bits = 0;
+
+    for (uint8_t i = 1; i < numFlancos && bits < NUM_BITS_RESPUESTA_DSHOT; i++) {
+        const uint16_t tramo = (uint16_t)(flancos[i] - flancos[i - 1]);
+        uint32_t longitud = (tramo + mitadBit) / ticksBit;
+
+        if (longitud == 0)
+            return RESPUESTA_DSHOT_ERROR_LONGITUD;
+
+        // Si la respuesta termina en bajo la linea vuelve al reposo con un ultimo flanco tardio
+        if (bits + longitud > NUM_BITS_RESPUESTA_DSHOT) {
+            if (i != numFlancos - 1)
+                return RESPUESTA_DSHOT_ERROR_LONGITUD;
+
+            longitud = NUM_BITS_RESPUESTA_DSHOT - bits;
+        }
+
+        valor = (valor << longitud) | (1UL << (longitud - 1));
+        bits += longitud;
+    }
+
+    // El ultimo nivel se mantiene hasta el final sin flanco si termina en alto
+    if (bits < NUM_BITS_RESPUESTA_DSHOT) {
+        const uint8_t longitud = NUM_BITS_RESPUESTA_DSHOT - bits;
+        valor = (valor << longitud) | (1UL << (longitud - 1));
+    }
+
+    // Los 20 bits de menor peso son el GCR (el bit 20 es el arranque)
+    const uint8_t c0 = tablaGCRdshot[valor & 0x1F];
+    const uint8_t c1 = tablaGCRdshot[(valor >> 5) & 0x1F];
+    const uint8_t c2 = tablaGCRdshot[(valor >> 10) & 0x1F];
+    const uint8_t c3 = tablaGCRdshot[(valor >> 15) & 0x1F];
+
+    if ((c0 | c1 | c2 | c3) & GCR_INVALIDO_DSHOT)
+        return RESPUESTA_DSHOT_ERROR_GCR;
+
+    const uint16_t dato = c0 | (c1 << 4) | (c2 << 8) | (c3 << 12);
+    if (((dato ^ (dato >> 4) ^ (dato >> 8) ^ (dato >> 12)) & 0xF) != 0xF)
+        return RESPUESTA_DSHOT_ERROR_CRC;
+
+    const uint16_t periodoCodificado = dato >> 4;
+    if (periodoCodificado == PERIODO_PARADO_DSHOT) {
+        *erpm = 0;
+        return RESPUESTA_DSHOT_OK;
+    }
+
+    const uint32_t periodo = (uint32_t)(periodoCodificado & 0x1FF) << (periodoCodificado >> 9);
+    if (periodo == 0)
+        return RESPUESTA_DSHOT_ERROR_CRC;
+
+    *erpm = (US_POR_MINUTO + periodo / 2) / periodo;
+    return RESPUESTA_DSHOT_OK;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void procesarRespuestaDshot(uint8_t indice, const uint16_t *flancos,
+**                                              uint8_t numFlancos, uint16_t ticksBit)
+**  Descripcion:    Decodifica la respuesta capturada de un motor y la publica
+**  Parametros:     Motor, tiempos de captura, numero de flancos, ticks por bit
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void procesarRespuestaDshot(uint8_t indice, const uint16_t *flancos, uint8_t numFlancos, uint16_t ticksBit)
+{
+    uint32_t erpm = 0;
+    const resultadoRespuestaDshot_e resultado = decodificarRespuestaDshot(flancos, numFlancos, ticksBit, &erpm);
+
+    publicarErpmDshot(indice, resultado, erpm);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void publicarErpmDshot(uint8_t indice, resultadoRespuestaDshot_e resultado, uint32_t erpm)
+**  Descripcion:    Actualiza la telemetria de un motor con el resultado de una respuesta
+**  Parametros:     Motor, resultado de la decodificacion, eRPM si es valida
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void publicarErpmDshot(uint8_t indice, resultadoRespuestaDshot_e resultado, uint32_t erpm)
+{
+    if (indice >= NUM_MAX_MOTORES)
+        return;
+
+    telemetriaMotorDshot_t *telemetria = &telemetriaMotor[indice];
+
+    switch (resultado) {
+        case RESPUESTA_DSHOT_OK:
+            telemetria->erpm = erpm;
+            telemetria->frecuencia = erpm * rpmPorErpm * (1.0f / 60.0f);
+            telemetria->tiempo = micros();
+            telemetria->respuestas++;
+            break;
+
+        case RESPUESTA_DSHOT_SIN_RESPUESTA:
+            telemetria->sinRespuesta++;
+            erroresVentana[indice]++;
+            break;
+
+        default:
+            telemetria->errores++;
+            erroresVentana[indice]++;
+            break;
+    }
+
+    if (++respuestasVentana[indice] >= VENTANA_TASA_ERROR_DSHOT) {
+        telemetria->tasaError = (uint32_t)erroresVentana[indice] * 1000 / respuestasVentana[indice];
+        erroresVentana[indice] = 0;
+        respuestasVentana[indice] = 0;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         const telemetriaMotorDshot_t *telemetriaMotorDshot(uint8_t indice)
+**  Descripcion:    Devuelve la telemetria de un motor
+**  Parametros:     Motor
+**  Retorno:        Telemetria o NULL si el motor no existe
+****************************************************************************************/
+const telemetriaMotorDshot_t *telemetriaMotorDshot(uint8_t indice)
+{
+    if (indice >= NUM_MAX_MOTORES)
+        return NULL;
+
+    return &telemetriaMotor[indice];
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool frecuenciaRotorMotor(uint8_t indice, float *frecuencia)
+**  Descripcion:    Devuelve la frecuencia de giro de un motor si la telemetria es reciente
+**                  y tiene pocos errores
+**  Parametros:     Motor, frecuencia en Hz
+**  Retorno:        True si la frecuencia es valida
+****************************************************************************************/
+CODIGO_RAPIDO bool frecuenciaRotorMotor(uint8_t indice, float *frecuencia)
+{
+    if (indice >= NUM_MAX_MOTORES)
+        return false;
+
+    const telemetriaMotorDshot_t *telemetria = &telemetriaMotor[indice];
+    if (telemetria->respuestas == 0 || micros() - telemetria->tiempo > TIMEOUT_TELEMETRIA_DSHOT_US ||
+        telemetria->tasaError > TASA_ERROR_MAX_DSHOT)
+        return false;
+
+    *frecuencia = telemetria->frecuencia;
+    return true;
+}
+
+#endif
@@ -0,0 +1,93 @@
+/***************************************************************************************
+**  telemetria_dshot.h - Telemetria de eRPM de DSHOT bidireccional
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __TELEMETRIA_DSHOT_H
+#define __TELEMETRIA_DSHOT_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "dshot.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Con DSHOT bidireccional la salida esta invertida (reposo en alto) y el ESC responde
+ * unos 30 us despues de cada trama por la misma linea a 5/4 de la velocidad de la trama.
+ * La respuesta tiene 21 bits: un bit de arranque a 0 y 20 bits GCR en los que un 1 es un
+ * cambio de nivel. El timer captura los flancos por DMA y aqui se convierten los tiempos
+ * entre flancos en tramos de bits, se recupera el GCR y cada quinteto se pasa a cuarteto
+ * con una tabla. Los 16 bits son eeem mmmm mmmm cccc: el periodo electrico en us es
+ * m << e y el checksum es el de la trama invertido. El periodo 0xFFF indica motor parado
+ */
+#define NUM_BITS_RESPUESTA_DSHOT            21
+#define NUM_MAX_FLANCOS_RESPUESTA_DSHOT     (NUM_BITS_RESPUESTA_DSHOT + 1)
+#define TICKS_BIT_RESPUESTA_DSHOT           (LONGITUD_BIT_MOTOR * 4 / 5)   // Ticks del timer por bit de la respuesta
+
+#define POLOS_DEFECTO_MOTOR                 14
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef enum {
+    RESPUESTA_DSHOT_OK = 0,
+    RESPUESTA_DSHOT_SIN_RESPUESTA,
+    RESPUESTA_DSHOT_ERROR_LONGITUD,                  // Los tramos no suman 21 bits
+    RESPUESTA_DSHOT_ERROR_GCR,                       // Quinteto que no existe en la tabla GCR
+    RESPUESTA_DSHOT_ERROR_CRC,
+} resultadoRespuestaDshot_e;
+
+typedef struct {
+    uint32_t erpm;                                   // rpm electricas de la ultima respuesta valida
+    float frecuencia;                                // Frecuencia de giro del rotor en Hz
+    uint32_t tiempo;                                 // us de la ultima respuesta valida
+    uint32_t respuestas;
+    uint32_t errores;                                // Respuestas con error de longitud, GCR o CRC
+    uint32_t sinRespuesta;
+    uint16_t tasaError;                              // Errores por mil en la ultima ventana
+} telemetriaMotorDshot_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void iniciarTelemetriaDshot(uint8_t polos);
+resultadoRespuestaDshot_e decodificarRespuestaDshot(const uint16_t *flancos, uint8_t numFlancos, uint16_t ticksBit, uint32_t *erpm);
+void procesarRespuestaDshot(uint8_t indice, const uint16_t *flancos, uint8_t numFlancos, uint16_t ticksBit);
+void publicarErpmDshot(uint8_t indice, resultadoRespuestaDshot_e resultado, uint32_t erpm);
+const telemetriaMotorDshot_t *telemetriaMotorDshot(uint8_t indice);
+bool frecuenciaRotorMotor(uint8_t indice, float *frecuencia);
+
+#endif // __TELEMETRIA_DSHOT_H
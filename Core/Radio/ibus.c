@@ -32,26 +32,20 @@
 #ifdef USAR_RADIO_UART
 #include "GP/gp_radio.h"
 #include "Drivers/uart.h"
-#include "Drivers/tiempo.h"
+#include "trama_radio.h"
 
 
 /***************************************************************************************
 ** AREA DE PREPROCESADOR                                                              **
 ****************************************************************************************/
-#define TAMANIO_FRAME_IBUS          32
-#define TAMANIO_FRAME_IBUS_32       8
-#define NUM_CANALES_ENTRADA_IBUS    14
 
 
 /***************************************************************************************
 ** AREA DE DEFINICION DE TIPOS                                                        **
 ****************************************************************************************/
 typedef struct {
-    bool tramaRecibida;
-    uint8_t buffer[TAMANIO_FRAME_IBUS];
-    uint32_t trama[TAMANIO_FRAME_IBUS_32];  // Buffer 4 veces mas pequeno para optimizacion
-    uint8_t offset;
-    uint32_t tiempoAnterior;
+    ensambladorRadio_t ensamblador;
+    bool failsafe;                        // La ultima trama decodificada indicaba failsafe
 } ibus_t;
 
 
@@ -66,7 +60,6 @@ static ibus_t ibus;
 ****************************************************************************************/
 bool iniciarIBUS(void);
 void procesarByteIBUS(uint8_t RxByte);
-bool decodificarTramaIBUS(const uint8_t *trama, uint16_t *valores);
 void leerIBUS(uint32_t tiempoActual);
 
 
@@ -83,6 +76,7 @@ void leerIBUS(uint32_t tiempoActual);
 bool iniciarIBUS(void)
 {
     memset(&ibus, 0, sizeof(ibus_t));
+    iniciarEnsambladorRadio(&ibus.ensamblador, TAM_TRAMA_IBUS, INICIO_TRAMA_IBUS, DURACION_MAX_TRAMA_IBUS);
 
     // Arrancamos la UART
     configIniUART_t config;
@@ -99,96 +93,50 @@ bool iniciarIBUS(void)
 
 /***************************************************************************************
 **  Nombre:         void procesarByteIBUS(uint8_t RxByte)
-**  Descripcion:    Recibe los bytes de la trama IBUs
+**  Descripcion:    Recibe los bytes de la trama IBUS
 **  Parametros:     Byte recibido
 **  Retorno:        Ninguno
 ****************************************************************************************/
-void procesarByteIBUS(uint8_t RxByte)
+CODIGO_RAPIDO void procesarByteIBUS(uint8_t RxByte)
 {
-    ibus_t *driver = &ibus;
-
-    uint32_t tiempoActual = microsISR();
-    const bool separacionTrama = (tiempoActual - driver->tiempoAnterior >= 2000U);
-    driver->tiempoAnterior = tiempoActual;
-
-    if (separacionTrama)                         // Si tenemos separacion reseteamos el offset para recibir nueva trama
-    	driver->offset = 0;
-
-    if (RxByte != 0x20 && driver->offset == 0)      // Para ser IBUS el primer byte es 0x20
-        return;
-
-    if (driver->offset == 0 && !separacionTrama) // Debe haber una separacion entre tramas para empezar un nuevo frame
-        return;
-
-    driver->buffer[driver->offset++] = RxByte;
-
-    if (driver->offset == sizeof(driver->buffer)) {
-    	driver->offset = 0;
-    	driver->tramaRecibida = true;
-
-        uint32_t *p = (uint32_t *)driver->buffer;
-        for (uint8_t i = 0; i < TAMANIO_FRAME_IBUS_32; i++) {
-            driver->trama[i] = *p;
-            p++;
-        }
-    }
-}
-
-
-/***************************************************************************************
-**  Nombre:         bool decodificarTramaIBUS(const uint8_t *trama, uint16_t *valores
-**  Descripcion:    Obtiene los valores de los canales dada una trama
-**  Parametros:     Trama, valores de los canales
-**  Retorno:        True si ok, failsafe
-****************************************************************************************/
-bool decodificarTramaIBUS(const uint8_t *trama, uint16_t *valores)
-{
-    uint32_t checksum = 96;
-
-    // El inicio de la trama comienza con 0x20, 0x40
-    if ((trama[0] != 0x20) || (trama[1] != 0x40))
-        return false;
-
-    // Extraemos los datos de la trama
-    for (uint8_t canal = 0, i = 2; canal < NUM_CANALES_ENTRADA_IBUS; canal++, i += 2) {
-        valores[canal] = trama[i] | (trama[i + 1] & 0x0F) << 8;
-        checksum += trama[i] + trama[i + 1];
-    }
-
-    checksum += trama[TAMANIO_FRAME_IBUS - 2] | trama[TAMANIO_FRAME_IBUS - 1] << 8;
-
-    if (checksum != 0xFFFF)
-        return false;
-
-    if ((trama[3] & 0xF0) || (trama[9] & 0xF0)) { // Failsafe
-        activarFailsafeRadio();
-        return false;
-    }
-
-    return true;
+    procesarByteEnsambladorRadio(&ibus.ensamblador, RxByte);
 }
 
 
 /***************************************************************************************
 **  Nombre:         void leerIBUS(uint32_t tiempoActual)
-**  Descripcion:    Lee la trama
-**  Parametros:     Ninguno
+**  Descripcion:    Decodifica la ultima trama recibida. El failsafe se mantiene hasta que
+**                  llega una trama que no lo indica
+**  Parametros:     Tiempo actual
 **  Retorno:        Ninguno
 ****************************************************************************************/
 void leerIBUS(uint32_t tiempoActual)
 {
-    UNUSED(tiempoActual);
     ibus_t *driver = &ibus;
-
-    if (!driver->tramaRecibida)
-        return;
-
-    uint16_t valores[NUM_CANALES_ENTRADA_IBUS];
-
-    if (decodificarTramaIBUS((uint8_t *)driver->trama, valores)) {
-    	driver->tramaRecibida = false;
-        anadirRecepcionRadio(NUM_CANALES_ENTRADA_IBUS, valores);
+    uint16_t valores[NUM_CANALES_IBUS];
+    uint32_t tiempoTrama;
+
+    switch (leerTramaRadio(&driver->ensamblador, decodificarTramaIBUS, valores, &tiempoTrama)) {
+        case TRAMA_RADIO_OK:
+            driver->failsafe = false;
+            anadirRecepcionRadio(NUM_CANALES_IBUS, valores, tiempoTrama);
+            break;
+
+        case TRAMA_RADIO_FAILSAFE:
+            driver->failsafe = true;
+            break;
+
+        case TRAMA_RADIO_PERDIDA:
+        case TRAMA_RADIO_INVALIDA:
+            driver->failsafe = false;
+            break;
+
+        default:
+            break;
     }
+
+    if (driver->failsafe)
+        activarFailsafeRadio();
 }
 
 
@@ -30,6 +30,7 @@
 #ifdef USAR_RADIO_PPM
 #include "GP/gp_radio.h"
 #include "Drivers/timer.h"
+#include "Drivers/tiempo.h"
 #include "Motores/motor.h"
 #include "Drivers/io.h"
 #include "Comun/util.h"
@@ -197,7 +198,7 @@ void edgeCallbackPPM(timerCCHandlerRec_t* cbRec, uint16_t captura)
             for (i = ppm.numCanales; i < NUM_CANALES_PPM; i++)
                 capturasPPM[i] = 0;
 
-            anadirRecepcionRadio(ppm.numCanales, capturasPPM);
+            anadirRecepcionRadio(ppm.numCanales, capturasPPM, microsISR());
         }
 
         ppm.tracking = true;
@@ -101,6 +101,12 @@ bool iniciarRadio(void)
         	tablaFnRadio = &tablaFnRadioSBUS;
             ajustarFrecuenciaEjecucionTarea(TAREA_LEER_RADIO, PERIODO_TAREA_HZ_SCHEDULER(configRadio()->frecLeer));
             break;
+#endif
+#if defined(SITL)
+        case RX_SITL:
+        	tablaFnRadio = &tablaFnRadioSITL;
+            ajustarFrecuenciaEjecucionTarea(TAREA_LEER_RADIO, PERIODO_TAREA_HZ_SCHEDULER(configRadio()->frecLeer));
+            break;
 #endif
         default:
 #ifdef DEBUG
@@ -178,6 +184,7 @@ void leerRadio(uint32_t tiempoActual)
 
         if (nuevaRecepcionRadio()) {
             radio.nuevaEntrada = true;
+            radio.latenciaPendiente = true;
             radio.ultimaMedida = tiempoActual;
         }
     }
@@ -187,21 +194,74 @@ void leerRadio(uint32_t tiempoActual)
 
 
 /***************************************************************************************
-**  Nombre:         void anadirRecepcionRadio(uint8_t numValores, uint16_t *valores)
+**  Nombre:         void anadirRecepcionRadio(uint8_t numValores, uint16_t *valores, uint32_t tiempoTrama)
 **  Descripcion:    Anade una nueva recepcion de datos de radio
-**  Parametros:     Numero de canales recibidos, valores de los canales, failsafe
+**  Parametros:     Numero de canales recibidos, valores de los canales, llegada de la
+**                  trama en us
 **  Retorno:        Ninguno
 ****************************************************************************************/
-void anadirRecepcionRadio(uint8_t numValores, uint16_t *valores)
+void anadirRecepcionRadio(uint8_t numValores, uint16_t *valores, uint32_t tiempoTrama)
 {
     numValores = MIN(numValores, NUM_MAX_CANALES_RADIO);
     memcpy(radio.canales, valores, numValores * sizeof(uint16_t));
 
     radio.numCanales = numValores;
+    radio.tiempoTrama = tiempoTrama;
     radio.contadorEntradas++;
 }
 
 
+/***************************************************************************************
+**  Nombre:         void medirLatenciaRadio(uint32_t tiempoActual)
+**  Descripcion:    Mide el tiempo desde que llego la trama hasta que la usa actualizarRC.
+**                  Solo cuenta la primera vez que se usa cada entrada
+**  Parametros:     Tiempo actual
+**  Retorno:        Ninguno
+****************************************************************************************/
+void medirLatenciaRadio(uint32_t tiempoActual)
+{
+    latenciaRadio_t *latencia = &radio.latencia;
+
+    if (!radio.latenciaPendiente)
+        return;
+
+    radio.latenciaPendiente = false;
+    latencia->ultima = tiempoActual - radio.tiempoTrama;
+    latencia->maxima = MAX(latencia->maxima, latencia->ultima);
+
+    if (latencia->muestras == 0)
+        latencia->media = latencia->ultima;
+    else
+        latencia->media += (int32_t)(latencia->ultima - latencia->media) / 8;
+
+    latencia->muestras++;
+}
+
+
+/***************************************************************************************
+**  Nombre:         const latenciaRadio_t *latenciaRadio(void)
+**  Descripcion:    Devuelve las medidas de latencia de la radio
+**  Parametros:     Ninguno
+**  Retorno:        Medidas
+****************************************************************************************/
+const latenciaRadio_t *latenciaRadio(void)
+{
+    return &radio.latencia;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void resetearLatenciaRadio(void)
+**  Descripcion:    Borra las medidas de latencia de la radio
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void resetearLatenciaRadio(void)
+{
+    memset(&radio.latencia, 0, sizeof(radio.latencia));
+}
+
+
 /***************************************************************************************
 **  Nombre:         bool nuevaRecepcionRadio(void)
 **  Descripcion:    Comprueba si ha habido una nueva recepcion de datos
@@ -67,8 +67,18 @@ typedef enum {
 	RX_PPM     =  0,
     RX_IBUS,
     RX_SBUS,
+#if defined(SITL)
+    RX_SITL,
+#endif
 } protocoloRadio_e;
 
+typedef struct {
+    uint32_t ultima;                      // us desde el inicio de la trama hasta actualizarRC
+    uint32_t maxima;
+    uint32_t media;                       // Media movil con peso 1/8
+    uint32_t muestras;
+} latenciaRadio_t;
+
 typedef struct {
     uint16_t canales[NUM_MAX_CANALES_RADIO];
     uint8_t numCanales;
@@ -78,6 +88,9 @@ typedef struct {
     bool iniciada;
     bool nuevaEntrada;
     uint32_t ultimaMedida;
+    uint32_t tiempoTrama;                 // Llegada de la ultima trama en us
+    bool latenciaPendiente;               // Entrada nueva que todavia no ha usado actualizarRC
+    latenciaRadio_t latencia;
 } radio_t;
 
 typedef struct {
@@ -92,6 +105,9 @@ typedef struct {
 extern tablaFnRadio_t tablaFnRadioPPM;
 extern tablaFnRadio_t tablaFnRadioIBUS;
 extern tablaFnRadio_t tablaFnRadioSBUS;
+#if defined(SITL)
+extern tablaFnRadio_t tablaFnRadioSITL;
+#endif
 
 
 /***************************************************************************************
@@ -99,7 +115,10 @@ extern tablaFnRadio_t tablaFnRadioSBUS;
 ****************************************************************************************/
 bool iniciarRadio(void);
 void leerRadio(uint32_t tiempoActual);
-void anadirRecepcionRadio(uint8_t numValores, uint16_t *valores);
+void anadirRecepcionRadio(uint8_t numValores, uint16_t *valores, uint32_t tiempoTrama);
+void medirLatenciaRadio(uint32_t tiempoActual);
+const latenciaRadio_t *latenciaRadio(void);
+void resetearLatenciaRadio(void);
 bool radioOperativa(void);
 bool radioEnFailsafe(void);
 void activarFailsafeRadio(void);
@@ -107,5 +126,8 @@ void desactivarFailsafeRadio(void);
 bool nuevaEntradaRadioValida(void);
 uint16_t canalRadio(uint8_t canal);
 void canalesRadio(uint16_t *canales);
+#if defined(SITL)
+void ajustarCanalRadioSITL(uint8_t canal, uint16_t valor);
+#endif
 
 #endif // __RADIO_H_
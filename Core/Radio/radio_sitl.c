@@ -0,0 +1,111 @@
+/***************************************************************************************
+**  radio_sitl.c - Funciones de la radio simulada en SITL. Los canales los fija el
+**                 programa de simulacion
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "radio.h"
+
+#if defined(USAR_RADIO) && defined(SITL)
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define NUM_CANALES_SITL                      8
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static uint16_t canalesSITL[NUM_CANALES_SITL];
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool iniciarRadioSITL(void);
+void leerRadioSITL(uint32_t tiempoActual);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool iniciarRadioSITL(void)
+**  Descripcion:    Centra todos los canales
+**  Parametros:     Ninguno
+**  Retorno:        True si ok
+****************************************************************************************/
+bool iniciarRadioSITL(void)
+{
+    for (uint8_t i = 0; i < NUM_CANALES_SITL; i++)
+        canalesSITL[i] = VALOR_MEDIO_RADIO;
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void leerRadioSITL(uint32_t tiempoActual)
+**  Descripcion:    Entrega una trama con los canales actuales
+**  Parametros:     Tiempo actual
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerRadioSITL(uint32_t tiempoActual)
+{
+    anadirRecepcionRadio(NUM_CANALES_SITL, canalesSITL, tiempoActual);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void ajustarCanalRadioSITL(uint8_t canal, uint16_t valor)
+**  Descripcion:    Fija el valor de un canal de la radio simulada
+**  Parametros:     Canal, valor en us
+**  Retorno:        Ninguno
+****************************************************************************************/
+void ajustarCanalRadioSITL(uint8_t canal, uint16_t valor)
+{
+    if (canal < NUM_CANALES_SITL)
+        canalesSITL[canal] = valor;
+}
+
+
+/***************************************************************************************
+**  Nombre:         tablaFnRadio_t tablaFnRadioSITL
+**  Descripcion:    Tabla de funciones de la radio simulada
+****************************************************************************************/
+tablaFnRadio_t tablaFnRadioSITL = {
+    iniciarRadioSITL,
+    leerRadioSITL,
+};
+
+#endif
@@ -0,0 +1,260 @@
+/***************************************************************************************
+**  trama_radio.c - Ensamblado y decodificacion de tramas SBUS e iBUS
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <string.h>
+
+#include "trama_radio.h"
+#include "Drivers/tiempo.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define BYTE_FLAGS_SBUS             23
+#define BIT_FAILSAFE_SBUS           3
+#define BIT_TRAMA_PERDIDA_SBUS      2
+#define MASCARA_CANAL_SBUS          0x7FF
+
+#define SEGUNDO_BYTE_IBUS           0x40
+#define MASCARA_CANAL_IBUS          0x0FFF
+#define MASCARA_FAILSAFE_IBUS       0xF0
+
+#define REINTENTOS_LECTURA_RADIO    2
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+/*
+ * Los 16 canales de 11 bits del SBUS van seguidos empezando por el bit menos significativo.
+ * Cada canal esta en 3 bytes consecutivos como mucho, asi que se juntan en una palabra y
+ * se extrae con un desplazamiento y una mascara
+ */
+typedef struct {
+    uint8_t byte;                         // Primer byte del canal en la trama
+    uint8_t desplazamiento;               // Bit del primer byte en el que empieza
+} canalSBUS_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static const canalSBUS_t canalesSBUS[NUM_CANALES_SBUS] = {
+    { 1, 0}, { 2, 3}, { 3, 6}, { 5, 1}, { 6, 4}, { 7, 7}, { 9, 2}, {10, 5},
+    {12, 0}, {13, 3}, {14, 6}, {16, 1}, {17, 4}, {18, 7}, {20, 2}, {21, 5},
+};
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         void iniciarEnsambladorRadio(ensambladorRadio_t *ensamblador, uint8_t tamTrama,
+**                                               uint8_t byteInicio, uint32_t duracionMax)
+**  Descripcion:    Inicia el ensamblador de tramas de un protocolo
+**  Parametros:     Ensamblador, tamanio de la trama, primer byte de la trama, tiempo maximo
+**                  en us entre el primer y el ultimo byte
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarEnsambladorRadio(ensambladorRadio_t *ensamblador, uint8_t tamTrama, uint8_t byteInicio, uint32_t duracionMax)
+{
+    memset(ensamblador, 0, sizeof(*ensamblador));
+    ensamblador->tamTrama = tamTrama < TAM_MAX_TRAMA_RADIO ? tamTrama : TAM_MAX_TRAMA_RADIO;
+    ensamblador->byteInicio = byteInicio;
+    ensamblador->duracionMax = duracionMax;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void procesarByteEnsambladorRadio(ensambladorRadio_t *ensamblador, uint8_t dato)
+**  Descripcion:    Anade un byte a la trama en curso y la publica al completarla. Se llama
+**                  desde la interrupcion de la UART
+**  Parametros:     Ensamblador, byte recibido
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void procesarByteEnsambladorRadio(ensambladorRadio_t *ensamblador, uint8_t dato)
+{
+    const uint32_t publicadas = ensamblador->publicadas;
+    uint8_t *trama = ensamblador->trama[publicadas & 1];
+    uint8_t offset = ensamblador->offset;
+
+    // Los bytes de en medio solo se copian
+    if (offset > 1 && offset < ensamblador->tamTrama - 2) {
+        trama[offset] = dato;
+        ensamblador->offset = offset + 1;
+        return;
+    }
+
+    // En los bytes que siguen a otro con tiempo se comprueba si ha habido separacion
+    if (offset != ensamblador->tamTrama - 2) {
+        const uint32_t tiempo = microsISR();
+        const bool separacion = tiempo - ensamblador->tiempoUltimo >= SEPARACION_MIN_TRAMA_RADIO;
+
+        ensamblador->tiempoUltimo = tiempo;
+
+        if (offset > 0 && separacion) {
+            ensamblador->descartadas++;
+            offset = 0;
+        }
+
+        if (offset == 0) {
+            ensamblador->offset = 0;
+            if (dato != ensamblador->byteInicio || !separacion)
+                return;
+
+            ensamblador->tiempoInicio = tiempo;
+        }
+    }
+    else
+        ensamblador->tiempoUltimo = microsISR();
+
+    trama[offset++] = dato;
+    if (offset < ensamblador->tamTrama) {
+        ensamblador->offset = offset;
+        return;
+    }
+
+    ensamblador->offset = 0;
+
+    // Si se ha perdido un byte por medio la trama se ha completado con la siguiente
+    if (ensamblador->tiempoUltimo - ensamblador->tiempoInicio > ensamblador->duracionMax) {
+        ensamblador->descartadas++;
+        return;
+    }
+
+    ensamblador->tiempo[publicadas & 1] = ensamblador->tiempoInicio;
+
+    // La trama tiene que estar en memoria antes de que la tarea vea el contador
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    ensamblador->publicadas = publicadas + 1;
+}
+
+
+/***************************************************************************************
+**  Nombre:         estadoTramaRadio_e leerTramaRadio(ensambladorRadio_t *ensamblador, decodificadorTramaRadio_f decodificar,
+**                                                    uint16_t *valores, uint32_t *tiempoTrama)
+**  Descripcion:    Decodifica la ultima trama publicada sobre su buffer. Si la interrupcion
+**                  ha empezado a reescribirlo mientras tanto se vuelve a intentar
+**  Parametros:     Ensamblador, decodificador del protocolo, valores de los canales,
+**                  llegada del inicio de la trama en us
+**  Retorno:        Estado de la trama o TRAMA_RADIO_NINGUNA si no hay una nueva
+****************************************************************************************/
+CODIGO_RAPIDO estadoTramaRadio_e leerTramaRadio(ensambladorRadio_t *ensamblador, decodificadorTramaRadio_f decodificar,
+                                                uint16_t *valores, uint32_t *tiempoTrama)
+{
+    for (uint8_t i = 0; i < REINTENTOS_LECTURA_RADIO; i++) {
+        const uint32_t publicadas = ensamblador->publicadas;
+
+        if (publicadas == ensamblador->leidas)
+            return TRAMA_RADIO_NINGUNA;
+
+        // El contador se lee antes que la trama
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        const uint8_t buffer = (publicadas - 1) & 1;
+        const estadoTramaRadio_e estado = decodificar(ensamblador->trama[buffer], valores);
+        *tiempoTrama = ensamblador->tiempo[buffer];
+
+        // La siguiente trama va al otro buffer. Solo se reescribe este despues de publicarla
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (ensamblador->publicadas == publicadas) {
+            ensamblador->noLeidas += publicadas - ensamblador->leidas - 1;
+            ensamblador->leidas = publicadas;
+            return estado;
+        }
+    }
+
+    return TRAMA_RADIO_NINGUNA;
+}
+
+
+/***************************************************************************************
+**  Nombre:         estadoTramaRadio_e decodificarTramaSBUS(const uint8_t *trama, uint16_t *valores)
+**  Descripcion:    Obtiene los valores de los canales de una trama SBUS
+**  Parametros:     Trama, valores de los 16 canales en us
+**  Retorno:        Estado de la trama
+****************************************************************************************/
+CODIGO_RAPIDO estadoTramaRadio_e decodificarTramaSBUS(const uint8_t *trama, uint16_t *valores)
+{
+    if (trama[0] != INICIO_TRAMA_SBUS)
+        return TRAMA_RADIO_INVALIDA;
+
+    for (uint8_t canal = 0; canal < NUM_CANALES_SBUS; canal++) {
+        const uint8_t *dato = &trama[canalesSBUS[canal].byte];
+        const uint32_t bits = dato[0] | (uint32_t)dato[1] << 8 | (uint32_t)dato[2] << 16;
+        const uint32_t valor = (bits >> canalesSBUS[canal].desplazamiento) & MASCARA_CANAL_SBUS;
+
+        // Convierte de 0-2048 a 1000-2000
+        valores[canal] = ((valor * 1000) >> 11) + 1000;
+    }
+
+    if (trama[BYTE_FLAGS_SBUS] & (1 << BIT_FAILSAFE_SBUS))
+        return TRAMA_RADIO_FAILSAFE;
+
+    if (trama[BYTE_FLAGS_SBUS] & (1 << BIT_TRAMA_PERDIDA_SBUS))
+        return TRAMA_RADIO_PERDIDA;
+
+    return TRAMA_RADIO_OK;
+}
+
+
+/***************************************************************************************
+**  Nombre:         estadoTramaRadio_e decodificarTramaIBUS(const uint8_t *trama, uint16_t *valores)
+**  Descripcion:    Obtiene los valores de los canales de una trama iBUS
+**  Parametros:     Trama, valores de los 14 canales en us
+**  Retorno:        Estado de la trama
+****************************************************************************************/
+CODIGO_RAPIDO estadoTramaRadio_e decodificarTramaIBUS(const uint8_t *trama, uint16_t *valores)
+{
+    // El checksum es 0xFFFF menos la suma de los bytes anteriores
+    uint32_t suma = INICIO_TRAMA_IBUS + SEGUNDO_BYTE_IBUS;
+
+    if (trama[0] != INICIO_TRAMA_IBUS || trama[1] != SEGUNDO_BYTE_IBUS)
+        return TRAMA_RADIO_INVALIDA;
+
+    for (uint8_t canal = 0; canal < NUM_CANALES_IBUS; canal++) {
+        const uint8_t *dato = &trama[2 + 2 * canal];
+
+        valores[canal] = (dato[0] | dato[1] << 8) & MASCARA_CANAL_IBUS;
+        suma += dato[0] + dato[1];
+    }
+
+    suma += trama[TAM_TRAMA_IBUS - 2] | trama[TAM_TRAMA_IBUS - 1] << 8;
+    if (suma != 0xFFFF)
+        return TRAMA_RADIO_INVALIDA;
+
+    if ((trama[3] & MASCARA_FAILSAFE_IBUS) || (trama[9] & MASCARA_FAILSAFE_IBUS))
+        return TRAMA_RADIO_FAILSAFE;
+
+    return TRAMA_RADIO_OK;
+}
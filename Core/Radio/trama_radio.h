@@ -0,0 +1,110 @@
+/***************************************************************************************
+**  trama_radio.h - Ensamblado y decodificacion de tramas SBUS e iBUS
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __TRAMA_RADIO_H
+#define __TRAMA_RADIO_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * La interrupcion de la UART solo copia bytes y lee el tiempo en los dos primeros y los dos
+ * ultimos de cada trama y mientras busca el inicio. Una trama solo empieza despues de una
+ * separacion, y si la separacion aparece tras el byte de inicio o antes del ultimo byte se
+ * vuelve a empezar desde el byte que la sigue. Si la trama completa ha tardado mas de lo que
+ * dura es que se ha perdido un byte por medio y se descarta. El tiempo de la trama es el de
+ * su byte de inicio. Las tramas se alternan entre dos buffers: la interrupcion escribe en
+ * uno mientras la tarea decodifica el ultimo publicado, y la tarea comprueba despues con el
+ * contador de publicadas que no se ha reescrito mientras lo leia, asi que no hacen falta
+ * secciones criticas
+ */
+#define TAM_MAX_TRAMA_RADIO         32
+#define SEPARACION_MIN_TRAMA_RADIO  2000         // us sin bytes entre dos tramas
+
+#define TAM_TRAMA_SBUS              25
+#define NUM_CANALES_SBUS            16
+#define INICIO_TRAMA_SBUS           0x0F
+#define DURACION_MAX_TRAMA_SBUS     4000         // us. 25 bytes de 12 bits a 100000 baudios son 3000 us
+
+#define TAM_TRAMA_IBUS              32
+#define NUM_CANALES_IBUS            14
+#define INICIO_TRAMA_IBUS           0x20
+#define DURACION_MAX_TRAMA_IBUS     4000         // us. 32 bytes de 10 bits a 115200 baudios son 2780 us
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef enum {
+    TRAMA_RADIO_NINGUNA = 0,              // No hay trama nueva
+    TRAMA_RADIO_OK,
+    TRAMA_RADIO_PERDIDA,                  // El receptor no ha recibido la trama del emisor
+    TRAMA_RADIO_FAILSAFE,
+    TRAMA_RADIO_INVALIDA,                 // Cabecera o checksum incorrectos
+} estadoTramaRadio_e;
+
+typedef estadoTramaRadio_e (*decodificadorTramaRadio_f)(const uint8_t *trama, uint16_t *valores);
+
+typedef struct {
+    uint8_t trama[2][TAM_MAX_TRAMA_RADIO] __attribute__((aligned(4)));
+    uint32_t tiempo[2];                   // Llegada del byte de inicio de cada trama en us
+    volatile uint32_t publicadas;         // La trama n esta en trama[(n - 1) & 1]
+    uint32_t leidas;                      // Valor de publicadas en la ultima lectura de la tarea
+    uint32_t tiempoInicio;
+    uint32_t tiempoUltimo;                // Ultimo byte en el que se ha leido el tiempo
+    uint32_t duracionMax;
+    uint32_t descartadas;                 // Tramas cortadas por una separacion o demasiado largas
+    uint32_t noLeidas;                    // Tramas publicadas que la tarea no ha llegado a leer
+    uint8_t offset;
+    uint8_t tamTrama;
+    uint8_t byteInicio;
+} ensambladorRadio_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void iniciarEnsambladorRadio(ensambladorRadio_t *ensamblador, uint8_t tamTrama, uint8_t byteInicio, uint32_t duracionMax);
+void procesarByteEnsambladorRadio(ensambladorRadio_t *ensamblador, uint8_t dato);
+estadoTramaRadio_e leerTramaRadio(ensambladorRadio_t *ensamblador, decodificadorTramaRadio_f decodificar,
+                                  uint16_t *valores, uint32_t *tiempoTrama);
+
+estadoTramaRadio_e decodificarTramaSBUS(const uint8_t *trama, uint16_t *valores);
+estadoTramaRadio_e decodificarTramaIBUS(const uint8_t *trama, uint16_t *valores);
+
+#endif // __TRAMA_RADIO_H
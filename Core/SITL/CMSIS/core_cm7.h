@@ -0,0 +1,79 @@
+/***************************************************************************************
+**  core_cm7.h - Sustituto de la cabecera CMSIS del nucleo Cortex-M7 para la compilacion
+**               SITL en el PC
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __CORE_CM7_H_GENERIC
+#define __CORE_CM7_H_GENERIC
+#define __CORE_CM7_H_DEPENDANT
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+
+#include "cmsis_version.h"
+#include "cmsis_compiler.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * El fichero de dispositivo (stm32f767xx.h) incluye "core_cm7.h" para los calificadores de
+ * los registros. El original de Drivers/CMSIS trae funciones inline del NVIC y de la cache
+ * que convierten direcciones de 32 bits en punteros, y en el PC cada una avisa en cada
+ * fichero. En SITL no hay nucleo: este directorio va delante de Drivers/CMSIS/Include en
+ * los includes y solo deja lo que necesitan las cabeceras de la HAL para compilar. Usar
+ * SCB, NVIC, SysTick o DWT en codigo que se compila en SITL es un error de compilacion
+ */
+#define __CM7_CMSIS_VERSION_MAIN  (__CM_CMSIS_VERSION_MAIN)
+#define __CM7_CMSIS_VERSION_SUB   (__CM_CMSIS_VERSION_SUB)
+#define __CM7_CMSIS_VERSION       ((__CM7_CMSIS_VERSION_MAIN << 16U) | __CM7_CMSIS_VERSION_SUB)
+#define __CORTEX_M                (7U)
+#define __FPU_USED                0U
+
+// Calificadores de acceso a los registros
+#define __I                       volatile const
+#define __O                       volatile
+#define __IO                      volatile
+#define __IM                      volatile const
+#define __OM                      volatile
+#define __IOM                     volatile
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+
+#endif // __CORE_CM7_H_GENERIC
@@ -0,0 +1,698 @@
+/***************************************************************************************
+**  analizador_ubx_sitl.c - Prueba, fuzz y medida del analizador UBX
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "analizador_ubx_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sitl.h"
+#include "Sensores/GPS/analizador_ubx.h"
+#include "Comun/buffer_anillo.h"
+#include "Comun/matematicas.h"
+#include "Comun/util.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define TAM_ANILLO_UBX_SITL             512          // Mismo tamanio que el de recepcion de la UART
+#define MAX_LLEGADA_UBX_SITL            160          // Bytes maximos que llegan entre dos lecturas
+#define BLOQUE_MEDIDA_UBX_SITL          64           // Bytes que llegan entre dos lecturas al medir
+#define BYTES_MEDIDA_UBX_SITL           (16u << 20)  // Bytes procesados como minimo al medir
+#define ITERACIONES_FUZZ_UBX_SITL       200
+#define BYTES_POR_MUTACION_UBX_SITL     200          // Una mutacion cada tantos bytes
+#define SEMILLA_UBX_SITL                0x5EED0B5u
+
+#define CLASE_NAV_UBX_SITL              0x01
+#define CLASE_ACK_UBX_SITL              0x05
+#define CLASE_MON_UBX_SITL              0x0A
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    uint8_t clase;
+    uint8_t id;
+    uint16_t longitud;
+    uint32_t hash;
+} registroTramaUBXSITL_t;
+
+typedef struct {
+    registroTramaUBXSITL_t *tramas;
+    uint32_t numTramas;
+    uint32_t capacidad;
+    uint32_t invalidas;                   // Tramas despachadas con cabecera o checksum mal
+} registroUBXSITL_t;
+
+// Maquina de estados byte a byte que habia antes en el driver
+typedef struct {
+    uint8_t estado;
+    uint8_t clase;
+    uint8_t id;
+    uint8_t ckA;
+    uint8_t ckB;
+    uint16_t longitud;
+    uint16_t contador;
+    uint8_t payload[TAM_MAX_PAYLOAD_UBX];
+} analizadorAnteriorUBXSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static uint32_t semillaUBXSITL;
+
+static const char nmeaUBXSITL[] = "$GNGGA,123519.00,4807.03812,N,01131.00024,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n";
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+uint32_t aleatorioUBXSITL(void);
+uint32_t hashUBXSITL(const uint8_t *dato, uint16_t longitud);
+
+uint8_t *leerFicheroUBXSITL(const char *fichero, uint32_t *longitud);
+uint8_t *generarFlujoUBXSITL(uint32_t epocas, uint32_t *longitud);
+uint32_t anadirTramaUBXSITL(uint8_t *flujo, uint8_t clase, uint8_t id, uint16_t longitud);
+uint8_t *mutarFlujoUBXSITL(const uint8_t *flujo, uint32_t longitud, uint32_t *longitudMutado);
+
+void anotarTramaUBXSITL(registroUBXSITL_t *registro, uint8_t clase, uint8_t id, uint16_t longitud, const uint8_t *payload);
+bool registrarTramaUBXSITL(void *contexto, const tramaUBX_t *trama);
+bool contarTramaUBXSITL(void *contexto, const tramaUBX_t *trama);
+
+bool procesarByteAnteriorUBXSITL(analizadorAnteriorUBXSITL_t *anterior, uint8_t dato);
+void analizarAnteriorUBXSITL(const uint8_t *flujo, uint32_t longitud, registroUBXSITL_t *registro);
+void analizarAnilloUBXSITL(const uint8_t *flujo, uint32_t longitud, registroUBXSITL_t *registro, estadisticasUBX_t *estadisticas);
+bool compararRegistrosUBXSITL(const registroUBXSITL_t *nuevo, const registroUBXSITL_t *anterior);
+uint32_t tramasPerdidasUBXSITL(const registroUBXSITL_t *nuevo, const registroUBXSITL_t *anterior);
+
+double medirAnteriorUBXSITL(const uint8_t *flujo, uint32_t longitud);
+double medirNuevoUBXSITL(const uint8_t *flujo, uint32_t longitud);
+
+static const entradaTablaUBX_t tablaUBXSITL[] = {
+    {CLASE_NAV_UBX_SITL, CUALQUIER_ID_UBX, 0, registrarTramaUBXSITL},
+    {CLASE_ACK_UBX_SITL, CUALQUIER_ID_UBX, 0, registrarTramaUBXSITL},
+};
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool probarAnalizadorUBXSITL(const char *datos)
+**  Descripcion:    Compara el analizador sobre el anillo con la maquina de estados
+**                  anterior, lo somete a flujos corruptos y mide los dos
+**  Parametros:     Fichero con un log UBX o numero de epocas a generar
+**  Retorno:        True si las tramas coinciden y ninguna trama corrupta se despacha
+****************************************************************************************/
+bool probarAnalizadorUBXSITL(const char *datos)
+{
+    char *fin;
+    const uint32_t epocas = strtoul(datos, &fin, 0);
+    uint32_t longitud;
+    uint8_t *flujo;
+
+    semillaUBXSITL = SEMILLA_UBX_SITL;
+
+    if (*fin != '\0')
+        flujo = leerFicheroUBXSITL(datos, &longitud);
+    else
+        flujo = generarFlujoUBXSITL(epocas, &longitud);
+
+    if (flujo == NULL || longitud == 0) {
+        free(flujo);
+        return false;
+    }
+
+    // Flujo limpio: mismas tramas y en el mismo orden que antes
+    registroUBXSITL_t nuevo = {0}, anterior = {0};
+    estadisticasUBX_t estadisticas;
+
+    analizarAnteriorUBXSITL(flujo, longitud, &anterior);
+    analizarAnilloUBXSITL(flujo, longitud, &nuevo, &estadisticas);
+
+    const bool coinciden = compararRegistrosUBXSITL(&nuevo, &anterior) && nuevo.invalidas == 0;
+
+    printf("analizador_ubx bytes=%u tramas=%u tramas_anterior=%u partidas=%u descartados=%u coinciden=%d\n",
+           longitud, nuevo.numTramas, anterior.numTramas, estadisticas.tramasPartidas, estadisticas.bytesDescartados,
+           coinciden);
+
+    // Flujos corruptos: no se despacha nada invalido ni se pierde lo que veia el anterior
+    uint32_t invalidas = 0, perdidas = 0, tramasFuzz = 0, tramasFuzzAnterior = 0, errorChecksum = 0;
+
+    for (uint32_t i = 0; i < ITERACIONES_FUZZ_UBX_SITL; i++) {
+        uint32_t longitudMutado;
+        uint8_t *mutado = mutarFlujoUBXSITL(flujo, longitud, &longitudMutado);
+
+        nuevo.numTramas = nuevo.invalidas = 0;
+        anterior.numTramas = 0;
+
+        analizarAnteriorUBXSITL(mutado, longitudMutado, &anterior);
+        analizarAnilloUBXSITL(mutado, longitudMutado, &nuevo, &estadisticas);
+
+        invalidas += nuevo.invalidas;
+        perdidas += tramasPerdidasUBXSITL(&nuevo, &anterior);
+        tramasFuzz += nuevo.numTramas;
+        tramasFuzzAnterior += anterior.numTramas;
+        errorChecksum += estadisticas.errorChecksum;
+        free(mutado);
+    }
+
+    printf("analizador_ubx fuzz iteraciones=%u tramas=%u tramas_anterior=%u error_checksum=%u invalidas=%u perdidas=%u\n",
+           ITERACIONES_FUZZ_UBX_SITL, tramasFuzz, tramasFuzzAnterior, errorChecksum, invalidas, perdidas);
+
+    // Tiempo por byte con llegadas de un tamanio fijo
+    const double nsAnterior = medirAnteriorUBXSITL(flujo, longitud);
+    const double nsNuevo = medirNuevoUBXSITL(flujo, longitud);
+
+    printf("analizador_ubx ns_byte=%.2f ns_byte_anterior=%.2f mejora=%.2f\n", nsNuevo, nsAnterior, nsAnterior / nsNuevo);
+
+    free(nuevo.tramas);
+    free(anterior.tramas);
+    free(flujo);
+    return coinciden && invalidas == 0 && perdidas == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t aleatorioUBXSITL(void)
+**  Descripcion:    Generador congruencial para que la prueba sea repetible
+**  Parametros:     Ninguno
+**  Retorno:        Numero pseudoaleatorio de 31 bits
+****************************************************************************************/
+uint32_t aleatorioUBXSITL(void)
+{
+    semillaUBXSITL = semillaUBXSITL * 1103515245u + 12345u;
+    return semillaUBXSITL >> 1;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t hashUBXSITL(const uint8_t *dato, uint16_t longitud)
+**  Descripcion:    Hash FNV-1a del payload para comparar tramas sin guardarlas
+**  Parametros:     Datos, longitud
+**  Retorno:        Hash
+****************************************************************************************/
+uint32_t hashUBXSITL(const uint8_t *dato, uint16_t longitud)
+{
+    uint32_t hash = 2166136261u;
+
+    while (longitud--)
+        hash = (hash ^ *dato++) * 16777619u;
+
+    return hash;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t *leerFicheroUBXSITL(const char *fichero, uint32_t *longitud)
+**  Descripcion:    Lee un log capturado del receptor tal cual llega por la UART
+**  Parametros:     Fichero, longitud leida
+**  Retorno:        Bytes del fichero o NULL si no se puede leer
+****************************************************************************************/
+uint8_t *leerFicheroUBXSITL(const char *fichero, uint32_t *longitud)
+{
+    FILE *entrada = fopen(fichero, "rb");
+    uint8_t *flujo;
+    long tam;
+
+    if (entrada == NULL) {
+        fprintf(stderr, "No se puede abrir %s\n", fichero);
+        return NULL;
+    }
+
+    fseek(entrada, 0, SEEK_END);
+    tam = ftell(entrada);
+    fseek(entrada, 0, SEEK_SET);
+
+    flujo = malloc(tam > 0 ? tam : 1);
+    *longitud = fread(flujo, 1, tam > 0 ? tam : 0, entrada);
+    fclose(entrada);
+
+    if (*longitud == 0)
+        fprintf(stderr, "El fichero %s esta vacio\n", fichero);
+
+    return flujo;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t *generarFlujoUBXSITL(uint32_t epocas, uint32_t *longitud)
+**  Descripcion:    Genera las tramas que manda el receptor en cada epoca con payload
+**                  aleatorio, que tambien contiene sincronizaciones falsas, y mete NMEA,
+**                  ACK, sondeos sin payload y tramas de longitud maxima entre medias
+**  Parametros:     Epocas, longitud generada
+**  Retorno:        Flujo generado
+****************************************************************************************/
+uint8_t *generarFlujoUBXSITL(uint32_t epocas, uint32_t *longitud)
+{
+    const uint32_t maxEpoca = 92 + 52 + 36 + 18 + 60 + 10 + 8 + TAM_MAX_PAYLOAD_UBX + 6 * (TAM_CABECERA_UBX + TAM_CHECKSUM_UBX) +
+                              sizeof(nmeaUBXSITL);
+    uint8_t *flujo = malloc(epocas * maxEpoca + 1);
+    uint32_t pos = 0;
+
+    for (uint32_t i = 0; i < epocas; i++) {
+        pos += anadirTramaUBXSITL(&flujo[pos], CLASE_NAV_UBX_SITL, 0x07, 92);      // PVT
+        pos += anadirTramaUBXSITL(&flujo[pos], CLASE_NAV_UBX_SITL, 0x06, 52);      // SOL
+        pos += anadirTramaUBXSITL(&flujo[pos], CLASE_NAV_UBX_SITL, 0x12, 36);      // VELNED
+        pos += anadirTramaUBXSITL(&flujo[pos], CLASE_NAV_UBX_SITL, 0x04, 18);      // DOP
+
+        if (i % 5 == 0)
+            pos += anadirTramaUBXSITL(&flujo[pos], CLASE_MON_UBX_SITL, 0x09, 60);  // HW
+
+        if (i % 3 == 0) {
+            memcpy(&flujo[pos], nmeaUBXSITL, sizeof(nmeaUBXSITL) - 1);
+            pos += sizeof(nmeaUBXSITL) - 1;
+        }
+
+        if (i % 7 == 0) {
+            pos += anadirTramaUBXSITL(&flujo[pos], CLASE_ACK_UBX_SITL, 0x01, 2);
+            pos += anadirTramaUBXSITL(&flujo[pos], 0x06, 0x04, 0);                 // Sondeo sin payload
+        }
+
+        if (i % 11 == 0)
+            pos += anadirTramaUBXSITL(&flujo[pos], CLASE_NAV_UBX_SITL, 0x35, TAM_MAX_PAYLOAD_UBX);
+    }
+
+    *longitud = pos;
+    return flujo;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t anadirTramaUBXSITL(uint8_t *flujo, uint8_t clase, uint8_t id, uint16_t longitud)
+**  Descripcion:    Escribe una trama con payload aleatorio y checksum
+**  Parametros:     Destino, clase, id, longitud del payload
+**  Retorno:        Bytes escritos
+****************************************************************************************/
+uint32_t anadirTramaUBXSITL(uint8_t *flujo, uint8_t clase, uint8_t id, uint16_t longitud)
+{
+    uint8_t ckA = 0, ckB = 0;
+
+    flujo[0] = SINCRONIZACION1_UBX;
+    flujo[1] = SINCRONIZACION2_UBX;
+    flujo[2] = clase;
+    flujo[3] = id;
+    flujo[4] = longitud & 0xFF;
+    flujo[5] = longitud >> 8;
+
+    for (uint16_t i = 0; i < longitud; i++)
+        flujo[TAM_CABECERA_UBX + i] = aleatorioUBXSITL() >> 7;
+
+    checksumUBX(&flujo[2], TAM_CABECERA_UBX - 2 + longitud, &ckA, &ckB);
+    flujo[TAM_CABECERA_UBX + longitud] = ckA;
+    flujo[TAM_CABECERA_UBX + longitud + 1] = ckB;
+
+    return TAM_CABECERA_UBX + longitud + TAM_CHECKSUM_UBX;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t *mutarFlujoUBXSITL(const uint8_t *flujo, uint32_t longitud, uint32_t *longitudMutado)
+**  Descripcion:    Copia el flujo cambiando, insertando y borrando bytes al azar y
+**                  cortando el final
+**  Parametros:     Flujo, longitud, longitud del flujo mutado
+**  Retorno:        Flujo mutado
+****************************************************************************************/
+uint8_t *mutarFlujoUBXSITL(const uint8_t *flujo, uint32_t longitud, uint32_t *longitudMutado)
+{
+    uint8_t *mutado = malloc(2 * longitud + 1);
+    uint32_t pos = 0;
+
+    for (uint32_t i = 0; i < longitud; i++) {
+        if (aleatorioUBXSITL() % BYTES_POR_MUTACION_UBX_SITL != 0) {
+            mutado[pos++] = flujo[i];
+            continue;
+        }
+
+        switch (aleatorioUBXSITL() % 4) {
+            case 0:                                                   // Bit cambiado
+                mutado[pos++] = flujo[i] ^ (1 << (aleatorioUBXSITL() % 8));
+                break;
+
+            case 1:                                                   // Byte insertado
+                mutado[pos++] = aleatorioUBXSITL() % 2 ? SINCRONIZACION1_UBX : aleatorioUBXSITL() >> 7;
+                mutado[pos++] = flujo[i];
+                break;
+
+            case 2:                                                   // Byte perdido
+                break;
+
+            default:                                                  // Byte cambiado
+                mutado[pos++] = aleatorioUBXSITL() >> 7;
+                break;
+        }
+    }
+
+    // El log puede acabar a mitad de una trama
+    *longitudMutado = pos - (pos > 0 ? aleatorioUBXSITL() % MIN(pos, (uint32_t)TAM_MAX_TRAMA_UBX) : 0);
+    return mutado;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void anotarTramaUBXSITL(registroUBXSITL_t *registro, uint8_t clase, uint8_t id,
+**                                          uint16_t longitud, const uint8_t *payload)
+**  Descripcion:    Anota una trama en el registro
+**  Parametros:     Registro, clase, id, longitud, payload
+**  Retorno:        Ninguno
+****************************************************************************************/
+void anotarTramaUBXSITL(registroUBXSITL_t *registro, uint8_t clase, uint8_t id, uint16_t longitud, const uint8_t *payload)
+{
+    if (registro->numTramas == registro->capacidad) {
+        registro->capacidad = registro->capacidad == 0 ? 1024 : 2 * registro->capacidad;
+        registro->tramas = realloc(registro->tramas, registro->capacidad * sizeof(registroTramaUBXSITL_t));
+    }
+
+    registroTramaUBXSITL_t *trama = &registro->tramas[registro->numTramas++];
+
+    trama->clase = clase;
+    trama->id = id;
+    trama->longitud = longitud;
+    trama->hash = hashUBXSITL(payload, longitud);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool registrarTramaUBXSITL(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Manejador que vuelve a comprobar la trama sobre la vista y la anota
+**  Parametros:     Registro, trama
+**  Retorno:        True
+****************************************************************************************/
+bool registrarTramaUBXSITL(void *contexto, const tramaUBX_t *trama)
+{
+    registroUBXSITL_t *registro = contexto;
+    const uint8_t *cabecera = trama->payload - TAM_CABECERA_UBX;
+    const uint8_t *checksum = trama->payload + trama->longitud;
+    uint8_t ckA = 0, ckB = 0;
+
+    // La vista apunta a la trama completa, en el anillo o en el buffer de tramas partidas
+    checksumUBX(&cabecera[2], TAM_CABECERA_UBX - 2 + trama->longitud, &ckA, &ckB);
+
+    if (cabecera[0] != SINCRONIZACION1_UBX || cabecera[1] != SINCRONIZACION2_UBX || cabecera[2] != trama->clase ||
+        cabecera[3] != trama->id || (cabecera[4] | (cabecera[5] << 8)) != trama->longitud ||
+        trama->longitud > TAM_MAX_PAYLOAD_UBX || ckA != checksum[0] || ckB != checksum[1])
+        registro->invalidas++;
+
+    anotarTramaUBXSITL(registro, trama->clase, trama->id, trama->longitud, trama->payload);
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool contarTramaUBXSITL(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Manejador para medir, solo cuenta las tramas
+**  Parametros:     Contador, trama
+**  Retorno:        True
+****************************************************************************************/
+bool contarTramaUBXSITL(void *contexto, const tramaUBX_t *trama)
+{
+    UNUSED(trama);
+
+    (*(uint32_t *)contexto)++;
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool procesarByteAnteriorUBXSITL(analizadorAnteriorUBXSITL_t *anterior, uint8_t dato)
+**  Descripcion:    Maquina de estados que usaba el driver antes, sin cambios
+**  Parametros:     Estado, byte recibido
+**  Retorno:        True si se ha completado una trama con checksum correcto
+****************************************************************************************/
+bool procesarByteAnteriorUBXSITL(analizadorAnteriorUBXSITL_t *anterior, uint8_t dato)
+{
+  reset:
+    switch (anterior->estado) {
+        case 1:
+            if (SINCRONIZACION2_UBX == dato) {
+                anterior->estado++;
+                break;
+            }
+            else
+                anterior->estado = 0;
+            FALLTHROUGH;
+
+        case 0:
+            if (SINCRONIZACION1_UBX == dato)
+                anterior->estado++;
+            break;
+
+        case 2:
+            anterior->estado++;
+            anterior->clase = dato;
+            anterior->ckB = anterior->ckA = dato;
+            break;
+
+        case 3:
+            anterior->estado++;
+            anterior->ckB += (anterior->ckA += dato);
+            anterior->id = dato;
+            break;
+
+        case 4:
+            anterior->estado++;
+            anterior->ckB += (anterior->ckA += dato);
+            anterior->longitud = dato;
+            break;
+
+        case 5:
+            anterior->estado++;
+            anterior->ckB += (anterior->ckA += dato);
+            anterior->longitud += (uint16_t)(dato << 8);
+            if (anterior->longitud > TAM_MAX_PAYLOAD_UBX) {
+                anterior->longitud = 0;
+                anterior->estado = 0;
+                goto reset;
+            }
+            if (anterior->longitud == 0)
+                anterior->estado = 7;
+            anterior->contador = 0;
+            break;
+
+        case 6:
+            anterior->ckB += (anterior->ckA += dato);
+            if (anterior->contador < TAM_MAX_PAYLOAD_UBX)
+                anterior->payload[anterior->contador] = dato;
+
+            anterior->contador++;
+            if (anterior->contador == anterior->longitud)
+                anterior->estado++;
+            break;
+
+        case 7:
+            anterior->estado++;
+            if (anterior->ckA != dato) {
+                anterior->estado = 0;
+                goto reset;
+            }
+            break;
+
+        case 8:
+            anterior->estado = 0;
+            return anterior->ckB == dato;
+    }
+
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void analizarAnteriorUBXSITL(const uint8_t *flujo, uint32_t longitud, registroUBXSITL_t *registro)
+**  Descripcion:    Pasa el flujo byte a byte por la maquina de estados anterior
+**  Parametros:     Flujo, longitud, registro de tramas
+**  Retorno:        Ninguno
+****************************************************************************************/
+void analizarAnteriorUBXSITL(const uint8_t *flujo, uint32_t longitud, registroUBXSITL_t *registro)
+{
+    static analizadorAnteriorUBXSITL_t anterior;
+
+    memset(&anterior, 0, sizeof(anterior));
+
+    for (uint32_t i = 0; i < longitud; i++) {
+        if (procesarByteAnteriorUBXSITL(&anterior, flujo[i]))
+            anotarTramaUBXSITL(registro, anterior.clase, anterior.id, anterior.longitud, anterior.payload);
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void analizarAnilloUBXSITL(const uint8_t *flujo, uint32_t longitud,
+**                                             registroUBXSITL_t *registro, estadisticasUBX_t *estadisticas)
+**  Descripcion:    Mete el flujo en un anillo como el de la UART en llegadas de tamanio
+**                  aleatorio y lo lee igual que leerGPSublox
+**  Parametros:     Flujo, longitud, registro de tramas, estadisticas del analizador
+**  Retorno:        Ninguno
+****************************************************************************************/
+void analizarAnilloUBXSITL(const uint8_t *flujo, uint32_t longitud, registroUBXSITL_t *registro, estadisticasUBX_t *estadisticas)
+{
+    static analizadorUBX_t analizador;
+    static uint8_t buffer[TAM_ANILLO_UBX_SITL];
+    bufferAnillo_t anillo;
+    uint32_t escritos = 0;
+    bool nuevosDatos = false;
+
+    iniciarAnalizadorUBX(&analizador, tablaUBXSITL, LONG_ARRAY(tablaUBXSITL), registrarTramaUBXSITL, registro);
+    iniciarBufferAnillo(&anillo, buffer, sizeof(buffer));
+
+    while (escritos < longitud) {
+        const uint32_t llegada = 1 + aleatorioUBXSITL() % MAX_LLEGADA_UBX_SITL;
+        const uint8_t *bloque;
+        uint16_t numc;
+
+        escritos += escribirBufferAnillo(&anillo, &flujo[escritos], MIN(llegada, longitud - escritos));
+
+        while ((numc = bloqueBufferAnillo(&anillo, &bloque)) > 0) {
+            const uint16_t usados = analizarBloqueUBX(&analizador, bloque, numc, &nuevosDatos);
+
+            consumirBufferAnillo(&anillo, usados);
+            if (usados == numc)
+                continue;
+
+            if (bytesOcupadosBufferAnillo(&anillo) <= (uint32_t)(numc - usados))
+                break;
+
+            guardarParcialUBX(&analizador, &bloque[usados], numc - usados);
+            consumirBufferAnillo(&anillo, numc - usados);
+        }
+    }
+
+    *estadisticas = analizador.estadisticas;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool compararRegistrosUBXSITL(const registroUBXSITL_t *nuevo, const registroUBXSITL_t *anterior)
+**  Descripcion:    Comprueba que los dos registros tienen las mismas tramas en el mismo
+**                  orden
+**  Parametros:     Registros
+**  Retorno:        True si coinciden
+****************************************************************************************/
+bool compararRegistrosUBXSITL(const registroUBXSITL_t *nuevo, const registroUBXSITL_t *anterior)
+{
+    if (nuevo->numTramas != anterior->numTramas)
+        return false;
+
+    return anterior->numTramas == 0 ||
+           memcmp(nuevo->tramas, anterior->tramas, anterior->numTramas * sizeof(registroTramaUBXSITL_t)) == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t tramasPerdidasUBXSITL(const registroUBXSITL_t *nuevo, const registroUBXSITL_t *anterior)
+**  Descripcion:    Cuenta las tramas del anterior que no aparecen en orden en el nuevo. El
+**                  nuevo puede tener mas porque despues de un error sigue buscando desde la
+**                  sincronizacion y no desde el final de la trama mala
+**  Parametros:     Registros
+**  Retorno:        Tramas perdidas
+****************************************************************************************/
+uint32_t tramasPerdidasUBXSITL(const registroUBXSITL_t *nuevo, const registroUBXSITL_t *anterior)
+{
+    uint32_t perdidas = 0, j = 0;
+
+    for (uint32_t i = 0; i < anterior->numTramas; i++) {
+        uint32_t k = j;
+
+        while (k < nuevo->numTramas &&
+               memcmp(&nuevo->tramas[k], &anterior->tramas[i], sizeof(registroTramaUBXSITL_t)) != 0)
+            k++;
+
+        if (k == nuevo->numTramas)
+            perdidas++;
+        else
+            j = k + 1;
+    }
+
+    return perdidas;
+}
+
+
+/***************************************************************************************
+**  Nombre:         double medirAnteriorUBXSITL(const uint8_t *flujo, uint32_t longitud)
+**  Descripcion:    Mide la maquina de estados anterior
+**  Parametros:     Flujo, longitud
+**  Retorno:        ns por byte
+****************************************************************************************/
+double medirAnteriorUBXSITL(const uint8_t *flujo, uint32_t longitud)
+{
+    static analizadorAnteriorUBXSITL_t anterior;
+    const uint32_t repeticiones = 1 + BYTES_MEDIDA_UBX_SITL / longitud;
+    volatile uint32_t tramas = 0;
+    const double inicio = tiempoRealNsSITL();
+
+    for (uint32_t r = 0; r < repeticiones; r++) {
+        memset(&anterior, 0, sizeof(anterior));
+
+        for (uint32_t pos = 0; pos < longitud; pos += BLOQUE_MEDIDA_UBX_SITL) {
+            const uint32_t fin = MIN(pos + BLOQUE_MEDIDA_UBX_SITL, longitud);
+
+            for (uint32_t i = pos; i < fin; i++) {
+                if (procesarByteAnteriorUBXSITL(&anterior, flujo[i]))
+                    tramas++;
+            }
+        }
+    }
+
+    return (tiempoRealNsSITL() - inicio) / ((double)repeticiones * longitud);
+}
+
+
+/***************************************************************************************
+**  Nombre:         double medirNuevoUBXSITL(const uint8_t *flujo, uint32_t longitud)
+**  Descripcion:    Mide el analizador nuevo. Los bytes que deja sin consumir se le vuelven
+**                  a pasar con la siguiente llegada, como hace el anillo
+**  Parametros:     Flujo, longitud
+**  Retorno:        ns por byte
+****************************************************************************************/
+double medirNuevoUBXSITL(const uint8_t *flujo, uint32_t longitud)
+{
+    static analizadorUBX_t analizador;
+    const uint32_t repeticiones = 1 + BYTES_MEDIDA_UBX_SITL / longitud;
+    uint32_t tramas = 0;
+    bool nuevosDatos = false;
+    const double inicio = tiempoRealNsSITL();
+
+    for (uint32_t r = 0; r < repeticiones; r++) {
+        uint32_t pos = 0;
+
+        iniciarAnalizadorUBX(&analizador, NULL, 0, contarTramaUBXSITL, &tramas);
+
+        for (uint32_t llegados = 0; llegados < longitud;) {
+            llegados = MIN(llegados + BLOQUE_MEDIDA_UBX_SITL, longitud);
+            pos += analizarBloqueUBX(&analizador, &flujo[pos], llegados - pos, &nuevosDatos);
+        }
+    }
+
+    return (tiempoRealNsSITL() - inicio) / ((double)repeticiones * longitud);
+}
+
+#endif
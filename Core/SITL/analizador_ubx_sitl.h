@@ -0,0 +1,66 @@
+/***************************************************************************************
+**  analizador_ubx_sitl.h - Prueba, fuzz y medida del analizador UBX
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __ANALIZADOR_UBX_SITL_H
+#define __ANALIZADOR_UBX_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * El flujo de bytes es un log capturado del receptor (fichero .ubx de u-center) o se
+ * generan epocas de NAV-PVT, NAV-SOL, NAV-VELNED, NAV-DOP y MON-HW con NMEA y ACK entre
+ * medias. Se pasa por un anillo como el de la UART, con bloques de llegada de tamanio
+ * aleatorio, y las tramas tienen que ser las mismas que con la maquina de estados byte
+ * a byte anterior. Despues se corrompe el flujo (bytes cambiados, insertados y borrados)
+ * y se comprueba que toda trama despachada es valida y que no se pierde ninguna de las
+ * que acepta la maquina anterior. Por ultimo se mide el tiempo por byte de los dos
+ */
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarAnalizadorUBXSITL(const char *datos);
+
+#endif // __ANALIZADOR_UBX_SITL_H
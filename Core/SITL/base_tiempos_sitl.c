@@ -0,0 +1,271 @@
+/***************************************************************************************
+**  base_tiempos_sitl.c - Prueba y medida de la base de tiempos sobre el reloj del PC
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "base_tiempos_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+
+#include "sitl.h"
+#include "Comun/base_tiempos.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define FREC_CONTADOR_HOST_SITL         1000000000   // ns de clock_gettime truncados a 32 bits
+#define FREC_CONTADOR_SIMULADO_SITL     216000000    // Reloj del STM32F767
+#define PASO_MAX_CONTADOR_SITL          4096         // Ciclos maximos entre lecturas simuladas
+#define INCREMENTO_MEDIDA_SITL          37           // Ciclos entre lecturas en la medida
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static baseTiempos_t baseHostSITL;
+static baseTiempos_t baseSimuladaSITL;
+static volatile uint32_t contadorSimuladoSITL;         // Hace de DWT->CYCCNT
+
+// Estado de micros() con el SysTick y division, para comparar
+static volatile uint32_t msSysTickSITL;
+static volatile uint32_t valSysTickSITL;
+static volatile uint32_t usTicksSITL = FREC_CONTADOR_SIMULADO_SITL / 1000000;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+static inline uint32_t leerCiclosHostSITL(void);
+static inline uint32_t leerCiclosSimuladoSITL(void);
+uint32_t comprobarRelojHostSITL(uint32_t numLecturas);
+uint32_t comprobarContadorSimuladoSITL(uint32_t numLecturas);
+void medirBaseTiemposSITL(uint32_t numLecturas);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool probarBaseTiemposSITL(uint32_t numLecturas)
+**  Descripcion:    Comprueba la base de tiempos con el reloj del PC y con un contador
+**                  simulado, y mide el coste de las lecturas
+**  Parametros:     Lecturas de cada prueba
+**  Retorno:        True si no hay errores
+****************************************************************************************/
+bool probarBaseTiemposSITL(uint32_t numLecturas)
+{
+    const uint32_t errores = comprobarRelojHostSITL(numLecturas) + comprobarContadorSimuladoSITL(numLecturas);
+
+    medirBaseTiemposSITL(numLecturas);
+    return errores == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t comprobarRelojHostSITL(uint32_t numLecturas)
+**  Descripcion:    Lee nanos y micros con el contador sacado de clock_gettime y comprueba
+**                  que quedan entre dos lecturas del reloj y que no retroceden
+**  Parametros:     Lecturas
+**  Retorno:        Numero de errores
+****************************************************************************************/
+uint32_t comprobarRelojHostSITL(uint32_t numLecturas)
+{
+    // La referencia tiene que caer en un tick, como el SysTick en el firmware
+    const uint64_t inicio = (uint64_t)tiempoRealNsSITL() / 1000000 * 1000000;
+    uint32_t fueraDeRango = 0, retrocesos = 0, ticks = 0;
+    uint64_t nsAnterior = 0;
+    uint32_t usAnterior = (uint32_t)(inicio / 1000);
+
+    iniciarBaseTiempos(&baseHostSITL, FREC_CONTADOR_HOST_SITL, 1000, (uint32_t)inicio, inicio);
+
+    for (uint32_t i = 0; i < numLecturas; i++) {
+        // Ticks de 1 ms, como los haria el SysTick
+        while (leerCiclosHostSITL() - baseHostSITL.marca[baseHostSITL.version & 1].ciclos >= baseHostSITL.ciclosPorPaso) {
+            avanzarBaseTiempos(&baseHostSITL);
+            ticks++;
+        }
+
+        const uint64_t antes = (uint64_t)tiempoRealNsSITL();
+        const uint64_t ns = nanosBaseTiempos(&baseHostSITL, leerCiclosHostSITL);
+        const uint32_t us = microsBaseTiempos(&baseHostSITL, leerCiclosHostSITL);
+        const uint64_t despues = (uint64_t)tiempoRealNsSITL();
+
+        if (ns < antes || ns > despues || (int32_t)(us - (uint32_t)(antes / 1000)) < 0 || (int32_t)((uint32_t)(despues / 1000) - us) < 0)
+            fueraDeRango++;
+
+        if (ns < nsAnterior || (int32_t)(us - usAnterior) < 0)
+            retrocesos++;
+
+        nsAnterior = ns;
+        usAnterior = us;
+    }
+
+    printf("base_tiempos contador=host lecturas=%u ticks=%u fuera_rango=%u retrocesos=%u\n", numLecturas, ticks, fueraDeRango, retrocesos);
+    return fueraDeRango + retrocesos;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t comprobarContadorSimuladoSITL(uint32_t numLecturas)
+**  Descripcion:    Avanza un contador de 216 MHz a saltos aleatorios, pasando por el
+**                  desbordamiento de 32 bits, y compara nanos y micros con el tiempo exacto
+**  Parametros:     Lecturas
+**  Retorno:        Numero de errores
+****************************************************************************************/
+uint32_t comprobarContadorSimuladoSITL(uint32_t numLecturas)
+{
+    const uint32_t ciclosInicio = UINT32_MAX - 100 * (FREC_CONTADOR_SIMULADO_SITL / 1000);
+    uint64_t ciclosTotales = 0;
+    uint64_t nsAnterior = 0;
+    uint32_t usAnterior = 0;
+    uint32_t errores = 0, retrocesos = 0, semilla = 1;
+    int64_t errorMaxNs = 0, errorMaxUs = 0;
+
+    contadorSimuladoSITL = ciclosInicio;
+    iniciarBaseTiempos(&baseSimuladaSITL, FREC_CONTADOR_SIMULADO_SITL, 1000, ciclosInicio, 0);
+
+    for (uint32_t i = 0; i < numLecturas; i++) {
+        semilla ^= semilla << 13;
+        semilla ^= semilla >> 17;
+        semilla ^= semilla << 5;
+
+        const uint32_t paso = semilla % PASO_MAX_CONTADOR_SITL;
+        contadorSimuladoSITL += paso;
+        ciclosTotales += paso;
+
+        while (contadorSimuladoSITL - baseSimuladaSITL.marca[baseSimuladaSITL.version & 1].ciclos >= baseSimuladaSITL.ciclosPorPaso)
+            avanzarBaseTiempos(&baseSimuladaSITL);
+
+        const uint64_t ns = nanosBaseTiempos(&baseSimuladaSITL, leerCiclosSimuladoSITL);
+        const uint32_t us = microsBaseTiempos(&baseSimuladaSITL, leerCiclosSimuladoSITL);
+        // Tiempo exacto en dos partes para no desbordar el producto
+        const uint64_t segundos = ciclosTotales / FREC_CONTADOR_SIMULADO_SITL;
+        const uint64_t resto = ciclosTotales % FREC_CONTADOR_SIMULADO_SITL;
+        const int64_t errorNs = (int64_t)(segundos * 1000000000 + resto * 1000000000 / FREC_CONTADOR_SIMULADO_SITL) - (int64_t)ns;
+        const int64_t errorUs = (int32_t)((uint32_t)(segundos * 1000000 + resto * 1000000 / FREC_CONTADOR_SIMULADO_SITL) - us);
+
+        // El multiplicador redondea hacia abajo: como mucho una unidad por detras, nunca por delante
+        if (errorNs < 0 || errorNs > 1 || errorUs < 0 || errorUs > 1)
+            errores++;
+
+        if (ns < nsAnterior || (int32_t)(us - usAnterior) < 0)
+            retrocesos++;
+
+        errorMaxNs = errorNs > errorMaxNs ? errorNs : errorMaxNs;
+        errorMaxUs = errorUs > errorMaxUs ? errorUs : errorMaxUs;
+        nsAnterior = ns;
+        usAnterior = us;
+    }
+
+    printf("base_tiempos contador=216MHz lecturas=%u mult_ns=%u>>%u mult_us=%u>>%u error_max_ns=%lld error_max_us=%lld errores=%u retrocesos=%u\n",
+           numLecturas, baseSimuladaSITL.multNs, baseSimuladaSITL.despNs, baseSimuladaSITL.multUs, baseSimuladaSITL.despUs,
+           (long long)errorMaxNs, (long long)errorMaxUs, errores, retrocesos);
+    return errores + retrocesos;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void medirBaseTiemposSITL(uint32_t numLecturas)
+**  Descripcion:    Mide el coste por llamada de micros() con division sobre el SysTick,
+**                  de micros y nanos con la base de tiempos y de nanos con el reloj del PC
+**  Parametros:     Lecturas
+**  Retorno:        Ninguno
+****************************************************************************************/
+void medirBaseTiemposSITL(uint32_t numLecturas)
+{
+    double inicio, fin;
+    volatile uint64_t acumulado = 0;
+    double s;
+
+    // micros() anterior: ms del SysTick mas los ciclos que le quedan al SysTick divididos
+    inicio = tiempoRealNsSITL();
+    for (uint32_t i = 0; i < numLecturas; i++) {
+        valSysTickSITL = (valSysTickSITL - INCREMENTO_MEDIDA_SITL) & 0x1FFFF;
+        acumulado += msSysTickSITL * 1000 + (usTicksSITL * 1000 - valSysTickSITL) / usTicksSITL;
+    }
+    fin = tiempoRealNsSITL();
+    s = (fin - inicio) * 1e-9;
+    printf("base_tiempos version=division_us ns_llamada=%.2f\n", s * 1e9 / numLecturas);
+
+    inicio = tiempoRealNsSITL();
+    for (uint32_t i = 0; i < numLecturas; i++) {
+        contadorSimuladoSITL += INCREMENTO_MEDIDA_SITL;
+        acumulado += microsBaseTiempos(&baseSimuladaSITL, leerCiclosSimuladoSITL);
+    }
+    fin = tiempoRealNsSITL();
+    s = (fin - inicio) * 1e-9;
+    printf("base_tiempos version=ciclos_us ns_llamada=%.2f\n", s * 1e9 / numLecturas);
+
+    inicio = tiempoRealNsSITL();
+    for (uint32_t i = 0; i < numLecturas; i++) {
+        contadorSimuladoSITL += INCREMENTO_MEDIDA_SITL;
+        acumulado += nanosBaseTiempos(&baseSimuladaSITL, leerCiclosSimuladoSITL);
+    }
+    fin = tiempoRealNsSITL();
+    s = (fin - inicio) * 1e-9;
+    printf("base_tiempos version=ciclos_ns ns_llamada=%.2f\n", s * 1e9 / numLecturas);
+
+    inicio = tiempoRealNsSITL();
+    for (uint32_t i = 0; i < numLecturas; i++)
+        acumulado += nanosBaseTiempos(&baseHostSITL, leerCiclosHostSITL);
+    fin = tiempoRealNsSITL();
+    s = (fin - inicio) * 1e-9;
+    printf("base_tiempos version=host_ns ns_llamada=%.2f\n", s * 1e9 / numLecturas);
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t leerCiclosHostSITL(void)
+**  Descripcion:    Contador de 32 bits a 1 GHz sobre el reloj del PC
+**  Parametros:     Ninguno
+**  Retorno:        Ciclos
+****************************************************************************************/
+static inline uint32_t leerCiclosHostSITL(void)
+{
+    return (uint32_t)(uint64_t)tiempoRealNsSITL();
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t leerCiclosSimuladoSITL(void)
+**  Descripcion:    Lee el contador simulado
+**  Parametros:     Ninguno
+**  Retorno:        Ciclos
+****************************************************************************************/
+static inline uint32_t leerCiclosSimuladoSITL(void)
+{
+    return contadorSimuladoSITL;
+}
+
+#endif
@@ -0,0 +1,63 @@
+/***************************************************************************************
+**  base_tiempos_sitl.h - Prueba y medida de la base de tiempos sobre el reloj del PC
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __BASE_TIEMPOS_SITL_H
+#define __BASE_TIEMPOS_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Ejecuta la base de tiempos del firmware con un contador de 32 bits a 1 GHz sacado de
+ * clock_gettime, con los ticks de 1 ms hechos en el propio bucle. Comprueba que micros y
+ * nanos no retroceden y que nanos no se separa del reloj del PC. Despues mide el coste de
+ * la conversion con un contador simulado de 216 MHz frente a la de micros() con division
+ */
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarBaseTiemposSITL(uint32_t numLecturas);
+
+#endif // __BASE_TIEMPOS_SITL_H
@@ -0,0 +1,479 @@
+/***************************************************************************************
+**  buffer_anillo_sitl.c - Prueba y medida del buffer en anillo de bytes
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "buffer_anillo_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+
+#include "sitl.h"
+#include "Comun/buffer_anillo.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define TAM_ANILLO_SITL                 256          // Pequenio para dar muchas vueltas
+#define TAM_ANILLO_HILOS_SITL           4096         // Mismo tamanio que el de transmision USB
+#define INICIO_INDICES_SITL             (UINT32_MAX - 1000)
+#define TAM_TRAMA_MEDIDA_SITL           200          // Trama de telemetria tipica
+#define TAM_ANILLO_DMA_SITL             64           // Como el de recepcion de la UART
+#define INICIO_INDICES_DMA_SITL         0xFFFFFF00   // Multiplo del tamanio: el DMA empieza en 0
+#define MIN(a, b)                       ((a) < (b) ? (a) : (b))
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    bufferAnillo_t anillo;
+    uint64_t totalBytes;
+    uint32_t errores;
+    uint32_t semilla;
+} pruebaHilosSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static uint8_t bufferSITL[TAM_ANILLO_SITL];
+static uint8_t bufferHilosSITL[TAM_ANILLO_HILOS_SITL];
+static uint8_t bufferDMASITL[TAM_ANILLO_DMA_SITL];
+static uint64_t entregadosDMASITL;
+static uint32_t erroresEntregaDMASITL;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+static inline uint8_t patronSITL(uint64_t posicion);
+static inline uint32_t aleatorioSITL(uint32_t *semilla);
+uint32_t compararModeloAnilloSITL(uint32_t numOperaciones);
+uint32_t probarHilosAnilloSITL(uint32_t numOperaciones);
+uint32_t compararDMAcircularAnilloSITL(uint32_t numOperaciones);
+static inline uint32_t escribirDMASITL(uint64_t *escritosDMA, uint32_t longitud);
+void entregaDMASITL(uint8_t dato);
+void *productorAnilloSITL(void *arg);
+void *consumidorAnilloSITL(void *arg);
+void medirBufferAnilloSITL(uint32_t numOperaciones);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool probarBufferAnilloSITL(uint32_t numOperaciones)
+**  Descripcion:    Comprueba el anillo con el modelo y con dos hilos, y mide el caudal
+**  Parametros:     Operaciones de cada prueba
+**  Retorno:        True si no hay errores
+****************************************************************************************/
+bool probarBufferAnilloSITL(uint32_t numOperaciones)
+{
+    const uint32_t errores = compararModeloAnilloSITL(numOperaciones) + probarHilosAnilloSITL(numOperaciones) +
+                             compararDMAcircularAnilloSITL(numOperaciones);
+
+    medirBufferAnilloSITL(numOperaciones);
+    return errores == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t compararModeloAnilloSITL(uint32_t numOperaciones)
+**  Descripcion:    Hace operaciones aleatorias sobre el anillo y comprueba longitudes,
+**                  posiciones y datos con un modelo de contadores de 64 bits
+**  Parametros:     Operaciones
+**  Retorno:        Numero de errores
+****************************************************************************************/
+uint32_t compararModeloAnilloSITL(uint32_t numOperaciones)
+{
+    bufferAnillo_t anillo;
+    uint64_t escritos = 0, leidos = 0;
+    uint32_t errores = 0, semilla = 1, llenos = 0, vueltas = 0;
+    uint8_t datos[TAM_ANILLO_SITL * 2];
+
+    if (iniciarBufferAnillo(&anillo, bufferSITL, TAM_ANILLO_SITL - 1) || !iniciarBufferAnillo(&anillo, bufferSITL, TAM_ANILLO_SITL))
+        errores++;
+
+    // Los indices corren libres: se empieza cerca del desbordamiento
+    anillo.cabeza = INICIO_INDICES_SITL;
+    anillo.cola = INICIO_INDICES_SITL;
+
+    for (uint32_t i = 0; i < numOperaciones; i++) {
+        const uint32_t ocupados = (uint32_t)(escritos - leidos);
+        const uint32_t libres = TAM_ANILLO_SITL - ocupados;
+        const uint32_t posCabeza = (INICIO_INDICES_SITL + escritos) & (TAM_ANILLO_SITL - 1);
+        const uint32_t posCola = (INICIO_INDICES_SITL + leidos) & (TAM_ANILLO_SITL - 1);
+        const uint32_t longitud = aleatorioSITL(&semilla) % (TAM_ANILLO_SITL + TAM_ANILLO_SITL / 2);
+
+        if (bytesOcupadosBufferAnillo(&anillo) != ocupados || bytesLibresBufferAnillo(&anillo) != libres)
+            errores++;
+
+        llenos += libres == 0;
+
+        switch (aleatorioSITL(&semilla) % 3) {
+            case 0: {
+                // Escritura con copia, que puede partirse en dos tramos
+                for (uint32_t j = 0; j < longitud; j++)
+                    datos[j] = patronSITL(escritos + j);
+
+                const uint32_t n = escribirBufferAnillo(&anillo, datos, longitud);
+                if (n != MIN(longitud, libres))
+                    errores++;
+
+                vueltas += posCabeza + n > TAM_ANILLO_SITL;
+                escritos += n;
+                break;
+            }
+
+            case 1: {
+                // Reserva de un tramo contiguo del que solo se publica una parte
+                uint8_t *bloque;
+                const uint32_t n = reservarBufferAnillo(&anillo, &bloque, longitud);
+
+                if (bloque != &bufferSITL[posCabeza] || n != MIN(MIN(longitud, libres), TAM_ANILLO_SITL - posCabeza))
+                    errores++;
+
+                const uint32_t publicados = n > 0 ? aleatorioSITL(&semilla) % (n + 1) : 0;
+                for (uint32_t j = 0; j < publicados; j++)
+                    bloque[j] = patronSITL(escritos + j);
+
+                publicarBufferAnillo(&anillo, publicados);
+                escritos += publicados;
+                break;
+            }
+
+            default: {
+                // Lectura del tramo contiguo y consumo de una parte
+                const uint8_t *bloque;
+                const uint32_t n = bloqueBufferAnillo(&anillo, &bloque);
+
+                if (bloque != &bufferSITL[posCola] || n != MIN(ocupados, TAM_ANILLO_SITL - posCola))
+                    errores++;
+
+                const uint32_t consumidos = n > 0 ? aleatorioSITL(&semilla) % (n + 1) : 0;
+                for (uint32_t j = 0; j < consumidos; j++)
+                    errores += bloque[j] != patronSITL(leidos + j);
+
+                consumirBufferAnillo(&anillo, consumidos);
+                leidos += consumidos;
+                break;
+            }
+        }
+    }
+
+    printf("buffer_anillo prueba=modelo operaciones=%u bytes=%llu lleno=%u escrituras_partidas=%u errores=%u\n",
+           numOperaciones, (unsigned long long)escritos, llenos, vueltas, errores);
+    return errores;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t probarHilosAnilloSITL(uint32_t numOperaciones)
+**  Descripcion:    Pasa datos de un hilo productor a uno consumidor por el anillo sin
+**                  bloqueos y comprueba que llegan completos y en orden
+**  Parametros:     Operaciones del productor
+**  Retorno:        Numero de errores
+****************************************************************************************/
+uint32_t probarHilosAnilloSITL(uint32_t numOperaciones)
+{
+    pruebaHilosSITL_t prueba = { .totalBytes = (uint64_t)numOperaciones * 16, .errores = 0, .semilla = 7 };
+    pthread_t productor, consumidor;
+
+    iniciarBufferAnillo(&prueba.anillo, bufferHilosSITL, TAM_ANILLO_HILOS_SITL);
+    prueba.anillo.cabeza = INICIO_INDICES_SITL;
+    prueba.anillo.cola = INICIO_INDICES_SITL;
+
+    if (pthread_create(&consumidor, NULL, consumidorAnilloSITL, &prueba) != 0 ||
+        pthread_create(&productor, NULL, productorAnilloSITL, &prueba) != 0) {
+        printf("buffer_anillo prueba=hilos error=pthread_create\n");
+        return 1;
+    }
+
+    pthread_join(productor, NULL);
+    pthread_join(consumidor, NULL);
+
+    printf("buffer_anillo prueba=hilos bytes=%llu errores=%u\n", (unsigned long long)prueba.totalBytes, prueba.errores);
+    return prueba.errores;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t compararDMAcircularAnilloSITL(uint32_t numOperaciones)
+**  Descripcion:    Recibe como la UART con DMA circular: el DMA escribe sin mirar la cola y
+**                  la cabeza se saca de su contador. Primero con tramas que se entregan en
+**                  la interrupcion IDLE y despues leyendo por sondeo con desbordes
+**  Parametros:     Operaciones de cada parte
+**  Retorno:        Numero de errores
+****************************************************************************************/
+uint32_t compararDMAcircularAnilloSITL(uint32_t numOperaciones)
+{
+    bufferAnillo_t anillo;
+    uint64_t escritosDMA = 0;
+    uint32_t errores = 0, semilla = 3, desbordes = 0;
+
+    // Tramas de 1 a TAM - 1 bytes, cada una seguida de la interrupcion IDLE
+    iniciarBufferAnillo(&anillo, bufferDMASITL, TAM_ANILLO_DMA_SITL);
+    anillo.cabeza = INICIO_INDICES_DMA_SITL;
+    anillo.cola = INICIO_INDICES_DMA_SITL;
+    entregadosDMASITL = 0;
+    erroresEntregaDMASITL = 0;
+
+    for (uint32_t i = 0; i < numOperaciones; i++) {
+        const uint32_t longitud = aleatorioSITL(&semilla) % (TAM_ANILLO_DMA_SITL - 1) + 1;
+        const uint32_t posicion = escribirDMASITL(&escritosDMA, longitud);
+
+        if (sincronizarCabezaBufferAnillo(&anillo, posicion) != longitud)
+            errores++;
+
+        if (entregarBufferAnillo(&anillo, entregaDMASITL) != longitud || bytesOcupadosBufferAnillo(&anillo) != 0)
+            errores++;
+    }
+
+    errores += erroresEntregaDMASITL + (entregadosDMASITL != escritosDMA);
+
+    // Lectura por sondeo: varias rafagas entre lecturas pueden alcanzar a la cola
+    iniciarBufferAnillo(&anillo, bufferDMASITL, TAM_ANILLO_DMA_SITL);
+    anillo.cabeza = INICIO_INDICES_DMA_SITL;
+    anillo.cola = INICIO_INDICES_DMA_SITL;
+    escritosDMA = 0;
+
+    for (uint32_t i = 0; i < numOperaciones; i++) {
+        const uint32_t rafagas = aleatorioSITL(&semilla) % 4;
+
+        for (uint32_t j = 0; j < rafagas; j++) {
+            const uint32_t longitud = aleatorioSITL(&semilla) % TAM_ANILLO_DMA_SITL;
+            const uint32_t posicion = escribirDMASITL(&escritosDMA, longitud);
+            const uint32_t cola = anillo.cola;
+
+            if (sincronizarCabezaBufferAnillo(&anillo, posicion) != longitud)
+                errores++;
+
+            desbordes += anillo.cola != cola;
+        }
+
+        if (anillo.cabeza != (uint32_t)(INICIO_INDICES_DMA_SITL + escritosDMA) ||
+            bytesOcupadosBufferAnillo(&anillo) > TAM_ANILLO_DMA_SITL)
+            errores++;
+
+        // La cola siempre apunta al byte mas antiguo que el DMA no ha pisado
+        const uint8_t *bloque;
+        const uint32_t n = bloqueBufferAnillo(&anillo, &bloque);
+        const uint32_t consumidos = n > 0 ? aleatorioSITL(&semilla) % (n + 1) : 0;
+        const uint64_t leidos = escritosDMA - bytesOcupadosBufferAnillo(&anillo);
+
+        for (uint32_t j = 0; j < consumidos; j++)
+            errores += bloque[j] != patronSITL(leidos + j);
+
+        consumirBufferAnillo(&anillo, consumidos);
+    }
+
+    printf("buffer_anillo prueba=dma_circular operaciones=%u vueltas=%llu desbordes=%u errores=%u\n",
+           numOperaciones, (unsigned long long)(escritosDMA / TAM_ANILLO_DMA_SITL), desbordes, errores);
+    return errores;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t escribirDMASITL(uint64_t *escritosDMA, uint32_t longitud)
+**  Descripcion:    Escribe el patron como el DMA circular, sin mirar la cola
+**  Parametros:     Bytes escritos por el DMA desde el inicio, longitud
+**  Retorno:        Posicion del DMA en el buffer (TAM - NDTR)
+****************************************************************************************/
+static inline uint32_t escribirDMASITL(uint64_t *escritosDMA, uint32_t longitud)
+{
+    for (uint32_t i = 0; i < longitud; i++, (*escritosDMA)++)
+        bufferDMASITL[*escritosDMA & (TAM_ANILLO_DMA_SITL - 1)] = patronSITL(*escritosDMA);
+
+    return *escritosDMA & (TAM_ANILLO_DMA_SITL - 1);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void entregaDMASITL(uint8_t dato)
+**  Descripcion:    Recibe los bytes entregados en la IDLE y comprueba el patron
+**  Parametros:     Byte
+**  Retorno:        Ninguno
+****************************************************************************************/
+void entregaDMASITL(uint8_t dato)
+{
+    erroresEntregaDMASITL += dato != patronSITL(entregadosDMASITL);
+    entregadosDMASITL++;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void *productorAnilloSITL(void *arg)
+**  Descripcion:    Escribe el patron en trozos aleatorios, alternando copia y reserva
+**  Parametros:     Prueba
+**  Retorno:        NULL
+****************************************************************************************/
+void *productorAnilloSITL(void *arg)
+{
+    pruebaHilosSITL_t *prueba = (pruebaHilosSITL_t *)arg;
+    uint8_t datos[TAM_ANILLO_HILOS_SITL];
+    uint64_t escritos = 0;
+
+    while (escritos < prueba->totalBytes) {
+        uint32_t longitud = aleatorioSITL(&prueba->semilla) % 512 + 1;
+
+        if (longitud > prueba->totalBytes - escritos)
+            longitud = prueba->totalBytes - escritos;
+
+        if (longitud & 1) {
+            for (uint32_t j = 0; j < longitud; j++)
+                datos[j] = patronSITL(escritos + j);
+
+            const uint32_t n = escribirBufferAnillo(&prueba->anillo, datos, longitud);
+            escritos += n;
+
+            if (n < longitud)
+                sched_yield();
+        }
+        else {
+            uint8_t *bloque;
+            const uint32_t n = reservarBufferAnillo(&prueba->anillo, &bloque, longitud);
+
+            for (uint32_t j = 0; j < n; j++)
+                bloque[j] = patronSITL(escritos + j);
+
+            publicarBufferAnillo(&prueba->anillo, n);
+            escritos += n;
+
+            if (n < longitud)
+                sched_yield();
+        }
+    }
+
+    return NULL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void *consumidorAnilloSITL(void *arg)
+**  Descripcion:    Lee tramos contiguos y comprueba el patron
+**  Parametros:     Prueba
+**  Retorno:        NULL
+****************************************************************************************/
+void *consumidorAnilloSITL(void *arg)
+{
+    pruebaHilosSITL_t *prueba = (pruebaHilosSITL_t *)arg;
+    uint64_t leidos = 0;
+    uint32_t errores = 0;
+
+    while (leidos < prueba->totalBytes) {
+        const uint8_t *bloque;
+        const uint32_t n = bloqueBufferAnillo(&prueba->anillo, &bloque);
+
+        for (uint32_t j = 0; j < n; j++)
+            errores += bloque[j] != patronSITL(leidos + j);
+
+        consumirBufferAnillo(&prueba->anillo, n);
+        leidos += n;
+
+        if (n == 0)
+            sched_yield();
+    }
+
+    prueba->errores += errores;
+    return NULL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void medirBufferAnilloSITL(uint32_t numOperaciones)
+**  Descripcion:    Mide el caudal encolando tramas byte a byte y de una vez
+**  Parametros:     Tramas a encolar
+**  Retorno:        Ninguno
+****************************************************************************************/
+void medirBufferAnilloSITL(uint32_t numOperaciones)
+{
+    bufferAnillo_t anillo;
+    uint8_t trama[TAM_TRAMA_MEDIDA_SITL];
+    double inicio, fin;
+    double s;
+
+    for (uint32_t i = 0; i < TAM_TRAMA_MEDIDA_SITL; i++)
+        trama[i] = patronSITL(i);
+
+    iniciarBufferAnillo(&anillo, bufferHilosSITL, TAM_ANILLO_HILOS_SITL);
+
+    inicio = tiempoRealNsSITL();
+    for (uint32_t i = 0; i < numOperaciones; i++) {
+        for (uint32_t j = 0; j < TAM_TRAMA_MEDIDA_SITL; j++)
+            escribirBufferAnillo(&anillo, &trama[j], 1);
+
+        vaciarBufferAnillo(&anillo);
+    }
+    fin = tiempoRealNsSITL();
+    s = (fin - inicio) * 1e-9;
+    printf("buffer_anillo version=byte_a_byte trama=%u ns_trama=%.1f MB_s=%.0f\n", TAM_TRAMA_MEDIDA_SITL,
+           s * 1e9 / numOperaciones, (double)numOperaciones * TAM_TRAMA_MEDIDA_SITL / s * 1e-6);
+
+    inicio = tiempoRealNsSITL();
+    for (uint32_t i = 0; i < numOperaciones; i++) {
+        escribirBufferAnillo(&anillo, trama, TAM_TRAMA_MEDIDA_SITL);
+        vaciarBufferAnillo(&anillo);
+    }
+    fin = tiempoRealNsSITL();
+    s = (fin - inicio) * 1e-9;
+    printf("buffer_anillo version=bloque trama=%u ns_trama=%.1f MB_s=%.0f\n", TAM_TRAMA_MEDIDA_SITL,
+           s * 1e9 / numOperaciones, (double)numOperaciones * TAM_TRAMA_MEDIDA_SITL / s * 1e-6);
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t patronSITL(uint64_t posicion)
+**  Descripcion:    Byte que debe haber en cada posicion del flujo de datos
+**  Parametros:     Posicion desde el inicio
+**  Retorno:        Byte
+****************************************************************************************/
+static inline uint8_t patronSITL(uint64_t posicion)
+{
+    return (uint8_t)(posicion * 131 + (posicion >> 8));
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t aleatorioSITL(uint32_t *semilla)
+**  Descripcion:    Generador xorshift de 32 bits
+**  Parametros:     Semilla
+**  Retorno:        Numero aleatorio
+****************************************************************************************/
+static inline uint32_t aleatorioSITL(uint32_t *semilla)
+{
+    *semilla ^= *semilla << 13;
+    *semilla ^= *semilla >> 17;
+    *semilla ^= *semilla << 5;
+    return *semilla;
+}
+
+#endif
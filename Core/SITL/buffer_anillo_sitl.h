@@ -0,0 +1,64 @@
+/***************************************************************************************
+**  buffer_anillo_sitl.h - Prueba y medida del buffer en anillo de bytes
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __BUFFER_ANILLO_SITL_H
+#define __BUFFER_ANILLO_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Compara el anillo con un modelo de referencia haciendo escrituras, reservas parciales y
+ * consumos parciales de longitud aleatoria, con los indices pasando por el desbordamiento
+ * de 32 bits. Despues lo usa con un hilo productor y otro consumidor a la vez, lo llena
+ * como el DMA circular de recepcion de la UART (cabeza desde el contador, entrega en la
+ * IDLE y desbordes) y mide el caudal de la escritura en bloque frente a byte a byte
+ */
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarBufferAnilloSITL(uint32_t numOperaciones);
+
+#endif // __BUFFER_ANILLO_SITL_H
@@ -0,0 +1,609 @@
+/***************************************************************************************
+**  calibrador_mag_sitl.c - Prueba del ajuste por tramos del calibrador del magnetometro
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "calibrador_mag_sitl.h"
+
+#if defined(SITL) && defined(USAR_MAG)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sitl.h"
+#include "Sensores/Calibrador/calibrador_mag.h"
+#include "Comun/matematicas.h"
+#include "Comun/util.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define PASOS_PASO_1_CAL_MAG_SITL          10       // Mismas iteraciones que el calibrador
+#define PASOS_ESFERA_PASO_2_CAL_MAG_SITL   15
+#define PASOS_PASO_2_CAL_MAG_SITL          35
+#define ITERACIONES_CAL_MAG_SITL           (PASOS_PASO_1_CAL_MAG_SITL + PASOS_PASO_2_CAL_MAG_SITL)
+#define MAX_TICKS_CAL_MAG_SITL             8192
+#define REPETICIONES_CAL_MAG_SITL          5
+#define AMORTIGUAMIENTO_LM_CAL_MAG_SITL    10.0f
+
+#define RADIO_MIN_CAL_MAG_SITL             300.0f   // mGa
+#define RADIO_MAX_CAL_MAG_SITL             500.0f
+#define OFFSET_MAX_CAL_MAG_SITL            400.0f
+#define DIAG_MAX_CAL_MAG_SITL              0.2f     // Desviacion maxima respecto a 1
+#define OFFDIAG_MAX_CAL_MAG_SITL           0.1f
+#define RUIDO_CAL_MAG_SITL                 2.0f     // Desviacion tipica en mGa
+#define TAM_LINEA_CAL_MAG_SITL             256
+
+#define TOLERANCIA_PARAM_CAL_MAG_SITL      1e-3f    // Relativa al radio para radio y offset
+#define TOLERANCIA_OFFSET_CAL_MAG_SITL     0.02f    // Relativa al radio frente al offset real
+#define FRACCION_TICK_CAL_MAG_SITL         0.25     // Peor tick nuevo / peor iteracion anterior
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    float fitness;
+    float esferaLambda;
+    float elipseLambda;
+} ajusteAnteriorCalMagSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static bufferCalMag_t bufferCalMagSITL;
+static double nsTicksCalMagSITL[MAX_TICKS_CAL_MAG_SITL];
+static double nsIteracionesCalMagSITL[ITERACIONES_CAL_MAG_SITL];
+static uint32_t semillaCalMagSITL;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool compararAjustesCalMagSITL(const char *nombre, const calParamMag_t *real, double *nsTickMax, double *nsIteracionMax);
+uint32_t ejecutarAjusteCalMagSITL(calParamMag_t *cal, float *fitness);
+void ejecutarAjusteAnteriorCalMagSITL(calParamMag_t *cal, float *fitness);
+uint32_t avanzarTickCalMagSITL(ajusteLM_t *ajuste, calParamMag_t *cal, tipoAjusteMag_e tipo, uint32_t tick);
+void iniciarParametrosCalMagSITL(calParamMag_t *cal);
+void iterarAjusteAnteriorCalMagSITL(ajusteAnteriorCalMagSITL_t *ajuste, calParamMag_t *cal, tipoAjusteMag_e tipo);
+void calcularJacobianoAnteriorCalMagSITL(const float *muestra, const calParamMag_t *cal, tipoAjusteMag_e tipo, float *j);
+float calcularResiduoAnteriorCalMagSITL(const float *muestra, const calParamMag_t *cal);
+float calcularResiduoMedioAnteriorCalMagSITL(const calParamMag_t *cal);
+void generarDatasetCalMagSITL(uint32_t indice, calParamMag_t *real);
+bool leerDatasetCalMagSITL(const char *fichero);
+float aleatorioCalMagSITL(void);
+float errorParametrosCalMagSITL(const calParamMag_t *a, const calParamMag_t *b);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool probarCalibradorMagSITL(const char *datos)
+**  Descripcion:    Compara los dos solvers sobre un CSV de muestras o sobre varios
+**                  conjuntos generados
+**  Parametros:     Ruta del CSV o numero de conjuntos a generar
+**  Retorno:        True si todos los conjuntos coinciden y el tick esta acotado
+****************************************************************************************/
+bool probarCalibradorMagSITL(const char *datos)
+{
+    char *fin;
+    const uint32_t numGenerados = strtoul(datos, &fin, 0);
+    double nsTickMax = 0, nsIteracionMax = 0;
+    bool ok = true;
+
+    if (*fin != '\0') {
+        if (!leerDatasetCalMagSITL(datos))
+            return false;
+
+        ok = compararAjustesCalMagSITL(datos, NULL, &nsTickMax, &nsIteracionMax);
+    }
+    else {
+        for (uint32_t i = 0; i < numGenerados; i++) {
+            calParamMag_t real;
+            char nombre[32];
+
+            generarDatasetCalMagSITL(i, &real);
+            snprintf(nombre, sizeof(nombre), "generado%u", i);
+            ok &= compararAjustesCalMagSITL(nombre, &real, &nsTickMax, &nsIteracionMax);
+        }
+    }
+
+    const bool tickAcotado = nsTickMax <= FRACCION_TICK_CAL_MAG_SITL * nsIteracionMax;
+
+    printf("cal_mag muestras_tick=%u ns_tick_max=%.0f ns_iteracion_anterior_max=%.0f mejora=%.1f tick_acotado=%u\n",
+           MUESTRAS_POR_TICK_CAL_MAG, nsTickMax, nsIteracionMax, nsTickMax > 0 ? nsIteracionMax / nsTickMax : 0.0, tickAcotado);
+
+    return ok && tickAcotado;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool compararAjustesCalMagSITL(const char *nombre, const calParamMag_t *real,
+**                                                 double *nsTickMax, double *nsIteracionMax)
+**  Descripcion:    Ajusta el buffer con los dos solvers, compara los resultados y acumula
+**                  el peor tiempo de cada uno
+**  Parametros:     Nombre del conjunto, parametros reales o NULL, peor tick, peor iteracion
+**  Retorno:        True si los parametros coinciden
+****************************************************************************************/
+bool compararAjustesCalMagSITL(const char *nombre, const calParamMag_t *real, double *nsTickMax, double *nsIteracionMax)
+{
+    static double nsTicks[MAX_TICKS_CAL_MAG_SITL], nsIteraciones[ITERACIONES_CAL_MAG_SITL];
+    calParamMag_t cal, calAnterior;
+    float fitness, fitnessAnterior;
+    uint32_t numTicks = 0;
+
+    // Cada tick se queda con el minimo de las repeticiones, que son identicas
+    for (uint8_t r = 0; r < REPETICIONES_CAL_MAG_SITL; r++) {
+        numTicks = ejecutarAjusteCalMagSITL(&cal, &fitness);
+        ejecutarAjusteAnteriorCalMagSITL(&calAnterior, &fitnessAnterior);
+
+        for (uint32_t i = 0; i < numTicks; i++)
+            nsTicks[i] = r == 0 ? nsTicksCalMagSITL[i] : MIN(nsTicks[i], nsTicksCalMagSITL[i]);
+
+        for (uint32_t i = 0; i < ITERACIONES_CAL_MAG_SITL; i++)
+            nsIteraciones[i] = r == 0 ? nsIteracionesCalMagSITL[i] : MIN(nsIteraciones[i], nsIteracionesCalMagSITL[i]);
+    }
+
+    double nsTick = 0, nsIteracion = 0;
+    for (uint32_t i = 0; i < numTicks; i++)
+        nsTick = MAX(nsTick, nsTicks[i]);
+
+    for (uint32_t i = 0; i < ITERACIONES_CAL_MAG_SITL; i++)
+        nsIteracion = MAX(nsIteracion, nsIteraciones[i]);
+
+    *nsTickMax = MAX(*nsTickMax, nsTick);
+    *nsIteracionMax = MAX(*nsIteracionMax, nsIteracion);
+
+    const float errorParam = errorParametrosCalMagSITL(&cal, &calAnterior);
+    const float errorFitness = fabsf(fitness - fitnessAnterior) / MAX(fitnessAnterior, 1.0f);
+    bool ok = errorParam <= TOLERANCIA_PARAM_CAL_MAG_SITL && errorFitness <= TOLERANCIA_PARAM_CAL_MAG_SITL;
+
+    printf("cal_mag %s muestras=%u ticks=%u radio=%.2f offset=%.2f,%.2f,%.2f diag=%.4f,%.4f,%.4f offdiag=%.4f,%.4f,%.4f fitness=%.3f fitness_anterior=%.3f error_param=%.2g",
+           nombre, bufferCalMagSITL.cntMuestras, numTicks, (double)cal.radio, (double)cal.offset[0], (double)cal.offset[1], (double)cal.offset[2],
+           (double)cal.diag[0], (double)cal.diag[1], (double)cal.diag[2], (double)cal.offDiag[0], (double)cal.offDiag[1], (double)cal.offDiag[2],
+           (double)fitness, (double)fitnessAnterior, (double)errorParam);
+
+    if (real != NULL) {
+        float errorOffset = 0;
+        for (uint8_t i = 0; i < 3; i++)
+            errorOffset = MAX(errorOffset, fabsf(cal.offset[i] - real->offset[i]) / real->radio);
+
+        ok &= errorOffset <= TOLERANCIA_OFFSET_CAL_MAG_SITL;
+        printf(" error_offset_real=%.2g", (double)errorOffset);
+    }
+
+    printf(" ns_tick_max=%.0f ns_iteracion_anterior_max=%.0f ok=%u\n", nsTick, nsIteracion, ok);
+    return ok;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t ejecutarAjusteCalMagSITL(calParamMag_t *cal, float *fitness)
+**  Descripcion:    Ajusta el buffer con el solver por tramos del calibrador. El paso 1 se
+**                  inicia con el buffer vacio como en el calibrador
+**  Parametros:     Parametros ajustados, fitness final
+**  Retorno:        Numero de ticks
+****************************************************************************************/
+uint32_t ejecutarAjusteCalMagSITL(calParamMag_t *cal, float *fitness)
+{
+    const uint16_t numMuestras = bufferCalMagSITL.cntMuestras;
+    ajusteLM_t ajuste;
+    uint32_t tick = 0;
+
+    iniciarParametrosCalMagSITL(cal);
+
+    bufferCalMagSITL.cntMuestras = 0;
+    iniciarAjusteLMMag(&ajuste, &bufferCalMagSITL);
+    bufferCalMagSITL.cntMuestras = numMuestras;
+
+    while (ajuste.pasoAjuste < PASOS_PASO_1_CAL_MAG_SITL)
+        tick = avanzarTickCalMagSITL(&ajuste, cal, AJUSTE_ESFERA_MAG, tick);
+
+    iniciarAjusteLMMag(&ajuste, &bufferCalMagSITL);
+    while (ajuste.fase == FASE_LM_FITNESS)
+        tick = avanzarTickCalMagSITL(&ajuste, cal, AJUSTE_ESFERA_MAG, tick);
+
+    while (ajuste.pasoAjuste < PASOS_PASO_2_CAL_MAG_SITL) {
+        const tipoAjusteMag_e tipo = ajuste.pasoAjuste < PASOS_ESFERA_PASO_2_CAL_MAG_SITL ? AJUSTE_ESFERA_MAG : AJUSTE_ELIPSE_MAG;
+        tick = avanzarTickCalMagSITL(&ajuste, cal, tipo, tick);
+    }
+
+    *fitness = ajuste.fitness;
+    return tick;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t avanzarTickCalMagSITL(ajusteLM_t *ajuste, calParamMag_t *cal,
+**                                                 tipoAjusteMag_e tipo, uint32_t tick)
+**  Descripcion:    Hace un tick del solver por tramos midiendo su duracion
+**  Parametros:     Ajuste, parametros, esfera o elipse, numero de tick
+**  Retorno:        Siguiente tick
+****************************************************************************************/
+uint32_t avanzarTickCalMagSITL(ajusteLM_t *ajuste, calParamMag_t *cal, tipoAjusteMag_e tipo, uint32_t tick)
+{
+    const double inicio = tiempoRealNsSITL();
+
+    avanzarAjusteLMMag(ajuste, cal, &bufferCalMagSITL, tipo, MUESTRAS_POR_TICK_CAL_MAG);
+
+    if (tick < MAX_TICKS_CAL_MAG_SITL)
+        nsTicksCalMagSITL[tick] = tiempoRealNsSITL() - inicio;
+
+    return MIN(tick + 1, (uint32_t)MAX_TICKS_CAL_MAG_SITL);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void ejecutarAjusteAnteriorCalMagSITL(calParamMag_t *cal, float *fitness)
+**  Descripcion:    Ajusta el buffer con el solver anterior, una iteracion por tick
+**  Parametros:     Parametros ajustados, fitness final
+**  Retorno:        Ninguno
+****************************************************************************************/
+void ejecutarAjusteAnteriorCalMagSITL(calParamMag_t *cal, float *fitness)
+{
+    ajusteAnteriorCalMagSITL_t ajuste = { .fitness = 1.0e30f, .esferaLambda = 1.0f, .elipseLambda = 1.0f };
+
+    iniciarParametrosCalMagSITL(cal);
+
+    for (uint8_t i = 0; i < ITERACIONES_CAL_MAG_SITL; i++) {
+        tipoAjusteMag_e tipo = AJUSTE_ESFERA_MAG;
+
+        if (i == PASOS_PASO_1_CAL_MAG_SITL) {
+            ajuste.fitness = calcularResiduoMedioAnteriorCalMagSITL(cal);
+            ajuste.esferaLambda = 1.0f;
+            ajuste.elipseLambda = 1.0f;
+        }
+
+        if (i >= PASOS_PASO_1_CAL_MAG_SITL + PASOS_ESFERA_PASO_2_CAL_MAG_SITL)
+            tipo = AJUSTE_ELIPSE_MAG;
+
+        const double inicio = tiempoRealNsSITL();
+        iterarAjusteAnteriorCalMagSITL(&ajuste, cal, tipo);
+        nsIteracionesCalMagSITL[i] = tiempoRealNsSITL() - inicio;
+    }
+
+    *fitness = ajuste.fitness;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void iniciarParametrosCalMagSITL(calParamMag_t *cal)
+**  Descripcion:    Parametros de partida del calibrador con el offset medio de las muestras
+**  Parametros:     Parametros
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarParametrosCalMagSITL(calParamMag_t *cal)
+{
+    cal->radio = 200;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        cal->offset[i] = 0.0f;
+        cal->diag[i] = 1.0f;
+        cal->offDiag[i] = 0.0f;
+    }
+
+    for (uint16_t n = 0; n < bufferCalMagSITL.cntMuestras; n++) {
+        for (uint8_t i = 0; i < 3; i++)
+            cal->offset[i] -= bufferCalMagSITL.magAcum[n][i];
+    }
+
+    for (uint8_t i = 0; i < 3; i++)
+        cal->offset[i] /= bufferCalMagSITL.cntMuestras;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void iterarAjusteAnteriorCalMagSITL(ajusteAnteriorCalMagSITL_t *ajuste,
+**                                                      calParamMag_t *cal, tipoAjusteMag_e tipo)
+**  Descripcion:    Iteracion Levenberg-Marquardt completa del solver anterior, con J'J
+**                  completa y las dos inversas de matriz_t
+**  Parametros:     Ajuste, parametros, esfera o elipse
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iterarAjusteAnteriorCalMagSITL(ajusteAnteriorCalMagSITL_t *ajuste, calParamMag_t *cal, tipoAjusteMag_e tipo)
+{
+    const uint8_t numParam = tipo == AJUSTE_ESFERA_MAG ? NUM_PARAMETROS_ESFERA_MAG_CAL : NUM_PARAMETROS_ELIPSE_MAG_CAL;
+    float *lambda = tipo == AJUSTE_ESFERA_MAG ? &ajuste->esferaLambda : &ajuste->elipseLambda;
+    float fitness = ajuste->fitness;
+    calParamMag_t paramFit1 = *cal, paramFit2 = *cal;
+    float JTFI[NUM_PARAMETROS_ELIPSE_MAG_CAL] = { 0 };
+    matriz_t JTJ, JTJ2;
+
+    memset(&JTJ, 0, sizeof(matriz_t));
+    memset(&JTJ2, 0, sizeof(matriz_t));
+
+    for (uint16_t k = 0; k < bufferCalMagSITL.cntMuestras; k++) {
+        const float *muestra = bufferCalMagSITL.magAcum[k];
+        float jacobiano[NUM_PARAMETROS_ELIPSE_MAG_CAL];
+
+        calcularJacobianoAnteriorCalMagSITL(muestra, &paramFit1, tipo, jacobiano);
+
+        for (uint8_t i = 0; i < numParam; i++) {
+            for (uint8_t j = 0; j < numParam; j++) {
+                JTJ.m[i][j]  += jacobiano[i] * jacobiano[j];
+                JTJ2.m[i][j] += jacobiano[i] * jacobiano[j];
+            }
+
+            JTFI[i] += jacobiano[i] * calcularResiduoAnteriorCalMagSITL(muestra, &paramFit1);
+        }
+    }
+
+    for (uint8_t i = 0; i < numParam; i++) {
+        JTJ.m[i][i]  += *lambda;
+        JTJ2.m[i][i] += *lambda / AMORTIGUAMIENTO_LM_CAL_MAG_SITL;
+    }
+
+    if (!inversaMatriz(JTJ, &JTJ, numParam) || !inversaMatriz(JTJ2, &JTJ2, numParam))
+        return;
+
+    float *p1 = tipo == AJUSTE_ESFERA_MAG ? &paramFit1.radio : &paramFit1.offset[0];
+    float *p2 = tipo == AJUSTE_ESFERA_MAG ? &paramFit2.radio : &paramFit2.offset[0];
+    for (uint8_t fila = 0; fila < numParam; fila++) {
+        for (uint8_t col = 0; col < numParam; col++) {
+            p1[fila] -= JTFI[col] * JTJ.m[fila][col];
+            p2[fila] -= JTFI[col] * JTJ2.m[fila][col];
+        }
+    }
+
+    const float fit1 = calcularResiduoMedioAnteriorCalMagSITL(&paramFit1);
+    const float fit2 = calcularResiduoMedioAnteriorCalMagSITL(&paramFit2);
+
+    if (fit1 > ajuste->fitness && fit2 > ajuste->fitness)
+        *lambda *= AMORTIGUAMIENTO_LM_CAL_MAG_SITL;
+    else if (fit2 < ajuste->fitness && fit2 < fit1) {
+        *lambda /= AMORTIGUAMIENTO_LM_CAL_MAG_SITL;
+        paramFit1 = paramFit2;
+        fitness = fit2;
+    }
+    else if (fit1 < ajuste->fitness)
+        fitness = fit1;
+
+    if (!isnan(fitness) && fitness < ajuste->fitness) {
+        ajuste->fitness = fitness;
+        *cal = paramFit1;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void calcularJacobianoAnteriorCalMagSITL(const float *muestra, const calParamMag_t *cal,
+**                                                           tipoAjusteMag_e tipo, float *j)
+**  Descripcion:    Jacobiano de la esfera o de la elipse
+**  Parametros:     Muestra, parametros, esfera o elipse, jacobiano calculado
+**  Retorno:        Ninguno
+****************************************************************************************/
+void calcularJacobianoAnteriorCalMagSITL(const float *muestra, const calParamMag_t *cal, tipoAjusteMag_e tipo, float *j)
+{
+    const float x = muestra[0] + cal->offset[0];
+    const float y = muestra[1] + cal->offset[1];
+    const float z = muestra[2] + cal->offset[2];
+    const float A = cal->diag[0] * x + cal->offDiag[0] * y + cal->offDiag[1] * z;
+    const float B = cal->offDiag[0] * x + cal->diag[1] * y + cal->offDiag[2] * z;
+    const float C = cal->offDiag[1] * x + cal->offDiag[2] * y + cal->diag[2] * z;
+    const float longitud = sqrtf(A * A + B * B + C * C);
+    float *d = j;
+
+    if (tipo == AJUSTE_ESFERA_MAG)
+        *d++ = 1.0f;
+
+    d[0] = -1.0f * ((cal->diag[0] * A + cal->offDiag[0] * B + cal->offDiag[1] * C) / longitud);
+    d[1] = -1.0f * ((cal->offDiag[0] * A + cal->diag[1] * B + cal->offDiag[2] * C) / longitud);
+    d[2] = -1.0f * ((cal->offDiag[1] * A + cal->offDiag[2] * B + cal->diag[2] * C) / longitud);
+
+    if (tipo == AJUSTE_ELIPSE_MAG) {
+        d[3] = -1.0f * (x * A) / longitud;
+        d[4] = -1.0f * (y * B) / longitud;
+        d[5] = -1.0f * (z * C) / longitud;
+        d[6] = -1.0f * (y * A + x * B) / longitud;
+        d[7] = -1.0f * (z * A + x * C) / longitud;
+        d[8] = -1.0f * (z * B + y * C) / longitud;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         float calcularResiduoAnteriorCalMagSITL(const float *muestra, const calParamMag_t *cal)
+**  Descripcion:    Residuo de una muestra
+**  Parametros:     Muestra, parametros
+**  Retorno:        Residuo
+****************************************************************************************/
+float calcularResiduoAnteriorCalMagSITL(const float *muestra, const calParamMag_t *cal)
+{
+    const float x = muestra[0] + cal->offset[0];
+    const float y = muestra[1] + cal->offset[1];
+    const float z = muestra[2] + cal->offset[2];
+    const float A = cal->diag[0] * x + cal->offDiag[0] * y + cal->offDiag[1] * z;
+    const float B = cal->offDiag[0] * x + cal->diag[1] * y + cal->offDiag[2] * z;
+    const float C = cal->offDiag[1] * x + cal->offDiag[2] * y + cal->diag[2] * z;
+
+    return cal->radio - sqrtf(A * A + B * B + C * C);
+}
+
+
+/***************************************************************************************
+**  Nombre:         float calcularResiduoMedioAnteriorCalMagSITL(const calParamMag_t *cal)
+**  Descripcion:    Residuo medio cuadrado del buffer
+**  Parametros:     Parametros
+**  Retorno:        Residuo medio
+****************************************************************************************/
+float calcularResiduoMedioAnteriorCalMagSITL(const calParamMag_t *cal)
+{
+    float suma = 0.0f;
+
+    if (bufferCalMagSITL.cntMuestras == 0)
+        return 1.0e30f;
+
+    for (uint16_t i = 0; i < bufferCalMagSITL.cntMuestras; i++)
+        suma += sq(calcularResiduoAnteriorCalMagSITL(bufferCalMagSITL.magAcum[i], cal));
+
+    return suma / bufferCalMagSITL.cntMuestras;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void generarDatasetCalMagSITL(uint32_t indice, calParamMag_t *real)
+**  Descripcion:    Genera muestras repartidas sobre un elipsoide con ruido. La muestra
+**                  cruda es inv(M) * radio * u - offset, siendo M la matriz simetrica de
+**                  diag y offDiag y u una direccion uniforme
+**  Parametros:     Indice del conjunto, parametros con los que se ha generado
+**  Retorno:        Ninguno
+****************************************************************************************/
+void generarDatasetCalMagSITL(uint32_t indice, calParamMag_t *real)
+{
+    semillaCalMagSITL = 0x9E3779B9u * (indice + 1);
+
+    real->radio = RADIO_MIN_CAL_MAG_SITL + (RADIO_MAX_CAL_MAG_SITL - RADIO_MIN_CAL_MAG_SITL) * aleatorioCalMagSITL();
+    for (uint8_t i = 0; i < 3; i++) {
+        real->offset[i] = OFFSET_MAX_CAL_MAG_SITL * (2.0f * aleatorioCalMagSITL() - 1.0f);
+        real->diag[i] = 1.0f + DIAG_MAX_CAL_MAG_SITL * (2.0f * aleatorioCalMagSITL() - 1.0f);
+        real->offDiag[i] = OFFDIAG_MAX_CAL_MAG_SITL * (2.0f * aleatorioCalMagSITL() - 1.0f);
+    }
+
+    // Inversa de la matriz simetrica por adjuntos
+    const float a = real->diag[0], b = real->offDiag[0], c = real->offDiag[1];
+    const float d = real->diag[1], e = real->offDiag[2], f = real->diag[2];
+    const float inv[3][3] = {
+        { d * f - e * e, c * e - b * f, b * e - c * d },
+        { c * e - b * f, a * f - c * c, b * c - a * e },
+        { b * e - c * d, b * c - a * e, a * d - b * b },
+    };
+    const float det = a * inv[0][0] + b * inv[0][1] + c * inv[0][2];
+
+    bufferCalMagSITL.cntMuestras = NUM_MAX_MUESTRAS_MAG_CAL;
+    for (uint16_t n = 0; n < NUM_MAX_MUESTRAS_MAG_CAL; n++) {
+        const float z = 2.0f * aleatorioCalMagSITL() - 1.0f;
+        const float fi = 2.0f * PI * aleatorioCalMagSITL();
+        const float r = sqrtf(1.0f - z * z);
+        const float u[3] = { real->radio * r * cosf(fi), real->radio * r * sinf(fi), real->radio * z };
+
+        for (uint8_t i = 0; i < 3; i++) {
+            // Ruido aproximadamente normal con la suma de 4 uniformes
+            const float ruido = (aleatorioCalMagSITL() + aleatorioCalMagSITL() + aleatorioCalMagSITL() + aleatorioCalMagSITL() - 2.0f) *
+                                RUIDO_CAL_MAG_SITL * sqrtf(3.0f);
+
+            bufferCalMagSITL.magAcum[n][i] = (inv[i][0] * u[0] + inv[i][1] * u[1] + inv[i][2] * u[2]) / det - real->offset[i] + ruido;
+        }
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool leerDatasetCalMagSITL(const char *fichero)
+**  Descripcion:    Lee un CSV con las columnas x,y,z del magnetometro. Las lineas que no
+**                  empiezan por un numero (cabecera) se saltan. Si hay mas muestras de las
+**                  que caben en el buffer se cogen repartidas por todo el fichero
+**  Parametros:     Ruta del CSV
+**  Retorno:        True si ok
+****************************************************************************************/
+bool leerDatasetCalMagSITL(const char *fichero)
+{
+    FILE *entrada = fopen(fichero, "r");
+    char linea[TAM_LINEA_CAL_MAG_SITL];
+    float *muestras = NULL;
+    uint32_t numMuestras = 0, capacidad = 0;
+
+    if (entrada == NULL) {
+        fprintf(stderr, "No se puede abrir %s\n", fichero);
+        return false;
+    }
+
+    while (fgets(linea, sizeof(linea), entrada) != NULL) {
+        float m[3];
+
+        if (sscanf(linea, "%f ,%f ,%f", &m[0], &m[1], &m[2]) != 3)
+            continue;
+
+        if (numMuestras == capacidad) {
+            capacidad = capacidad > 0 ? 2 * capacidad : 1024;
+            float *nuevas = realloc(muestras, 3 * capacidad * sizeof(float));
+            if (nuevas == NULL) {
+                free(muestras);
+                fclose(entrada);
+                return false;
+            }
+            muestras = nuevas;
+        }
+
+        memcpy(&muestras[3 * numMuestras++], m, sizeof(m));
+    }
+
+    fclose(entrada);
+
+    if (numMuestras < 3 * NUM_PARAMETROS_ELIPSE_MAG_CAL) {
+        fprintf(stderr, "No hay muestras suficientes en %s\n", fichero);
+        free(muestras);
+        return false;
+    }
+
+    bufferCalMagSITL.cntMuestras = MIN(numMuestras, (uint32_t)NUM_MAX_MUESTRAS_MAG_CAL);
+    for (uint16_t n = 0; n < bufferCalMagSITL.cntMuestras; n++)
+        memcpy(bufferCalMagSITL.magAcum[n], &muestras[3 * (((uint64_t)n * numMuestras) / bufferCalMagSITL.cntMuestras)], 3 * sizeof(float));
+
+    free(muestras);
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         float aleatorioCalMagSITL(void)
+**  Descripcion:    Numero pseudoaleatorio reproducible
+**  Parametros:     Ninguno
+**  Retorno:        Valor en [0, 1)
+****************************************************************************************/
+float aleatorioCalMagSITL(void)
+{
+    semillaCalMagSITL = semillaCalMagSITL * 1664525u + 1013904223u;
+    return (semillaCalMagSITL >> 8) * (1.0f / 16777216.0f);
+}
+
+
+/***************************************************************************************
+**  Nombre:         float errorParametrosCalMagSITL(const calParamMag_t *a, const calParamMag_t *b)
+**  Descripcion:    Diferencia maxima entre dos calibraciones. Radio y offset relativos al
+**                  radio y la matriz en valor absoluto
+**  Parametros:     Calibraciones a comparar
+**  Retorno:        Diferencia maxima
+****************************************************************************************/
+float errorParametrosCalMagSITL(const calParamMag_t *a, const calParamMag_t *b)
+{
+    const float radio = MAX(fabsf(b->radio), 1.0f);
+    float error = fabsf(a->radio - b->radio) / radio;
+
+    for (uint8_t i = 0; i < 3; i++) {
+        error = MAX(error, fabsf(a->offset[i] - b->offset[i]) / radio);
+        error = MAX(error, fabsf(a->diag[i] - b->diag[i]));
+        error = MAX(error, fabsf(a->offDiag[i] - b->offDiag[i]));
+    }
+
+    // Un NaN tiene que dar error
+    return isnan(error) ? INFINITY : error;
+}
+
+#endif
@@ -0,0 +1,67 @@
+/***************************************************************************************
+**  calibrador_mag_sitl.h - Prueba del ajuste por tramos del calibrador del magnetometro
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __CALIBRADOR_MAG_SITL_H
+#define __CALIBRADOR_MAG_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Ajusta cada conjunto de muestras de magnetometro con el solver por tramos del
+ * calibrador y con el solver anterior, que hacia cada iteracion completa en un tick e
+ * invertia matrices de 10x10. Los dos siguen la misma secuencia de iteraciones que el
+ * calibrador (esfera, esfera y elipse). Se comprueba que los parametros coinciden y que el
+ * peor tick del solver nuevo cuesta una fraccion de la peor iteracion del anterior. Los
+ * tiempos de cada tick son el minimo de varias repeticiones para quitar el ruido del PC.
+ * Las muestras se leen de un CSV con columnas x,y,z o se generan sobre elipsoides
+ * conocidos, y en ese caso tambien se compara el offset con el real
+ */
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarCalibradorMagSITL(const char *datos);
+
+#endif // __CALIBRADOR_MAG_SITL_H
@@ -0,0 +1,284 @@
+/***************************************************************************************
+**  codificacion_blackbox_sitl.c - Prueba de ida y vuelta de la codificacion del blackbox
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "codificacion_blackbox_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <string.h>
+
+#include "Blackbox/codificacion_blackbox.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define NUM_MAX_BORDES_SITL             64
+#define NUM_CAMPOS_SITL                 (3 * CAMPOS_POR_CODIFICACION_SITL)
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static int32_t bordesSITL[NUM_MAX_BORDES_SITL];
+static uint8_t numBordesSITL;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+static inline uint32_t aleatorioCodificacionSITL(uint32_t *semilla);
+void generarBordesCodificacionSITL(void);
+uint8_t longitudVarintSITL(uint32_t valor);
+uint32_t comprobarVarintSITL(uint32_t valor);
+uint32_t probarBordesCodificacionSITL(void);
+uint32_t probarFramesCodificacionSITL(uint32_t numFrames);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool probarCodificacionBlackboxSITL(uint32_t numFrames)
+**  Descripcion:    Comprueba la ida y vuelta de los valores frontera y de frames mixtos
+**  Parametros:     Frames a codificar
+**  Retorno:        True si no hay errores
+****************************************************************************************/
+bool probarCodificacionBlackboxSITL(uint32_t numFrames)
+{
+    generarBordesCodificacionSITL();
+
+    const uint32_t errores = probarBordesCodificacionSITL() + probarFramesCodificacionSITL(numFrames);
+    return errores == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void generarBordesCodificacionSITL(void)
+**  Descripcion:    Llena la lista de valores frontera. Para cada ancho de 7, 14, 21 y 28
+**                  bits estan los que en zig-zag quedan justo a cada lado (+-2^(k-1) y sus
+**                  vecinos) y los que sin signo quedan a cada lado (2^k - 1 y 2^k)
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void generarBordesCodificacionSITL(void)
+{
+    static const uint8_t bits[] = { 7, 14, 21, 28 };
+
+    numBordesSITL = 0;
+    bordesSITL[numBordesSITL++] = 0;
+    bordesSITL[numBordesSITL++] = 1;
+    bordesSITL[numBordesSITL++] = -1;
+    bordesSITL[numBordesSITL++] = INT32_MIN;
+    bordesSITL[numBordesSITL++] = INT32_MIN + 1;
+    bordesSITL[numBordesSITL++] = INT32_MAX;
+    bordesSITL[numBordesSITL++] = INT32_MAX - 1;
+
+    for (uint8_t i = 0; i < sizeof(bits); i++) {
+        const int32_t mitad = (int32_t)1 << (bits[i] - 1);
+
+        bordesSITL[numBordesSITL++] = mitad - 1;
+        bordesSITL[numBordesSITL++] = mitad;
+        bordesSITL[numBordesSITL++] = -mitad;
+        bordesSITL[numBordesSITL++] = -mitad - 1;
+        bordesSITL[numBordesSITL++] = 2 * mitad - 1;
+        bordesSITL[numBordesSITL++] = 2 * mitad;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t longitudVarintSITL(uint32_t valor)
+**  Descripcion:    Bytes que debe ocupar un valor en varint
+**  Parametros:     Valor
+**  Retorno:        Bytes
+****************************************************************************************/
+uint8_t longitudVarintSITL(uint32_t valor)
+{
+    if (valor < (1UL << 7))
+        return 1;
+    else if (valor < (1UL << 14))
+        return 2;
+    else if (valor < (1UL << 21))
+        return 3;
+    else if (valor < (1UL << 28))
+        return 4;
+    else
+        return 5;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t comprobarVarintSITL(uint32_t valor)
+**  Descripcion:    Escribe un varint, lo lee entero y cortado un byte
+**  Parametros:     Valor
+**  Retorno:        Numero de errores
+****************************************************************************************/
+uint32_t comprobarVarintSITL(uint32_t valor)
+{
+    uint8_t buffer[MAX_BYTES_CAMPO_BLACKBOX + 1];
+    uint32_t leido = ~valor, errores = 0;
+
+    memset(buffer, 0xA5, sizeof(buffer));
+
+    const uint8_t n = escribirVarintBlackbox(buffer, valor);
+    if (n != longitudVarintSITL(valor) || buffer[MAX_BYTES_CAMPO_BLACKBOX] != 0xA5)
+        errores++;
+
+    if (leerVarintBlackbox(buffer, n, &leido) != n || leido != valor)
+        errores++;
+
+    if (leerVarintBlackbox(buffer, n - 1, &leido) != 0)
+        errores++;
+
+    return errores;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t probarBordesCodificacionSITL(void)
+**  Descripcion:    Comprueba zig-zag y varint con los valores frontera
+**  Parametros:     Ninguno
+**  Retorno:        Numero de errores
+****************************************************************************************/
+uint32_t probarBordesCodificacionSITL(void)
+{
+    uint32_t errores = 0;
+
+    for (uint8_t i = 0; i < numBordesSITL; i++) {
+        const int32_t valor = bordesSITL[i];
+        const uint32_t zigzag = zigzagBlackbox(valor);
+        const uint32_t esperado = valor >= 0 ? (uint32_t)(2 * (int64_t)valor) : (uint32_t)(-2 * (int64_t)valor - 1);
+
+        if (zigzag != esperado || deshacerZigzagBlackbox(zigzag) != valor) {
+            printf("codificacion_blackbox error=zigzag valor=%d zigzag=%u esperado=%u\n", valor, zigzag, esperado);
+            errores++;
+        }
+
+        errores += comprobarVarintSITL(zigzag) + comprobarVarintSITL((uint32_t)valor);
+    }
+
+    printf("codificacion_blackbox prueba=bordes valores=%u errores=%u\n", numBordesSITL, errores);
+    return errores;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t probarFramesCodificacionSITL(uint32_t numFrames)
+**  Descripcion:    Codifica y decodifica una secuencia de frames, con uno completo cada
+**                  INTERVALO_FRAME_I_BLACKBOX como el log. Cada frame tambien se intenta
+**                  decodificar cortado un byte, lo que debe fallar sin tocar los previos
+**  Parametros:     Frames
+**  Retorno:        Numero de errores
+****************************************************************************************/
+uint32_t probarFramesCodificacionSITL(uint32_t numFrames)
+{
+    uint8_t codificacion[NUM_CAMPOS_SITL];
+    int32_t valores[NUM_CAMPOS_SITL], previosCod[NUM_CAMPOS_SITL], previosDec[NUM_CAMPOS_SITL], copia[NUM_CAMPOS_SITL];
+    uint8_t buffer[NUM_CAMPOS_SITL * MAX_BYTES_CAMPO_BLACKBOX];
+    uint32_t errores = 0, semilla = 12345;
+    uint64_t bytes = 0;
+
+    for (uint8_t i = 0; i < NUM_CAMPOS_SITL; i++)
+        codificacion[i] = i % 3;
+
+    memset(previosCod, 0, sizeof(previosCod));
+    memset(previosDec, 0, sizeof(previosDec));
+
+    for (uint32_t f = 0; f < numFrames; f++) {
+        const bool completo = (f % INTERVALO_FRAME_I_BLACKBOX) == 0;
+
+        // La mitad de los campos llevan un valor frontera y el resto uno aleatorio de
+        // cualquier magnitud
+        for (uint8_t i = 0; i < NUM_CAMPOS_SITL; i++) {
+            const uint32_t r = aleatorioCodificacionSITL(&semilla);
+
+            if (r & 1)
+                valores[i] = bordesSITL[(r >> 1) % numBordesSITL];
+            else
+                valores[i] = (int32_t)aleatorioCodificacionSITL(&semilla) >> ((r >> 1) % 32);
+        }
+
+        const uint16_t n = codificarFrameBlackbox(buffer, codificacion, previosCod, valores, NUM_CAMPOS_SITL, completo);
+        bytes += n;
+
+        memcpy(copia, previosDec, sizeof(copia));
+        if (decodificarFrameBlackbox(buffer, n - 1, codificacion, previosDec, NUM_CAMPOS_SITL, completo) != 0 ||
+            memcmp(copia, previosDec, sizeof(copia)) != 0)
+            errores++;
+
+        if (decodificarFrameBlackbox(buffer, n, codificacion, previosDec, NUM_CAMPOS_SITL, completo) != n) {
+            errores++;
+            memcpy(previosDec, previosCod, sizeof(previosDec));
+            continue;
+        }
+
+        for (uint8_t i = 0; i < NUM_CAMPOS_SITL; i++) {
+            int32_t esperado = valores[i];
+
+            if (codificacion[i] == BLACKBOX_COD_FIJO_16 && completo)
+                esperado = esperado > INT16_MAX ? INT16_MAX : esperado < INT16_MIN ? INT16_MIN : esperado;
+            else if (codificacion[i] == BLACKBOX_COD_FIJO_16)
+                esperado = previosCod[i];
+
+            if (previosDec[i] != esperado || previosDec[i] != previosCod[i]) {
+                if (errores < 10)
+                    printf("codificacion_blackbox error=frame frame=%u campo=%u valor=%d decodificado=%d\n",
+                           f, i, valores[i], previosDec[i]);
+                errores++;
+            }
+        }
+    }
+
+    printf("codificacion_blackbox prueba=frames frames=%u campos=%u bytes=%llu errores=%u\n",
+           numFrames, NUM_CAMPOS_SITL, (unsigned long long)bytes, errores);
+    return errores;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t aleatorioCodificacionSITL(uint32_t *semilla)
+**  Descripcion:    Generador xorshift de 32 bits
+**  Parametros:     Semilla
+**  Retorno:        Numero aleatorio
+****************************************************************************************/
+static inline uint32_t aleatorioCodificacionSITL(uint32_t *semilla)
+{
+    *semilla ^= *semilla << 13;
+    *semilla ^= *semilla >> 17;
+    *semilla ^= *semilla << 5;
+    return *semilla;
+}
+
+#endif
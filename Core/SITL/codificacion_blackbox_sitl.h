@@ -0,0 +1,66 @@
+/***************************************************************************************
+**  codificacion_blackbox_sitl.h - Prueba de ida y vuelta de la codificacion del blackbox
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __CODIFICACION_BLACKBOX_SITL_H
+#define __CODIFICACION_BLACKBOX_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Pasa por zig-zag y varint los valores frontera (0, +-1, INT32_MIN, INT32_MAX y los que
+ * caen a cada lado de 7, 14, 21 y 28 bits) y comprueba el valor deshecho, la longitud y
+ * que un varint cortado no se lee. Despues codifica y decodifica frames completos y delta
+ * con campos de las tres codificaciones, mezclando esos valores con otros aleatorios: los
+ * campos varint tienen que volver exactos, los de 16 bits saturados y el decodificador
+ * tiene que acabar con los mismos valores previos que el codificador
+ */
+#define CAMPOS_POR_CODIFICACION_SITL      8
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarCodificacionBlackboxSITL(uint32_t numFrames);
+
+#endif // __CODIFICACION_BLACKBOX_SITL_H
@@ -0,0 +1,544 @@
+/***************************************************************************************
+**  cola_blackbox_sitl.c - Prueba de la cola del blackbox con una SD lenta
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "cola_blackbox_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sitl.h"
+#include "Blackbox/blackbox.h"
+#include "Blackbox/cola_blackbox.h"
+#include "Blackbox/codificacion_blackbox.h"
+#include "Comun/util.h"
+#include "Comun/matematicas.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define NUM_CAMPOS_COLA_SITL              40
+#define PERIODO_PRODUCTOR_COLA_SITL       500       // us, log a 2 kHz
+#define PERIODO_CONSUMIDOR_COLA_SITL      1000      // us entre llamadas de la tarea de vaciado
+#define INTERVALO_EVENTO_COLA_SITL        1000      // Frames entre eventos
+#define REPETICIONES_COLA_SITL            5
+#define MAX_FRAMES_COLA_SITL              1000000
+#define TAM_DECODIFICACION_COLA_SITL      (TAM_COLA_BLACKBOX + MAX_BYTES_FRAME_BLACKBOX)
+#define PERCENTIL_COLA_SITL               0.999
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    const char *nombre;
+    uint32_t tasa;                         // KB/s mientras no esta ocupada
+    uint32_t parada;                       // us ocupada
+    uint32_t bytesEntreParadas;            // 0 sin paradas
+    bool sinPerdidas;                      // Sus paradas caben en la cola
+} consumidorColaSITL_t;
+
+typedef struct {
+    uint64_t ocupadaHasta;                 // us virtuales
+    uint32_t bytesDesdeParada;
+} sdColaSITL_t;
+
+typedef struct {
+    uint8_t pendiente[TAM_DECODIFICACION_COLA_SITL];
+    uint32_t longitud;
+    int32_t previos[NUM_CAMPOS_COLA_SITL];
+    bool previosValidos;
+    int64_t ultimoFrame;
+    int64_t ultimoEvento;
+    uint32_t frames;
+    uint32_t eventos;
+    uint64_t bytes;
+    uint32_t errores;
+} decodificadorColaSITL_t;
+
+typedef struct {
+    uint32_t eventos;
+    uint32_t framesDescartados;
+    uint32_t eventosDescartados;
+    uint32_t partidos;                     // Codificados en el buffer temporal
+    uint64_t bytesPublicados;
+} resultadoColaSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static colaBlackbox_t colaSITL;
+static uint8_t bufferColaSITL[TAM_COLA_BLACKBOX];
+static uint8_t temporalColaSITL[MAX_BYTES_FRAME_BLACKBOX];
+static decodificadorColaSITL_t decodificadorColaSITL;
+static uint8_t codificacionColaSITL[NUM_CAMPOS_COLA_SITL];
+
+static const consumidorColaSITL_t consumidoresColaSITL[] = {
+    {"rapida",        4096, 0,      0,          true},
+    {"lenta",         256,  60000,  128 * 1024, true},
+    {"atascada",      256,  250000, 128 * 1024, false},
+    {"sin_escritura", 0,    0,      0,          false},
+};
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+uint32_t ejecutarColaSITL(const consumidorColaSITL_t *consumidor, uint32_t numFrames, double *ns, resultadoColaSITL_t *resultado);
+uint32_t probarDescartesColaSITL(void);
+void vaciarColaSITL(const consumidorColaSITL_t *consumidor, sdColaSITL_t *sd, uint64_t tiempo, bool todo);
+void recibirColaSITL(decodificadorColaSITL_t *dec, const uint8_t *datos, uint32_t longitud);
+uint32_t decodificarColaSITL(decodificadorColaSITL_t *dec, const uint8_t *datos, uint32_t longitud);
+void comprobarFrameColaSITL(decodificadorColaSITL_t *dec, bool completo);
+int32_t valorColaSITL(uint32_t frame, uint8_t campo);
+double percentilColaSITL(const double *ns, uint32_t num, double percentil);
+int comparaDoubleColaSITL(const void *a, const void *b);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool probarColaBlackboxSITL(uint32_t numFrames)
+**  Descripcion:    Registra los frames con cada consumidor, comprueba lo recibido y
+**                  compara el peor coste del productor
+**  Parametros:     Frames de cada prueba
+**  Retorno:        True si no hay errores y el coste del productor no depende de la SD
+****************************************************************************************/
+bool probarColaBlackboxSITL(uint32_t numFrames)
+{
+    if (numFrames == 0 || numFrames > MAX_FRAMES_COLA_SITL) {
+        fprintf(stderr, "Tiene que haber entre 1 y %u frames\n", MAX_FRAMES_COLA_SITL);
+        return false;
+    }
+
+    double *ns = malloc(numFrames * sizeof(double));
+    double *nsMin = malloc(numFrames * sizeof(double));
+    if (ns == NULL || nsMin == NULL) {
+        free(ns);
+        free(nsMin);
+        return false;
+    }
+
+    // Como el frame rapido: contadores, giro de tamanio fijo y el resto con signo
+    for (uint8_t j = 0; j < NUM_CAMPOS_COLA_SITL; j++)
+        codificacionColaSITL[j] = j < 2 ? BLACKBOX_COD_VB_SIN_SIGNO : j < 5 ? BLACKBOX_COD_FIJO_16 : BLACKBOX_COD_VB_CON_SIGNO;
+
+    bool ok = true;
+    double nsMaxReferencia = 0, nsMaxPeor = 0;
+
+    for (uint8_t c = 0; c < LONG_ARRAY(consumidoresColaSITL); c++) {
+        const consumidorColaSITL_t *consumidor = &consumidoresColaSITL[c];
+        resultadoColaSITL_t resultado;
+        uint32_t errores = 0;
+
+        // Las repeticiones son identicas: cada frame se queda con su minimo
+        for (uint8_t r = 0; r < REPETICIONES_COLA_SITL; r++) {
+            errores += ejecutarColaSITL(consumidor, numFrames, ns, &resultado);
+
+            for (uint32_t i = 0; i < numFrames; i++)
+                nsMin[i] = r == 0 ? ns[i] : MIN(nsMin[i], ns[i]);
+        }
+
+        double nsTotal = 0, nsMax = 0;
+        for (uint32_t i = 0; i < numFrames; i++) {
+            nsTotal += nsMin[i];
+            nsMax = MAX(nsMax, nsMin[i]);
+        }
+
+        const double nsPercentil = percentilColaSITL(nsMin, numFrames, PERCENTIL_COLA_SITL);
+
+        if (c == 0)
+            nsMaxReferencia = nsMax;
+        nsMaxPeor = MAX(nsMaxPeor, nsMax);
+
+        printf("cola_blackbox consumidor=%s tasa_kbs=%u parada_ms=%u frames=%u recibidos=%u descartados=%u bytes_descartados=%u "
+               "eventos=%u eventos_descartados=%u partidos=%u max_ocupados=%u tam=%u ns_medio=%.1f ns_p999=%.1f ns_max=%.1f errores=%u\n",
+               consumidor->nombre, consumidor->tasa, consumidor->parada / 1000, numFrames, decodificadorColaSITL.frames,
+               resultado.framesDescartados, colaSITL.bytesDescartados, resultado.eventos, resultado.eventosDescartados,
+               resultado.partidos, colaSITL.maxOcupados, TAM_COLA_BLACKBOX, nsTotal / numFrames, nsPercentil, nsMax, errores);
+
+        ok &= errores == 0;
+    }
+
+    const uint32_t erroresDescartes = probarDescartesColaSITL();
+
+    printf("cola_blackbox descartes_bytes_sueltos errores=%u\n", erroresDescartes);
+    ok &= erroresDescartes == 0;
+
+    const bool plano = nsMaxPeor <= FACTOR_PEOR_COLA_BLACKBOX_SITL * nsMaxReferencia;
+
+    printf("cola_blackbox ns_max_sd_rapida=%.1f ns_max_peor=%.1f relacion=%.2f plano=%u\n",
+           nsMaxReferencia, nsMaxPeor, nsMaxReferencia > 0 ? nsMaxPeor / nsMaxReferencia : 0.0, plano);
+
+    free(ns);
+    free(nsMin);
+    return ok && plano;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t ejecutarColaSITL(const consumidorColaSITL_t *consumidor, uint32_t numFrames, double *ns,
+**                                            resultadoColaSITL_t *resultado)
+**  Descripcion:    Registra los frames con un consumidor y comprueba los contadores y lo
+**                  recibido
+**  Parametros:     Consumidor, numero de frames, coste de cada frame, resultado
+**  Retorno:        Numero de errores
+****************************************************************************************/
+uint32_t ejecutarColaSITL(const consumidorColaSITL_t *consumidor, uint32_t numFrames, double *ns, resultadoColaSITL_t *resultado)
+{
+    decodificadorColaSITL_t *dec = &decodificadorColaSITL;
+    int32_t previos[NUM_CAMPOS_COLA_SITL] = {0};
+    int32_t valores[NUM_CAMPOS_COLA_SITL];
+    sdColaSITL_t sd = {0};
+    uint32_t contadorFrames = 0;
+    uint64_t tiempo = 0;
+
+    iniciarColaBlackbox(&colaSITL, bufferColaSITL, sizeof(bufferColaSITL), temporalColaSITL, sizeof(temporalColaSITL));
+    memset(resultado, 0, sizeof(resultadoColaSITL_t));
+    memset(dec, 0, sizeof(decodificadorColaSITL_t));
+    dec->ultimoFrame = -1;
+    dec->ultimoEvento = -1;
+
+    for (uint32_t k = 0; k < numFrames; k++) {
+        for (uint8_t j = 0; j < NUM_CAMPOS_COLA_SITL; j++)
+            valores[j] = valorColaSITL(k, j);
+
+        // Lo mismo que escribirFrameBlackbox
+        const bool completo = (contadorFrames % INTERVALO_FRAME_I_BLACKBOX) == 0;
+        const double inicio = tiempoRealNsSITL();
+        uint8_t *destino = reservarColaBlackbox(&colaSITL, MAX_BYTES_FRAME_BLACKBOX);
+        uint16_t longitud = 0;
+        bool escrito = false;
+
+        if (destino != NULL) {
+            destino[0] = completo ? MARCADOR_FRAME_I_BLACKBOX : MARCADOR_FRAME_P_BLACKBOX;
+            longitud = codificarFrameBlackbox(&destino[1], codificacionColaSITL, previos, valores, NUM_CAMPOS_COLA_SITL, completo) + 1;
+            escrito = publicarColaBlackbox(&colaSITL, longitud);
+        }
+
+        ns[k] = tiempoRealNsSITL() - inicio;
+
+        resultado->partidos += destino == temporalColaSITL;
+        if (escrito) {
+            resultado->bytesPublicados += longitud;
+            contadorFrames++;
+        }
+        else {
+            resultado->framesDescartados++;
+            contadorFrames = 0;
+        }
+
+        if (k % INTERVALO_EVENTO_COLA_SITL == 0) {
+            uint8_t evento[2 + 2 * MAX_BYTES_CAMPO_BLACKBOX];
+            uint8_t n = 0;
+
+            evento[n++] = MARCADOR_EVENTO_BLACKBOX;
+            evento[n++] = BLACKBOX_LOG_EVENTO_MODO;
+            n += escribirVarintBlackbox(&evento[n], k);
+            n += escribirVarintBlackbox(&evento[n], 0);
+
+            resultado->eventos++;
+            if (escribirColaBlackbox(&colaSITL, evento, n))
+                resultado->bytesPublicados += n;
+            else
+                resultado->eventosDescartados++;
+        }
+
+        tiempo += PERIODO_PRODUCTOR_COLA_SITL;
+        if (tiempo % PERIODO_CONSUMIDOR_COLA_SITL == 0)
+            vaciarColaSITL(consumidor, &sd, tiempo, false);
+    }
+
+    // Al aterrizar se vuelca lo que queda sin limite de tasa
+    vaciarColaSITL(consumidor, &sd, tiempo, true);
+
+    uint32_t errores = dec->errores;
+
+    errores += dec->longitud != 0;
+    errores += dec->frames + resultado->framesDescartados != numFrames;
+    errores += dec->eventos + resultado->eventosDescartados != resultado->eventos;
+    errores += dec->bytes != resultado->bytesPublicados;
+    errores += colaSITL.framesDescartados != resultado->framesDescartados + resultado->eventosDescartados;
+    errores += colaSITL.maxOcupados > TAM_COLA_BLACKBOX;
+    errores += consumidor->sinPerdidas && colaSITL.framesDescartados > 0;
+
+    return errores;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t probarDescartesColaSITL(void)
+**  Descripcion:    Llena la cola byte a byte como la cabecera y comprueba que los bytes
+**                  sueltos que no caben no cuentan como frames y un evento si
+**  Parametros:     Ninguno
+**  Retorno:        Numero de errores
+****************************************************************************************/
+uint32_t probarDescartesColaSITL(void)
+{
+    const uint8_t evento[3] = {MARCADOR_EVENTO_BLACKBOX, BLACKBOX_LOG_EVENTO_MODO, 0};
+    const uint8_t valor = 'H';
+    uint32_t errores = 0;
+
+    iniciarColaBlackbox(&colaSITL, bufferColaSITL, sizeof(bufferColaSITL), temporalColaSITL, sizeof(temporalColaSITL));
+
+    while (escribirBytesColaBlackbox(&colaSITL, &valor, 1))
+        ;
+
+    for (uint8_t i = 0; i < 10; i++)
+        escribirBytesColaBlackbox(&colaSITL, &valor, 1);
+
+    errores += colaSITL.framesDescartados != 0;
+    errores += colaSITL.bytesDescartados != 11;
+
+    escribirColaBlackbox(&colaSITL, evento, sizeof(evento));
+
+    errores += colaSITL.framesDescartados != 1;
+    errores += colaSITL.bytesDescartados != 11 + sizeof(evento);
+
+    return errores;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void vaciarColaSITL(const consumidorColaSITL_t *consumidor, sdColaSITL_t *sd, uint64_t tiempo,
+**                                      bool todo)
+**  Descripcion:    Tarea de vaciado: si la SD no esta ocupada saca de la cola lo que la
+**                  SD escribe en un periodo y lo pasa al decodificador
+**  Parametros:     Consumidor, estado de la SD, tiempo virtual en us, vaciar todo
+**  Retorno:        Ninguno
+****************************************************************************************/
+void vaciarColaSITL(const consumidorColaSITL_t *consumidor, sdColaSITL_t *sd, uint64_t tiempo, bool todo)
+{
+    uint32_t permitidos;
+
+    if (todo)
+        permitidos = UINT32_MAX;
+    else if (tiempo < sd->ocupadaHasta)
+        return;
+    else
+        permitidos = (uint32_t)((uint64_t)consumidor->tasa * 1024 * PERIODO_CONSUMIDOR_COLA_SITL / 1000000);
+
+    while (permitidos > 0) {
+        const uint8_t *bloque;
+        const uint32_t n = MIN(bloqueColaBlackbox(&colaSITL, &bloque), permitidos);
+
+        if (n == 0)
+            break;
+
+        recibirColaSITL(&decodificadorColaSITL, bloque, n);
+        consumirColaBlackbox(&colaSITL, n);
+        permitidos -= n;
+        sd->bytesDesdeParada += n;
+    }
+
+    if (!todo && consumidor->bytesEntreParadas > 0 && sd->bytesDesdeParada >= consumidor->bytesEntreParadas) {
+        sd->ocupadaHasta = tiempo + consumidor->parada;
+        sd->bytesDesdeParada = 0;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void recibirColaSITL(decodificadorColaSITL_t *dec, const uint8_t *datos, uint32_t longitud)
+**  Descripcion:    Anade un tramo a lo pendiente y decodifica los frames completos
+**  Parametros:     Decodificador, datos, longitud
+**  Retorno:        Ninguno
+****************************************************************************************/
+void recibirColaSITL(decodificadorColaSITL_t *dec, const uint8_t *datos, uint32_t longitud)
+{
+    dec->bytes += longitud;
+
+    while (longitud > 0) {
+        const uint32_t n = MIN(longitud, TAM_DECODIFICACION_COLA_SITL - dec->longitud);
+
+        memcpy(&dec->pendiente[dec->longitud], datos, n);
+        dec->longitud += n;
+        datos += n;
+        longitud -= n;
+
+        const uint32_t leidos = decodificarColaSITL(dec, dec->pendiente, dec->longitud);
+
+        memmove(dec->pendiente, &dec->pendiente[leidos], dec->longitud - leidos);
+        dec->longitud -= leidos;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t decodificarColaSITL(decodificadorColaSITL_t *dec, const uint8_t *datos, uint32_t longitud)
+**  Descripcion:    Decodifica frames y eventos hasta que falten bytes. Un marcador
+**                  desconocido o un frame que no se puede leer con todo su tamanio
+**                  disponible es un error
+**  Parametros:     Decodificador, datos, longitud
+**  Retorno:        Bytes leidos
+****************************************************************************************/
+uint32_t decodificarColaSITL(decodificadorColaSITL_t *dec, const uint8_t *datos, uint32_t longitud)
+{
+    uint32_t pos = 0;
+
+    while (pos < longitud) {
+        const uint8_t *p = &datos[pos];
+        const uint32_t resto = longitud - pos;
+        uint32_t leidos = 0;
+
+        if (p[0] == MARCADOR_FRAME_I_BLACKBOX || p[0] == MARCADOR_FRAME_P_BLACKBOX) {
+            const bool completo = p[0] == MARCADOR_FRAME_I_BLACKBOX;
+
+            leidos = decodificarFrameBlackbox(&p[1], resto - 1, codificacionColaSITL, dec->previos, NUM_CAMPOS_COLA_SITL, completo);
+            if (leidos > 0) {
+                comprobarFrameColaSITL(dec, completo);
+                leidos++;
+            }
+        }
+        else if (p[0] == MARCADOR_EVENTO_BLACKBOX && resto >= 2) {
+            uint32_t flags, ultimosFlags;
+            const uint8_t n1 = leerVarintBlackbox(&p[2], resto - 2, &flags);
+            const uint8_t n2 = n1 > 0 ? leerVarintBlackbox(&p[2 + n1], resto - 2 - n1, &ultimosFlags) : 0;
+
+            if (n2 > 0) {
+                dec->errores += p[1] != BLACKBOX_LOG_EVENTO_MODO || (int64_t)flags <= dec->ultimoEvento || ultimosFlags != 0;
+                dec->ultimoEvento = flags;
+                dec->eventos++;
+                leidos = 2 + n1 + n2;
+            }
+        }
+        else if (p[0] != MARCADOR_EVENTO_BLACKBOX) {
+            dec->errores++;
+            dec->previosValidos = false;
+            leidos = 1;
+        }
+
+        if (leidos == 0) {
+            if (resto < MAX_BYTES_FRAME_BLACKBOX)
+                break;
+
+            // Con todo el frame disponible no se puede leer: se salta el marcador
+            dec->errores++;
+            dec->previosValidos = false;
+            leidos = 1;
+        }
+
+        pos += leidos;
+    }
+
+    return pos;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void comprobarFrameColaSITL(decodificadorColaSITL_t *dec, bool completo)
+**  Descripcion:    Comprueba los valores decodificados con los generados. Un P tiene
+**                  que ir justo detras del frame anterior
+**  Parametros:     Decodificador con los valores en previos, frame completo o delta
+**  Retorno:        Ninguno
+****************************************************************************************/
+void comprobarFrameColaSITL(decodificadorColaSITL_t *dec, bool completo)
+{
+    const int64_t frame = (uint32_t)dec->previos[0];
+    bool ok = frame > dec->ultimoFrame && (completo || (dec->previosValidos && frame == dec->ultimoFrame + 1));
+
+    for (uint8_t j = 0; j < NUM_CAMPOS_COLA_SITL && ok; j++)
+        ok = dec->previos[j] == valorColaSITL((uint32_t)frame, j);
+
+    dec->errores += !ok;
+    dec->previosValidos = ok;
+    dec->ultimoFrame = frame;
+    dec->frames++;
+}
+
+
+/***************************************************************************************
+**  Nombre:         int32_t valorColaSITL(uint32_t frame, uint8_t campo)
+**  Descripcion:    Valor de un campo en un frame: la iteracion, el tiempo, el giro
+**                  acotado a 16 bits y el resto con amplitudes distintas para que el
+**                  tamanio del frame varie
+**  Parametros:     Frame, campo
+**  Retorno:        Valor
+****************************************************************************************/
+int32_t valorColaSITL(uint32_t frame, uint8_t campo)
+{
+    uint32_t h = frame * 0x9E3779B1u ^ (campo + 1u) * 0x85EBCA6Bu;
+
+    h ^= h >> 16;
+    h *= 0x7FEB352Du;
+    h ^= h >> 15;
+    h *= 0x846CA68Bu;
+    h ^= h >> 16;
+
+    if (campo == 0)
+        return (int32_t)frame;
+    else if (campo == 1)
+        return (int32_t)(frame * PERIODO_PRODUCTOR_COLA_SITL);
+    else if (campo < 5)
+        return (int32_t)(h % 4001) - 2000;
+
+    const uint32_t amplitud = 1u << (2 + campo % 16);
+    return (int32_t)(h & (amplitud - 1)) - (int32_t)(amplitud / 2);
+}
+
+
+/***************************************************************************************
+**  Nombre:         double percentilColaSITL(const double *ns, uint32_t num, double percentil)
+**  Descripcion:    Calcula un percentil ordenando una copia
+**  Parametros:     Tiempos, numero de tiempos, percentil en tanto por uno
+**  Retorno:        Tiempo del percentil
+****************************************************************************************/
+double percentilColaSITL(const double *ns, uint32_t num, double percentil)
+{
+    double *copia = malloc(num * sizeof(double));
+
+    if (copia == NULL)
+        return 0;
+
+    memcpy(copia, ns, num * sizeof(double));
+    qsort(copia, num, sizeof(double), comparaDoubleColaSITL);
+
+    const double valor = copia[(uint32_t)(percentil * (num - 1))];
+    free(copia);
+    return valor;
+}
+
+
+/***************************************************************************************
+**  Nombre:         int comparaDoubleColaSITL(const void *a, const void *b)
+**  Descripcion:    Comparacion para qsort
+**  Parametros:     Elementos a comparar
+**  Retorno:        Orden
+****************************************************************************************/
+int comparaDoubleColaSITL(const void *a, const void *b)
+{
+    const double x = *(const double *)a, y = *(const double *)b;
+
+    return (x > y) - (x < y);
+}
+
+#endif
@@ -0,0 +1,73 @@
+/***************************************************************************************
+**  cola_blackbox_sitl.h - Prueba de la cola del blackbox con una SD lenta
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __COLA_BLACKBOX_SITL_H
+#define __COLA_BLACKBOX_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * El productor codifica frames de 40 campos a 2 kHz de tiempo virtual directamente en la
+ * cola, como escribirLogRapidoBlackbox, con un evento copiado cada 1000 frames. El
+ * consumidor es una SD simulada que se vacia cada ms a su tasa y se queda ocupada un
+ * tiempo cada cierto numero de bytes. Se prueba con una SD rapida, una lenta con paradas
+ * que caben en la cola, una con paradas que no caben y una que no escribe nada. Todo lo
+ * que sale de la cola se decodifica y se compara con lo generado.
+ *
+ * El coste de cada frame en el productor (reserva, codificacion y publicacion) es el
+ * minimo de varias repeticiones identicas para quitar el ruido del PC. Se exige que su
+ * peor caso con cualquier consumidor no pase de FACTOR_PEOR_COLA_BLACKBOX_SITL veces el de
+ * la SD rapida, que no se pierda nada mientras las paradas quepan en la cola y que los
+ * descartes se cuenten enteros. Aparte se comprueba que los bytes sueltos de la cabecera
+ * que no caben no cuentan como frames descartados
+ */
+#define FACTOR_PEOR_COLA_BLACKBOX_SITL    2.0
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarColaBlackboxSITL(uint32_t numFrames);
+
+#endif // __COLA_BLACKBOX_SITL_H
@@ -0,0 +1,165 @@
+/***************************************************************************************
+**  crc_sitl.c - Prueba y medida de las versiones del CRC16 en el PC
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "crc_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+
+#include "sitl.h"
+#include "Comun/crc.h"
+#include "Comun/matematicas.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define LONGITUD_MAX_PRUEBA_CRC_SITL       300     // Longitudes comprobadas exhaustivamente
+#define ALINEACIONES_PRUEBA_CRC_SITL       8
+#define TAM_BUFFER_CRC_SITL                16384   // Orden del tamanio de la configuracion en flash
+#define CRC_VECTOR_CCITT_SITL              0x29B1  // CRC-CCITT(0xFFFF) de "123456789"
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef uint16_t (*fnCRC16SITL_t)(uint16_t crc, const void *dato, uint32_t longitud);
+
+typedef struct {
+    const char *nombre;
+    fnCRC16SITL_t fn;
+} versionCRC16SITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static const versionCRC16SITL_t versionesCRC16SITL[] = {
+    { "bit",    calcularCRC16Bit },
+    { "tabla",  calcularCRC16Tabla },
+    { "slice",  calcularCRC16Slice },
+    { "api",    calcularCRC16 },
+};
+
+static uint8_t bufferCRC16SITL[TAM_BUFFER_CRC_SITL + ALINEACIONES_PRUEBA_CRC_SITL];
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+uint32_t aleatorioCRC16SITL(uint32_t *semilla);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool probarCRC16SITL(uint32_t kilobytes)
+**  Descripcion:    Compara todas las versiones con la version bit a bit y mide su caudal
+**  Parametros:     Kilobytes a procesar con cada version en la medida
+**  Retorno:        True si todas las versiones coinciden
+****************************************************************************************/
+bool probarCRC16SITL(uint32_t kilobytes)
+{
+    const uint8_t numVersiones = sizeof(versionesCRC16SITL) / sizeof(versionesCRC16SITL[0]);
+    uint32_t semilla = 1;
+    uint32_t errores = 0;
+    uint32_t pruebas = 0;
+
+    for (uint32_t i = 0; i < sizeof(bufferCRC16SITL); i++)
+        bufferCRC16SITL[i] = aleatorioCRC16SITL(&semilla);
+
+    // Vector conocido
+    if (calcularCRC16Bit(0xFFFF, "123456789", 9) != CRC_VECTOR_CCITT_SITL)
+        errores++;
+
+    // Todas las longitudes y alineaciones, con valores iniciales aleatorios
+    for (uint32_t longitud = 0; longitud <= LONGITUD_MAX_PRUEBA_CRC_SITL; longitud++) {
+        for (uint8_t alineacion = 0; alineacion < ALINEACIONES_PRUEBA_CRC_SITL; alineacion++) {
+            const uint16_t inicial = aleatorioCRC16SITL(&semilla);
+            const uint8_t *dato = &bufferCRC16SITL[alineacion];
+            const uint16_t referencia = calcularCRC16Bit(inicial, dato, longitud);
+
+            for (uint8_t v = 1; v < numVersiones; v++) {
+                if (versionesCRC16SITL[v].fn(inicial, dato, longitud) != referencia)
+                    errores++;
+                pruebas++;
+            }
+        }
+    }
+
+    // Encadenar llamadas debe dar lo mismo que una sola, como hace la escritura de la configuracion
+    const uint16_t completo = calcularCRC16Bit(0, bufferCRC16SITL, TAM_BUFFER_CRC_SITL);
+    uint16_t encadenado = 0;
+    for (uint32_t i = 0, trozo = 1; i < TAM_BUFFER_CRC_SITL; i += trozo, trozo = trozo % 61 + 1)
+        encadenado = calcularCRC16(encadenado, &bufferCRC16SITL[i], MIN(trozo, TAM_BUFFER_CRC_SITL - i));
+    if (encadenado != completo)
+        errores++;
+
+    printf("crc16 bytes_por_paso=%u pruebas=%u errores=%u\n", CRC16_BYTES_POR_PASO, pruebas + 2, errores);
+
+    // Caudal
+    const uint32_t repeticiones = kilobytes * 1024 / TAM_BUFFER_CRC_SITL + 1;
+    for (uint8_t v = 0; v < numVersiones; v++) {
+        double inicio, fin;
+        volatile uint16_t crc = 0;
+
+        inicio = tiempoRealNsSITL();
+        for (uint32_t r = 0; r < repeticiones; r++)
+            crc = versionesCRC16SITL[v].fn(crc, bufferCRC16SITL, TAM_BUFFER_CRC_SITL);
+        fin = tiempoRealNsSITL();
+
+        const double s = (fin - inicio) * 1e-9;
+        const double bytes = (double)repeticiones * TAM_BUFFER_CRC_SITL;
+        printf("crc16 version=%s mb_s=%.1f ns_byte=%.3f\n", versionesCRC16SITL[v].nombre, s > 0 ? bytes / s / 1e6 : 0.0,
+               bytes > 0 ? s * 1e9 / bytes : 0.0);
+    }
+
+    return errores == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t aleatorioCRC16SITL(uint32_t *semilla)
+**  Descripcion:    Generador xorshift para que la prueba sea reproducible
+**  Parametros:     Estado del generador
+**  Retorno:        Numero aleatorio
+****************************************************************************************/
+uint32_t aleatorioCRC16SITL(uint32_t *semilla)
+{
+    uint32_t x = *semilla;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *semilla = x;
+    return x;
+}
+
+#endif
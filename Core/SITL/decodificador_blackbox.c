@@ -0,0 +1,527 @@
+/***************************************************************************************
+**  decodificador_blackbox.c - Conversion de los logs binarios de la blackbox a CSV
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "decodificador_blackbox.h"
+
+#if defined(SITL)
+#include <stdlib.h>
+#include <string.h>
+
+#include "Blackbox/blackbox.h"
+#include "Blackbox/codificacion_blackbox.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define NUM_MAX_DEFS_DECODIFICADOR        64
+#define TAM_NOMBRE_DECODIFICADOR          24
+#define TAM_COLUMNA_DECODIFICADOR         (TAM_NOMBRE_DECODIFICADOR + 4)
+#define TAM_LINEA_DECODIFICADOR           1024
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    // Definicion de la cabecera
+    uint8_t numDefs;
+    uint8_t numDrivers;
+    uint8_t numCodificaciones;
+    uint8_t numEscalas;
+    char nombre[NUM_MAX_DEFS_DECODIFICADOR][TAM_NOMBRE_DECODIFICADOR];
+    uint8_t drivers[NUM_MAX_DEFS_DECODIFICADOR];
+    uint8_t codificacionDef[NUM_MAX_DEFS_DECODIFICADOR];
+    uint32_t escalaDef[NUM_MAX_DEFS_DECODIFICADOR];
+
+    // Campos expandidos con sus drivers
+    uint8_t numCampos;
+    char columna[NUM_MAX_CAMPOS_BLACKBOX][TAM_COLUMNA_DECODIFICADOR];
+    uint8_t codificacion[NUM_MAX_CAMPOS_BLACKBOX];
+    uint32_t escala[NUM_MAX_CAMPOS_BLACKBOX];
+    int32_t valores[NUM_MAX_CAMPOS_BLACKBOX];
+    bool valido;
+} frameDecodificador_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static frameDecodificador_t frameRapidoDecodificador;
+static frameDecodificador_t frameLentoDecodificador;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void leerLineaCabeceraDecodificador(const char *linea);
+uint8_t leerListaCabeceraDecodificador(const char *lista, frameDecodificador_t *frame, uint8_t tipo);
+bool expandirCamposDecodificador(frameDecodificador_t *frame);
+void escribirCabeceraCSVdecodificador(FILE *salida);
+void escribirFilaCSVdecodificador(FILE *salida);
+void escribirValorCSVdecodificador(FILE *salida, int32_t valor, uint8_t codificacion, uint32_t escala);
+uint32_t saltarEventoDecodificador(const uint8_t *buffer, uint32_t longitud, bool *fin);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool convertirLogBlackboxCSV(const char *fichero, FILE *salida)
+**  Descripcion:    Lee un log de la blackbox y lo escribe en CSV
+**  Parametros:     Ruta del log, fichero de salida
+**  Retorno:        True si ok
+****************************************************************************************/
+bool convertirLogBlackboxCSV(const char *fichero, FILE *salida)
+{
+    FILE *entrada = fopen(fichero, "rb");
+    resultadoDecodificacionBlackbox_t resultado;
+
+    if (entrada == NULL) {
+        fprintf(stderr, "No se puede abrir %s\n", fichero);
+        return false;
+    }
+
+    fseek(entrada, 0, SEEK_END);
+    const long longitud = ftell(entrada);
+    fseek(entrada, 0, SEEK_SET);
+
+    uint8_t *log = malloc(longitud > 0 ? longitud : 1);
+    if (log == NULL || fread(log, 1, longitud, entrada) != (size_t)longitud) {
+        fprintf(stderr, "No se puede leer %s\n", fichero);
+        fclose(entrada);
+        free(log);
+        return false;
+    }
+
+    fclose(entrada);
+
+    const bool ok = decodificarLogBlackbox(log, longitud, salida, &resultado);
+    free(log);
+
+    fprintf(stderr, "blackbox frames_I=%u frames_P=%u frames_lentos=%u eventos=%u frames_descartados=%u bytes_corruptos=%u\n",
+            resultado.framesI, resultado.framesP, resultado.framesLentos, resultado.eventos,
+            resultado.framesDescartados, resultado.bytesCorruptos);
+
+    return ok;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool decodificarLogBlackbox(const uint8_t *log, uint32_t longitud, FILE *salida,
+**                                              resultadoDecodificacionBlackbox_t *resultado)
+**  Descripcion:    Lee la cabecera de texto y decodifica los frames binarios
+**  Parametros:     Contenido del log, longitud, fichero de salida, resultado
+**  Retorno:        True si la cabecera es valida
+****************************************************************************************/
+bool decodificarLogBlackbox(const uint8_t *log, uint32_t longitud, FILE *salida, resultadoDecodificacionBlackbox_t *resultado)
+{
+    uint32_t pos = 0;
+
+    memset(resultado, 0, sizeof(*resultado));
+    memset(&frameRapidoDecodificador, 0, sizeof(frameRapidoDecodificador));
+    memset(&frameLentoDecodificador, 0, sizeof(frameLentoDecodificador));
+
+    // Cabecera: lineas de texto que empiezan por 'C'
+    while (pos < longitud && log[pos] == 'C') {
+        char linea[TAM_LINEA_DECODIFICADOR];
+        uint32_t n = 0;
+
+        while (pos < longitud && log[pos] != '\n') {
+            if (n < sizeof(linea) - 1)
+                linea[n++] = log[pos];
+
+            pos++;
+        }
+
+        linea[n] = '\0';
+        pos++;
+        leerLineaCabeceraDecodificador(linea);
+    }
+
+    if (frameRapidoDecodificador.numDefs == 0 || !expandirCamposDecodificador(&frameRapidoDecodificador) ||
+        !expandirCamposDecodificador(&frameLentoDecodificador)) {
+        fprintf(stderr, "Cabecera de la blackbox no valida\n");
+        return false;
+    }
+
+    escribirCabeceraCSVdecodificador(salida);
+
+    while (pos < longitud) {
+        const uint8_t marcador = log[pos];
+        const uint8_t *datos = &log[pos + 1];
+        const uint32_t disponibles = longitud - pos - 1;
+        uint32_t leidos = 0;
+        bool fin = false;
+
+        switch (marcador) {
+            case MARCADOR_FRAME_I_BLACKBOX:
+                leidos = decodificarFrameBlackbox(datos, disponibles, frameRapidoDecodificador.codificacion,
+                                                  frameRapidoDecodificador.valores, frameRapidoDecodificador.numCampos, true);
+                if (leidos > 0) {
+                    frameRapidoDecodificador.valido = true;
+                    resultado->framesI++;
+                    escribirFilaCSVdecodificador(salida);
+                }
+                break;
+
+            case MARCADOR_FRAME_P_BLACKBOX:
+                if (frameRapidoDecodificador.valido) {
+                    leidos = decodificarFrameBlackbox(datos, disponibles, frameRapidoDecodificador.codificacion,
+                                                      frameRapidoDecodificador.valores, frameRapidoDecodificador.numCampos, false);
+                    if (leidos > 0) {
+                        resultado->framesP++;
+                        escribirFilaCSVdecodificador(salida);
+                    }
+                }
+                else {
+                    // Sin un frame completo antes solo se puede saltar
+                    int32_t descartados[NUM_MAX_CAMPOS_BLACKBOX] = { 0 };
+
+                    leidos = decodificarFrameBlackbox(datos, disponibles, frameRapidoDecodificador.codificacion, descartados,
+                                                      frameRapidoDecodificador.numCampos, false);
+                    if (leidos > 0)
+                        resultado->framesDescartados++;
+                }
+                break;
+
+            case MARCADOR_FRAME_LENTO_BLACKBOX:
+                leidos = decodificarFrameBlackbox(datos, disponibles, frameLentoDecodificador.codificacion,
+                                                  frameLentoDecodificador.valores, frameLentoDecodificador.numCampos, true);
+                if (leidos > 0) {
+                    frameLentoDecodificador.valido = true;
+                    resultado->framesLentos++;
+                }
+                break;
+
+            case MARCADOR_EVENTO_BLACKBOX:
+                leidos = saltarEventoDecodificador(datos, disponibles, &fin);
+                if (leidos > 0)
+                    resultado->eventos++;
+                break;
+
+            default:
+                break;
+        }
+
+        if (fin)
+            break;
+
+        // Marcador desconocido o frame incompleto: se avanza un byte y se espera al siguiente I
+        if (leidos == 0) {
+            resultado->bytesCorruptos++;
+            frameRapidoDecodificador.valido = false;
+            pos++;
+        }
+        else
+            pos += 1 + leidos;
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void leerLineaCabeceraDecodificador(const char *linea)
+**  Descripcion:    Interpreta las lineas "C Campo x tipo:a,b,c" de la cabecera. El resto
+**                  de lineas son informativas
+**  Parametros:     Linea sin el salto de linea
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerLineaCabeceraDecodificador(const char *linea)
+{
+    static const char *const tipos[] = { "nombre", "drivers", "codificacion", "escala" };
+    frameDecodificador_t *frame;
+
+    if (strncmp(linea, "C Campo ", 8) != 0)
+        return;
+
+    if (linea[8] == 'R')
+        frame = &frameRapidoDecodificador;
+    else if (linea[8] == 'L')
+        frame = &frameLentoDecodificador;
+    else
+        return;
+
+    const char *tipo = &linea[10];
+    const char *lista = strchr(tipo, ':');
+    if (lista == NULL)
+        return;
+
+    for (uint8_t i = 0; i < sizeof(tipos) / sizeof(tipos[0]); i++) {
+        if ((size_t)(lista - tipo) == strlen(tipos[i]) && strncmp(tipo, tipos[i], strlen(tipos[i])) == 0) {
+            const uint8_t num = leerListaCabeceraDecodificador(lista + 1, frame, i);
+
+            switch (i) {
+                case 0:
+                    frame->numDefs = num;
+                    break;
+
+                case 1:
+                    frame->numDrivers = num;
+                    break;
+
+                case 2:
+                    frame->numCodificaciones = num;
+                    break;
+
+                default:
+                    frame->numEscalas = num;
+                    break;
+            }
+        }
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t leerListaCabeceraDecodificador(const char *lista, frameDecodificador_t *frame, uint8_t tipo)
+**  Descripcion:    Lee una lista separada por comas de la cabecera
+**  Parametros:     Lista, frame, tipo de lista (nombre, drivers, codificacion, escala)
+**  Retorno:        Numero de elementos
+****************************************************************************************/
+uint8_t leerListaCabeceraDecodificador(const char *lista, frameDecodificador_t *frame, uint8_t tipo)
+{
+    uint8_t num = 0;
+
+    while (*lista != '\0' && num < NUM_MAX_DEFS_DECODIFICADOR) {
+        const char *fin = strchr(lista, ',');
+        const size_t longitud = fin != NULL ? (size_t)(fin - lista) : strlen(lista);
+
+        switch (tipo) {
+            case 0: {
+                const size_t copia = longitud < TAM_NOMBRE_DECODIFICADOR - 1 ? longitud : TAM_NOMBRE_DECODIFICADOR - 1;
+
+                memcpy(frame->nombre[num], lista, copia);
+                frame->nombre[num][copia] = '\0';
+                break;
+            }
+
+            case 1:
+                frame->drivers[num] = strtoul(lista, NULL, 10);
+                break;
+
+            case 2:
+                frame->codificacionDef[num] = strtoul(lista, NULL, 10);
+                break;
+
+            default:
+                frame->escalaDef[num] = strtoul(lista, NULL, 10);
+                break;
+        }
+
+        num++;
+        if (fin == NULL)
+            break;
+
+        lista = fin + 1;
+    }
+
+    return num;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool expandirCamposDecodificador(frameDecodificador_t *frame)
+**  Descripcion:    Crea una columna por cada driver de cada campo, en el orden del frame.
+**                  Con varios drivers el indice se anade al nombre: giro0[0], giro1[0]...
+**  Parametros:     Frame
+**  Retorno:        True si las listas de la cabecera son coherentes
+****************************************************************************************/
+bool expandirCamposDecodificador(frameDecodificador_t *frame)
+{
+    if (frame->numDrivers != frame->numDefs || frame->numCodificaciones != frame->numDefs || frame->numEscalas != frame->numDefs)
+        return false;
+
+    frame->numCampos = 0;
+
+    for (uint8_t i = 0; i < frame->numDefs; i++) {
+        for (uint8_t j = 0; j < frame->drivers[i]; j++) {
+            if (frame->numCampos >= NUM_MAX_CAMPOS_BLACKBOX || frame->codificacionDef[i] > BLACKBOX_COD_FIJO_16)
+                return false;
+
+            char columna[TAM_COLUMNA_DECODIFICADOR];
+            const char *corchete = strchr(frame->nombre[i], '[');
+
+            if (frame->drivers[i] == 1)
+                snprintf(columna, TAM_COLUMNA_DECODIFICADOR, "%s", frame->nombre[i]);
+            else if (corchete == NULL)
+                snprintf(columna, TAM_COLUMNA_DECODIFICADOR, "%s%u", frame->nombre[i], j);
+            else
+                snprintf(columna, TAM_COLUMNA_DECODIFICADOR, "%.*s%u%s", (int)(corchete - frame->nombre[i]), frame->nombre[i], j, corchete);
+
+            memcpy(frame->columna[frame->numCampos], columna, sizeof(columna));
+            frame->codificacion[frame->numCampos] = frame->codificacionDef[i];
+            frame->escala[frame->numCampos] = frame->escalaDef[i] > 0 ? frame->escalaDef[i] : 1;
+            frame->numCampos++;
+        }
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void escribirCabeceraCSVdecodificador(FILE *salida)
+**  Descripcion:    Escribe la fila con los nombres de las columnas
+**  Parametros:     Fichero de salida
+**  Retorno:        Ninguno
+****************************************************************************************/
+void escribirCabeceraCSVdecodificador(FILE *salida)
+{
+    const frameDecodificador_t *frames[] = { &frameRapidoDecodificador, &frameLentoDecodificador };
+    bool necesitaComa = false;
+
+    for (uint8_t f = 0; f < 2; f++) {
+        for (uint8_t i = 0; i < frames[f]->numCampos; i++) {
+            fprintf(salida, "%s%s", necesitaComa ? "," : "", frames[f]->columna[i]);
+            necesitaComa = true;
+        }
+    }
+
+    fputc('\n', salida);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void escribirFilaCSVdecodificador(FILE *salida)
+**  Descripcion:    Escribe el frame rapido actual junto al ultimo frame lento
+**  Parametros:     Fichero de salida
+**  Retorno:        Ninguno
+****************************************************************************************/
+void escribirFilaCSVdecodificador(FILE *salida)
+{
+    const frameDecodificador_t *rapido = &frameRapidoDecodificador;
+    const frameDecodificador_t *lento = &frameLentoDecodificador;
+
+    for (uint8_t i = 0; i < rapido->numCampos; i++) {
+        if (i > 0)
+            fputc(',', salida);
+
+        escribirValorCSVdecodificador(salida, rapido->valores[i], rapido->codificacion[i], rapido->escala[i]);
+    }
+
+    for (uint8_t i = 0; i < lento->numCampos; i++) {
+        if (rapido->numCampos > 0 || i > 0)
+            fputc(',', salida);
+
+        if (lento->valido)
+            escribirValorCSVdecodificador(salida, lento->valores[i], lento->codificacion[i], lento->escala[i]);
+    }
+
+    fputc('\n', salida);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void escribirValorCSVdecodificador(FILE *salida, int32_t valor, uint8_t codificacion, uint32_t escala)
+**  Descripcion:    Escribe un valor dividido por su escala. Con escalas potencia de 10 se
+**                  usan tantos decimales como ceros tenga la escala
+**  Parametros:     Fichero de salida, valor entero, codificacion, escala
+**  Retorno:        Ninguno
+****************************************************************************************/
+void escribirValorCSVdecodificador(FILE *salida, int32_t valor, uint8_t codificacion, uint32_t escala)
+{
+    if (codificacion == BLACKBOX_COD_VB_SIN_SIGNO && escala == 1) {
+        fprintf(salida, "%lu", (unsigned long)(uint32_t)valor);
+        return;
+    }
+
+    if (escala == 1) {
+        fprintf(salida, "%ld", (long)valor);
+        return;
+    }
+
+    int decimales = 0;
+    uint32_t e = escala;
+
+    while (e % 10 == 0) {
+        e /= 10;
+        decimales++;
+    }
+
+    if (e == 1)
+        fprintf(salida, "%.*f", decimales, (double)valor / escala);
+    else
+        fprintf(salida, "%.6g", (double)valor / escala);
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t saltarEventoDecodificador(const uint8_t *buffer, uint32_t longitud, bool *fin)
+**  Descripcion:    Lee un evento. El de fin de log termina la decodificacion
+**  Parametros:     Buffer sin el marcador, bytes disponibles, fin del log
+**  Retorno:        Bytes leidos. 0 si el evento esta incompleto o no existe
+****************************************************************************************/
+uint32_t saltarEventoDecodificador(const uint8_t *buffer, uint32_t longitud, bool *fin)
+{
+    uint32_t n = 1;
+    uint8_t numDatos;
+
+    if (longitud < 1)
+        return 0;
+
+    switch (buffer[0]) {
+        case BLACKBOX_LOG_EVENTO_DESARMAR:
+            numDatos = 1;
+            break;
+
+        case BLACKBOX_LOG_EVENTO_MODO:
+        case BLACKBOX_LOG_EVENTO_LOG_REANUDAR:
+            numDatos = 2;
+            break;
+
+        case BLACKBOX_LOG_EVENTO_LOG_FIN:
+            while (n < longitud && buffer[n] != 0)
+                n++;
+
+            *fin = true;
+            return n;
+
+        default:
+            return 0;
+    }
+
+    for (uint8_t i = 0; i < numDatos; i++) {
+        uint32_t dato;
+        const uint8_t leidos = leerVarintBlackbox(&buffer[n], longitud - n, &dato);
+
+        if (leidos == 0)
+            return 0;
+
+        n += leidos;
+    }
+
+    // Tras reanudar el log el primer frame rapido es completo
+    if (buffer[0] == BLACKBOX_LOG_EVENTO_LOG_REANUDAR)
+        frameRapidoDecodificador.valido = false;
+
+    return n;
+}
+
+#endif
@@ -0,0 +1,73 @@
+/***************************************************************************************
+**  decodificador_blackbox.h - Conversion de los logs binarios de la blackbox a CSV
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __DECODIFICADOR_BLACKBOX_H
+#define __DECODIFICADOR_BLACKBOX_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Lee un fichero LOGxxxxx.URP (formato en Blackbox/codificacion_blackbox.h) y escribe
+ * una fila CSV por cada frame rapido con los valores ya divididos por su escala. Las
+ * columnas del frame lento se anaden al final con el ultimo valor recibido. Si el log
+ * tiene bytes corruptos se descartan los frames delta hasta el siguiente frame completo
+ */
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    uint32_t framesI;
+    uint32_t framesP;
+    uint32_t framesLentos;
+    uint32_t eventos;
+    uint32_t framesDescartados;
+    uint32_t bytesCorruptos;
+} resultadoDecodificacionBlackbox_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool decodificarLogBlackbox(const uint8_t *log, uint32_t longitud, FILE *salida, resultadoDecodificacionBlackbox_t *resultado);
+bool convertirLogBlackboxCSV(const char *fichero, FILE *salida);
+
+#endif // __DECODIFICADOR_BLACKBOX_H
@@ -0,0 +1,593 @@
+/***************************************************************************************
+**  decodificador_telemetria.c - Decodificador y grabador de la telemetria por USB
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "decodificador_telemetria.h"
+
+#if defined(SITL)
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <termios.h>
+#include <sys/stat.h>
+
+#include "sitl.h"
+#include "Comun/crc.h"
+#include "GP/gp_telemetria.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define SUSCRIPCION_DEFECTO_SITL          "todos:2,giro:1,acel:1,actitud:5,baro:50"
+#define TOLERANCIA_MUESTRAS_SITL          0.02
+#define TAM_LECTURA_DECODIFICADOR         4096
+#define TAM_SUSCRIPCION_DECODIFICADOR     256
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static decodificadorTelemetria_t decodificadorTelemetria;
+static volatile sig_atomic_t pararGrabacionTelemetria;
+static int puertoTelemetria = -1;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void procesarTramaDecodificador(decodificadorTelemetria_t *dec, const cabeceraTelemetria_t *cabecera, const uint8_t *carga);
+void leerEsquemaDecodificador(decodificadorTelemetria_t *dec, const cabeceraTelemetria_t *cabecera, const uint8_t *carga);
+void leerDatosDecodificador(decodificadorTelemetria_t *dec, const cabeceraTelemetria_t *cabecera, const uint8_t *carga);
+void enviarSuscripcionDecodificador(decodificadorTelemetria_t *dec);
+void escribirCabeceraCSVtelemetria(decodificadorTelemetria_t *dec);
+void mostrarResumenTelemetria(const decodificadorTelemetria_t *dec, FILE *salida);
+void enviarPuertoTelemetria(const uint8_t *dato, uint32_t longitud);
+void senalGrabacionTelemetria(int senal);
+void capturarUSBtelemetriaSITL(const uint8_t *dato, uint32_t longitud);
+void inyectarUSBtelemetriaSITL(const uint8_t *dato, uint32_t longitud);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         void iniciarDecodificadorTelemetria(decodificadorTelemetria_t *dec, const char *suscripcion,
+**                                                      enviarDecodificadorTelemetria_t enviar, FILE *salida)
+**  Descripcion:    Inicia el decodificador
+**  Parametros:     Decodificador, suscripcion a mandar con el primer esquema (NULL ninguna),
+**                  funcion para mandar los comandos, salida CSV (NULL sin salida)
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarDecodificadorTelemetria(decodificadorTelemetria_t *dec, const char *suscripcion,
+                                    enviarDecodificadorTelemetria_t enviar, FILE *salida)
+{
+    memset(dec, 0, sizeof(*dec));
+    dec->suscripcion = suscripcion;
+    dec->enviar = enviar;
+    dec->salida = salida;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void decodificarTelemetria(decodificadorTelemetria_t *dec, const uint8_t *dato, uint32_t longitud)
+**  Descripcion:    Busca tramas completas en los bytes recibidos. Si la cabecera o el CRC
+**                  no son validos se avanza un byte y se vuelve a buscar el sincronismo
+**  Parametros:     Decodificador, datos recibidos, longitud
+**  Retorno:        Ninguno
+****************************************************************************************/
+void decodificarTelemetria(decodificadorTelemetria_t *dec, const uint8_t *dato, uint32_t longitud)
+{
+    while (longitud > 0) {
+        // Siempre cabe una trama completa detras de lo pendiente
+        uint32_t n = sizeof(dec->entrada) - dec->indice;
+        if (n > longitud)
+            n = longitud;
+
+        memcpy(&dec->entrada[dec->indice], dato, n);
+        dec->indice += n;
+        dato += n;
+        longitud -= n;
+
+        uint32_t pos = 0;
+        while (dec->indice - pos >= TAM_CABECERA_TELEMETRIA + TAM_CRC_TELEMETRIA) {
+            const uint8_t *trama = &dec->entrada[pos];
+            cabeceraTelemetria_t cabecera;
+
+            memcpy(&cabecera, trama, sizeof(cabecera));
+            if (cabecera.sincronismo[0] != SINCRONISMO_1_TELEMETRIA || cabecera.sincronismo[1] != SINCRONISMO_2_TELEMETRIA ||
+                cabecera.version != VERSION_TELEMETRIA || cabecera.longitud > TAM_MAX_CARGA_TELEMETRIA) {
+                dec->bytesDescartados++;
+                pos++;
+                continue;
+            }
+
+            const uint32_t tam = TAM_CABECERA_TELEMETRIA + cabecera.longitud;
+            if (dec->indice - pos < tam + TAM_CRC_TELEMETRIA)
+                break;
+
+            const uint16_t crc = trama[tam] | (trama[tam + 1] << 8);
+            if (calcularCRC16(VALOR_INICIO_CRC_TELEMETRIA, trama, tam) != crc) {
+                dec->erroresCRC++;
+                dec->bytesDescartados++;
+                pos++;
+                continue;
+            }
+
+            procesarTramaDecodificador(dec, &cabecera, &trama[TAM_CABECERA_TELEMETRIA]);
+            pos += tam + TAM_CRC_TELEMETRIA;
+        }
+
+        memmove(dec->entrada, &dec->entrada[pos], dec->indice - pos);
+        dec->indice -= pos;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t construirComandoTelemetria(uint8_t *trama, comandoTelemetria_e comando,
+**                                                      uint32_t canales, uint16_t divisor)
+**  Descripcion:    Construye una trama de comando para la placa
+**  Parametros:     Buffer de la trama, comando, mascara de canales, divisor
+**  Retorno:        Bytes de la trama
+****************************************************************************************/
+uint16_t construirComandoTelemetria(uint8_t *trama, comandoTelemetria_e comando, uint32_t canales, uint16_t divisor)
+{
+    const cabeceraTelemetria_t cabecera = {
+        .sincronismo = {SINCRONISMO_1_TELEMETRIA, SINCRONISMO_2_TELEMETRIA},
+        .tipo = TRAMA_TELEMETRIA_COMANDO,
+        .version = VERSION_TELEMETRIA,
+        .longitud = TAM_CARGA_COMANDO_TELEMETRIA,
+        .canales = canales,
+    };
+    const uint16_t tam = TAM_CABECERA_TELEMETRIA + TAM_CARGA_COMANDO_TELEMETRIA;
+
+    memcpy(trama, &cabecera, sizeof(cabecera));
+    trama[TAM_CABECERA_TELEMETRIA] = comando;
+    trama[TAM_CABECERA_TELEMETRIA + 1] = divisor & 0xFF;
+    trama[TAM_CABECERA_TELEMETRIA + 2] = divisor >> 8;
+
+    const uint16_t crc = calcularCRC16(VALOR_INICIO_CRC_TELEMETRIA, trama, tam);
+    trama[tam] = crc & 0xFF;
+    trama[tam + 1] = crc >> 8;
+
+    return tam + TAM_CRC_TELEMETRIA;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool grabarTelemetria(const char *fuente, const char *suscripcion, FILE *salida)
+**  Descripcion:    Lee la telemetria del puerto USB hasta Ctrl+C, o de una captura hasta el
+**                  final, y la escribe en CSV. En el puerto pide el esquema y se suscribe
+**  Parametros:     Puerto o fichero, suscripcion (NULL para dejar la de la placa), salida CSV
+**  Retorno:        True si ok
+****************************************************************************************/
+bool grabarTelemetria(const char *fuente, const char *suscripcion, FILE *salida)
+{
+    uint8_t buffer[TAM_LECTURA_DECODIFICADOR];
+    struct stat info;
+    ssize_t n;
+
+    puertoTelemetria = open(fuente, O_RDWR | O_NOCTTY);
+    if (puertoTelemetria < 0)
+        puertoTelemetria = open(fuente, O_RDONLY);
+
+    if (puertoTelemetria < 0 || fstat(puertoTelemetria, &info) != 0) {
+        fprintf(stderr, "No se puede abrir %s\n", fuente);
+        return false;
+    }
+
+    const bool puerto = S_ISCHR(info.st_mode);
+    iniciarDecodificadorTelemetria(&decodificadorTelemetria, puerto ? suscripcion : NULL, puerto ? enviarPuertoTelemetria : NULL, salida);
+
+    if (puerto) {
+        struct termios tty;
+
+        // El CDC no usa la velocidad, solo hace falta el modo raw
+        if (tcgetattr(puertoTelemetria, &tty) == 0) {
+            cfmakeraw(&tty);
+            tcsetattr(puertoTelemetria, TCSANOW, &tty);
+            tcflush(puertoTelemetria, TCIFLUSH);
+        }
+
+        n = construirComandoTelemetria(buffer, COMANDO_TELEMETRIA_ESQUEMA, 0, 0);
+        enviarPuertoTelemetria(buffer, n);
+        signal(SIGINT, senalGrabacionTelemetria);
+    }
+
+    while (!pararGrabacionTelemetria && (n = read(puertoTelemetria, buffer, sizeof(buffer))) > 0)
+        decodificarTelemetria(&decodificadorTelemetria, buffer, n);
+
+    close(puertoTelemetria);
+    puertoTelemetria = -1;
+
+    if (salida != NULL)
+        fflush(salida);
+
+    mostrarResumenTelemetria(&decodificadorTelemetria, stderr);
+    return decodificadorTelemetria.esquemaValido;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void conectarTelemetriaSITL(const char *suscripcion)
+**  Descripcion:    Conecta el USB simulado al decodificador y pide el esquema. Se llama
+**                  antes de iniciar la placa
+**  Parametros:     Suscripcion (NULL para la de por defecto)
+**  Retorno:        Ninguno
+****************************************************************************************/
+void conectarTelemetriaSITL(const char *suscripcion)
+{
+    uint8_t comando[TAM_CABECERA_TELEMETRIA + TAM_CARGA_COMANDO_TELEMETRIA + TAM_CRC_TELEMETRIA];
+
+    iniciarDecodificadorTelemetria(&decodificadorTelemetria, suscripcion != NULL ? suscripcion : SUSCRIPCION_DEFECTO_SITL,
+                                   inyectarUSBtelemetriaSITL, NULL);
+    conectarUSBSITL(capturarUSBtelemetriaSITL);
+    inyectarUSBSITL(comando, construirComandoTelemetria(comando, COMANDO_TELEMETRIA_ESQUEMA, 0, 0));
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool comprobarTelemetriaSITL(void)
+**  Descripcion:    Comprueba que todas las tramas han llegado bien y que cada canal
+**                  suscrito sale a la frecuencia de su divisor
+**  Parametros:     Ninguno
+**  Retorno:        True si no hay errores
+****************************************************************************************/
+bool comprobarTelemetriaSITL(void)
+{
+    const decodificadorTelemetria_t *dec = &decodificadorTelemetria;
+    const double segundos = (uint32_t)(dec->ultimoTiempo - dec->primerTiempo) * 1e-6;
+    uint32_t errores = dec->erroresCRC + dec->tramasInvalidas + dec->tramasPerdidas + dec->bytesDescartados;
+
+    if (!dec->esquemaValido || !dec->suscrito || segundos <= 0)
+        errores++;
+
+    mostrarResumenTelemetria(dec, stdout);
+
+    for (uint8_t i = 0; i < NUM_CANALES_TELEMETRIA; i++) {
+        if (!(dec->columnas & (1UL << i)))
+            continue;
+
+        const double esperadas = segundos * FREC_ACTUALIZAR_TELEMETRIA_HZ / dec->divisor[i];
+        const bool ok = fabs(dec->muestras[i] - esperadas) <= esperadas * TOLERANCIA_MUESTRAS_SITL + 1;
+
+        printf("telemetria canal=%s divisor=%u muestras=%u esperadas=%.0f hz=%.1f%s\n", dec->nombre[i], dec->divisor[i],
+               dec->muestras[i], esperadas, segundos > 0 ? dec->muestras[i] / segundos : 0, ok ? "" : " ERROR");
+        errores += !ok;
+    }
+
+    return errores == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void procesarTramaDecodificador(decodificadorTelemetria_t *dec,
+**                                                  const cabeceraTelemetria_t *cabecera, const uint8_t *carga)
+**  Descripcion:    Procesa una trama con el CRC correcto
+**  Parametros:     Decodificador, cabecera, carga
+**  Retorno:        Ninguno
+****************************************************************************************/
+void procesarTramaDecodificador(decodificadorTelemetria_t *dec, const cabeceraTelemetria_t *cabecera, const uint8_t *carga)
+{
+    switch (cabecera->tipo) {
+        case TRAMA_TELEMETRIA_ESQUEMA:
+            leerEsquemaDecodificador(dec, cabecera, carga);
+            break;
+
+        case TRAMA_TELEMETRIA_DATOS:
+            leerDatosDecodificador(dec, cabecera, carga);
+            break;
+
+        default:
+            break;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void leerEsquemaDecodificador(decodificadorTelemetria_t *dec,
+**                                                const cabeceraTelemetria_t *cabecera, const uint8_t *carga)
+**  Descripcion:    Guarda los canales del esquema, manda la suscripcion pendiente y
+**                  escribe la cabecera CSV si han cambiado los canales enviados
+**  Parametros:     Decodificador, cabecera, carga
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerEsquemaDecodificador(decodificadorTelemetria_t *dec, const cabeceraTelemetria_t *cabecera, const uint8_t *carga)
+{
+    uint32_t indice = 0, canales = 0, columnas = 0;
+
+    while (indice + 6 <= cabecera->longitud) {
+        const uint8_t canal = carga[indice];
+        const uint8_t longNombre = carga[indice + 5];
+
+        if (canal >= NUM_CANALES_TELEMETRIA || carga[indice + 1] > NUM_MAX_VALORES_CANAL_TELEMETRIA ||
+            indice + 6 + longNombre > cabecera->longitud) {
+            dec->tramasInvalidas++;
+            return;
+        }
+
+        dec->numValores[canal] = carga[indice + 1];
+        dec->tipo[canal] = carga[indice + 2];
+        dec->divisor[canal] = carga[indice + 3] | (carga[indice + 4] << 8);
+
+        const uint8_t n = longNombre < TAM_NOMBRE_CANAL_DECODIFICADOR ? longNombre : TAM_NOMBRE_CANAL_DECODIFICADOR - 1;
+        memcpy(dec->nombre[canal], &carga[indice + 6], n);
+        dec->nombre[canal][n] = '\0';
+
+        canales |= 1UL << canal;
+        if (dec->divisor[canal] > 0)
+            columnas |= 1UL << canal;
+
+        indice += 6 + longNombre;
+    }
+
+    dec->tramasEsquema++;
+    dec->canales = canales;
+    dec->esquemaValido = true;
+
+    // Las frecuencias se miden desde el ultimo cambio de suscripcion
+    memset(dec->muestras, 0, sizeof(dec->muestras));
+    dec->tiempoIniciado = false;
+
+    if (!dec->suscrito && dec->suscripcion != NULL && dec->enviar != NULL) {
+        enviarSuscripcionDecodificador(dec);
+        dec->suscrito = true;
+    }
+
+    if (columnas != dec->columnas) {
+        dec->columnas = columnas;
+        escribirCabeceraCSVtelemetria(dec);
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void leerDatosDecodificador(decodificadorTelemetria_t *dec,
+**                                              const cabeceraTelemetria_t *cabecera, const uint8_t *carga)
+**  Descripcion:    Comprueba la secuencia, cuenta las muestras y escribe la fila CSV
+**  Parametros:     Decodificador, cabecera, carga
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerDatosDecodificador(decodificadorTelemetria_t *dec, const cabeceraTelemetria_t *cabecera, const uint8_t *carga)
+{
+    uint32_t longitud = 0;
+    uint32_t posicion[NUM_CANALES_TELEMETRIA];
+
+    if (dec->secuenciaIniciada)
+        dec->tramasPerdidas += (uint16_t)(cabecera->secuencia - dec->secuencia);
+
+    dec->secuenciaIniciada = true;
+    dec->secuencia = cabecera->secuencia + 1;
+    dec->tramasDatos++;
+    dec->bytesDatos += TAM_CABECERA_TELEMETRIA + cabecera->longitud + TAM_CRC_TELEMETRIA;
+
+    if (!dec->esquemaValido)
+        return;
+
+    for (uint32_t pendientes = cabecera->canales; pendientes != 0; pendientes &= pendientes - 1) {
+        const uint8_t canal = __builtin_ctz(pendientes);
+
+        if (canal >= NUM_CANALES_TELEMETRIA || !(dec->canales & (1UL << canal))) {
+            dec->tramasInvalidas++;
+            return;
+        }
+
+        posicion[canal] = longitud;
+        longitud += dec->numValores[canal] * sizeof(uint32_t);
+    }
+
+    if (longitud != cabecera->longitud) {
+        dec->tramasInvalidas++;
+        return;
+    }
+
+    if (!dec->tiempoIniciado) {
+        dec->tiempoIniciado = true;
+        dec->primerTiempo = cabecera->tiempo;
+    }
+    dec->ultimoTiempo = cabecera->tiempo;
+
+    for (uint32_t pendientes = cabecera->canales; pendientes != 0; pendientes &= pendientes - 1)
+        dec->muestras[__builtin_ctz(pendientes)]++;
+
+    if (dec->salida == NULL)
+        return;
+
+    fprintf(dec->salida, "%u,%u", cabecera->tiempo, cabecera->secuencia);
+
+    for (uint8_t i = 0; i < NUM_CANALES_TELEMETRIA; i++) {
+        if (!(dec->columnas & (1UL << i)))
+            continue;
+
+        const bool presente = cabecera->canales & (1UL << i);
+
+        for (uint8_t j = 0; j < dec->numValores[i]; j++) {
+            if (!presente) {
+                fputc(',', dec->salida);
+                continue;
+            }
+
+            uint32_t bits;
+            memcpy(&bits, &carga[posicion[i] + j * sizeof(uint32_t)], sizeof(bits));
+
+            if (dec->tipo[i] == VALOR_TELEMETRIA_INT32)
+                fprintf(dec->salida, ",%d", (int32_t)bits);
+            else {
+                float valor;
+                memcpy(&valor, &bits, sizeof(valor));
+                fprintf(dec->salida, ",%.6g", valor);
+            }
+        }
+    }
+
+    fputc('\n', dec->salida);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void enviarSuscripcionDecodificador(decodificadorTelemetria_t *dec)
+**  Descripcion:    Manda un comando por cada elemento "nombre:divisor" de la suscripcion
+**  Parametros:     Decodificador
+**  Retorno:        Ninguno
+****************************************************************************************/
+void enviarSuscripcionDecodificador(decodificadorTelemetria_t *dec)
+{
+    char lista[TAM_SUSCRIPCION_DECODIFICADOR];
+    uint8_t comando[TAM_CABECERA_TELEMETRIA + TAM_CARGA_COMANDO_TELEMETRIA + TAM_CRC_TELEMETRIA];
+    char *contexto;
+
+    strncpy(lista, dec->suscripcion, sizeof(lista) - 1);
+    lista[sizeof(lista) - 1] = '\0';
+
+    for (char *elemento = strtok_r(lista, ",", &contexto); elemento != NULL; elemento = strtok_r(NULL, ",", &contexto)) {
+        char *separador = strchr(elemento, ':');
+        const uint16_t divisor = separador != NULL ? strtoul(separador + 1, NULL, 0) : 1;
+        uint32_t canales = 0;
+
+        if (separador != NULL)
+            *separador = '\0';
+
+        if (strcmp(elemento, "todos") == 0)
+            canales = dec->canales;
+        else {
+            for (uint8_t i = 0; i < NUM_CANALES_TELEMETRIA; i++) {
+                if ((dec->canales & (1UL << i)) && strcmp(elemento, dec->nombre[i]) == 0)
+                    canales = 1UL << i;
+            }
+        }
+
+        if (canales == 0) {
+            fprintf(stderr, "Canal de telemetria desconocido: %s\n", elemento);
+            continue;
+        }
+
+        dec->enviar(comando, construirComandoTelemetria(comando, COMANDO_TELEMETRIA_SUSCRIBIR, canales, divisor));
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void escribirCabeceraCSVtelemetria(decodificadorTelemetria_t *dec)
+**  Descripcion:    Escribe los nombres de las columnas de los canales enviados
+**  Parametros:     Decodificador
+**  Retorno:        Ninguno
+****************************************************************************************/
+void escribirCabeceraCSVtelemetria(decodificadorTelemetria_t *dec)
+{
+    if (dec->salida == NULL)
+        return;
+
+    fprintf(dec->salida, "tiempo_us,secuencia");
+
+    for (uint8_t i = 0; i < NUM_CANALES_TELEMETRIA; i++) {
+        if (!(dec->columnas & (1UL << i)))
+            continue;
+
+        for (uint8_t j = 0; j < dec->numValores[i]; j++)
+            fprintf(dec->salida, ",%s[%u]", dec->nombre[i], j);
+    }
+
+    fputc('\n', dec->salida);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void mostrarResumenTelemetria(const decodificadorTelemetria_t *dec, FILE *salida)
+**  Descripcion:    Muestra las tramas recibidas, el caudal y los errores
+**  Parametros:     Decodificador, salida
+**  Retorno:        Ninguno
+****************************************************************************************/
+void mostrarResumenTelemetria(const decodificadorTelemetria_t *dec, FILE *salida)
+{
+    const double segundos = (uint32_t)(dec->ultimoTiempo - dec->primerTiempo) * 1e-6;
+
+    fprintf(salida, "telemetria tramas=%u esquemas=%u bytes=%llu kB_s=%.1f errores_crc=%u invalidas=%u perdidas=%u descartados=%u\n",
+            dec->tramasDatos, dec->tramasEsquema, (unsigned long long)dec->bytesDatos,
+            segundos > 0 ? dec->bytesDatos / segundos * 1e-3 : 0, dec->erroresCRC, dec->tramasInvalidas,
+            dec->tramasPerdidas, dec->bytesDescartados);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void enviarPuertoTelemetria(const uint8_t *dato, uint32_t longitud)
+**  Descripcion:    Manda un comando por el puerto USB
+**  Parametros:     Datos, longitud
+**  Retorno:        Ninguno
+****************************************************************************************/
+void enviarPuertoTelemetria(const uint8_t *dato, uint32_t longitud)
+{
+    if (write(puertoTelemetria, dato, longitud) != (ssize_t)longitud)
+        fprintf(stderr, "No se puede escribir en el puerto de telemetria\n");
+}
+
+
+/***************************************************************************************
+**  Nombre:         void senalGrabacionTelemetria(int senal)
+**  Descripcion:    Termina la grabacion con Ctrl+C
+**  Parametros:     Senal
+**  Retorno:        Ninguno
+****************************************************************************************/
+void senalGrabacionTelemetria(int senal)
+{
+    (void)senal;
+    pararGrabacionTelemetria = 1;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void capturarUSBtelemetriaSITL(const uint8_t *dato, uint32_t longitud)
+**  Descripcion:    Recibe lo que transmite la placa simulada por el USB
+**  Parametros:     Datos, longitud
+**  Retorno:        Ninguno
+****************************************************************************************/
+void capturarUSBtelemetriaSITL(const uint8_t *dato, uint32_t longitud)
+{
+    decodificarTelemetria(&decodificadorTelemetria, dato, longitud);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void inyectarUSBtelemetriaSITL(const uint8_t *dato, uint32_t longitud)
+**  Descripcion:    Manda un comando a la placa simulada
+**  Parametros:     Datos, longitud
+**  Retorno:        Ninguno
+****************************************************************************************/
+void inyectarUSBtelemetriaSITL(const uint8_t *dato, uint32_t longitud)
+{
+    inyectarUSBSITL(dato, longitud);
+}
+
+#endif
@@ -0,0 +1,112 @@
+/***************************************************************************************
+**  decodificador_telemetria.h - Decodificador y grabador de la telemetria por USB
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __DECODIFICADOR_TELEMETRIA_H
+#define __DECODIFICADOR_TELEMETRIA_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+
+#include "Sistema/plataforma.h"
+#include "Telemetria/telemetria.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Decodifica las tramas de Telemetria/telemetria.h y escribe una fila CSV por trama de
+ * datos con los canales del ultimo esquema recibido (vacios si no van en la trama). Las
+ * suscripciones se escriben como "nombre:divisor,..." ("todos" para todos los canales) y
+ * se mandan al recibir el primer esquema, que se pide al empezar. La fuente puede ser el
+ * puerto del USB (/dev/ttyACMx) o un fichero con una captura que incluya el esquema. En
+ * SITL la telemetria de la placa simulada pasa por el mismo decodificador y se comprueban
+ * el CRC, la secuencia y la frecuencia de cada canal
+ */
+#define TAM_NOMBRE_CANAL_DECODIFICADOR        16
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef void (*enviarDecodificadorTelemetria_t)(const uint8_t *dato, uint32_t longitud);
+
+typedef struct {
+    // Esquema
+    bool esquemaValido;
+    uint32_t canales;
+    uint8_t numValores[NUM_CANALES_TELEMETRIA];
+    uint8_t tipo[NUM_CANALES_TELEMETRIA];
+    uint16_t divisor[NUM_CANALES_TELEMETRIA];
+    char nombre[NUM_CANALES_TELEMETRIA][TAM_NOMBRE_CANAL_DECODIFICADOR];
+    uint32_t columnas;                    // Canales con divisor en la cabecera CSV
+
+    // Bytes recibidos pendientes de formar una trama
+    uint8_t entrada[2 * TAM_MAX_TRAMA_TELEMETRIA];
+    uint32_t indice;
+
+    // Suscripcion pendiente y salida de los comandos
+    const char *suscripcion;
+    bool suscrito;
+    enviarDecodificadorTelemetria_t enviar;
+    FILE *salida;
+
+    // Estadisticas
+    uint32_t tramasDatos;
+    uint32_t tramasEsquema;
+    uint32_t erroresCRC;
+    uint32_t tramasInvalidas;             // Carga que no coincide con el esquema
+    uint32_t bytesDescartados;
+    uint32_t tramasPerdidas;              // Saltos de secuencia
+    uint64_t bytesDatos;
+    bool secuenciaIniciada;
+    uint16_t secuencia;
+    bool tiempoIniciado;
+    uint32_t primerTiempo;                // Primera trama de datos desde el ultimo esquema
+    uint32_t ultimoTiempo;
+    uint32_t muestras[NUM_CANALES_TELEMETRIA];  // Desde el ultimo esquema
+} decodificadorTelemetria_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void iniciarDecodificadorTelemetria(decodificadorTelemetria_t *dec, const char *suscripcion,
+                                    enviarDecodificadorTelemetria_t enviar, FILE *salida);
+void decodificarTelemetria(decodificadorTelemetria_t *dec, const uint8_t *dato, uint32_t longitud);
+uint16_t construirComandoTelemetria(uint8_t *trama, comandoTelemetria_e comando, uint32_t canales, uint16_t divisor);
+bool grabarTelemetria(const char *fuente, const char *suscripcion, FILE *salida);
+void conectarTelemetriaSITL(const char *suscripcion);
+bool comprobarTelemetriaSITL(void);
+
+#endif // __DECODIFICADOR_TELEMETRIA_H
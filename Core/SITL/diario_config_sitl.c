@@ -0,0 +1,582 @@
+/***************************************************************************************
+**  diario_config_sitl.c - Pruebas del diario de configuracion con cortes de alimentacion
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "diario_config_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <string.h>
+
+#include "sitl.h"
+#include "GP/diario_config.h"
+#include "Comun/util.h"
+#include "Comun/matematicas.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define TAM_SECTOR_DIARIO_SITL          0x8000       // Sectores 1 y 2 del F767
+#define TAM_SECTOR_CORTES_SITL          4096         // Sector pequeno para compactar a menudo
+#define NUM_GP_DIARIO_SITL              12
+#define TAM_MAX_GP_DIARIO_SITL          300
+#define VERSION_DIARIO_SITL             2
+#define US_PROGRAMAR_WORD_SITL          16           // Valores tipicos del F767 con x32
+#define US_BORRAR_SECTOR_SITL           250000
+#define PROB_ARMADO_SITL                10           // Uno de cada tantos guardados no puede borrar
+#define REPETICIONES_APERTURA_SITL      1000
+#define SEMILLA_DIARIO_SITL             0xD1A1u
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    uint8_t sector[2][TAM_SECTOR_DIARIO_SITL] __attribute__((aligned(4)));
+    int32_t operacionesHastaCorte;       // Negativo si no hay corte programado
+    bool sinAlimentacion;
+    uint32_t borrados;
+    uint32_t words;
+    uint32_t reprogramadas;              // Words programadas sin estar borradas
+} flashDiarioSITL_t;
+
+typedef struct {
+    uint8_t dato[NUM_GP_DIARIO_SITL][TAM_MAX_GP_DIARIO_SITL];
+    bool guardado[NUM_GP_DIARIO_SITL];
+} modeloDiarioSITL_t;
+
+typedef enum {
+    OPERACION_NORMAL_SITL = 0,
+    OPERACION_CORTADA_SITL,              // Se va la alimentacion a mitad de esta operacion
+    OPERACION_SIN_ALIMENTACION_SITL,
+} estadoOperacionSITL_e;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static const uint16_t tamGPDiarioSITL[NUM_GP_DIARIO_SITL] = {4, 12, 24, 40, 64, 100, 128, 200, 256, 300, 18, 7};
+
+static flashDiarioSITL_t flashDiarioSITL;
+static dispositivoDiarioConfig_t dispositivoDiarioSITL;
+static diarioConfig_t diarioSITL;
+static modeloDiarioSITL_t guardadoSITL;        // Lo que tiene que haber en la flash
+static modeloDiarioSITL_t ramSITL;             // Lo que hay en RAM
+static uint32_t semillaDiarioSITL;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+uint32_t aleatorioDiarioSITL(void);
+void iniciarFlashDiarioSITL(uint32_t tamSector);
+estadoOperacionSITL_e operacionFlashDiarioSITL(void);
+int32_t borrarFlashDiarioSITL(uint8_t numSector);
+int32_t programarFlashDiarioSITL(const uint8_t *dir, const uint32_t *dato, uint32_t numWords);
+
+uint16_t gpnDiarioSITL(uint8_t gp);
+void modificarGPDiarioSITL(uint8_t gp);
+estadoDiarioConfig_e guardarGPDiarioSITL(uint8_t gp, bool permitirBorrado);
+bool guardarTodosDiarioSITL(void);
+uint32_t comprobarDiarioSITL(int16_t enCurso);
+
+bool probarBasicoDiarioSITL(void);
+bool probarDesgasteDiarioSITL(uint32_t numGuardados);
+bool probarCortesDiarioSITL(uint32_t numGuardados);
+void medirAperturaDiarioSITL(void);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool probarDiarioConfigSITL(uint32_t numGuardados)
+**  Descripcion:    Prueba el diario de configuracion sobre una flash simulada
+**  Parametros:     Guardados de la prueba de desgaste y de la de cortes
+**  Retorno:        True si no se pierde ni se corrompe ningun GP
+****************************************************************************************/
+bool probarDiarioConfigSITL(uint32_t numGuardados)
+{
+    semillaDiarioSITL = SEMILLA_DIARIO_SITL;
+
+    bool ok = probarBasicoDiarioSITL();
+    ok &= probarDesgasteDiarioSITL(numGuardados);
+    ok &= probarCortesDiarioSITL(numGuardados);
+    medirAperturaDiarioSITL();
+
+    return ok;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t aleatorioDiarioSITL(void)
+**  Descripcion:    Generador xorshift para que la prueba sea repetible. Los bits bajos
+**                  sirven igual que los altos
+**  Parametros:     Ninguno
+**  Retorno:        Numero pseudoaleatorio de 32 bits
+****************************************************************************************/
+uint32_t aleatorioDiarioSITL(void)
+{
+    semillaDiarioSITL ^= semillaDiarioSITL << 13;
+    semillaDiarioSITL ^= semillaDiarioSITL >> 17;
+    semillaDiarioSITL ^= semillaDiarioSITL << 5;
+    return semillaDiarioSITL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void iniciarFlashDiarioSITL(uint32_t tamSector)
+**  Descripcion:    Borra la flash simulada y prepara el dispositivo del diario
+**  Parametros:     Tamanio de sector que usa el diario
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarFlashDiarioSITL(uint32_t tamSector)
+{
+    memset(&flashDiarioSITL, 0xFF, sizeof(flashDiarioSITL.sector));
+    flashDiarioSITL.operacionesHastaCorte = -1;
+    flashDiarioSITL.sinAlimentacion = false;
+    flashDiarioSITL.borrados = 0;
+    flashDiarioSITL.words = 0;
+    flashDiarioSITL.reprogramadas = 0;
+
+    dispositivoDiarioSITL.sector[0] = flashDiarioSITL.sector[0];
+    dispositivoDiarioSITL.sector[1] = flashDiarioSITL.sector[1];
+    dispositivoDiarioSITL.tamSector = tamSector;
+    dispositivoDiarioSITL.borrar = borrarFlashDiarioSITL;
+    dispositivoDiarioSITL.programar = programarFlashDiarioSITL;
+
+    memset(&guardadoSITL, 0, sizeof(guardadoSITL));
+    memset(&ramSITL, 0, sizeof(ramSITL));
+
+    // Como al arrancar con la flash vacia: no hay sector activo
+    abrirDiarioConfig(&diarioSITL, &dispositivoDiarioSITL, VERSION_DIARIO_SITL);
+}
+
+
+/***************************************************************************************
+**  Nombre:         estadoOperacionSITL_e operacionFlashDiarioSITL(void)
+**  Descripcion:    Cuenta una operacion de la flash y decide si se va la alimentacion
+**  Parametros:     Ninguno
+**  Retorno:        Estado de la operacion
+****************************************************************************************/
+estadoOperacionSITL_e operacionFlashDiarioSITL(void)
+{
+    if (flashDiarioSITL.sinAlimentacion)
+        return OPERACION_SIN_ALIMENTACION_SITL;
+
+    if (flashDiarioSITL.operacionesHastaCorte == 0) {
+        flashDiarioSITL.sinAlimentacion = true;
+        return OPERACION_CORTADA_SITL;
+    }
+
+    if (flashDiarioSITL.operacionesHastaCorte > 0)
+        flashDiarioSITL.operacionesHastaCorte--;
+
+    return OPERACION_NORMAL_SITL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         int32_t borrarFlashDiarioSITL(uint8_t numSector)
+**  Descripcion:    Borra un sector. Si se corta deja la mitad de las words sin borrar
+**  Parametros:     Numero de sector
+**  Retorno:        0 si ok
+****************************************************************************************/
+int32_t borrarFlashDiarioSITL(uint8_t numSector)
+{
+    uint32_t *sector = (uint32_t *)flashDiarioSITL.sector[numSector];
+    const estadoOperacionSITL_e estado = operacionFlashDiarioSITL();
+
+    if (estado == OPERACION_SIN_ALIMENTACION_SITL)
+        return -1;
+
+    if (estado == OPERACION_CORTADA_SITL) {
+        for (uint32_t i = 0; i < dispositivoDiarioSITL.tamSector / 4; i++) {
+            if (aleatorioDiarioSITL() & 1)
+                sector[i] = 0xFFFFFFFF;
+        }
+        return -1;
+    }
+
+    memset(sector, 0xFF, dispositivoDiarioSITL.tamSector);
+    flashDiarioSITL.borrados++;
+    return 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         int32_t programarFlashDiarioSITL(const uint8_t *dir, const uint32_t *dato, uint32_t numWords)
+**  Descripcion:    Programa words bajando bits. Si se corta la ultima queda a medias
+**  Parametros:     Direccion, datos, numero de words
+**  Retorno:        0 si ok
+****************************************************************************************/
+int32_t programarFlashDiarioSITL(const uint8_t *dir, const uint32_t *dato, uint32_t numWords)
+{
+    uint32_t *p = (uint32_t *)dir;
+
+    for (uint32_t i = 0; i < numWords; i++) {
+        const estadoOperacionSITL_e estado = operacionFlashDiarioSITL();
+
+        if (estado == OPERACION_SIN_ALIMENTACION_SITL)
+            return -2;
+
+        if (estado == OPERACION_CORTADA_SITL) {
+            p[i] &= dato[i] | aleatorioDiarioSITL();
+            return -2;
+        }
+
+        if (p[i] != 0xFFFFFFFF)
+            flashDiarioSITL.reprogramadas++;
+
+        p[i] &= dato[i];
+        flashDiarioSITL.words++;
+    }
+
+    return 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t gpnDiarioSITL(uint8_t gp)
+**  Descripcion:    Numero de GP de la prueba
+**  Parametros:     Indice del GP
+**  Retorno:        Numero de GP
+****************************************************************************************/
+uint16_t gpnDiarioSITL(uint8_t gp)
+{
+    return 100 + gp;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void modificarGPDiarioSITL(uint8_t gp)
+**  Descripcion:    Cambia unos bytes de un GP en RAM, como al ajustar un parametro
+**  Parametros:     Indice del GP
+**  Retorno:        Ninguno
+****************************************************************************************/
+void modificarGPDiarioSITL(uint8_t gp)
+{
+    const uint8_t numCambios = 1 + aleatorioDiarioSITL() % 4;
+
+    for (uint8_t i = 0; i < numCambios; i++)
+        ramSITL.dato[gp][aleatorioDiarioSITL() % tamGPDiarioSITL[gp]] ^= 1 + aleatorioDiarioSITL() % 255;
+}
+
+
+/***************************************************************************************
+**  Nombre:         estadoDiarioConfig_e guardarGPDiarioSITL(uint8_t gp, bool permitirBorrado)
+**  Descripcion:    Guarda un GP y actualiza el modelo si queda guardado
+**  Parametros:     Indice del GP, permitir borrar
+**  Retorno:        Estado de la escritura
+****************************************************************************************/
+estadoDiarioConfig_e guardarGPDiarioSITL(uint8_t gp, bool permitirBorrado)
+{
+    const estadoDiarioConfig_e estado = escribirDiarioConfig(&diarioSITL, gpnDiarioSITL(gp), VERSION_DIARIO_SITL,
+                                                             ramSITL.dato[gp], tamGPDiarioSITL[gp], permitirBorrado);
+
+    if (estado != DIARIO_CONFIG_LLENO && estado != DIARIO_CONFIG_ERROR) {
+        memcpy(guardadoSITL.dato[gp], ramSITL.dato[gp], tamGPDiarioSITL[gp]);
+        guardadoSITL.guardado[gp] = true;
+    }
+
+    return estado;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool guardarTodosDiarioSITL(void)
+**  Descripcion:    Guarda todos los GP
+**  Parametros:     Ninguno
+**  Retorno:        True si ok
+****************************************************************************************/
+bool guardarTodosDiarioSITL(void)
+{
+    bool ok = true;
+
+    for (uint8_t i = 0; i < NUM_GP_DIARIO_SITL; i++) {
+        const estadoDiarioConfig_e estado = guardarGPDiarioSITL(i, true);
+        ok &= estado != DIARIO_CONFIG_LLENO && estado != DIARIO_CONFIG_ERROR;
+    }
+
+    return ok;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t comprobarDiarioSITL(int16_t enCurso)
+**  Descripcion:    Compara cada GP del diario con el modelo. El GP que se estaba guardando
+**                  puede tener lo anterior o lo nuevo, y si tiene lo nuevo pasa al modelo
+**  Parametros:     Indice del GP que se estaba guardando o -1
+**  Retorno:        Numero de GP incorrectos
+****************************************************************************************/
+uint32_t comprobarDiarioSITL(int16_t enCurso)
+{
+    uint32_t errores = 0;
+
+    for (uint8_t i = 0; i < NUM_GP_DIARIO_SITL; i++) {
+        uint16_t tam;
+        uint8_t version;
+        const uint8_t *dato = leerDiarioConfig(&diarioSITL, gpnDiarioSITL(i), &tam, &version);
+
+        if (dato == NULL) {
+            errores += guardadoSITL.guardado[i];
+            continue;
+        }
+
+        if (tam != tamGPDiarioSITL[i] || version != VERSION_DIARIO_SITL) {
+            errores++;
+            continue;
+        }
+
+        if (guardadoSITL.guardado[i] && memcmp(dato, guardadoSITL.dato[i], tam) == 0)
+            continue;
+
+        if (i == enCurso && memcmp(dato, ramSITL.dato[i], tam) == 0) {
+            memcpy(guardadoSITL.dato[i], dato, tam);
+            guardadoSITL.guardado[i] = true;
+            continue;
+        }
+
+        errores++;
+    }
+
+    return errores;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool probarBasicoDiarioSITL(void)
+**  Descripcion:    Formatea sobre una zona con basura, guarda, repite sin cambios, cambia
+**                  una version y vuelve a abrir
+**  Parametros:     Ninguno
+**  Retorno:        True si ok
+****************************************************************************************/
+bool probarBasicoDiarioSITL(void)
+{
+    uint32_t errores = 0;
+
+    // Una zona con otro formato no se abre
+    iniciarFlashDiarioSITL(TAM_SECTOR_DIARIO_SITL);
+    for (uint32_t i = 0; i < TAM_SECTOR_DIARIO_SITL; i++)
+        flashDiarioSITL.sector[0][i] = aleatorioDiarioSITL();
+
+    errores += abrirDiarioConfig(&diarioSITL, &dispositivoDiarioSITL, VERSION_DIARIO_SITL);
+    errores += !formatearDiarioConfig(&diarioSITL);
+
+    for (uint8_t i = 0; i < NUM_GP_DIARIO_SITL; i++) {
+        for (uint16_t j = 0; j < tamGPDiarioSITL[i]; j++)
+            ramSITL.dato[i][j] = aleatorioDiarioSITL();
+    }
+    errores += !guardarTodosDiarioSITL();
+
+    // Guardar sin cambios no programa nada
+    const uint32_t words = flashDiarioSITL.words;
+    for (uint8_t i = 0; i < NUM_GP_DIARIO_SITL; i++)
+        errores += guardarGPDiarioSITL(i, true) != DIARIO_CONFIG_SIN_CAMBIOS;
+    errores += flashDiarioSITL.words != words;
+
+    // Con otra version se vuelve a escribir
+    errores += escribirDiarioConfig(&diarioSITL, gpnDiarioSITL(0), VERSION_DIARIO_SITL + 1, ramSITL.dato[0],
+                                    tamGPDiarioSITL[0], true) != DIARIO_CONFIG_ESCRITO;
+    errores += guardarGPDiarioSITL(0, true) != DIARIO_CONFIG_ESCRITO;
+
+    errores += !abrirDiarioConfig(&diarioSITL, &dispositivoDiarioSITL, VERSION_DIARIO_SITL);
+    errores += comprobarDiarioSITL(-1);
+    errores += abrirDiarioConfig(&diarioSITL, &dispositivoDiarioSITL, VERSION_DIARIO_SITL + 1);
+
+    printf("diario prueba=basica errores=%u\n", errores);
+    return errores == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool probarDesgasteDiarioSITL(uint32_t numGuardados)
+**  Descripcion:    Guarda cambios pequenos en GP aleatorios con sectores de 32K y cuenta
+**                  borrados y words frente a reescribir toda la zona en cada guardado
+**  Parametros:     Numero de guardados
+**  Retorno:        True si ok
+****************************************************************************************/
+bool probarDesgasteDiarioSITL(uint32_t numGuardados)
+{
+    uint32_t errores = 0;
+    uint32_t guardados = 0;
+    uint32_t llenos = 0;
+    uint32_t wordsMaxSinBorrar = 0;
+
+    iniciarFlashDiarioSITL(TAM_SECTOR_DIARIO_SITL);
+    errores += !formatearDiarioConfig(&diarioSITL);
+    errores += !guardarTodosDiarioSITL();
+
+    const uint32_t borradosInicio = flashDiarioSITL.borrados;
+    const uint32_t wordsInicio = flashDiarioSITL.words;
+
+    for (uint32_t k = 0; k < numGuardados; k++) {
+        const uint8_t gp = aleatorioDiarioSITL() % NUM_GP_DIARIO_SITL;
+        const bool permitirBorrado = aleatorioDiarioSITL() % PROB_ARMADO_SITL != 0;
+        const uint32_t words = flashDiarioSITL.words;
+
+        modificarGPDiarioSITL(gp);
+        const estadoDiarioConfig_e estado = guardarGPDiarioSITL(gp, permitirBorrado);
+
+        if (estado == DIARIO_CONFIG_ERROR)
+            errores++;
+        else if (estado == DIARIO_CONFIG_LLENO)
+            llenos++;
+        else
+            guardados++;
+
+        if (estado == DIARIO_CONFIG_ESCRITO)
+            wordsMaxSinBorrar = MAX(wordsMaxSinBorrar, flashDiarioSITL.words - words);
+    }
+
+    // Los que no cupieron con los motores en marcha se guardan despues
+    errores += !guardarTodosDiarioSITL();
+    errores += !abrirDiarioConfig(&diarioSITL, &dispositivoDiarioSITL, VERSION_DIARIO_SITL);
+    errores += comprobarDiarioSITL(-1);
+    errores += flashDiarioSITL.reprogramadas;
+
+    // Reescribir toda la zona: cabecera, cada GP con la suya, terminador y CRC
+    uint32_t bytesZona = 2 + 2 + 2;
+    for (uint8_t i = 0; i < NUM_GP_DIARIO_SITL; i++)
+        bytesZona += 6 + tamGPDiarioSITL[i];
+    const uint32_t wordsAnterior = (bytesZona + 3) / 4;
+
+    const uint32_t borrados = flashDiarioSITL.borrados - borradosInicio;
+    const uint32_t words = flashDiarioSITL.words - wordsInicio;
+
+    printf("diario prueba=desgaste guardados=%u llenos=%u borrados=%u borrados_anterior=%u guardados_por_borrado=%.1f "
+           "words_por_guardado=%.1f words_por_guardado_anterior=%u us_max_sin_borrar=%u us_guardado_anterior=%u "
+           "reprogramadas=%u errores=%u\n",
+           guardados, llenos, borrados, guardados, borrados ? (double)guardados / borrados : (double)guardados,
+           guardados ? (double)words / guardados : 0.0, wordsAnterior, wordsMaxSinBorrar * US_PROGRAMAR_WORD_SITL,
+           US_BORRAR_SECTOR_SITL + wordsAnterior * US_PROGRAMAR_WORD_SITL, flashDiarioSITL.reprogramadas, errores);
+
+    return errores == 0 && borrados * 10 < guardados;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool probarCortesDiarioSITL(uint32_t numGuardados)
+**  Descripcion:    Guarda con cortes de alimentacion en cualquier operacion, incluidas las
+**                  compactaciones, y comprueba el diario al volver a abrirlo
+**  Parametros:     Numero de guardados
+**  Retorno:        True si ok
+****************************************************************************************/
+bool probarCortesDiarioSITL(uint32_t numGuardados)
+{
+    uint32_t errores = 0;
+    uint32_t cortes = 0;
+    uint32_t cortesCompactando = 0;
+    uint32_t descartados = 0;
+
+    iniciarFlashDiarioSITL(TAM_SECTOR_CORTES_SITL);
+    errores += !formatearDiarioConfig(&diarioSITL);
+    errores += !guardarTodosDiarioSITL();
+
+    for (uint32_t k = 0; k < numGuardados; k++) {
+        const uint8_t gp = aleatorioDiarioSITL() % NUM_GP_DIARIO_SITL;
+        const uint32_t wordsRegistro = 5 + (tamGPDiarioSITL[gp] + 3) / 4;
+        const bool compactara = bytesLibresDiarioConfig(&diarioSITL) < wordsRegistro * 4;
+
+        modificarGPDiarioSITL(gp);
+
+        // La mitad de los guardados se cortan en una operacion al azar del guardado
+        if (aleatorioDiarioSITL() & 1) {
+            const uint32_t operaciones = compactara ? 2 + TAM_SECTOR_CORTES_SITL / 4 : wordsRegistro;
+            flashDiarioSITL.operacionesHastaCorte = aleatorioDiarioSITL() % operaciones;
+        }
+
+        const estadoDiarioConfig_e estado = escribirDiarioConfig(&diarioSITL, gpnDiarioSITL(gp), VERSION_DIARIO_SITL,
+                                                                 ramSITL.dato[gp], tamGPDiarioSITL[gp], true);
+        flashDiarioSITL.operacionesHastaCorte = -1;
+
+        if (!flashDiarioSITL.sinAlimentacion) {
+            if (estado == DIARIO_CONFIG_LLENO || estado == DIARIO_CONFIG_ERROR)
+                errores++;
+            else {
+                memcpy(guardadoSITL.dato[gp], ramSITL.dato[gp], tamGPDiarioSITL[gp]);
+                guardadoSITL.guardado[gp] = true;
+            }
+            continue;
+        }
+
+        // Vuelve la alimentacion: se abre el diario como al arrancar
+        cortes++;
+        cortesCompactando += compactara;
+        flashDiarioSITL.sinAlimentacion = false;
+
+        errores += !abrirDiarioConfig(&diarioSITL, &dispositivoDiarioSITL, VERSION_DIARIO_SITL);
+        errores += comprobarDiarioSITL(gp);
+        descartados += diarioSITL.descartados;
+    }
+
+    errores += !abrirDiarioConfig(&diarioSITL, &dispositivoDiarioSITL, VERSION_DIARIO_SITL);
+    errores += comprobarDiarioSITL(-1);
+    errores += flashDiarioSITL.reprogramadas;
+
+    printf("diario prueba=cortes guardados=%u cortes=%u cortes_compactando=%u "
+           "registros_descartados=%u borrados=%u reprogramadas=%u errores=%u\n",
+           numGuardados, cortes, cortesCompactando, descartados, flashDiarioSITL.borrados,
+           flashDiarioSITL.reprogramadas, errores);
+
+    return errores == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void medirAperturaDiarioSITL(void)
+**  Descripcion:    Llena un sector de 32K y mide lo que tarda en abrirse el diario
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void medirAperturaDiarioSITL(void)
+{
+    uint32_t registros = NUM_GP_DIARIO_SITL;
+
+    iniciarFlashDiarioSITL(TAM_SECTOR_DIARIO_SITL);
+    formatearDiarioConfig(&diarioSITL);
+    guardarTodosDiarioSITL();
+
+    while (true) {
+        const uint8_t gp = aleatorioDiarioSITL() % NUM_GP_DIARIO_SITL;
+        modificarGPDiarioSITL(gp);
+        if (guardarGPDiarioSITL(gp, false) != DIARIO_CONFIG_ESCRITO)
+            break;
+        registros++;
+    }
+
+    const double inicio = tiempoRealNsSITL();
+    for (uint32_t i = 0; i < REPETICIONES_APERTURA_SITL; i++)
+        abrirDiarioConfig(&diarioSITL, &dispositivoDiarioSITL, VERSION_DIARIO_SITL);
+    const double fin = tiempoRealNsSITL();
+
+    printf("diario prueba=apertura registros=%u libres=%u us_abrir=%.1f\n", registros,
+           bytesLibresDiarioConfig(&diarioSITL), (fin - inicio) / REPETICIONES_APERTURA_SITL / 1000);
+}
+
+#endif
@@ -0,0 +1,64 @@
+/***************************************************************************************
+**  diario_config_sitl.h - Pruebas del diario de configuracion con cortes de alimentacion
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __DIARIO_CONFIG_SITL_H
+#define __DIARIO_CONFIG_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Simula dos sectores de flash NOR (borrar pone todo a 1, programar solo baja bits) y corta
+ * la alimentacion en una operacion cualquiera: la word que se estaba programando queda a
+ * medias y el sector que se estaba borrando queda mezclado. Despues de cada corte se vuelve
+ * a abrir el diario y se comprueba que cada GP tiene lo ultimo guardado o lo que se estaba
+ * guardando. Tambien compara el desgaste y el bloqueo con reescribir toda la zona
+ */
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarDiarioConfigSITL(uint32_t numGuardados);
+
+#endif // __DIARIO_CONFIG_SITL_H
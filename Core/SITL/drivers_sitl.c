@@ -0,0 +1,594 @@
+/***************************************************************************************
+**  drivers_sitl.c - Sustitutos de los drivers del micro en SITL. Los modulos que
+**                   dependen de hardware sin modelo (buses, timers, SD) se enlazan
+**                   contra estas funciones, que no hacen nada o devuelven fallo. El USB,
+**                   los registros del bus y la SD se pueden conectar a las pruebas con
+**                   conectarUSBSITL, conectarBusSITL y conectarSDSITL
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spi_sitl.h"
+#include "Drivers/io.h"
+#include "Drivers/bus.h"
+#include "Drivers/cola_spi.h"
+#include "Drivers/spi.h"
+#include "Drivers/i2c.h"
+#include "Drivers/timer.h"
+#include "Drivers/usb.h"
+#include "Drivers/reset.h"
+#include "Blackbox/sd.h"
+#include "Comun/util.h"
+#include "Comun/buffer_anillo.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define RELOJ_SISTEMA_SITL            216000000
+#define TAM_RX_USB_SITL               1024
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+uint32_t SystemCoreClock = RELOJ_SISTEMA_SITL;
+
+// USB simulado: lo transmitido va a la funcion de captura y lo inyectado se recibe
+static capturaUSBSITL_t capturaUSBSITL;
+static bufferAnillo_t anilloRxUSBSITL;
+static uint8_t bufferRxUSBSITL[TAM_RX_USB_SITL];
+static uint8_t bufferTxUSBSITL[TAMANIO_BUFFER_TX_USB];
+
+// Modelo de los dispositivos del bus conectado por las pruebas
+static transferenciaBusSITL_t transferenciaBusSITL;
+
+// Modelo de la tarjeta SD conectado por las pruebas
+static const tablaFnSD_t *tablaFnSDsitl;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         void resetSistema(void)
+**  Descripcion:    Termina la simulacion
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void resetSistema(void)
+{
+    fprintf(stderr, "SITL: reset del sistema\n");
+    exit(EXIT_FAILURE);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void configurarIO(uint8_t tag, uint16_t cfg, uint8_t af)
+**  Descripcion:    Los pines no existen en SITL
+**  Parametros:     Tag del pin, configuracion, funcion alternativa
+**  Retorno:        Ninguno
+****************************************************************************************/
+void configurarIO(uint8_t tag, uint16_t cfg, uint8_t af)
+{
+    UNUSED(tag);
+    UNUSED(cfg);
+    UNUSED(af);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void escribirIO(uint8_t tag, bool estado)
+**  Descripcion:    Los pines no existen en SITL. Los cambios se pasan al SPI simulado para
+**                  seguir los CS de sus dispositivos
+**  Parametros:     Tag del pin, estado
+**  Retorno:        Ninguno
+****************************************************************************************/
+void escribirIO(uint8_t tag, bool estado)
+{
+    cambiarPinSPISITL(tag, estado);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool leerIO(uint8_t tag)
+**  Descripcion:    Los pines no existen en SITL
+**  Parametros:     Tag del pin
+**  Retorno:        Siempre false
+****************************************************************************************/
+bool leerIO(uint8_t tag)
+{
+    UNUSED(tag);
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void invertirIO(uint8_t tag)
+**  Descripcion:    Los pines no existen en SITL
+**  Parametros:     Tag del pin
+**  Retorno:        Ninguno
+****************************************************************************************/
+void invertirIO(uint8_t tag)
+{
+    UNUSED(tag);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool iniciarSPI(numSPI_e numSPI)
+**  Descripcion:    Solo hay puertos si las pruebas han conectado un modelo del bus
+**  Parametros:     Numero de SPI
+**  Retorno:        True si hay modelo
+****************************************************************************************/
+bool iniciarSPI(numSPI_e numSPI)
+{
+    UNUSED(numSPI);
+    return transferenciaBusSITL != NULL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool spiIniciado(numSPI_e numSPI)
+**  Descripcion:    No hay buses en SITL
+**  Parametros:     Numero de SPI
+**  Retorno:        Siempre false
+****************************************************************************************/
+bool spiIniciado(numSPI_e numSPI)
+{
+    UNUSED(numSPI);
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool iniciarI2C(numI2C_e numI2C)
+**  Descripcion:    No hay buses en SITL
+**  Parametros:     Numero de I2C
+**  Retorno:        Siempre false
+****************************************************************************************/
+bool iniciarI2C(numI2C_e numI2C)
+{
+    UNUSED(numI2C);
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool i2cIniciado(numI2C_e numI2C)
+**  Descripcion:    No hay buses en SITL
+**  Parametros:     Numero de I2C
+**  Retorno:        Siempre false
+****************************************************************************************/
+bool i2cIniciado(numI2C_e numI2C)
+{
+    UNUSED(numI2C);
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool escribirRegistroBus(const bus_t *bus, uint8_t reg, uint8_t byteTx)
+**  Descripcion:    Sin modelo conectado no hay buses y los drivers reales no detectan
+**                  su sensor
+**  Parametros:     Puntero al bus, registro, byte a escribir
+**  Retorno:        True si lo ha aceptado el modelo
+****************************************************************************************/
+bool escribirRegistroBus(const bus_t *bus, uint8_t reg, uint8_t byteTx)
+{
+    if (transferenciaBusSITL != NULL)
+        return transferenciaBusSITL(bus, reg, &byteTx, NULL, 1);
+
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool escribirBufferRegistroBus(const bus_t *bus, uint8_t reg, uint8_t *datoTx,
+**                                                 uint8_t longitud)
+**  Descripcion:    Pasa la escritura al modelo del bus
+**  Parametros:     Puntero al bus, registro, datos a escribir, longitud
+**  Retorno:        True si lo ha aceptado el modelo
+****************************************************************************************/
+bool escribirBufferRegistroBus(const bus_t *bus, uint8_t reg, uint8_t *datoTx, uint8_t longitud)
+{
+    if (transferenciaBusSITL != NULL)
+        return transferenciaBusSITL(bus, reg, datoTx, NULL, longitud);
+
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool leerRegistroBus(const bus_t *bus, uint8_t reg, uint8_t *byteRx)
+**  Descripcion:    Pasa la lectura al modelo del bus
+**  Parametros:     Puntero al bus, registro, byte leido
+**  Retorno:        True si ha respondido el modelo
+****************************************************************************************/
+bool leerRegistroBus(const bus_t *bus, uint8_t reg, uint8_t *byteRx)
+{
+    *byteRx = 0;
+
+    if (transferenciaBusSITL != NULL)
+        return transferenciaBusSITL(bus, reg, NULL, byteRx, 1);
+
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool leerBufferRegistroBus(const bus_t *bus, uint8_t reg, uint8_t *datoRx,
+**                                             uint8_t longitud)
+**  Descripcion:    Pasa la lectura al modelo del bus
+**  Parametros:     Puntero al bus, registro, datos leidos, longitud
+**  Retorno:        True si ha respondido el modelo
+****************************************************************************************/
+bool leerBufferRegistroBus(const bus_t *bus, uint8_t reg, uint8_t *datoRx, uint8_t longitud)
+{
+    memset(datoRx, 0, longitud);
+
+    if (transferenciaBusSITL != NULL)
+        return transferenciaBusSITL(bus, reg, NULL, datoRx, longitud);
+
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool encolarTransaccionBus(transaccionBus_t *transaccion)
+**  Descripcion:    Las transacciones SPI van a la cola real sobre el SPI simulado
+**  Parametros:     Transaccion
+**  Retorno:        True si se ha encolado
+****************************************************************************************/
+bool encolarTransaccionBus(transaccionBus_t *transaccion)
+{
+    if (transaccion->bus->tipo != BUS_SPI)
+        return false;
+
+    return encolarTransaccionSPI(transaccion);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void ajustarRelojSPI(numSPI_e numSPI, divisorRelojSPI_e divisor)
+**  Descripcion:    No hay buses en SITL
+**  Parametros:     Numero de SPI, divisor
+**  Retorno:        Ninguno
+****************************************************************************************/
+void ajustarRelojSPI(numSPI_e numSPI, divisorRelojSPI_e divisor)
+{
+    UNUSED(numSPI);
+    UNUSED(divisor);
+}
+
+
+/***************************************************************************************
+**  Nombre:         tim_t *timerPorTag(uint8_t tag, bool *encontrado)
+**  Descripcion:    No hay timers en SITL
+**  Parametros:     Tag del pin, encontrado
+**  Retorno:        Siempre NULL
+****************************************************************************************/
+tim_t *timerPorTag(uint8_t tag, bool *encontrado)
+{
+    UNUSED(tag);
+    *encontrado = false;
+    return NULL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool iniciarTimer(numTimer_e numTimer, uint8_t pin, usoTimer_e uso)
+**  Descripcion:    No hay timers en SITL
+**  Parametros:     Numero de timer, pin, uso
+**  Retorno:        Siempre false
+****************************************************************************************/
+bool iniciarTimer(numTimer_e numTimer, uint8_t pin, usoTimer_e uso)
+{
+    UNUSED(numTimer);
+    UNUSED(pin);
+    UNUSED(uso);
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool configurarSalidaPWMtimer(tim_t *dTim, canal_t *canal, uint32_t frec,
+**                                                uint16_t periodo, uint16_t pulsoReposo, bool inversion)
+**  Descripcion:    No hay timers en SITL
+**  Parametros:     Timer, canal, frecuencia, periodo, pulso en reposo, inversion
+**  Retorno:        Siempre false
+****************************************************************************************/
+bool configurarSalidaPWMtimer(tim_t *dTim, canal_t *canal, uint32_t frec, uint16_t periodo, uint16_t pulsoReposo, bool inversion)
+{
+    UNUSED(dTim);
+    UNUSED(canal);
+    UNUSED(frec);
+    UNUSED(periodo);
+    UNUSED(pulsoReposo);
+    UNUSED(inversion);
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void forzarOverflowTimer(tim_t *dTim)
+**  Descripcion:    No hay timers en SITL
+**  Parametros:     Timer
+**  Retorno:        Ninguno
+****************************************************************************************/
+void forzarOverflowTimer(tim_t *dTim)
+{
+    UNUSED(dTim);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void conectarBusSITL(transferenciaBusSITL_t transferencia)
+**  Descripcion:    Conecta un modelo a las transferencias de registros del bus. Con NULL
+**                  no hay ningun dispositivo
+**  Parametros:     Funcion del modelo
+**  Retorno:        Ninguno
+****************************************************************************************/
+void conectarBusSITL(transferenciaBusSITL_t transferencia)
+{
+    transferenciaBusSITL = transferencia;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void conectarSDSITL(const tablaFnSD_t *tabla)
+**  Descripcion:    Conecta un modelo de tarjeta SD. Con NULL no hay tarjeta
+**  Parametros:     Tabla de funciones del modelo
+**  Retorno:        Ninguno
+****************************************************************************************/
+void conectarSDSITL(const tablaFnSD_t *tabla)
+{
+    tablaFnSDsitl = tabla;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void conectarUSBSITL(capturaUSBSITL_t captura)
+**  Descripcion:    Abre el puerto USB simulado. Con NULL queda desconectado
+**  Parametros:     Funcion que recibe los datos transmitidos
+**  Retorno:        Ninguno
+****************************************************************************************/
+void conectarUSBSITL(capturaUSBSITL_t captura)
+{
+    capturaUSBSITL = captura;
+    iniciarBufferAnillo(&anilloRxUSBSITL, bufferRxUSBSITL, TAM_RX_USB_SITL);
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t inyectarUSBSITL(const uint8_t *dato, uint32_t longitud)
+**  Descripcion:    Pone datos en la recepcion del USB simulado, como si los mandara el PC
+**  Parametros:     Datos, longitud
+**  Retorno:        Bytes que caben
+****************************************************************************************/
+uint32_t inyectarUSBSITL(const uint8_t *dato, uint32_t longitud)
+{
+    if (capturaUSBSITL == NULL)
+        return 0;
+
+    return escribirBufferAnillo(&anilloRxUSBSITL, dato, longitud);
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t escribirBufferUSB(const uint8_t *datoTx, uint32_t longitud)
+**  Descripcion:    Pasa los datos a la captura. Sin captura el USB no esta conectado
+**  Parametros:     Datos a escribir, longitud
+**  Retorno:        Bytes escritos
+****************************************************************************************/
+uint32_t escribirBufferUSB(const uint8_t *datoTx, uint32_t longitud)
+{
+    if (capturaUSBSITL == NULL)
+        return 0;
+
+    capturaUSBSITL(datoTx, longitud);
+    return longitud;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t reservarBufferTxUSB(uint8_t **bloque, uint32_t longitud)
+**  Descripcion:    Da un buffer temporal que se pasa a la captura al publicarlo
+**  Parametros:     Puntero al tramo, bytes que se quieren escribir
+**  Retorno:        Bytes disponibles en el tramo
+****************************************************************************************/
+uint32_t reservarBufferTxUSB(uint8_t **bloque, uint32_t longitud)
+{
+    *bloque = bufferTxUSBSITL;
+
+    if (capturaUSBSITL == NULL)
+        return 0;
+
+    return longitud < TAMANIO_BUFFER_TX_USB ? longitud : TAMANIO_BUFFER_TX_USB;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void publicarBufferTxUSB(uint32_t longitud)
+**  Descripcion:    Pasa a la captura lo escrito en el tramo reservado
+**  Parametros:     Bytes escritos
+**  Retorno:        Ninguno
+****************************************************************************************/
+void publicarBufferTxUSB(uint32_t longitud)
+{
+    escribirBufferUSB(bufferTxUSBSITL, longitud);
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t bytesLibresBufferTxUSB(void)
+**  Descripcion:    La captura se lleva los datos al momento, asi que el buffer esta vacio
+**  Parametros:     Ninguno
+**  Retorno:        Numero de bytes libres
+****************************************************************************************/
+uint32_t bytesLibresBufferTxUSB(void)
+{
+    return capturaUSBSITL != NULL ? TAMANIO_BUFFER_TX_USB : 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         int16_t leerUSB(void)
+**  Descripcion:    Lee un byte inyectado
+**  Parametros:     Ninguno
+**  Retorno:        Dato leido o -1 si no hay
+****************************************************************************************/
+int16_t leerUSB(void)
+{
+    const uint8_t *bloque;
+
+    if (capturaUSBSITL == NULL || bloqueBufferAnillo(&anilloRxUSBSITL, &bloque) == 0)
+        return -1;
+
+    const int16_t dato = bloque[0];
+    consumirBufferAnillo(&anilloRxUSBSITL, 1);
+    return dato;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t bytesRecibidosUSB(void)
+**  Descripcion:    Devuelve los bytes inyectados pendientes de leer
+**  Parametros:     Ninguno
+**  Retorno:        Numero de bytes
+****************************************************************************************/
+uint32_t bytesRecibidosUSB(void)
+{
+    if (capturaUSBSITL == NULL)
+        return 0;
+
+    return bytesOcupadosBufferAnillo(&anilloRxUSBSITL);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool sondearSD(void)
+**  Descripcion:    Avanza el modelo de SD conectado
+**  Parametros:     Ninguno
+**  Retorno:        True si hay tarjeta y esta lista
+****************************************************************************************/
+bool sondearSD(void)
+{
+    return tablaFnSDsitl != NULL && tablaFnSDsitl->sondearSD();
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool leerBloqueSD(uint32_t indice, uint8_t *buffer, callbackOpCompletaSD_c callback,
+**                                    uint32_t datoCallback)
+**  Descripcion:    Lee un bloque del modelo de SD conectado
+**  Parametros:     Indice del bloque, buffer, callback, dato del callback
+**  Retorno:        False si no hay tarjeta o esta ocupada
+****************************************************************************************/
+bool leerBloqueSD(uint32_t indice, uint8_t *buffer, callbackOpCompletaSD_c callback, uint32_t datoCallback)
+{
+    if (tablaFnSDsitl == NULL)
+        return false;
+
+    return tablaFnSDsitl->leerBloqueSD(indice, buffer, callback, datoCallback);
+}
+
+
+/***************************************************************************************
+**  Nombre:         estadoOperacionSD_e iniciarEscrituraBloquesSD(uint32_t indice, uint32_t numBloques)
+**  Descripcion:    Anuncia una escritura de bloques consecutivos al modelo de SD conectado
+**  Parametros:     Indice del primer bloque, numero de bloques
+**  Retorno:        Estado de la operacion. Fallo si no hay tarjeta
+****************************************************************************************/
+estadoOperacionSD_e iniciarEscrituraBloquesSD(uint32_t indice, uint32_t numBloques)
+{
+    if (tablaFnSDsitl == NULL)
+        return SD_OPERACION_FALLO;
+
+    return tablaFnSDsitl->iniciarEscrituraBloquesSD(indice, numBloques);
+}
+
+
+/***************************************************************************************
+**  Nombre:         estadoOperacionSD_e escribirBloqueSD(uint32_t indice, uint8_t *buffer,
+**                                                       callbackOpCompletaSD_c callback, uint32_t datoCallback)
+**  Descripcion:    Escribe un bloque en el modelo de SD conectado
+**  Parametros:     Indice del bloque, buffer, callback, dato del callback
+**  Retorno:        Estado de la operacion. Fallo si no hay tarjeta
+****************************************************************************************/
+estadoOperacionSD_e escribirBloqueSD(uint32_t indice, uint8_t *buffer, callbackOpCompletaSD_c callback, uint32_t datoCallback)
+{
+    if (tablaFnSDsitl == NULL)
+        return SD_OPERACION_FALLO;
+
+    return tablaFnSDsitl->escribirBloqueSD(indice, buffer, callback, datoCallback);
+}
+
+
+/***************************************************************************************
+**  Nombre:         estadoOperacionSD_e escribirBloquesSD(uint32_t indice, uint8_t *buffer, uint16_t numBloques,
+**                                                        callbackOpCompletaSD_c callback, uint32_t datoCallback)
+**  Descripcion:    Escribe varios bloques con un comando en el modelo de SD conectado
+**  Parametros:     Indice del primer bloque, buffer, numero de bloques, callback, dato del callback
+**  Retorno:        Estado de la operacion. Fallo si no hay tarjeta
+****************************************************************************************/
+estadoOperacionSD_e escribirBloquesSD(uint32_t indice, uint8_t *buffer, uint16_t numBloques, callbackOpCompletaSD_c callback, uint32_t datoCallback)
+{
+    if (tablaFnSDsitl == NULL)
+        return SD_OPERACION_FALLO;
+
+    return tablaFnSDsitl->escribirBloquesSD(indice, buffer, numBloques, callback, datoCallback);
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t maxBloquesEscrituraSD(void)
+**  Descripcion:    Bloques por comando del modelo de SD conectado
+**  Parametros:     Ninguno
+**  Retorno:        Numero de bloques
+****************************************************************************************/
+uint16_t maxBloquesEscrituraSD(void)
+{
+    return tablaFnSDsitl ? tablaFnSDsitl->maxBloquesEscritura : 1;
+}
+
+#endif
@@ -0,0 +1,264 @@
+/***************************************************************************************
+**  espectro_sitl.c - Analisis del espectro de logs de giro en el PC
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "espectro_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "Filtros/analizador_espectro.h"
+#include "GP/gp.h"
+#include "GP/gp_imu.h"
+#include "Comun/util.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define TAM_LINEA_ESPECTRO_SITL            4096
+#define MAX_COLUMNAS_ESPECTRO_SITL         256
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    int16_t columnaTiempo;
+    int16_t columnaGiro[3];
+    float *giro;                         // Tres ejes por muestra
+    uint32_t numMuestras;
+    float frecMuestreo;
+} logGiroSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool leerLogGiroSITL(const char *fichero, logGiroSITL_t *log);
+uint16_t separarLineaEspectroSITL(char *linea, char **columnas);
+int comparaFloatEspectroSITL(const void *a, const void *b);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool analizarLogGiroSITL(const char *fichero, float frecEsperada)
+**  Descripcion:    Analiza el log y muestra los picos de cada eje del ultimo analisis y
+**                  la frecuencia dominante que seguirian los notch
+**  Parametros:     Ruta del CSV, frecuencia del pico esperado (0 para no comprobar)
+**  Retorno:        True si se ha podido analizar y los ejes con picos coinciden con la
+**                  frecuencia esperada
+****************************************************************************************/
+bool analizarLogGiroSITL(const char *fichero, float frecEsperada)
+{
+    static analizadorEspectro_t analizador;
+    logGiroSITL_t log;
+    uint8_t eje;
+    bool ok = true;
+    uint8_t ejesConPicos = 0;
+
+    if (!leerLogGiroSITL(fichero, &log))
+        return false;
+
+    // El rango de busqueda es el de la configuracion por defecto
+    resetearTodosGP();
+
+    if (!iniciarAnalizadorEspectro(&analizador, log.frecMuestreo, configNotchDinamico()->frecMin, configNotchDinamico()->frecMax)) {
+        fprintf(stderr, "Rango de busqueda no valido para %.1f Hz\n", (double)log.frecMuestreo);
+        free(log.giro);
+        return false;
+    }
+
+    for (uint32_t n = 0; n < log.numMuestras; n++) {
+        anadirMuestraAnalizadorEspectro(&analizador, &log.giro[3 * n]);
+        actualizarAnalizadorEspectro(&analizador, &eje);
+    }
+
+    free(log.giro);
+
+    printf("espectro muestras=%u frec_muestreo_hz=%.1f diezmado=%u resolucion_hz=%.2f analisis=%u\n", log.numMuestras,
+           (double)log.frecMuestreo, analizador.diezmado, (double)analizador.resolucion, analizador.numAnalisis);
+
+    for (uint8_t i = 0; i < 3; i++) {
+        printf("eje=%u dominante_hz=%.1f picos=", i, (double)analizador.frecDominante[i]);
+        for (uint8_t j = 0; j < analizador.numPicos[i]; j++)
+            printf("%s%.1f:%.3g", j > 0 ? "," : "", (double)analizador.picos[i][j].frecuencia, (double)analizador.picos[i][j].magnitud);
+        printf("\n");
+
+        if (analizador.numPicos[i] > 0) {
+            ejesConPicos++;
+            if (frecEsperada > 0 && fabsf(analizador.frecDominante[i] - frecEsperada) > TOLERANCIA_PICO_ESPECTRO_SITL * frecEsperada)
+                ok = false;
+        }
+    }
+
+    return ok && (frecEsperada <= 0 || ejesConPicos > 0);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool leerLogGiroSITL(const char *fichero, logGiroSITL_t *log)
+**  Descripcion:    Lee las columnas de tiempo y giro del CSV. Las filas sin giro (frames
+**                  lentos o eventos de la blackbox) se saltan
+**  Parametros:     Ruta del CSV, log leido
+**  Retorno:        True si ok
+****************************************************************************************/
+bool leerLogGiroSITL(const char *fichero, logGiroSITL_t *log)
+{
+    FILE *entrada = fopen(fichero, "r");
+    static char linea[TAM_LINEA_ESPECTRO_SITL];
+    char *columnas[MAX_COLUMNAS_ESPECTRO_SITL];
+    uint32_t capacidad = 0;
+    float *periodos = NULL;
+    double tiempoAnterior = -1;
+
+    memset(log, 0, sizeof(logGiroSITL_t));
+    log->columnaTiempo = -1;
+    log->columnaGiro[0] = log->columnaGiro[1] = log->columnaGiro[2] = -1;
+
+    if (entrada == NULL) {
+        fprintf(stderr, "No se puede abrir %s\n", fichero);
+        return false;
+    }
+
+    // Cabecera
+    if (fgets(linea, sizeof(linea), entrada) != NULL) {
+        const uint16_t numColumnas = separarLineaEspectroSITL(linea, columnas);
+
+        for (uint16_t i = 0, eje = 0; i < numColumnas; i++) {
+            if (strcmp(columnas[i], "tiempo") == 0)
+                log->columnaTiempo = i;
+            else if (eje < 3 && strncmp(columnas[i], "giro", 4) == 0)
+                log->columnaGiro[eje++] = i;
+        }
+    }
+
+    if (log->columnaTiempo < 0 || log->columnaGiro[2] < 0) {
+        fprintf(stderr, "Faltan las columnas tiempo y giro en %s\n", fichero);
+        fclose(entrada);
+        return false;
+    }
+
+    while (fgets(linea, sizeof(linea), entrada) != NULL) {
+        const uint16_t numColumnas = separarLineaEspectroSITL(linea, columnas);
+
+        if (numColumnas <= log->columnaTiempo || numColumnas <= log->columnaGiro[2] || columnas[log->columnaGiro[0]][0] == '\0')
+            continue;
+
+        if (log->numMuestras == capacidad) {
+            capacidad = capacidad > 0 ? 2 * capacidad : 4096;
+            log->giro = realloc(log->giro, 3 * capacidad * sizeof(float));
+            periodos = realloc(periodos, capacidad * sizeof(float));
+            if (log->giro == NULL || periodos == NULL) {
+                fclose(entrada);
+                free(log->giro);
+                free(periodos);
+                return false;
+            }
+        }
+
+        const double tiempo = strtod(columnas[log->columnaTiempo], NULL);
+        if (tiempoAnterior >= 0)
+            periodos[log->numMuestras - 1] = tiempo - tiempoAnterior;
+        tiempoAnterior = tiempo;
+
+        for (uint8_t i = 0; i < 3; i++)
+            log->giro[3 * log->numMuestras + i] = strtof(columnas[log->columnaGiro[i]], NULL);
+        log->numMuestras++;
+    }
+
+    fclose(entrada);
+
+    // Se usa la mediana del periodo para que los huecos del log no cambien la frecuencia
+    if (log->numMuestras > 1) {
+        qsort(periodos, log->numMuestras - 1, sizeof(float), comparaFloatEspectroSITL);
+        const float periodo = periodos[(log->numMuestras - 1) / 2];
+        log->frecMuestreo = periodo > 0 ? 1e6f / periodo : 0;
+    }
+
+    free(periodos);
+
+    if (log->frecMuestreo <= 0) {
+        fprintf(stderr, "No hay muestras suficientes en %s\n", fichero);
+        free(log->giro);
+        return false;
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t separarLineaEspectroSITL(char *linea, char **columnas)
+**  Descripcion:    Separa una linea del CSV por comas (se modifica la linea)
+**  Parametros:     Linea, punteros a las columnas
+**  Retorno:        Numero de columnas
+****************************************************************************************/
+uint16_t separarLineaEspectroSITL(char *linea, char **columnas)
+{
+    uint16_t numColumnas = 0;
+
+    linea[strcspn(linea, "\r\n")] = '\0';
+    columnas[numColumnas++] = linea;
+
+    for (char *p = linea; *p != '\0' && numColumnas < MAX_COLUMNAS_ESPECTRO_SITL; p++) {
+        if (*p == ',') {
+            *p = '\0';
+            columnas[numColumnas++] = p + 1;
+        }
+    }
+
+    return numColumnas;
+}
+
+
+/***************************************************************************************
+**  Nombre:         int comparaFloatEspectroSITL(const void *a, const void *b)
+**  Descripcion:    Comparacion para qsort
+**  Parametros:     Elementos a comparar
+**  Retorno:        Orden
+****************************************************************************************/
+int comparaFloatEspectroSITL(const void *a, const void *b)
+{
+    const float fa = *(const float *)a;
+    const float fb = *(const float *)b;
+
+    return (fa > fb) - (fa < fb);
+}
+
+#endif
@@ -0,0 +1,65 @@
+/***************************************************************************************
+**  espectro_sitl.h - Analisis del espectro de logs de giro en el PC
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __ESPECTRO_SITL_H
+#define __ESPECTRO_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Pasa un log de giro en CSV por el analizador de espectro del notch dinamico, con el
+ * mismo reparto en pasos que en el scheduler (un paso por muestra). El CSV debe tener
+ * cabecera con una columna "tiempo" en us y las tres primeras columnas que empiezan por
+ * "giro" son los ejes, como en la salida del decodificador de la blackbox. La frecuencia
+ * de muestreo se saca de los tiempos
+ */
+#define TOLERANCIA_PICO_ESPECTRO_SITL      0.05f   // Error relativo admitido respecto al pico esperado
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool analizarLogGiroSITL(const char *fichero, float frecEsperada);
+
+#endif // __ESPECTRO_SITL_H
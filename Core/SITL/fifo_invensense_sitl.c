@@ -0,0 +1,432 @@
+/***************************************************************************************
+**  fifo_invensense_sitl.c - Prueba del decodificador de la FIFO de las IMU Invensense
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "fifo_invensense_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Sensores/IMU/fifo_invensense.h"
+#include "Comun/matematicas.h"
+#include "Comun/util.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define MAX_TAM_FIFO_SITL                 TAM_FIFO_ICM20689_INVENSENSE
+#define PERIODO_MUESTRA_FIFO_SITL         125          // us, FIFO a 8 kHz como en el driver
+#define MUESTRAS_RAFAGA_FIFO_SITL         16           // INVENSENSE_FIFO_BUFFER_LEN del driver
+#define INTERVALO_MIN_FIFO_SITL           100          // us entre lecturas normales
+#define INTERVALO_MAX_FIFO_SITL           1500
+#define PORCENTAJE_PARADAS_FIFO_SITL      3            // Lecturas tras una parada que puede desbordar la FIFO
+#define PORCENTAJE_PARTIDAS_FIFO_SITL     3            // Rafagas que se llevan bytes de mas
+#define SEMILLA_FIFO_SITL                 0x1F1F0
+#define TAM_LINEA_FIFO_SITL               8192
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    const char *nombre;
+    uint16_t tam;
+} modeloFifoSITL_t;
+
+typedef struct {
+    uint8_t datos[MAX_TAM_FIFO_SITL];
+    uint16_t tam;
+    uint16_t inicio;                     // Byte mas antiguo
+    uint16_t bytes;
+    uint32_t siguienteMuestra;           // Numero de orden de la proxima muestra
+    bool desbordada;                     // Se han descartado bytes desde el ultimo reseteo
+    bool partida;                        // Se ha leido parte de una muestra
+} sensorFifoSITL_t;
+
+typedef struct {
+    uint32_t rafagas;
+    uint32_t muestras;
+    uint32_t perdidas;                   // Muestras que no se leen por los reseteos
+    uint32_t desbordes;
+    uint32_t partidas;
+    uint32_t reseteos;
+    uint32_t errores;
+    uint16_t maxBytes;                   // Maximo contador aceptado sin resetear
+} registroFifoSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static const modeloFifoSITL_t modelosFifoSITL[] = {
+    { "MPU6000",  TAM_FIFO_MPU6000_INVENSENSE },
+    { "MPU9250",  TAM_FIFO_MPU9250_INVENSENSE },
+    { "ICM20602", TAM_FIFO_ICM20602_INVENSENSE },
+    { "ICM20689", TAM_FIFO_ICM20689_INVENSENSE },
+    { "ICM20789", TAM_FIFO_ICM20789_INVENSENSE },
+};
+
+static sensorFifoSITL_t sensorFifoSITL;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarModeloFifoSITL(const modeloFifoSITL_t *modelo, uint32_t numRafagas, uint32_t *semilla);
+bool probarFicheroFifoSITL(const char *fichero);
+void escribirMuestraFifoSITL(sensorFifoSITL_t *sensor);
+void leerBytesFifoSITL(sensorFifoSITL_t *sensor, uint8_t *buffer, uint16_t longitud);
+void resetearFifoSITL(sensorFifoSITL_t *sensor);
+void generarMuestraFifoSITL(uint32_t numero, muestraFifoInvensense_t muestra);
+bool numeroMuestraFifoSITL(const muestraFifoInvensense_t muestra, uint32_t *numero);
+static inline uint32_t aleatorioFifoSITL(uint32_t *semilla);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool probarFifoInvensenseSITL(const char *datos)
+**  Descripcion:    Prueba el decodificador con rafagas generadas para cada modelo o con
+**                  rafagas grabadas
+**  Parametros:     Fichero con rafagas o numero de rafagas a generar por modelo
+**  Retorno:        True si ok
+****************************************************************************************/
+bool probarFifoInvensenseSITL(const char *datos)
+{
+    char *fin;
+    const uint32_t numRafagas = strtoul(datos, &fin, 0);
+    uint32_t semilla = SEMILLA_FIFO_SITL;
+    bool ok = true;
+
+    if (*fin != '\0')
+        return probarFicheroFifoSITL(datos);
+
+    for (uint8_t i = 0; i < LONG_ARRAY(modelosFifoSITL); i++)
+        ok &= probarModeloFifoSITL(&modelosFifoSITL[i], numRafagas, &semilla);
+
+    return ok;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool probarModeloFifoSITL(const modeloFifoSITL_t *modelo, uint32_t numRafagas,
+**                                            uint32_t *semilla)
+**  Descripcion:    Lee la FIFO simulada de un modelo como el driver y comprueba las
+**                  muestras decodificadas y los reseteos
+**  Parametros:     Modelo, numero de lecturas, semilla
+**  Retorno:        True si no hay errores
+****************************************************************************************/
+bool probarModeloFifoSITL(const modeloFifoSITL_t *modelo, uint32_t numRafagas, uint32_t *semilla)
+{
+    sensorFifoSITL_t *sensor = &sensorFifoSITL;
+    registroFifoSITL_t registro;
+    uint32_t tiempo = 0, tiempoMuestra = 0, esperada = 0;
+    bool sincronizada = true;
+
+    memset(sensor, 0, sizeof(sensorFifoSITL_t));
+    memset(&registro, 0, sizeof(registro));
+    sensor->tam = modelo->tam;
+
+    for (uint32_t r = 0; r < numRafagas; r++) {
+        uint8_t buffer[MUESTRAS_RAFAGA_FIFO_SITL * TAM_MUESTRA_FIFO_INVENSENSE + TAM_MUESTRA_FIFO_INVENSENSE];
+        muestraFifoInvensense_t muestras[MUESTRAS_RAFAGA_FIFO_SITL];
+
+        // Las paradas llegan hasta el doble de lo que tarda en llenarse la FIFO
+        if (aleatorioFifoSITL(semilla) % 100 < PORCENTAJE_PARADAS_FIFO_SITL)
+            tiempo += aleatorioFifoSITL(semilla) % (2 * (modelo->tam / TAM_MUESTRA_FIFO_INVENSENSE) * PERIODO_MUESTRA_FIFO_SITL);
+        else
+            tiempo += INTERVALO_MIN_FIFO_SITL + aleatorioFifoSITL(semilla) % (INTERVALO_MAX_FIFO_SITL - INTERVALO_MIN_FIFO_SITL);
+
+        for (; tiempo - tiempoMuestra >= PERIODO_MUESTRA_FIFO_SITL; tiempoMuestra += PERIODO_MUESTRA_FIFO_SITL)
+            escribirMuestraFifoSITL(sensor);
+
+        // Contador en big endian como en FIFO_COUNTH/L
+        const uint8_t cuentaRaw[2] = { sensor->bytes >> 8, sensor->bytes & 0xFF };
+        const uint16_t bytes = leerCuentaFifoInvensense(cuentaRaw);
+        const bool debeResetear = sensor->desbordada || sensor->partida || modelo->tam - bytes < TAM_MUESTRA_FIFO_INVENSENSE;
+        const bool resetear = fifoInvensenseDesbordada(bytes, modelo->tam) || !fifoInvensenseAlineada(bytes);
+
+        registro.rafagas++;
+        if (resetear != debeResetear || bytes != sensor->bytes)
+            registro.errores++;
+
+        if (resetear) {
+            registro.reseteos++;
+            registro.desbordes += sensor->desbordada;
+            registro.partidas += sensor->partida;
+            resetearFifoSITL(sensor);
+            sincronizada = false;
+            continue;
+        }
+
+        registro.maxBytes = MAX(registro.maxBytes, bytes);
+
+        const uint16_t enCola = bytes / TAM_MUESTRA_FIFO_INVENSENSE;
+        const uint16_t aLeer = MIN(enCola, MUESTRAS_RAFAGA_FIFO_SITL);
+        if (aLeer == 0)
+            continue;
+
+        // Algunas rafagas se llevan parte de la muestra siguiente
+        uint16_t longitud = aLeer * TAM_MUESTRA_FIFO_INVENSENSE;
+        if (aleatorioFifoSITL(semilla) % 100 < PORCENTAJE_PARTIDAS_FIFO_SITL)
+            longitud += MIN(1 + aleatorioFifoSITL(semilla) % (TAM_MUESTRA_FIFO_INVENSENSE - 1), bytes - longitud);
+
+        leerBytesFifoSITL(sensor, buffer, longitud);
+        const uint16_t numMuestras = parsearFifoInvensense(buffer, longitud, muestras, MUESTRAS_RAFAGA_FIFO_SITL);
+        if (numMuestras != aLeer)
+            registro.errores++;
+
+        for (uint16_t i = 0; i < numMuestras; i++) {
+            uint32_t numero;
+
+            if (!numeroMuestraFifoSITL(muestras[i], &numero) || (sincronizada && numero != esperada) || numero < esperada) {
+                registro.errores++;
+                continue;
+            }
+
+            // Tras un reseteo se pierden las muestras que hubiera en la FIFO
+            registro.perdidas += numero - esperada;
+            registro.muestras++;
+            esperada = numero + 1;
+            sincronizada = true;
+        }
+    }
+
+    printf("fifo_invensense modelo=%s tam=%u rafagas=%u muestras=%u max_bytes=%u desbordes=%u partidas=%u reseteos=%u perdidas=%u errores=%u\n",
+           modelo->nombre, modelo->tam, registro.rafagas, registro.muestras, registro.maxBytes, registro.desbordes,
+           registro.partidas, registro.reseteos, registro.perdidas, registro.errores);
+
+    return registro.errores == 0 && (numRafagas == 0 || registro.muestras > 0);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool probarFicheroFifoSITL(const char *fichero)
+**  Descripcion:    Decodifica rafagas grabadas. Cada linea tiene el tamanio de la FIFO, el
+**                  contador leido y los bytes de la rafaga en hexadecimal
+**  Parametros:     Fichero
+**  Retorno:        True si se ha decodificado alguna muestra sin errores
+****************************************************************************************/
+bool probarFicheroFifoSITL(const char *fichero)
+{
+    FILE *entrada = fopen(fichero, "r");
+    static char linea[TAM_LINEA_FIFO_SITL];
+    registroFifoSITL_t registro;
+    uint32_t incompletas = 0, cortas = 0;
+
+    if (entrada == NULL) {
+        fprintf(stderr, "No se puede abrir %s\n", fichero);
+        return false;
+    }
+
+    memset(&registro, 0, sizeof(registro));
+
+    while (fgets(linea, sizeof(linea), entrada) != NULL) {
+        uint8_t buffer[MUESTRAS_RAFAGA_FIFO_SITL * TAM_MUESTRA_FIFO_INVENSENSE + TAM_MUESTRA_FIFO_INVENSENSE];
+        muestraFifoInvensense_t muestras[MUESTRAS_RAFAGA_FIFO_SITL];
+        uint16_t longitud = 0;
+        char *p = linea, *fin;
+
+        if (linea[0] == '#' || linea[0] == '\n' || linea[0] == '\r')
+            continue;
+
+        const uint16_t tam = strtoul(p, &fin, 0);
+        if (fin == p || tam == 0)
+            continue;
+
+        p = fin;
+        const uint16_t cuenta = strtoul(p, &fin, 0);
+        if (fin == p)
+            continue;
+
+        for (p = fin; longitud < sizeof(buffer); p = fin) {
+            const uint32_t dato = strtoul(p, &fin, 16);
+            if (fin == p)
+                break;
+
+            buffer[longitud++] = dato;
+        }
+
+        const uint8_t cuentaRaw[2] = { cuenta >> 8, cuenta & 0xFF };
+        const uint16_t bytes = leerCuentaFifoInvensense(cuentaRaw);
+
+        registro.rafagas++;
+        if (fifoInvensenseDesbordada(bytes, tam)) {
+            registro.desbordes++;
+            registro.reseteos++;
+            continue;
+        }
+
+        if (!fifoInvensenseAlineada(bytes)) {
+            registro.partidas++;
+            registro.reseteos++;
+            continue;
+        }
+
+        registro.maxBytes = MAX(registro.maxBytes, bytes);
+
+        // Una rafaga grabada mas corta que lo que anuncia el contador termina en una
+        // muestra incompleta que no se debe decodificar
+        const uint16_t aLeer = MIN(bytes / TAM_MUESTRA_FIFO_INVENSENSE, MUESTRAS_RAFAGA_FIFO_SITL);
+        const uint16_t numMuestras = parsearFifoInvensense(buffer, longitud, muestras, MUESTRAS_RAFAGA_FIFO_SITL);
+
+        incompletas += (longitud % TAM_MUESTRA_FIFO_INVENSENSE) != 0;
+        cortas += longitud < aLeer * TAM_MUESTRA_FIFO_INVENSENSE;
+        if (numMuestras != MIN(longitud / TAM_MUESTRA_FIFO_INVENSENSE, MUESTRAS_RAFAGA_FIFO_SITL))
+            registro.errores++;
+
+        registro.muestras += numMuestras;
+    }
+
+    fclose(entrada);
+
+    printf("fifo_invensense fichero=%s rafagas=%u muestras=%u max_bytes=%u desbordes=%u desalineadas=%u reseteos=%u incompletas=%u cortas=%u errores=%u\n",
+           fichero, registro.rafagas, registro.muestras, registro.maxBytes, registro.desbordes, registro.partidas,
+           registro.reseteos, incompletas, cortas, registro.errores);
+
+    return registro.errores == 0 && registro.muestras > 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void escribirMuestraFifoSITL(sensorFifoSITL_t *sensor)
+**  Descripcion:    Escribe la siguiente muestra en la FIFO simulada. Si no cabe se
+**                  descartan los bytes mas antiguos, como hace el sensor
+**  Parametros:     Sensor
+**  Retorno:        Ninguno
+****************************************************************************************/
+void escribirMuestraFifoSITL(sensorFifoSITL_t *sensor)
+{
+    muestraFifoInvensense_t muestra;
+
+    generarMuestraFifoSITL(sensor->siguienteMuestra++, muestra);
+
+    for (uint8_t i = 0; i < TAM_MUESTRA_FIFO_INVENSENSE; i++) {
+        const uint16_t valor = (uint16_t)muestra[i / 2];
+        const uint8_t dato = (i % 2) == 0 ? valor >> 8 : valor & 0xFF;
+
+        if (sensor->bytes == sensor->tam) {
+            sensor->inicio = (sensor->inicio + 1) % sensor->tam;
+            sensor->bytes--;
+            sensor->desbordada = true;
+        }
+
+        sensor->datos[(sensor->inicio + sensor->bytes) % sensor->tam] = dato;
+        sensor->bytes++;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void leerBytesFifoSITL(sensorFifoSITL_t *sensor, uint8_t *buffer, uint16_t longitud)
+**  Descripcion:    Lee bytes de la FIFO simulada. Si no se lee un numero entero de
+**                  muestras la FIFO queda desalineada
+**  Parametros:     Sensor, destino, bytes a leer
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerBytesFifoSITL(sensorFifoSITL_t *sensor, uint8_t *buffer, uint16_t longitud)
+{
+    for (uint16_t i = 0; i < longitud && sensor->bytes > 0; i++) {
+        buffer[i] = sensor->datos[sensor->inicio];
+        sensor->inicio = (sensor->inicio + 1) % sensor->tam;
+        sensor->bytes--;
+    }
+
+    if ((longitud % TAM_MUESTRA_FIFO_INVENSENSE) != 0)
+        sensor->partida = true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void resetearFifoSITL(sensorFifoSITL_t *sensor)
+**  Descripcion:    Vacia la FIFO simulada como el bit FIFO_RESET
+**  Parametros:     Sensor
+**  Retorno:        Ninguno
+****************************************************************************************/
+void resetearFifoSITL(sensorFifoSITL_t *sensor)
+{
+    sensor->inicio = 0;
+    sensor->bytes = 0;
+    sensor->desbordada = false;
+    sensor->partida = false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void generarMuestraFifoSITL(uint32_t numero, muestraFifoInvensense_t muestra)
+**  Descripcion:    Genera una muestra con su numero de orden en los dos primeros ejes y una
+**                  firma en el resto para detectar las desalineadas
+**  Parametros:     Numero de orden, muestra
+**  Retorno:        Ninguno
+****************************************************************************************/
+void generarMuestraFifoSITL(uint32_t numero, muestraFifoInvensense_t muestra)
+{
+    const uint32_t firma = numero * 2654435761u;
+
+    muestra[0] = (int16_t)(numero & 0xFFFF);
+    muestra[1] = (int16_t)(numero >> 16);
+    for (uint8_t i = 2; i < NUM_EJES_FIFO_INVENSENSE; i++)
+        muestra[i] = (int16_t)(firma >> (3 * i));
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool numeroMuestraFifoSITL(const muestraFifoInvensense_t muestra, uint32_t *numero)
+**  Descripcion:    Recupera el numero de orden de una muestra decodificada
+**  Parametros:     Muestra, numero de orden
+**  Retorno:        True si la firma coincide
+****************************************************************************************/
+bool numeroMuestraFifoSITL(const muestraFifoInvensense_t muestra, uint32_t *numero)
+{
+    muestraFifoInvensense_t esperada;
+
+    *numero = (uint16_t)muestra[0] | ((uint32_t)(uint16_t)muestra[1] << 16);
+    generarMuestraFifoSITL(*numero, esperada);
+    return memcmp(muestra, esperada, sizeof(muestraFifoInvensense_t)) == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t aleatorioFifoSITL(uint32_t *semilla)
+**  Descripcion:    Generador xorshift de 32 bits
+**  Parametros:     Semilla
+**  Retorno:        Numero aleatorio
+****************************************************************************************/
+static inline uint32_t aleatorioFifoSITL(uint32_t *semilla)
+{
+    *semilla ^= *semilla << 13;
+    *semilla ^= *semilla >> 17;
+    *semilla ^= *semilla << 5;
+    return *semilla;
+}
+
+#endif
@@ -0,0 +1,70 @@
+/***************************************************************************************
+**  fifo_invensense_sitl.h - Prueba del decodificador de la FIFO de las IMU Invensense
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __FIFO_INVENSENSE_SITL_H
+#define __FIFO_INVENSENSE_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Un sensor simulado escribe una muestra cada 125 us en una FIFO del tamanio de cada
+ * modelo y, al llenarse, descarta los bytes mas antiguos como el sensor real. El lector
+ * sigue los pasos del driver (contador, comprobacion de desborde y alineacion, rafaga y
+ * decodificacion) a intervalos aleatorios, con paradas largas que desbordan la FIFO y
+ * rafagas que se llevan bytes de mas y la dejan con un paquete partido. Cada muestra
+ * lleva su numero de orden y una firma, asi que se comprueba que no se decodifica
+ * ninguna desalineada, que no hay huecos sin un reseteo y que solo se resetea cuando
+ * hace falta.
+ *
+ * Tambien acepta un fichero con rafagas grabadas, una por linea: tamanio de la FIFO,
+ * contador leido y bytes de la rafaga en hexadecimal separados por espacios
+ */
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarFifoInvensenseSITL(const char *datos);
+
+#endif // __FIFO_INVENSENSE_SITL_H
@@ -0,0 +1,180 @@
+/***************************************************************************************
+**  filtros_sitl.c - Medida del coste de los filtros de la IMU en SITL
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "filtros_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <math.h>
+
+#include "sitl.h"
+#include "Filtros/filtro_pasa_bajo.h"
+#include "Filtros/filtro_notch.h"
+#include "Filtros/banco_biquad.h"
+#include "Comun/util.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define CANALES_PRUEBA_FILTROS_SITL        (NUM_IMUS_PRUEBA_FILTROS_SITL * 6)
+#define LONGITUD_SENAL_FILTROS_SITL        1024    // Muestras precalculadas que se repiten en la prueba
+
+#define FREC_MUESTREO_FILTROS_SITL         8000.0f
+#define FREC_CORTE_ACEL_FILTROS_SITL       30.0f
+#define FREC_CORTE_GIRO_FILTROS_SITL       150.0f
+#define FREC_NOTCH_FILTROS_SITL            200.0f
+#define ANCHO_NOTCH_FILTROS_SITL           100.0f
+#define ATENUACION_NOTCH_FILTROS_SITL      40.0f
+
+#define TOLERANCIA_FILTROS_SITL            1e-3f
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static float senalFiltrosSITL[LONGITUD_SENAL_FILTROS_SITL][CANALES_PRUEBA_FILTROS_SITL];
+static filtroPasaBajo2P_t pasaBajoFiltrosSITL[CANALES_PRUEBA_FILTROS_SITL];
+static filtroNotchArmonicos_t notchFiltrosSITL[CANALES_PRUEBA_FILTROS_SITL];
+static bancoBiquad_t bancoFiltrosSITL;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void iniciarPruebaFiltrosSITL(void);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool medirFiltrosIMUSITL(uint32_t numMuestras)
+**  Descripcion:    Filtra la misma senial con los filtros individuales y con el banco,
+**                  mide el tiempo por muestra de cada uno y compara las salidas
+**  Parametros:     Numero de muestras a filtrar
+**  Retorno:        True si las salidas coinciden
+****************************************************************************************/
+bool medirFiltrosIMUSITL(uint32_t numMuestras)
+{
+    float muestras[CANALES_PRUEBA_FILTROS_SITL];
+    float errorMax = 0;
+    volatile float sumidero = 0;
+
+    iniciarPruebaFiltrosSITL();
+
+    // Filtros individuales, como en leerDriverIMU
+    const double inicioIndividual = tiempoRealNsSITL();
+    for (uint32_t n = 0; n < numMuestras; n++) {
+        const float *senal = senalFiltrosSITL[n % LONGITUD_SENAL_FILTROS_SITL];
+
+        for (uint8_t i = 0; i < CANALES_PRUEBA_FILTROS_SITL; i++) {
+            const float valor = actualizarFiltroPasaBajo2P(&pasaBajoFiltrosSITL[i], senal[i]);
+            actualizarFiltroNotchArmonicos(&notchFiltrosSITL[i], valor);
+        }
+
+        sumidero += notchFiltrosSITL[n % CANALES_PRUEBA_FILTROS_SITL].valor;
+    }
+    const double nsIndividual = tiempoRealNsSITL() - inicioIndividual;
+
+    // Banco de biquads
+    const double inicioBanco = tiempoRealNsSITL();
+    for (uint32_t n = 0; n < numMuestras; n++) {
+        const float *senal = senalFiltrosSITL[n % LONGITUD_SENAL_FILTROS_SITL];
+
+        for (uint8_t i = 0; i < CANALES_PRUEBA_FILTROS_SITL; i++)
+            muestras[i] = senal[i];
+
+        actualizarBancoBiquad(&bancoFiltrosSITL, muestras);
+        sumidero += muestras[n % CANALES_PRUEBA_FILTROS_SITL];
+    }
+    const double nsBanco = tiempoRealNsSITL() - inicioBanco;
+
+    // Las dos versiones han filtrado la misma secuencia, por lo que la ultima salida debe coincidir
+    for (uint8_t i = 0; i < CANALES_PRUEBA_FILTROS_SITL; i++) {
+        const float error = fabsf(notchFiltrosSITL[i].valor - muestras[i]);
+        if (error > errorMax)
+            errorMax = error;
+    }
+
+    printf("filtros_imu imus=%u canales=%u etapas=%u muestras=%u ns_individual=%.1f ns_banco=%.1f mejora=%.2f error_max=%g\n",
+           NUM_IMUS_PRUEBA_FILTROS_SITL, CANALES_PRUEBA_FILTROS_SITL, 1 + NUM_ARMONICOS_PRUEBA_FILTROS_SITL, numMuestras,
+           numMuestras > 0 ? nsIndividual / numMuestras : 0.0, numMuestras > 0 ? nsBanco / numMuestras : 0.0,
+           nsBanco > 0 ? nsIndividual / nsBanco : 0.0, errorMax);
+
+    UNUSED(sumidero);
+    return errorMax < TOLERANCIA_FILTROS_SITL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void iniciarPruebaFiltrosSITL(void)
+**  Descripcion:    Genera la senial de prueba y ajusta los filtros de las dos versiones
+**                  con la misma configuracion. Los canales 0-2 de cada IMU son de
+**                  acelerometro y los 3-5 de giroscopo
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarPruebaFiltrosSITL(void)
+{
+    for (uint16_t n = 0; n < LONGITUD_SENAL_FILTROS_SITL; n++) {
+        const float t = n / FREC_MUESTREO_FILTROS_SITL;
+
+        for (uint8_t i = 0; i < CANALES_PRUEBA_FILTROS_SITL; i++) {
+            senalFiltrosSITL[n][i] = sinf(2.0f * PI * (5.0f + i) * t) + 0.5f * sinf(2.0f * PI * FREC_NOTCH_FILTROS_SITL * t) +
+                                     0.2f * sinf(2.0f * PI * 3.0f * FREC_NOTCH_FILTROS_SITL * t + i);
+        }
+    }
+
+    iniciarBancoBiquad(&bancoFiltrosSITL, CANALES_PRUEBA_FILTROS_SITL, 1 + NUM_ARMONICOS_PRUEBA_FILTROS_SITL);
+
+    for (uint8_t i = 0; i < CANALES_PRUEBA_FILTROS_SITL; i++) {
+        const float frecCorte = i % 6 < 3 ? FREC_CORTE_ACEL_FILTROS_SITL : FREC_CORTE_GIRO_FILTROS_SITL;
+
+        ajustarFiltroPasaBajo2P(&pasaBajoFiltrosSITL[i], frecCorte, FREC_MUESTREO_FILTROS_SITL);
+        ajustarFiltroNotchArmonicos(&notchFiltrosSITL[i], FREC_NOTCH_FILTROS_SITL, FREC_MUESTREO_FILTROS_SITL,
+                                    ANCHO_NOTCH_FILTROS_SITL, ATENUACION_NOTCH_FILTROS_SITL,
+                                    (1U << NUM_ARMONICOS_PRUEBA_FILTROS_SITL) - 1);
+        resetearFiltroNotchArmonicos(&notchFiltrosSITL[i]);
+
+        ajustarPasaBajoBancoBiquad(&bancoFiltrosSITL, 0, i, 1, frecCorte, FREC_MUESTREO_FILTROS_SITL);
+        // filtroNotchArmonicos_t usa la Q del fundamental en todos los armonicos, que equivale a escalar el ancho de banda
+        for (uint8_t j = 0; j < NUM_ARMONICOS_PRUEBA_FILTROS_SITL; j++) {
+            ajustarNotchBancoBiquad(&bancoFiltrosSITL, j + 1, i, 1, FREC_NOTCH_FILTROS_SITL * (j + 1), FREC_MUESTREO_FILTROS_SITL,
+                                    ANCHO_NOTCH_FILTROS_SITL * (j + 1), ATENUACION_NOTCH_FILTROS_SITL);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,65 @@
+/***************************************************************************************
+**  filtros_sitl.h - Medida del coste de los filtros de la IMU en SITL
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __FILTROS_SITL_H
+#define __FILTROS_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Compara el coste por muestra de la cadena de filtros de 4 IMUs x 6 ejes (pasa bajo
+ * de 2 polos y notch con 3 armonicos) hecha con filtroPasaBajo2P_t y
+ * filtroNotchArmonicos_t frente al banco de biquads. Ambas versiones filtran la misma
+ * senial y se comprueba que las salidas coinciden
+ */
+#define NUM_IMUS_PRUEBA_FILTROS_SITL       4
+#define NUM_ARMONICOS_PRUEBA_FILTROS_SITL  3
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool medirFiltrosIMUSITL(uint32_t numMuestras);
+
+#endif // __FILTROS_SITL_H
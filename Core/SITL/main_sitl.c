@@ -0,0 +1,477 @@
+/***************************************************************************************
+**  main_sitl.c - Punto de entrada del programa en SITL
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "modelo_quad.h"
+#include "spi_sitl.h"
+#include "filtros_sitl.h"
+#include "espectro_sitl.h"
+#include "crc_sitl.h"
+#include "base_tiempos_sitl.h"
+#include "buffer_anillo_sitl.h"
+#include "ms5611_sitl.h"
+#include "calibrador_mag_sitl.h"
+#include "rejilla_hash_sitl.h"
+#include "matriz_fija_sitl.h"
+#include "analizador_ubx_sitl.h"
+#include "trama_radio_sitl.h"
+#include "diario_config_sitl.h"
+#include "salida_motores_sitl.h"
+#include "telemetria_dshot_sitl.h"
+#include "notch_rpm_sitl.h"
+#include "sd_ram_sitl.h"
+#include "cola_blackbox_sitl.h"
+#include "scheduler_sitl.h"
+#include "fifo_invensense_sitl.h"
+#include "codificacion_blackbox_sitl.h"
+#include "decodificador_blackbox.h"
+#include "decodificador_telemetria.h"
+#include "Core/inicializacion.h"
+#include "Scheduler/scheduler.h"
+#include "Sensores/IMU/imu.h"
+#include "Sensores/Barometro/barometro.h"
+#include "Sensores/Magnetometro/magnetometro.h"
+#include "Radio/radio.h"
+#include "Comun/util.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define DURACION_DEFECTO_SITL         10.0f        // s
+#define PERIODO_SINCRONIZACION_SITL   1000         // us de tiempo virtual entre esperas en tiempo real
+#define TAM_BUFFER_ESTADISTICAS_SITL  4096
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    float duracion;                  // Tiempo a simular en s
+    float factorTiempoReal;          // 0 para ejecutar lo mas rapido posible
+    uint32_t semilla;
+    bool mostrarEstadisticas;        // Estadisticas de las tareas, con el coste de CPU del PC en el reloj virtual
+    uint32_t transaccionesSPI;       // Prueba de la cola SPI en lugar del vuelo si no es 0
+    const char *logBlackbox;         // Log a convertir a CSV en lugar del vuelo
+    uint32_t muestrasFiltros;        // Medida de los filtros de la IMU en lugar del vuelo si no es 0
+    const char *logGiro;             // Log de giro en CSV a analizar en lugar del vuelo
+    float frecPicoEsperada;          // Pico que debe encontrar el analisis del log de giro
+    uint32_t kilobytesCRC;           // Prueba del CRC16 en lugar del vuelo si no es 0
+    uint32_t lecturasTiempo;         // Prueba de la base de tiempos en lugar del vuelo si no es 0
+    uint32_t operacionesAnillo;      // Prueba del buffer en anillo en lugar del vuelo si no es 0
+    const char *fuenteTelemetria;    // Puerto o captura a grabar en CSV en lugar del vuelo
+    const char *suscripcionTelemetria; // Canales "nombre:divisor,..." a pedir a la placa
+    bool probarTelemetria;           // Comprueba la telemetria USB del vuelo simulado
+    uint32_t segundosBaro;           // Prueba del driver del MS5611 en lugar del vuelo si no es 0
+    const char *datosCalMag;         // CSV de muestras o conjuntos a generar para probar el calibrador del mag
+    uint32_t muestrasRejilla;        // Prueba de la rejilla hash en lugar del vuelo si no es 0
+    uint32_t repeticionesMatriz;     // Prueba de las matrices de dimension fija en lugar del vuelo si no es 0
+    const char *datosUBX;            // Log UBX o epocas a generar para probar el analizador del GPS
+    uint32_t tramasRadio;            // Prueba de los decodificadores SBUS e iBUS en lugar del vuelo si no es 0
+    uint32_t guardadosDiario;        // Prueba del diario de configuracion en lugar del vuelo si no es 0
+    uint32_t ciclosSalidaMotores;    // Prueba de la salida por lotes de los motores en lugar del vuelo si no es 0
+    const char *datosDshot;          // Capturas de respuestas DSHOT o numero a generar para probar la telemetria
+    const char *datosNotchRPM;       // Log de giro y rpm o muestras a generar para probar los notch RPM
+    const char *kilobytesSD;         // KB del log a cada tasa para probar la escritura en la SD
+    uint32_t framesColaBlackbox;     // Prueba de la cola del blackbox con una SD lenta en lugar del vuelo si no es 0
+    uint32_t ciclosScheduler;        // Comparacion del scheduler por vencimiento con el lineal en lugar del vuelo si no es 0
+    const char *datosFifoIMU;        // Rafagas grabadas de la FIFO de la IMU o numero a generar por modelo
+    uint32_t framesCodificacion;     // Prueba de ida y vuelta de la codificacion del blackbox en lugar del vuelo si no es 0
+} opcionesSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool leerOpcionesSITL(int argc, char **argv, opcionesSITL_t *opciones);
+void esperarTiempoRealSITL(uint64_t inicioReal, float factor);
+void mostrarResultadosSITL(const opcionesSITL_t *opciones, uint64_t iteraciones, uint64_t duracionReal);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         int main(int argc, char **argv)
+**  Descripcion:    Inicia la placa simulada y ejecuta el scheduler con el reloj virtual
+**  Parametros:     Argumentos de la linea de comandos
+**  Retorno:        0 si ok
+****************************************************************************************/
+int main(int argc, char **argv)
+{
+    opcionesSITL_t opciones;
+
+    if (!leerOpcionesSITL(argc, argv, &opciones))
+        return EXIT_FAILURE;
+
+    if (opciones.logBlackbox != NULL)
+        return convertirLogBlackboxCSV(opciones.logBlackbox, stdout) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.kilobytesCRC > 0)
+        return probarCRC16SITL(opciones.kilobytesCRC) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.lecturasTiempo > 0)
+        return probarBaseTiemposSITL(opciones.lecturasTiempo) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.operacionesAnillo > 0)
+        return probarBufferAnilloSITL(opciones.operacionesAnillo) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.logGiro != NULL)
+        return analizarLogGiroSITL(opciones.logGiro, opciones.frecPicoEsperada) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.datosNotchRPM != NULL)
+        return probarNotchRPMSITL(opciones.datosNotchRPM) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.kilobytesSD != NULL)
+        return probarEscrituraSDSITL(opciones.kilobytesSD) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.framesColaBlackbox > 0)
+        return probarColaBlackboxSITL(opciones.framesColaBlackbox) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.ciclosScheduler > 0)
+        return probarSchedulerSITL(opciones.ciclosScheduler) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.datosFifoIMU != NULL)
+        return probarFifoInvensenseSITL(opciones.datosFifoIMU) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.framesCodificacion > 0)
+        return probarCodificacionBlackboxSITL(opciones.framesCodificacion) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.muestrasFiltros > 0)
+        return medirFiltrosIMUSITL(opciones.muestrasFiltros) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.datosUBX != NULL)
+        return probarAnalizadorUBXSITL(opciones.datosUBX) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.repeticionesMatriz > 0)
+        return probarMatrizFijaSITL(opciones.repeticionesMatriz) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.guardadosDiario > 0)
+        return probarDiarioConfigSITL(opciones.guardadosDiario) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.muestrasRejilla > 0)
+        return probarRejillaHashSITL(opciones.muestrasRejilla) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.datosCalMag != NULL)
+        return probarCalibradorMagSITL(opciones.datosCalMag) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.fuenteTelemetria != NULL)
+        return grabarTelemetria(opciones.fuenteTelemetria, opciones.suscripcionTelemetria, stdout) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    iniciarSITL(opciones.semilla);
+    if (opciones.transaccionesSPI > 0)
+        return probarColaSPISITL(opciones.transaccionesSPI) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.segundosBaro > 0)
+        return probarBaroMS5611SITL(opciones.segundosBaro) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.tramasRadio > 0)
+        return probarTramaRadioSITL(opciones.tramasRadio) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.ciclosSalidaMotores > 0)
+        return probarSalidaMotoresSITL(opciones.ciclosSalidaMotores) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.datosDshot != NULL)
+        return probarTelemetriaDshotSITL(opciones.datosDshot) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    if (opciones.probarTelemetria)
+        conectarTelemetriaSITL(opciones.suscripcionTelemetria);
+
+    iniciarPlaca();
+    if (opciones.mostrarEstadisticas)
+        habilitarCosteCPUSITL();
+
+    const uint64_t finVirtual = tiempoSITL() + (uint64_t)(opciones.duracion * 1e6f);
+    const uint64_t inicioReal = (uint64_t)(tiempoRealNsSITL() / 1000);
+    uint64_t sincronizacion = tiempoSITL();
+    uint64_t iteraciones = 0;
+
+    while (tiempoSITL() < finVirtual) {
+        scheduler();
+        avanzarTiempoSITL(PASO_BUCLE_SITL_US);
+        iteraciones++;
+
+        if (opciones.factorTiempoReal > 0 && tiempoSITL() - sincronizacion >= PERIODO_SINCRONIZACION_SITL) {
+            sincronizacion = tiempoSITL();
+            esperarTiempoRealSITL(inicioReal, opciones.factorTiempoReal);
+        }
+    }
+
+    mostrarResultadosSITL(&opciones, iteraciones, (uint64_t)(tiempoRealNsSITL() / 1000) - inicioReal);
+
+    if (opciones.probarTelemetria)
+        return comprobarTelemetriaSITL() ? EXIT_SUCCESS : EXIT_FAILURE;
+
+    return EXIT_SUCCESS;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool leerOpcionesSITL(int argc, char **argv, opcionesSITL_t *opciones)
+**  Descripcion:    Lee las opciones de la linea de comandos
+**  Parametros:     Argumentos, opciones leidas
+**  Retorno:        True si ok
+****************************************************************************************/
+bool leerOpcionesSITL(int argc, char **argv, opcionesSITL_t *opciones)
+{
+    int opcion;
+
+    opciones->duracion = DURACION_DEFECTO_SITL;
+    opciones->factorTiempoReal = 0;
+    opciones->semilla = 1;
+    opciones->mostrarEstadisticas = false;
+    opciones->transaccionesSPI = 0;
+    opciones->logBlackbox = NULL;
+    opciones->muestrasFiltros = 0;
+    opciones->logGiro = NULL;
+    opciones->frecPicoEsperada = 0;
+    opciones->kilobytesCRC = 0;
+    opciones->lecturasTiempo = 0;
+    opciones->operacionesAnillo = 0;
+    opciones->fuenteTelemetria = NULL;
+    opciones->suscripcionTelemetria = NULL;
+    opciones->probarTelemetria = false;
+    opciones->segundosBaro = 0;
+    opciones->datosCalMag = NULL;
+    opciones->muestrasRejilla = 0;
+    opciones->repeticionesMatriz = 0;
+    opciones->datosUBX = NULL;
+    opciones->tramasRadio = 0;
+    opciones->guardadosDiario = 0;
+    opciones->ciclosSalidaMotores = 0;
+    opciones->datosDshot = NULL;
+    opciones->datosNotchRPM = NULL;
+    opciones->kilobytesSD = NULL;
+    opciones->framesColaBlackbox = 0;
+    opciones->ciclosScheduler = 0;
+    opciones->datosFifoIMU = NULL;
+    opciones->framesCodificacion = 0;
+
+    while ((opcion = getopt(argc, argv, "t:r:s:eq:b:f:g:p:c:m:a:l:k:uw:n:x:o:y:z:d:j:v:i:h:A:B:C:D:")) != -1) {
+        switch (opcion) {
+            case 't':
+                opciones->duracion = strtof(optarg, NULL);
+                break;
+
+            case 'r':
+                opciones->factorTiempoReal = strtof(optarg, NULL);
+                break;
+
+            case 's':
+                opciones->semilla = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'e':
+                opciones->mostrarEstadisticas = true;
+                break;
+
+            case 'q':
+                opciones->transaccionesSPI = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'b':
+                opciones->logBlackbox = optarg;
+                break;
+
+            case 'f':
+                opciones->muestrasFiltros = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'g':
+                opciones->logGiro = optarg;
+                break;
+
+            case 'p':
+                opciones->frecPicoEsperada = strtof(optarg, NULL);
+                break;
+
+            case 'c':
+                opciones->kilobytesCRC = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'm':
+                opciones->lecturasTiempo = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'a':
+                opciones->operacionesAnillo = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'l':
+                opciones->fuenteTelemetria = optarg;
+                break;
+
+            case 'k':
+                opciones->suscripcionTelemetria = optarg;
+                break;
+
+            case 'u':
+                opciones->probarTelemetria = true;
+                break;
+
+            case 'w':
+                opciones->segundosBaro = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'n':
+                opciones->datosCalMag = optarg;
+                break;
+
+            case 'x':
+                opciones->muestrasRejilla = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'o':
+                opciones->repeticionesMatriz = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'y':
+                opciones->datosUBX = optarg;
+                break;
+
+            case 'z':
+                opciones->tramasRadio = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'd':
+                opciones->guardadosDiario = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'j':
+                opciones->ciclosSalidaMotores = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'v':
+                opciones->datosDshot = optarg;
+                break;
+
+            case 'i':
+                opciones->datosNotchRPM = optarg;
+                break;
+
+            case 'h':
+                opciones->kilobytesSD = optarg;
+                break;
+
+            case 'A':
+                opciones->framesColaBlackbox = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'B':
+                opciones->ciclosScheduler = strtoul(optarg, NULL, 0);
+                break;
+
+            case 'C':
+                opciones->datosFifoIMU = optarg;
+                break;
+
+            case 'D':
+                opciones->framesCodificacion = strtoul(optarg, NULL, 0);
+                break;
+
+            default:
+                fprintf(stderr, "Uso: %s [-t segundos] [-r factor tiempo real] [-s semilla] [-e] [-q transacciones SPI] [-b log blackbox] [-f muestras filtros] [-g log giro CSV] [-p pico esperado Hz] [-c kilobytes CRC] [-m lecturas base de tiempos] [-a operaciones buffer anillo] [-l puerto o captura telemetria] [-k suscripcion telemetria] [-u] [-w segundos baro MS5611] [-n muestras mag CSV o conjuntos a generar] [-x muestras rejilla hash] [-o repeticiones matrices] [-y log UBX o epocas a generar] [-z tramas radio] [-d guardados diario config] [-j ciclos salida motores] [-v capturas DSHOT o respuestas a generar] [-i log giro y rpm CSV o muestras notch RPM] [-h kilobytes escritura SD] [-A frames cola blackbox] [-B ciclos scheduler] [-C rafagas FIFO IMU o rafagas a generar] [-D frames codificacion blackbox]\n", argv[0]);
+                return false;
+        }
+    }
+
+    return opciones->duracion > 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void esperarTiempoRealSITL(uint64_t inicioReal, float factor)
+**  Descripcion:    Duerme hasta que el tiempo real alcance al virtual escalado por el factor
+**  Parametros:     Inicio de la simulacion en tiempo real, factor de tiempo real
+**  Retorno:        Ninguno
+****************************************************************************************/
+void esperarTiempoRealSITL(uint64_t inicioReal, float factor)
+{
+    const uint64_t objetivo = inicioReal + (uint64_t)(tiempoSITL() / factor);
+    const uint64_t actual = (uint64_t)(tiempoRealNsSITL() / 1000);
+
+    if (objetivo > actual) {
+        const uint64_t espera = objetivo - actual;
+        struct timespec ts = { .tv_sec = espera / 1000000, .tv_nsec = (espera % 1000000) * 1000 };
+        nanosleep(&ts, NULL);
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void mostrarResultadosSITL(const opcionesSITL_t *opciones, uint64_t iteraciones,
+**                                             uint64_t duracionReal)
+**  Descripcion:    Muestra el rendimiento del bucle y el estado final del vehiculo
+**  Parametros:     Opciones, iteraciones del scheduler, duracion en tiempo real en us
+**  Retorno:        Ninguno
+****************************************************************************************/
+void mostrarResultadosSITL(const opcionesSITL_t *opciones, uint64_t iteraciones, uint64_t duracionReal)
+{
+    const estadoModeloQuad_t *estado = estadoModeloQuad();
+    const double segVirtual = tiempoSITL() * 1e-6;
+    const double segReal = duracionReal > 0 ? duracionReal * 1e-6 : 1e-6;
+
+    printf("tiempo_virtual_s=%.3f tiempo_real_s=%.3f factor=%.1f iteraciones=%llu iter_s=%.0f\n",
+           segVirtual, segReal, segVirtual / segReal, (unsigned long long)iteraciones, iteraciones / segReal);
+    printf("posicion_m=%.3f,%.3f,%.3f velocidad_ms=%.3f,%.3f,%.3f q=%.4f,%.4f,%.4f,%.4f suelo=%u\n",
+           estado->posicion[0], estado->posicion[1], estado->posicion[2],
+           estado->velocidad[0], estado->velocidad[1], estado->velocidad[2],
+           estado->q[0], estado->q[1], estado->q[2], estado->q[3], estado->enSuelo);
+
+    float acel[3], giro[3], mag[3];
+    acelIMU(acel);
+    giroIMU(giro);
+    campoMag(mag);
+    printf("imu=%u baro=%u mag=%u acel_g=%.3f,%.3f,%.3f giro_gs=%.3f,%.3f,%.3f presion_mbar=%.2f campo_mga=%.1f,%.1f,%.1f\n",
+           imuGenOperativa(), baroGenOperativo(), magGenOperativo(), acel[0], acel[1], acel[2], giro[0], giro[1], giro[2],
+           presionBaro(), mag[0], mag[1], mag[2]);
+
+    const latenciaRadio_t *latencia = latenciaRadio();
+    printf("radio latencia_us=%u latencia_max_us=%u latencia_media_us=%u muestras=%u\n",
+           latencia->ultima, latencia->maxima, latencia->media, latencia->muestras);
+
+    if (opciones->mostrarEstadisticas) {
+        static char buffer[TAM_BUFFER_ESTADISTICAS_SITL];
+        volcarEstadisticasTareas(buffer, sizeof(buffer));
+        fputs(buffer, stdout);
+    }
+}
+
+#endif
@@ -0,0 +1,455 @@
+/***************************************************************************************
+**  matriz_fija_sitl.c - Pruebas y medida de las matrices de dimension fija
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "matriz_fija_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include "sitl.h"
+#include "Comun/matriz_fija.h"
+#include "Comun/matematicas.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define MAX_PRUEBAS_MATRIZ_SITL                1000
+#define FILAS_POR_INCOGNITA_MATRIZ_SITL        4
+#define RUIDO_MATRIZ_SITL                      0.01f
+#define TOLERANCIA_MATRIZ_SITL                 1e-3f
+#define TOLERANCIA_MIN_CUADRADOS_MATRIZ_SITL   1e-2f
+
+#define PROBAR_MATRIZ_FIJA_SITL(n)                                                                                                         \
+bool probarMatriz ## n ## SITL(uint32_t repeticiones)                                                                                      \
+{                                                                                                                                          \
+    const uint16_t filas = FILAS_POR_INCOGNITA_MATRIZ_SITL * n;                                                                            \
+    const uint32_t pruebas = MIN(repeticiones, (uint32_t)MAX_PRUEBAS_MATRIZ_SITL);                                                         \
+    matriz ## n ## _t A, B, C, R;                                                                                                          \
+    minCuadrados ## n ## _t mc;                                                                                                            \
+    matriz_t anteriorA, anteriorB, anteriorR;                                                                                              \
+    float x[n], b[n], sol[n], solH[n];                                                                                                     \
+    float filasA[FILAS_POR_INCOGNITA_MATRIZ_SITL * n][n], filasH[FILAS_POR_INCOGNITA_MATRIZ_SITL * n][n];                                  \
+    float y[FILAS_POR_INCOGNITA_MATRIZ_SITL * n], yH[FILAS_POR_INCOGNITA_MATRIZ_SITL * n];                                                 \
+    float errorOperaciones = 0.0f, errorSistemas = 0.0f, errorMinCuadrados = 0.0f;                                                         \
+    bool ok = true;                                                                                                                        \
+                                                                                                                                           \
+    semillaMatrizSITL = 12345 + n;                                                                                                         \
+                                                                                                                                           \
+    for (uint32_t p = 0; p < pruebas; p++) {                                                                                               \
+        /* Operaciones frente a matriz_t y resultados en el sitio */                                                                       \
+        generarMatrizSITL(&A.m[0][0], n, MATRIZ_GENERAL_SITL);                                                                             \
+        generarMatrizSITL(&B.m[0][0], n, MATRIZ_GENERAL_SITL);                                                                             \
+        aMatrizSITL(&A.m[0][0], n, &anteriorA);                                                                                            \
+        aMatrizSITL(&B.m[0][0], n, &anteriorB);                                                                                            \
+                                                                                                                                           \
+        multiplicarMatrices ## n(&A, &B, &R);                                                                                              \
+        multiplicarMatrices(anteriorA, anteriorB, &anteriorR, n);                                                                          \
+        errorOperaciones = MAX(errorOperaciones, diferenciaMatrizSITL(&R.m[0][0], &anteriorR, n));                                         \
+        C = A;                                                                                                                             \
+        multiplicarMatrices ## n(&C, &B, &C);                                                                                              \
+        ok &= memcmp(&C, &R, sizeof(C)) == 0;                                                                                              \
+                                                                                                                                           \
+        C = A;                                                                                                                             \
+        traspuestaMatriz ## n(&C);                                                                                                         \
+        traspuestaMatriz(anteriorA, &anteriorR, n);                                                                                        \
+        errorOperaciones = MAX(errorOperaciones, diferenciaMatrizSITL(&C.m[0][0], &anteriorR, n));                                         \
+                                                                                                                                           \
+        sumarMatrices ## n(&A, &B, &C);                                                                                                    \
+        restarMatrices ## n(&C, &B, &C);                                                                                                   \
+        escalarMatriz ## n(&C, 2.0f, &C);                                                                                                  \
+        escalarMatriz ## n(&A, 2.0f, &R);                                                                                                  \
+        errorOperaciones = MAX(errorOperaciones, errorRelativoMatrizSITL(&C.m[0][0], &R.m[0][0], n * n));                                  \
+                                                                                                                                           \
+        generarVectorSITL(x, n);                                                                                                           \
+        C = A;                                                                                                                             \
+        rango1Matriz ## n(&C, 0.5f, x);                                                                                                    \
+        completarSimetricaMatriz ## n(&C);                                                                                                 \
+        for (uint8_t i = 0; i < n; i++) {                                                                                                  \
+            for (uint8_t j = 0; j <= i; j++) {                                                                                             \
+                errorOperaciones = MAX(errorOperaciones, fabsf(C.m[i][j] - A.m[i][j] - 0.5f * x[i] * x[j]));                               \
+                ok &= C.m[j][i] == C.m[i][j];                                                                                              \
+            }                                                                                                                              \
+        }                                                                                                                                  \
+                                                                                                                                           \
+        /* Sistemas simetricos definidos positivos */                                                                                      \
+        generarMatrizSITL(&A.m[0][0], n, MATRIZ_DEFINIDA_SITL);                                                                            \
+        multiplicarMatrizVector ## n(&A, x, b);                                                                                            \
+                                                                                                                                           \
+        C = A;                                                                                                                             \
+        memcpy(sol, b, sizeof(b));                                                                                                         \
+        ok &= factorizarCholeskyMatriz ## n(&C);                                                                                           \
+        resolverCholeskyMatriz ## n(&C, sol);                                                                                              \
+        errorSistemas = MAX(errorSistemas, errorRelativoMatrizSITL(sol, x, n));                                                            \
+                                                                                                                                           \
+        C = A;                                                                                                                             \
+        memcpy(sol, b, sizeof(b));                                                                                                         \
+        ok &= factorizarLDLMatriz ## n(&C);                                                                                                \
+        resolverLDLMatriz ## n(&C, sol);                                                                                                   \
+        errorSistemas = MAX(errorSistemas, errorRelativoMatrizSITL(sol, x, n));                                                            \
+                                                                                                                                           \
+        /* Simetricas indefinidas: solo LDL' */                                                                                            \
+        generarMatrizSITL(&A.m[0][0], n, MATRIZ_INDEFINIDA_SITL);                                                                          \
+        multiplicarMatrizVector ## n(&A, x, b);                                                                                            \
+                                                                                                                                           \
+        C = A;                                                                                                                             \
+        ok &= !factorizarCholeskyMatriz ## n(&C);                                                                                          \
+                                                                                                                                           \
+        C = A;                                                                                                                             \
+        memcpy(sol, b, sizeof(b));                                                                                                         \
+        ok &= factorizarLDLMatriz ## n(&C);                                                                                                \
+        resolverLDLMatriz ## n(&C, sol);                                                                                                   \
+        multiplicarMatrizVector ## n(&A, sol, solH);                                                                                       \
+        errorSistemas = MAX(errorSistemas, errorRelativoMatrizSITL(solH, b, n));                                                           \
+                                                                                                                                           \
+        /* Minimos cuadrados: Givens, Householder y ecuaciones normales */                                                                 \
+        iniciarMinCuadrados ## n(&mc);                                                                                                     \
+        resetearMatriz ## n(&C);                                                                                                           \
+        memset(b, 0, sizeof(b));                                                                                                           \
+        for (uint16_t f = 0; f < filas; f++) {                                                                                             \
+            generarVectorSITL(filasA[f], n);                                                                                               \
+            y[f] = RUIDO_MATRIZ_SITL * aleatorioMatrizSITL();                                                                              \
+            for (uint8_t i = 0; i < n; i++)                                                                                                \
+                y[f] += filasA[f][i] * x[i];                                                                                               \
+                                                                                                                                           \
+            for (uint8_t i = 0; i < n; i++)                                                                                                \
+                b[i] += filasA[f][i] * y[f];                                                                                               \
+                                                                                                                                           \
+            anadirFilaMinCuadrados ## n(&mc, filasA[f], y[f]);                                                                             \
+            rango1Matriz ## n(&C, 1.0f, filasA[f]);                                                                                        \
+        }                                                                                                                                  \
+                                                                                                                                           \
+        memcpy(filasH, filasA, sizeof(filasA));                                                                                            \
+        memcpy(yH, y, sizeof(y));                                                                                                          \
+        ok &= resolverMinCuadrados ## n(&mc, sol);                                                                                         \
+        ok &= resolverHouseholderMatriz ## n(filasH, yH, filas, solH);                                                                     \
+        ok &= factorizarCholeskyMatriz ## n(&C);                                                                                           \
+        resolverCholeskyMatriz ## n(&C, b);                                                                                                \
+        errorMinCuadrados = MAX(errorMinCuadrados, errorRelativoMatrizSITL(sol, solH, n));                                                 \
+        errorMinCuadrados = MAX(errorMinCuadrados, errorRelativoMatrizSITL(b, solH, n));                                                   \
+                                                                                                                                           \
+        float residuoH = 0.0f;                                                                                                             \
+        for (uint16_t f = n; f < filas; f++)                                                                                               \
+            residuoH += yH[f] * yH[f];                                                                                                     \
+                                                                                                                                           \
+        errorMinCuadrados = MAX(errorMinCuadrados, fabsf(mc.residuo2 - residuoH) / MAX(residuoH, 1e-9f));                                  \
+                                                                                                                                           \
+        /* Rango incompleto: una columna nula */                                                                                           \
+        iniciarMinCuadrados ## n(&mc);                                                                                                     \
+        for (uint16_t f = 0; f < filas; f++) {                                                                                             \
+            filasA[f][0] = 0.0f;                                                                                                           \
+            anadirFilaMinCuadrados ## n(&mc, filasA[f], y[f]);                                                                             \
+        }                                                                                                                                  \
+                                                                                                                                           \
+        memcpy(filasH, filasA, sizeof(filasA));                                                                                            \
+        memcpy(yH, y, sizeof(y));                                                                                                          \
+        ok &= !resolverMinCuadrados ## n(&mc, sol);                                                                                        \
+        ok &= !resolverHouseholderMatriz ## n(filasH, yH, filas, solH);                                                                    \
+    }                                                                                                                                      \
+                                                                                                                                           \
+    ok &= errorOperaciones < TOLERANCIA_MATRIZ_SITL && errorSistemas < TOLERANCIA_MATRIZ_SITL &&                                           \
+          errorMinCuadrados < TOLERANCIA_MIN_CUADRADOS_MATRIZ_SITL;                                                                        \
+                                                                                                                                           \
+    /* Tiempos de resolver el mismo sistema */                                                                                             \
+    generarMatrizSITL(&A.m[0][0], n, MATRIZ_DEFINIDA_SITL);                                                                                \
+    generarVectorSITL(b, n);                                                                                                               \
+    aMatrizSITL(&A.m[0][0], n, &anteriorA);                                                                                                \
+                                                                                                                                           \
+    double inicio = tiempoRealNsSITL();                                                                                                    \
+    for (uint32_t r = 0; r < repeticiones; r++) {                                                                                          \
+        C = A;                                                                                                                             \
+        memcpy(sol, b, sizeof(b));                                                                                                         \
+        factorizarCholeskyMatriz ## n(&C);                                                                                                 \
+        resolverCholeskyMatriz ## n(&C, sol);                                                                                              \
+        sumideroMatrizSITL += sol[0];                                                                                                      \
+    }                                                                                                                                      \
+    const double nsCholesky = (tiempoRealNsSITL() - inicio) / repeticiones;                                                                \
+                                                                                                                                           \
+    inicio = tiempoRealNsSITL();                                                                                                           \
+    for (uint32_t r = 0; r < repeticiones; r++) {                                                                                          \
+        C = A;                                                                                                                             \
+        memcpy(sol, b, sizeof(b));                                                                                                         \
+        factorizarLDLMatriz ## n(&C);                                                                                                      \
+        resolverLDLMatriz ## n(&C, sol);                                                                                                   \
+        sumideroMatrizSITL += sol[0];                                                                                                      \
+    }                                                                                                                                      \
+    const double nsLDL = (tiempoRealNsSITL() - inicio) / repeticiones;                                                                     \
+                                                                                                                                           \
+    inicio = tiempoRealNsSITL();                                                                                                           \
+    for (uint32_t r = 0; r < repeticiones; r++) {                                                                                          \
+        inversaMatriz(anteriorA, &anteriorR, n);                                                                                           \
+        for (uint8_t i = 0; i < n; i++) {                                                                                                  \
+            sol[i] = 0.0f;                                                                                                                 \
+            for (uint8_t k = 0; k < n; k++)                                                                                                \
+                sol[i] += anteriorR.m[i][k] * b[k];                                                                                        \
+        }                                                                                                                                  \
+        sumideroMatrizSITL += sol[0];                                                                                                      \
+    }                                                                                                                                      \
+    const double nsInversaAnterior = (tiempoRealNsSITL() - inicio) / repeticiones;                                                         \
+                                                                                                                                           \
+    generarMatrizSITL(&B.m[0][0], n, MATRIZ_GENERAL_SITL);                                                                                 \
+    aMatrizSITL(&B.m[0][0], n, &anteriorB);                                                                                                \
+                                                                                                                                           \
+    inicio = tiempoRealNsSITL();                                                                                                           \
+    for (uint32_t r = 0; r < repeticiones; r++) {                                                                                          \
+        multiplicarMatrices ## n(&A, &B, &R);                                                                                              \
+        sumideroMatrizSITL += R.m[0][0];                                                                                                   \
+    }                                                                                                                                      \
+    const double nsMultiplicar = (tiempoRealNsSITL() - inicio) / repeticiones;                                                             \
+                                                                                                                                           \
+    inicio = tiempoRealNsSITL();                                                                                                           \
+    for (uint32_t r = 0; r < repeticiones; r++) {                                                                                          \
+        multiplicarMatrices(anteriorA, anteriorB, &anteriorR, n);                                                                          \
+        sumideroMatrizSITL += anteriorR.m[0][0];                                                                                           \
+    }                                                                                                                                      \
+    const double nsMultiplicarAnterior = (tiempoRealNsSITL() - inicio) / repeticiones;                                                     \
+                                                                                                                                           \
+    for (uint16_t f = 0; f < filas; f++) {                                                                                                 \
+        generarVectorSITL(filasA[f], n);                                                                                                   \
+        y[f] = aleatorioMatrizSITL();                                                                                                      \
+    }                                                                                                                                      \
+                                                                                                                                           \
+    inicio = tiempoRealNsSITL();                                                                                                           \
+    for (uint32_t r = 0; r < repeticiones; r++) {                                                                                          \
+        iniciarMinCuadrados ## n(&mc);                                                                                                     \
+        for (uint16_t f = 0; f < filas; f++)                                                                                               \
+            anadirFilaMinCuadrados ## n(&mc, filasA[f], y[f]);                                                                             \
+                                                                                                                                           \
+        resolverMinCuadrados ## n(&mc, sol);                                                                                               \
+        sumideroMatrizSITL += sol[0];                                                                                                      \
+    }                                                                                                                                      \
+    const double nsGivens = (tiempoRealNsSITL() - inicio) / repeticiones;                                                                  \
+                                                                                                                                           \
+    inicio = tiempoRealNsSITL();                                                                                                           \
+    for (uint32_t r = 0; r < repeticiones; r++) {                                                                                          \
+        memcpy(filasH, filasA, sizeof(filasA));                                                                                            \
+        memcpy(yH, y, sizeof(y));                                                                                                          \
+        resolverHouseholderMatriz ## n(filasH, yH, filas, sol);                                                                            \
+        sumideroMatrizSITL += sol[0];                                                                                                      \
+    }                                                                                                                                      \
+    const double nsHouseholder = (tiempoRealNsSITL() - inicio) / repeticiones;                                                             \
+                                                                                                                                           \
+    printf("matriz_fija n=%u pruebas=%u error_operaciones=%.1e error_sistemas=%.1e error_min_cuadrados=%.1e "                              \
+           "ns_cholesky=%.1f ns_ldl=%.1f ns_inversa_anterior=%.1f "                                                                        \
+           "ns_multiplicar=%.1f ns_multiplicar_anterior=%.1f ns_givens_%u_filas=%.1f ns_householder_%u_filas=%.1f "                        \
+           "mejora_resolver=%.1f mejora_multiplicar=%.1f ok=%u\n",                                                                         \
+           n, pruebas, (double)errorOperaciones, (double)errorSistemas, (double)errorMinCuadrados,                                         \
+           nsCholesky, nsLDL, nsInversaAnterior, nsMultiplicar, nsMultiplicarAnterior,                                                     \
+           filas, nsGivens, filas, nsHouseholder,                                                                                          \
+           nsCholesky > 0 ? nsInversaAnterior / nsCholesky : 0.0, nsMultiplicar > 0 ? nsMultiplicarAnterior / nsMultiplicar : 0.0, ok);    \
+                                                                                                                                           \
+    return ok;                                                                                                                             \
+}
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef enum {
+    MATRIZ_GENERAL_SITL,
+    MATRIZ_DEFINIDA_SITL,
+    MATRIZ_INDEFINIDA_SITL,
+} tipoMatrizSITL_e;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static uint32_t semillaMatrizSITL;
+static volatile float sumideroMatrizSITL;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarMatriz3SITL(uint32_t repeticiones);
+bool probarMatriz4SITL(uint32_t repeticiones);
+bool probarMatriz6SITL(uint32_t repeticiones);
+bool probarMatriz9SITL(uint32_t repeticiones);
+void generarMatrizSITL(float *a, uint8_t n, tipoMatrizSITL_e tipo);
+void generarVectorSITL(float *v, uint8_t n);
+void aMatrizSITL(const float *a, uint8_t n, matriz_t *M);
+float diferenciaMatrizSITL(const float *a, const matriz_t *M, uint8_t n);
+float errorRelativoMatrizSITL(const float *x, const float *referencia, uint16_t n);
+float aleatorioMatrizSITL(void);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool probarMatrizFijaSITL(uint32_t repeticiones)
+**  Descripcion:    Prueba y mide las matrices de dimension 3, 4, 6 y 9
+**  Parametros:     Repeticiones de cada medida
+**  Retorno:        True si todas las pruebas pasan
+****************************************************************************************/
+bool probarMatrizFijaSITL(uint32_t repeticiones)
+{
+    bool ok = true;
+
+    ok &= probarMatriz3SITL(repeticiones);
+    ok &= probarMatriz4SITL(repeticiones);
+    ok &= probarMatriz6SITL(repeticiones);
+    ok &= probarMatriz9SITL(repeticiones);
+
+    return ok;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool probarMatrizNSITL(uint32_t repeticiones)
+**  Descripcion:    Prueba y mide las matrices de una dimension
+**  Parametros:     Repeticiones de cada medida
+**  Retorno:        True si todas las pruebas pasan
+****************************************************************************************/
+PROBAR_MATRIZ_FIJA_SITL(3)
+PROBAR_MATRIZ_FIJA_SITL(4)
+PROBAR_MATRIZ_FIJA_SITL(6)
+PROBAR_MATRIZ_FIJA_SITL(9)
+
+
+/***************************************************************************************
+**  Nombre:         void generarMatrizSITL(float *a, uint8_t n, tipoMatrizSITL_e tipo)
+**  Descripcion:    Genera una matriz aleatoria. Las simetricas se forman como B' * D * B,
+**                  con D positiva mas n * I para las definidas y D de signo alterno para
+**                  las indefinidas
+**  Parametros:     Matriz, dimension, tipo
+**  Retorno:        Ninguno
+****************************************************************************************/
+void generarMatrizSITL(float *a, uint8_t n, tipoMatrizSITL_e tipo)
+{
+    float b[n * n], d[n];
+
+    generarVectorSITL(b, n * n);
+    if (tipo == MATRIZ_GENERAL_SITL) {
+        memcpy(a, b, sizeof(b));
+        return;
+    }
+
+    for (uint8_t k = 0; k < n; k++) {
+        d[k] = 0.5f + 0.5f * fabsf(aleatorioMatrizSITL());
+        if (tipo == MATRIZ_INDEFINIDA_SITL && (k & 1))
+            d[k] = -d[k];
+    }
+
+    for (uint8_t i = 0; i < n; i++) {
+        for (uint8_t j = 0; j < n; j++) {
+            float suma = tipo == MATRIZ_DEFINIDA_SITL && i == j ? n : 0.0f;
+            for (uint8_t k = 0; k < n; k++)
+                suma += b[k * n + i] * d[k] * b[k * n + j];
+
+            a[i * n + j] = suma;
+        }
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void generarVectorSITL(float *v, uint8_t n)
+**  Descripcion:    Genera un vector con componentes en [-1, 1)
+**  Parametros:     Vector, numero de componentes
+**  Retorno:        Ninguno
+****************************************************************************************/
+void generarVectorSITL(float *v, uint8_t n)
+{
+    for (uint8_t i = 0; i < n; i++)
+        v[i] = aleatorioMatrizSITL();
+}
+
+
+/***************************************************************************************
+**  Nombre:         void aMatrizSITL(const float *a, uint8_t n, matriz_t *M)
+**  Descripcion:    Copia una matriz de dimension fija en una matriz_t
+**  Parametros:     Matriz, dimension, matriz_t
+**  Retorno:        Ninguno
+****************************************************************************************/
+void aMatrizSITL(const float *a, uint8_t n, matriz_t *M)
+{
+    memset(M, 0, sizeof(matriz_t));
+
+    for (uint8_t i = 0; i < n; i++) {
+        for (uint8_t j = 0; j < n; j++)
+            M->m[i][j] = a[i * n + j];
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         float diferenciaMatrizSITL(const float *a, const matriz_t *M, uint8_t n)
+**  Descripcion:    Diferencia maxima entre una matriz de dimension fija y una matriz_t
+**  Parametros:     Matriz, matriz_t, dimension
+**  Retorno:        Diferencia maxima
+****************************************************************************************/
+float diferenciaMatrizSITL(const float *a, const matriz_t *M, uint8_t n)
+{
+    float diferencia = 0.0f;
+
+    for (uint8_t i = 0; i < n; i++) {
+        for (uint8_t j = 0; j < n; j++)
+            diferencia = MAX(diferencia, fabsf(a[i * n + j] - M->m[i][j]));
+    }
+
+    return diferencia;
+}
+
+
+/***************************************************************************************
+**  Nombre:         float errorRelativoMatrizSITL(const float *x, const float *referencia, uint16_t n)
+**  Descripcion:    Error maximo relativo a la mayor componente de la referencia
+**  Parametros:     Vector, vector de referencia, numero de componentes
+**  Retorno:        Error relativo
+****************************************************************************************/
+float errorRelativoMatrizSITL(const float *x, const float *referencia, uint16_t n)
+{
+    float error = 0.0f, escala = 1e-6f;
+
+    for (uint16_t i = 0; i < n; i++) {
+        error = MAX(error, fabsf(x[i] - referencia[i]));
+        escala = MAX(escala, fabsf(referencia[i]));
+    }
+
+    // Los NaN tambien fallan
+    return isfinite(error) ? error / escala : INFINITY;
+}
+
+
+/***************************************************************************************
+**  Nombre:         float aleatorioMatrizSITL(void)
+**  Descripcion:    Numero pseudoaleatorio reproducible
+**  Parametros:     Ninguno
+**  Retorno:        Valor en [-1, 1)
+****************************************************************************************/
+float aleatorioMatrizSITL(void)
+{
+    semillaMatrizSITL = semillaMatrizSITL * 1664525u + 1013904223u;
+    return (semillaMatrizSITL >> 8) * (2.0f / 16777216.0f) - 1.0f;
+}
+
+#endif
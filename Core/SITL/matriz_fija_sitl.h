@@ -0,0 +1,64 @@
+/***************************************************************************************
+**  matriz_fija_sitl.h - Pruebas y medida de las matrices de dimension fija
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __MATRIZ_FIJA_SITL_H
+#define __MATRIZ_FIJA_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Para cada dimension generada se comprueban las operaciones frente a las de matriz_t y
+ * las soluciones frente a la solucion conocida con matrices aleatorias: Cholesky y LDL'
+ * con simetricas definidas positivas, LDL' con indefinidas (donde Cholesky tiene que
+ * fallar) y Givens y Householder con sistemas sobredeterminados, incluido uno de rango
+ * incompleto. Despues se mide el tiempo de resolver un sistema con cada metodo
+ */
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarMatrizFijaSITL(uint32_t repeticiones);
+
+#endif // __MATRIZ_FIJA_SITL_H
@@ -0,0 +1,398 @@
+/***************************************************************************************
+**  modelo_quad.c - Modelo de solido rigido de un cuadricoptero en X para SITL
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <string.h>
+#include <math.h>
+
+#include "modelo_quad.h"
+
+#if defined(SITL)
+#include "Comun/util.h"
+#include "Comun/matematicas.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define PRESION_NIVEL_MAR_MODELO      1013.25f     // mBar
+#define TEMPERATURA_NIVEL_MAR_MODELO  15.0f        // ºC
+#define GRADIENTE_TEMP_MODELO         0.0065f      // ºC/m
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    float roll;
+    float pitch;
+    float yaw;
+} geometriaMotor_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static parametrosModeloQuad_t parametros;
+static estadoModeloQuad_t estado;
+static uint32_t semillaRuido;
+
+// Misma disposicion que mixerQuadX
+static const geometriaMotor_t geometriaQuadX[NUM_MOTORES_MODELO_QUAD] = {
+    { -1.0f,  1.0f,  1.0f },          // Motor 1
+    {  1.0f,  1.0f, -1.0f },          // Motor 2
+    {  1.0f, -1.0f,  1.0f },          // Motor 3
+    { -1.0f, -1.0f, -1.0f },          // Motor 4
+};
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void rotarCuerpoATierraModeloQuad(const float *q, const float *vCuerpo, float *vTierra);
+void rotarTierraACuerpoModeloQuad(const float *q, const float *vTierra, float *vCuerpo);
+float ruidoGaussianoModeloQuad(float sigma);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         void iniciarModeloQuad(uint32_t semilla)
+**  Descripcion:    Carga los parametros por defecto y deja el vehiculo en reposo en el suelo
+**  Parametros:     Semilla del generador de ruido
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarModeloQuad(uint32_t semilla)
+{
+    // Cuadricoptero de 450 mm con motores de 2212
+    parametros.masa = 1.2f;
+    parametros.brazo = 0.225f;
+    parametros.empujeMax = 8.0f;
+    parametros.curvaEmpuje = 0.5f;
+    parametros.coefPar = 0.016f;
+    parametros.tauMotor = 0.03f;
+    parametros.rpmMax = 9000.0f;
+    parametros.inercia[0] = 0.011f;
+    parametros.inercia[1] = 0.011f;
+    parametros.inercia[2] = 0.021f;
+    parametros.arrastreLineal = 0.25f;
+    parametros.arrastreAngular = 0.002f;
+
+    // Campo magnetico aproximado en Logrono
+    parametros.campoMagTierra[0] = 255.0f;
+    parametros.campoMagTierra[1] = 0.0f;
+    parametros.campoMagTierra[2] = -375.0f;
+
+    parametros.ruidoGiro = 0.05f;
+    parametros.ruidoAcel = 0.002f;
+    parametros.ruidoBaro = 0.01f;
+    parametros.ruidoMag = 1.0f;
+
+    memset(&estado, 0, sizeof(estadoModeloQuad_t));
+    estado.q[0] = 1.0f;
+    estado.fuerzaEspecifica[2] = G_A_MSS;
+    estado.enSuelo = true;
+
+    semillaRuido = semilla != 0 ? semilla : 1;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void actualizarModeloQuad(uint32_t dt)
+**  Descripcion:    Integra el modelo un paso de tiempo
+**  Parametros:     Paso de integracion en us
+**  Retorno:        Ninguno
+****************************************************************************************/
+void actualizarModeloQuad(uint32_t dt)
+{
+    const float dtS = dt * 1e-6f;
+    const float kMotor = dtS / (parametros.tauMotor + dtS);
+    const float brazoEje = parametros.brazo * 0.70710678f;
+    float empujeTotal = 0;
+    float par[3] = {0, 0, 0};
+
+    estado.tiempo += dt;
+
+    // Motores con respuesta de primer orden
+    for (uint8_t i = 0; i < NUM_MOTORES_MODELO_QUAD; i++) {
+        const float mando = estado.mando[i];
+        const float objetivo = parametros.empujeMax * ((1.0f - parametros.curvaEmpuje) * mando + parametros.curvaEmpuje * mando * mando);
+
+        estado.empuje[i] += (objetivo - estado.empuje[i]) * kMotor;
+        empujeTotal += estado.empuje[i];
+
+        par[0] += brazoEje * geometriaQuadX[i].roll * estado.empuje[i];
+        par[1] += brazoEje * geometriaQuadX[i].pitch * estado.empuje[i];
+        par[2] += parametros.coefPar * geometriaQuadX[i].yaw * estado.empuje[i];
+    }
+
+    // Fuerzas en ejes tierra
+    const float empujeCuerpo[3] = {0, 0, empujeTotal};
+    float fuerza[3], acel[3];
+
+    rotarCuerpoATierraModeloQuad(estado.q, empujeCuerpo, fuerza);
+    for (uint8_t i = 0; i < 3; i++) {
+        fuerza[i] -= parametros.arrastreLineal * estado.velocidad[i];
+        acel[i] = fuerza[i] / parametros.masa;
+    }
+    acel[2] -= G_A_MSS;
+
+    // Contacto con el suelo. Solo se despega cuando el empuje vence al peso
+    if (estado.enSuelo && acel[2] <= 0) {
+        memset(acel, 0, sizeof(acel));
+        memset(estado.velocidad, 0, sizeof(estado.velocidad));
+        memset(estado.velAngular, 0, sizeof(estado.velAngular));
+    }
+    else {
+        // Ecuacion de Euler: I * dw = par - w x (I * w) - arrastre
+        const float *w = estado.velAngular;
+        const float *I = parametros.inercia;
+        float dw[3];
+
+        dw[0] = (par[0] - (I[2] - I[1]) * w[1] * w[2] - parametros.arrastreAngular * w[0]) / I[0];
+        dw[1] = (par[1] - (I[0] - I[2]) * w[2] * w[0] - parametros.arrastreAngular * w[1]) / I[1];
+        dw[2] = (par[2] - (I[1] - I[0]) * w[0] * w[1] - parametros.arrastreAngular * w[2]) / I[2];
+
+        for (uint8_t i = 0; i < 3; i++) {
+            estado.velAngular[i] += dw[i] * dtS;
+            estado.velocidad[i] += acel[i] * dtS;
+            estado.posicion[i] += estado.velocidad[i] * dtS;
+        }
+
+        estado.enSuelo = false;
+        if (estado.posicion[2] <= 0) {
+            estado.posicion[2] = 0;
+            memset(estado.velocidad, 0, sizeof(estado.velocidad));
+            memset(estado.velAngular, 0, sizeof(estado.velAngular));
+            memset(acel, 0, sizeof(acel));
+            estado.enSuelo = true;
+        }
+    }
+
+    // Integracion del cuaternion: dq = 0.5 * q x (0, w)
+    const float *q = estado.q;
+    const float *w = estado.velAngular;
+    float dq[4];
+
+    dq[0] = 0.5f * (-q[1] * w[0] - q[2] * w[1] - q[3] * w[2]);
+    dq[1] = 0.5f * ( q[0] * w[0] + q[2] * w[2] - q[3] * w[1]);
+    dq[2] = 0.5f * ( q[0] * w[1] - q[1] * w[2] + q[3] * w[0]);
+    dq[3] = 0.5f * ( q[0] * w[2] + q[1] * w[1] - q[2] * w[0]);
+
+    for (uint8_t i = 0; i < 4; i++)
+        estado.q[i] += dq[i] * dtS;
+
+    // Normalizacion exacta: la aproximacion de invSqrt deriva al integrar miles de pasos
+    const float norma = sqrtf(estado.q[0] * estado.q[0] + estado.q[1] * estado.q[1] + estado.q[2] * estado.q[2] + estado.q[3] * estado.q[3]);
+    for (uint8_t i = 0; i < 4; i++)
+        estado.q[i] /= norma;
+
+    // El acelerometro mide la fuerza especifica: a - g
+    acel[2] += G_A_MSS;
+    rotarTierraACuerpoModeloQuad(estado.q, acel, estado.fuerzaEspecifica);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void escribirMandoModeloQuad(uint8_t motor, float mando)
+**  Descripcion:    Escribe el mando de un motor
+**  Parametros:     Motor, mando entre 0 y 1
+**  Retorno:        Ninguno
+****************************************************************************************/
+void escribirMandoModeloQuad(uint8_t motor, float mando)
+{
+    if (motor < NUM_MOTORES_MODELO_QUAD)
+        estado.mando[motor] = limitarFloat(mando, 0.0f, 1.0f);
+}
+
+
+/***************************************************************************************
+**  Nombre:         parametrosModeloQuad_t *parametrosModeloQuad(void)
+**  Descripcion:    Devuelve los parametros del modelo para poder modificarlos
+**  Parametros:     Ninguno
+**  Retorno:        Puntero a los parametros
+****************************************************************************************/
+parametrosModeloQuad_t *parametrosModeloQuad(void)
+{
+    return &parametros;
+}
+
+
+/***************************************************************************************
+**  Nombre:         const estadoModeloQuad_t *estadoModeloQuad(void)
+**  Descripcion:    Devuelve el estado del modelo
+**  Parametros:     Ninguno
+**  Retorno:        Puntero al estado
+****************************************************************************************/
+const estadoModeloQuad_t *estadoModeloQuad(void)
+{
+    return &estado;
+}
+
+
+/***************************************************************************************
+**  Nombre:         float frecuenciaRotorModeloQuad(uint8_t motor)
+**  Descripcion:    Frecuencia de giro de un rotor. El empuje crece con el cuadrado de la
+**                  velocidad de giro
+**  Parametros:     Motor
+**  Retorno:        Frecuencia en Hz
+****************************************************************************************/
+float frecuenciaRotorModeloQuad(uint8_t motor)
+{
+    if (motor >= NUM_MOTORES_MODELO_QUAD || estado.empuje[motor] <= 0)
+        return 0;
+
+    return parametros.rpmMax * (1.0f / 60.0f) * sqrtf(estado.empuje[motor] / parametros.empujeMax);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void giroModeloQuad(float *giro)
+**  Descripcion:    Medida del giroscopio
+**  Parametros:     Velocidad angular en º/s
+**  Retorno:        Ninguno
+****************************************************************************************/
+void giroModeloQuad(float *giro)
+{
+    for (uint8_t i = 0; i < 3; i++)
+        giro[i] = grados(estado.velAngular[i]) + ruidoGaussianoModeloQuad(parametros.ruidoGiro);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void acelModeloQuad(float *acel)
+**  Descripcion:    Medida del acelerometro
+**  Parametros:     Aceleracion en g
+**  Retorno:        Ninguno
+****************************************************************************************/
+void acelModeloQuad(float *acel)
+{
+    for (uint8_t i = 0; i < 3; i++)
+        acel[i] = estado.fuerzaEspecifica[i] / G_A_MSS + ruidoGaussianoModeloQuad(parametros.ruidoAcel);
+}
+
+
+/***************************************************************************************
+**  Nombre:         float presionModeloQuad(void)
+**  Descripcion:    Medida del barometro con la atmosfera estandar
+**  Parametros:     Ninguno
+**  Retorno:        Presion en mBar
+****************************************************************************************/
+float presionModeloQuad(void)
+{
+    const float presion = PRESION_NIVEL_MAR_MODELO * powf(1.0f - 2.25577e-5f * estado.posicion[2], 5.25588f);
+    return presion + ruidoGaussianoModeloQuad(parametros.ruidoBaro);
+}
+
+
+/***************************************************************************************
+**  Nombre:         float temperaturaModeloQuad(void)
+**  Descripcion:    Temperatura del aire con la atmosfera estandar
+**  Parametros:     Ninguno
+**  Retorno:        Temperatura en ºC
+****************************************************************************************/
+float temperaturaModeloQuad(void)
+{
+    return TEMPERATURA_NIVEL_MAR_MODELO - GRADIENTE_TEMP_MODELO * estado.posicion[2];
+}
+
+
+/***************************************************************************************
+**  Nombre:         void campoMagModeloQuad(float *campo)
+**  Descripcion:    Medida del magnetometro
+**  Parametros:     Campo magnetico en mGa
+**  Retorno:        Ninguno
+****************************************************************************************/
+void campoMagModeloQuad(float *campo)
+{
+    rotarTierraACuerpoModeloQuad(estado.q, parametros.campoMagTierra, campo);
+
+    for (uint8_t i = 0; i < 3; i++)
+        campo[i] += ruidoGaussianoModeloQuad(parametros.ruidoMag);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void rotarCuerpoATierraModeloQuad(const float *q, const float *vCuerpo, float *vTierra)
+**  Descripcion:    Rota un vector de ejes cuerpo a ejes tierra
+**  Parametros:     Cuaternion, vector en ejes cuerpo, vector en ejes tierra
+**  Retorno:        Ninguno
+****************************************************************************************/
+void rotarCuerpoATierraModeloQuad(const float *q, const float *vCuerpo, float *vTierra)
+{
+    const float x = vCuerpo[0], y = vCuerpo[1], z = vCuerpo[2];
+
+    vTierra[0] = (1 - 2 * (q[2] * q[2] + q[3] * q[3])) * x + 2 * (q[1] * q[2] - q[0] * q[3]) * y + 2 * (q[1] * q[3] + q[0] * q[2]) * z;
+    vTierra[1] = 2 * (q[1] * q[2] + q[0] * q[3]) * x + (1 - 2 * (q[1] * q[1] + q[3] * q[3])) * y + 2 * (q[2] * q[3] - q[0] * q[1]) * z;
+    vTierra[2] = 2 * (q[1] * q[3] - q[0] * q[2]) * x + 2 * (q[2] * q[3] + q[0] * q[1]) * y + (1 - 2 * (q[1] * q[1] + q[2] * q[2])) * z;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void rotarTierraACuerpoModeloQuad(const float *q, const float *vTierra, float *vCuerpo)
+**  Descripcion:    Rota un vector de ejes tierra a ejes cuerpo
+**  Parametros:     Cuaternion, vector en ejes tierra, vector en ejes cuerpo
+**  Retorno:        Ninguno
+****************************************************************************************/
+void rotarTierraACuerpoModeloQuad(const float *q, const float *vTierra, float *vCuerpo)
+{
+    const float x = vTierra[0], y = vTierra[1], z = vTierra[2];
+
+    vCuerpo[0] = (1 - 2 * (q[2] * q[2] + q[3] * q[3])) * x + 2 * (q[1] * q[2] + q[0] * q[3]) * y + 2 * (q[1] * q[3] - q[0] * q[2]) * z;
+    vCuerpo[1] = 2 * (q[1] * q[2] - q[0] * q[3]) * x + (1 - 2 * (q[1] * q[1] + q[3] * q[3])) * y + 2 * (q[2] * q[3] + q[0] * q[1]) * z;
+    vCuerpo[2] = 2 * (q[1] * q[3] + q[0] * q[2]) * x + 2 * (q[2] * q[3] - q[0] * q[1]) * y + (1 - 2 * (q[1] * q[1] + q[2] * q[2])) * z;
+}
+
+
+/***************************************************************************************
+**  Nombre:         float ruidoGaussianoModeloQuad(float sigma)
+**  Descripcion:    Genera ruido gaussiano reproducible (xorshift32 + Box-Muller)
+**  Parametros:     Desviacion tipica
+**  Retorno:        Muestra de ruido
+****************************************************************************************/
+float ruidoGaussianoModeloQuad(float sigma)
+{
+    float u[2];
+
+    if (sigma <= 0)
+        return 0;
+
+    for (uint8_t i = 0; i < 2; i++) {
+        semillaRuido ^= semillaRuido << 13;
+        semillaRuido ^= semillaRuido >> 17;
+        semillaRuido ^= semillaRuido << 5;
+        u[i] = (semillaRuido >> 8) * (1.0f / 16777216.0f);
+    }
+
+    if (u[0] < 1e-7f)
+        u[0] = 1e-7f;
+
+    return sigma * sqrtf(-2.0f * logf(u[0])) * cosf(2.0f * M_PIf * u[1]);
+}
+
+#endif
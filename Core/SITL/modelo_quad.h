@@ -0,0 +1,104 @@
+/***************************************************************************************
+**  modelo_quad.h - Modelo de solido rigido de un cuadricoptero en X para SITL
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __MODELO_QUAD_H
+#define __MODELO_QUAD_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define NUM_MOTORES_MODELO_QUAD       4
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+/*
+ * Ejes del modelo:
+ *  - Tierra: x al norte, y al oeste, z hacia arriba
+ *  - Cuerpo: z hacia arriba, igual que las medidas de la IMU (en reposo el acelerometro mide +1 g en z)
+ * La geometria de los motores es la de la tabla mixerQuadX de FC/mixer.c
+ */
+typedef struct {
+    float masa;                                       // kg
+    float brazo;                                      // Distancia del motor al centro en m
+    float empujeMax;                                  // Empuje maximo de cada motor en N
+    float curvaEmpuje;                                // empuje = empujeMax * ((1 - curva) * mando + curva * mando^2)
+    float coefPar;                                    // Par de guinada por unidad de empuje en m
+    float tauMotor;                                   // Constante de tiempo de los motores en s
+    float rpmMax;                                     // rpm del rotor con el empuje maximo
+    float inercia[3];                                 // Momentos de inercia en kg*m^2
+    float arrastreLineal;                             // Coeficiente de arrastre lineal en N/(m/s)
+    float arrastreAngular;                            // Coeficiente de arrastre angular en N*m/(rad/s)
+    float campoMagTierra[3];                          // Campo magnetico terrestre en mGa (ejes tierra)
+    float ruidoGiro;                                  // Desviacion tipica en º/s
+    float ruidoAcel;                                  // Desviacion tipica en g
+    float ruidoBaro;                                  // Desviacion tipica en mBar
+    float ruidoMag;                                   // Desviacion tipica en mGa
+} parametrosModeloQuad_t;
+
+typedef struct {
+    float posicion[3];                                // m (ejes tierra)
+    float velocidad[3];                               // m/s (ejes tierra)
+    float q[4];                                       // Cuaternion de cuerpo a tierra
+    float velAngular[3];                              // rad/s (ejes cuerpo)
+    float fuerzaEspecifica[3];                        // m/s^2 (ejes cuerpo). Es lo que mide el acelerometro
+    float mando[NUM_MOTORES_MODELO_QUAD];             // Mando de los motores entre 0 y 1
+    float empuje[NUM_MOTORES_MODELO_QUAD];            // Empuje actual de cada motor en N
+    bool enSuelo;
+    uint64_t tiempo;                                  // Tiempo simulado en us
+} estadoModeloQuad_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void iniciarModeloQuad(uint32_t semilla);
+void actualizarModeloQuad(uint32_t dt);
+void escribirMandoModeloQuad(uint8_t motor, float mando);
+parametrosModeloQuad_t *parametrosModeloQuad(void);
+const estadoModeloQuad_t *estadoModeloQuad(void);
+
+void giroModeloQuad(float *giro);
+void acelModeloQuad(float *acel);
+float presionModeloQuad(void);
+float temperaturaModeloQuad(void);
+float frecuenciaRotorModeloQuad(uint8_t motor);
+void campoMagModeloQuad(float *campo);
+
+#endif // __MODELO_QUAD_H
@@ -0,0 +1,508 @@
+/***************************************************************************************
+**  ms5611_sitl.c - Modelo del protocolo del MS5611 para probar el driver del barometro
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "ms5611_sitl.h"
+
+#if defined(SITL) && defined(USAR_BARO)
+#include <stdio.h>
+#include <string.h>
+
+#include "sitl.h"
+#include "spi_sitl.h"
+#include "Comun/crc.h"
+#include "GP/gp_barometro.h"
+#include "Scheduler/scheduler.h"
+#include "Sensores/Barometro/barometro.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define CMD_RESET_MS5611_SITL           0x1E
+#define CMD_ADC_READ_MS5611_SITL        0x00
+#define CMD_PROM_RD_MS5611_SITL         0xA0
+#define CMD_CONV_D1_MS5611_SITL         0x40
+#define CMD_CONV_D2_MS5611_SITL         0x50
+
+#define DURACION_SEGMENTO_MS5611_SITL   100000       // Tiempo en us con los mismos D1 y D2
+#define PIN_CS_MS5611_SITL              0x40         // Tag del CS del primer sensor
+#define SEGMENTOS_DATASHEET_MS5611_SITL 10           // Cada cuantos segmentos el baro 1 da el ejemplo del datasheet
+
+// Ejemplo del datasheet
+#define D1_DATASHEET_MS5611_SITL        9085466
+#define D2_DATASHEET_MS5611_SITL        8569150
+#define P_DATASHEET_MS5611_SITL         100009       // 0.01 mbar
+#define TEMP_DATASHEET_MS5611_SITL      2007         // 0.01 ºC
+
+#define MIN_FRACCION_PRESIONES_SITL     0.9f         // Presiones por segundo minimas sobre el maximo teorico
+#define MAX_DESPERTARES_CONVERSION_SITL 1.25f        // Despertares de la tarea por conversion de un baro
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    numSPI_e numSPI;
+    uint16_t prom[8];
+    bool convirtiendo;
+    bool presion;                        // Conversion en curso de D1 o de D2
+    uint64_t finConversion;
+
+    // Estadisticas
+    uint32_t conversionesP;
+    uint32_t conversionesT;
+    uint32_t comandosSolapados;
+    uint32_t lecturasPrematuras;
+    uint32_t lecturasVacias;
+    uint32_t comandosDesconocidos;
+} ms5611SITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static ms5611SITL_t ms5611SITL[NUM_MS5611_SITL];
+static uint32_t semillaMS5611SITL = 1;
+static uint64_t ultimaTransferenciaSITL;
+static uint32_t despertaresSITL;
+
+static const uint16_t tiempoConversionMS5611SITL[] = {600, 1170, 2280, 4540, 9040};
+static const uint16_t coeficientesDatasheetSITL[6] = {40127, 36924, 23317, 23282, 33464, 28312};
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+static inline uint32_t aleatorioMS5611SITL(uint32_t *semilla);
+void iniciarModeloMS5611SITL(void);
+bool transferirMS5611SITL(const bus_t *bus, uint8_t reg, const uint8_t *datoTx, uint8_t *datoRx, uint8_t longitud);
+void transferirColaMS5611SITL(uint8_t numSPI, const uint8_t *datoTx, uint8_t *datoRx, uint16_t longitud);
+void atenderMS5611SITL(ms5611SITL_t *sensor, uint8_t numSensor, uint8_t reg, const uint8_t *datoTx, uint8_t *datoRx, uint8_t longitud);
+void comandoMS5611SITL(ms5611SITL_t *sensor, uint8_t comando);
+void valoresMS5611SITL(uint8_t numSensor, uint32_t segmento, uint32_t *d1, uint32_t *d2);
+void compensarMS5611SITL(const uint16_t *prom, uint32_t d1, uint32_t d2, int32_t *p, int32_t *temp);
+uint32_t comprobarSegmentoMS5611SITL(uint32_t segmento, uint32_t *datasheet);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool probarBaroMS5611SITL(uint32_t segundos)
+**  Descripcion:    Inicia los baros sobre el modelo y ejecuta sus tareas con el
+**                  scheduler comprobando las medidas, el protocolo y el caudal
+**  Parametros:     Segundos virtuales a medir despues de la calibracion
+**  Retorno:        True si no hay errores
+****************************************************************************************/
+bool probarBaroMS5611SITL(uint32_t segundos)
+{
+    uint32_t errores = 0, comprobaciones = 0, datasheet = 0, solapados = 0, prematuras = 0, vacias = 0;
+
+    iniciarModeloMS5611SITL();
+    conectarBusSITL(transferirMS5611SITL);
+
+    for (uint8_t i = 0; i < NUM_MAX_BARO; i++) {
+        configBaro_t *config = &configBaro_SistemaArray[i];
+
+        memset(config, 0, sizeof(*config));
+        config->tipoBaro = i < NUM_MS5611_SITL ? BARO_MS5611 : BARO_NINGUNO;
+        config->bus = BUS_SPI;
+        config->dispBus = ms5611SITL[i % NUM_MS5611_SITL].numSPI;
+        config->csSPI = PIN_CS_MS5611_SITL + i % NUM_MS5611_SITL;
+        config->frecActualizar = FREC_ACTUALIZAR_BARO_HZ;
+        config->frecLeer = FREC_LEER_BARO_HZ;
+    }
+
+    iniciarScheduler();
+    if (!iniciarBaro() || numBarosConectados() != NUM_MS5611_SITL) {
+        printf("baro_ms5611 no se han iniciado los %u baros\n", NUM_MS5611_SITL);
+        conectarBusSITL(NULL);
+        return false;
+    }
+
+    anadirTareaEnCola(&tareas[TAREA_ACTUALIZAR_BARO]);
+    anadirTareaEnCola(&tareas[TAREA_LEER_BARO]);
+
+    // Las estadisticas empiezan despues de la calibracion
+    for (uint8_t i = 0; i < NUM_MS5611_SITL; i++) {
+        ms5611SITL_t *sensor = &ms5611SITL[i];
+        errores += sensor->comandosSolapados + sensor->lecturasPrematuras + sensor->comandosDesconocidos;
+        sensor->conversionesP = sensor->conversionesT = sensor->lecturasVacias = 0;
+    }
+    despertaresSITL = 0;
+
+    const uint64_t inicio = tiempoSITL();
+    const uint64_t fin = inicio + (uint64_t)segundos * 1000000;
+    uint32_t segmento = tiempoSITL() / DURACION_SEGMENTO_MS5611_SITL;
+    bool segmentoCompleto = false;
+
+    while (tiempoSITL() < fin) {
+        scheduler();
+        avanzarTiempoSITL(PASO_BUCLE_SITL_US);
+
+        // Al cambiar de segmento se comprueba el anterior si se ha medido entero
+        const uint32_t actual = tiempoSITL() / DURACION_SEGMENTO_MS5611_SITL;
+        if (actual != segmento) {
+            if (segmentoCompleto) {
+                errores += comprobarSegmentoMS5611SITL(segmento, &datasheet);
+                comprobaciones++;
+            }
+
+            segmento = actual;
+            segmentoCompleto = true;
+        }
+    }
+
+    conectarBusSITL(NULL);
+
+    const float duracion = (tiempoSITL() - inicio) * 1e-6f;
+    const float maxPresiones = 1e6f / tiempoConversionMS5611SITL[3] * 4 / 5;
+
+    printf("baro_ms5611 baros=%u segundos=%.1f comprobaciones=%u datasheet=%u despertares_s=%.1f presiones/temperaturas_s",
+           NUM_MS5611_SITL, duracion, comprobaciones, datasheet, despertaresSITL / duracion);
+
+    for (uint8_t i = 0; i < NUM_MS5611_SITL; i++) {
+        const ms5611SITL_t *sensor = &ms5611SITL[i];
+        const float presiones = sensor->conversionesP / duracion;
+        const float conversiones = (sensor->conversionesP + sensor->conversionesT) / duracion;
+
+        printf(" baro%u=%.1f/%.1f", i + 1, presiones, sensor->conversionesT / duracion);
+
+        solapados += sensor->comandosSolapados;
+        prematuras += sensor->lecturasPrematuras;
+        vacias += sensor->lecturasVacias;
+        errores += sensor->comandosSolapados + sensor->lecturasPrematuras + sensor->lecturasVacias + sensor->comandosDesconocidos;
+        errores += presiones < MIN_FRACCION_PRESIONES_SITL * maxPresiones;
+        errores += despertaresSITL > MAX_DESPERTARES_CONVERSION_SITL * conversiones * duracion;
+    }
+
+    printf(" solapados=%u prematuras=%u vacias=%u errores=%u\n", solapados, prematuras, vacias, errores);
+
+    return errores == 0 && comprobaciones > 0 && datasheet > 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         static inline uint32_t aleatorioMS5611SITL(uint32_t *semilla)
+**  Descripcion:    Generador xorshift32
+**  Parametros:     Estado del generador
+**  Retorno:        Numero aleatorio
+****************************************************************************************/
+static inline uint32_t aleatorioMS5611SITL(uint32_t *semilla)
+{
+    uint32_t x = *semilla;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *semilla = x;
+    return x;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void iniciarModeloMS5611SITL(void)
+**  Descripcion:    Pone cada sensor en un SPI con la PROM del datasheet variada y su CRC
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarModeloMS5611SITL(void)
+{
+    for (uint8_t i = 0; i < NUM_MS5611_SITL; i++) {
+        ms5611SITL_t *sensor = &ms5611SITL[i];
+        uint16_t prom[8];
+
+        memset(sensor, 0, sizeof(*sensor));
+        sensor->numSPI = SPI_1 + i;
+
+        // Las lecturas bloqueantes llegan por el bus y las de la cola por el SPI simulado
+        conectarModeloSPISITL(sensor->numSPI, PIN_CS_MS5611_SITL + i, transferirColaMS5611SITL);
+
+        // El primero tiene los coeficientes del ejemplo del datasheet
+        prom[0] = 0x0A5A;
+        for (uint8_t j = 0; j < 6; j++)
+            prom[j + 1] = coeficientesDatasheetSITL[j] + i * (97 * (j + 1));
+        prom[7] = 0x4D00;
+
+        prom[7] |= calcularCRC4(prom);
+        memcpy(sensor->prom, prom, sizeof(prom));
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool transferirMS5611SITL(const bus_t *bus, uint8_t reg, const uint8_t *datoTx,
+**                                            uint8_t *datoRx, uint8_t longitud)
+**  Descripcion:    Atiende los comandos y lecturas bloqueantes del sensor del bus
+**  Parametros:     Bus, comando, datos a escribir (NULL en lectura), datos leidos, longitud
+**  Retorno:        True si hay un sensor en el bus
+****************************************************************************************/
+bool transferirMS5611SITL(const bus_t *bus, uint8_t reg, const uint8_t *datoTx, uint8_t *datoRx, uint8_t longitud)
+{
+    for (uint8_t i = 0; i < NUM_MS5611_SITL; i++) {
+        if (bus->tipo == BUS_SPI && bus->bus_u.spi.numSPI == ms5611SITL[i].numSPI) {
+            // Las transferencias en el mismo instante son de la misma ejecucion de la tarea
+            const uint64_t ahora = tiempoSITL();
+            if (ahora != ultimaTransferenciaSITL) {
+                ultimaTransferenciaSITL = ahora;
+                despertaresSITL++;
+            }
+
+            atenderMS5611SITL(&ms5611SITL[i], i, reg, datoTx, datoRx, longitud);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void transferirColaMS5611SITL(uint8_t numSPI, const uint8_t *datoTx, uint8_t *datoRx,
+**                                                uint16_t longitud)
+**  Descripcion:    Atiende una transferencia de la cola. El primer byte es el comando. Solo
+**                  las lecturas las lanza la tarea, los comandos los encadena el callback
+**  Parametros:     Puerto, datos enviados, datos recibidos, longitud
+**  Retorno:        Ninguno
+****************************************************************************************/
+void transferirColaMS5611SITL(uint8_t numSPI, const uint8_t *datoTx, uint8_t *datoRx, uint16_t longitud)
+{
+    for (uint8_t i = 0; i < NUM_MS5611_SITL; i++) {
+        if (ms5611SITL[i].numSPI != numSPI || datoTx == NULL || longitud == 0)
+            continue;
+
+        if (longitud == 1) {
+            atenderMS5611SITL(&ms5611SITL[i], i, datoTx[0], datoTx, NULL, 0);
+            return;
+        }
+
+        const uint64_t ahora = tiempoSITL();
+        if (ahora != ultimaTransferenciaSITL) {
+            ultimaTransferenciaSITL = ahora;
+            despertaresSITL++;
+        }
+
+        // Sin conversion terminada el ADC responde con ceros
+        memset(datoRx, 0, longitud);
+        atenderMS5611SITL(&ms5611SITL[i], i, datoTx[0], NULL, &datoRx[1], longitud - 1);
+        return;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void atenderMS5611SITL(ms5611SITL_t *sensor, uint8_t numSensor, uint8_t reg,
+**                                         const uint8_t *datoTx, uint8_t *datoRx, uint8_t longitud)
+**  Descripcion:    Ejecuta un comando o responde a una lectura del sensor
+**  Parametros:     Sensor, numero de sensor, comando, datos a escribir (NULL en lectura),
+**                  datos leidos, longitud
+**  Retorno:        Ninguno
+****************************************************************************************/
+void atenderMS5611SITL(ms5611SITL_t *sensor, uint8_t numSensor, uint8_t reg, const uint8_t *datoTx, uint8_t *datoRx, uint8_t longitud)
+{
+    const uint64_t ahora = tiempoSITL();
+
+    if (datoTx != NULL) {
+        comandoMS5611SITL(sensor, reg);
+        return;
+    }
+
+    if (reg >= CMD_PROM_RD_MS5611_SITL && reg < CMD_PROM_RD_MS5611_SITL + 16 && !(reg & 1) && longitud == 2) {
+        const uint16_t palabra = sensor->prom[(reg - CMD_PROM_RD_MS5611_SITL) >> 1];
+
+        datoRx[0] = palabra >> 8;
+        datoRx[1] = palabra & 0xFF;
+        return;
+    }
+
+    if (reg != CMD_ADC_READ_MS5611_SITL || longitud != 3) {
+        sensor->comandosDesconocidos++;
+        return;
+    }
+
+    // El ADC da 0 si no hay conversion terminada
+    if (!sensor->convirtiendo) {
+        sensor->lecturasVacias++;
+        return;
+    }
+
+    if (ahora < sensor->finConversion) {
+        sensor->lecturasPrematuras++;
+        return;
+    }
+
+    uint32_t d1, d2;
+    valoresMS5611SITL(numSensor, sensor->finConversion / DURACION_SEGMENTO_MS5611_SITL, &d1, &d2);
+
+    const uint32_t adc = sensor->presion ? d1 : d2;
+    datoRx[0] = adc >> 16;
+    datoRx[1] = (adc >> 8) & 0xFF;
+    datoRx[2] = adc & 0xFF;
+
+    sensor->convirtiendo = false;
+    if (sensor->presion)
+        sensor->conversionesP++;
+    else
+        sensor->conversionesT++;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void comandoMS5611SITL(ms5611SITL_t *sensor, uint8_t comando)
+**  Descripcion:    Ejecuta un comando de reset o de conversion
+**  Parametros:     Sensor, comando
+**  Retorno:        Ninguno
+****************************************************************************************/
+void comandoMS5611SITL(ms5611SITL_t *sensor, uint8_t comando)
+{
+    const uint64_t ahora = tiempoSITL();
+    const uint8_t tipo = comando & 0xF0;
+    const uint8_t osr = (comando & 0x0F) >> 1;
+
+    if (comando == CMD_RESET_MS5611_SITL) {
+        sensor->convirtiendo = false;
+        return;
+    }
+
+    if ((tipo != CMD_CONV_D1_MS5611_SITL && tipo != CMD_CONV_D2_MS5611_SITL) || (comando & 1) || osr > 4) {
+        sensor->comandosDesconocidos++;
+        return;
+    }
+
+    if (sensor->convirtiendo && ahora < sensor->finConversion)
+        sensor->comandosSolapados++;
+
+    const uint32_t maximo = tiempoConversionMS5611SITL[osr];
+    sensor->convirtiendo = true;
+    sensor->presion = tipo == CMD_CONV_D1_MS5611_SITL;
+    sensor->finConversion = ahora + maximo - aleatorioMS5611SITL(&semillaMS5611SITL) % (maximo / 10 + 1);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void valoresMS5611SITL(uint8_t numSensor, uint32_t segmento, uint32_t *d1, uint32_t *d2)
+**  Descripcion:    Da los valores del ADC de un segmento. La temperatura va de -40 a 85 ºC
+**                  para pasar por los dos tramos de segundo orden y la presion de 300 a
+**                  1100 mbar
+**  Parametros:     Sensor, segmento de tiempo, D1, D2
+**  Retorno:        Ninguno
+****************************************************************************************/
+void valoresMS5611SITL(uint8_t numSensor, uint32_t segmento, uint32_t *d1, uint32_t *d2)
+{
+    const uint16_t *prom = ms5611SITL[numSensor].prom;
+    uint32_t semilla = (segmento + 1) * 2654435761u ^ (numSensor + 1) * 40503u;
+
+    if (numSensor == 0 && segmento % SEGMENTOS_DATASHEET_MS5611_SITL == 0) {
+        *d1 = D1_DATASHEET_MS5611_SITL;
+        *d2 = D2_DATASHEET_MS5611_SITL;
+        return;
+    }
+
+    for (uint8_t i = 0; i < 4; i++)
+        aleatorioMS5611SITL(&semilla);
+
+    // D2 y D1 salen de la temperatura y la presion con las formulas de primer orden
+    const int32_t temperatura = -4000 + (int32_t)(aleatorioMS5611SITL(&semilla) % 12500);
+    const int64_t dT = (int64_t)(temperatura - 2000) * 8388608 / prom[6];
+    *d2 = ((int32_t)prom[5] << 8) + dT;
+
+    const int64_t off = ((int64_t)prom[2] << 16) + (int64_t)prom[4] * dT / 128;
+    const int64_t sens = ((int64_t)prom[1] << 15) + (int64_t)prom[3] * dT / 256;
+    const int64_t presion = 30000 + aleatorioMS5611SITL(&semilla) % 80000;
+    *d1 = ((presion * 32768 + off) * 2097152) / sens;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void compensarMS5611SITL(const uint16_t *prom, uint32_t d1, uint32_t d2,
+**                                           int32_t *p, int32_t *temp)
+**  Descripcion:    Formulas del datasheet con los coeficientes sin preparar
+**  Parametros:     PROM, D1, D2, presion en 0.01 mbar, temperatura en 0.01 ºC
+**  Retorno:        Ninguno
+****************************************************************************************/
+void compensarMS5611SITL(const uint16_t *prom, uint32_t d1, uint32_t d2, int32_t *p, int32_t *temp)
+{
+    const int64_t dT = (int64_t)d2 - (int64_t)prom[5] * 256;
+    int64_t t = 2000 + dT * prom[6] / 8388608;
+    int64_t off = (int64_t)prom[2] * 65536 + (int64_t)prom[4] * dT / 128;
+    int64_t sens = (int64_t)prom[1] * 32768 + (int64_t)prom[3] * dT / 256;
+
+    if (t < 2000) {
+        int64_t off2 = 5 * (t - 2000) * (t - 2000) / 2;
+        int64_t sens2 = 5 * (t - 2000) * (t - 2000) / 4;
+
+        if (t < -1500) {
+            off2 = off2 + 7 * (t + 1500) * (t + 1500);
+            sens2 = sens2 + 11 * (t + 1500) * (t + 1500) / 2;
+        }
+
+        t = t - dT * dT / 2147483648LL;
+        off = off - off2;
+        sens = sens - sens2;
+    }
+
+    *p = (d1 * sens / 2097152 - off) / 32768;
+    *temp = t;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t comprobarSegmentoMS5611SITL(uint32_t segmento, uint32_t *datasheet)
+**  Descripcion:    Compara la ultima medida de cada baro con la de los valores del segmento
+**  Parametros:     Segmento terminado, contador de comprobaciones del ejemplo del datasheet
+**  Retorno:        Numero de errores
+****************************************************************************************/
+uint32_t comprobarSegmentoMS5611SITL(uint32_t segmento, uint32_t *datasheet)
+{
+    uint32_t errores = 0;
+
+    for (uint8_t i = 0; i < NUM_MS5611_SITL; i++) {
+        uint32_t d1, d2;
+        int32_t p, temp;
+
+        valoresMS5611SITL(i, segmento, &d1, &d2);
+        compensarMS5611SITL(ms5611SITL[i].prom, d1, d2, &p, &temp);
+
+        // El ejemplo del datasheet comprueba tambien la referencia
+        if (d1 == D1_DATASHEET_MS5611_SITL && d2 == D2_DATASHEET_MS5611_SITL && i == 0) {
+            errores += p != P_DATASHEET_MS5611_SITL || temp != TEMP_DATASHEET_MS5611_SITL;
+            (*datasheet)++;
+        }
+
+        if (presionNumBaro(i) != p * 0.01f || temperaturaNumBaro(i) != temp * 0.01f) {
+            printf("baro_ms5611 baro%u segmento=%u presion=%.2f esperada=%.2f temperatura=%.2f esperada=%.2f\n",
+                   i + 1, segmento, presionNumBaro(i), p * 0.01f, temperaturaNumBaro(i), temp * 0.01f);
+            errores++;
+        }
+    }
+
+    return errores;
+}
+
+#endif
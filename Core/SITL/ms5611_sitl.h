@@ -0,0 +1,67 @@
+/***************************************************************************************
+**  ms5611_sitl.h - Modelo del protocolo del MS5611 para probar el driver del barometro
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __MS5611_SITL_H
+#define __MS5611_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Modela varios MS5611 en puertos SPI distintos con los comandos de reset, PROM,
+ * conversion y lectura del ADC. Cada conversion dura entre el 90 y el 100 % del tiempo
+ * maximo de su OSR en el reloj virtual. Leer el ADC antes de que termine devuelve 0 y un
+ * comando durante la conversion cuenta como solapado. Los valores de D1 y D2 cambian cada
+ * segmento de tiempo y al final de cada uno se compara la presion y la temperatura de
+ * cada baro con las formulas del datasheet. La prueba usa el modulo barometro y el
+ * scheduler reales, asi que mide tambien cuantas veces se despierta la tarea
+ */
+#define NUM_MS5611_SITL                 3
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarBaroMS5611SITL(uint32_t segundos);
+
+#endif // __MS5611_SITL_H
@@ -0,0 +1,652 @@
+/***************************************************************************************
+**  notch_rpm_sitl.c - Pruebas del banco de notch RPM en el PC
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "notch_rpm_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sitl.h"
+#include "Filtros/banco_notch_rpm.h"
+#include "Filtros/filtro_notch.h"
+#include "GP/gp.h"
+#include "GP/gp_imu.h"
+#include "Comun/matematicas.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define TAM_LINEA_NOTCH_SITL             4096
+#define MAX_COLUMNAS_NOTCH_SITL          256
+#define SEMILLA_NOTCH_SITL               0x2BADF00D
+#define FREC_MUESTREO_NOTCH_SITL         4000.0f
+#define NUM_MOTORES_LOG_NOTCH_SITL       8
+#define AMPLITUD_MOVIMIENTO_NOTCH_SITL   50.0f    // º/s del movimiento lento
+#define FREC_MOVIMIENTO_NOTCH_SITL       2.0f
+#define AMPLITUD_VIBRACION_NOTCH_SITL    4.0f     // º/s del primer armonico de cada rotor
+#define RUIDO_NOTCH_SITL                 0.05f    // º/s
+#define DURACION_BLOQUE_NOTCH_SITL       0.2f     // s por bloque de la demodulacion
+#define FREC_PASA_ALTO_NOTCH_SITL        50.0f    // Separa las vibraciones del movimiento antes de medir
+#define ERROR_MAX_GANANCIA_NOTCH_SITL    0.02f    // Error de ganancia admitido en el movimiento lento
+#define RETARDO_MAX_NOTCH_SITL           5.0f     // ms de retardo admitidos en el movimiento lento
+#define ITERACIONES_COSTE_NOTCH_SITL     20000
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    uint32_t numMuestras;
+    uint8_t numMotores;
+    float frecMuestreo;
+    float *giro;                                  // Tres ejes por muestra
+    float *frecuencia;                            // Frecuencia de giro de cada motor por muestra en Hz
+    float *limpio;                                // Giro sin vibraciones (solo en el log generado)
+} logNotchSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static const float *frecuenciaActualNotchSITL;
+static uint32_t semillaNotchSITL;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool generarLogNotchSITL(uint32_t numMuestras, logNotchSITL_t *log);
+bool leerLogNotchSITL(const char *fichero, logNotchSITL_t *log);
+void liberarLogNotchSITL(logNotchSITL_t *log);
+bool filtrarLogNotchSITL(const logNotchSITL_t *log, float *filtrado, uint32_t *ajustes);
+void pasaAltoNotchSITL(const logNotchSITL_t *log, const float *giro, float *salida);
+void medirArmonicosNotchSITL(const logNotchSITL_t *log, const float *giro, const uint8_t *armonico, uint8_t numArmonicos, float *amplitud);
+void medirMovimientoNotchSITL(const logNotchSITL_t *log, const float *giro, double *re, double *im);
+double medirCosteNotchSITL(uint8_t numMotores, bool banco);
+bool frecuenciaLogNotchSITL(uint8_t motor, float *frecuencia);
+uint16_t separarLineaNotchSITL(char *linea, char **columnas);
+float aleatorioNotchSITL(void);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool probarNotchRPMSITL(const char *datos)
+**  Descripcion:    Filtra el log, mide la atenuacion de cada armonico y el coste por
+**                  iteracion
+**  Parametros:     Fichero CSV o numero de muestras a generar
+**  Retorno:        True si el log se ha filtrado y, con el log generado, la atenuacion y
+**                  el movimiento lento cumplen
+****************************************************************************************/
+bool probarNotchRPMSITL(const char *datos)
+{
+    char *fin;
+    const uint32_t numMuestras = strtoul(datos, &fin, 0);
+    logNotchSITL_t log;
+    uint8_t armonico[NUM_MAX_ARMONICOS_NOTCH_RPM], numArmonicos = 0;
+    uint32_t ajustes;
+    bool ok;
+
+    resetearTodosGP();
+
+    if (*fin != '\0')
+        ok = leerLogNotchSITL(datos, &log);
+    else
+        ok = generarLogNotchSITL(numMuestras, &log);
+
+    if (!ok)
+        return false;
+
+    float *filtrado = malloc(3 * log.numMuestras * sizeof(float));
+    if (filtrado == NULL || !filtrarLogNotchSITL(&log, filtrado, &ajustes)) {
+        fprintf(stderr, "No se puede filtrar el log a %.1f Hz\n", (double)log.frecMuestreo);
+        free(filtrado);
+        liberarLogNotchSITL(&log);
+        return false;
+    }
+
+    printf("notch_rpm muestras=%u frec_muestreo_hz=%.1f motores=%u ajustes_muestra=%.2f\n", log.numMuestras,
+           (double)log.frecMuestreo, log.numMotores, (double)ajustes / log.numMuestras);
+
+    // Atenuacion de cada armonico configurado y de toda la banda de las vibraciones
+    float antes[NUM_MAX_ARMONICOS_NOTCH_RPM], despues[NUM_MAX_ARMONICOS_NOTCH_RPM];
+    float *vibracionAntes = malloc(3 * log.numMuestras * sizeof(float));
+    float *vibracionDespues = malloc(3 * log.numMuestras * sizeof(float));
+    double potenciaAntes = 0, potenciaDespues = 0;
+
+    if (vibracionAntes == NULL || vibracionDespues == NULL) {
+        free(vibracionAntes);
+        free(vibracionDespues);
+        free(filtrado);
+        liberarLogNotchSITL(&log);
+        return false;
+    }
+
+    for (uint8_t i = 0; i < NUM_MAX_ARMONICOS_NOTCH_RPM; i++) {
+        if ((1U << i) & configNotchRPM()->armonicos)
+            armonico[numArmonicos++] = i + 1;
+    }
+
+    pasaAltoNotchSITL(&log, log.giro, vibracionAntes);
+    pasaAltoNotchSITL(&log, filtrado, vibracionDespues);
+    medirArmonicosNotchSITL(&log, vibracionAntes, armonico, numArmonicos, antes);
+    medirArmonicosNotchSITL(&log, vibracionDespues, armonico, numArmonicos, despues);
+
+    for (uint32_t i = 0; i < 3 * log.numMuestras; i++) {
+        potenciaAntes += sq((double)vibracionAntes[i]);
+        potenciaDespues += sq((double)vibracionDespues[i]);
+    }
+
+    free(vibracionAntes);
+    free(vibracionDespues);
+
+    printf("notch_rpm banda rms_antes=%.4f rms_despues=%.4f atenuacion_db=%.1f\n", sqrt(potenciaAntes / (3 * log.numMuestras)),
+           sqrt(potenciaDespues / (3 * log.numMuestras)), potenciaDespues > 0 ? 10.0 * log10(potenciaAntes / potenciaDespues) : 0.0);
+
+    for (uint8_t i = 0; i < numArmonicos; i++) {
+        const float atenuacion = despues[i] > 0 ? 20.0f * log10f(antes[i] / despues[i]) : 0;
+
+        printf("notch_rpm armonico=%u amplitud_antes=%.4f amplitud_despues=%.4f atenuacion_db=%.1f\n", armonico[i],
+               (double)antes[i], (double)despues[i], (double)atenuacion);
+
+        if (log.limpio != NULL && atenuacion < ATENUACION_MIN_NOTCH_RPM_SITL)
+            ok = false;
+    }
+
+    // Con el log generado el movimiento lento pasa con su amplitud y el retardo de los notch
+    if (log.limpio != NULL) {
+        double reLimpio, imLimpio, reFiltrado, imFiltrado;
+
+        medirMovimientoNotchSITL(&log, log.limpio, &reLimpio, &imLimpio);
+        medirMovimientoNotchSITL(&log, filtrado, &reFiltrado, &imFiltrado);
+
+        const double ganancia = sqrt((sq(reFiltrado) + sq(imFiltrado)) / (sq(reLimpio) + sq(imLimpio)));
+        const double desfase = atan2(imLimpio, reLimpio) - atan2(imFiltrado, reFiltrado);
+        const double retardo = 1e3 * remainder(desfase, 2.0 * M_PI) / (2.0 * M_PI * FREC_MOVIMIENTO_NOTCH_SITL);
+
+        printf("notch_rpm movimiento_hz=%.1f ganancia=%.4f retardo_ms=%.2f\n", (double)FREC_MOVIMIENTO_NOTCH_SITL, ganancia, retardo);
+        if (fabs(ganancia - 1.0) > ERROR_MAX_GANANCIA_NOTCH_SITL || retardo > RETARDO_MAX_NOTCH_SITL)
+            ok = false;
+    }
+
+    free(filtrado);
+    liberarLogNotchSITL(&log);
+
+    // Coste por iteracion de los tres ejes
+    for (uint8_t motores = 4; motores <= NUM_MAX_MOTORES_NOTCH_RPM; motores += 4) {
+        const double nsBanco = medirCosteNotchSITL(motores, true);
+        const double nsAnterior = medirCosteNotchSITL(motores, false);
+
+        printf("notch_rpm motores=%u notch=%u ns_iteracion=%.1f ns_iteracion_recalculo=%.1f mejora=%.2f\n", motores,
+               motores * numArmonicos * 3, nsBanco, nsAnterior, nsAnterior / nsBanco);
+    }
+
+    return ok;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool filtrarLogNotchSITL(const logNotchSITL_t *log, float *filtrado, uint32_t *ajustes)
+**  Descripcion:    Pasa el log por el banco con un reajuste por turnos en cada muestra
+**  Parametros:     Log, giro filtrado, notch reajustados en total
+**  Retorno:        True si el banco se ha podido iniciar
+****************************************************************************************/
+bool filtrarLogNotchSITL(const logNotchSITL_t *log, float *filtrado, uint32_t *ajustes)
+{
+    static bancoNotchRPM_t banco;
+
+    if (!iniciarBancoNotchRPM(&banco, 3, log->numMotores, configNotchRPM()->armonicos, log->frecMuestreo,
+                              configNotchRPM()->frecMin, configNotchRPM()->anchoBanda, configNotchRPM()->atenuacionDB,
+                              8, frecuenciaLogNotchSITL))
+        return false;
+
+    for (uint32_t n = 0; n < log->numMuestras; n++) {
+        frecuenciaActualNotchSITL = &log->frecuencia[n * log->numMotores];
+        ajustarBancoNotchRPM(&banco);
+
+        memcpy(&filtrado[3 * n], &log->giro[3 * n], 3 * sizeof(float));
+        actualizarCanalesBancoNotchRPM(&banco, 0, 3, &filtrado[3 * n]);
+    }
+
+    *ajustes = banco.ajustes;
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void pasaAltoNotchSITL(const logNotchSITL_t *log, const float *giro, float *salida)
+**  Descripcion:    Pasa alto Butterworth de 4 polos que deja solo la banda de las vibraciones
+**  Parametros:     Log, giro de entrada, giro filtrado
+**  Retorno:        Ninguno
+****************************************************************************************/
+void pasaAltoNotchSITL(const logNotchSITL_t *log, const float *giro, float *salida)
+{
+    // Dos biquads con Q de Butterworth de orden 4
+    const double Q[2] = { 0.54119610, 1.30656296 };
+    const double omega = 2.0 * M_PI * FREC_PASA_ALTO_NOTCH_SITL / log->frecMuestreo;
+    double b[2][3], a[2][3], estado[2][3][2] = {{{0}}};
+
+    for (uint8_t k = 0; k < 2; k++) {
+        const double alpha = sin(omega) / (2.0 * Q[k]);
+        const double a0 = 1.0 + alpha;
+
+        b[k][0] = (1.0 + cos(omega)) / 2.0 / a0;
+        b[k][1] = -(1.0 + cos(omega)) / a0;
+        b[k][2] = b[k][0];
+        a[k][1] = -2.0 * cos(omega) / a0;
+        a[k][2] = (1.0 - alpha) / a0;
+    }
+
+    for (uint32_t n = 0; n < log->numMuestras; n++) {
+        for (uint8_t e = 0; e < 3; e++) {
+            double x = giro[3 * n + e];
+
+            for (uint8_t k = 0; k < 2; k++) {
+                const double y = b[k][0] * x + estado[k][e][0];
+                estado[k][e][0] = b[k][1] * x - a[k][1] * y + estado[k][e][1];
+                estado[k][e][1] = b[k][2] * x - a[k][2] * y;
+                x = y;
+            }
+
+            salida[3 * n + e] = x;
+        }
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void medirMovimientoNotchSITL(const logNotchSITL_t *log, const float *giro, double *re, double *im)
+**  Descripcion:    Componente del eje x a la frecuencia del movimiento lento del log generado
+**  Parametros:     Log, giro, parte real e imaginaria
+**  Retorno:        Ninguno
+****************************************************************************************/
+void medirMovimientoNotchSITL(const logNotchSITL_t *log, const float *giro, double *re, double *im)
+{
+    // Numero entero de periodos para que no haya fugas
+    const uint32_t muestrasPeriodo = log->frecMuestreo / FREC_MOVIMIENTO_NOTCH_SITL;
+    const uint32_t numMuestras = (log->numMuestras / muestrasPeriodo) * muestrasPeriodo;
+
+    *re = *im = 0;
+    for (uint32_t n = 0; n < numMuestras; n++) {
+        const double fase = 2.0 * M_PI * FREC_MOVIMIENTO_NOTCH_SITL * n / log->frecMuestreo;
+
+        *re += giro[3 * n] * cos(fase);
+        *im -= giro[3 * n] * sin(fase);
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void medirArmonicosNotchSITL(const logNotchSITL_t *log, const float *giro,
+**                                               const uint8_t *armonico, uint8_t numArmonicos, float *amplitud)
+**  Descripcion:    Amplitud media de cada armonico sumada para todos los motores y ejes. La
+**                  fase de cada motor se integra con su frecuencia y se demodula por bloques
+**                  con ventana de Hann para que no se mezclen los motores cercanos
+**  Parametros:     Log, giro a medir, multiplos, numero de armonicos, amplitudes
+**  Retorno:        Ninguno
+****************************************************************************************/
+void medirArmonicosNotchSITL(const logNotchSITL_t *log, const float *giro, const uint8_t *armonico, uint8_t numArmonicos, float *amplitud)
+{
+    const uint32_t muestrasBloque = DURACION_BLOQUE_NOTCH_SITL * log->frecMuestreo;
+    double fase[NUM_MAX_MOTORES_NOTCH_RPM] = {0};
+    double re[NUM_MAX_MOTORES_NOTCH_RPM][NUM_MAX_ARMONICOS_NOTCH_RPM][3] = {{{0}}};
+    double im[NUM_MAX_MOTORES_NOTCH_RPM][NUM_MAX_ARMONICOS_NOTCH_RPM][3] = {{{0}}};
+    double suma[NUM_MAX_ARMONICOS_NOTCH_RPM] = {0};
+    uint32_t bloques = 0, enBloque = 0;
+
+    for (uint32_t n = 0; n < log->numMuestras; n++) {
+        const double ventana = 1.0 - cos(2.0 * M_PI * enBloque / muestrasBloque);
+
+        for (uint8_t m = 0; m < log->numMotores; m++) {
+            fase[m] += 2.0 * M_PI * log->frecuencia[n * log->numMotores + m] / log->frecMuestreo;
+
+            for (uint8_t h = 0; h < numArmonicos; h++) {
+                const double c = ventana * cos(armonico[h] * fase[m]), s = ventana * sin(armonico[h] * fase[m]);
+
+                for (uint8_t e = 0; e < 3; e++) {
+                    re[m][h][e] += giro[3 * n + e] * c;
+                    im[m][h][e] -= giro[3 * n + e] * s;
+                }
+            }
+        }
+
+        if (++enBloque < muestrasBloque && n + 1 < log->numMuestras)
+            continue;
+
+        // Los bloques incompletos del final no cuentan
+        if (enBloque == muestrasBloque) {
+            for (uint8_t m = 0; m < log->numMotores; m++) {
+                for (uint8_t h = 0; h < numArmonicos; h++) {
+                    for (uint8_t e = 0; e < 3; e++)
+                        suma[h] += 2.0 * sqrt(sq(re[m][h][e]) + sq(im[m][h][e])) / enBloque;
+                }
+            }
+            bloques++;
+        }
+
+        memset(re, 0, sizeof(re));
+        memset(im, 0, sizeof(im));
+        enBloque = 0;
+    }
+
+    for (uint8_t h = 0; h < numArmonicos; h++)
+        amplitud[h] = bloques > 0 ? suma[h] / bloques : 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         double medirCosteNotchSITL(uint8_t numMotores, bool banco)
+**  Descripcion:    Mide el coste de reajustar y filtrar los tres ejes en una iteracion con
+**                  el banco por turnos o recalculando todos los filtros de armonicos
+**  Parametros:     Numero de motores, true para medir el banco
+**  Retorno:        ns por iteracion
+****************************************************************************************/
+double medirCosteNotchSITL(uint8_t numMotores, bool banco)
+{
+    static bancoNotchRPM_t bancoRPM;
+    static filtroNotchArmonicos_t filtros[NUM_MAX_MOTORES_NOTCH_RPM][3];
+    static float frecuencias[NUM_MAX_MOTORES_NOTCH_RPM];
+    double inicio, fin;
+    volatile float salida = 0;
+    float muestras[3];
+
+    for (uint8_t m = 0; m < numMotores; m++) {
+        frecuencias[m] = 150.0f + 10.0f * m;
+        for (uint8_t e = 0; e < 3; e++)
+            ajustarFiltroNotchArmonicos(&filtros[m][e], frecuencias[m], FREC_MUESTREO_NOTCH_SITL,
+                                        frecuencias[m] * configNotchRPM()->anchoBanda, configNotchRPM()->atenuacionDB,
+                                        configNotchRPM()->armonicos);
+    }
+
+    frecuenciaActualNotchSITL = frecuencias;
+    iniciarBancoNotchRPM(&bancoRPM, 3, numMotores, configNotchRPM()->armonicos, FREC_MUESTREO_NOTCH_SITL,
+                         configNotchRPM()->frecMin, configNotchRPM()->anchoBanda, configNotchRPM()->atenuacionDB, 8,
+                         frecuenciaLogNotchSITL);
+
+    inicio = tiempoRealNsSITL();
+
+    for (uint32_t i = 0; i < ITERACIONES_COSTE_NOTCH_SITL; i++) {
+        for (uint8_t m = 0; m < numMotores; m++)
+            frecuencias[m] += (i & 1) ? 0.1f : -0.1f;
+
+        for (uint8_t e = 0; e < 3; e++)
+            muestras[e] = (float)((i + e) & 0xFF) - 128.0f;
+
+        if (banco) {
+            ajustarBancoNotchRPM(&bancoRPM);
+            actualizarCanalesBancoNotchRPM(&bancoRPM, 0, 3, muestras);
+        }
+        else {
+            for (uint8_t m = 0; m < numMotores; m++) {
+                for (uint8_t e = 0; e < 3; e++) {
+                    actualizarFrecFiltroNotchArmonicos(&filtros[m][e], frecuencias[m]);
+                    muestras[e] = actualizarFiltroNotchArmonicos(&filtros[m][e], muestras[e]);
+                }
+            }
+        }
+
+        salida += muestras[0] + muestras[1] + muestras[2];
+    }
+
+    fin = tiempoRealNsSITL();
+
+    const double s = (fin - inicio) * 1e-9;
+    return s * 1e9 / ITERACIONES_COSTE_NOTCH_SITL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool generarLogNotchSITL(uint32_t numMuestras, logNotchSITL_t *log)
+**  Descripcion:    Genera un log con un movimiento lento y los armonicos de los rotores,
+**                  cuya velocidad cambia de forma distinta en cada motor
+**  Parametros:     Numero de muestras, log generado
+**  Retorno:        True si ok
+****************************************************************************************/
+bool generarLogNotchSITL(uint32_t numMuestras, logNotchSITL_t *log)
+{
+    double fase[NUM_MOTORES_LOG_NOTCH_SITL] = {0};
+    float ganancia[NUM_MOTORES_LOG_NOTCH_SITL][3];
+
+    memset(log, 0, sizeof(logNotchSITL_t));
+    if (numMuestras == 0)
+        return false;
+
+    log->numMuestras = numMuestras;
+    log->numMotores = NUM_MOTORES_LOG_NOTCH_SITL;
+    log->frecMuestreo = FREC_MUESTREO_NOTCH_SITL;
+    log->giro = malloc(3 * numMuestras * sizeof(float));
+    log->limpio = malloc(3 * numMuestras * sizeof(float));
+    log->frecuencia = malloc(NUM_MOTORES_LOG_NOTCH_SITL * numMuestras * sizeof(float));
+
+    if (log->giro == NULL || log->limpio == NULL || log->frecuencia == NULL) {
+        liberarLogNotchSITL(log);
+        return false;
+    }
+
+    // Cada motor vibra con distinta intensidad en cada eje
+    semillaNotchSITL = SEMILLA_NOTCH_SITL;
+    for (uint8_t m = 0; m < NUM_MOTORES_LOG_NOTCH_SITL; m++) {
+        for (uint8_t e = 0; e < 3; e++)
+            ganancia[m][e] = 0.5f + 0.5f * (aleatorioNotchSITL() + 1.0f) * 0.5f;
+    }
+
+    for (uint32_t n = 0; n < numMuestras; n++) {
+        const double t = n / (double)FREC_MUESTREO_NOTCH_SITL;
+        float *frecuencia = &log->frecuencia[n * NUM_MOTORES_LOG_NOTCH_SITL];
+
+        for (uint8_t e = 0; e < 3; e++)
+            log->limpio[3 * n + e] = AMPLITUD_MOVIMIENTO_NOTCH_SITL * sin(2.0 * M_PI * FREC_MOVIMIENTO_NOTCH_SITL * t + e);
+
+        for (uint8_t e = 0; e < 3; e++)
+            log->giro[3 * n + e] = log->limpio[3 * n + e] + RUIDO_NOTCH_SITL * aleatorioNotchSITL();
+
+        for (uint8_t m = 0; m < NUM_MOTORES_LOG_NOTCH_SITL; m++) {
+            // Entre 100 y 300 Hz con cambios lentos y distintos en cada motor
+            frecuencia[m] = (130.0f + 15.0f * m) * (1.0f + 0.3f * sin(2.0 * M_PI * (0.3 + 0.07 * m) * t + m));
+            fase[m] += 2.0 * M_PI * frecuencia[m] / FREC_MUESTREO_NOTCH_SITL;
+
+            for (uint8_t h = 1; h <= NUM_MAX_ARMONICOS_NOTCH_RPM; h++) {
+                const float vibracion = AMPLITUD_VIBRACION_NOTCH_SITL / h * sin(h * fase[m] + 0.5 * h * m);
+
+                for (uint8_t e = 0; e < 3; e++)
+                    log->giro[3 * n + e] += ganancia[m][e] * vibracion;
+            }
+        }
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool leerLogNotchSITL(const char *fichero, logNotchSITL_t *log)
+**  Descripcion:    Lee el tiempo, el giro y las rpm de los motores del CSV. Las filas sin
+**                  giro o sin rpm se saltan
+**  Parametros:     Ruta del CSV, log leido
+**  Retorno:        True si ok
+****************************************************************************************/
+bool leerLogNotchSITL(const char *fichero, logNotchSITL_t *log)
+{
+    FILE *entrada = fopen(fichero, "r");
+    static char linea[TAM_LINEA_NOTCH_SITL];
+    char *columnas[MAX_COLUMNAS_NOTCH_SITL];
+    int16_t columnaTiempo = -1, columnaGiro[3] = {-1, -1, -1}, columnaRPM[NUM_MAX_MOTORES_NOTCH_RPM];
+    int16_t ultimaColumna = 0;
+    uint32_t capacidad = 0;
+    double tiempoInicio = 0, tiempoFin = 0;
+
+    memset(log, 0, sizeof(logNotchSITL_t));
+
+    if (entrada == NULL) {
+        fprintf(stderr, "No se puede abrir %s\n", fichero);
+        return false;
+    }
+
+    // Cabecera
+    if (fgets(linea, sizeof(linea), entrada) != NULL) {
+        const uint16_t numColumnas = separarLineaNotchSITL(linea, columnas);
+
+        for (uint16_t i = 0, eje = 0; i < numColumnas; i++) {
+            if (columnaTiempo < 0 && strncmp(columnas[i], "tiempo", 6) == 0)
+                columnaTiempo = i;
+            else if (eje < 3 && strncmp(columnas[i], "giro", 4) == 0)
+                columnaGiro[eje++] = i;
+            else if (log->numMotores < NUM_MAX_MOTORES_NOTCH_RPM && strncmp(columnas[i], "rpm", 3) == 0)
+                columnaRPM[log->numMotores++] = i;
+            else
+                continue;
+
+            ultimaColumna = i;
+        }
+    }
+
+    if (columnaTiempo < 0 || columnaGiro[2] < 0 || log->numMotores == 0) {
+        fprintf(stderr, "Faltan las columnas tiempo, giro y rpm en %s\n", fichero);
+        fclose(entrada);
+        return false;
+    }
+
+    while (fgets(linea, sizeof(linea), entrada) != NULL) {
+        const uint16_t numColumnas = separarLineaNotchSITL(linea, columnas);
+
+        if (numColumnas <= ultimaColumna || columnas[columnaGiro[0]][0] == '\0' || columnas[columnaRPM[0]][0] == '\0')
+            continue;
+
+        if (log->numMuestras == capacidad) {
+            capacidad = capacidad > 0 ? 2 * capacidad : 4096;
+            log->giro = realloc(log->giro, 3 * capacidad * sizeof(float));
+            log->frecuencia = realloc(log->frecuencia, log->numMotores * capacidad * sizeof(float));
+            if (log->giro == NULL || log->frecuencia == NULL) {
+                fclose(entrada);
+                liberarLogNotchSITL(log);
+                return false;
+            }
+        }
+
+        const double tiempo = strtod(columnas[columnaTiempo], NULL);
+        if (log->numMuestras == 0)
+            tiempoInicio = tiempo;
+        tiempoFin = tiempo;
+
+        for (uint8_t e = 0; e < 3; e++)
+            log->giro[3 * log->numMuestras + e] = strtof(columnas[columnaGiro[e]], NULL);
+        for (uint8_t m = 0; m < log->numMotores; m++)
+            log->frecuencia[log->numMuestras * log->numMotores + m] = strtof(columnas[columnaRPM[m]], NULL) / 60.0f;
+        log->numMuestras++;
+    }
+
+    fclose(entrada);
+
+    if (log->numMuestras > 1 && tiempoFin > tiempoInicio)
+        log->frecMuestreo = (log->numMuestras - 1) * 1e6 / (tiempoFin - tiempoInicio);
+
+    if (log->frecMuestreo <= 0) {
+        fprintf(stderr, "No hay muestras suficientes en %s\n", fichero);
+        liberarLogNotchSITL(log);
+        return false;
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void liberarLogNotchSITL(logNotchSITL_t *log)
+**  Descripcion:    Libera la memoria del log
+**  Parametros:     Log
+**  Retorno:        Ninguno
+****************************************************************************************/
+void liberarLogNotchSITL(logNotchSITL_t *log)
+{
+    free(log->giro);
+    free(log->frecuencia);
+    free(log->limpio);
+    log->giro = log->frecuencia = log->limpio = NULL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool frecuenciaLogNotchSITL(uint8_t motor, float *frecuencia)
+**  Descripcion:    Fuente de la frecuencia de giro con los datos de la muestra actual
+**  Parametros:     Motor, frecuencia en Hz
+**  Retorno:        True si el motor gira
+****************************************************************************************/
+bool frecuenciaLogNotchSITL(uint8_t motor, float *frecuencia)
+{
+    *frecuencia = frecuenciaActualNotchSITL[motor];
+    return *frecuencia > 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t separarLineaNotchSITL(char *linea, char **columnas)
+**  Descripcion:    Separa una linea del CSV por comas (se modifica la linea)
+**  Parametros:     Linea, punteros a las columnas
+**  Retorno:        Numero de columnas
+****************************************************************************************/
+uint16_t separarLineaNotchSITL(char *linea, char **columnas)
+{
+    uint16_t numColumnas = 0;
+
+    linea[strcspn(linea, "\r\n")] = '\0';
+    columnas[numColumnas++] = linea;
+
+    for (char *p = linea; *p != '\0' && numColumnas < MAX_COLUMNAS_NOTCH_SITL; p++) {
+        if (*p == ',') {
+            *p = '\0';
+            columnas[numColumnas++] = p + 1;
+        }
+    }
+
+    return numColumnas;
+}
+
+
+/***************************************************************************************
+**  Nombre:         float aleatorioNotchSITL(void)
+**  Descripcion:    Generador xorshift para que la prueba sea reproducible
+**  Parametros:     Ninguno
+**  Retorno:        Numero aleatorio entre -1 y 1
+****************************************************************************************/
+float aleatorioNotchSITL(void)
+{
+    uint32_t x = semillaNotchSITL;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    semillaNotchSITL = x;
+    return (x / 4294967295.0f) * 2.0f - 1.0f;
+}
+
+#endif
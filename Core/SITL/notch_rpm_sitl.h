@@ -0,0 +1,74 @@
+/***************************************************************************************
+**  notch_rpm_sitl.h - Pruebas del banco de notch RPM en el PC
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __NOTCH_RPM_SITL_H
+#define __NOTCH_RPM_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Pasa un log de giro con las rpm de los motores por el banco de notch RPM con la
+ * configuracion por defecto, reajustando por turnos en cada muestra como en la lectura
+ * de la IMU. El CSV debe tener cabecera con una columna que empiece por "tiempo" en us,
+ * las tres primeras columnas que empiezan por "giro" y hasta 12 columnas que empiezan por
+ * "rpm" (rpm mecanicas), como la captura de la telemetria con los canales giro_imu1 y
+ * rpm_motores. Con un numero se genera un log de esas muestras con 8 motores que cambian
+ * de velocidad, un movimiento lento y los armonicos de cada rotor en los tres ejes.
+ *
+ * Las vibraciones se separan del movimiento con un pasa alto de 50 Hz y la atenuacion de
+ * cada armonico se mide con una demodulacion sincrona: la fase de cada motor se integra
+ * con su frecuencia y se mide la amplitud a ese armonico por bloques con ventana antes y
+ * despues del filtro. Con el log generado se comprueba ademas que el movimiento lento pasa
+ * con su amplitud y se mide el retardo que le anaden los notch. Despues se mide el coste por iteracion con 4, 8 y 12 motores
+ * frente a recalcular todos los filtroNotchArmonicos_t con sinf, cosf, powf y log2f
+ */
+#define ATENUACION_MIN_NOTCH_RPM_SITL    20.0f   // dB exigidos a cada armonico con el log generado
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarNotchRPMSITL(const char *datos);
+
+#endif // __NOTCH_RPM_SITL_H
@@ -0,0 +1,317 @@
+/***************************************************************************************
+**  rejilla_hash_sitl.c - Prueba y medida de la rejilla hash frente a la busqueda lineal
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "rejilla_hash_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sitl.h"
+#include "Comun/rejilla_hash.h"
+#include "Comun/util.h"
+#include "Comun/matematicas.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define MAX_MUESTRAS_REJILLA_SITL          16384
+#define CANDIDATAS_POR_MUESTRA_REJILLA_SITL 8
+#define RADIO_REJILLA_SITL                 400.0f   // mGa
+#define OFFSET_REJILLA_SITL                150.0f
+#define RUIDO_REJILLA_SITL                 2.0f
+#define GIRO_REJILLA_SITL                  0.08f    // Giro maximo entre candidatas en rad
+#define FACTOR_FILTRO_REJILLA_SITL         1.1f     // Distancia del filtrado / distancia de aceptacion
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    float (*puntos)[3];
+    uint32_t numPuntos;
+    uint16_t *siguientes;
+    uint16_t *cabezas;
+    rejillaHash_t rejilla;
+} conjuntoRejillaSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static uint32_t semillaRejillaSITL;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void generarCandidatasRejillaSITL(float (*candidatas)[3], uint32_t numCandidatas);
+bool hayVecinoLinealRejillaSITL(float (*puntos)[3], uint32_t numPuntos, const float *punto, float distanciaMin2, uint32_t indiceIgnorado);
+uint32_t filtrarLinealRejillaSITL(float (*puntos)[3], uint32_t numPuntos, float distanciaMin2);
+uint32_t filtrarHashRejillaSITL(conjuntoRejillaSITL_t *conjunto, float distanciaMin);
+float distanciaMinRejillaSITL(uint32_t numMuestras);
+float aleatorioRejillaSITL(void);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool probarRejillaHashSITL(uint32_t numMuestras)
+**  Descripcion:    Acepta y filtra muestras con la rejilla y con la busqueda lineal
+**  Parametros:     Tamanio del buffer de muestras
+**  Retorno:        True si las dos versiones dan las mismas muestras
+****************************************************************************************/
+bool probarRejillaHashSITL(uint32_t numMuestras)
+{
+    const uint32_t numCandidatas = CANDIDATAS_POR_MUESTRA_REJILLA_SITL * numMuestras;
+    conjuntoRejillaSITL_t hash;
+    float (*lineal)[3];
+    float (*candidatas)[3];
+    uint32_t numLineal = 0, numCubetas = 1;
+
+    if (numMuestras < 2 || numMuestras > MAX_MUESTRAS_REJILLA_SITL) {
+        printf("rejilla_hash muestras=%u fuera de rango (2-%u)\n", numMuestras, MAX_MUESTRAS_REJILLA_SITL);
+        return false;
+    }
+
+    // Unas dos cubetas por muestra
+    while (numCubetas < 2 * numMuestras)
+        numCubetas <<= 1;
+
+    hash.puntos = malloc(numMuestras * sizeof(hash.puntos[0]));
+    hash.siguientes = malloc(numMuestras * sizeof(uint16_t));
+    hash.cabezas = malloc(numCubetas * sizeof(uint16_t));
+    hash.numPuntos = 0;
+    lineal = malloc(numMuestras * sizeof(lineal[0]));
+    candidatas = malloc(numCandidatas * sizeof(candidatas[0]));
+    if (hash.puntos == NULL || hash.siguientes == NULL || hash.cabezas == NULL || lineal == NULL || candidatas == NULL ||
+        !iniciarRejillaHash(&hash.rejilla, (const float (*)[3])hash.puntos, numMuestras, hash.siguientes, hash.cabezas, numCubetas)) {
+        printf("rejilla_hash muestras=%u error=memoria\n", numMuestras);
+        return false;
+    }
+
+    generarCandidatasRejillaSITL(candidatas, numCandidatas);
+    const float distanciaMin = distanciaMinRejillaSITL(numMuestras);
+
+    // Aceptacion de muestras como en cogerMuestraCalMag
+    vaciarRejillaHash(&hash.rejilla, distanciaMin);
+    const double inicioAceptarHash = tiempoRealNsSITL();
+    for (uint32_t i = 0; i < numCandidatas && hash.numPuntos < numMuestras; i++) {
+        if (!hayVecinoRejillaHash(&hash.rejilla, candidatas[i], NINGUNO_REJILLA_HASH)) {
+            memcpy(hash.puntos[hash.numPuntos], candidatas[i], sizeof(candidatas[0]));
+            insertarRejillaHash(&hash.rejilla, hash.numPuntos++);
+        }
+    }
+    const double nsAceptarHash = tiempoRealNsSITL() - inicioAceptarHash;
+
+    const double inicioAceptarLineal = tiempoRealNsSITL();
+    for (uint32_t i = 0; i < numCandidatas && numLineal < numMuestras; i++) {
+        if (!hayVecinoLinealRejillaSITL(lineal, numLineal, candidatas[i], distanciaMin * distanciaMin, UINT32_MAX))
+            memcpy(lineal[numLineal++], candidatas[i], sizeof(candidatas[0]));
+    }
+    const double nsAceptarLineal = tiempoRealNsSITL() - inicioAceptarLineal;
+
+    bool ok = hash.numPuntos == numLineal && memcmp(hash.puntos, lineal, numLineal * sizeof(lineal[0])) == 0;
+    const uint32_t aceptadas = numLineal;
+
+    // Filtrado del paso 2 sobre las mismas muestras barajadas
+    for (uint32_t i = numLineal - 1; i >= 1; i--) {
+        const uint32_t j = (uint32_t)(aleatorioRejillaSITL() * (i + 1));
+        float temp[3];
+
+        memcpy(temp, lineal[i], sizeof(temp));
+        memcpy(lineal[i], lineal[j], sizeof(temp));
+        memcpy(lineal[j], temp, sizeof(temp));
+    }
+    memcpy(hash.puntos, lineal, numLineal * sizeof(lineal[0]));
+
+    const double inicioFiltrarHash = tiempoRealNsSITL();
+    hash.numPuntos = filtrarHashRejillaSITL(&hash, FACTOR_FILTRO_REJILLA_SITL * distanciaMin);
+    const double nsFiltrarHash = tiempoRealNsSITL() - inicioFiltrarHash;
+
+    const double inicioFiltrarLineal = tiempoRealNsSITL();
+    numLineal = filtrarLinealRejillaSITL(lineal, numLineal, sq(FACTOR_FILTRO_REJILLA_SITL * distanciaMin));
+    const double nsFiltrarLineal = tiempoRealNsSITL() - inicioFiltrarLineal;
+
+    ok &= hash.numPuntos == numLineal && memcmp(hash.puntos, lineal, numLineal * sizeof(lineal[0])) == 0;
+
+    printf("rejilla_hash muestras=%u cubetas=%u candidatas=%u aceptadas=%u filtradas=%u distancia=%.2f "
+           "ns_candidata_hash=%.1f ns_candidata_lineal=%.1f us_filtro_hash=%.1f us_filtro_lineal=%.1f "
+           "mejora_aceptar=%.1f mejora_filtro=%.1f coinciden=%u\n",
+           numMuestras, numCubetas, numCandidatas, aceptadas, numLineal, (double)distanciaMin,
+           nsAceptarHash / numCandidatas, nsAceptarLineal / numCandidatas, nsFiltrarHash * 1e-3, nsFiltrarLineal * 1e-3,
+           nsAceptarHash > 0 ? nsAceptarLineal / nsAceptarHash : 0.0, nsFiltrarHash > 0 ? nsFiltrarLineal / nsFiltrarHash : 0.0, ok);
+
+    free(hash.puntos);
+    free(hash.siguientes);
+    free(hash.cabezas);
+    free(lineal);
+    free(candidatas);
+    return ok;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void generarCandidatasRejillaSITL(float (*candidatas)[3], uint32_t numCandidatas)
+**  Descripcion:    Genera el campo medido mientras la placa gira al azar con el offset y
+**                  el ruido del sensor
+**  Parametros:     Candidatas, numero de candidatas
+**  Retorno:        Ninguno
+****************************************************************************************/
+void generarCandidatasRejillaSITL(float (*candidatas)[3], uint32_t numCandidatas)
+{
+    float direccion[3] = {1.0f, 0.0f, 0.0f};
+
+    semillaRejillaSITL = 12345;
+
+    for (uint32_t n = 0; n < numCandidatas; n++) {
+        float modulo = 0.0f;
+
+        for (uint8_t i = 0; i < 3; i++) {
+            direccion[i] += GIRO_REJILLA_SITL * (2.0f * aleatorioRejillaSITL() - 1.0f);
+            modulo += sq(direccion[i]);
+        }
+
+        modulo = sqrtf(modulo);
+        for (uint8_t i = 0; i < 3; i++) {
+            direccion[i] /= modulo;
+            candidatas[n][i] = RADIO_REJILLA_SITL * direccion[i] + OFFSET_REJILLA_SITL +
+                               RUIDO_REJILLA_SITL * (2.0f * aleatorioRejillaSITL() - 1.0f);
+        }
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool hayVecinoLinealRejillaSITL(float (*puntos)[3], uint32_t numPuntos, const float *punto,
+**                                                  float distanciaMin2, uint32_t indiceIgnorado)
+**  Descripcion:    Busqueda lineal de la version anterior del calibrador
+**  Parametros:     Puntos, numero de puntos, punto, distancia minima al cuadrado, indice a ignorar
+**  Retorno:        True si hay algun punto demasiado cerca
+****************************************************************************************/
+bool hayVecinoLinealRejillaSITL(float (*puntos)[3], uint32_t numPuntos, const float *punto, float distanciaMin2, uint32_t indiceIgnorado)
+{
+    for (uint32_t i = 0; i < numPuntos; i++) {
+        const float dx = punto[0] - puntos[i][0];
+        const float dy = punto[1] - puntos[i][1];
+        const float dz = punto[2] - puntos[i][2];
+
+        if (i != indiceIgnorado && dx * dx + dy * dy + dz * dz < distanciaMin2)
+            return true;
+    }
+
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t filtrarLinealRejillaSITL(float (*puntos)[3], uint32_t numPuntos, float distanciaMin2)
+**  Descripcion:    Filtrado de la version anterior del calibrador
+**  Parametros:     Puntos, numero de puntos, distancia minima al cuadrado
+**  Retorno:        Puntos que quedan
+****************************************************************************************/
+uint32_t filtrarLinealRejillaSITL(float (*puntos)[3], uint32_t numPuntos, float distanciaMin2)
+{
+    for (uint32_t i = 0; i < numPuntos; i++) {
+        if (hayVecinoLinealRejillaSITL(puntos, numPuntos, puntos[i], distanciaMin2, i)) {
+            memcpy(puntos[i], puntos[numPuntos - 1], sizeof(puntos[0]));
+            numPuntos--;
+        }
+    }
+
+    return numPuntos;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t filtrarHashRejillaSITL(conjuntoRejillaSITL_t *conjunto, float distanciaMin)
+**  Descripcion:    Filtrado con la rejilla, como en filtrarMuestrasCalMag
+**  Parametros:     Conjunto de puntos, distancia minima
+**  Retorno:        Puntos que quedan
+****************************************************************************************/
+uint32_t filtrarHashRejillaSITL(conjuntoRejillaSITL_t *conjunto, float distanciaMin)
+{
+    uint32_t numPuntos = conjunto->numPuntos;
+
+    vaciarRejillaHash(&conjunto->rejilla, distanciaMin);
+    for (uint32_t i = 0; i < numPuntos; i++)
+        insertarRejillaHash(&conjunto->rejilla, i);
+
+    for (uint32_t i = 0; i < numPuntos; i++) {
+        const uint32_t ultima = numPuntos - 1;
+
+        if (hayVecinoRejillaHash(&conjunto->rejilla, conjunto->puntos[i], i)) {
+            quitarRejillaHash(&conjunto->rejilla, i);
+            if (i != ultima) {
+                quitarRejillaHash(&conjunto->rejilla, ultima);
+                memcpy(conjunto->puntos[i], conjunto->puntos[ultima], sizeof(conjunto->puntos[0]));
+                insertarRejillaHash(&conjunto->rejilla, i);
+            }
+
+            numPuntos--;
+        }
+    }
+
+    return numPuntos;
+}
+
+
+/***************************************************************************************
+**  Nombre:         float distanciaMinRejillaSITL(uint32_t numMuestras)
+**  Descripcion:    Distancia entre vertices contiguos de un poliedro con tantos vertices
+**                  como muestras, igual que en el calibrador
+**  Parametros:     Numero de muestras
+**  Retorno:        Distancia en mGa
+****************************************************************************************/
+float distanciaMinRejillaSITL(uint32_t numMuestras)
+{
+    const float caras = 2.0f * numMuestras - 4.0f;
+    const float a = (4.0f * PI / (3.0f * caras)) + PI / 3.0f;
+    const float theta = 0.5f * acosf(cosf(a) / (1.0f - cosf(a)));
+
+    return RADIO_REJILLA_SITL * 2.0f * sinf(theta / 2.0f);
+}
+
+
+/***************************************************************************************
+**  Nombre:         float aleatorioRejillaSITL(void)
+**  Descripcion:    Numero pseudoaleatorio reproducible
+**  Parametros:     Ninguno
+**  Retorno:        Valor en [0, 1)
+****************************************************************************************/
+float aleatorioRejillaSITL(void)
+{
+    semillaRejillaSITL = semillaRejillaSITL * 1664525u + 1013904223u;
+    return (semillaRejillaSITL >> 8) * (1.0f / 16777216.0f);
+}
+
+#endif
@@ -0,0 +1,65 @@
+/***************************************************************************************
+**  rejilla_hash_sitl.h - Prueba y medida de la rejilla hash frente a la busqueda lineal
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __REJILLA_HASH_SITL_H
+#define __REJILLA_HASH_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Simula el muestreo del calibrador del magnetometro: el campo recorre la esfera girando
+ * poco a poco y con ruido, y cada muestra se acepta si no hay otra guardada a menos de la
+ * distancia minima para ese numero de muestras. Despues se barajan las muestras y se
+ * filtran con una distancia algo mayor, como en el paso 2 del calibrador. Las dos cosas
+ * se hacen con la rejilla y con la busqueda lineal que habia antes, se comprueba que las
+ * decisiones son las mismas y se mide el tiempo de cada una
+ */
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarRejillaHashSITL(uint32_t numMuestras);
+
+#endif // __REJILLA_HASH_SITL_H
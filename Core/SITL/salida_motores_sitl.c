@@ -0,0 +1,329 @@
+/***************************************************************************************
+**  salida_motores_sitl.c - Timers y DMA simulados de la etapa de salida de los motores
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "salida_motores_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <string.h>
+
+#include "sitl.h"
+#include "Motores/salida_motores.h"
+#include "Drivers/tiempo.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define NUM_MOTORES_SALIDA_SITL          12
+#define NUM_TIMERS_SALIDA_SITL           4
+#define PASO_TIEMPO_SALIDA_SITL_US       125
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    uint32_t arranques;
+    uint8_t canales;                                        // Canales preparados en el ultimo arranque
+    uint32_t burst[TAM_BUFFER_BURST_SALIDA_MOTORES];        // Copia del buffer al arrancar en burst
+} timerSITL_t;
+
+typedef struct {
+    const char *nombre;
+    codificacionSalidaMotores_e codificacion;
+    bool burst;
+} modoSalidaSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+// Timer y canal de cada motor
+static const uint8_t timerMotorSITL[NUM_MOTORES_SALIDA_SITL] = { 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 3, 3 };
+static const uint8_t canalMotorSITL[NUM_MOTORES_SALIDA_SITL] = { 0, 1, 2, 3, 0, 1, 2, 3, 0, 1, 2, 3 };
+
+static const modoSalidaSITL_t modosSalidaSITL[] = {
+    { "dshot_burst",   SALIDA_MOTORES_DSHOT,   true },
+    { "dshot_canal",   SALIDA_MOTORES_DSHOT,   false },
+    { "proshot_canal", SALIDA_MOTORES_PROSHOT, false },
+};
+
+static timerSITL_t timerSITL[NUM_MAX_TIMERS_SALIDA_MOTORES];
+static uint32_t canalSITL[NUM_MAX_MOTORES][TAMANIO_BUFFER_DMA_DSHOT];  // Copia del buffer al arrancar por canal
+static bool capturarSITL;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool configurarSalidaSITL(const modoSalidaSITL_t *modo);
+int32_t decodificarSalidaSITL(const modoSalidaSITL_t *modo, uint8_t motor);
+double medirSalidaSITL(uint32_t ciclos, bool porLotes, uint32_t *arranques);
+uint32_t aleatorioSalidaSITL(uint32_t *semilla);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         void arrancarDMAsalidaMotores(uint8_t indiceTimer, const timerSalidaMotores_t *timer)
+**  Descripcion:    Cuenta el arranque y copia lo que transferiria el DMA
+**  Parametros:     Indice del timer, estado del timer en la etapa de salida
+**  Retorno:        Ninguno
+****************************************************************************************/
+void arrancarDMAsalidaMotores(uint8_t indiceTimer, const timerSalidaMotores_t *timer)
+{
+    timerSITL_t *t = &timerSITL[indiceTimer];
+
+    t->arranques++;
+    t->canales = timer->canalesPreparados;
+
+    if (!capturarSITL)
+        return;
+
+    if (timer->buffer != NULL) {
+        memcpy(t->burst, timer->buffer, timer->longitud * sizeof(uint32_t));
+        return;
+    }
+
+    for (uint8_t i = 0; i < NUM_MOTORES_SALIDA_SITL; i++) {
+        if (timerMotorSITL[i] == indiceTimer && (timer->canalesPreparados & (1 << canalMotorSITL[i])))
+            memcpy(canalSITL[i], bufferSalidaMotor(i), timer->longitud * sizeof(uint32_t));
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool probarSalidaMotoresSITL(uint32_t ciclos)
+**  Descripcion:    Comprueba los paquetes y los arranques de cada modo y mide el coste
+**  Parametros:     Iteraciones del lazo a simular en cada modo
+**  Retorno:        True si todas las comprobaciones son correctas
+****************************************************************************************/
+bool probarSalidaMotoresSITL(uint32_t ciclos)
+{
+    const uint8_t numModos = sizeof(modosSalidaSITL) / sizeof(modosSalidaSITL[0]);
+    uint32_t semilla = 1;
+    uint32_t errores = 0;
+
+    for (uint8_t m = 0; m < numModos; m++) {
+        const modoSalidaSITL_t *modo = &modosSalidaSITL[m];
+        uint32_t erroresModo = 0;
+        uint32_t arranquesExtra = 0;
+
+        if (!configurarSalidaSITL(modo)) {
+            printf("salida_motores modo=%s error=configuracion\n", modo->nombre);
+            errores++;
+            continue;
+        }
+
+        capturarSITL = true;
+        for (uint32_t c = 0; c < ciclos; c++) {
+            uint16_t paquete[NUM_MOTORES_SALIDA_SITL];
+
+            for (uint8_t i = 0; i < NUM_MOTORES_SALIDA_SITL; i++) {
+                const uint16_t valor = aleatorioSalidaSITL(&semilla) & 0x7FF;
+                paquete[i] = prepararPaqueteDshot(valor, aleatorioSalidaSITL(&semilla) & 1, false);
+                prepararSalidaMotor(i, paquete[i]);
+            }
+
+            uint32_t antes[NUM_TIMERS_SALIDA_SITL];
+            for (uint8_t t = 0; t < NUM_TIMERS_SALIDA_SITL; t++)
+                antes[t] = timerSITL[t].arranques;
+
+            avanzarTiempoSITL(PASO_TIEMPO_SALIDA_SITL_US);
+            if (confirmarSalidaMotores() != NUM_TIMERS_SALIDA_SITL)
+                erroresModo++;
+
+            estadisticasSalidaMotores_t estadisticas;
+            estadisticasSalidaMotores(&estadisticas);
+            if (estadisticas.tiempoConfirmacion != micros())
+                erroresModo++;
+
+            // Un arranque por timer con todos sus canales
+            for (uint8_t t = 0; t < NUM_TIMERS_SALIDA_SITL; t++) {
+                const uint8_t esperados = t < 2 ? 0x0F : (t == 2 ? 0x03 : 0x0C);
+                if (timerSITL[t].arranques - antes[t] != 1 || timerSITL[t].canales != esperados)
+                    erroresModo++;
+            }
+
+            for (uint8_t i = 0; i < NUM_MOTORES_SALIDA_SITL; i++) {
+                if (decodificarSalidaSITL(modo, i) != paquete[i])
+                    erroresModo++;
+            }
+
+            // Sin motores preparados no se arranca nada
+            if (confirmarSalidaMotores() != 0)
+                arranquesExtra++;
+        }
+
+        // Escribir solo un motor arranca solo su timer
+        prepararSalidaMotor(9, prepararPaqueteDshot(1000, false, false));
+        if (confirmarSalidaMotores() != 1 || timerSITL[2].canales != 0x02)
+            erroresModo++;
+
+        printf("salida_motores modo=%s ciclos=%u arranques_timer_ciclo=%u errores=%u arranques_sin_datos=%u\n", modo->nombre, ciclos,
+               NUM_TIMERS_SALIDA_SITL, erroresModo, arranquesExtra);
+        errores += erroresModo + arranquesExtra;
+    }
+
+    // Coste por iteracion con la etapa por lotes y enviando tras cada motor
+    if (!configurarSalidaSITL(&modosSalidaSITL[0]))
+        return false;
+
+    capturarSITL = false;
+    uint32_t arranquesLotes, arranquesMotor;
+    const double nsLotes = medirSalidaSITL(ciclos, true, &arranquesLotes);
+    const double nsMotor = medirSalidaSITL(ciclos, false, &arranquesMotor);
+
+    printf("salida_motores medida=lotes ns_ciclo=%.1f arranques_ciclo=%.2f\n", nsLotes, (double)arranquesLotes / ciclos);
+    printf("salida_motores medida=por_motor ns_ciclo=%.1f arranques_ciclo=%.2f\n", nsMotor, (double)arranquesMotor / ciclos);
+
+    return errores == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool configurarSalidaSITL(const modoSalidaSITL_t *modo)
+**  Descripcion:    Inicia la etapa de salida y asigna los motores a los timers simulados
+**  Parametros:     Modo a probar
+**  Retorno:        True si ok
+****************************************************************************************/
+bool configurarSalidaSITL(const modoSalidaSITL_t *modo)
+{
+    memset(timerSITL, 0, sizeof(timerSITL));
+    memset(canalSITL, 0, sizeof(canalSITL));
+    iniciarSalidaMotores(modo->codificacion, modo->burst);
+
+    for (uint8_t i = 0; i < NUM_MOTORES_SALIDA_SITL; i++) {
+        if (!asignarSalidaMotor(i, timerMotorSITL[i], canalMotorSITL[i]))
+            return false;
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         int32_t decodificarSalidaSITL(const modoSalidaSITL_t *modo, uint8_t motor)
+**  Descripcion:    Recupera el paquete de un motor a partir de lo copiado en el arranque
+**  Parametros:     Modo probado, motor
+**  Retorno:        Paquete o -1 si los anchos, el final de trama o el checksum no son validos
+****************************************************************************************/
+int32_t decodificarSalidaSITL(const modoSalidaSITL_t *modo, uint8_t motor)
+{
+    const uint32_t *buffer = modo->burst ? &timerSITL[timerMotorSITL[motor]].burst[canalMotorSITL[motor]] : canalSITL[motor];
+    const uint8_t paso = modo->burst ? NUM_CANALES_TIMER_SALIDA_MOTORES : 1;
+    uint16_t paquete = 0;
+    uint8_t longitud;
+
+    if (modo->codificacion == SALIDA_MOTORES_PROSHOT) {
+        for (uint8_t i = 0; i < 4; i++) {
+            const uint32_t ancho = buffer[i * paso];
+            if (ancho < SIMBOLO_BASE_PROSHOT || (ancho - SIMBOLO_BASE_PROSHOT) % ANCHO_BIT_PROSHOT != 0 ||
+                (ancho - SIMBOLO_BASE_PROSHOT) / ANCHO_BIT_PROSHOT > 0xF)
+                return -1;
+            paquete = (paquete << 4) | ((ancho - SIMBOLO_BASE_PROSHOT) / ANCHO_BIT_PROSHOT);
+        }
+        longitud = TAMANIO_BUFFER_DMA_PROSHOT;
+    }
+    else {
+        for (uint8_t i = 0; i < 16; i++) {
+            const uint32_t ancho = buffer[i * paso];
+            if (ancho != BIT_0_MOTOR && ancho != BIT_1_MOTOR)
+                return -1;
+            paquete = (paquete << 1) | (ancho == BIT_1_MOTOR);
+        }
+        longitud = TAMANIO_BUFFER_DMA_DSHOT;
+    }
+
+    // La trama termina con la salida a 0
+    if (buffer[(longitud - 2) * paso] != 0 || buffer[(longitud - 1) * paso] != 0)
+        return -1;
+
+    const uint16_t dato = paquete >> 4;
+    if (((dato ^ (dato >> 4) ^ (dato >> 8)) & 0xF) != (paquete & 0xF))
+        return -1;
+
+    return paquete;
+}
+
+
+/***************************************************************************************
+**  Nombre:         double medirSalidaSITL(uint32_t ciclos, bool porLotes, uint32_t *arranques)
+**  Descripcion:    Mide el coste de escribir todos los motores en cada iteracion
+**  Parametros:     Iteraciones, true para enviar una vez por iteracion y false para enviar
+**                  tras cada motor, arranques del DMA realizados
+**  Retorno:        ns por iteracion
+****************************************************************************************/
+double medirSalidaSITL(uint32_t ciclos, bool porLotes, uint32_t *arranques)
+{
+    estadisticasSalidaMotores_t inicioEstadisticas, finEstadisticas;
+    double inicio, fin;
+    uint16_t valor = 48;
+
+    estadisticasSalidaMotores(&inicioEstadisticas);
+    inicio = tiempoRealNsSITL();
+
+    for (uint32_t c = 0; c < ciclos; c++) {
+        for (uint8_t i = 0; i < NUM_MOTORES_SALIDA_SITL; i++) {
+            prepararSalidaMotor(i, prepararPaqueteDshot(valor, false, false));
+            if (!porLotes)
+                confirmarSalidaMotores();
+        }
+        confirmarSalidaMotores();
+        valor = valor < 2047 ? valor + 1 : 48;
+    }
+
+    fin = tiempoRealNsSITL();
+    estadisticasSalidaMotores(&finEstadisticas);
+
+    *arranques = finEstadisticas.arranquesDMA - inicioEstadisticas.arranquesDMA;
+    const double s = (fin - inicio) * 1e-9;
+    return ciclos > 0 ? s * 1e9 / ciclos : 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t aleatorioSalidaSITL(uint32_t *semilla)
+**  Descripcion:    Generador xorshift para que la prueba sea reproducible
+**  Parametros:     Estado del generador
+**  Retorno:        Numero aleatorio
+****************************************************************************************/
+uint32_t aleatorioSalidaSITL(uint32_t *semilla)
+{
+    uint32_t x = *semilla;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *semilla = x;
+    return x;
+}
+
+#endif
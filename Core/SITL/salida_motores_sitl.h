@@ -0,0 +1,65 @@
+/***************************************************************************************
+**  salida_motores_sitl.h - Timers y DMA simulados de la etapa de salida de los motores
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __SALIDA_MOTORES_SITL_H
+#define __SALIDA_MOTORES_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Cada arranque del DMA de un timer se cuenta y copia el buffer tal y como lo leeria el
+ * DMA en ese momento. La prueba reparte 12 motores en 4 timers (4, 4, 2 y 2 canales),
+ * escribe valores aleatorios con la etapa por lotes en burst y por canal con DSHOT y
+ * PROSHOT, decodifica los bits capturados y comprueba valor, bit de telemetria,
+ * checksum y que haya un solo arranque por timer. Despues mide el coste por iteracion
+ * frente a enviar tras cada motor como se hacia antes
+ */
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarSalidaMotoresSITL(uint32_t ciclos);
+
+#endif // __SALIDA_MOTORES_SITL_H
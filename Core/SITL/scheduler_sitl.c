@@ -0,0 +1,598 @@
+/***************************************************************************************
+**  scheduler_sitl.c - Comparacion del despacho por vencimiento con el recorrido lineal
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "scheduler_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <string.h>
+
+#include "sitl.h"
+#include "Scheduler/scheduler.h"
+#include "Scheduler/monticulo_tareas.h"
+#include "Comun/matematicas.h"
+#include "Comun/util.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define NUM_NIVELES_SCHEDULER_SITL        (PRIORIDAD_ALTA + 2)    // Como en el scheduler
+#define MUESTREO_CARGA_SCHEDULER_SITL     16                      // Como en el scheduler
+#define LLAMADAS_MEDIDA_SCHEDULER_SITL    16           // Selecciones por medida de tiempo
+#define PASO_MAX_SCHEDULER_SITL           1500         // us de tiempo virtual por ciclo
+#define INICIO_TIEMPO_SCHEDULER_SITL      (UINT32_MAX - 5000000)  // Se pasa por el desbordamiento de micros()
+#define NUM_TIEMPO_REAL_SCHEDULER_SITL    3            // Tareas en tiempo real del despacho
+#define DURACION_MIN_FONDO_SITL           2            // us de ejecucion de las tareas de fondo
+#define DURACION_MAX_FONDO_SITL           40
+#define NUM_CUBETAS_DESPACHO_SITL         256          // Cubetas de 1 us, la ultima satura
+#define US_CICLO_DESPACHO_SITL            10           // us de tiempo virtual simulados por ciclo pedido
+#define NS_MAX_DECISION_SITL              1000         // Por encima el PC ha expulsado al proceso
+#define MICROS_DESPACHO_SITL()            ((uint32_t)(uint64_t)relojDespachoSITL)  // micros() del despacho simulado
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    double nsTotal;
+    double nsMax;
+} medidaSchedulerSITL_t;
+
+typedef struct {
+    uint32_t cubetas[NUM_CUBETAS_DESPACHO_SITL];
+    uint32_t muestras;
+    double total;
+    double max;
+} histogramaDespachoSITL_t;
+
+typedef struct {
+    histogramaDespachoSITL_t latencia;           // Inicio de la tarea en tiempo real menos su vencimiento
+    histogramaDespachoSITL_t jitter;             // Diferencia entre el periodo real y el nominal
+    uint32_t ejecucionesFondo;
+} despachoSchedulerSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static tarea_t tareasSITL[TAREA_CONTADOR];
+static tarea_t *colaSITL[TAREA_CONTADOR];        // Ordenada por prioridad como la del scheduler lineal
+static monticuloTareas_t monticuloTiempoRealSITL;
+static monticuloTareas_t monticulosSITL[NUM_NIVELES_SCHEDULER_SITL];
+static uint8_t mascaraNivelesSITL;
+static uint8_t numTiempoRealSITL;
+
+// Datos del despacho simulado por tarea
+static uint32_t duracionSITL[TAREA_CONTADOR];
+static double inicioAnteriorSITL[TAREA_CONTADOR];
+static double relojDespachoSITL;                 // Tiempo virtual en us
+static double nsCalibracionSITL;                 // Coste de leer el reloj del PC
+
+static const uint8_t prioridadesSITL[] = { PRIORIDAD_BAJA, PRIORIDAD_MEDIA, PRIORIDAD_MEDIA_ALTA, PRIORIDAD_ALTA, PRIORIDAD_MAXIMA };
+static const int32_t periodosSITL[] = { 1000, 2000, 5000, 10000, 20000, 50000, 100000 };
+static const int32_t periodosTiempoRealSITL[NUM_TIEMPO_REAL_SCHEDULER_SITL] = { 125, 500, 1000 };
+static const uint32_t duracionesTiempoRealSITL[NUM_TIEMPO_REAL_SCHEDULER_SITL] = { 20, 10, 8 };
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool compararSeleccionSchedulerSITL(uint32_t numCiclos);
+bool compararDespachoSchedulerSITL(uint32_t numCiclos);
+void iniciarTareasSchedulerSITL(uint32_t *semilla, uint8_t numTiempoReal, uint8_t numPrioridades);
+static inline uint8_t nivelTareaSchedulerSITL(const tarea_t *tarea);
+tarea_t *seleccionarMonticulosSchedulerSITL(uint32_t tiempoActual, uint16_t *tareasEnEspera);
+tarea_t *contarMonticulosSchedulerSITL(uint32_t tiempoActual, uint16_t *tareasEnEspera);
+tarea_t *seleccionarLinealSchedulerSITL(uint32_t tiempoActual, uint16_t *tareasEnEspera);
+double medirSeleccionSchedulerSITL(tarea_t *(*seleccion)(uint32_t, uint16_t *), uint32_t tiempoActual, medidaSchedulerSITL_t *medida);
+void simularDespachoSchedulerSITL(bool monticulos, uint32_t numCiclos, despachoSchedulerSITL_t *despacho);
+void cobrarCosteSchedulerSITL(double *inicioNs);
+void ejecutarTareaSchedulerSITL(tarea_t *tarea, uint32_t vencimiento, despachoSchedulerSITL_t *despacho);
+void anotarHistogramaDespachoSITL(histogramaDespachoSITL_t *histograma, double us);
+double percentilHistogramaDespachoSITL(const histogramaDespachoSITL_t *histograma, float percentil);
+static inline uint32_t aleatorioSchedulerSITL(uint32_t *semilla);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool probarSchedulerSITL(uint32_t numCiclos)
+**  Descripcion:    Compara la seleccion de fondo por monticulos con el recorrido lineal y
+**                  despues el despacho completo de los dos schedulers
+**  Parametros:     Ciclos del scheduler
+**  Retorno:        True si no hay errores
+****************************************************************************************/
+bool probarSchedulerSITL(uint32_t numCiclos)
+{
+    const bool seleccionOk = compararSeleccionSchedulerSITL(numCiclos);
+    const bool despachoOk = compararDespachoSchedulerSITL(numCiclos);
+
+    return seleccionOk && despachoOk;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool compararSeleccionSchedulerSITL(uint32_t numCiclos)
+**  Descripcion:    Elige la tarea de fondo con los monticulos y con el recorrido lineal en
+**                  los mismos instantes, comprueba la seleccion y mide su coste
+**  Parametros:     Ciclos del scheduler
+**  Retorno:        True si no hay errores
+****************************************************************************************/
+bool compararSeleccionSchedulerSITL(uint32_t numCiclos)
+{
+    medidaSchedulerSITL_t medidaMonticulos = { 0 }, medidaCarga = { 0 }, medidaLineal = { 0 };
+    uint32_t semilla = 1, tiempoActual = INICIO_TIEMPO_SCHEDULER_SITL;
+    uint32_t errores = 0, mismaTarea = 0, mismaPrioridad = 0, enEsperaMax = 0;
+    uint64_t enEsperaTotal = 0;
+
+    iniciarTareasSchedulerSITL(&semilla, 0, LONG_ARRAY(prioridadesSITL));
+
+    for (uint32_t i = 0; i < numCiclos; i++) {
+        uint16_t enEsperaMonticulos, enEsperaLineal;
+
+        tiempoActual += 1 + aleatorioSchedulerSITL(&semilla) % PASO_MAX_SCHEDULER_SITL;
+
+        // Las selecciones solo escriben la edad y la prioridad dinamica de las tareas
+        // vencidas, que son las mismas para el mismo tiempo, asi que se pueden repetir
+        medirSeleccionSchedulerSITL(seleccionarMonticulosSchedulerSITL, tiempoActual, &medidaMonticulos);
+        tarea_t *tareaMonticulos = seleccionarMonticulosSchedulerSITL(tiempoActual, &enEsperaMonticulos);
+        medirSeleccionSchedulerSITL(contarMonticulosSchedulerSITL, tiempoActual, &medidaCarga);
+        contarMonticulosSchedulerSITL(tiempoActual, &enEsperaMonticulos);
+
+        medirSeleccionSchedulerSITL(seleccionarLinealSchedulerSITL, tiempoActual, &medidaLineal);
+        tarea_t *tareaLineal = seleccionarLinealSchedulerSITL(tiempoActual, &enEsperaLineal);
+
+        // Debe haber seleccion si y solo si hay tareas vencidas, la elegida debe estar
+        // vencida y ser la primera de su nivel, y la carga debe coincidir
+        if ((tareaMonticulos == NULL) != (tareaLineal == NULL) || enEsperaMonticulos != enEsperaLineal)
+            errores++;
+        else if (tareaMonticulos != NULL &&
+                 ((int32_t)(tiempoActual - VENCIMIENTO_TAREA(tareaMonticulos)) < 0 ||
+                  primeraTareaMonticulo(&monticulosSITL[nivelTareaSchedulerSITL(tareaMonticulos)]) != tareaMonticulos))
+            errores++;
+
+        // Informativo: el recorrido lineal ha calculado la prioridad dinamica de todas las vencidas
+        mismaTarea += tareaMonticulos == tareaLineal;
+        mismaPrioridad += tareaLineal != NULL && tareaMonticulos != NULL &&
+                          tareaMonticulos->prioridadDinamica == tareaLineal->prioridadDinamica;
+        enEsperaTotal += enEsperaLineal;
+        enEsperaMax = MAX(enEsperaMax, enEsperaLineal);
+
+        // Se ejecuta la que eligen los monticulos, igual que el scheduler
+        if (tareaMonticulos != NULL) {
+            tareaMonticulos->ultimoPeriodoEjec = tiempoActual - tareaMonticulos->ultimoTiempoEjec;
+            tareaMonticulos->ultimoTiempoEjec = tiempoActual;
+            tareaMonticulos->prioridadDinamica = 0;
+            reprogramarMonticuloTareas(&monticulosSITL[nivelTareaSchedulerSITL(tareaMonticulos)], tareaMonticulos);
+        }
+    }
+
+    const double ciclos = MAX(numCiclos, 1);
+    printf("scheduler version=monticulos tareas=%u ns_media=%.1f ns_max=%.1f ns_carga=%.1f\n", TAREA_CONTADOR,
+           medidaMonticulos.nsTotal / ciclos, medidaMonticulos.nsMax, medidaCarga.nsTotal / ciclos / MUESTREO_CARGA_SCHEDULER_SITL);
+    printf("scheduler version=lineal tareas=%u ns_media=%.1f ns_max=%.1f\n", TAREA_CONTADOR,
+           medidaLineal.nsTotal / ciclos, medidaLineal.nsMax);
+    printf("scheduler ciclos=%u en_espera_media=%.2f en_espera_max=%u misma_tarea=%u misma_prioridad=%u errores=%u\n",
+           numCiclos, enEsperaTotal / ciclos, enEsperaMax, mismaTarea, mismaPrioridad, errores);
+
+    return errores == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool compararDespachoSchedulerSITL(uint32_t numCiclos)
+**  Descripcion:    Simula el despacho con los dos schedulers sobre las mismas tareas y
+**                  compara la latencia y el jitter de las tareas en tiempo real
+**  Parametros:     Ciclos pedidos, se simulan US_CICLO_DESPACHO_SITL us por ciclo
+**  Retorno:        True si los dos despachan todas las tareas
+****************************************************************************************/
+bool compararDespachoSchedulerSITL(uint32_t numCiclos)
+{
+    static despachoSchedulerSITL_t despachos[2];
+    const char *nombres[] = { "lineal", "monticulos" };
+    bool ok = true;
+
+    // Coste de leer el reloj del PC, que no gasta el micro
+    nsCalibracionSITL = 0;
+    for (uint16_t i = 0; i < 1000; i++) {
+        const double inicio = tiempoRealNsSITL();
+        const double ns = tiempoRealNsSITL() - inicio;
+        nsCalibracionSITL = i == 0 ? ns : MIN(nsCalibracionSITL, ns);
+    }
+
+    for (uint8_t i = 0; i < LONG_ARRAY(despachos); i++) {
+        despachoSchedulerSITL_t *despacho = &despachos[i];
+
+        memset(despacho, 0, sizeof(despachoSchedulerSITL_t));
+        simularDespachoSchedulerSITL(i == 1, numCiclos, despacho);
+
+        printf("scheduler despacho=%s latencia_us_media=%.2f latencia_us_p99=%.0f latencia_us_max=%.1f "
+               "jitter_us_media=%.2f jitter_us_p99=%.0f jitter_us_max=%.1f ejecuciones_rt=%u ejecuciones_fondo=%u\n",
+               nombres[i], despacho->latencia.total / MAX(despacho->latencia.muestras, 1),
+               percentilHistogramaDespachoSITL(&despacho->latencia, 0.99f), despacho->latencia.max,
+               despacho->jitter.total / MAX(despacho->jitter.muestras, 1),
+               percentilHistogramaDespachoSITL(&despacho->jitter, 0.99f), despacho->jitter.max,
+               despacho->latencia.muestras, despacho->ejecucionesFondo);
+
+        ok &= despacho->latencia.muestras > 0 && despacho->ejecucionesFondo > 0;
+    }
+
+    return ok;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void iniciarTareasSchedulerSITL(uint32_t *semilla, uint8_t numTiempoReal,
+**                                                  uint8_t numPrioridades)
+**  Descripcion:    Crea las tareas y las mete en la cola lineal y en los monticulos. Las
+**                  primeras numTiempoReal son en tiempo real y el resto de fondo con una de
+**                  las primeras numPrioridades prioridades
+**  Parametros:     Semilla, tareas en tiempo real, prioridades de fondo a usar
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarTareasSchedulerSITL(uint32_t *semilla, uint8_t numTiempoReal, uint8_t numPrioridades)
+{
+    numTiempoRealSITL = numTiempoReal;
+    mascaraNivelesSITL = 0;
+    iniciarMonticuloTareas(&monticuloTiempoRealSITL);
+    for (uint8_t i = 0; i < NUM_NIVELES_SCHEDULER_SITL; i++)
+        iniciarMonticuloTareas(&monticulosSITL[i]);
+
+    for (uint8_t i = 0; i < TAREA_CONTADOR; i++) {
+        const bool tiempoReal = i < numTiempoReal;
+        const int32_t periodo = tiempoReal ? periodosTiempoRealSITL[i] :
+                                periodosSITL[aleatorioSchedulerSITL(semilla) % LONG_ARRAY(periodosSITL)];
+        const tarea_t tarea = {
+            .nombreTarea = "SITL",
+            .periodo = periodo,
+            .prioridadEstatica = tiempoReal ? PRIORIDAD_TIEMPO_REAL : prioridadesSITL[aleatorioSchedulerSITL(semilla) % numPrioridades],
+            .ultimoTiempoEjec = INICIO_TIEMPO_SCHEDULER_SITL - aleatorioSchedulerSITL(semilla) % periodo,
+        };
+
+        // La prioridad estatica es constante y no se puede asignar
+        memcpy(&tareasSITL[i], &tarea, sizeof(tarea_t));
+        duracionSITL[i] = tiempoReal ? duracionesTiempoRealSITL[i] :
+                          DURACION_MIN_FONDO_SITL + aleatorioSchedulerSITL(semilla) % (DURACION_MAX_FONDO_SITL - DURACION_MIN_FONDO_SITL + 1);
+        inicioAnteriorSITL[i] = -1;
+
+        // Insercion ordenada por prioridad como anadirTareaEnCola del scheduler lineal
+        uint8_t pos = i;
+        while (pos > 0 && colaSITL[pos - 1]->prioridadEstatica < tarea.prioridadEstatica) {
+            colaSITL[pos] = colaSITL[pos - 1];
+            pos--;
+        }
+        colaSITL[pos] = &tareasSITL[i];
+
+        if (tiempoReal)
+            insertarMonticuloTareas(&monticuloTiempoRealSITL, &tareasSITL[i]);
+        else {
+            const uint8_t nivel = nivelTareaSchedulerSITL(&tareasSITL[i]);
+            insertarMonticuloTareas(&monticulosSITL[nivel], &tareasSITL[i]);
+            mascaraNivelesSITL |= BIT(nivel);
+        }
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t nivelTareaSchedulerSITL(const tarea_t *tarea)
+**  Descripcion:    Devuelve el nivel de fondo de una tarea como nivelPrioridadTarea
+**  Parametros:     Tarea
+**  Retorno:        Nivel
+****************************************************************************************/
+static inline uint8_t nivelTareaSchedulerSITL(const tarea_t *tarea)
+{
+    return tarea->prioridadEstatica <= PRIORIDAD_ALTA ? tarea->prioridadEstatica : PRIORIDAD_ALTA + 1;
+}
+
+
+/***************************************************************************************
+**  Nombre:         tarea_t *seleccionarMonticulosSchedulerSITL(uint32_t tiempoActual, uint16_t *tareasEnEspera)
+**  Descripcion:    Seleccion de la tarea de fondo del scheduler por vencimiento
+**  Parametros:     Tiempo actual, tareas en espera (no se calculan)
+**  Retorno:        Tarea seleccionada o NULL
+****************************************************************************************/
+tarea_t *seleccionarMonticulosSchedulerSITL(uint32_t tiempoActual, uint16_t *tareasEnEspera)
+{
+    *tareasEnEspera = 0;
+    return seleccionarFondoMonticulos(monticulosSITL, mascaraNivelesSITL, tiempoActual);
+}
+
+
+/***************************************************************************************
+**  Nombre:         tarea_t *contarMonticulosSchedulerSITL(uint32_t tiempoActual, uint16_t *tareasEnEspera)
+**  Descripcion:    Muestra de carga del scheduler por vencimiento
+**  Parametros:     Tiempo actual, tareas en espera
+**  Retorno:        NULL, solo cuenta
+****************************************************************************************/
+tarea_t *contarMonticulosSchedulerSITL(uint32_t tiempoActual, uint16_t *tareasEnEspera)
+{
+    *tareasEnEspera = 0;
+    for (uint8_t nivel = 0; nivel < NUM_NIVELES_SCHEDULER_SITL; nivel++)
+        *tareasEnEspera += contarTareasVencidasMonticulo(&monticulosSITL[nivel], tiempoActual);
+
+    return NULL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         tarea_t *seleccionarLinealSchedulerSITL(uint32_t tiempoActual, uint16_t *tareasEnEspera)
+**  Descripcion:    Seleccion de la tarea de fondo del scheduler con recorrido lineal
+**  Parametros:     Tiempo actual, tareas en espera
+**  Retorno:        Tarea seleccionada o NULL
+****************************************************************************************/
+tarea_t *seleccionarLinealSchedulerSITL(uint32_t tiempoActual, uint16_t *tareasEnEspera)
+{
+    tarea_t *tareaSeleccionada = NULL;
+    uint16_t prioridadDinamicaTareaSeleccionada = 0;
+
+    *tareasEnEspera = 0;
+    for (uint8_t i = 0; i < TAREA_CONTADOR; i++) {
+        tarea_t *tarea = colaSITL[i];
+        if (tarea->prioridadEstatica == PRIORIDAD_TIEMPO_REAL)
+            continue;
+
+        tarea->edadCiclosTarea = ((tiempoActual - tarea->ultimoTiempoEjec) / tarea->periodo);
+        if (tarea->edadCiclosTarea > 0) {
+            tarea->prioridadDinamica = 1 + tarea->prioridadEstatica * tarea->edadCiclosTarea;
+            (*tareasEnEspera)++;
+        }
+
+        if (tarea->prioridadDinamica > prioridadDinamicaTareaSeleccionada) {
+            prioridadDinamicaTareaSeleccionada = tarea->prioridadDinamica;
+            tareaSeleccionada = tarea;
+        }
+    }
+
+    return tareaSeleccionada;
+}
+
+
+/***************************************************************************************
+**  Nombre:         double medirSeleccionSchedulerSITL(tarea_t *(*seleccion)(uint32_t, uint16_t *),
+**                                                     uint32_t tiempoActual, medidaSchedulerSITL_t *medida)
+**  Descripcion:    Mide el coste de una seleccion como el minimo de varias repeticiones
+**  Parametros:     Seleccion, tiempo actual, medida acumulada
+**  Retorno:        Coste en ns
+****************************************************************************************/
+double medirSeleccionSchedulerSITL(tarea_t *(*seleccion)(uint32_t, uint16_t *), uint32_t tiempoActual, medidaSchedulerSITL_t *medida)
+{
+    double ns = 0;
+
+    for (uint8_t r = 0; r < REPETICIONES_SCHEDULER_SITL; r++) {
+        uint16_t tareasEnEspera;
+        const double inicio = tiempoRealNsSITL();
+
+        for (uint8_t i = 0; i < LLAMADAS_MEDIDA_SCHEDULER_SITL; i++)
+            seleccion(tiempoActual, &tareasEnEspera);
+
+        const double nsLlamada = (tiempoRealNsSITL() - inicio) / LLAMADAS_MEDIDA_SCHEDULER_SITL;
+        ns = r == 0 ? nsLlamada : MIN(ns, nsLlamada);
+    }
+
+    medida->nsTotal += ns;
+    medida->nsMax = MAX(medida->nsMax, ns);
+    return ns;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void simularDespachoSchedulerSITL(bool monticulos, uint32_t numCiclos,
+**                                                    despachoSchedulerSITL_t *despacho)
+**  Descripcion:    Reproduce las llamadas a scheduler() de una de las dos versiones. Las
+**                  tareas avanzan el reloj virtual su duracion y las decisiones del
+**                  scheduler lo que tardan en el PC escaladas por FACTOR_CPU_SITL
+**  Parametros:     True para la version por vencimiento, ciclos pedidos, resultados
+**  Retorno:        Ninguno
+****************************************************************************************/
+void simularDespachoSchedulerSITL(bool monticulos, uint32_t numCiclos, despachoSchedulerSITL_t *despacho)
+{
+    uint32_t semilla = 1;
+
+    iniciarTareasSchedulerSITL(&semilla, NUM_TIEMPO_REAL_SCHEDULER_SITL, LONG_ARRAY(prioridadesSITL) - 1);
+    relojDespachoSITL = INICIO_TIEMPO_SCHEDULER_SITL;
+
+    const double fin = relojDespachoSITL + (double)numCiclos * US_CICLO_DESPACHO_SITL;
+    for (uint32_t ciclo = 0; relojDespachoSITL < fin; ciclo++) {
+        int32_t tiempoHastaEjec = 0x7FFFFFFF;
+        double inicioNs = tiempoRealNsSITL();
+        uint32_t tiempoActual = MICROS_DESPACHO_SITL();
+
+        // Tareas en tiempo real
+        if (monticulos) {
+            tarea_t *tarea = primeraTareaMonticulo(&monticuloTiempoRealSITL);
+            tiempoHastaEjec = VENCIMIENTO_TAREA(tarea) - tiempoActual;
+
+            while ((int32_t)(VENCIMIENTO_TAREA(tarea) - tiempoActual) <= 0) {
+                const uint32_t vencimiento = VENCIMIENTO_TAREA(tarea);
+
+                tarea->ultimoPeriodoEjec = tiempoActual - tarea->ultimoTiempoEjec;
+                tarea->ultimoTiempoEjec = tiempoActual;
+                reprogramarMonticuloTareas(&monticuloTiempoRealSITL, tarea);
+
+                cobrarCosteSchedulerSITL(&inicioNs);
+                ejecutarTareaSchedulerSITL(tarea, vencimiento, despacho);
+                tiempoHastaEjec -= tarea->tiempoMaxEjecucion;
+                tarea = primeraTareaMonticulo(&monticuloTiempoRealSITL);
+            }
+        }
+        else {
+            for (uint8_t i = 0; i < TAREA_CONTADOR && colaSITL[i]->prioridadEstatica == PRIORIDAD_TIEMPO_REAL; i++) {
+                tarea_t *tarea = colaSITL[i];
+                const int32_t tiempoEjec = tarea->ultimoTiempoEjec + tarea->periodo - tiempoActual;
+
+                if (tiempoEjec < tiempoHastaEjec)
+                    tiempoHastaEjec = tiempoEjec;
+
+                if (tiempoEjec <= 0) {
+                    tarea->ultimoPeriodoEjec = tiempoActual - tarea->ultimoTiempoEjec;
+                    tarea->ultimoTiempoEjec = tiempoActual;
+
+                    cobrarCosteSchedulerSITL(&inicioNs);
+                    ejecutarTareaSchedulerSITL(tarea, tiempoActual + tiempoEjec, despacho);
+                    tiempoHastaEjec -= tarea->tiempoMaxEjecucion;
+                }
+            }
+        }
+
+        // Tareas de fondo
+        if (tiempoHastaEjec > INTERVALO_GUARDA_TIEMPO_REAL) {
+            tarea_t *tareaSeleccionada;
+            uint16_t tareasEnEspera;
+
+            cobrarCosteSchedulerSITL(&inicioNs);
+            tiempoActual = MICROS_DESPACHO_SITL();
+
+            if (monticulos) {
+                tareaSeleccionada = seleccionarFondoMonticulos(monticulosSITL, mascaraNivelesSITL, tiempoActual);
+                if ((ciclo % MUESTREO_CARGA_SCHEDULER_SITL) == 0)
+                    contarMonticulosSchedulerSITL(tiempoActual, &tareasEnEspera);
+            }
+            else
+                tareaSeleccionada = seleccionarLinealSchedulerSITL(tiempoActual, &tareasEnEspera);
+
+            if (tareaSeleccionada != NULL) {
+                tareaSeleccionada->ultimoPeriodoEjec = tiempoActual - tareaSeleccionada->ultimoTiempoEjec;
+                tareaSeleccionada->ultimoTiempoEjec = tiempoActual;
+                tareaSeleccionada->prioridadDinamica = 0;
+                if (monticulos)
+                    reprogramarMonticuloTareas(&monticulosSITL[nivelTareaSchedulerSITL(tareaSeleccionada)], tareaSeleccionada);
+
+                cobrarCosteSchedulerSITL(&inicioNs);
+                ejecutarTareaSchedulerSITL(tareaSeleccionada, VENCIMIENTO_TAREA(tareaSeleccionada), despacho);
+            }
+        }
+
+        cobrarCosteSchedulerSITL(&inicioNs);
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void cobrarCosteSchedulerSITL(double *inicioNs)
+**  Descripcion:    Avanza el reloj virtual con lo que ha tardado el scheduler en el PC
+**                  desde inicioNs, sin la lectura del reloj, y reinicia la medida. Se
+**                  limita a NS_MAX_DECISION_SITL para no cobrar las expulsiones del PC
+**  Parametros:     Inicio de la medida en ns
+**  Retorno:        Ninguno
+****************************************************************************************/
+void cobrarCosteSchedulerSITL(double *inicioNs)
+{
+    const double ahoraNs = tiempoRealNsSITL();
+
+    const double ns = MIN(MAX(ahoraNs - *inicioNs - nsCalibracionSITL, 0), NS_MAX_DECISION_SITL);
+
+    relojDespachoSITL += ns * FACTOR_CPU_SITL * 1e-3;
+    *inicioNs = tiempoRealNsSITL();
+}
+
+
+/***************************************************************************************
+**  Nombre:         void ejecutarTareaSchedulerSITL(tarea_t *tarea, uint32_t vencimiento,
+**                                                  despachoSchedulerSITL_t *despacho)
+**  Descripcion:    Ejecuta una tarea simulada. En las de tiempo real anota la latencia
+**                  respecto al vencimiento y el error del periodo
+**  Parametros:     Tarea, vencimiento con el que se ha despachado, resultados
+**  Retorno:        Ninguno
+****************************************************************************************/
+void ejecutarTareaSchedulerSITL(tarea_t *tarea, uint32_t vencimiento, despachoSchedulerSITL_t *despacho)
+{
+    const uint8_t id = tarea - tareasSITL;
+
+    if (id < numTiempoRealSITL) {
+        const double fraccion = relojDespachoSITL - (double)(uint64_t)relojDespachoSITL;
+
+        anotarHistogramaDespachoSITL(&despacho->latencia, (int32_t)(MICROS_DESPACHO_SITL() - vencimiento) + fraccion);
+        if (inicioAnteriorSITL[id] >= 0)
+            anotarHistogramaDespachoSITL(&despacho->jitter, ABS(relojDespachoSITL - inicioAnteriorSITL[id] - tarea->periodo));
+        inicioAnteriorSITL[id] = relojDespachoSITL;
+    }
+    else
+        despacho->ejecucionesFondo++;
+
+    tarea->tiempoMaxEjecucion = duracionSITL[id];
+    relojDespachoSITL += duracionSITL[id];
+}
+
+
+/***************************************************************************************
+**  Nombre:         void anotarHistogramaDespachoSITL(histogramaDespachoSITL_t *histograma, double us)
+**  Descripcion:    Anade una muestra al histograma de cubetas de 1 us
+**  Parametros:     Histograma, muestra en us
+**  Retorno:        Ninguno
+****************************************************************************************/
+void anotarHistogramaDespachoSITL(histogramaDespachoSITL_t *histograma, double us)
+{
+    us = MAX(us, 0);
+    histograma->cubetas[MIN((uint32_t)us, NUM_CUBETAS_DESPACHO_SITL - 1)]++;
+    histograma->muestras++;
+    histograma->total += us;
+    histograma->max = MAX(histograma->max, us);
+}
+
+
+/***************************************************************************************
+**  Nombre:         double percentilHistogramaDespachoSITL(const histogramaDespachoSITL_t *histograma,
+**                                                         float percentil)
+**  Descripcion:    Devuelve el limite superior de la cubeta que contiene el percentil
+**  Parametros:     Histograma, percentil entre 0 y 1
+**  Retorno:        Percentil en us
+****************************************************************************************/
+double percentilHistogramaDespachoSITL(const histogramaDespachoSITL_t *histograma, float percentil)
+{
+    const uint32_t objetivo = (uint32_t)(percentil * histograma->muestras);
+    uint32_t acumulado = 0;
+
+    for (uint16_t i = 0; i < NUM_CUBETAS_DESPACHO_SITL; i++) {
+        acumulado += histograma->cubetas[i];
+        if (acumulado > objetivo)
+            return i + 1;
+    }
+
+    return NUM_CUBETAS_DESPACHO_SITL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t aleatorioSchedulerSITL(uint32_t *semilla)
+**  Descripcion:    Generador xorshift de 32 bits
+**  Parametros:     Semilla
+**  Retorno:        Numero aleatorio
+****************************************************************************************/
+static inline uint32_t aleatorioSchedulerSITL(uint32_t *semilla)
+{
+    *semilla ^= *semilla << 13;
+    *semilla ^= *semilla >> 17;
+    *semilla ^= *semilla << 5;
+    return *semilla;
+}
+
+#endif
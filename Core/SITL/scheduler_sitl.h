@@ -0,0 +1,77 @@
+/***************************************************************************************
+**  scheduler_sitl.h - Comparacion del despacho por vencimiento con el recorrido lineal
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __SCHEDULER_SITL_H
+#define __SCHEDULER_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Primero crea TAREA_CONTADOR tareas de fondo con prioridades y periodos aleatorios y
+ * las despacha con tiempo virtual, avanzando menos de lo que necesitan para que se
+ * acumulen tareas vencidas. En cada ciclo se elige la tarea con los monticulos por nivel
+ * (seleccionarFondoMonticulos, como el scheduler por vencimiento) y con el recorrido
+ * lineal de la cola ordenada por prioridad. Los dos deben elegir tarea en los mismos
+ * ciclos, la de los monticulos debe estar vencida y ser la primera de su nivel, y la
+ * cuenta de tareas en espera debe coincidir. Que elijan la misma tarea o la misma
+ * prioridad dinamica solo se informa, porque los monticulos no redondean la edad.
+ *
+ * Despues simula el despacho completo de las dos versiones con tres tareas en tiempo
+ * real (125, 500 y 1000 us) y tareas de fondo de duracion fija. Las tareas avanzan el
+ * reloj virtual su duracion y las decisiones del scheduler lo que tardan en el PC por
+ * FACTOR_CPU_SITL. Se informa de la latencia de las tareas en tiempo real respecto a su
+ * vencimiento y del error de su periodo (media, p99 y maximo).
+ *
+ * El coste de cada seleccion es el minimo de REPETICIONES_SCHEDULER_SITL repeticiones
+ * identicas para quitar el ruido del PC
+ */
+#define REPETICIONES_SCHEDULER_SITL       8
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarSchedulerSITL(uint32_t numCiclos);
+
+#endif // __SCHEDULER_SITL_H
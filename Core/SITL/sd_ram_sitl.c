@@ -0,0 +1,676 @@
+/***************************************************************************************
+**  sd_ram_sitl.c - Tarjeta SD en memoria con tiempos de una SD real y prueba de
+**                  escritura del blackbox con asyncfatfs
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "sd_ram_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "sitl.h"
+#include "Blackbox/sd.h"
+#include "Blackbox/asyncfatfs/asyncfatfs.h"
+#include "Blackbox/asyncfatfs/fat_standard.h"
+#include "Comun/util.h"
+#include "Comun/matematicas.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define TAM_SECTOR_SD_RAM_SITL            512
+#define NUM_SECTORES_SD_RAM_SITL          72000     // 35 MB, con clusters de un sector sale FAT32
+#define MAX_KILOBYTES_SD_RAM_SITL         32768     // El log tiene que caber en el fichero libre
+#define INICIO_PARTICION_SD_RAM_SITL      64
+#define SECTORES_RESERVADOS_SD_RAM_SITL   32
+#define MAX_BLOQUES_SD_RAM_SITL           128       // Como el driver SDIO
+
+// Tiempos de la tarjeta en us
+#define T_COMANDO_SD_RAM_SITL             50        // Comando y respuesta
+#define T_BLOQUE_SD_RAM_SITL              26        // 512 bytes por el bus de 4 bits a 48 MHz con CRC
+#define T_PROGRAMACION_SD_RAM_SITL        1500      // Ocupada tras cada comando de escritura
+#define T_PROGRAMACION_BLOQUE_SD_RAM_SITL 4
+#define T_ACCESO_LECTURA_SD_RAM_SITL      300
+
+#define PERIODO_BLACKBOX_SD_RAM_SITL      1000      // us entre llamadas de la tarea del blackbox
+#define TRAMA_MIN_SD_RAM_SITL             16
+#define TRAMA_MAX_SD_RAM_SITL             160
+#define TIMEOUT_SD_RAM_SITL               60000000  // us virtuales para montar, abrir o cerrar
+#define SEMILLA_SD_RAM_SITL               0x5D0CA4D1
+#define NOMBRE_LOG_SD_RAM_SITL            "LOG00001.BBL"
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    uint8_t *sector;
+    uint64_t reloj;                               // us virtuales
+    uint64_t finTransmision;                      // Fin de los datos de la operacion pendiente
+    uint64_t libre;                               // Fin de la programacion o acceso de la tarjeta
+    bool pendiente;
+    operacionBloqueSD_e operacion;
+    uint32_t indice;
+    uint8_t *buffer;
+    uint16_t numBloques;
+    callbackOpCompletaSD_c callback;
+    uint32_t datoCallback;
+    uint32_t comandosEscritura;
+    uint32_t bloquesEscritos;
+    uint32_t comandosLectura;
+} sdRAMSITL_t;
+
+typedef struct {
+    uint32_t ofrecidos;
+    uint32_t escritos;
+    uint32_t comandos;
+    uint32_t bloques;
+    uint64_t duracion;                            // us virtuales de la produccion
+    double nsEscrituraMax;
+    double nsEscrituraTotal;
+    uint32_t llamadasEscritura;
+    double nsPollTotal;
+    uint32_t llamadasPoll;
+} resultadoSDRAMSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static sdRAMSITL_t sdRAMSITL;
+static afatfsFilePtr_t ficheroSDRAMSITL;
+static bool ficheroAbiertoSDRAMSITL;
+static bool ficheroCerradoSDRAMSITL;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool formatearSDRAMSITL(void);
+bool iniciarSDRAMSITL(void);
+bool sondearSDRAMSITL(void);
+bool leerBloqueSDRAMSITL(uint32_t indice, uint8_t *buffer, callbackOpCompletaSD_c callback, uint32_t datoCallback);
+estadoOperacionSD_e iniciarEscrituraBloquesSDRAMSITL(uint32_t indice, uint32_t numBloques);
+estadoOperacionSD_e escribirBloqueSDRAMSITL(uint32_t indice, uint8_t *buffer, callbackOpCompletaSD_c callback, uint32_t datoCallback);
+estadoOperacionSD_e escribirBloquesSDRAMSITL(uint32_t indice, uint8_t *buffer, uint16_t numBloques, callbackOpCompletaSD_c callback, uint32_t datoCallback);
+bool escribirLogSDRAMSITL(uint32_t tasa, uint32_t kilobytes, bool stream, resultadoSDRAMSITL_t *resultado);
+bool comprobarLogSDRAMSITL(uint32_t escritos);
+bool montarSDRAMSITL(void);
+bool desmontarSDRAMSITL(void);
+bool esperarSDRAMSITL(bool *condicion);
+void ficheroAbiertoSDRAMSITL_c(afatfsFilePtr_t fichero);
+void ficheroCerradoSDRAMSITL_c(void);
+uint8_t datoLogSDRAMSITL(uint32_t posicion);
+uint32_t aleatorioSDRAMSITL(uint32_t *semilla);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         tablaFnSD_t tablaFnSDRAMSITL
+**  Descripcion:    Tabla de funciones de la SD en memoria
+****************************************************************************************/
+static const tablaFnSD_t tablaFnSDRAMSITL = {
+    iniciarSDRAMSITL,
+    sondearSDRAMSITL,
+    leerBloqueSDRAMSITL,
+    iniciarEscrituraBloquesSDRAMSITL,
+    escribirBloqueSDRAMSITL,
+    escribirBloquesSDRAMSITL,
+    MAX_BLOQUES_SD_RAM_SITL,
+};
+
+
+/***************************************************************************************
+**  Nombre:         bool probarEscrituraSDSITL(const char *datos)
+**  Descripcion:    Escribe el log a cada tasa a traves de la cache de sectores y en modo
+**                  stream, compara la perdida de datos y el coste de la escritura, y
+**                  comprueba cada fichero leyendolo de vuelta
+**  Parametros:     KB del log a cada tasa
+**  Retorno:        True si todos los ficheros se leen bien y el stream no pierde datos
+****************************************************************************************/
+bool probarEscrituraSDSITL(const char *datos)
+{
+    const uint32_t kilobytes = strtoul(datos, NULL, 0);
+    bool ok = kilobytes > 0 && kilobytes <= MAX_KILOBYTES_SD_RAM_SITL;
+
+    if (!ok)
+        fprintf(stderr, "El log tiene que tener entre 1 y %u KB\n", MAX_KILOBYTES_SD_RAM_SITL);
+
+    sdRAMSITL.sector = malloc((size_t)NUM_SECTORES_SD_RAM_SITL * TAM_SECTOR_SD_RAM_SITL);
+    if (sdRAMSITL.sector == NULL || !ok) {
+        free(sdRAMSITL.sector);
+        return false;
+    }
+
+    conectarSDSITL(&tablaFnSDRAMSITL);
+
+    for (uint32_t tasa = TASA_MAX_SD_RAM_SITL / 8; tasa <= TASA_MAX_SD_RAM_SITL && ok; tasa *= 2) {
+        for (uint8_t stream = 0; stream < 2 && ok; stream++) {
+            resultadoSDRAMSITL_t resultado;
+
+            if (!escribirLogSDRAMSITL(tasa, kilobytes, stream, &resultado)) {
+                fprintf(stderr, "No se puede escribir el log a %u KB/s\n", tasa);
+                ok = false;
+                break;
+            }
+
+            const bool leido = comprobarLogSDRAMSITL(resultado.escritos);
+            const uint32_t perdidos = resultado.ofrecidos - resultado.escritos;
+
+            printf("escritura_sd modo=%s tasa_kbs=%u ofrecido=%u escrito=%u perdido_pct=%.2f kbs_reales=%.1f "
+                   "comandos=%u bloques_comando=%.1f fwrite_ns_medio=%.0f fwrite_ns_max=%.0f poll_ns_medio=%.0f leido=%s\n",
+                   stream ? "stream" : "cache", tasa, resultado.ofrecidos, resultado.escritos,
+                   100.0 * perdidos / resultado.ofrecidos, resultado.escritos * 1e6 / 1024.0 / resultado.duracion,
+                   resultado.comandos, (double)resultado.bloques / (resultado.comandos ? resultado.comandos : 1),
+                   resultado.nsEscrituraTotal / resultado.llamadasEscritura, resultado.nsEscrituraMax,
+                   resultado.nsPollTotal / resultado.llamadasPoll, leido ? "si" : "no");
+
+            ok = leido && (!stream || perdidos == 0);
+        }
+    }
+
+    afatfs_setStreamingEnabled(true);
+    conectarSDSITL(NULL);
+    free(sdRAMSITL.sector);
+    sdRAMSITL.sector = NULL;
+
+    return ok;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool escribirLogSDRAMSITL(uint32_t tasa, uint32_t kilobytes, bool stream,
+**                                            resultadoSDRAMSITL_t *resultado)
+**  Descripcion:    Formatea la tarjeta y escribe un log como el blackbox: en cada periodo
+**                  de la tarea escribe las tramas que tocan a la tasa dada y llama una vez
+**                  a afatfs_poll. Al final cierra el fichero y desmonta el volumen
+**  Parametros:     Tasa en KB/s, KB a ofrecer, true para el modo stream, resultado
+**  Retorno:        True si el fichero se ha abierto y cerrado bien
+****************************************************************************************/
+bool escribirLogSDRAMSITL(uint32_t tasa, uint32_t kilobytes, bool stream, resultadoSDRAMSITL_t *resultado)
+{
+    const uint32_t total = kilobytes * 1024;
+    const uint32_t bytesPeriodo = (uint64_t)tasa * 1024 * PERIODO_BLACKBOX_SD_RAM_SITL / 1000000;
+    uint32_t semilla = SEMILLA_SD_RAM_SITL;
+    uint8_t trama[TRAMA_MAX_SD_RAM_SITL];
+
+    memset(resultado, 0, sizeof(resultadoSDRAMSITL_t));
+
+    if (!formatearSDRAMSITL())
+        return false;
+
+    afatfs_setStreamingEnabled(stream);
+    if (!montarSDRAMSITL())
+        return false;
+
+    ficheroAbiertoSDRAMSITL = false;
+    ficheroSDRAMSITL = NULL;
+    if (!afatfs_fopen(NOMBRE_LOG_SD_RAM_SITL, "as", ficheroAbiertoSDRAMSITL_c) || !esperarSDRAMSITL(&ficheroAbiertoSDRAMSITL)
+        || ficheroSDRAMSITL == NULL)
+        return false;
+
+    const uint32_t comandosInicio = sdRAMSITL.comandosEscritura;
+    const uint32_t bloquesInicio = sdRAMSITL.bloquesEscritos;
+    const uint64_t inicio = sdRAMSITL.reloj;
+    uint32_t pendientePeriodo = 0;
+
+    while (resultado->ofrecidos < total) {
+        pendientePeriodo += bytesPeriodo;
+
+        while (pendientePeriodo > 0 && resultado->ofrecidos < total) {
+            uint32_t longitud = TRAMA_MIN_SD_RAM_SITL + aleatorioSDRAMSITL(&semilla) % (TRAMA_MAX_SD_RAM_SITL - TRAMA_MIN_SD_RAM_SITL + 1);
+            longitud = MIN(longitud, MIN(pendientePeriodo, total - resultado->ofrecidos));
+
+            // El contenido depende de la posicion en el fichero para comprobarlo aunque se pierdan tramas
+            for (uint32_t i = 0; i < longitud; i++)
+                trama[i] = datoLogSDRAMSITL(resultado->escritos + i);
+
+            const double t0 = tiempoRealNsSITL();
+            const uint32_t escritos = afatfs_fwrite(ficheroSDRAMSITL, trama, longitud);
+            const double ns = tiempoRealNsSITL() - t0;
+
+            resultado->nsEscrituraTotal += ns;
+            resultado->nsEscrituraMax = ns > resultado->nsEscrituraMax ? ns : resultado->nsEscrituraMax;
+            resultado->llamadasEscritura++;
+            resultado->ofrecidos += longitud;
+            resultado->escritos += escritos;
+            pendientePeriodo -= longitud;
+        }
+
+        const double t0 = tiempoRealNsSITL();
+        afatfs_poll();
+        resultado->nsPollTotal += tiempoRealNsSITL() - t0;
+        resultado->llamadasPoll++;
+
+        sdRAMSITL.reloj += PERIODO_BLACKBOX_SD_RAM_SITL;
+    }
+
+    resultado->duracion = sdRAMSITL.reloj - inicio;
+
+    // Como finalizarLogBlackbox: se insiste hasta que el cierre se pone en marcha
+    const uint64_t limite = sdRAMSITL.reloj + TIMEOUT_SD_RAM_SITL;
+    ficheroCerradoSDRAMSITL = false;
+    while (!afatfs_fclose(ficheroSDRAMSITL, ficheroCerradoSDRAMSITL_c)) {
+        afatfs_poll();
+        sdRAMSITL.reloj += PERIODO_BLACKBOX_SD_RAM_SITL;
+        if (sdRAMSITL.reloj > limite)
+            return false;
+    }
+
+    if (!esperarSDRAMSITL(&ficheroCerradoSDRAMSITL) || !desmontarSDRAMSITL())
+        return false;
+
+    resultado->comandos = sdRAMSITL.comandosEscritura - comandosInicio;
+    resultado->bloques = sdRAMSITL.bloquesEscritos - bloquesInicio;
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool comprobarLogSDRAMSITL(uint32_t escritos)
+**  Descripcion:    Monta de nuevo el volumen y lee el log con asyncfatfs, que sigue la
+**                  cadena de clusters de la FAT, comparando el tamanio y cada byte
+**  Parametros:     Bytes que acepto afatfs_fwrite
+**  Retorno:        True si el fichero coincide
+****************************************************************************************/
+bool comprobarLogSDRAMSITL(uint32_t escritos)
+{
+    uint8_t bloque[TAM_SECTOR_SD_RAM_SITL];
+    uint32_t leidos = 0;
+    bool ok = true;
+
+    if (!montarSDRAMSITL())
+        return false;
+
+    ficheroAbiertoSDRAMSITL = false;
+    ficheroSDRAMSITL = NULL;
+    if (!afatfs_fopen(NOMBRE_LOG_SD_RAM_SITL, "r", ficheroAbiertoSDRAMSITL_c) || !esperarSDRAMSITL(&ficheroAbiertoSDRAMSITL)
+        || ficheroSDRAMSITL == NULL)
+        return false;
+
+    const uint64_t limite = sdRAMSITL.reloj + TIMEOUT_SD_RAM_SITL + (uint64_t)escritos / TAM_SECTOR_SD_RAM_SITL * 10 * T_ACCESO_LECTURA_SD_RAM_SITL;
+    while (ok && !afatfs_feof(ficheroSDRAMSITL) && sdRAMSITL.reloj < limite) {
+        const uint32_t n = afatfs_fread(ficheroSDRAMSITL, bloque, sizeof(bloque));
+
+        for (uint32_t i = 0; i < n && ok; i++)
+            ok = leidos + i < escritos && bloque[i] == datoLogSDRAMSITL(leidos + i);
+
+        leidos += n;
+        afatfs_poll();
+        sdRAMSITL.reloj += T_ACCESO_LECTURA_SD_RAM_SITL;
+    }
+
+    if (leidos != escritos) {
+        fprintf(stderr, "El log tiene %u bytes en vez de %u\n", leidos, escritos);
+        ok = false;
+    }
+
+    ficheroCerradoSDRAMSITL = false;
+    afatfs_fclose(ficheroSDRAMSITL, ficheroCerradoSDRAMSITL_c);
+    return esperarSDRAMSITL(&ficheroCerradoSDRAMSITL) && desmontarSDRAMSITL() && ok;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool montarSDRAMSITL(void)
+**  Descripcion:    Inicia asyncfatfs y espera a que el volumen este listo
+**  Parametros:     Ninguno
+**  Retorno:        True si se ha montado
+****************************************************************************************/
+bool montarSDRAMSITL(void)
+{
+    const uint64_t limite = sdRAMSITL.reloj + TIMEOUT_SD_RAM_SITL;
+
+    afatfs_init();
+
+    while (afatfs_getFilesystemState() != AFATFS_FILESYSTEM_STATE_READY) {
+        if (afatfs_getFilesystemState() == AFATFS_FILESYSTEM_STATE_FATAL || sdRAMSITL.reloj > limite)
+            return false;
+
+        afatfs_poll();
+        sdRAMSITL.reloj += T_COMANDO_SD_RAM_SITL;
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool desmontarSDRAMSITL(void)
+**  Descripcion:    Cierra el volumen escribiendo todo lo pendiente
+**  Parametros:     Ninguno
+**  Retorno:        True si se ha desmontado a tiempo
+****************************************************************************************/
+bool desmontarSDRAMSITL(void)
+{
+    const uint64_t limite = sdRAMSITL.reloj + TIMEOUT_SD_RAM_SITL;
+
+    while (!afatfs_destroy(false)) {
+        if (sdRAMSITL.reloj > limite)
+            return false;
+
+        sdRAMSITL.reloj += T_COMANDO_SD_RAM_SITL;
+    }
+
+    // La ultima escritura se tiene que completar antes de volver a montar
+    while (!sondearSDRAMSITL())
+        sdRAMSITL.reloj += T_COMANDO_SD_RAM_SITL;
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool esperarSDRAMSITL(bool *condicion)
+**  Descripcion:    Llama a afatfs_poll hasta que un callback pone la condicion
+**  Parametros:     Condicion
+**  Retorno:        True si se cumple antes del timeout
+****************************************************************************************/
+bool esperarSDRAMSITL(bool *condicion)
+{
+    const uint64_t limite = sdRAMSITL.reloj + TIMEOUT_SD_RAM_SITL;
+
+    while (!*condicion) {
+        if (sdRAMSITL.reloj > limite)
+            return false;
+
+        afatfs_poll();
+        sdRAMSITL.reloj += T_COMANDO_SD_RAM_SITL;
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void ficheroAbiertoSDRAMSITL_c(afatfsFilePtr_t fichero)
+**  Descripcion:    Callback de afatfs_fopen
+**  Parametros:     Fichero o NULL si no se ha podido abrir
+**  Retorno:        Ninguno
+****************************************************************************************/
+void ficheroAbiertoSDRAMSITL_c(afatfsFilePtr_t fichero)
+{
+    ficheroSDRAMSITL = fichero;
+    ficheroAbiertoSDRAMSITL = true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void ficheroCerradoSDRAMSITL_c(void)
+**  Descripcion:    Callback de afatfs_fclose
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void ficheroCerradoSDRAMSITL_c(void)
+{
+    ficheroCerradoSDRAMSITL = true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool formatearSDRAMSITL(void)
+**  Descripcion:    Borra la tarjeta y crea un MBR con una particion FAT32 de un sector
+**                  por cluster y el directorio raiz vacio en el cluster 2
+**  Parametros:     Ninguno
+**  Retorno:        True si el volumen tiene clusters suficientes para FAT32
+****************************************************************************************/
+bool formatearSDRAMSITL(void)
+{
+    const uint32_t sectoresParticion = NUM_SECTORES_SD_RAM_SITL - INICIO_PARTICION_SD_RAM_SITL;
+    const uint32_t entradasSector = TAM_SECTOR_SD_RAM_SITL / sizeof(uint32_t);
+    uint32_t sectoresFAT = 1;
+
+    // La FAT tiene que tener una entrada por cluster mas las dos reservadas
+    while ((sectoresParticion - SECTORES_RESERVADOS_SD_RAM_SITL - 2 * sectoresFAT) + 2 > sectoresFAT * entradasSector)
+        sectoresFAT++;
+
+    const uint32_t numClusters = sectoresParticion - SECTORES_RESERVADOS_SD_RAM_SITL - 2 * sectoresFAT;
+    if (numClusters <= FAT16_MAX_CLUSTERS)
+        return false;
+
+    uint8_t *disco = sdRAMSITL.sector;
+    memset(&sdRAMSITL, 0, sizeof(sdRAMSITL_t));
+    memset(disco, 0, (size_t)NUM_SECTORES_SD_RAM_SITL * TAM_SECTOR_SD_RAM_SITL);
+    sdRAMSITL.sector = disco;
+
+    // MBR
+    uint8_t *sector = sdRAMSITL.sector;
+    mbrPartitionEntry_t particion = {
+        .type = MBR_PARTITION_TYPE_FAT32_LBA,
+        .lbaBegin = INICIO_PARTICION_SD_RAM_SITL,
+        .numSectors = sectoresParticion,
+    };
+    memcpy(sector + 446, &particion, sizeof(particion));
+    sector[510] = FAT_VOLUME_ID_SIGNATURE_1;
+    sector[511] = FAT_VOLUME_ID_SIGNATURE_2;
+
+    // Sector de arranque del volumen
+    sector = sdRAMSITL.sector + INICIO_PARTICION_SD_RAM_SITL * TAM_SECTOR_SD_RAM_SITL;
+    fatVolumeID_t volumen = {
+        .jmpBoot = {0xEB, 0x58, 0x90},
+        .oemName = "URPILOT ",
+        .bytesPerSector = TAM_SECTOR_SD_RAM_SITL,
+        .sectorsPerCluster = 1,
+        .reservedSectorCount = SECTORES_RESERVADOS_SD_RAM_SITL,
+        .numFATs = 2,
+        .media = 0xF8,
+        .hiddenSectors = INICIO_PARTICION_SD_RAM_SITL,
+        .totalSectors32 = sectoresParticion,
+        .fatDescriptor.fat32 = {
+            .FATSize32 = sectoresFAT,
+            .rootCluster = FAT_SMALLEST_LEGAL_CLUSTER_NUMBER,
+            .fsInfo = 1,
+            .backupBootSector = 6,
+            .driveNumber = 0x80,
+            .bootSignature = 0x29,
+            .volumeID = SEMILLA_SD_RAM_SITL,
+            .volumeLabel = "SITL       ",
+            .fileSystemType = "FAT32   ",
+        },
+    };
+    memcpy(sector, &volumen, sizeof(volumen));
+    sector[510] = FAT_VOLUME_ID_SIGNATURE_1;
+    sector[511] = FAT_VOLUME_ID_SIGNATURE_2;
+
+    // Las dos FAT: entradas reservadas y el directorio raiz, de un cluster
+    const uint32_t primerasEntradas[3] = {0x0FFFFFF8, 0x0FFFFFFF, 0x0FFFFFFF};
+    for (uint8_t i = 0; i < 2; i++) {
+        sector = sdRAMSITL.sector + (INICIO_PARTICION_SD_RAM_SITL + SECTORES_RESERVADOS_SD_RAM_SITL + i * sectoresFAT) * TAM_SECTOR_SD_RAM_SITL;
+        memcpy(sector, primerasEntradas, sizeof(primerasEntradas));
+    }
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool iniciarSDRAMSITL(void)
+**  Descripcion:    La tarjeta en memoria no necesita iniciarse
+**  Parametros:     Ninguno
+**  Retorno:        True
+****************************************************************************************/
+bool iniciarSDRAMSITL(void)
+{
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool sondearSDRAMSITL(void)
+**  Descripcion:    Completa la operacion pendiente si su transmision ha terminado en el
+**                  reloj virtual y llama a su callback
+**  Parametros:     Ninguno
+**  Retorno:        True si la tarjeta esta lista para otra operacion
+****************************************************************************************/
+bool sondearSDRAMSITL(void)
+{
+    sdRAMSITL_t *sd = &sdRAMSITL;
+
+    if (sd->pendiente && sd->reloj >= sd->finTransmision) {
+        uint8_t *disco = sd->sector + (size_t)sd->indice * TAM_SECTOR_SD_RAM_SITL;
+        const size_t bytes = (size_t)sd->numBloques * TAM_SECTOR_SD_RAM_SITL;
+
+        if (sd->operacion == SD_OPERACION_BLOQUE_LEER)
+            memcpy(sd->buffer, disco, bytes);
+        else
+            memcpy(disco, sd->buffer, bytes);
+
+        sd->pendiente = false;
+        if (sd->callback)
+            sd->callback(sd->operacion, sd->indice, sd->buffer, sd->datoCallback);
+    }
+
+    return !sd->pendiente && sd->reloj >= sd->libre;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool leerBloqueSDRAMSITL(uint32_t indice, uint8_t *buffer, callbackOpCompletaSD_c callback,
+**                                           uint32_t datoCallback)
+**  Descripcion:    Empieza la lectura de un bloque
+**  Parametros:     Indice del bloque, buffer, callback, dato del callback
+**  Retorno:        False si la tarjeta esta ocupada o el bloque no existe
+****************************************************************************************/
+bool leerBloqueSDRAMSITL(uint32_t indice, uint8_t *buffer, callbackOpCompletaSD_c callback, uint32_t datoCallback)
+{
+    sdRAMSITL_t *sd = &sdRAMSITL;
+
+    if (sd->pendiente || sd->reloj < sd->libre || indice >= NUM_SECTORES_SD_RAM_SITL)
+        return false;
+
+    sd->pendiente = true;
+    sd->operacion = SD_OPERACION_BLOQUE_LEER;
+    sd->indice = indice;
+    sd->buffer = buffer;
+    sd->numBloques = 1;
+    sd->callback = callback;
+    sd->datoCallback = datoCallback;
+    sd->finTransmision = sd->reloj + T_COMANDO_SD_RAM_SITL + T_ACCESO_LECTURA_SD_RAM_SITL + T_BLOQUE_SD_RAM_SITL;
+    sd->libre = sd->finTransmision;
+    sd->comandosLectura++;
+
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         estadoOperacionSD_e iniciarEscrituraBloquesSDRAMSITL(uint32_t indice, uint32_t numBloques)
+**  Descripcion:    Como el driver SDIO sin cache, solo anota la serie: cada bloque se sigue
+**                  escribiendo con su comando
+**  Parametros:     Indice del primer bloque, numero de bloques
+**  Retorno:        Exito
+****************************************************************************************/
+estadoOperacionSD_e iniciarEscrituraBloquesSDRAMSITL(uint32_t indice, uint32_t numBloques)
+{
+    UNUSED(indice);
+    UNUSED(numBloques);
+    return SD_OPERACION_EXITO;
+}
+
+
+/***************************************************************************************
+**  Nombre:         estadoOperacionSD_e escribirBloqueSDRAMSITL(uint32_t indice, uint8_t *buffer,
+**                                                              callbackOpCompletaSD_c callback, uint32_t datoCallback)
+**  Descripcion:    Escribe un bloque con su propio comando
+**  Parametros:     Indice del bloque, buffer, callback, dato del callback
+**  Retorno:        Estado de la operacion
+****************************************************************************************/
+estadoOperacionSD_e escribirBloqueSDRAMSITL(uint32_t indice, uint8_t *buffer, callbackOpCompletaSD_c callback, uint32_t datoCallback)
+{
+    return escribirBloquesSDRAMSITL(indice, buffer, 1, callback, datoCallback);
+}
+
+
+/***************************************************************************************
+**  Nombre:         estadoOperacionSD_e escribirBloquesSDRAMSITL(uint32_t indice, uint8_t *buffer, uint16_t numBloques,
+**                                                               callbackOpCompletaSD_c callback, uint32_t datoCallback)
+**  Descripcion:    Empieza la escritura de varios bloques con un comando. Los datos se
+**                  copian al disco al terminar la transmision
+**  Parametros:     Indice del primer bloque, buffer, numero de bloques, callback, dato del callback
+**  Retorno:        En progreso, ocupado o fallo si los bloques no existen
+****************************************************************************************/
+estadoOperacionSD_e escribirBloquesSDRAMSITL(uint32_t indice, uint8_t *buffer, uint16_t numBloques, callbackOpCompletaSD_c callback, uint32_t datoCallback)
+{
+    sdRAMSITL_t *sd = &sdRAMSITL;
+
+    if (numBloques == 0 || numBloques > MAX_BLOQUES_SD_RAM_SITL || indice + numBloques > NUM_SECTORES_SD_RAM_SITL)
+        return SD_OPERACION_FALLO;
+
+    if (sd->pendiente || sd->reloj < sd->libre)
+        return SD_OPERACION_OCUPADO;
+
+    sd->pendiente = true;
+    sd->operacion = SD_OPERACION_BLOQUE_ESCRIBIR;
+    sd->indice = indice;
+    sd->buffer = buffer;
+    sd->numBloques = numBloques;
+    sd->callback = callback;
+    sd->datoCallback = datoCallback;
+    sd->finTransmision = sd->reloj + T_COMANDO_SD_RAM_SITL + numBloques * T_BLOQUE_SD_RAM_SITL;
+    sd->libre = sd->finTransmision + T_PROGRAMACION_SD_RAM_SITL + numBloques * T_PROGRAMACION_BLOQUE_SD_RAM_SITL;
+    sd->comandosEscritura++;
+    sd->bloquesEscritos += numBloques;
+
+    return SD_OPERACION_EN_PROGRESO;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t datoLogSDRAMSITL(uint32_t posicion)
+**  Descripcion:    Contenido esperado del log en cada posicion
+**  Parametros:     Posicion en el fichero
+**  Retorno:        Byte
+****************************************************************************************/
+uint8_t datoLogSDRAMSITL(uint32_t posicion)
+{
+    return (uint8_t)(((posicion * 2654435761u) >> 24) ^ (posicion >> 9));
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t aleatorioSDRAMSITL(uint32_t *semilla)
+**  Descripcion:    Generador xorshift32 para que las pruebas sean repetibles
+**  Parametros:     Semilla
+**  Retorno:        Numero aleatorio
+****************************************************************************************/
+uint32_t aleatorioSDRAMSITL(uint32_t *semilla)
+{
+    uint32_t x = *semilla;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *semilla = x;
+    return x;
+}
+
+#endif
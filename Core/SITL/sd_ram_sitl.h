@@ -0,0 +1,75 @@
+/***************************************************************************************
+**  sd_ram_sitl.h - Tarjeta SD en memoria con tiempos de una SD real y prueba de
+**                  escritura del blackbox con asyncfatfs
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __SD_RAM_SITL_H
+#define __SD_RAM_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * La tarjeta es un volumen FAT32 formateado en memoria que se conecta con conectarSDSITL.
+ * Sigue un reloj virtual propio: cada comando de escritura cuesta el envio del comando, la
+ * transmision de sus bloques por el bus SDIO y un tiempo de programacion en el que la
+ * tarjeta esta ocupada, que es casi fijo por comando. Por eso escribir bloque a bloque es
+ * mucho mas lento que escribir tramos largos con un solo comando. Los datos se copian al
+ * disco al terminar la transmision, asi que un buffer que se toque antes de su callback
+ * estropea el fichero.
+ *
+ * La prueba escribe con asyncfatfs un log de los KB indicados a varias tasas, con la
+ * tarea del blackbox a 1 kHz (un afatfs_poll por ms) y tramas de tamanio aleatorio. Se
+ * compara la escritura a traves de la cache de sectores con el modo stream. Al acabar se
+ * cierra el fichero, se desmonta el volumen y se vuelve a leer con asyncfatfs, siguiendo
+ * la cadena de la FAT, para comprobar el tamanio y cada byte. Se exige que el stream no
+ * pierda datos a ninguna tasa y que todos los ficheros se lean bien
+ */
+#define TASA_MAX_SD_RAM_SITL              1024      // KB/s de la tasa mas alta de la prueba
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarEscrituraSDSITL(const char *datos);
+
+#endif // __SD_RAM_SITL_H
@@ -0,0 +1,175 @@
+/***************************************************************************************
+**  sitl.c - Funciones del entorno SITL (Software In The Loop). Permite ejecutar el
+**           nucleo de vuelo en el PC con un reloj virtual y un modelo del vehiculo
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "sitl.h"
+
+#if defined(SITL)
+#include <time.h>
+
+#include "modelo_quad.h"
+#include "spi_sitl.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static uint64_t relojSITL;                   // Tiempo virtual en us
+static uint64_t ultimoPasoModelo;            // Tiempo virtual del ultimo paso del modelo en us
+static bool costeCPUSITL = false;            // El reloj virtual avanza con el tiempo de CPU del PC
+static uint64_t ultimoTiempoCPUSITL;         // Tiempo de CPU del PC ya aplicado en ns
+static double restoCosteCPUSITL;             // Fraccion de us pendiente de aplicar
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+uint64_t tiempoCPUSITL(void);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         void iniciarSITL(uint32_t semilla)
+**  Descripcion:    Reinicia el reloj virtual y el modelo del vehiculo
+**  Parametros:     Semilla del ruido de los sensores
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarSITL(uint32_t semilla)
+{
+    relojSITL = 0;
+    ultimoPasoModelo = 0;
+    costeCPUSITL = false;
+    iniciarModeloQuad(semilla);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void habilitarCosteCPUSITL(void)
+**  Descripcion:    Hace que el reloj virtual avance tambien con el tiempo de CPU del PC,
+**                  escalado por FACTOR_CPU_SITL, para que las tareas tengan duracion
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void habilitarCosteCPUSITL(void)
+{
+    costeCPUSITL = true;
+    restoCosteCPUSITL = 0;
+    ultimoTiempoCPUSITL = tiempoCPUSITL();
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint64_t tiempoSITL(void)
+**  Descripcion:    Devuelve el tiempo virtual sin desbordamiento
+**  Parametros:     Ninguno
+**  Retorno:        Tiempo en us
+****************************************************************************************/
+uint64_t tiempoSITL(void)
+{
+    if (costeCPUSITL) {
+        const uint64_t tiempoCPU = tiempoCPUSITL();
+
+        restoCosteCPUSITL += (tiempoCPU - ultimoTiempoCPUSITL) * FACTOR_CPU_SITL * 1e-3;
+        ultimoTiempoCPUSITL = tiempoCPU;
+
+        const uint64_t coste = (uint64_t)restoCosteCPUSITL;
+        restoCosteCPUSITL -= coste;
+        relojSITL += coste;
+    }
+
+    return relojSITL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void avanzarTiempoSITL(uint32_t us)
+**  Descripcion:    Avanza el reloj virtual, integra el modelo los pasos que hayan vencido y
+**                  termina las transferencias del SPI simulado
+**  Parametros:     Microsegundos a avanzar
+**  Retorno:        Ninguno
+****************************************************************************************/
+void avanzarTiempoSITL(uint32_t us)
+{
+    relojSITL += us;
+
+    while (relojSITL - ultimoPasoModelo >= PERIODO_MODELO_SITL_US) {
+        ultimoPasoModelo += PERIODO_MODELO_SITL_US;
+        actualizarModeloQuad(PERIODO_MODELO_SITL_US);
+    }
+
+    // Las transferencias del SPI simulado que terminan hacen de interrupcion del DMA
+    avanzarSPISITL();
+
+    // El tiempo del modelo y del SPI simulado no lo gasta el micro
+    if (costeCPUSITL)
+        ultimoTiempoCPUSITL = tiempoCPUSITL();
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint64_t tiempoCPUSITL(void)
+**  Descripcion:    Devuelve el tiempo de CPU consumido por el hilo en el PC
+**  Parametros:     Ninguno
+**  Retorno:        Tiempo en ns
+****************************************************************************************/
+uint64_t tiempoCPUSITL(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+
+/***************************************************************************************
+**  Nombre:         double tiempoRealNsSITL(void)
+**  Descripcion:    Devuelve el tiempo monotono del PC para medir lo que tarda el codigo
+**  Parametros:     Ninguno
+**  Retorno:        Tiempo en ns
+****************************************************************************************/
+double tiempoRealNsSITL(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+#endif
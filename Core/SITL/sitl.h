@@ -0,0 +1,94 @@
+/***************************************************************************************
+**  sitl.h - Funciones del entorno SITL (Software In The Loop). Permite ejecutar el
+**           nucleo de vuelo en el PC con un reloj virtual y un modelo del vehiculo
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __SITL_H
+#define __SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+#include "Drivers/bus.h"
+#include "Blackbox/sd.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * La compilacion SITL se activa con los defines SITL y STM32F767xx (los tipos de la HAL
+ * se siguen usando en las cabeceras). Se compilan todos los ficheros de Core excepto
+ * Startup, Sistema/system_stm32f7xx.c, GP/config_flash.c y los drivers del micro
+ * (Core/Drivers salvo tiempo.c y cola_spi.c), junto con las cabeceras de
+ * Drivers/STM32F7xx_HAL_Driver y Drivers/CMSIS. El directorio SITL/CMSIS va el primero en
+ * los includes para que su core_cm7.h sustituya al del micro. Las funciones de los drivers que usan el
+ * resto de modulos se sustituyen en drivers_sitl.c y la transferencia de los puertos SPI
+ * en spi_sitl.c. Los sensores, la radio y los motores se conectan al modelo del
+ * vehiculo (modelo_quad.h) y el tiempo lo marca el reloj virtual, por lo que el bucle
+ * puede ejecutarse mas rapido que el tiempo real.
+ */
+#define PASO_BUCLE_SITL_US            LIMITE_FREC_US_SCHEDULER  // Tiempo virtual consumido por cada llamada al scheduler
+#define PERIODO_MODELO_SITL_US        125                       // Paso de integracion del modelo (8 kHz)
+
+/*
+ * Con el coste de CPU habilitado el reloj virtual avanza tambien lo que tarda el codigo
+ * del firmware en el PC multiplicado por FACTOR_CPU_SITL, una estimacion de cuanto mas
+ * lento es el micro. Asi las tareas tienen duracion y las estadisticas del scheduler
+ * tienen datos, a costa de que la simulacion deje de ser repetible
+ */
+#define FACTOR_CPU_SITL               20.0                      // Veces que el micro es mas lento que el PC
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef void (*capturaUSBSITL_t)(const uint8_t *dato, uint32_t longitud);
+
+// Transferencia de registro por el bus: escribe si datoTx no es NULL y lee si lo es
+typedef bool (*transferenciaBusSITL_t)(const bus_t *bus, uint8_t reg, const uint8_t *datoTx, uint8_t *datoRx, uint8_t longitud);
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void iniciarSITL(uint32_t semilla);
+void habilitarCosteCPUSITL(void);
+uint64_t tiempoSITL(void);
+void avanzarTiempoSITL(uint32_t us);
+double tiempoRealNsSITL(void);
+void conectarUSBSITL(capturaUSBSITL_t captura);
+uint32_t inyectarUSBSITL(const uint8_t *dato, uint32_t longitud);
+void conectarBusSITL(transferenciaBusSITL_t transferencia);
+void conectarSDSITL(const tablaFnSD_t *tabla);
+
+#endif // __SITL_H
@@ -0,0 +1,429 @@
+/***************************************************************************************
+**  spi_sitl.c - Motor SPI simulado para ejecutar la cola de transacciones en SITL
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "spi_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <string.h>
+
+#include "sitl.h"
+#include "Drivers/spi.h"
+#include "Drivers/cola_spi.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define NUM_MAX_DISPOSITIVOS_SPI_SITL      8
+#define NUM_TRANSACCIONES_PRUEBA_SPI_SITL  12      // Transacciones en vuelo durante la prueba
+#define MAX_DATOS_PRUEBA_SPI_SITL          16
+#define TIMEOUT_PRUEBA_SPI_SITL_US         10000000
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    uint8_t numSPI;
+    uint8_t pinCS;
+    bool seleccionado;
+    bool direccionRecibida;
+    uint8_t registro;
+    modeloSPISITL_t modelo;                // NULL para el banco de registros
+} dispositivoSPISITL_t;
+
+typedef struct {
+    bool ocupado;
+    uint8_t *datoTx;
+    uint8_t *datoRx;
+    uint16_t longitud;
+    uint64_t fin;                          // Tiempo virtual en us
+} transferenciaSPISITL_t;
+
+typedef struct {
+    transaccionBus_t transaccion;
+    segmentoBus_t segmentos[2];
+    uint8_t direccion;
+    uint8_t datos[MAX_DATOS_PRUEBA_SPI_SITL];
+    uint32_t secuencia;
+} transaccionPruebaSPISITL_t;
+
+typedef struct {
+    uint32_t siguienteSecuencia[NUM_MAX_SPI];
+    uint32_t secuenciaEsperada[NUM_MAX_SPI];
+    uint32_t pendientes;                   // Transacciones que quedan por encolar
+    uint32_t completadas;
+    uint32_t encadenadas;
+    uint32_t erroresOrden;
+    uint32_t erroresDatos;
+    uint32_t fallos;
+} pruebaSPISITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static dispositivoSPISITL_t dispositivoSPISITL[NUM_MAX_DISPOSITIVOS_SPI_SITL];
+static uint8_t numDispositivosSPISITL;
+static transferenciaSPISITL_t transferenciaSPISITL[NUM_MAX_SPI];
+static uint32_t erroresCSSITL;
+static pruebaSPISITL_t pruebaSPISITL;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void procesarTransferenciaSPISITL(uint8_t numSPI, transferenciaSPISITL_t *transferencia);
+void lanzarPruebaSPISITL(transaccionPruebaSPISITL_t *prueba);
+void callbackPruebaSPISITL(transaccionBus_t *transaccion, bool ok);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool conectarDispositivoSPISITL(uint8_t numSPI, uint8_t pinCS)
+**  Descripcion:    Conecta un dispositivo simulado a un puerto
+**  Parametros:     Puerto SPI, pin del CS
+**  Retorno:        True si ok
+****************************************************************************************/
+bool conectarDispositivoSPISITL(uint8_t numSPI, uint8_t pinCS)
+{
+    return conectarModeloSPISITL(numSPI, pinCS, NULL);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool conectarModeloSPISITL(uint8_t numSPI, uint8_t pinCS, modeloSPISITL_t modelo)
+**  Descripcion:    Conecta un dispositivo simulado que atiende sus propias transferencias
+**  Parametros:     Puerto SPI, pin del CS, modelo del dispositivo
+**  Retorno:        True si ok
+****************************************************************************************/
+bool conectarModeloSPISITL(uint8_t numSPI, uint8_t pinCS, modeloSPISITL_t modelo)
+{
+    if (numDispositivosSPISITL >= NUM_MAX_DISPOSITIVOS_SPI_SITL || numSPI >= NUM_MAX_SPI)
+        return false;
+
+    dispositivoSPISITL_t *dispositivo = &dispositivoSPISITL[numDispositivosSPISITL++];
+
+    dispositivo->numSPI = numSPI;
+    dispositivo->pinCS = pinCS;
+    dispositivo->seleccionado = false;
+    dispositivo->direccionRecibida = false;
+    dispositivo->modelo = modelo;
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t valorRegistroSPISITL(uint8_t pinCS, uint8_t registro)
+**  Descripcion:    Contenido de un registro de los dispositivos simulados
+**  Parametros:     Pin del CS del dispositivo, registro
+**  Retorno:        Valor del registro
+****************************************************************************************/
+uint8_t valorRegistroSPISITL(uint8_t pinCS, uint8_t registro)
+{
+    return (uint8_t)(registro * 29 + pinCS * 7 + 3);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void cambiarPinSPISITL(uint8_t tag, bool estado)
+**  Descripcion:    Sigue los CS de los dispositivos. Al bajar el CS el dispositivo espera
+**                  una direccion nueva
+**  Parametros:     Tag del pin, estado
+**  Retorno:        Ninguno
+****************************************************************************************/
+void cambiarPinSPISITL(uint8_t tag, bool estado)
+{
+    for (uint8_t i = 0; i < numDispositivosSPISITL; i++) {
+        dispositivoSPISITL_t *dispositivo = &dispositivoSPISITL[i];
+
+        if (dispositivo->pinCS != tag)
+            continue;
+
+        if (!estado && !dispositivo->seleccionado)
+            dispositivo->direccionRecibida = false;
+
+        dispositivo->seleccionado = !estado;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool transferirBufferAsincronoSPI(numSPI_e numSPI, uint8_t *datoTx, uint8_t *datoRx,
+**                                                    uint16_t longitud)
+**  Descripcion:    Lanza una transferencia simulada. Termina en avanzarSPISITL
+**  Parametros:     Dispositivo, buffer a enviar, buffer a recibir, longitud
+**  Retorno:        True si se ha lanzado
+****************************************************************************************/
+bool transferirBufferAsincronoSPI(numSPI_e numSPI, uint8_t *datoTx, uint8_t *datoRx, uint16_t longitud)
+{
+    transferenciaSPISITL_t *transferencia = &transferenciaSPISITL[numSPI];
+
+    if (transferencia->ocupado)
+        return false;
+
+    const uint32_t duracion = TIEMPO_ARRANQUE_SPI_SITL_NS + (uint32_t)longitud * TIEMPO_BYTE_SPI_SITL_NS;
+
+    transferencia->datoTx = datoTx;
+    transferencia->datoRx = datoRx;
+    transferencia->longitud = longitud;
+    transferencia->fin = tiempoSITL() + (duracion + 999) / 1000;
+    transferencia->ocupado = true;
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void avanzarSPISITL(void)
+**  Descripcion:    Termina las transferencias que han vencido y avisa a la cola como lo
+**                  haria la interrupcion del DMA
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void avanzarSPISITL(void)
+{
+    for (uint8_t i = 0; i < NUM_MAX_SPI; i++) {
+        transferenciaSPISITL_t *transferencia = &transferenciaSPISITL[i];
+
+        if (!transferencia->ocupado || tiempoSITL() < transferencia->fin)
+            continue;
+
+        transferencia->ocupado = false;
+        procesarTransferenciaSPISITL(i, transferencia);
+        finTransferenciaAsincronaSPI(i, true);
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void procesarTransferenciaSPISITL(uint8_t numSPI, transferenciaSPISITL_t *transferencia)
+**  Descripcion:    Intercambia los bytes con el dispositivo seleccionado del puerto
+**  Parametros:     Puerto, transferencia
+**  Retorno:        Ninguno
+****************************************************************************************/
+void procesarTransferenciaSPISITL(uint8_t numSPI, transferenciaSPISITL_t *transferencia)
+{
+    dispositivoSPISITL_t *dispositivo = NULL;
+    uint8_t seleccionados = 0;
+
+    for (uint8_t i = 0; i < numDispositivosSPISITL; i++) {
+        if (dispositivoSPISITL[i].numSPI == numSPI && dispositivoSPISITL[i].seleccionado) {
+            dispositivo = &dispositivoSPISITL[i];
+            seleccionados++;
+        }
+    }
+
+    // Sin dispositivo o con varios a la vez la linea MISO no es valida
+    if (seleccionados != 1) {
+        erroresCSSITL++;
+        if (transferencia->datoRx != NULL)
+            memset(transferencia->datoRx, 0xFF, transferencia->longitud);
+
+        return;
+    }
+
+    if (dispositivo->modelo != NULL) {
+        dispositivo->modelo(numSPI, transferencia->datoTx, transferencia->datoRx, transferencia->longitud);
+        return;
+    }
+
+    for (uint16_t i = 0; i < transferencia->longitud; i++) {
+        const uint8_t byteTx = transferencia->datoTx != NULL ? transferencia->datoTx[i] : 0xFF;
+        uint8_t byteRx = 0xFF;
+
+        if (!dispositivo->direccionRecibida) {
+            dispositivo->registro = byteTx & 0x7F;
+            dispositivo->direccionRecibida = true;
+        }
+        else
+            byteRx = valorRegistroSPISITL(dispositivo->pinCS, dispositivo->registro++);
+
+        if (transferencia->datoRx != NULL)
+            transferencia->datoRx[i] = byteRx;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t erroresCSspiSITL(void)
+**  Descripcion:    Devuelve las transferencias hechas sin un unico dispositivo seleccionado
+**  Parametros:     Ninguno
+**  Retorno:        Numero de errores
+****************************************************************************************/
+uint32_t erroresCSspiSITL(void)
+{
+    return erroresCSSITL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool probarColaSPISITL(uint32_t numTransacciones)
+**  Descripcion:    Ejecuta lecturas de registros de dos segmentos (direccion y datos con el
+**                  CS bajo) sobre dos dispositivos del SPI1 y uno del SPI2. Comprueba el
+**                  orden de los callbacks, los datos y el CS, y mide la latencia
+**  Parametros:     Numero de transacciones
+**  Retorno:        True si no hay errores
+****************************************************************************************/
+bool probarColaSPISITL(uint32_t numTransacciones)
+{
+    static bus_t buses[] = {
+        { .tipo = BUS_SPI, .bus_u.spi = { SPI_1, 10 } },
+        { .tipo = BUS_SPI, .bus_u.spi = { SPI_1, 11 } },
+        { .tipo = BUS_SPI, .bus_u.spi = { SPI_2, 12 } },
+    };
+    static transaccionPruebaSPISITL_t pruebas[NUM_TRANSACCIONES_PRUEBA_SPI_SITL];
+    const uint8_t numBuses = sizeof(buses) / sizeof(buses[0]);
+    double inicioReal, finReal;
+
+    numDispositivosSPISITL = 0;
+    erroresCSSITL = 0;
+    memset(transferenciaSPISITL, 0, sizeof(transferenciaSPISITL));
+    memset(&pruebaSPISITL, 0, sizeof(pruebaSPISITL));
+    memset(pruebas, 0, sizeof(pruebas));
+    pruebaSPISITL.pendientes = numTransacciones;
+
+    for (uint8_t i = 0; i < numBuses; i++) {
+        conectarDispositivoSPISITL(buses[i].bus_u.spi.numSPI, buses[i].bus_u.spi.pinCS);
+        iniciarColaSPI(buses[i].bus_u.spi.numSPI);
+    }
+
+    for (uint8_t i = 0; i < NUM_TRANSACCIONES_PRUEBA_SPI_SITL; i++) {
+        transaccionPruebaSPISITL_t *prueba = &pruebas[i];
+
+        prueba->transaccion.bus = &buses[i % numBuses];
+        prueba->transaccion.segmentos = prueba->segmentos;
+        prueba->transaccion.numSegmentos = 2;
+        prueba->transaccion.callback = callbackPruebaSPISITL;
+        prueba->transaccion.datoCallback = prueba;
+
+        prueba->segmentos[0].datoTx = &prueba->direccion;
+        prueba->segmentos[0].longitud = 1;
+        prueba->segmentos[1].datoRx = prueba->datos;
+        prueba->segmentos[1].liberarCS = true;
+    }
+
+    inicioReal = tiempoRealNsSITL();
+    const uint64_t inicioVirtual = tiempoSITL();
+
+    while (pruebaSPISITL.completadas < numTransacciones && tiempoSITL() - inicioVirtual < TIMEOUT_PRUEBA_SPI_SITL_US) {
+        for (uint8_t i = 0; i < NUM_TRANSACCIONES_PRUEBA_SPI_SITL && pruebaSPISITL.pendientes > 0; i++) {
+            const estadoTransaccionBus_e estado = pruebas[i].transaccion.estado;
+
+            if (estado != TRANSACCION_BUS_PENDIENTE && estado != TRANSACCION_BUS_EN_CURSO)
+                lanzarPruebaSPISITL(&pruebas[i]);
+        }
+
+        avanzarTiempoSITL(1);
+    }
+
+    finReal = tiempoRealNsSITL();
+    const double nsReal = finReal - inicioReal;
+
+    estadisticasColaSPI_t estadisticas, total;
+    memset(&total, 0, sizeof(total));
+
+    for (uint8_t i = SPI_1; i <= SPI_2; i++) {
+        estadisticasColaSPI(i, &estadisticas);
+        total.numTransacciones += estadisticas.numTransacciones;
+        total.numErrores += estadisticas.numErrores;
+        total.latenciaAcumulada += estadisticas.latenciaAcumulada;
+        if (estadisticas.latenciaMax > total.latenciaMax)
+            total.latenciaMax = estadisticas.latenciaMax;
+    }
+
+    printf("cola_spi transacciones=%u encadenadas=%u errores_orden=%u errores_datos=%u errores_cs=%u fallos=%u "
+           "latencia_media_us=%.2f latencia_max_us=%u tiempo_virtual_us=%llu ns_reales_por_transaccion=%.1f\n",
+           pruebaSPISITL.completadas, pruebaSPISITL.encadenadas, pruebaSPISITL.erroresOrden, pruebaSPISITL.erroresDatos,
+           erroresCSSITL, pruebaSPISITL.fallos + total.numErrores,
+           total.numTransacciones > 0 ? (double)total.latenciaAcumulada / total.numTransacciones : 0.0, total.latenciaMax,
+           (unsigned long long)(tiempoSITL() - inicioVirtual), pruebaSPISITL.completadas > 0 ? nsReal / pruebaSPISITL.completadas : 0.0);
+
+    return pruebaSPISITL.completadas == numTransacciones && pruebaSPISITL.erroresOrden == 0 && pruebaSPISITL.erroresDatos == 0 &&
+           erroresCSSITL == 0 && pruebaSPISITL.fallos == 0 && total.numErrores == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void lanzarPruebaSPISITL(transaccionPruebaSPISITL_t *prueba)
+**  Descripcion:    Numera la transaccion en el orden de su puerto y la encola
+**  Parametros:     Transaccion de prueba
+**  Retorno:        Ninguno
+****************************************************************************************/
+void lanzarPruebaSPISITL(transaccionPruebaSPISITL_t *prueba)
+{
+    const numSPI_e numSPI = prueba->transaccion.bus->bus_u.spi.numSPI;
+
+    prueba->secuencia = pruebaSPISITL.siguienteSecuencia[numSPI]++;
+    prueba->direccion = (uint8_t)((prueba->secuencia * 5) & 0x3F);
+    prueba->segmentos[1].longitud = 1 + prueba->secuencia % MAX_DATOS_PRUEBA_SPI_SITL;
+    pruebaSPISITL.pendientes--;
+
+    if (!encolarTransaccionBus(&prueba->transaccion))
+        pruebaSPISITL.fallos++;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void callbackPruebaSPISITL(transaccionBus_t *transaccion, bool ok)
+**  Descripcion:    Comprueba el orden y los datos. Una de cada cuatro transacciones se
+**                  vuelve a encolar desde el callback, como la rafaga de la FIFO de la IMU
+**  Parametros:     Transaccion, resultado
+**  Retorno:        Ninguno
+****************************************************************************************/
+void callbackPruebaSPISITL(transaccionBus_t *transaccion, bool ok)
+{
+    transaccionPruebaSPISITL_t *prueba = transaccion->datoCallback;
+    const numSPI_e numSPI = transaccion->bus->bus_u.spi.numSPI;
+    const uint8_t pinCS = transaccion->bus->bus_u.spi.pinCS;
+
+    pruebaSPISITL.completadas++;
+    if (!ok)
+        pruebaSPISITL.fallos++;
+
+    if (prueba->secuencia != pruebaSPISITL.secuenciaEsperada[numSPI])
+        pruebaSPISITL.erroresOrden++;
+
+    pruebaSPISITL.secuenciaEsperada[numSPI] = prueba->secuencia + 1;
+
+    for (uint16_t i = 0; i < prueba->segmentos[1].longitud; i++) {
+        if (prueba->datos[i] != valorRegistroSPISITL(pinCS, prueba->direccion + i)) {
+            pruebaSPISITL.erroresDatos++;
+            break;
+        }
+    }
+
+    if ((prueba->secuencia & 3) == 0 && pruebaSPISITL.pendientes > 0) {
+        pruebaSPISITL.encadenadas++;
+        lanzarPruebaSPISITL(prueba);
+    }
+}
+
+#endif
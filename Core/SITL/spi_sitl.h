@@ -0,0 +1,75 @@
+/***************************************************************************************
+**  spi_sitl.h - Motor SPI simulado para ejecutar la cola de transacciones en SITL
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __SPI_SITL_H
+#define __SPI_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Cada puerto hace una transferencia a la vez, que termina cuando el reloj virtual
+ * alcanza el tiempo de los bytes a la velocidad del SPI. Los dispositivos conectados se
+ * modelan como un banco de registros con autoincremento: el primer byte tras bajar el
+ * CS es la direccion y los siguientes devuelven el contenido de los registros. Si el CS
+ * sube a mitad de una transaccion o hay dos dispositivos seleccionados en el puerto las
+ * respuestas dejan de coincidir y se cuenta como error. Un dispositivo con modelo propio
+ * recibe las transferencias enteras en lugar del banco de registros
+ */
+#define TIEMPO_BYTE_SPI_SITL_NS        593     // 13.5 MHz (SPI_RELOJ_RAPIDO)
+#define TIEMPO_ARRANQUE_SPI_SITL_NS    1000    // Arranque del DMA y entrada en la interrupcion
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef void (*modeloSPISITL_t)(uint8_t numSPI, const uint8_t *datoTx, uint8_t *datoRx, uint16_t longitud);
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool conectarDispositivoSPISITL(uint8_t numSPI, uint8_t pinCS);
+bool conectarModeloSPISITL(uint8_t numSPI, uint8_t pinCS, modeloSPISITL_t modelo);
+uint8_t valorRegistroSPISITL(uint8_t pinCS, uint8_t registro);
+void cambiarPinSPISITL(uint8_t tag, bool estado);
+void avanzarSPISITL(void);
+uint32_t erroresCSspiSITL(void);
+bool probarColaSPISITL(uint32_t numTransacciones);
+
+#endif // __SPI_SITL_H
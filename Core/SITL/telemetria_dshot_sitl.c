@@ -0,0 +1,442 @@
+/***************************************************************************************
+**  telemetria_dshot_sitl.c - ESC simulado con respuesta de DSHOT bidireccional
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "telemetria_dshot_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "sitl.h"
+#include "Motores/telemetria_dshot.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define SEMILLA_DSHOT_SITL               0x0D5407E1
+#define US_POR_MINUTO_DSHOT_SITL         60000000
+#define ERPM_MAX_DSHOT_SITL              250000
+#define PERIODO_MAX_DSHOT_SITL           (0x1FF << 7)    // Periodo mas largo que se puede codificar en us
+#define RUIDO_FLANCO_DSHOT_SITL          2               // Ticks maximos de ruido en cada flanco
+#define DESVIO_RELOJ_DSHOT_SITL          0.03f           // Desvio maximo del reloj del ESC
+#define PORCENTAJE_CORRUPTAS_DSHOT_SITL  5
+#define MAX_NO_DETECTADAS_DSHOT_SITL     20              // Por mil de las respuestas corruptas
+#define NUM_RESPUESTAS_MEDIDA_DSHOT_SITL 4096
+#define REPETICIONES_MEDIDA_DSHOT_SITL   64
+#define TAM_LINEA_DSHOT_SITL             512
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    uint32_t respuestas;
+    uint32_t ok;
+    uint32_t resultado[RESPUESTA_DSHOT_ERROR_CRC + 1];
+    uint32_t erroneas;                                      // Validas con una eRPM distinta de la enviada
+    uint32_t corruptas;
+    uint32_t noDetectadas;                                  // Corruptas que pasan como validas con otra eRPM
+} registroDshotSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+// Cuarteto a quinteto GCR
+static const uint8_t quintetoGCRsitl[16] = {
+    0x19, 0x1B, 0x12, 0x13, 0x1D, 0x15, 0x16, 0x17,
+    0x1A, 0x09, 0x0A, 0x0B, 0x1E, 0x0D, 0x0E, 0x0F,
+};
+
+static const char *nombreResultadoDshotSITL[] = { "ok", "sin_respuesta", "longitud", "gcr", "crc" };
+
+static uint32_t semillaVueloDshotSITL = SEMILLA_DSHOT_SITL;
+static uint16_t contadorVueloDshotSITL;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarGeneradasDshotSITL(uint32_t numRespuestas);
+bool probarFicheroDshotSITL(const char *fichero);
+uint16_t codificarErpmDshotSITL(uint32_t erpm);
+uint32_t erpmCodificadaDshotSITL(uint16_t dato);
+uint8_t generarFlancosDshotSITL(uint16_t dato, uint16_t ticksBit, uint16_t origen, float escala, uint32_t *semilla, uint16_t *flancos);
+uint8_t corromperFlancosDshotSITL(uint16_t *flancos, uint8_t numFlancos, uint16_t ticksBit, uint32_t *semilla);
+double medirDecodificacionDshotSITL(uint32_t *semilla);
+uint32_t aleatorioDshotSITL(uint32_t *semilla);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         void responderDshotSITL(uint8_t motor, float frecuencia)
+**  Descripcion:    Respuesta del ESC simulado a una trama. Pasa por el mismo decodificador
+**                  que las capturas del timer
+**  Parametros:     Motor, frecuencia de giro del rotor en Hz
+**  Retorno:        Ninguno
+****************************************************************************************/
+void responderDshotSITL(uint8_t motor, float frecuencia)
+{
+    uint16_t flancos[NUM_MAX_FLANCOS_RESPUESTA_DSHOT];
+    const uint32_t erpm = (uint32_t)(frecuencia * 60.0f * (POLOS_DEFECTO_MOTOR / 2));
+
+    contadorVueloDshotSITL += 997;
+    const uint8_t numFlancos = generarFlancosDshotSITL(codificarErpmDshotSITL(erpm), TICKS_BIT_RESPUESTA_DSHOT,
+                                                       contadorVueloDshotSITL, 1.0f, &semillaVueloDshotSITL, flancos);
+    procesarRespuestaDshot(motor, flancos, numFlancos, TICKS_BIT_RESPUESTA_DSHOT);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool probarTelemetriaDshotSITL(const char *datos)
+**  Descripcion:    Prueba el decodificador con respuestas generadas o capturadas
+**  Parametros:     Fichero con capturas o numero de respuestas a generar
+**  Retorno:        True si todas las respuestas limpias se decodifican bien
+****************************************************************************************/
+bool probarTelemetriaDshotSITL(const char *datos)
+{
+    char *fin;
+    const uint32_t numRespuestas = strtoul(datos, &fin, 0);
+
+    iniciarTelemetriaDshot(POLOS_DEFECTO_MOTOR);
+
+    if (*fin != '\0')
+        return probarFicheroDshotSITL(datos);
+
+    return probarGeneradasDshotSITL(numRespuestas);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool probarGeneradasDshotSITL(uint32_t numRespuestas)
+**  Descripcion:    Decodifica respuestas generadas con ruido, desborde del contador y
+**                  reloj desviado. Una parte se corrompe para comprobar que se detectan
+**  Parametros:     Numero de respuestas
+**  Retorno:        True si ok
+****************************************************************************************/
+bool probarGeneradasDshotSITL(uint32_t numRespuestas)
+{
+    uint32_t semilla = SEMILLA_DSHOT_SITL;
+    registroDshotSITL_t registro;
+    uint16_t flancos[NUM_MAX_FLANCOS_RESPUESTA_DSHOT + 2];
+
+    memset(&registro, 0, sizeof(registro));
+
+    for (uint32_t i = 0; i < numRespuestas; i++) {
+        // Una de cada 16 con el motor parado
+        const uint32_t erpm = (aleatorioDshotSITL(&semilla) & 0xF) == 0 ? 0 : aleatorioDshotSITL(&semilla) % ERPM_MAX_DSHOT_SITL;
+        const uint16_t dato = codificarErpmDshotSITL(erpm);
+        const float escala = 1.0f + DESVIO_RELOJ_DSHOT_SITL * ((int32_t)(aleatorioDshotSITL(&semilla) % 2001) - 1000) / 1000.0f;
+        const uint16_t origen = aleatorioDshotSITL(&semilla);
+        const bool corromper = aleatorioDshotSITL(&semilla) % 100 < PORCENTAJE_CORRUPTAS_DSHOT_SITL;
+
+        uint8_t numFlancos = generarFlancosDshotSITL(dato, TICKS_BIT_RESPUESTA_DSHOT, origen, escala, &semilla, flancos);
+        if (corromper)
+            numFlancos = corromperFlancosDshotSITL(flancos, numFlancos, TICKS_BIT_RESPUESTA_DSHOT, &semilla);
+
+        uint32_t decodificada = 0;
+        const resultadoRespuestaDshot_e resultado = decodificarRespuestaDshot(flancos, numFlancos, TICKS_BIT_RESPUESTA_DSHOT, &decodificada);
+        const bool correcta = resultado == RESPUESTA_DSHOT_OK && decodificada == erpmCodificadaDshotSITL(dato);
+
+        registro.respuestas++;
+        registro.resultado[resultado]++;
+        if (resultado == RESPUESTA_DSHOT_OK)
+            registro.ok++;
+
+        if (corromper) {
+            registro.corruptas++;
+            if (resultado == RESPUESTA_DSHOT_OK && !correcta)
+                registro.noDetectadas++;
+        }
+        else if (!correcta)
+            registro.erroneas++;
+
+        // Publicacion en la telemetria del motor 0
+        publicarErpmDshot(0, resultado, decodificada);
+    }
+
+    printf("telemetria_dshot respuestas=%u ok=%u sin_respuesta=%u longitud=%u gcr=%u crc=%u\n", registro.respuestas, registro.ok,
+           registro.resultado[RESPUESTA_DSHOT_SIN_RESPUESTA], registro.resultado[RESPUESTA_DSHOT_ERROR_LONGITUD],
+           registro.resultado[RESPUESTA_DSHOT_ERROR_GCR], registro.resultado[RESPUESTA_DSHOT_ERROR_CRC]);
+    printf("telemetria_dshot limpias_erroneas=%u corruptas=%u no_detectadas=%u\n", registro.erroneas, registro.corruptas,
+           registro.noDetectadas);
+
+    // La telemetria publicada cuenta lo mismo que el decodificador
+    const telemetriaMotorDshot_t *telemetria = telemetriaMotorDshot(0);
+    float frecuencia = 0;
+    const bool frecuenciaValida = frecuenciaRotorMotor(0, &frecuencia);
+    const bool publicacionOk = telemetria->respuestas == registro.ok &&
+                               telemetria->errores + telemetria->sinRespuesta == registro.respuestas - registro.ok;
+
+    printf("telemetria_dshot publicadas=%u errores=%u sin_respuesta=%u tasa_error=%u frecuencia=%.1f valida=%d\n",
+           telemetria->respuestas, telemetria->errores, telemetria->sinRespuesta, telemetria->tasaError,
+           (double)frecuencia, frecuenciaValida);
+
+    const double ns = medirDecodificacionDshotSITL(&semilla);
+    printf("telemetria_dshot ns_respuesta=%.1f\n", ns);
+
+    return registro.respuestas > 0 && registro.erroneas == 0 && publicacionOk &&
+           registro.noDetectadas * 1000 <= registro.corruptas * MAX_NO_DETECTADAS_DSHOT_SITL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool probarFicheroDshotSITL(const char *fichero)
+**  Descripcion:    Decodifica respuestas capturadas. Cada linea tiene los ticks por bit
+**                  y los tiempos de los flancos separados por comas
+**  Parametros:     Fichero
+**  Retorno:        True si alguna respuesta es valida
+****************************************************************************************/
+bool probarFicheroDshotSITL(const char *fichero)
+{
+    FILE *entrada = fopen(fichero, "r");
+    char linea[TAM_LINEA_DSHOT_SITL];
+    registroDshotSITL_t registro;
+    uint64_t sumaErpm = 0;
+
+    if (entrada == NULL) {
+        fprintf(stderr, "No se puede abrir %s\n", fichero);
+        return false;
+    }
+
+    memset(&registro, 0, sizeof(registro));
+
+    while (fgets(linea, sizeof(linea), entrada) != NULL) {
+        uint16_t flancos[NUM_MAX_FLANCOS_RESPUESTA_DSHOT];
+        uint8_t numFlancos = 0;
+        char *p = linea, *fin;
+
+        if (linea[0] == '#' || linea[0] == '\n' || linea[0] == '\r')
+            continue;
+
+        const uint16_t ticksBit = strtoul(p, &fin, 0);
+        if (fin == p || ticksBit == 0)
+            continue;
+
+        for (p = fin; *p == ','; p = fin) {
+            const uint32_t tiempo = strtoul(p + 1, &fin, 0);
+            if (fin == p + 1 || numFlancos == NUM_MAX_FLANCOS_RESPUESTA_DSHOT)
+                break;
+
+            flancos[numFlancos++] = tiempo;
+        }
+
+        uint32_t erpm = 0;
+        const resultadoRespuestaDshot_e resultado = decodificarRespuestaDshot(flancos, numFlancos, ticksBit, &erpm);
+
+        registro.respuestas++;
+        registro.resultado[resultado]++;
+        if (resultado == RESPUESTA_DSHOT_OK) {
+            registro.ok++;
+            sumaErpm += erpm;
+        }
+    }
+
+    fclose(entrada);
+
+    printf("telemetria_dshot fichero=%s respuestas=%u ok=%u erpm_media=%.0f", fichero, registro.respuestas, registro.ok,
+           registro.ok > 0 ? (double)sumaErpm / registro.ok : 0.0);
+    for (uint8_t i = RESPUESTA_DSHOT_SIN_RESPUESTA; i <= RESPUESTA_DSHOT_ERROR_CRC; i++)
+        printf(" %s=%u", nombreResultadoDshotSITL[i], registro.resultado[i]);
+    printf("\n");
+
+    return registro.ok > 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t codificarErpmDshotSITL(uint32_t erpm)
+**  Descripcion:    Codifica la eRPM como periodo en us con exponente y checksum invertido
+**  Parametros:     eRPM
+**  Retorno:        Dato de 16 bits
+****************************************************************************************/
+uint16_t codificarErpmDshotSITL(uint32_t erpm)
+{
+    uint16_t codificado = 0xFFF;
+
+    if (erpm > 0 && US_POR_MINUTO_DSHOT_SITL / erpm <= PERIODO_MAX_DSHOT_SITL) {
+        uint32_t periodo = (US_POR_MINUTO_DSHOT_SITL + erpm / 2) / erpm;
+        uint8_t exponente = 0;
+
+        while (periodo > 0x1FF) {
+            periodo >>= 1;
+            exponente++;
+        }
+
+        codificado = (exponente << 9) | periodo;
+    }
+
+    const uint8_t crc = ~(codificado ^ (codificado >> 4) ^ (codificado >> 8)) & 0xF;
+    return (codificado << 4) | crc;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t erpmCodificadaDshotSITL(uint16_t dato)
+**  Descripcion:    eRPM que representa un dato una vez cuantizado el periodo
+**  Parametros:     Dato de 16 bits
+**  Retorno:        eRPM
+****************************************************************************************/
+uint32_t erpmCodificadaDshotSITL(uint16_t dato)
+{
+    const uint16_t codificado = dato >> 4;
+
+    if (codificado == 0xFFF)
+        return 0;
+
+    const uint32_t periodo = (uint32_t)(codificado & 0x1FF) << (codificado >> 9);
+    return (US_POR_MINUTO_DSHOT_SITL + periodo / 2) / periodo;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t generarFlancosDshotSITL(uint16_t dato, uint16_t ticksBit, uint16_t origen,
+**                                                  float escala, uint32_t *semilla, uint16_t *flancos)
+**  Descripcion:    Genera los tiempos que captura el timer para una respuesta. Cada 1 del
+**                  bit de arranque y del GCR es un cambio de nivel. Si la linea queda en
+**                  bajo vuelve al reposo algo despues del ultimo bit
+**  Parametros:     Dato, ticks por bit, contador en el arranque, escala del reloj del ESC,
+**                  estado del generador, tiempos generados
+**  Retorno:        Numero de flancos
+****************************************************************************************/
+uint8_t generarFlancosDshotSITL(uint16_t dato, uint16_t ticksBit, uint16_t origen, float escala, uint32_t *semilla, uint16_t *flancos)
+{
+    uint32_t palabra = 1UL << 20;
+    uint8_t numFlancos = 0;
+
+    for (uint8_t i = 0; i < 4; i++)
+        palabra |= (uint32_t)quintetoGCRsitl[(dato >> (4 * i)) & 0xF] << (5 * i);
+
+    for (int8_t bit = NUM_BITS_RESPUESTA_DSHOT - 1; bit >= 0; bit--) {
+        if (!(palabra & (1UL << bit)))
+            continue;
+
+        const int32_t ruido = (int32_t)(aleatorioDshotSITL(semilla) % (2 * RUIDO_FLANCO_DSHOT_SITL + 1)) - RUIDO_FLANCO_DSHOT_SITL;
+        const float tiempo = (NUM_BITS_RESPUESTA_DSHOT - 1 - bit) * ticksBit * escala;
+        flancos[numFlancos++] = (uint16_t)(origen + lrintf(tiempo) + ruido);
+    }
+
+    if (numFlancos & 1) {
+        const float reposo = (NUM_BITS_RESPUESTA_DSHOT + (aleatorioDshotSITL(semilla) % 3)) * ticksBit * escala;
+        flancos[numFlancos++] = (uint16_t)(origen + lrintf(reposo));
+    }
+
+    return numFlancos;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t corromperFlancosDshotSITL(uint16_t *flancos, uint8_t numFlancos,
+**                                                    uint16_t ticksBit, uint32_t *semilla)
+**  Descripcion:    Corrompe una respuesta: sin respuesta, flanco perdido, flanco movido un
+**                  bit o flanco de mas
+**  Parametros:     Tiempos, numero de flancos, ticks por bit, estado del generador
+**  Retorno:        Numero de flancos tras corromper
+****************************************************************************************/
+uint8_t corromperFlancosDshotSITL(uint16_t *flancos, uint8_t numFlancos, uint16_t ticksBit, uint32_t *semilla)
+{
+    const uint8_t posicion = 1 + aleatorioDshotSITL(semilla) % (numFlancos - 1);
+
+    switch (aleatorioDshotSITL(semilla) % 4) {
+        case 0:
+            return 0;
+
+        case 1:
+            memmove(&flancos[posicion], &flancos[posicion + 1], (numFlancos - posicion - 1) * sizeof(uint16_t));
+            return numFlancos - 1;
+
+        case 2:
+            flancos[posicion] += (aleatorioDshotSITL(semilla) & 1) ? ticksBit : -ticksBit;
+            return numFlancos;
+
+        default:
+            memmove(&flancos[posicion + 1], &flancos[posicion], (numFlancos - posicion) * sizeof(uint16_t));
+            flancos[posicion] = flancos[posicion - 1] + ticksBit;
+            return numFlancos + 1;
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         double medirDecodificacionDshotSITL(uint32_t *semilla)
+**  Descripcion:    Mide el coste de decodificar una respuesta
+**  Parametros:     Estado del generador
+**  Retorno:        ns por respuesta
+****************************************************************************************/
+double medirDecodificacionDshotSITL(uint32_t *semilla)
+{
+    static uint16_t flancos[NUM_RESPUESTAS_MEDIDA_DSHOT_SITL][NUM_MAX_FLANCOS_RESPUESTA_DSHOT];
+    static uint8_t numFlancos[NUM_RESPUESTAS_MEDIDA_DSHOT_SITL];
+    double inicio, fin;
+    volatile uint32_t suma = 0;
+
+    for (uint32_t i = 0; i < NUM_RESPUESTAS_MEDIDA_DSHOT_SITL; i++) {
+        const uint16_t dato = codificarErpmDshotSITL(aleatorioDshotSITL(semilla) % ERPM_MAX_DSHOT_SITL);
+        numFlancos[i] = generarFlancosDshotSITL(dato, TICKS_BIT_RESPUESTA_DSHOT, aleatorioDshotSITL(semilla), 1.0f, semilla, flancos[i]);
+    }
+
+    inicio = tiempoRealNsSITL();
+
+    for (uint32_t r = 0; r < REPETICIONES_MEDIDA_DSHOT_SITL; r++) {
+        for (uint32_t i = 0; i < NUM_RESPUESTAS_MEDIDA_DSHOT_SITL; i++) {
+            uint32_t erpm;
+            if (decodificarRespuestaDshot(flancos[i], numFlancos[i], TICKS_BIT_RESPUESTA_DSHOT, &erpm) == RESPUESTA_DSHOT_OK)
+                suma += erpm;
+        }
+    }
+
+    fin = tiempoRealNsSITL();
+
+    const double s = (fin - inicio) * 1e-9;
+    return s * 1e9 / ((double)REPETICIONES_MEDIDA_DSHOT_SITL * NUM_RESPUESTAS_MEDIDA_DSHOT_SITL);
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t aleatorioDshotSITL(uint32_t *semilla)
+**  Descripcion:    Generador xorshift para que la prueba sea reproducible
+**  Parametros:     Estado del generador
+**  Retorno:        Numero aleatorio
+****************************************************************************************/
+uint32_t aleatorioDshotSITL(uint32_t *semilla)
+{
+    uint32_t x = *semilla;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *semilla = x;
+    return x;
+}
+
+#endif
@@ -0,0 +1,71 @@
+/***************************************************************************************
+**  telemetria_dshot_sitl.h - ESC simulado con respuesta de DSHOT bidireccional
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __TELEMETRIA_DSHOT_SITL_H
+#define __TELEMETRIA_DSHOT_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * El ESC simulado codifica la eRPM como lo hace el firmware del ESC (periodo, checksum
+ * invertido, GCR y cambios de nivel) y genera los tiempos que capturaria el timer, con
+ * el contador en una posicion cualquiera para que desborde, ruido en cada flanco y reloj
+ * del ESC desviado. En vuelo responde con la velocidad de los rotores del modelo para que
+ * el controlador tenga la misma fuente de rpm que en el micro.
+ *
+ * La prueba decodifica respuestas generadas y comprueba la eRPM, mete respuestas
+ * corruptas (flancos perdidos, desplazados o de mas y sin respuesta) y cuenta las que
+ * pasan como validas, comprueba la tasa de error publicada y mide el coste por respuesta.
+ * Tambien acepta un fichero con capturas reales, una por linea: ticks por bit y tiempos
+ * de los flancos separados por comas
+ */
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void responderDshotSITL(uint8_t motor, float frecuencia);
+bool probarTelemetriaDshotSITL(const char *datos);
+
+#endif // __TELEMETRIA_DSHOT_SITL_H
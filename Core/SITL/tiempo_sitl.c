@@ -0,0 +1,143 @@
+/***************************************************************************************
+**  tiempo_sitl.c - Funciones de tiempo de SITL. Sustituyen a las de Drivers/tiempo.c y
+**                  se basan en el reloj virtual del simulador
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "Drivers/tiempo.h"
+
+#if defined(SITL)
+#include "sitl.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+volatile uint32_t tiempoSysTick = 0;
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         void iniciarContadorCiclos(void)
+**  Descripcion:    No hace nada. El reloj virtual no necesita calibracion
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarContadorCiclos(void)
+{
+
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t microsISR(void)
+**  Descripcion:    Retorna los microsegundos del reloj virtual
+**  Parametros:     Ninguno
+**  Retorno:        Microsegundos transcurridos
+****************************************************************************************/
+uint32_t microsISR(void)
+{
+    return (uint32_t)tiempoSITL();
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t micros(void)
+**  Descripcion:    Retorna los microsegundos del reloj virtual
+**  Parametros:     Ninguno
+**  Retorno:        Microsegundos transcurridos
+****************************************************************************************/
+uint32_t micros(void)
+{
+    return (uint32_t)tiempoSITL();
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint64_t nanos(void)
+**  Descripcion:    Retorna los nanosegundos del reloj virtual
+**  Parametros:     Ninguno
+**  Retorno:        Nanosegundos transcurridos
+****************************************************************************************/
+uint64_t nanos(void)
+{
+    return tiempoSITL() * 1000;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t millis(void)
+**  Descripcion:    Retorna los milisegundos del reloj virtual
+**  Parametros:     Ninguno
+**  Retorno:        Milisegundos transcurridos
+****************************************************************************************/
+uint32_t millis(void)
+{
+    return (uint32_t)(tiempoSITL() / 1000);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void delayMicroseconds(uint32_t us)
+**  Descripcion:    Avanza el reloj virtual los microsegundos indicados
+**  Parametros:     Microsegundos que se quiere retardar
+**  Retorno:        Ninguno
+****************************************************************************************/
+void delayMicroseconds(uint32_t us)
+{
+    avanzarTiempoSITL(us);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void delay(uint32_t ms)
+**  Descripcion:    Avanza el reloj virtual los milisegundos indicados
+**  Parametros:     Milisegundos que se quiere retardar
+**  Retorno:        Ninguno
+****************************************************************************************/
+void delay(uint32_t ms)
+{
+    avanzarTiempoSITL(ms * 1000);
+}
+
+#endif
@@ -0,0 +1,740 @@
+/***************************************************************************************
+**  trama_radio_sitl.c - Prueba y medida de los decodificadores SBUS e iBUS
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "trama_radio_sitl.h"
+
+#if defined(SITL)
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "sitl.h"
+#include "Radio/trama_radio.h"
+#include "Drivers/tiempo.h"
+#include "Comun/util.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define PERIODO_SBUS_SITL               9000         // us entre tramas de un receptor FrSky
+#define TIEMPO_BYTE_SBUS_SITL           120          // 12 bits a 100000 baudios
+#define PERIODO_IBUS_SITL               7000
+#define TIEMPO_BYTE_IBUS_SITL           87           // 10 bits a 115200 baudios
+
+#define SEPARACION_ANTERIOR_SITL        2000         // us que usaba el ensamblador anterior
+#define PROB_BYTE_PERDIDO_SITL          400          // Uno de cada tantos bytes se pierde
+#define PROB_RUIDO_SITL                 20           // Una de cada tantas separaciones tiene ruido
+#define TRAMAS_HILOS_SITL               2000000
+#define TRAMAS_MEDIDA_SITL              256
+#define REPETICIONES_MEDIDA_SITL        2000
+#define FRACCION_MIN_RECUPERADAS_SITL   0.95         // Tramas publicadas respecto al ensamblador anterior
+#define SEMILLA_RADIO_SITL              0x5B05u
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef estadoTramaRadio_e (*decodificadorAnteriorSITL_f)(const uint8_t *trama, uint16_t *valores);
+typedef void (*generadorTramaSITL_f)(uint8_t *trama);
+
+typedef struct {
+    const char *nombre;
+    uint8_t tamTrama;
+    uint8_t byteInicio;
+    uint8_t numCanales;
+    uint32_t duracionMax;
+    uint32_t periodo;
+    uint32_t tiempoByte;
+    decodificadorTramaRadio_f decodificar;
+    decodificadorAnteriorSITL_f decodificarAnterior;
+    generadorTramaSITL_f generar;
+} protocoloRadioSITL_t;
+
+typedef struct {
+    const protocoloRadioSITL_t *protocolo;
+    uint8_t trama[TAM_MAX_TRAMA_RADIO];
+    estadoTramaRadio_e estado;
+    uint16_t valores[NUM_CANALES_SBUS];
+} referenciaRadioSITL_t;
+
+// Ensamblador que habia antes en los drivers: lee el tiempo en cada byte
+typedef struct {
+    bool tramaRecibida;
+    uint8_t buffer[TAM_MAX_TRAMA_RADIO] __attribute__((aligned(4)));
+    uint32_t trama[TAM_MAX_TRAMA_RADIO / 4];
+    uint8_t offset;
+    uint32_t tiempoAnterior;
+} ensambladorAnteriorSITL_t;
+
+typedef struct {
+    ensambladorRadio_t ensamblador;
+    volatile bool terminado;
+    uint32_t leidas;
+    uint32_t desgarradas;
+    uint32_t desgarradasSinComprobar;
+} pruebaHilosRadioSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static uint32_t semillaRadioSITL;
+static uint8_t tamCopiaRadioSITL;
+
+// Capturas de un receptor FrSky (SBUS) y de uno FlySky (iBUS)
+static const uint8_t tramasSBUSSITL[][TAM_TRAMA_SBUS] = {
+    {0x0F, 0xE0, 0x03, 0x1F, 0x2B, 0xC0, 0x37, 0x71, 0x56, 0x80, 0x0F, 0x7C, 0xE0, 0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E,
+     0xF0, 0x81, 0x0F, 0x7C, 0x00, 0x00},
+    {0x0F, 0xB0, 0x04, 0x19, 0x64, 0x80, 0xCC, 0x8A, 0x89, 0x83, 0x8F, 0x3E, 0xE8, 0xE3, 0x2E, 0xF4, 0xC9, 0x00, 0x80,
+     0xFF, 0x03, 0xF0, 0x7F, 0x00, 0x00},
+    {0x0F, 0xE0, 0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0xE0, 0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E,
+     0xF0, 0x81, 0x0F, 0x7C, 0x04, 0x00},                                  // Trama perdida
+    {0x0F, 0xE0, 0x03, 0x1F, 0x2B, 0xC0, 0x07, 0x3E, 0xF0, 0x81, 0x0F, 0x7C, 0xE0, 0x03, 0x1F, 0xF8, 0xC0, 0x07, 0x3E,
+     0xF0, 0x81, 0x0F, 0x7C, 0x0C, 0x00},                                  // Failsafe
+};
+
+static const uint16_t valoresSBUSSITL[][NUM_CANALES_SBUS] = {
+    {1484, 1484, 1083, 1484, 1884, 1083, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484},
+    {1585, 1390, 1195, 1781, 1083, 1884, 1484, 1244, 1488, 1732, 1976, 1048, 1000, 1999, 1500, 1499},
+    {1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484},
+    {1484, 1484, 1083, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484, 1484},
+};
+
+static const estadoTramaRadio_e estadosSBUSSITL[] = {TRAMA_RADIO_OK, TRAMA_RADIO_OK, TRAMA_RADIO_PERDIDA, TRAMA_RADIO_FAILSAFE};
+
+static const uint8_t tramasIBUSSITL[][TAM_TRAMA_IBUS] = {
+    {0x20, 0x40, 0xDC, 0x05, 0xDC, 0x05, 0xE8, 0x03, 0xDC, 0x05, 0xD0, 0x07, 0xE8, 0x03, 0xDC, 0x05, 0xDC, 0x05, 0xDC,
+     0x05, 0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05, 0x47, 0xF3},
+    {0x20, 0x40, 0xD2, 0x04, 0xE6, 0x06, 0xE8, 0x03, 0xCF, 0x07, 0xE8, 0x03, 0xD0, 0x07, 0xDC, 0x05, 0xDC, 0x05, 0x4C,
+     0x04, 0x6C, 0x07, 0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05, 0xDC, 0x05, 0x51, 0xF4},
+};
+
+static const uint16_t valoresIBUSSITL[][NUM_CANALES_IBUS] = {
+    {1500, 1500, 1000, 1500, 2000, 1000, 1500, 1500, 1500, 1500, 1500, 1500, 1500, 1500},
+    {1234, 1766, 1000, 1999, 1000, 2000, 1500, 1500, 1100, 1900, 1500, 1500, 1500, 1500},
+};
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+uint32_t aleatorioRadioSITL(void);
+void generarTramaSBUSSITL(uint8_t *trama);
+void generarTramaIBUSSITL(uint8_t *trama);
+void cerrarTramaIBUSSITL(uint8_t *trama);
+estadoTramaRadio_e copiarTramaRadioSITL(const uint8_t *trama, uint16_t *valores);
+
+estadoTramaRadio_e decodificarAnteriorSBUSSITL(const uint8_t *trama, uint16_t *valores);
+estadoTramaRadio_e decodificarAnteriorIBUSSITL(const uint8_t *trama, uint16_t *valores);
+void procesarByteAnteriorSITL(ensambladorAnteriorSITL_t *anterior, const protocoloRadioSITL_t *protocolo, uint8_t dato);
+
+bool probarReferenciasRadioSITL(void);
+bool compararDecodificadoresRadioSITL(const protocoloRadioSITL_t *protocolo, uint32_t numTramas);
+bool probarFlujoRadioSITL(const protocoloRadioSITL_t *protocolo, uint32_t numTramas);
+bool probarHilosRadioSITL(void);
+void *productorRadioSITL(void *arg);
+void medirRadioSITL(const protocoloRadioSITL_t *protocolo);
+
+static const protocoloRadioSITL_t protocolosRadioSITL[] = {
+    {"sbus", TAM_TRAMA_SBUS, INICIO_TRAMA_SBUS, NUM_CANALES_SBUS, DURACION_MAX_TRAMA_SBUS, PERIODO_SBUS_SITL,
+     TIEMPO_BYTE_SBUS_SITL, decodificarTramaSBUS, decodificarAnteriorSBUSSITL, generarTramaSBUSSITL},
+    {"ibus", TAM_TRAMA_IBUS, INICIO_TRAMA_IBUS, NUM_CANALES_IBUS, DURACION_MAX_TRAMA_IBUS, PERIODO_IBUS_SITL,
+     TIEMPO_BYTE_IBUS_SITL, decodificarTramaIBUS, decodificarAnteriorIBUSSITL, generarTramaIBUSSITL},
+};
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool probarTramaRadioSITL(uint32_t numTramas)
+**  Descripcion:    Prueba los decodificadores y el ensamblador de SBUS e iBUS y los mide
+**  Parametros:     Tramas aleatorias y del flujo por protocolo
+**  Retorno:        True si todo coincide y no se publica ninguna trama corrupta
+****************************************************************************************/
+bool probarTramaRadioSITL(uint32_t numTramas)
+{
+    bool ok = probarReferenciasRadioSITL();
+
+    semillaRadioSITL = SEMILLA_RADIO_SITL;
+
+    for (uint8_t i = 0; i < LONG_ARRAY(protocolosRadioSITL); i++) {
+        ok &= compararDecodificadoresRadioSITL(&protocolosRadioSITL[i], numTramas);
+        ok &= probarFlujoRadioSITL(&protocolosRadioSITL[i], numTramas);
+    }
+
+    ok &= probarHilosRadioSITL();
+
+    for (uint8_t i = 0; i < LONG_ARRAY(protocolosRadioSITL); i++)
+        medirRadioSITL(&protocolosRadioSITL[i]);
+
+    return ok;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t aleatorioRadioSITL(void)
+**  Descripcion:    Generador congruencial para que la prueba sea repetible
+**  Parametros:     Ninguno
+**  Retorno:        Numero pseudoaleatorio de 31 bits
+****************************************************************************************/
+uint32_t aleatorioRadioSITL(void)
+{
+    semillaRadioSITL = semillaRadioSITL * 1103515245u + 12345u;
+    return semillaRadioSITL >> 1;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void generarTramaSBUSSITL(uint8_t *trama)
+**  Descripcion:    Genera una trama SBUS con canales y flags aleatorios
+**  Parametros:     Trama
+**  Retorno:        Ninguno
+****************************************************************************************/
+void generarTramaSBUSSITL(uint8_t *trama)
+{
+    trama[0] = INICIO_TRAMA_SBUS;
+
+    for (uint8_t i = 1; i < TAM_TRAMA_SBUS - 2; i++)
+        trama[i] = aleatorioRadioSITL() >> 7;
+
+    trama[TAM_TRAMA_SBUS - 2] = (aleatorioRadioSITL() % 4) << 2;
+    trama[TAM_TRAMA_SBUS - 1] = 0x00;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void generarTramaIBUSSITL(uint8_t *trama)
+**  Descripcion:    Genera una trama iBUS con canales aleatorios. Algunas tienen el
+**                  failsafe y otras el checksum mal
+**  Parametros:     Trama
+**  Retorno:        Ninguno
+****************************************************************************************/
+void generarTramaIBUSSITL(uint8_t *trama)
+{
+    trama[0] = INICIO_TRAMA_IBUS;
+    trama[1] = 0x40;
+
+    for (uint8_t i = 0; i < NUM_CANALES_IBUS; i++) {
+        const uint16_t valor = 1000 + aleatorioRadioSITL() % 1001;
+
+        trama[2 + 2 * i] = valor & 0xFF;
+        trama[3 + 2 * i] = valor >> 8;
+    }
+
+    if (aleatorioRadioSITL() % 8 == 0)
+        trama[3] |= 0x40;
+
+    cerrarTramaIBUSSITL(trama);
+
+    if (aleatorioRadioSITL() % 8 == 0)
+        trama[TAM_TRAMA_IBUS - 1] ^= 1 << (aleatorioRadioSITL() % 8);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void cerrarTramaIBUSSITL(uint8_t *trama)
+**  Descripcion:    Calcula el checksum de una trama iBUS
+**  Parametros:     Trama
+**  Retorno:        Ninguno
+****************************************************************************************/
+void cerrarTramaIBUSSITL(uint8_t *trama)
+{
+    uint16_t checksum = 0xFFFF;
+
+    for (uint8_t i = 0; i < TAM_TRAMA_IBUS - 2; i++)
+        checksum -= trama[i];
+
+    trama[TAM_TRAMA_IBUS - 2] = checksum & 0xFF;
+    trama[TAM_TRAMA_IBUS - 1] = checksum >> 8;
+}
+
+
+/***************************************************************************************
+**  Nombre:         estadoTramaRadio_e copiarTramaRadioSITL(const uint8_t *trama, uint16_t *valores)
+**  Descripcion:    Decodificador que devuelve los bytes de la trama tal cual
+**  Parametros:     Trama, destino de al menos TAM_MAX_TRAMA_RADIO bytes
+**  Retorno:        TRAMA_RADIO_OK
+****************************************************************************************/
+estadoTramaRadio_e copiarTramaRadioSITL(const uint8_t *trama, uint16_t *valores)
+{
+    memcpy(valores, trama, tamCopiaRadioSITL);
+    return TRAMA_RADIO_OK;
+}
+
+
+/***************************************************************************************
+**  Nombre:         estadoTramaRadio_e decodificarAnteriorSBUSSITL(const uint8_t *trama, uint16_t *valores)
+**  Descripcion:    Decodificador SBUS anterior, bit a bit con la matriz de decodificacion
+**  Parametros:     Trama, valores
+**  Retorno:        Estado de la trama
+****************************************************************************************/
+estadoTramaRadio_e decodificarAnteriorSBUSSITL(const uint8_t *trama, uint16_t *valores)
+{
+    static const uint8_t decodificador[NUM_CANALES_SBUS][3][4] = {
+        { { 0, 0, 0xFF, 0}, { 1, 0, 0x07, 8}, { 0, 0, 0x00,  0} },
+        { { 1, 3, 0x1F, 0}, { 2, 0, 0x3F, 5}, { 0, 0, 0x00,  0} },
+        { { 2, 6, 0x03, 0}, { 3, 0, 0xFF, 2}, { 4, 0, 0x01, 10} },
+        { { 4, 1, 0x7F, 0}, { 5, 0, 0x0F, 7}, { 0, 0, 0x00,  0} },
+        { { 5, 4, 0x0F, 0}, { 6, 0, 0x7F, 4}, { 0, 0, 0x00,  0} },
+        { { 6, 7, 0x01, 0}, { 7, 0, 0xFF, 1}, { 8, 0, 0x03,  9} },
+        { { 8, 2, 0x3F, 0}, { 9, 0, 0x1F, 6}, { 0, 0, 0x00,  0} },
+        { { 9, 5, 0x07, 0}, {10, 0, 0xFF, 3}, { 0, 0, 0x00,  0} },
+        { {11, 0, 0xFF, 0}, {12, 0, 0x07, 8}, { 0, 0, 0x00,  0} },
+        { {12, 3, 0x1F, 0}, {13, 0, 0x3F, 5}, { 0, 0, 0x00,  0} },
+        { {13, 6, 0x03, 0}, {14, 0, 0xFF, 2}, {15, 0, 0x01, 10} },
+        { {15, 1, 0x7F, 0}, {16, 0, 0x0F, 7}, { 0, 0, 0x00,  0} },
+        { {16, 4, 0x0F, 0}, {17, 0, 0x7F, 4}, { 0, 0, 0x00,  0} },
+        { {17, 7, 0x01, 0}, {18, 0, 0xFF, 1}, {19, 0, 0x03,  9} },
+        { {19, 2, 0x3F, 0}, {20, 0, 0x1F, 6}, { 0, 0, 0x00,  0} },
+        { {20, 5, 0x07, 0}, {21, 0, 0xFF, 3}, { 0, 0, 0x00,  0} }
+    };
+
+    if (trama[0] != INICIO_TRAMA_SBUS)
+        return TRAMA_RADIO_INVALIDA;
+
+    for (uint8_t canal = 0; canal < NUM_CANALES_SBUS; canal++) {
+        uint16_t valor = 0;
+
+        for (uint8_t i = 0; i < 3; i++) {
+            const uint8_t *d = decodificador[canal][i];
+
+            if (d[2] != 0) {
+                uint8_t pieza = trama[1 + d[0]];
+                pieza >>= d[1];
+                pieza &= d[2];
+                valor |= (uint16_t)pieza << d[3];
+            }
+        }
+
+        valores[canal] = (valor * 1000 / 2048) + 1000;
+    }
+
+    if (trama[23] & (1 << 3))
+        return TRAMA_RADIO_FAILSAFE;
+
+    if (trama[23] & (1 << 2))
+        return TRAMA_RADIO_PERDIDA;
+
+    return TRAMA_RADIO_OK;
+}
+
+
+/***************************************************************************************
+**  Nombre:         estadoTramaRadio_e decodificarAnteriorIBUSSITL(const uint8_t *trama, uint16_t *valores)
+**  Descripcion:    Decodificador iBUS anterior
+**  Parametros:     Trama, valores
+**  Retorno:        Estado de la trama
+****************************************************************************************/
+estadoTramaRadio_e decodificarAnteriorIBUSSITL(const uint8_t *trama, uint16_t *valores)
+{
+    uint32_t checksum = 96;
+
+    if ((trama[0] != 0x20) || (trama[1] != 0x40))
+        return TRAMA_RADIO_INVALIDA;
+
+    for (uint8_t canal = 0, i = 2; canal < NUM_CANALES_IBUS; canal++, i += 2) {
+        valores[canal] = trama[i] | (trama[i + 1] & 0x0F) << 8;
+        checksum += trama[i] + trama[i + 1];
+    }
+
+    checksum += trama[TAM_TRAMA_IBUS - 2] | trama[TAM_TRAMA_IBUS - 1] << 8;
+
+    if (checksum != 0xFFFF)
+        return TRAMA_RADIO_INVALIDA;
+
+    if ((trama[3] & 0xF0) || (trama[9] & 0xF0))
+        return TRAMA_RADIO_FAILSAFE;
+
+    return TRAMA_RADIO_OK;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void procesarByteAnteriorSITL(ensambladorAnteriorSITL_t *anterior,
+**                                                const protocoloRadioSITL_t *protocolo, uint8_t dato)
+**  Descripcion:    Ensamblador anterior de los drivers
+**  Parametros:     Estado, protocolo, byte recibido
+**  Retorno:        Ninguno
+****************************************************************************************/
+void procesarByteAnteriorSITL(ensambladorAnteriorSITL_t *anterior, const protocoloRadioSITL_t *protocolo, uint8_t dato)
+{
+    uint32_t tiempoActual = microsISR();
+    const bool separacionTrama = (tiempoActual - anterior->tiempoAnterior >= SEPARACION_ANTERIOR_SITL);
+    anterior->tiempoAnterior = tiempoActual;
+
+    if (separacionTrama)
+        anterior->offset = 0;
+
+    if (dato != protocolo->byteInicio && anterior->offset == 0)
+        return;
+
+    if (anterior->offset == 0 && !separacionTrama)
+        return;
+
+    anterior->buffer[anterior->offset++] = dato;
+
+    if (anterior->offset == protocolo->tamTrama) {
+        anterior->offset = 0;
+        anterior->tramaRecibida = true;
+
+        uint32_t *p = (uint32_t *)anterior->buffer;
+        for (uint8_t i = 0; i < (protocolo->tamTrama + 3) / 4; i++) {
+            anterior->trama[i] = *p;
+            p++;
+        }
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool probarReferenciasRadioSITL(void)
+**  Descripcion:    Decodifica las capturas y comprueba los valores y el estado
+**  Parametros:     Ninguno
+**  Retorno:        True si coinciden
+****************************************************************************************/
+bool probarReferenciasRadioSITL(void)
+{
+    referenciaRadioSITL_t referencias[LONG_ARRAY(tramasSBUSSITL) + LONG_ARRAY(tramasIBUSSITL) + 2];
+    uint8_t numReferencias = 0;
+    uint32_t errores = 0;
+
+    for (uint8_t i = 0; i < LONG_ARRAY(tramasSBUSSITL); i++) {
+        referenciaRadioSITL_t *ref = &referencias[numReferencias++];
+
+        ref->protocolo = &protocolosRadioSITL[0];
+        memcpy(ref->trama, tramasSBUSSITL[i], TAM_TRAMA_SBUS);
+        memcpy(ref->valores, valoresSBUSSITL[i], sizeof(valoresSBUSSITL[i]));
+        ref->estado = estadosSBUSSITL[i];
+    }
+
+    for (uint8_t i = 0; i < LONG_ARRAY(tramasIBUSSITL); i++) {
+        referenciaRadioSITL_t *ref = &referencias[numReferencias++];
+
+        ref->protocolo = &protocolosRadioSITL[1];
+        memcpy(ref->trama, tramasIBUSSITL[i], TAM_TRAMA_IBUS);
+        memcpy(ref->valores, valoresIBUSSITL[i], sizeof(valoresIBUSSITL[i]));
+        ref->estado = TRAMA_RADIO_OK;
+    }
+
+    // El receptor marca el failsafe en el nibble alto de los canales
+    referencias[numReferencias] = referencias[numReferencias - 2];
+    referencias[numReferencias].trama[3] |= 0x40;
+    cerrarTramaIBUSSITL(referencias[numReferencias].trama);
+    referencias[numReferencias++].estado = TRAMA_RADIO_FAILSAFE;
+
+    referencias[numReferencias] = referencias[numReferencias - 2];
+    referencias[numReferencias].trama[TAM_TRAMA_IBUS - 2] ^= 0x01;
+    referencias[numReferencias++].estado = TRAMA_RADIO_INVALIDA;
+
+    for (uint8_t i = 0; i < numReferencias; i++) {
+        const referenciaRadioSITL_t *ref = &referencias[i];
+        uint16_t valores[NUM_CANALES_SBUS];
+        const estadoTramaRadio_e estado = ref->protocolo->decodificar(ref->trama, valores);
+
+        if (estado != ref->estado || memcmp(valores, ref->valores, ref->protocolo->numCanales * sizeof(uint16_t)) != 0) {
+            printf("trama_radio referencia=%u protocolo=%s estado=%u esperado=%u\n", i, ref->protocolo->nombre, estado, ref->estado);
+            errores++;
+        }
+    }
+
+    printf("trama_radio referencias=%u errores=%u\n", numReferencias, errores);
+    return errores == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool compararDecodificadoresRadioSITL(const protocoloRadioSITL_t *protocolo, uint32_t numTramas)
+**  Descripcion:    Decodifica tramas aleatorias con el decodificador nuevo y el anterior
+**  Parametros:     Protocolo, numero de tramas
+**  Retorno:        True si coinciden todos los valores y estados
+****************************************************************************************/
+bool compararDecodificadoresRadioSITL(const protocoloRadioSITL_t *protocolo, uint32_t numTramas)
+{
+    uint32_t distintas = 0;
+
+    for (uint32_t i = 0; i < numTramas; i++) {
+        uint8_t trama[TAM_MAX_TRAMA_RADIO];
+        uint16_t valores[NUM_CANALES_SBUS], valoresAnterior[NUM_CANALES_SBUS];
+
+        protocolo->generar(trama);
+
+        const estadoTramaRadio_e estado = protocolo->decodificar(trama, valores);
+        const estadoTramaRadio_e estadoAnterior = protocolo->decodificarAnterior(trama, valoresAnterior);
+
+        if (estado != estadoAnterior || memcmp(valores, valoresAnterior, protocolo->numCanales * sizeof(uint16_t)) != 0)
+            distintas++;
+    }
+
+    printf("trama_radio protocolo=%s aleatorias=%u distintas=%u\n", protocolo->nombre, numTramas, distintas);
+    return distintas == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool probarFlujoRadioSITL(const protocoloRadioSITL_t *protocolo, uint32_t numTramas)
+**  Descripcion:    Manda tramas con la temporizacion del protocolo por el reloj virtual,
+**                  pierde bytes y mete ruido entre tramas. Cada trama publicada tiene que
+**                  ser una trama enviada entera y su tiempo el de su byte de inicio
+**  Parametros:     Protocolo, numero de tramas
+**  Retorno:        True si no se publica ninguna trama corrupta
+****************************************************************************************/
+bool probarFlujoRadioSITL(const protocoloRadioSITL_t *protocolo, uint32_t numTramas)
+{
+    static ensambladorRadio_t ensamblador;
+    static ensambladorAnteriorSITL_t anterior;
+    uint8_t (*tramas)[TAM_MAX_TRAMA_RADIO] = malloc(numTramas * sizeof(*tramas));
+    bool *enteras = malloc(numTramas * sizeof(bool));
+    uint32_t numEnteras = 0, leidas = 0, corruptas = 0, publicadasAnterior = 0, corruptasAnterior = 0;
+    const uint32_t inicio = microsISR();
+
+    iniciarEnsambladorRadio(&ensamblador, protocolo->tamTrama, protocolo->byteInicio, protocolo->duracionMax);
+    memset(&anterior, 0, sizeof(anterior));
+    tamCopiaRadioSITL = protocolo->tamTrama;
+
+    for (uint32_t k = 0; k < numTramas; k++) {
+        protocolo->generar(tramas[k]);
+        enteras[k] = true;
+
+        for (uint8_t i = 0; i < protocolo->tamTrama; i++) {
+            if (aleatorioRadioSITL() % PROB_BYTE_PERDIDO_SITL == 0)
+                enteras[k] = false;
+            else {
+                procesarByteEnsambladorRadio(&ensamblador, tramas[k][i]);
+                procesarByteAnteriorSITL(&anterior, protocolo, tramas[k][i]);
+            }
+
+            // La tarea lee en cualquier momento, tambien a mitad de trama
+            if (aleatorioRadioSITL() % protocolo->tamTrama == 0) {
+                uint8_t copia[TAM_MAX_TRAMA_RADIO] __attribute__((aligned(2)));
+                uint32_t tiempoTrama;
+
+                if (leerTramaRadio(&ensamblador, copiarTramaRadioSITL, (uint16_t *)copia, &tiempoTrama) != TRAMA_RADIO_NINGUNA) {
+                    const uint32_t desfase = tiempoTrama - inicio;
+                    const uint32_t n = desfase / protocolo->periodo;
+
+                    leidas++;
+                    if (desfase % protocolo->periodo != 0 || n >= numTramas || !enteras[n] ||
+                        memcmp(copia, tramas[n], protocolo->tamTrama) != 0)
+                        corruptas++;
+                }
+            }
+
+            if (anterior.tramaRecibida) {
+                anterior.tramaRecibida = false;
+                publicadasAnterior++;
+                if (!enteras[k] || memcmp(anterior.trama, tramas[k], protocolo->tamTrama) != 0)
+                    corruptasAnterior++;
+            }
+
+            if (i < protocolo->tamTrama - 1)
+                avanzarTiempoSITL(protocolo->tiempoByte);
+        }
+
+        numEnteras += enteras[k];
+
+        // Ruido en la separacion entre tramas, a veces con el byte de inicio
+        const uint32_t resto = protocolo->periodo - (protocolo->tamTrama - 1) * protocolo->tiempoByte;
+        if (aleatorioRadioSITL() % PROB_RUIDO_SITL == 0) {
+            const uint8_t ruido = aleatorioRadioSITL() % 2 ? protocolo->byteInicio : aleatorioRadioSITL() >> 7;
+
+            avanzarTiempoSITL(resto / 2);
+            procesarByteEnsambladorRadio(&ensamblador, ruido);
+            procesarByteAnteriorSITL(&anterior, protocolo, ruido);
+            avanzarTiempoSITL(resto - resto / 2);
+        }
+        else
+            avanzarTiempoSITL(resto);
+    }
+
+    printf("trama_radio protocolo=%s tramas=%u enteras=%u publicadas=%u publicadas_anterior=%u descartadas=%u leidas=%u "
+           "no_leidas=%u corruptas=%u corruptas_anterior=%u\n", protocolo->nombre, numTramas, numEnteras, ensamblador.publicadas,
+           publicadasAnterior, ensamblador.descartadas, leidas, ensamblador.noLeidas, corruptas, corruptasAnterior);
+
+    const bool ok = corruptas == 0 && ensamblador.publicadas >= FRACCION_MIN_RECUPERADAS_SITL * publicadasAnterior;
+
+    free(tramas);
+    free(enteras);
+    return ok;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void *productorRadioSITL(void *arg)
+**  Descripcion:    Hace de interrupcion de la UART: manda tramas SBUS sin parar con todos
+**                  los bytes de datos iguales al numero de trama
+**  Parametros:     Prueba
+**  Retorno:        NULL
+****************************************************************************************/
+void *productorRadioSITL(void *arg)
+{
+    pruebaHilosRadioSITL_t *prueba = arg;
+
+    for (uint32_t k = 0; k < TRAMAS_HILOS_SITL; k++) {
+        // El reloj virtual no avanza: se simula la separacion antes de cada trama
+        prueba->ensamblador.tiempoUltimo = microsISR() - SEPARACION_MIN_TRAMA_RADIO;
+        procesarByteEnsambladorRadio(&prueba->ensamblador, INICIO_TRAMA_SBUS);
+
+        for (uint8_t i = 1; i < TAM_TRAMA_SBUS; i++)
+            procesarByteEnsambladorRadio(&prueba->ensamblador, k);
+    }
+
+    __atomic_store_n(&prueba->terminado, true, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool probarHilosRadioSITL(void)
+**  Descripcion:    La tarea lee mientras otro hilo publica tramas. Ninguna trama entregada
+**                  puede mezclar bytes de dos tramas. Tambien cuenta las que se mezclarian
+**                  leyendo el buffer sin volver a comprobar el contador
+**  Parametros:     Ninguno
+**  Retorno:        True si no se entrega ninguna trama mezclada
+****************************************************************************************/
+bool probarHilosRadioSITL(void)
+{
+    static pruebaHilosRadioSITL_t prueba;
+    pthread_t productor;
+
+    memset(&prueba, 0, sizeof(prueba));
+    iniciarEnsambladorRadio(&prueba.ensamblador, TAM_TRAMA_SBUS, INICIO_TRAMA_SBUS, DURACION_MAX_TRAMA_SBUS);
+    tamCopiaRadioSITL = TAM_TRAMA_SBUS;
+
+    if (pthread_create(&productor, NULL, productorRadioSITL, &prueba) != 0) {
+        printf("trama_radio prueba=hilos error=pthread_create\n");
+        return false;
+    }
+
+    while (!__atomic_load_n(&prueba.terminado, __ATOMIC_ACQUIRE)) {
+        uint8_t copia[TAM_MAX_TRAMA_RADIO] __attribute__((aligned(2)));
+        uint32_t tiempoTrama;
+
+        if (leerTramaRadio(&prueba.ensamblador, copiarTramaRadioSITL, (uint16_t *)copia, &tiempoTrama) != TRAMA_RADIO_NINGUNA) {
+            prueba.leidas++;
+            for (uint8_t i = 2; i < TAM_TRAMA_SBUS; i++) {
+                if (copia[i] != copia[1]) {
+                    prueba.desgarradas++;
+                    break;
+                }
+            }
+        }
+
+        // Lo mismo sin comprobar si se ha reescrito el buffer mientras se copiaba
+        const uint32_t publicadas = __atomic_load_n(&prueba.ensamblador.publicadas, __ATOMIC_ACQUIRE);
+        if (publicadas > 0) {
+            copiarTramaRadioSITL(prueba.ensamblador.trama[(publicadas - 1) & 1], (uint16_t *)copia);
+            for (uint8_t i = 2; i < TAM_TRAMA_SBUS; i++) {
+                if (copia[i] != copia[1]) {
+                    prueba.desgarradasSinComprobar++;
+                    break;
+                }
+            }
+        }
+    }
+
+    pthread_join(productor, NULL);
+
+    printf("trama_radio prueba=hilos publicadas=%u leidas=%u desgarradas=%u desgarradas_sin_comprobar=%u\n",
+           prueba.ensamblador.publicadas, prueba.leidas, prueba.desgarradas, prueba.desgarradasSinComprobar);
+    return prueba.desgarradas == 0 && prueba.leidas > 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void medirRadioSITL(const protocoloRadioSITL_t *protocolo)
+**  Descripcion:    Mide por trama lo que cuesta la interrupcion y la decodificacion con el
+**                  codigo nuevo y el anterior. En el PC leer el tiempo es mas barato que en
+**                  la placa, asi que la diferencia en la interrupcion es menor que la real
+**  Parametros:     Protocolo
+**  Retorno:        Ninguno
+****************************************************************************************/
+void medirRadioSITL(const protocoloRadioSITL_t *protocolo)
+{
+    static uint8_t tramas[TRAMAS_MEDIDA_SITL][TAM_MAX_TRAMA_RADIO] __attribute__((aligned(4)));
+    static ensambladorRadio_t ensamblador;
+    static ensambladorAnteriorSITL_t anterior;
+    volatile uint32_t suma = 0;
+    uint16_t valores[NUM_CANALES_SBUS];
+    const double numTramas = (double)TRAMAS_MEDIDA_SITL * REPETICIONES_MEDIDA_SITL;
+    double inicio;
+
+    for (uint32_t k = 0; k < TRAMAS_MEDIDA_SITL; k++)
+        protocolo->generar(tramas[k]);
+
+    iniciarEnsambladorRadio(&ensamblador, protocolo->tamTrama, protocolo->byteInicio, protocolo->duracionMax);
+    memset(&anterior, 0, sizeof(anterior));
+
+    // Interrupcion
+    inicio = tiempoRealNsSITL();
+    for (uint32_t r = 0; r < REPETICIONES_MEDIDA_SITL; r++) {
+        for (uint32_t k = 0; k < TRAMAS_MEDIDA_SITL; k++) {
+            // El reloj virtual no avanza: se simula la separacion antes de cada trama
+            ensamblador.tiempoUltimo = microsISR() - SEPARACION_MIN_TRAMA_RADIO;
+            for (uint8_t i = 0; i < protocolo->tamTrama; i++)
+                procesarByteEnsambladorRadio(&ensamblador, tramas[k][i]);
+        }
+    }
+    const double nsIsr = (tiempoRealNsSITL() - inicio) / numTramas;
+
+    inicio = tiempoRealNsSITL();
+    for (uint32_t r = 0; r < REPETICIONES_MEDIDA_SITL; r++) {
+        for (uint32_t k = 0; k < TRAMAS_MEDIDA_SITL; k++) {
+            anterior.tiempoAnterior = microsISR() - SEPARACION_ANTERIOR_SITL;
+            for (uint8_t i = 0; i < protocolo->tamTrama; i++)
+                procesarByteAnteriorSITL(&anterior, protocolo, tramas[k][i]);
+        }
+    }
+    const double nsIsrAnterior = (tiempoRealNsSITL() - inicio) / numTramas;
+
+    // Decodificacion
+    inicio = tiempoRealNsSITL();
+    for (uint32_t r = 0; r < REPETICIONES_MEDIDA_SITL; r++) {
+        for (uint32_t k = 0; k < TRAMAS_MEDIDA_SITL; k++) {
+            suma += protocolo->decodificar(tramas[k], valores);
+            suma += valores[protocolo->numCanales - 1];
+        }
+    }
+    const double nsDecodificar = (tiempoRealNsSITL() - inicio) / numTramas;
+
+    inicio = tiempoRealNsSITL();
+    for (uint32_t r = 0; r < REPETICIONES_MEDIDA_SITL; r++) {
+        for (uint32_t k = 0; k < TRAMAS_MEDIDA_SITL; k++) {
+            suma += protocolo->decodificarAnterior(tramas[k], valores);
+            suma += valores[protocolo->numCanales - 1];
+        }
+    }
+    const double nsDecodificarAnterior = (tiempoRealNsSITL() - inicio) / numTramas;
+
+    printf("trama_radio protocolo=%s ns_isr_trama=%.1f ns_isr_trama_anterior=%.1f ns_decodificar=%.1f ns_decodificar_anterior=%.1f\n",
+           protocolo->nombre, nsIsr, nsIsrAnterior, nsDecodificar, nsDecodificarAnterior);
+}
+
+#endif
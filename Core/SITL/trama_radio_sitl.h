@@ -0,0 +1,63 @@
+/***************************************************************************************
+**  trama_radio_sitl.h - Prueba y medida de los decodificadores SBUS e iBUS
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __TRAMA_RADIO_SITL_H
+#define __TRAMA_RADIO_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * Comprueba los decodificadores con tramas de referencia y con tramas aleatorias frente a
+ * los decodificadores anteriores, pasa un flujo con la temporizacion real del SBUS y del
+ * iBUS por el ensamblador con bytes perdidos y ruido entre tramas, prueba el doble buffer
+ * con un hilo que hace de interrupcion y mide el coste por trama de los dos
+ */
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool probarTramaRadioSITL(uint32_t numTramas);
+
+#endif // __TRAMA_RADIO_SITL_H
@@ -0,0 +1,317 @@
+/***************************************************************************************
+**  monticulo_tareas.c - Funciones del monticulo de tareas ordenado por vencimiento
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "monticulo_tareas.h"
+#include "Comun/util.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define PADRE_MONTICULO(pos)          (((pos) - 1) >> 1)
+#define HIJO_IZQ_MONTICULO(pos)       (((pos) << 1) + 1)
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+static inline bool antesEnMonticulo(tarea_t *tarea1, tarea_t *tarea2);
+static inline void colocarEnMonticulo(monticuloTareas_t *monticulo, tarea_t *tarea, uint8_t pos);
+void subirMonticuloTareas(monticuloTareas_t *monticulo, uint8_t pos);
+void bajarMonticuloTareas(monticuloTareas_t *monticulo, uint8_t pos);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool antesEnMonticulo(tarea_t *tarea1, tarea_t *tarea2)
+**  Descripcion:    Comprueba si la tarea 1 vence antes que la tarea 2
+**  Parametros:     Tarea 1, tarea 2
+**  Retorno:        True si la tarea 1 vence antes
+****************************************************************************************/
+static inline bool antesEnMonticulo(tarea_t *tarea1, tarea_t *tarea2)
+{
+    return (int32_t)(VENCIMIENTO_TAREA(tarea1) - VENCIMIENTO_TAREA(tarea2)) < 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void colocarEnMonticulo(monticuloTareas_t *monticulo, tarea_t *tarea, uint8_t pos)
+**  Descripcion:    Coloca una tarea en una posicion del monticulo
+**  Parametros:     Monticulo, tarea, posicion
+**  Retorno:        Ninguno
+****************************************************************************************/
+static inline void colocarEnMonticulo(monticuloTareas_t *monticulo, tarea_t *tarea, uint8_t pos)
+{
+    monticulo->tareas[pos] = tarea;
+    tarea->posMonticulo = pos;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void iniciarMonticuloTareas(monticuloTareas_t *monticulo)
+**  Descripcion:    Vacia el monticulo
+**  Parametros:     Monticulo
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarMonticuloTareas(monticuloTareas_t *monticulo)
+{
+    for (uint8_t i = 0; i < TAREA_CONTADOR; i++)
+        monticulo->tareas[i] = NULL;
+
+    monticulo->tam = 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void subirMonticuloTareas(monticuloTareas_t *monticulo, uint8_t pos)
+**  Descripcion:    Sube una tarea hasta restaurar el orden del monticulo
+**  Parametros:     Monticulo, posicion de la tarea
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void subirMonticuloTareas(monticuloTareas_t *monticulo, uint8_t pos)
+{
+    tarea_t *tarea = monticulo->tareas[pos];
+
+    while (pos > 0) {
+        const uint8_t padre = PADRE_MONTICULO(pos);
+        if (!antesEnMonticulo(tarea, monticulo->tareas[padre]))
+            break;
+
+        colocarEnMonticulo(monticulo, monticulo->tareas[padre], pos);
+        pos = padre;
+    }
+
+    colocarEnMonticulo(monticulo, tarea, pos);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void bajarMonticuloTareas(monticuloTareas_t *monticulo, uint8_t pos)
+**  Descripcion:    Baja una tarea hasta restaurar el orden del monticulo
+**  Parametros:     Monticulo, posicion de la tarea
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void bajarMonticuloTareas(monticuloTareas_t *monticulo, uint8_t pos)
+{
+    tarea_t *tarea = monticulo->tareas[pos];
+
+    while (true) {
+        uint8_t hijo = HIJO_IZQ_MONTICULO(pos);
+        if (hijo >= monticulo->tam)
+            break;
+
+        // Nos quedamos con el hijo que vence antes
+        if ((hijo + 1) < monticulo->tam && antesEnMonticulo(monticulo->tareas[hijo + 1], monticulo->tareas[hijo]))
+            hijo++;
+
+        if (!antesEnMonticulo(monticulo->tareas[hijo], tarea))
+            break;
+
+        colocarEnMonticulo(monticulo, monticulo->tareas[hijo], pos);
+        pos = hijo;
+    }
+
+    colocarEnMonticulo(monticulo, tarea, pos);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool insertarMonticuloTareas(monticuloTareas_t *monticulo, tarea_t *tarea)
+**  Descripcion:    Inserta una tarea en el monticulo
+**  Parametros:     Monticulo, tarea
+**  Retorno:        True si ok
+****************************************************************************************/
+bool insertarMonticuloTareas(monticuloTareas_t *monticulo, tarea_t *tarea)
+{
+    if (monticulo->tam >= TAREA_CONTADOR || tareaEnMonticulo(monticulo, tarea))
+        return false;
+
+    tarea->vencimiento = tarea->ultimoTiempoEjec + (uint32_t)tarea->periodo;
+    colocarEnMonticulo(monticulo, tarea, monticulo->tam);
+    monticulo->tam++;
+    subirMonticuloTareas(monticulo, tarea->posMonticulo);
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool quitarMonticuloTareas(monticuloTareas_t *monticulo, tarea_t *tarea)
+**  Descripcion:    Quita una tarea del monticulo
+**  Parametros:     Monticulo, tarea
+**  Retorno:        True si ok
+****************************************************************************************/
+bool quitarMonticuloTareas(monticuloTareas_t *monticulo, tarea_t *tarea)
+{
+    if (!tareaEnMonticulo(monticulo, tarea))
+        return false;
+
+    const uint8_t pos = tarea->posMonticulo;
+    monticulo->tam--;
+
+    // El ultimo elemento ocupa el hueco y se recoloca
+    if (pos != monticulo->tam) {
+        colocarEnMonticulo(monticulo, monticulo->tareas[monticulo->tam], pos);
+        reordenarMonticuloTareas(monticulo, monticulo->tareas[pos]);
+    }
+
+    monticulo->tareas[monticulo->tam] = NULL;
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void reordenarMonticuloTareas(monticuloTareas_t *monticulo, tarea_t *tarea)
+**  Descripcion:    Recoloca una tarea cuyo vencimiento ha cambiado
+**  Parametros:     Monticulo, tarea
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void reordenarMonticuloTareas(monticuloTareas_t *monticulo, tarea_t *tarea)
+{
+    const uint8_t pos = tarea->posMonticulo;
+
+    if (pos > 0 && antesEnMonticulo(tarea, monticulo->tareas[PADRE_MONTICULO(pos)]))
+        subirMonticuloTareas(monticulo, pos);
+    else
+        bajarMonticuloTareas(monticulo, pos);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool tareaEnMonticulo(monticuloTareas_t *monticulo, tarea_t *tarea)
+**  Descripcion:    Comprueba si una tarea esta en el monticulo
+**  Parametros:     Monticulo, tarea
+**  Retorno:        True si esta metida
+****************************************************************************************/
+bool tareaEnMonticulo(monticuloTareas_t *monticulo, tarea_t *tarea)
+{
+    return tarea->posMonticulo < monticulo->tam && monticulo->tareas[tarea->posMonticulo] == tarea;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void reprogramarMonticuloTareas(monticuloTareas_t *monticulo, tarea_t *tarea)
+**  Descripcion:    Recalcula el vencimiento tras ejecutar la tarea o cambiar su periodo y
+**                  la recoloca
+**  Parametros:     Monticulo, tarea
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void reprogramarMonticuloTareas(monticuloTareas_t *monticulo, tarea_t *tarea)
+{
+    const uint32_t vencimientoAnterior = tarea->vencimiento;
+
+    tarea->vencimiento = tarea->ultimoTiempoEjec + (uint32_t)tarea->periodo;
+
+    // Al ejecutarse el vencimiento solo avanza y basta con bajarla
+    if ((int32_t)(tarea->vencimiento - vencimientoAnterior) >= 0)
+        bajarMonticuloTareas(monticulo, tarea->posMonticulo);
+    else
+        subirMonticuloTareas(monticulo, tarea->posMonticulo);
+}
+
+
+/***************************************************************************************
+**  Nombre:         tarea_t *seleccionarFondoMonticulos(monticuloTareas_t *monticulos, uint8_t mascaraNiveles,
+**                                                      uint32_t tiempoActual)
+**  Descripcion:    Elige la tarea de fondo a ejecutar mirando solo la primera de cada
+**                  nivel. Entre las vencidas gana la de mayor prioridad por edad en
+**                  periodos, como la prioridad dinamica del recorrido lineal pero sin
+**                  redondear la edad. Se compara multiplicando en cruz para no dividir y a
+**                  igualdad gana el nivel mas alto
+**  Parametros:     Monticulos por nivel, niveles con alguna tarea, tiempo actual
+**  Retorno:        Tarea seleccionada o NULL si no hay ninguna vencida
+****************************************************************************************/
+CODIGO_RAPIDO tarea_t *seleccionarFondoMonticulos(monticuloTareas_t *monticulos, uint8_t mascaraNiveles, uint32_t tiempoActual)
+{
+    tarea_t *tareaSeleccionada = NULL;
+    float pesoSeleccionada = 0;                 // Prioridad por edad de la seleccionada
+    float periodoSeleccionada = 1;
+
+    while (mascaraNiveles != 0) {
+        const uint8_t nivel = 31 - __builtin_clz(mascaraNiveles);
+        mascaraNiveles &= ~BIT(nivel);
+
+        tarea_t *tarea = primeraTareaMonticulo(&monticulos[nivel]);
+        if ((int32_t)(tiempoActual - VENCIMIENTO_TAREA(tarea)) < 0)
+            continue;
+
+        // peso / periodo > pesoSeleccionada / periodoSeleccionada
+        const float peso = (float)tarea->prioridadEstatica * (tiempoActual - tarea->ultimoTiempoEjec);
+        if (tareaSeleccionada == NULL || peso * periodoSeleccionada > pesoSeleccionada * tarea->periodo) {
+            tareaSeleccionada = tarea;
+            pesoSeleccionada = peso;
+            periodoSeleccionada = tarea->periodo;
+        }
+    }
+
+    return tareaSeleccionada;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint8_t contarTareasVencidasMonticulo(monticuloTareas_t *monticulo, uint32_t tiempoActual)
+**  Descripcion:    Cuenta las tareas cuyo vencimiento ha pasado. Solo se recorren las ramas
+**                  vencidas, por lo que el coste es proporcional al numero de tareas en espera
+**  Parametros:     Monticulo, tiempo actual
+**  Retorno:        Numero de tareas vencidas
+****************************************************************************************/
+CODIGO_RAPIDO uint8_t contarTareasVencidasMonticulo(monticuloTareas_t *monticulo, uint32_t tiempoActual)
+{
+    uint8_t pila[TAREA_CONTADOR];
+    uint8_t tamPila = 0;
+    uint8_t vencidas = 0;
+
+    if (monticulo->tam > 0)
+        pila[tamPila++] = 0;
+
+    while (tamPila > 0) {
+        const uint8_t pos = pila[--tamPila];
+        if ((int32_t)(tiempoActual - VENCIMIENTO_TAREA(monticulo->tareas[pos])) < 0)
+            continue;
+
+        vencidas++;
+        const uint8_t hijo = HIJO_IZQ_MONTICULO(pos);
+        if (hijo < monticulo->tam)
+            pila[tamPila++] = hijo;
+        if ((hijo + 1) < monticulo->tam)
+            pila[tamPila++] = hijo + 1;
+    }
+
+    return vencidas;
+}
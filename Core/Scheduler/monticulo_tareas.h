@@ -0,0 +1,91 @@
+/***************************************************************************************
+**  monticulo_tareas.h - Funciones del monticulo de tareas ordenado por vencimiento
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __MONTICULO_TAREAS_H
+#define __MONTICULO_TAREAS_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "Sistema/plataforma.h"
+#include "scheduler.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+// Instante de la proxima ejecucion de una tarea, precalculado al insertarla y al
+// reprogramarla. Las comparaciones se hacen con la diferencia con signo para soportar el
+// desbordamiento de micros()
+#define VENCIMIENTO_TAREA(tarea)            ((tarea)->vencimiento)
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    tarea_t *tareas[TAREA_CONTADOR];     // Monticulo binario de minimos por vencimiento
+    uint8_t tam;
+} monticuloTareas_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void iniciarMonticuloTareas(monticuloTareas_t *monticulo);
+bool insertarMonticuloTareas(monticuloTareas_t *monticulo, tarea_t *tarea);
+bool quitarMonticuloTareas(monticuloTareas_t *monticulo, tarea_t *tarea);
+void reordenarMonticuloTareas(monticuloTareas_t *monticulo, tarea_t *tarea);
+bool tareaEnMonticulo(monticuloTareas_t *monticulo, tarea_t *tarea);
+void reprogramarMonticuloTareas(monticuloTareas_t *monticulo, tarea_t *tarea);
+tarea_t *seleccionarFondoMonticulos(monticuloTareas_t *monticulos, uint8_t mascaraNiveles, uint32_t tiempoActual);
+uint8_t contarTareasVencidasMonticulo(monticuloTareas_t *monticulo, uint32_t tiempoActual);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         tarea_t *primeraTareaMonticulo(monticuloTareas_t *monticulo)
+**  Descripcion:    Devuelve la tarea con el vencimiento mas proximo
+**  Parametros:     Monticulo
+**  Retorno:        Tarea o NULL si esta vacio
+****************************************************************************************/
+static inline tarea_t *primeraTareaMonticulo(monticuloTareas_t *monticulo)
+{
+    return monticulo->tam > 0 ? monticulo->tareas[0] : NULL;
+}
+
+
+#endif // __MONTICULO_TAREAS_H
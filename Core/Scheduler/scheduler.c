@@ -25,9 +25,12 @@
 /***************************************************************************************
 ** AREA DE INCLUDES                                                                   **
 ****************************************************************************************/
+#include <stdio.h>
 #include <string.h>
 
 #include "scheduler.h"
+#include "monticulo_tareas.h"
+#include "Comun/util.h"
 #include "Comun/matematicas.h"
 #include "Drivers/tiempo.h"
 #include "GP/gp_sistema.h"
@@ -38,6 +41,8 @@
 ** AREA DE PREPROCESADOR                                                              **
 ****************************************************************************************/
 #define NUM_MUESTRAS_SUMA_SCHEDULER      32
+#define NUM_NIVELES_PRIORIDAD_SCHEDULER  (PRIORIDAD_ALTA + 2)   // Un nivel por prioridad de fondo y otro para PRIORIDAD_MAXIMA
+#define MUESTREO_CARGA_SCHEDULER         16                     // Pasadas de fondo por cada muestra de carga
 
 
 /***************************************************************************************
@@ -48,13 +53,20 @@
 /***************************************************************************************
 ** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
+#if defined(USAR_SCHEDULER_DEADLINE)
+static RAM_RAPIDA monticuloTareas_t monticuloTiempoReal;
+static RAM_RAPIDA monticuloTareas_t monticulosFondo[NUM_NIVELES_PRIORIDAD_SCHEDULER];
+static RAM_RAPIDA uint8_t mascaraNivelesFondo = 0;            // Niveles de fondo con alguna tarea
+static RAM_RAPIDA uint8_t contadorMuestreoCarga = 0;
+#else
 static RAM_RAPIDA tarea_t* colaTareas[TAREA_CONTADOR + 1];  // Una posicion extra para un puntero nulo
+static RAM_RAPIDA uint8_t posColaTareas = 0;
+static RAM_RAPIDA uint8_t tamColaTareas = 0;
+#endif
 static RAM_RAPIDA tarea_t *tareaActual = NULL;
 static RAM_RAPIDA_INI uint32_t totalTareasEsperando;
 static RAM_RAPIDA_INI uint32_t totalMuestraTareasEsperando;
 static RAM_RAPIDA_INI bool calcularEstadisticasTareas;
-static RAM_RAPIDA uint8_t posColaTareas = 0;
-static RAM_RAPIDA uint8_t tamColaTareas = 0;
 static RAM_RAPIDA uint8_t porcentajeCargaSistema = 0;
 
 static bool bitVidaScheduler = false;
@@ -65,8 +77,18 @@ static bool bitVidaScheduler = false;
 ****************************************************************************************/
 void limpiarColaTareas(void);
 bool tareaEnCola(tarea_t *tarea);
+#if defined(USAR_SCHEDULER_DEADLINE)
+static inline uint8_t nivelPrioridadTarea(tarea_t *tarea);
+static inline monticuloTareas_t *monticuloTarea(tarea_t *tarea);
+#else
 tarea_t *primeraTareaCola(void);
 tarea_t *siguienteTareaCola(void);
+#endif
+#if defined(USAR_ESTADISTICAS_TAREAS)
+static inline void anadirHistogramaTarea(histogramaTarea_t *hist, uint32_t valor);
+uint32_t percentilHistogramaTarea(const histogramaTarea_t *hist, uint8_t percentil);
+void actualizarEstadisticasTarea(tarea_t *tarea, uint32_t tiempoEjecTarea);
+#endif
 void actualizarBitVidaScheduler(colorRGB_e color);
 
 
@@ -82,10 +104,47 @@ void actualizarBitVidaScheduler(colorRGB_e color);
 ****************************************************************************************/
 void limpiarColaTareas(void)
 {
+#if defined(USAR_SCHEDULER_DEADLINE)
+    iniciarMonticuloTareas(&monticuloTiempoReal);
+    for (uint8_t i = 0; i < NUM_NIVELES_PRIORIDAD_SCHEDULER; i++)
+        iniciarMonticuloTareas(&monticulosFondo[i]);
+
+    mascaraNivelesFondo = 0;
+#else
     memset(colaTareas, 0, sizeof(colaTareas));
     posColaTareas = 0;
     tamColaTareas = 0;
+#endif
+}
+
+
+#if defined(USAR_SCHEDULER_DEADLINE)
+/***************************************************************************************
+**  Nombre:         uint8_t nivelPrioridadTarea(tarea_t *tarea)
+**  Descripcion:    Devuelve el nivel de fondo que corresponde a la prioridad de una tarea
+**  Parametros:     Tarea
+**  Retorno:        Nivel
+****************************************************************************************/
+static inline uint8_t nivelPrioridadTarea(tarea_t *tarea)
+{
+    return tarea->prioridadEstatica <= PRIORIDAD_ALTA ? tarea->prioridadEstatica : PRIORIDAD_ALTA + 1;
+}
+
+
+/***************************************************************************************
+**  Nombre:         monticuloTareas_t *monticuloTarea(tarea_t *tarea)
+**  Descripcion:    Devuelve el monticulo en el que se gestiona una tarea
+**  Parametros:     Tarea
+**  Retorno:        Monticulo
+****************************************************************************************/
+static inline monticuloTareas_t *monticuloTarea(tarea_t *tarea)
+{
+    if (tarea->prioridadEstatica == PRIORIDAD_TIEMPO_REAL)
+        return &monticuloTiempoReal;
+
+    return &monticulosFondo[nivelPrioridadTarea(tarea)];
 }
+#endif
 
 
 /***************************************************************************************
@@ -96,6 +155,15 @@ void limpiarColaTareas(void)
 ****************************************************************************************/
 bool anadirTareaEnCola(tarea_t *tarea)
 {
+#if defined(USAR_SCHEDULER_DEADLINE)
+    if (!insertarMonticuloTareas(monticuloTarea(tarea), tarea))
+        return false;
+
+    if (tarea->prioridadEstatica != PRIORIDAD_TIEMPO_REAL)
+        mascaraNivelesFondo |= BIT(nivelPrioridadTarea(tarea));
+
+    return true;
+#else
     // Chequeamos el tamanio de la cola o si ya esta metida
     if ((tamColaTareas >= TAREA_CONTADOR) || tareaEnCola(tarea))
         return false;
@@ -110,6 +178,7 @@ bool anadirTareaEnCola(tarea_t *tarea)
         }
     }
     return false;
+#endif
 }
 
 
@@ -121,6 +190,17 @@ bool anadirTareaEnCola(tarea_t *tarea)
 ****************************************************************************************/
 bool quitarTareaDeCola(tarea_t *tarea)
 {
+#if defined(USAR_SCHEDULER_DEADLINE)
+    monticuloTareas_t *monticulo = monticuloTarea(tarea);
+
+    if (!quitarMonticuloTareas(monticulo, tarea))
+        return false;
+
+    if (tarea->prioridadEstatica != PRIORIDAD_TIEMPO_REAL && monticulo->tam == 0)
+        mascaraNivelesFondo &= ~BIT(nivelPrioridadTarea(tarea));
+
+    return true;
+#else
     for (uint8_t i = 0; i < tamColaTareas; i++) {
         if (colaTareas[i] == tarea) {
             memmove(&colaTareas[i], &colaTareas[i+1], sizeof(tarea) * (tamColaTareas - i));
@@ -129,6 +209,7 @@ bool quitarTareaDeCola(tarea_t *tarea)
         }
     }
     return false;
+#endif
 }
 
 
@@ -140,14 +221,21 @@ bool quitarTareaDeCola(tarea_t *tarea)
 ****************************************************************************************/
 bool tareaEnCola(tarea_t *tarea)
 {
+#if defined(USAR_SCHEDULER_DEADLINE)
+    return tareaEnMonticulo(monticuloTarea(tarea), tarea);
+#else
     for (uint8_t i = 0; i < tamColaTareas; i++) {
         if (colaTareas[i] == tarea)
             return true;
     }
     return false;
+#endif
 }
 
 
+#if !defined(USAR_SCHEDULER_DEADLINE)
+
+
 /***************************************************************************************
 **  Nombre:         tarea_t *primeraTareaCola(void)
 **  Descripcion:    Retorna la primera tarea de la cola
@@ -171,6 +259,7 @@ CODIGO_RAPIDO tarea_t *siguienteTareaCola(void)
 {
     return colaTareas[++posColaTareas];
 }
+#endif
 
 
 /***************************************************************************************
@@ -204,12 +293,15 @@ void ajustarFrecuenciaEjecucionTarea(idTarea_e idTarea, uint32_t periodo)
         tarea = &tareas[idTarea];
         tarea->periodo = MAX(LIMITE_FREC_US_SCHEDULER, (int32_t)periodo);  // Limite para prevenir la saturacion del scheduler
     }
+
+#if defined(USAR_SCHEDULER_DEADLINE)
+    // El vencimiento depende del periodo
+    if (tarea != NULL && tareaEnCola(tarea))
+        reprogramarMonticuloTareas(monticuloTarea(tarea), tarea);
+#endif
 }
-uint32_t contador = 0;
-uint32_t tiempoIni = 0;
-bool ini = false;
-float porcentaje, pMax;
-uint32_t t1, t2 = 0;
+
+
 /***************************************************************************************
 **  Nombre:         void calcularCargaScheduler(uint32_t tiempoActual)
 **  Descripcion:    Calcula la carga del scheduler
@@ -222,16 +314,6 @@ void calcularCargaScheduler(uint32_t tiempoActual)
 
     actualizarBitVidaScheduler(VERDE);
 
-    if (t1 > 0 || t2 > 0) {
-    	porcentaje = (float)(t1 + t2) / 100000.0;
-    	if (pMax < porcentaje)
-    		pMax = porcentaje;
-    	t1 = 0;
-    	t2 = 0;
-    	contador = 0;
-    }
-
-
     if (totalMuestraTareasEsperando > 0) {
         porcentajeCargaSistema = 100 * totalTareasEsperando / totalMuestraTareasEsperando;
         totalMuestraTareasEsperando = 0;
@@ -294,6 +376,45 @@ void infoTarea(idTarea_e idTarea, infoTarea_t * infoTarea)
     infoTarea->tiempoEjecucionTotal = tareas[idTarea].tiempoEjecucionTotal;
     infoTarea->tiempoEjecucionMedio = tareas[idTarea].sumaMovTiempoEjec / NUM_MUESTRAS_SUMA_SCHEDULER;
     infoTarea->ultimoPeriodo = tareas[idTarea].ultimoPeriodoEjec;
+
+#if defined(USAR_ESTADISTICAS_TAREAS)
+    infoTarea->tiempoEjecucionP50 = percentilHistogramaTarea(&tareas[idTarea].histTiempoEjec, 50);
+    infoTarea->tiempoEjecucionP99 = percentilHistogramaTarea(&tareas[idTarea].histTiempoEjec, 99);
+    infoTarea->errorPeriodoP50 = percentilHistogramaTarea(&tareas[idTarea].histErrorPeriodo, 50);
+    infoTarea->errorPeriodoP99 = percentilHistogramaTarea(&tareas[idTarea].histErrorPeriodo, 99);
+    infoTarea->errorPeriodoMax = tareas[idTarea].histErrorPeriodo.max;
+#endif
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t volcarEstadisticasTareas(char *buffer, uint32_t tam)
+**  Descripcion:    Escribe en texto los percentiles de todas las tareas
+**  Parametros:     Buffer de salida, tamanio del buffer
+**  Retorno:        Numero de caracteres escritos
+****************************************************************************************/
+uint32_t volcarEstadisticasTareas(char *buffer, uint32_t tam)
+{
+    uint32_t pos = 0;
+
+    for (idTarea_e i = 0; i < TAREA_CONTADOR && pos < tam; i++) {
+        infoTarea_t info;
+        infoTarea(i, &info);
+
+        if (!info.habilitado)
+            continue;
+
+        int ret = snprintf(&buffer[pos], tam - pos, "%s: ejec p50 %lu p99 %lu max %lu us, error periodo p50 %lu p99 %lu max %lu us\n",
+                           info.nombreTarea,
+                           (unsigned long)info.tiempoEjecucionP50, (unsigned long)info.tiempoEjecucionP99, (unsigned long)info.tiempoMaxEjecucion,
+                           (unsigned long)info.errorPeriodoP50, (unsigned long)info.errorPeriodoP99, (unsigned long)info.errorPeriodoMax);
+        if (ret < 0)
+            break;
+
+        pos = MIN(pos + ret, tam - 1);
+    }
+
+    return pos;
 }
 
 
@@ -310,11 +431,15 @@ void resetearEstadisticasTarea(idTarea_e idTarea)
         tareaActual->sumaMovTiempoEjec = 0;
         tareaActual->tiempoEjecucionTotal = 0;
         tareaActual->tiempoMaxEjecucion = 0;
+        memset(&tareaActual->histTiempoEjec, 0, sizeof(histogramaTarea_t));
+        memset(&tareaActual->histErrorPeriodo, 0, sizeof(histogramaTarea_t));
     }
     else if (idTarea < TAREA_CONTADOR) {
         tareas[idTarea].sumaMovTiempoEjec = 0;
         tareas[idTarea].tiempoEjecucionTotal = 0;
         tareas[idTarea].tiempoMaxEjecucion = 0;
+        memset(&tareas[idTarea].histTiempoEjec, 0, sizeof(histogramaTarea_t));
+        memset(&tareas[idTarea].histErrorPeriodo, 0, sizeof(histogramaTarea_t));
     }
 #endif
 }
@@ -354,9 +479,165 @@ void actualizarBitVidaScheduler(colorRGB_e color)
 		bitVidaScheduler = true;
 	}
 }
-#include <math.h>
-uint32_t contador1 = 0;
-bool calc = false;
+
+
+#if defined(USAR_ESTADISTICAS_TAREAS)
+/***************************************************************************************
+**  Nombre:         void anadirHistogramaTarea(histogramaTarea_t *hist, uint32_t valor)
+**  Descripcion:    Anade una muestra a un histograma log2
+**  Parametros:     Histograma, valor en us
+**  Retorno:        Ninguno
+****************************************************************************************/
+static inline void anadirHistogramaTarea(histogramaTarea_t *hist, uint32_t valor)
+{
+    const uint32_t cubeta = valor ? 32 - __builtin_clz(valor) : 0;
+
+    hist->cubetas[MIN(cubeta, NUM_CUBETAS_HIST_TAREA - 1)]++;
+    if (valor > hist->max)
+        hist->max = valor;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t percentilHistogramaTarea(const histogramaTarea_t *hist, uint8_t percentil)
+**  Descripcion:    Calcula un percentil de un histograma. Trabaja sobre una copia para no
+**                  tener que parar el scheduler. El resultado es el limite superior de la
+**                  cubeta, acotado por el maximo
+**  Parametros:     Histograma, percentil
+**  Retorno:        Valor del percentil en us
+****************************************************************************************/
+uint32_t percentilHistogramaTarea(const histogramaTarea_t *hist, uint8_t percentil)
+{
+    histogramaTarea_t copia;
+    uint64_t total = 0;
+    uint64_t acumulado = 0;
+
+    memcpy(&copia, hist, sizeof(histogramaTarea_t));
+    for (uint8_t i = 0; i < NUM_CUBETAS_HIST_TAREA; i++)
+        total += copia.cubetas[i];
+
+    if (total == 0)
+        return 0;
+
+    const uint64_t umbral = (total * percentil + 99) / 100;
+    for (uint8_t i = 0; i < NUM_CUBETAS_HIST_TAREA - 1; i++) {
+        acumulado += copia.cubetas[i];
+        if (acumulado >= umbral)
+            return MIN((1UL << i) - 1, copia.max);
+    }
+
+    return copia.max;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void actualizarEstadisticasTarea(tarea_t *tarea, uint32_t tiempoEjecTarea)
+**  Descripcion:    Actualiza las estadisticas de una tarea tras su ejecucion
+**  Parametros:     Tarea, tiempo de ejecucion en us
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void actualizarEstadisticasTarea(tarea_t *tarea, uint32_t tiempoEjecTarea)
+{
+    tarea->sumaMovTiempoEjec += tiempoEjecTarea - tarea->sumaMovTiempoEjec / NUM_MUESTRAS_SUMA_SCHEDULER;
+    tarea->tiempoEjecucionTotal += tiempoEjecTarea;   // Tiempo consumido por el scheduler + tarea
+    tarea->tiempoMaxEjecucion = MAX(tarea->tiempoMaxEjecucion, tiempoEjecTarea);
+    anadirHistogramaTarea(&tarea->histTiempoEjec, tiempoEjecTarea);
+
+    // En la primera ejecucion el periodo se mide desde el arranque y no es valido
+    if ((uint32_t)tarea->ultimoPeriodoEjec != tarea->ultimoTiempoEjec) {
+        const int32_t errorPeriodo = tarea->ultimoPeriodoEjec - tarea->periodo;
+        anadirHistogramaTarea(&tarea->histErrorPeriodo, ABS(errorPeriodo));
+    }
+}
+#endif
+
+
+#if defined(USAR_SCHEDULER_DEADLINE)
+/***************************************************************************************
+**  Nombre:         void scheduler(void)
+**  Descripcion:    Funcion de ejecucion de las tareas. Las tareas en tiempo real se
+**                  despachan desde un monticulo ordenado por vencimiento y las de fondo
+**                  desde un monticulo por nivel de prioridad ordenado por vencimiento
+**                  precalculado. En los niveles de fondo solo se mira la primera tarea de
+**                  cada uno y se elige la vencida con mayor prioridad por edad
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void scheduler(void)
+{
+    int32_t tiempoHastaEjec = 0x7FFFFFFF;
+    uint32_t tiempoActual = micros();
+
+    // Actualizacion de las tareas en tiempo real por orden de vencimiento
+    tarea_t *tarea = primeraTareaMonticulo(&monticuloTiempoReal);
+    if (tarea != NULL)
+        tiempoHastaEjec = VENCIMIENTO_TAREA(tarea) - tiempoActual;
+
+    while (tarea != NULL && (int32_t)(VENCIMIENTO_TAREA(tarea) - tiempoActual) <= 0) {
+        tarea->ultimoPeriodoEjec = tiempoActual - tarea->ultimoTiempoEjec;
+        tarea->ultimoTiempoEjec = tiempoActual;
+        reprogramarMonticuloTareas(&monticuloTiempoReal, tarea);
+        tareaActual = tarea;
+
+#if defined(USAR_ESTADISTICAS_TAREAS)
+        if (calcularEstadisticasTareas) {
+            const uint32_t tiempoActualAntesLlamada = micros();
+            tarea->funTarea(tiempoActual);
+            const uint32_t tiempoEjecTarea = micros() - tiempoActualAntesLlamada;
+            actualizarEstadisticasTarea(tarea, tiempoEjecTarea);
+        }
+        else
+#endif
+        tarea->funTarea(tiempoActual);
+
+        tiempoHastaEjec -= tarea->tiempoMaxEjecucion;
+        tarea = primeraTareaMonticulo(&monticuloTiempoReal);
+    }
+
+    // Actualizacion de las tareas no en tiempo real
+    if (tiempoHastaEjec > INTERVALO_GUARDA_TIEMPO_REAL) {
+        tiempoActual = micros();
+
+        // Solo se mira la primera tarea de cada nivel, la de vencimiento mas antiguo
+        tarea_t *tareaSeleccionada = seleccionarFondoMonticulos(monticulosFondo, mascaraNivelesFondo, tiempoActual);
+
+        // La carga se estima contando las tareas vencidas solo en una de cada
+        // MUESTREO_CARGA_SCHEDULER pasadas, para no recorrer los monticulos en cada ciclo
+        if (++contadorMuestreoCarga >= MUESTREO_CARGA_SCHEDULER) {
+            uint16_t tareasEnEspera = 0;
+
+            contadorMuestreoCarga = 0;
+            for (uint8_t nivel = 0; nivel < NUM_NIVELES_PRIORIDAD_SCHEDULER; nivel++)
+                tareasEnEspera += contarTareasVencidasMonticulo(&monticulosFondo[nivel], tiempoActual);
+
+            totalMuestraTareasEsperando++;
+            totalTareasEsperando += tareasEnEspera;
+        }
+
+        tareaActual = tareaSeleccionada;
+
+        if (tareaSeleccionada) {
+            // Se ha encontrado una tarea que debe ser ejecutada
+            tareaSeleccionada->ultimoPeriodoEjec = tiempoActual - tareaSeleccionada->ultimoTiempoEjec;
+            tareaSeleccionada->ultimoTiempoEjec = tiempoActual;
+            reprogramarMonticuloTareas(monticuloTarea(tareaSeleccionada), tareaSeleccionada);
+
+            // Ejecuta la tarea
+#if defined(USAR_ESTADISTICAS_TAREAS)
+            if (calcularEstadisticasTareas) {
+                const uint32_t tiempoActualAntesLlamada = micros();
+
+                tareaSeleccionada->funTarea(tiempoActualAntesLlamada);
+                const uint32_t tiempoEjecTarea = micros() - tiempoActualAntesLlamada;
+                actualizarEstadisticasTarea(tareaSeleccionada, tiempoEjecTarea);
+            }
+            else
+#endif
+            tareaSeleccionada->funTarea(tiempoActual);
+        }
+    }
+}
+#else
 /***************************************************************************************
 **  Nombre:         void scheduler(void)
 **  Descripcion:    Funcion de ejecucion de las tareas
@@ -369,13 +650,6 @@ CODIGO_RAPIDO void scheduler(void)
     int32_t tiempoHastaEjec = 0x7FFFFFFF;
 
     uint32_t tiempoActual = micros();
-    if (!ini) {
-    	tiempoIni = tiempoActual;
-        ini = true;
-    }
-
-    if ((tiempoActual - tiempoIni) < 100000)
-        contador1++;
 
     // Actualizacion de las tareas en tiempo real
     for (tarea_t *tarea = primeraTareaCola(); tarea != NULL; tarea = siguienteTareaCola()) {
@@ -397,31 +671,7 @@ CODIGO_RAPIDO void scheduler(void)
                 const uint32_t tiempoActualAntesLlamada = micros();
                 tarea->funTarea(tiempoActual);
                 const uint32_t tiempoEjecTarea = micros() - tiempoActualAntesLlamada;
-                tarea->sumaMovTiempoEjec += tiempoEjecTarea - tarea->sumaMovTiempoEjec / NUM_MUESTRAS_SUMA_SCHEDULER;
-                tarea->tiempoEjecucionTotal += tiempoEjecTarea;   // Tiempo consumido por el scheduler + tarea
-                tarea->tiempoMaxEjecucion = MAX(tarea->tiempoMaxEjecucion, tiempoEjecTarea);
-                t1 = t1 + tiempoEjecTarea;
-                if (tarea->cntHist < 100) {
-                    tarea->periodoHist[tarea->cntHist] = tarea->ultimoPeriodoEjec;
-                    tarea->cntHist++;
-
-                    if (tarea->cntHist == 100) {
-                    	if (tarea->calc) {
-							float tau = 0.0;
-							float dif[100];
-							for (uint32_t cnt = 0; cnt < 100; cnt++) {
-								dif[cnt] = (float)(tarea->periodo - tarea->periodoHist[cnt]);
-								tau = tau + (dif[cnt] * dif[cnt]);
-							}
-
-							tau = sqrt(tau) / 100;
-							if (tau > tarea->tau)
-								tarea->tau = tau;
-                    	}
-                    	tarea->cntHist = 0;
-                    	tarea->calc = true;
-                    }
-                }
+                actualizarEstadisticasTarea(tarea, tiempoEjecTarea);
             }
             else
 #endif
@@ -476,30 +726,7 @@ CODIGO_RAPIDO void scheduler(void)
 
                 tareaSeleccionada->funTarea(tiempoActualAntesLlamada);
                 const uint32_t tiempoEjecTarea = micros() - tiempoActualAntesLlamada;
-                tareaSeleccionada->sumaMovTiempoEjec += tiempoEjecTarea - tareaSeleccionada->sumaMovTiempoEjec / NUM_MUESTRAS_SUMA_SCHEDULER;
-                tareaSeleccionada->tiempoEjecucionTotal += tiempoEjecTarea;   // Tiempo consumido por el scheduler + tarea
-                tareaSeleccionada->tiempoMaxEjecucion = MAX(tareaSeleccionada->tiempoMaxEjecucion, tiempoEjecTarea);
-                if (tareaSeleccionada->cntHist < 100){
-                    tareaSeleccionada->periodoHist[tareaSeleccionada->cntHist] = tareaSeleccionada->ultimoPeriodoEjec;
-                    tareaSeleccionada->cntHist++;
-                    if (tareaSeleccionada->cntHist == 100) {
-                    	if (tareaSeleccionada->calc) {
-							float tau = 0.0;
-							float dif[100];
-							for (uint32_t cnt = 0; cnt < 100; cnt++) {
-								dif[cnt] = (float)(tareaSeleccionada->periodo - tareaSeleccionada->periodoHist[cnt]);
-								tau = tau + (dif[cnt] * dif[cnt]);
-							}
-
-							tau = sqrt(tau) / 100;
-							if (tau > tareaSeleccionada->tau)
-							tareaSeleccionada->tau = tau;
-                    	}
-                    	tareaSeleccionada->cntHist = 0;
-                    	tareaSeleccionada->calc = true;
-                    }
-                }
-                t2 = t2 + tiempoEjecTarea;
+                actualizarEstadisticasTarea(tareaSeleccionada, tiempoEjecTarea);
             }
             else
 #endif
@@ -507,4 +734,4 @@ CODIGO_RAPIDO void scheduler(void)
         }
     }
 }
-
+#endif
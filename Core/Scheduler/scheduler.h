@@ -38,11 +38,14 @@
 ** AREA DE PREPROCESADOR                                                              **
 ****************************************************************************************/
 #define INTERVALO_GUARDA_TIEMPO_REAL        50                     // Tiempo en us
+#define USAR_SCHEDULER_DEADLINE                                    // Despacho por vencimiento en lugar del recorrido lineal de la cola
 
 #define PERIODO_TAREA_HZ_SCHEDULER(hz)      (1000000 / (hz))
 #define PERIODO_TAREA_MS_SCHEDULER(ms)      ((ms) * 1000)
 #define PERIODO_TAREA_US_SCHEDULER(us)      (us)
 
+#define NUM_CUBETAS_HIST_TAREA              16                     // Cubeta k: valores en [2^(k-1), 2^k) us. La ultima acumula el resto
+
 
 /***************************************************************************************
 ** AREA DE DEFINICION DE TIPOS                                                        **
@@ -67,8 +70,18 @@ typedef struct {
     uint32_t tiempoMaxEjecucion;
     uint32_t tiempoEjecucionTotal;
     uint32_t tiempoEjecucionMedio;
+    uint32_t tiempoEjecucionP50;
+    uint32_t tiempoEjecucionP99;
+    uint32_t errorPeriodoP50;
+    uint32_t errorPeriodoP99;
+    uint32_t errorPeriodoMax;
 } infoTarea_t;
 
+typedef struct {
+    uint32_t cubetas[NUM_CUBETAS_HIST_TAREA];
+    uint32_t max;
+} histogramaTarea_t;
+
 typedef enum {
 	TAREA_SCHEDULER = 0,
     TAREA_STACK,
@@ -93,6 +106,7 @@ typedef enum {
     TAREA_LEER_IMU,
     TAREA_ACTUALIZAR_CALIBRADOR_ACELEROMETRO,
     TAREA_ACTUALIZAR_CALIBRADOR_GIROSCOPIO,
+    TAREA_ACTUALIZAR_NOTCH_DINAMICO,
 #endif
 #ifdef USAR_GPS
     TAREA_LEER_GPS,
@@ -123,18 +137,19 @@ typedef struct {
     uint16_t edadCiclosTarea;
     int32_t ultimoPeriodoEjec;           // Ultima periodo de ejecucion
     uint32_t ultimoTiempoEjec;           // Ultimo tiempo de invocacion
+#if defined(USAR_SCHEDULER_DEADLINE)
+    uint32_t vencimiento;                // Proximo tiempo de invocacion, clave del monticulo
+    uint8_t posMonticulo;                // Posicion de la tarea en su monticulo
+#endif
 
 #if defined(USAR_ESTADISTICAS_TAREAS)
     // Estadisticas
     uint64_t sumaMovTiempoEjec;          // Suma sobre 32 muestras
     uint64_t tiempoMaxEjecucion;
     uint64_t tiempoEjecucionTotal;       // tiempo total consumido por la tarea desde el encendido
+    histogramaTarea_t histTiempoEjec;    // Histogramas log2 en us. Solo los escribe el scheduler
+    histogramaTarea_t histErrorPeriodo;
 #endif
-
-    int32_t periodoHist[100];
-    uint32_t cntHist;
-    float tau;
-    bool calc;
 } tarea_t;
 
 
@@ -158,6 +173,7 @@ void deshabilitarEstadisticasScheduler(void);
 void infoTarea(idTarea_e idTarea, infoTarea_t *infoTarea);
 void resetearEstadisticasTarea(idTarea_e idTarea);
 void resetearTiempoMaxEjecTarea(idTarea_e idTarea);
+uint32_t volcarEstadisticasTareas(char *buffer, uint32_t tam);
 void scheduler(void);
 
 #endif // __SCHEDULER_H
@@ -50,6 +50,7 @@
 #include "Sensores/Calibrador/calibrador_mag.h"
 #include "GP/gp_calibrador.h"
 #include "Telemetria/telemetria.h"
+#include "GP/gp_telemetria.h"
 
 
 /***************************************************************************************
@@ -173,6 +174,13 @@ tarea_t tareas[TAREA_CONTADOR] = {
         .periodo = PERIODO_TAREA_HZ_SCHEDULER(FREC_ACTUALIZAR_CALIBRADOR_IMU_HZ),
         .prioridadEstatica = PRIORIDAD_BAJA,
     },
+    [TAREA_ACTUALIZAR_NOTCH_DINAMICO] = {
+        .nombreTarea = "ACTUALIZAR NOTCH DINAMICO",
+        .subNombreTarea = "SENSORES",
+        .funTarea = actualizarNotchDinamicoIMU,
+        .periodo = PERIODO_TAREA_HZ_SCHEDULER(FREC_ACTUALIZAR_NOTCH_DINAMICO_HZ),
+        .prioridadEstatica = PRIORIDAD_MEDIA,
+    },
 #endif
 #ifdef USAR_GPS
     [TAREA_LEER_GPS] = {
@@ -220,13 +228,15 @@ tarea_t tareas[TAREA_CONTADOR] = {
         .periodo = PERIODO_TAREA_HZ_SCHEDULER(FREC_ACTUALIZAR_POSICION_FC_HZ),
         .prioridadEstatica = PRIORIDAD_ALTA,
     },
+#ifdef USAR_TELEMETRIA
     [TAREA_ACTUALIZAR_TELEMETRIA] = {
         .nombreTarea = "ACTUALIZAR TELEMETRIA",
         .subNombreTarea = "TELEMETRIA",
         .funTarea = actualizarTelemetria,
-        .periodo = PERIODO_TAREA_HZ_SCHEDULER(200),
+        .periodo = PERIODO_TAREA_HZ_SCHEDULER(FREC_ACTUALIZAR_TELEMETRIA_HZ),
         .prioridadEstatica = PRIORIDAD_MEDIA_ALTA,
     },
+#endif
 };
 
 
@@ -266,6 +276,8 @@ void iniciarTareas(void)
   #ifdef LEER_IMU_SCHEDULER
     anadirTareaEnCola(&tareas[TAREA_LEER_IMU]);
   #endif
+    if (configNotchDinamico()->habilitado)
+        anadirTareaEnCola(&tareas[TAREA_ACTUALIZAR_NOTCH_DINAMICO]);
 #endif
 
 #ifdef USAR_BARO
@@ -298,7 +310,9 @@ void iniciarTareas(void)
     anadirTareaEnCola(&tareas[TAREA_ACTUALIZAR_ACTITUD_FC]);
     anadirTareaEnCola(&tareas[TAREA_ACTUALIZAR_POSICION_FC]);
 
+#ifdef USAR_TELEMETRIA
     anadirTareaEnCola(&tareas[TAREA_ACTUALIZAR_TELEMETRIA]);
+#endif
 }
 
 
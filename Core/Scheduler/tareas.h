@@ -33,7 +33,7 @@
 #include <stdbool.h>
 
 #include "Sistema/plataforma.h"
-#include "Scheduler.h"
+#include "scheduler.h"
 
 
 /***************************************************************************************
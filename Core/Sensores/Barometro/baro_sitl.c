@@ -0,0 +1,144 @@
+/***************************************************************************************
+**  baro_sitl.c - Funciones del barometro simulado en SITL
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <string.h>
+
+#include "barometro.h"
+
+#if defined(USAR_BARO) && defined(SITL)
+#include "Drivers/tiempo.h"
+#include "SITL/modelo_quad.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    acumulador_t acumuladorP;
+    acumulador_t acumuladorT;
+} baroSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static baroSITL_t baroSITL[NUM_MAX_BARO];
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool iniciarBaroSITL(baro_t *dBaro);
+void leerBaroSITL(baro_t *dBaro);
+void actualizarBaroSITL(baro_t *dBaro);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool iniciarBaroSITL(baro_t *dBaro)
+**  Descripcion:    Inicia el barometro
+**  Parametros:     Puntero al barometro
+**  Retorno:        True si ok
+****************************************************************************************/
+bool iniciarBaroSITL(baro_t *dBaro)
+{
+    baroSITL_t *driver = &baroSITL[dBaro->numBaro];
+    dBaro->driver = driver;
+
+    memset(driver, 0, sizeof(*driver));
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void leerBaroSITL(baro_t *dBaro)
+**  Descripcion:    Lee la presion y la temperatura acumuladas
+**  Parametros:     Puntero al barometro
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerBaroSITL(baro_t *dBaro)
+{
+    baroSITL_t *driver = dBaro->driver;
+    const uint32_t tiempo = micros();
+
+    if (driver->acumuladorP.contador == 0)
+        return;
+
+    const float presion = driver->acumuladorP.acumulado / driver->acumuladorP.contador;
+    const float temperatura = driver->acumuladorT.acumulado / driver->acumuladorT.contador;
+    memset(&driver->acumuladorP, 0, sizeof(driver->acumuladorP));
+    memset(&driver->acumuladorT, 0, sizeof(driver->acumuladorT));
+
+    if (dBaro->presion != presion)
+        dBaro->timing.ultimoCambio = tiempo;
+
+    dBaro->presion = presion;
+    dBaro->temperatura = temperatura;
+    dBaro->timing.ultimaMedida = tiempo;
+    dBaro->nuevaMedida = true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void actualizarBaroSITL(baro_t *dBaro)
+**  Descripcion:    Toma una muestra del modelo
+**  Parametros:     Puntero al barometro
+**  Retorno:        Ninguno
+****************************************************************************************/
+void actualizarBaroSITL(baro_t *dBaro)
+{
+    baroSITL_t *driver = dBaro->driver;
+    const float presion = presionModeloQuad();
+
+    dBaro->timing.ultimaActualizacion = micros();
+
+    if (presionBaroOk(dBaro, presion)) {
+        acumularLectura(&driver->acumuladorP, presion, 100);
+        acumularLectura(&driver->acumuladorT, temperaturaModeloQuad(), 100);
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         tablaFnBaro_t tablaFnBaroSITL
+**  Descripcion:    Tabla de funciones del barometro simulado
+****************************************************************************************/
+tablaFnBaro_t tablaFnBaroSITL = {
+    iniciarBaroSITL,
+    leerBaroSITL,
+    actualizarBaroSITL,
+};
+
+#endif
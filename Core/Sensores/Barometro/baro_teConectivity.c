@@ -58,17 +58,88 @@
 #define CMD_ADC_T_RES_3_BARO_TEC         0x56
 #define CMD_ADC_T_RES_4_BARO_TEC         0x58
 
+/*
+ * Cada baro lanza su siguiente conversion justo despues de leer el ADC y guarda cuando
+ * termina segun el OSR, asi las conversiones de todos los baros corren a la vez mientras
+ * el bus solo se usa para la lectura y el comando. La tarea se despierta en el vencimiento
+ * (ver actualizarBaro). Con cada temperatura se recalculan en enteros de 64 bits los
+ * terminos de la compensacion del datasheet, y en cada lectura solo queda la presion
+ */
+#define OSR_BARO_TEC                     OSR_2048_BARO_TEC
+#define PRESIONES_POR_TEMP_BARO_TEC      4       // Conversiones de presion por cada una de temperatura
+#define MAX_MUESTRAS_BARO_TEC            100
+
+/*
+ * Por SPI la lectura del ADC y el comando de la siguiente conversion van por la cola de
+ * transacciones: la tarea encola la lectura, el callback encadena el comando y fija el
+ * vencimiento, y la tarea procesa el resultado en la siguiente ejecucion. Los buffers
+ * ocupan una linea de cache entera para el mantenimiento de la cache del DMA
+ */
+#define TAM_BUFFER_BUS_BARO_TEC          32
+
 
 /***************************************************************************************
 ** AREA DE DEFINICION DE TIPOS                                                        **
 ****************************************************************************************/
+typedef enum {
+    OSR_256_BARO_TEC = 0,
+    OSR_512_BARO_TEC,
+    OSR_1024_BARO_TEC,
+    OSR_2048_BARO_TEC,
+    OSR_4096_BARO_TEC,
+} osrBaroTEConectivity_e;
+
+typedef struct {
+    uint8_t comandoP, comandoT;
+    uint16_t tiempoConversion;           // Tiempo maximo del datasheet en us
+} defOsrBaroTEConectivity_t;
+
+#ifdef USAR_COLA_SPI
+typedef enum {
+    BUS_BARO_TEC_LIBRE = 0,
+    BUS_BARO_TEC_LECTURA,                // Leyendo el ADC
+    BUS_BARO_TEC_COMANDO,                // Lanzando la siguiente conversion
+    BUS_BARO_TEC_DATOS,                  // Lectura pendiente de procesar por la tarea
+    BUS_BARO_TEC_ERROR,
+} faseBusBaroTEConectivity_e;
+#endif
+
 typedef struct {
     uint8_t comandoP, comandoT;
+    uint16_t tiempoConversion;
     uint16_t prom[8];
-    float presionRaw, temperaturaRaw;
-    acumulador_t acumuladorP, acumuladorT;
-    uint8_t estado;
-    bool descartarLect;        // Si la lectura del ADC es erronea descartamos la siguiente lectura
+
+    // Coeficientes de la PROM escalados como en el datasheet
+    int64_t sensT1;                      // C1 * 2^15
+    int64_t offT1;                       // C2 * 2^16
+    int64_t tcs;                         // C3
+    int64_t tco;                         // C4
+    int32_t tref;                        // C5 * 2^8
+    int64_t tempsens;                    // C6
+
+    // Compensacion con la ultima temperatura
+    bool temperaturaValida;
+    int32_t temp;                        // Temperatura en 0.01 ºC
+    int64_t off, sens;
+
+    // Presiones sin compensar desde la ultima lectura
+    uint32_t sumaD1;
+    uint8_t cuentaD1;
+
+    uint8_t fase;                        // Conversion en curso. 0 temperatura, el resto presion
+    uint32_t erroresAdc;
+#ifdef USAR_COLA_SPI
+    // Lectura asincrona del ADC. El callback de la lectura encadena el comando
+    uint8_t txBus[TAM_BUFFER_BUS_BARO_TEC] __attribute__((aligned(32)));
+    uint8_t rxBus[TAM_BUFFER_BUS_BARO_TEC] __attribute__((aligned(32)));
+    transaccionBus_t transaccion;
+    segmentoBus_t segmento;
+    volatile faseBusBaroTEConectivity_e faseBus;
+    bool usarCola;
+    uint32_t adcLeido;                   // 0 si la lectura no es valida
+    uint8_t faseLeida;                   // Conversion a la que corresponde la lectura
+    uint32_t tiempoLectura;
+#endif
 } baroTEConectivity_t;
 
 
@@ -77,6 +148,14 @@ typedef struct {
 ****************************************************************************************/
 static baroTEConectivity_t baroTEConectivity[NUM_MAX_BARO];
 
+static const defOsrBaroTEConectivity_t defOsrBaroTEConectivity[] = {
+    [OSR_256_BARO_TEC]  = {CMD_ADC_P_RES_0_BARO_TEC, CMD_ADC_T_RES_0_BARO_TEC, 600},
+    [OSR_512_BARO_TEC]  = {CMD_ADC_P_RES_1_BARO_TEC, CMD_ADC_T_RES_1_BARO_TEC, 1170},
+    [OSR_1024_BARO_TEC] = {CMD_ADC_P_RES_2_BARO_TEC, CMD_ADC_T_RES_2_BARO_TEC, 2280},
+    [OSR_2048_BARO_TEC] = {CMD_ADC_P_RES_3_BARO_TEC, CMD_ADC_T_RES_3_BARO_TEC, 4540},
+    [OSR_4096_BARO_TEC] = {CMD_ADC_P_RES_4_BARO_TEC, CMD_ADC_T_RES_4_BARO_TEC, 9040},
+};
+
 
 /***************************************************************************************
 ** AREA DE PROTOTIPOS DE FUNCION                                                      **
@@ -87,9 +166,16 @@ void resetearBaroTEConectivity(bus_t *bus);
 bool leerPromBaroTEConectivity(bus_t *bus, uint16_t *prom);
 bool leerWordPromBaroTEConectivity(bus_t *bus, uint8_t word, uint16_t *dato);
 bool leerAdcBaroTEConectivity(bus_t *bus, uint32_t *adc);
+void prepararCoeficientesBaroTEConectivity(baroTEConectivity_t *driver);
 void leerBaroTEConectivity(baro_t *dBaro);
 void actualizarBaroTEConectivity(baro_t *dBaro);
-void calcularBaroTEConectivity(baro_t *dBaro);
+void procesarAdcBaroTEConectivity(baro_t *dBaro, uint8_t fase, uint32_t valorAdc);
+#ifdef USAR_COLA_SPI
+void actualizarAsincronoBaroTEConectivity(baro_t *dBaro);
+void callbackBusBaroTEConectivity(transaccionBus_t *transaccion, bool ok);
+#endif
+void compensarTemperaturaBaroTEConectivity(baroTEConectivity_t *driver, uint32_t d2);
+void calcularBaroTEConectivity(baro_t *dBaro, uint32_t d1);
 
 
 /***************************************************************************************
@@ -121,12 +207,28 @@ bool iniciarBaroTEConectivity(baro_t *dBaro)
     if (!leerPromBaroTEConectivity(&dBaro->bus, driver->prom))
         return false;
 
-    driver->comandoP = CMD_ADC_P_RES_3_BARO_TEC;
-    driver->comandoT = CMD_ADC_T_RES_3_BARO_TEC;
+    prepararCoeficientesBaroTEConectivity(driver);
+
+#ifdef USAR_COLA_SPI
+    driver->usarCola = dBaro->bus.tipo == BUS_SPI;
+    driver->transaccion.bus = &dBaro->bus;
+    driver->transaccion.segmentos = &driver->segmento;
+    driver->transaccion.numSegmentos = 1;
+    driver->transaccion.callback = callbackBusBaroTEConectivity;
+    driver->transaccion.datoCallback = dBaro;
+    driver->segmento.datoTx = driver->txBus;
+    driver->segmento.datoRx = driver->rxBus;
+    driver->segmento.liberarCS = true;
+#endif
+
+    driver->comandoP = defOsrBaroTEConectivity[OSR_BARO_TEC].comandoP;
+    driver->comandoT = defOsrBaroTEConectivity[OSR_BARO_TEC].comandoT;
+    driver->tiempoConversion = defOsrBaroTEConectivity[OSR_BARO_TEC].tiempoConversion;
 
     // Enviamos el comando de lectura de la temperatura
-    escribirRegistroBus(&dBaro->bus, driver->comandoP, 1);
-    delay(10);
+    driver->fase = 0;
+    escribirRegistroBus(&dBaro->bus, driver->comandoT, 1);
+    dBaro->timing.proximaActualizacion = micros() + driver->tiempoConversion;
 
     return true;
 }
@@ -219,132 +321,262 @@ bool leerAdcBaroTEConectivity(bus_t *bus, uint32_t *adc)
 }
 
 
+/***************************************************************************************
+**  Nombre:         void prepararCoeficientesBaroTEConectivity(baroTEConectivity_t *driver)
+**  Descripcion:    Escala los coeficientes de la PROM para la compensacion
+**  Parametros:     Driver TEConectivity
+**  Retorno:        Ninguno
+****************************************************************************************/
+void prepararCoeficientesBaroTEConectivity(baroTEConectivity_t *driver)
+{
+    driver->sensT1 = (int64_t)driver->prom[1] << 15;
+    driver->offT1 = (int64_t)driver->prom[2] << 16;
+    driver->tcs = driver->prom[3];
+    driver->tco = driver->prom[4];
+    driver->tref = (int32_t)driver->prom[5] << 8;
+    driver->tempsens = driver->prom[6];
+}
+
+
 /***************************************************************************************
 **  Nombre:         void leerBaroTEConectivity(baro_t *dBaro)
-**  Descripcion:    Lee la presion y la temperatura
+**  Descripcion:    Calcula la presion con la media de las conversiones desde la ultima
+**                  lectura y la ultima temperatura
 **  Parametros:     Puntero al barometro
 **  Retorno:        Ninguno
 ****************************************************************************************/
 void leerBaroTEConectivity(baro_t *dBaro)
 {
-    uint32_t aP, aT;
-    uint8_t cuentaP, cuentaT;
     baroTEConectivity_t *driver = dBaro->driver;
 
-    if (driver->acumuladorP.contador == 0)
+    if (driver->cuentaD1 == 0 || !driver->temperaturaValida)
         return;
 
-    aP = driver->acumuladorP.acumulado;
-    aT = driver->acumuladorT.acumulado;
-    cuentaP = driver->acumuladorP.contador;
-    cuentaT = driver->acumuladorT.contador;
-    memset(&driver->acumuladorP, 0, sizeof(driver->acumuladorP));
-    memset(&driver->acumuladorT, 0, sizeof(driver->acumuladorT));
-
-    if (cuentaP != 0)
-        driver->presionRaw = ((float)aP) / cuentaP;
+    const uint32_t d1 = (driver->sumaD1 + driver->cuentaD1 / 2) / driver->cuentaD1;
+    driver->sumaD1 = 0;
+    driver->cuentaD1 = 0;
 
-    if (cuentaT != 0)
-        driver->temperaturaRaw = ((float)aT) / cuentaT;
-
-    if (cuentaP != 0 || cuentaT != 0) {
-        calcularBaroTEConectivity(dBaro);
-        dBaro->nuevaMedida = true;
-    }
+    calcularBaroTEConectivity(dBaro, d1);
+    dBaro->nuevaMedida = true;
 }
 
 
 /***************************************************************************************
 **  Nombre:         void actualizarBaroTEConectivity(baro_t *dBaro)
-**  Descripcion:    Actualiza las lecturas del barometro
+**  Descripcion:    Si ha terminado la conversion lee el ADC y lanza la siguiente
 **  Parametros:     Puntero al barometro
 **  Retorno:        Ninguno
 ****************************************************************************************/
 void actualizarBaroTEConectivity(baro_t *dBaro)
 {
     baroTEConectivity_t *driver = dBaro->driver;
-    uint8_t sigComando;
-    uint8_t sigEstado;
-    uint32_t valorAdc;
+    uint32_t valorAdc = 0;
 
-    bool estado = leerAdcBaroTEConectivity(&dBaro->bus, &valorAdc);
+#ifdef USAR_COLA_SPI
+    if (driver->usarCola) {
+        actualizarAsincronoBaroTEConectivity(dBaro);
+        return;
+    }
+#endif
 
-    if (valorAdc == 0 || estado == false)
-        sigEstado = driver->estado;
-    else
-        sigEstado = (driver->estado + 1) % 5;
+    // Un comando durante la conversion la estropea
+    if ((int32_t)(micros() - dBaro->timing.proximaActualizacion) < 0)
+        return;
 
-    // Enviamos el comando que toque
-    sigComando = sigEstado == 0 ? driver->comandoT : driver->comandoP;
-    escribirRegistroBus(&dBaro->bus, sigComando, 1);
+    const bool lecturaOk = leerAdcBaroTEConectivity(&dBaro->bus, &valorAdc) && valorAdc != 0;
+    const uint8_t fase = driver->fase;
 
-    // Si la medida ha sido mala descartamos la siguiente
-    if (valorAdc == 0 || estado == false) {
-        driver->descartarLect = true;
+    // Si la lectura es mala se repite la misma conversion
+    if (lecturaOk)
+        driver->fase = (fase + 1) % (PRESIONES_POR_TEMP_BARO_TEC + 1);
+
+    // La siguiente conversion se lanza antes de procesar la lectura
+    escribirRegistroBus(&dBaro->bus, driver->fase == 0 ? driver->comandoT : driver->comandoP, 1);
+    const uint32_t tiempo = micros();
+    dBaro->timing.proximaActualizacion = tiempo + driver->tiempoConversion;
+
+    if (!lecturaOk) {
+        driver->erroresAdc++;
         return;
     }
 
-    if (driver->descartarLect) {
-        driver->descartarLect = false;
-        driver->estado = sigEstado;
-        return;
+    dBaro->timing.ultimaActualizacion = tiempo;
+    procesarAdcBaroTEConectivity(dBaro, fase, valorAdc);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void procesarAdcBaroTEConectivity(baro_t *dBaro, uint8_t fase, uint32_t valorAdc)
+**  Descripcion:    Recalcula la compensacion con una temperatura o acumula una presion
+**  Parametros:     Puntero al barometro, conversion leida, valor del ADC
+**  Retorno:        Ninguno
+****************************************************************************************/
+void procesarAdcBaroTEConectivity(baro_t *dBaro, uint8_t fase, uint32_t valorAdc)
+{
+    baroTEConectivity_t *driver = dBaro->driver;
+
+    if (fase == 0)
+        compensarTemperaturaBaroTEConectivity(driver, valorAdc);
+    else if (presionBaroOk(dBaro, valorAdc)) {
+        driver->sumaD1 += valorAdc;
+        driver->cuentaD1++;
+
+        if (driver->cuentaD1 == MAX_MUESTRAS_BARO_TEC) {
+            driver->sumaD1 /= 2;
+            driver->cuentaD1 /= 2;
+        }
     }
+}
 
-    dBaro->timing.ultimaActualizacion = micros();
 
-    if (driver->estado == 0)
-        acumularLectura(&driver->acumuladorT, (float)valorAdc, 100);
-    else if (presionBaroOk(dBaro, valorAdc))
-        acumularLectura(&driver->acumuladorP, (float)valorAdc, 100);
+#ifdef USAR_COLA_SPI
+/***************************************************************************************
+**  Nombre:         void actualizarAsincronoBaroTEConectivity(baro_t *dBaro)
+**  Descripcion:    Procesa la lectura que dejo la transaccion anterior y, si ha terminado
+**                  la conversion, encola la lectura del ADC
+**  Parametros:     Puntero al barometro
+**  Retorno:        Ninguno
+****************************************************************************************/
+void actualizarAsincronoBaroTEConectivity(baro_t *dBaro)
+{
+    baroTEConectivity_t *driver = dBaro->driver;
+
+    switch (driver->faseBus) {
+        case BUS_BARO_TEC_LECTURA:
+        case BUS_BARO_TEC_COMANDO:
+            // Transferencia en curso
+            return;
+
+        case BUS_BARO_TEC_DATOS:
+            dBaro->timing.ultimaActualizacion = driver->tiempoLectura;
+            procesarAdcBaroTEConectivity(dBaro, driver->faseLeida, driver->adcLeido);
+            break;
+
+        case BUS_BARO_TEC_ERROR:
+            driver->erroresAdc++;
+            break;
+
+        default:
+            break;
+    }
+
+    driver->faseBus = BUS_BARO_TEC_LIBRE;
 
-    driver->estado = sigEstado;
+    // Un comando durante la conversion la estropea
+    if ((int32_t)(micros() - dBaro->timing.proximaActualizacion) < 0)
+        return;
+
+    // Vencimiento provisional hasta que el callback lance la conversion
+    dBaro->timing.proximaActualizacion = micros() + driver->tiempoConversion;
+
+    driver->faseBus = BUS_BARO_TEC_LECTURA;
+    driver->txBus[0] = CMD_ADC_READ_BARO_TEC;
+    driver->segmento.longitud = 4;
+
+    if (!encolarTransaccionBus(&driver->transaccion))
+        driver->faseBus = BUS_BARO_TEC_ERROR;
 }
 
 
 /***************************************************************************************
-**  Nombre:         void calcularBaroTEConectivity(baro_t *dBaro)
-**  Descripcion:    Compensa las lecturas con los valores de calibracion
-**  Parametros:     Driver TEConectivity
+**  Nombre:         void callbackBusBaroTEConectivity(transaccionBus_t *transaccion, bool ok)
+**  Descripcion:    Al terminar la lectura encola el comando de la siguiente conversion. Al
+**                  terminar el comando fija el vencimiento y deja la lectura para la
+**                  tarea. Se ejecuta en la interrupcion del DMA
+**  Parametros:     Transaccion, resultado
 **  Retorno:        Ninguno
 ****************************************************************************************/
-void calcularBaroTEConectivity(baro_t *dBaro)
+void callbackBusBaroTEConectivity(transaccionBus_t *transaccion, bool ok)
 {
+    baro_t *dBaro = transaccion->datoCallback;
     baroTEConectivity_t *driver = dBaro->driver;
-    float presion, temperatura;
-    uint32_t tiempo = micros();
-
-    float dT;
-    float TEMP;
-    float OFF;
-    float SENS;
-
-    // Formulas del datasheet
-    // No esta incluida la compensacion a -15ºC
-
-    // Vamos a realizar los calculos con flotantes para mayor rapidez y precision
-    dT = driver->temperaturaRaw - (((uint32_t) driver->prom[5]) << 8);
-    TEMP = (dT * driver->prom[6]) / 8388608;
-    OFF = driver->prom[2] * 65536.0f + (driver->prom[4] * dT) / 128;
-    SENS = driver->prom[1] * 32768.0f + (driver->prom[3] * dT) / 256;
-
-    if (TEMP < 0) {
-        // Compensacion de segundo orden cuando estamos a menos de 20ºC
-        float T2 = (dT * dT) / 0x80000000;
-        float Aux = TEMP * TEMP;
-        float OFF2 = 2.5f * Aux;
-        float SENS2 = 1.25f * Aux;
-        TEMP = TEMP - T2;
-        OFF = OFF - OFF2;
-        SENS = SENS - SENS2;
+
+    if (driver->faseBus == BUS_BARO_TEC_COMANDO) {
+        const uint32_t tiempo = microsISR();
+
+        // Sin conversion en marcha se vuelve a leer cuanto antes y la lectura dara error
+        dBaro->timing.proximaActualizacion = ok ? tiempo + driver->tiempoConversion : tiempo;
+        driver->tiempoLectura = tiempo;
+        driver->faseBus = driver->adcLeido != 0 ? BUS_BARO_TEC_DATOS : BUS_BARO_TEC_ERROR;
+        return;
+    }
+
+    // Si la lectura es mala se repite la misma conversion
+    driver->adcLeido = ok ? (driver->rxBus[1] << 16) | (driver->rxBus[2] << 8) | driver->rxBus[3] : 0;
+    driver->faseLeida = driver->fase;
+    if (driver->adcLeido != 0)
+        driver->fase = (driver->fase + 1) % (PRESIONES_POR_TEMP_BARO_TEC + 1);
+
+    driver->faseBus = BUS_BARO_TEC_COMANDO;
+    driver->txBus[0] = driver->fase == 0 ? driver->comandoT : driver->comandoP;
+    driver->segmento.longitud = 1;
+
+    if (!encolarTransaccionBus(transaccion)) {
+        dBaro->timing.proximaActualizacion = microsISR();
+        driver->faseBus = BUS_BARO_TEC_ERROR;
+    }
+}
+#endif
+
+
+/***************************************************************************************
+**  Nombre:         void compensarTemperaturaBaroTEConectivity(baroTEConectivity_t *driver, uint32_t d2)
+**  Descripcion:    Calcula la temperatura y los terminos de la compensacion de la presion
+**                  con las formulas enteras del datasheet, incluido el segundo orden
+**  Parametros:     Driver TEConectivity, valor del ADC de la temperatura
+**  Retorno:        Ninguno
+****************************************************************************************/
+void compensarTemperaturaBaroTEConectivity(baroTEConectivity_t *driver, uint32_t d2)
+{
+    const int64_t dT = (int32_t)d2 - driver->tref;
+    int32_t temp = 2000 + (dT * driver->tempsens) / 8388608;
+    int64_t off = driver->offT1 + (driver->tco * dT) / 128;
+    int64_t sens = driver->sensT1 + (driver->tcs * dT) / 256;
+
+    // Segundo orden por debajo de 20ºC y de -15ºC
+    if (temp < 2000) {
+        const int64_t t2 = (dT * dT) / 2147483648LL;
+        const int64_t bajo = (int64_t)(temp - 2000) * (temp - 2000);
+        int64_t off2 = 5 * bajo / 2;
+        int64_t sens2 = 5 * bajo / 4;
+
+        if (temp < -1500) {
+            const int64_t muyBajo = (int64_t)(temp + 1500) * (temp + 1500);
+            off2 += 7 * muyBajo;
+            sens2 += 11 * muyBajo / 2;
+        }
+
+        temp -= t2;
+        off -= off2;
+        sens -= sens2;
     }
-    presion = ((driver->presionRaw * SENS / 2097152 - OFF) / 32768) * 0.01f;     // Presion en mBar
-    temperatura = (TEMP + 2000) * 0.01f;                                         // Temperatura en ºC
+
+    driver->temp = temp;
+    driver->off = off;
+    driver->sens = sens;
+    driver->temperaturaValida = true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void calcularBaroTEConectivity(baro_t *dBaro, uint32_t d1)
+**  Descripcion:    Compensa la presion con los terminos de la ultima temperatura
+**  Parametros:     Puntero al barometro, valor del ADC de la presion
+**  Retorno:        Ninguno
+****************************************************************************************/
+void calcularBaroTEConectivity(baro_t *dBaro, uint32_t d1)
+{
+    baroTEConectivity_t *driver = dBaro->driver;
+    const uint32_t tiempo = micros();
+
+    const int32_t p = ((int64_t)d1 * driver->sens / 2097152 - driver->off) / 32768;
+    const float presion = p * 0.01f;                                             // Presion en mBar
 
     if (dBaro->presion != presion)
     	dBaro->timing.ultimoCambio = tiempo;
 
     dBaro->presion = presion;
-    dBaro->temperatura = temperatura;
+    dBaro->temperatura = driver->temp * 0.01f;                                   // Temperatura en ºC
     dBaro->timing.ultimaMedida = tiempo;
 }
 
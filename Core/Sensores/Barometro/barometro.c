@@ -49,6 +49,7 @@
 #define TIMEOUT_CAMBIO_MEDIDA_BARO    500000     // Timeout en us desde la ultima lectura con cambios en las medidas
 
 #define MEZCLADO_MEDIDAS_BARO         1
+#define VENTANA_AGRUPAR_BARO          500        // Los baros que vencen en esta ventana en us se atienden juntos
 
 
 /***************************************************************************************
@@ -163,6 +164,12 @@ bool iniciarBaro(void)
                 tablaFnBaro[i] = &tablaFnBaroBosch;
                 break;
 
+#if defined(SITL)
+            case BARO_SITL:
+                tablaFnBaro[i] = &tablaFnBaroSITL;
+                break;
+#endif
+
             default:
 #ifdef DEBUG
                 printf("Fallo en la definicion del Barometro %u\n", i + 1);
@@ -313,20 +320,48 @@ void leerDriverBaro(baro_t *dBaro)
 
 /***************************************************************************************
 **  Nombre:         bool actualizarBaro(uint32_t tiempoActual)
-**  Descripcion:    Actualiza las muestras de los barometros
+**  Descripcion:    Actualiza los barometros que han vencido y ajusta el periodo de la
+**                  tarea al siguiente vencimiento. Si hay varios baros cerca se espera al
+**                  ultimo de la ventana para atenderlos en la misma ejecucion
 **  Parametros:     Tiempo actual
 **  Retorno:        Ninguno
 ****************************************************************************************/
 void actualizarBaro(uint32_t tiempoActual)
 {
-    UNUSED(tiempoActual);
+    const int32_t periodo = PERIODO_TAREA_HZ_SCHEDULER(configBaro(0)->frecActualizar);
+    int32_t primero = periodo;
+    int32_t espera;
 
     for (uint8_t i = 0; i < NUM_MAX_BARO; i++) {
     	baro_t *driver = &baro[i];
 
-        if (driver->iniciado && (configBaro(i)->drdy == 0 || leerIO(configBaro(i)->drdy)))
+        if (!driver->iniciado || (int32_t)(tiempoActual - driver->timing.proximaActualizacion) < 0)
+            continue;
+
+        const uint32_t proxima = driver->timing.proximaActualizacion;
+
+        if (configBaro(i)->drdy == 0 || leerIO(configBaro(i)->drdy))
             actualizarDriverBaro(driver);
+
+        // Los drivers que no planifican sus conversiones se actualizan con el periodo configurado
+        if (driver->timing.proximaActualizacion == proxima)
+            driver->timing.proximaActualizacion = tiempoActual + periodo;
     }
+
+    for (uint8_t i = 0; i < NUM_MAX_BARO; i++) {
+        if (baro[i].iniciado)
+            primero = MIN(primero, (int32_t)(baro[i].timing.proximaActualizacion - tiempoActual));
+    }
+
+    espera = primero;
+    for (uint8_t i = 0; i < NUM_MAX_BARO; i++) {
+        const int32_t vencimiento = baro[i].timing.proximaActualizacion - tiempoActual;
+
+        if (baro[i].iniciado && vencimiento <= primero + VENTANA_AGRUPAR_BARO)
+            espera = MAX(espera, vencimiento);
+    }
+
+    ajustarFrecuenciaEjecucionTarea(TASK_SELF, MAX(espera, 0));
 }
 
 
@@ -60,12 +60,16 @@ typedef enum {
     BARO_NINGUNO = -1,
     BARO_MS5611  =  0,
     BARO_BMP180,
+#if defined(SITL)
+    BARO_SITL,
+#endif
 } tipoBaro_e;
 
 typedef struct {
     uint32_t ultimaActualizacion;        // Tiempo en us
     uint32_t ultimaMedida;               // Tiempo en us
     uint32_t ultimoCambio;               // Tiempo en us
+    uint32_t proximaActualizacion;       // Tiempo en us. El driver lo adelanta si sabe cuando tiene dato
 } timingBaro_t;
 
 typedef struct {
@@ -99,6 +103,9 @@ typedef struct {
 ****************************************************************************************/
 extern tablaFnBaro_t tablaFnBaroBosch;
 extern tablaFnBaro_t tablaFnBaroTEConectivity;
+#if defined(SITL)
+extern tablaFnBaro_t tablaFnBaroSITL;
+#endif
 
 
 /***************************************************************************************
@@ -35,14 +35,18 @@
 #include "Drivers/tiempo.h"
 #include "Scheduler/tareas.h"
 #include "Comun/matematicas.h"
+#include "Comun/rejilla_hash.h"
+#include "GP/gp_calibrador.h"
 
 
 /***************************************************************************************
 ** AREA DE PREPROCESADOR                                                              **
 ****************************************************************************************/
-#define NUM_MAX_MUESTRAS_MAG_CAL            500
-#define NUM_PARAMETROS_ESFERA_MAG_CAL       4
-#define NUM_PARAMETROS_ELIPSE_MAG_CAL       9
+#define PASOS_PASO_1_CAL_MAG                10       // Iteraciones de esfera
+#define PASOS_ESFERA_PASO_2_CAL_MAG         15
+#define PASOS_PASO_2_CAL_MAG                35       // Las que faltan son de elipse
+#define NUM_CUBETAS_REJILLA_CAL_MAG         512      // Potencia de 2
+#define AMORTIGUAMIENTO_LM_CAL_MAG          10.0f
 #define RADIO_CAMPO_MIN                     150
 #define RADIO_CAMPO_MAX                     950
 #define OFFSET_CAMPO_MAX                    1800
@@ -63,26 +67,20 @@ typedef enum {
 	MAL_RADIO        = 7,
 } estadoCalMag_e;
 
-typedef struct {
-	uint16_t cntMuestras;
-    float magAcum[NUM_MAX_MUESTRAS_MAG_CAL][3];
-} bufferCalMag_t;
-
-typedef struct {
-    uint16_t pasoAjuste;
-    float fitness;
-    float fitnessInicial;
-    float esferaLambda;
-    float elipseLambda;
-} ajusteLM_t;
-
 typedef struct {
     bool iniciado;
     bool terminado;
     bool error;
     numMag_e numMag;
     uint32_t tiempoIni;
+    uint32_t tiempoMuestra;
+    bool filtrando;
+    uint16_t indiceRejilla;
+    uint16_t indiceFiltro;
     bufferCalMag_t buffer;
+    rejillaHash_t rejilla;
+    uint16_t siguientesRejilla[NUM_MAX_MUESTRAS_MAG_CAL];
+    uint16_t cubetasRejilla[NUM_CUBETAS_REJILLA_CAL_MAG];
     calParamMag_t cal;
     ajusteLM_t ajusteLM;
     estadoCalMag_e estado;
@@ -95,27 +93,31 @@ typedef struct {
 calMag_t calMag[NUM_MAX_MAG];
 
 static bool calibradorMagArrancado = false;
+static float factorDistanciaCalMag = 0.0f;
 
 
 /***************************************************************************************
 ** AREA DE PROTOTIPOS DE FUNCION                                                      **
 ****************************************************************************************/
-void cogerMuestraCalMag(calMag_t *calMag);
+void cogerMuestraCalMag(calMag_t *calMag, uint32_t tiempoActual);
 bool ejecutandoCalibracionMag(calMag_t *calMag);
 bool ajustandoCalMAg(calMag_t *calMag);
-void iniciarFitnessCalMAg(calMag_t *calMag);
 void resetearEstadoCalMAg(calMag_t *calMag);
 void ajustarEstadoCalMag(calMag_t *calMag, estadoCalMag_e estado);
 bool comprobarResultadosCalMag(calMag_t *calMag);
-void filtrarMuestrasCalMag(calMag_t *calMag);
+void barajarMuestrasCalMag(calMag_t *calMag);
+void filtrarMuestrasCalMag(calMag_t *calMag, uint16_t numFiltrados);
 bool aceptarMuestraCalMag(calMag_t *calMag, float *muestra, uint16_t indiceIgnorado);
+void calcularFactorDistanciaCalMag(void);
+uint8_t sectorCoberturaCalMag(const float *direccion);
 void calcularOffsetMagInicial(calMag_t *calMag);
-void ajustarEsferaCalMag(calMag_t *calMag);
-void ajustarElipseCalMag(calMag_t *calMag);
-void calcularJacobianoEsfera(float *muestra, calParamMag_t param, float *j);
-void calcularJacobianoElipse(float *muestra, calParamMag_t param, float *j);
-float calcularResiduo(const float *muestra, const calParamMag_t param);
-float calcularResiduoMedioCuadrado(const calParamMag_t param, bufferCalMag_t buffer);
+void acumularAjusteLMMag(ajusteLM_t *ajuste, const calParamMag_t *param, const bufferCalMag_t *buffer, tipoAjusteMag_e tipo, uint16_t fin);
+bool resolverAjusteLMMag(ajusteLM_t *ajuste, const calParamMag_t *param, tipoAjusteMag_e tipo);
+void cargarSistemaLMMag(const ajusteLM_t *ajuste, float lambda, uint8_t dim, float *JTJ1, float *JTJ2, float *delta1, float *delta2);
+void decidirAjusteLMMag(ajusteLM_t *ajuste, calParamMag_t *param, uint16_t numMuestras, tipoAjusteMag_e tipo);
+void calcularJacobianoEsfera(const float *muestra, const calParamMag_t *param, float *j);
+void calcularJacobianoElipse(const float *muestra, const calParamMag_t *param, float *j);
+float calcularResiduo(const float *muestra, const calParamMag_t *param);
 
 
 /***************************************************************************************
@@ -134,6 +136,8 @@ void iniciarCalMag(void)
         return;
 
     calibradorMagArrancado = true;
+    calcularFactorDistanciaCalMag();
+
     uint8_t numSensores = numMagsConectados();
     uint32_t tiempo = millis();
     for (uint8_t i = 0; i < numSensores; i++) {
@@ -158,6 +162,8 @@ void iniciarCalMag(void)
                 driver->buffer.magAcum[j][k] = 0.0;
         }
 
+        iniciarRejillaHash(&driver->rejilla, (const float (*)[3])driver->buffer.magAcum, NUM_MAX_MUESTRAS_MAG_CAL,
+                           driver->siguientesRejilla, driver->cubetasRejilla, NUM_CUBETAS_REJILLA_CAL_MAG);
         ajustarEstadoCalMag(driver, NO_INICIADO);
         driver->estado = ESPERANDO_INICIO;
 	    driver->tiempoIni = tiempo;
@@ -165,7 +171,8 @@ void iniciarCalMag(void)
         driver->iniciado = true;
     }
 
-    // Se arranca la tarea del scheduler
+    // Se arranca la tarea del scheduler. El ajuste le sube la frecuencia mientras dura
+    ajustarFrecuenciaEjecucionTarea(TAREA_ACTUALIZAR_CALIBRADOR_MAGNETOMETRO, PERIODO_TAREA_HZ_SCHEDULER(FREC_ACTUALIZAR_CALIBRADOR_MAG_HZ));
     anadirTareaEnCola(&tareas[TAREA_ACTUALIZAR_CALIBRADOR_MAGNETOMETRO]);
 }
 
@@ -193,14 +200,16 @@ void terminarCalMag(void)
 
 /***************************************************************************************
 **  Nombre:         void actualizarCalMag(uint32_t tiempoActual)
-**  Descripcion:    Actualiza el calibrador del magnetometro
+**  Descripcion:    Actualiza el calibrador del magnetometro. Cada tick hace como mucho un
+**                  tramo del filtrado o del ajuste de cada calibrador
 **  Parametros:     Tiempo actual
 **  Retorno:        Ninguno
 ****************************************************************************************/
 void actualizarCalMag(uint32_t tiempoActual)
 {
     bool todosCalibrados = true;
-    return;
+    bool ajustando = false;
+
     for (uint8_t i = 0; i < NUM_MAX_MAG; i++) {
         calMag_t *driver = &calMag[i];
 
@@ -210,48 +219,66 @@ void actualizarCalMag(uint32_t tiempoActual)
         if (driver->terminado == false || driver->estado != EXITO)
             todosCalibrados = false;
 
-        cogerMuestraCalMag(driver);
+        // El filtrado y el residuo de partida del paso 2 van antes de coger muestras nuevas
+        if (driver->filtrando) {
+            filtrarMuestrasCalMag(driver, MUESTRAS_POR_TICK_CAL_MAG);
+            ajustando = true;
+            continue;
+        }
+
+        if (driver->ajusteLM.fase == FASE_LM_FITNESS) {
+            avanzarAjusteLMMag(&driver->ajusteLM, &driver->cal, &driver->buffer, AJUSTE_ESFERA_MAG, MUESTRAS_POR_TICK_CAL_MAG);
+            ajustando = true;
+            continue;
+        }
+
+        cogerMuestraCalMag(driver, tiempoActual);
 
         // Se rellena el buffer antes de ajustar
         if (!ajustandoCalMAg(driver))
-            return;
+            continue;
+
+        ajustando = true;
 
         if (driver->estado == CORRIENDO_PASO_1) {
-            if (driver->ajusteLM.pasoAjuste >= 10) {
+            if (driver->ajusteLM.pasoAjuste >= PASOS_PASO_1_CAL_MAG) {
                 if ((driver->ajusteLM.fitness == driver->ajusteLM.fitnessInicial) || driver->ajusteLM.fitness == 0.0)
                     ajustarEstadoCalMag(driver, FALLO);
                 else
                 	ajustarEstadoCalMag(driver, CORRIENDO_PASO_2);
             }
             else {
-                if (driver->ajusteLM.pasoAjuste == 0)
+                if (driver->ajusteLM.pasoAjuste == 0 && driver->ajusteLM.fase == FASE_LM_ACUMULAR && driver->ajusteLM.muestra == 0)
                     calcularOffsetMagInicial(driver);
 
-                ajustarEsferaCalMag(driver);
-                driver->ajusteLM.pasoAjuste++;
+                avanzarAjusteLMMag(&driver->ajusteLM, &driver->cal, &driver->buffer, AJUSTE_ESFERA_MAG, MUESTRAS_POR_TICK_CAL_MAG);
             }
         }
         else if (driver->estado == CORRIENDO_PASO_2) {
-            if (driver->ajusteLM.pasoAjuste >= 35) {
+            if (driver->ajusteLM.pasoAjuste >= PASOS_PASO_2_CAL_MAG) {
             	driver->terminado = true;
                 if (comprobarResultadosCalMag(driver))
                     ajustarEstadoCalMag(driver, EXITO);
                 else
                     ajustarEstadoCalMag(driver, FALLO);
             }
-            else if (driver->ajusteLM.pasoAjuste < 15) {
-                ajustarEsferaCalMag(driver);
-                driver->ajusteLM.pasoAjuste++;
-            }
-            else {
-                ajustarElipseCalMag(driver);
-                driver->ajusteLM.pasoAjuste++;
-            }
+            else if (driver->ajusteLM.pasoAjuste < PASOS_ESFERA_PASO_2_CAL_MAG)
+                avanzarAjusteLMMag(&driver->ajusteLM, &driver->cal, &driver->buffer, AJUSTE_ESFERA_MAG, MUESTRAS_POR_TICK_CAL_MAG);
+            else
+                avanzarAjusteLMMag(&driver->ajusteLM, &driver->cal, &driver->buffer, AJUSTE_ELIPSE_MAG, MUESTRAS_POR_TICK_CAL_MAG);
         }
     }
 
-    if (todosCalibrados)
+    if (todosCalibrados) {
         terminarCalMag();
+        return;
+    }
+
+    // Mientras se ajusta se acortan los ticks en lugar de alargarlos
+    if (ajustando)
+        ajustarFrecuenciaEjecucionTarea(TASK_SELF, PERIODO_TAREA_HZ_SCHEDULER(FREC_AJUSTE_CALIBRADOR_MAG_HZ));
+    else
+        ajustarFrecuenciaEjecucionTarea(TASK_SELF, PERIODO_TAREA_HZ_SCHEDULER(FREC_ACTUALIZAR_CALIBRADOR_MAG_HZ));
 }
 
 
@@ -280,16 +307,106 @@ calParamMag_t parametrosCalMAg(uint8_t numCal)
 
 
 /***************************************************************************************
-**  Nombre:         void cogerMuestraCalMag(calMag_t *calMag)
-**  Descripcion:    Coge una muestra del magnetometro para el calibrador
-**  Parametros:     Puntero al calibrador
+**  Nombre:         uint8_t progresoCalMag(uint8_t numCal)
+**  Descripcion:    Devuelve el progreso de la calibracion. La primera mitad es el llenado
+**                  del buffer y la segunda las iteraciones del ajuste
+**  Parametros:     Numero del calibrador
+**  Retorno:        Progreso en %
+****************************************************************************************/
+uint8_t progresoCalMag(uint8_t numCal)
+{
+    const calMag_t *driver = &calMag[numCal];
+    uint16_t pasos = driver->ajusteLM.pasoAjuste;
+    uint8_t progreso = 50;
+
+    switch (driver->estado) {
+        case EXITO:
+            return 100;
+
+        case CORRIENDO_PASO_1:
+            progreso = (50 * driver->buffer.cntMuestras) / NUM_MAX_MUESTRAS_MAG_CAL;
+            break;
+
+        case CORRIENDO_PASO_2:
+            pasos = driver->filtrando ? 0 : pasos;
+            pasos += PASOS_PASO_1_CAL_MAG;
+            break;
+
+        default:
+            return 0;
+    }
+
+    return progreso + (50 * MIN(pasos, PASOS_PASO_1_CAL_MAG + PASOS_PASO_2_CAL_MAG)) / (PASOS_PASO_1_CAL_MAG + PASOS_PASO_2_CAL_MAG);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void coberturaCalMag(uint8_t numCal, coberturaCalMag_t *cobertura)
+**  Descripcion:    Devuelve que sectores de la esfera tienen muestras para saber si se han
+**                  visto suficientes orientaciones. Recorre el buffer una vez
+**  Parametros:     Numero del calibrador, cobertura
+**  Retorno:        Ninguno
+****************************************************************************************/
+void coberturaCalMag(uint8_t numCal, coberturaCalMag_t *cobertura)
+{
+    const calMag_t *driver = &calMag[numCal];
+    const uint16_t numMuestras = driver->buffer.cntMuestras;
+    float centro[3] = {0.0f, 0.0f, 0.0f};
+
+    memset(cobertura, 0, sizeof(coberturaCalMag_t));
+    cobertura->muestras = numMuestras;
+    if (numMuestras == 0)
+        return;
+
+    if (driver->estado == CORRIENDO_PASO_2) {
+        for (uint8_t i = 0; i < 3; i++)
+            centro[i] = -driver->cal.offset[i];
+    }
+    else {
+        for (uint16_t n = 0; n < numMuestras; n++) {
+            for (uint8_t i = 0; i < 3; i++)
+                centro[i] += driver->buffer.magAcum[n][i];
+        }
+
+        for (uint8_t i = 0; i < 3; i++)
+            centro[i] /= numMuestras;
+    }
+
+    for (uint16_t n = 0; n < numMuestras; n++) {
+        float direccion[3];
+
+        for (uint8_t i = 0; i < 3; i++)
+            direccion[i] = driver->buffer.magAcum[n][i] - centro[i];
+
+        cobertura->mascaraSectores |= 1UL << sectorCoberturaCalMag(direccion);
+    }
+
+    for (uint8_t i = 0; i < NUM_SECTORES_COBERTURA_CAL_MAG; i++) {
+        if (cobertura->mascaraSectores & (1UL << i))
+            cobertura->sectoresCubiertos++;
+    }
+
+    cobertura->porcentaje = (100 * cobertura->sectoresCubiertos) / NUM_SECTORES_COBERTURA_CAL_MAG;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void cogerMuestraCalMag(calMag_t *calMag, uint32_t tiempoActual)
+**  Descripcion:    Coge una muestra del magnetometro para el calibrador. Se mantiene el
+**                  ritmo de muestreo aunque la tarea vaya mas rapida por otro ajuste
+**  Parametros:     Puntero al calibrador, tiempo actual
 **  Retorno:        Ninguno
 ****************************************************************************************/
-void cogerMuestraCalMag(calMag_t *calMag)
+void cogerMuestraCalMag(calMag_t *calMag, uint32_t tiempoActual)
 {
     if (calMag->estado == ESPERANDO_INICIO)
         ajustarEstadoCalMag(calMag, CORRIENDO_PASO_1);
 
+    if (tiempoActual - calMag->tiempoMuestra < PERIODO_TAREA_HZ_SCHEDULER(FREC_ACTUALIZAR_CALIBRADOR_MAG_HZ))
+        return;
+
+    calMag->tiempoMuestra = tiempoActual;
+
     float m[3];
     campoNumMag(calMag->numMag, m);
 
@@ -297,6 +414,7 @@ void cogerMuestraCalMag(calMag_t *calMag)
     	calMag->buffer.magAcum[calMag->buffer.cntMuestras][0] = m[0];
     	calMag->buffer.magAcum[calMag->buffer.cntMuestras][1] = m[1];
     	calMag->buffer.magAcum[calMag->buffer.cntMuestras][2] = m[2];
+        insertarRejillaHash(&calMag->rejilla, calMag->buffer.cntMuestras);
         calMag->buffer.cntMuestras++;
     }
 }
@@ -326,26 +444,6 @@ bool ajustandoCalMAg(calMag_t *calMag)
 }
 
 
-/***************************************************************************************
-**  Nombre:         void iniciarFitnessCalMAg(calMag_t *calMag)
-**  Descripcion:    Inicia los valores de fitness
-**  Parametros:     Puntero al calibrador
-**  Retorno:        Ninguno
-****************************************************************************************/
-void iniciarFitnessCalMAg(calMag_t *calMag)
-{
-    if (calMag->buffer.cntMuestras != 0)
-        calMag->ajusteLM.fitness = calcularResiduoMedioCuadrado(calMag->cal, calMag->buffer);
-    else
-        calMag->ajusteLM.fitness = 1.0e30f;
-
-    calMag->ajusteLM.fitnessInicial = calMag->ajusteLM.fitness;
-    calMag->ajusteLM.esferaLambda = 1.0f;
-    calMag->ajusteLM.elipseLambda = 1.0f;
-    calMag->ajusteLM.pasoAjuste = 0;
-}
-
-
 /***************************************************************************************
 **  Nombre:         void resetearEstadoCalMAg(calMag_t *calMag)
 **  Descripcion:    Resetea el estado
@@ -369,7 +467,9 @@ void resetearEstadoCalMAg(calMag_t *calMag)
     calMag->cal.offDiag[1] = 0.0;
     calMag->cal.offDiag[2] = 0.0;
 
-    iniciarFitnessCalMAg(calMag);
+    calMag->filtrando = false;
+    vaciarRejillaHash(&calMag->rejilla, calMag->cal.radio * factorDistanciaCalMag);
+    iniciarAjusteLMMag(&calMag->ajusteLM, &calMag->buffer);
 }
 
 
@@ -402,7 +502,7 @@ void ajustarEstadoCalMag(calMag_t *calMag, estadoCalMag_e estado)
             if (calMag->estado != ESPERANDO_INICIO)
             	break;
 
-            iniciarFitnessCalMAg(calMag);
+            iniciarAjusteLMMag(&calMag->ajusteLM, &calMag->buffer);
             calMag->estado = CORRIENDO_PASO_1;
             break;
 
@@ -410,8 +510,14 @@ void ajustarEstadoCalMag(calMag_t *calMag, estadoCalMag_e estado)
             if (calMag->estado != CORRIENDO_PASO_1)
             	break;
 
-            filtrarMuestrasCalMag(calMag);
-            iniciarFitnessCalMAg(calMag);
+            // La rejilla se rehace con el radio ajustado. Eso, el filtrado y el residuo de
+            // partida se reparten entre los siguientes ticks
+            barajarMuestrasCalMag(calMag);
+            vaciarRejillaHash(&calMag->rejilla, calMag->cal.radio * factorDistanciaCalMag);
+            calMag->filtrando = true;
+            calMag->indiceRejilla = 0;
+            calMag->indiceFiltro = 0;
+            iniciarAjusteLMMag(&calMag->ajusteLM, &calMag->buffer);
             calMag->estado = CORRIENDO_PASO_2;
             break;
 
@@ -471,13 +577,12 @@ bool comprobarResultadosCalMag(calMag_t *calMag)
 
 
 /***************************************************************************************
-**  Nombre:         void filtrarMuestrasCalMag(calMag_t *calMag)
-**  Descripcion:    Filtra las muestras obtenidas y elimina las que estan muy juntas para
-**                  tener la mayor variedad posible de muestras
+**  Nombre:         void barajarMuestrasCalMag(calMag_t *calMag)
+**  Descripcion:    Baraja las muestras antes de filtrarlas
 **  Parametros:     Puntero al calibrador
 **  Retorno:        Ninguno
 ****************************************************************************************/
-void filtrarMuestrasCalMag(calMag_t *calMag)
+void barajarMuestrasCalMag(calMag_t *calMag)
 {
     // Se barajan las muestras con: http://en.wikipedia.org/wiki/Fisher%E2%80%93Yates_shuffle
     // Esto es para que las muestras adyacentes no se eliminen secuencialmente
@@ -489,51 +594,99 @@ void filtrarMuestrasCalMag(calMag_t *calMag)
         memcpy(calMag->buffer.magAcum[i], calMag->buffer.magAcum[j], sizeof(temp));
         memcpy(calMag->buffer.magAcum[j], temp, sizeof(temp));
     }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void filtrarMuestrasCalMag(calMag_t *calMag, uint16_t numFiltrados)
+**  Descripcion:    Filtra las muestras obtenidas y elimina las que estan muy juntas para
+**                  tener la mayor variedad posible de muestras. Primero mete las muestras
+**                  en la rejilla y despues las revisa. Cada llamada procesa como mucho
+**                  numFiltrados muestras y continua donde lo dejo la anterior
+**  Parametros:     Puntero al calibrador, muestras a procesar
+**  Retorno:        Ninguno
+****************************************************************************************/
+void filtrarMuestrasCalMag(calMag_t *calMag, uint16_t numFiltrados)
+{
+    for (; numFiltrados > 0 && calMag->indiceRejilla < calMag->buffer.cntMuestras; numFiltrados--)
+        insertarRejillaHash(&calMag->rejilla, calMag->indiceRejilla++);
+
+    // Elimina las muestras que estan muy juntas. La ultima ocupa el hueco
+    for (; numFiltrados > 0 && calMag->indiceFiltro < calMag->buffer.cntMuestras; numFiltrados--) {
+        const uint16_t i = calMag->indiceFiltro++;
+        const uint16_t ultima = calMag->buffer.cntMuestras - 1;
 
-    // Elimina las muestras que estan muy juntas
-    for (uint16_t i = 0; i < calMag->buffer.cntMuestras; i++) {
         if (!aceptarMuestraCalMag(calMag, calMag->buffer.magAcum[i], i)) {
-        	memcpy(calMag->buffer.magAcum[i], calMag->buffer.magAcum[calMag->buffer.cntMuestras - 1], sizeof(calMag->buffer.magAcum[0]));
+            quitarRejillaHash(&calMag->rejilla, i);
+            if (i != ultima) {
+                quitarRejillaHash(&calMag->rejilla, ultima);
+                memcpy(calMag->buffer.magAcum[i], calMag->buffer.magAcum[ultima], sizeof(calMag->buffer.magAcum[0]));
+                insertarRejillaHash(&calMag->rejilla, i);
+            }
+
             calMag->buffer.cntMuestras--;
         }
     }
+
+    if (calMag->indiceFiltro >= calMag->buffer.cntMuestras)
+        calMag->filtrando = false;
 }
 
 
 /***************************************************************************************
 **  Nombre:         bool aceptarMuestraCalMag(calMag_t *calMag, float *muestra, uint16_t indiceIgnorado)
-**  Descripcion:    Comprueba si hay que aceptar una muestra. Para ello tiene que superar una distancia
-**                  minima donde lse considera que en cualquier poliedro de caras triangulares el angulo
+**  Descripcion:    Comprueba si hay que aceptar una muestra. Se rechaza si hay otra a menos
+**                  de la distancia minima, que busca la rejilla solo entre las cercanas
+**  Parametros:     Puntero al calibrador, muestra a comprobar, indice a ignorar
+**  Retorno:        True si se acepta
+****************************************************************************************/
+bool aceptarMuestraCalMag(calMag_t *calMag, float *muestra, uint16_t indiceIgnorado)
+{
+    return !hayVecinoRejillaHash(&calMag->rejilla, muestra, indiceIgnorado);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void calcularFactorDistanciaCalMag(void)
+**  Descripcion:    Calcula una vez la distancia minima entre muestras relativa al radio.
+**                  Se considera que en cualquier poliedro de caras triangulares el angulo
 **                  entre dos puntos contiguos es: theta = arccos(cos(A) / (1 - cos(A))) donde:
 **                  A = (4pi / F + pi) / 3 y
 **                  F = 2V - 4 es el numero de caras del poliedro que depende del numero de vertices V
-**  Parametros:     Puntero al calibrador, muestra a comprobar, indice a ignorar
+**  Parametros:     Ninguno
 **  Retorno:        Ninguno
 ****************************************************************************************/
-bool aceptarMuestraCalMag(calMag_t *calMag, float *muestra, uint16_t indiceIgnorado)
+void calcularFactorDistanciaCalMag(void)
 {
+    if (factorDistanciaCalMag > 0.0f)
+        return;
+
     uint16_t caras = (2 * NUM_MAX_MUESTRAS_MAG_CAL - 4);
     float a = (4.0f * PI / (3.0f * caras)) + PI / 3.0f;
     float theta = 0.5f * acosf(cosf(a) / (1.0f - cosf(a)));
 
-    float distanciaMin = calMag->cal.radio * 2 * sinf(theta / 2);
-
-    for (uint16_t i = 0; i < calMag->buffer.cntMuestras; i++) {
-        if (i != indiceIgnorado) {
-            float vectorDis[3];
+    factorDistanciaCalMag = 2 * sinf(theta / 2);
+}
 
-            vectorDis[0] = muestra[0] - calMag->buffer.magAcum[i][0];
-            vectorDis[1] = muestra[1] - calMag->buffer.magAcum[i][1];
-            vectorDis[2] = muestra[2] - calMag->buffer.magAcum[i][2];
 
-            float distancia = moduloVector3(vectorDis);
+/***************************************************************************************
+**  Nombre:         uint8_t sectorCoberturaCalMag(const float *direccion)
+**  Descripcion:    Sector de una direccion: cara del cubo por el eje dominante y su signo,
+**                  y cuadrante de la cara por el signo de los otros dos ejes
+**  Parametros:     Direccion respecto al centro
+**  Retorno:        Sector
+****************************************************************************************/
+uint8_t sectorCoberturaCalMag(const float *direccion)
+{
+    uint8_t eje = 0;
 
-            if (distancia < distanciaMin)
-                return false;
-        }
+    for (uint8_t i = 1; i < 3; i++) {
+        if (fabsf(direccion[i]) > fabsf(direccion[eje]))
+            eje = i;
     }
 
-    return true;
+    const uint8_t cara = 2 * eje + (direccion[eje] < 0.0f);
+    return 4 * cara + 2 * (direccion[(eje + 1) % 3] >= 0.0f) + (direccion[(eje + 2) % 3] >= 0.0f);
 }
 
 
@@ -562,192 +715,259 @@ void calcularOffsetMagInicial(calMag_t *calMag)
 
 
 /***************************************************************************************
-**  Nombre:         void ajustarEsferaCalMag(calMag_t *calMag)
-**  Descripcion:    Ejecuta el algoritmo de la esferea para calcular la matriz
-**  Parametros:     Puntero al calibrador
+**  Nombre:         void iniciarAjusteLMMag(ajusteLM_t *ajuste, const bufferCalMag_t *buffer)
+**  Descripcion:    Inicia el ajuste. Si hay muestras el residuo de partida se calcula por
+**                  tramos antes de la primera iteracion
+**  Parametros:     Ajuste, buffer de muestras
 **  Retorno:        Ninguno
 ****************************************************************************************/
-void ajustarEsferaCalMag(calMag_t *calMag)
+void iniciarAjusteLMMag(ajusteLM_t *ajuste, const bufferCalMag_t *buffer)
 {
-    const float lmaDamping = 10.0f;
+    ajuste->fitness = 1.0e30f;
+    ajuste->fitnessInicial = ajuste->fitness;
+    ajuste->esferaLambda = 1.0f;
+    ajuste->elipseLambda = 1.0f;
+    ajuste->pasoAjuste = 0;
+
+    ajuste->fase = buffer->cntMuestras != 0 ? FASE_LM_FITNESS : FASE_LM_ACUMULAR;
+    ajuste->muestra = 0;
+    ajuste->suma1 = 0.0f;
+}
 
-    // Copia de seguridad para determinar si el ajuste ha mejorado
-    float fitness = calMag->ajusteLM.fitness;
-    float fit1, fit2;
 
-    calParamMag_t paramFit1, paramFit2;
-    paramFit1 = calMag->cal;
-    paramFit2 = calMag->cal;
+/***************************************************************************************
+**  Nombre:         bool avanzarAjusteLMMag(ajusteLM_t *ajuste, calParamMag_t *param,
+**                                          const bufferCalMag_t *buffer, tipoAjusteMag_e tipo,
+**                                          uint16_t presupuesto)
+**  Descripcion:    Avanza la iteracion Levenberg-Marquardt en curso procesando como mucho
+**                  presupuesto muestras. Al terminar la iteracion actualiza los parametros
+**                  si han mejorado y el paso del ajuste
+**  Parametros:     Ajuste, parametros, buffer de muestras, esfera o elipse, muestras maximas
+**  Retorno:        True si ha terminado una iteracion
+****************************************************************************************/
+bool avanzarAjusteLMMag(ajusteLM_t *ajuste, calParamMag_t *param, const bufferCalMag_t *buffer, tipoAjusteMag_e tipo, uint16_t presupuesto)
+{
+    const uint16_t fin = MIN((uint32_t)ajuste->muestra + presupuesto, buffer->cntMuestras);
 
-    matriz_t JTJ, JTJ2;
-    memset(&JTJ, 0, sizeof(matriz_t));
-    memset(&JTJ2, 0, sizeof(matriz_t));
+    switch (ajuste->fase) {
+        case FASE_LM_FITNESS:
+            for (; ajuste->muestra < fin; ajuste->muestra++)
+                ajuste->suma1 += sq(calcularResiduo(buffer->magAcum[ajuste->muestra], param));
 
-    float JTFI[NUM_PARAMETROS_ESFERA_MAG_CAL];
-    for (uint8_t i = 0; i < NUM_PARAMETROS_ESFERA_MAG_CAL; i++)
-    	JTFI[i] = 0.0;
+            if (ajuste->muestra < buffer->cntMuestras)
+                return false;
+
+            ajuste->fitness = buffer->cntMuestras != 0 ? ajuste->suma1 / buffer->cntMuestras : 1.0e30f;
+            ajuste->fitnessInicial = ajuste->fitness;
+            ajuste->fase = FASE_LM_ACUMULAR;
+            ajuste->muestra = 0;
+            return false;
 
-    // Parte Gauss Newton
-    for (uint16_t k = 0; k < calMag->buffer.cntMuestras; k++) {
-        float *muestra = calMag->buffer.magAcum[k];
-        float jacobianoEsfera[NUM_PARAMETROS_ESFERA_MAG_CAL];
+        case FASE_LM_ACUMULAR:
+            acumularAjusteLMMag(ajuste, param, buffer, tipo, fin);
 
-        calcularJacobianoEsfera(muestra, paramFit1, jacobianoEsfera);
+            if (ajuste->muestra < buffer->cntMuestras)
+                return false;
 
-        for (uint8_t i = 0; i < NUM_PARAMETROS_ESFERA_MAG_CAL; i++) {
-            // Calculo JTJ
-            for (uint8_t j = 0; j < NUM_PARAMETROS_ESFERA_MAG_CAL; j++) {
-                JTJ.m[i][j]  += jacobianoEsfera[i] * jacobianoEsfera[j];
-                JTJ2.m[i][j] += jacobianoEsfera[i] * jacobianoEsfera[j];   // Backup de JTJ
+            ajuste->muestra = 0;
+
+            // Si no se puede resolver la iteracion termina sin cambios
+            if (!resolverAjusteLMMag(ajuste, param, tipo)) {
+                ajuste->pasoAjuste++;
+                return true;
             }
 
-            // Calculo JTFI
-            JTFI[i] += jacobianoEsfera[i] * calcularResiduo(muestra, paramFit1);
-        }
-    }
+            ajuste->fase = FASE_LM_EVALUAR;
+            ajuste->suma1 = 0.0f;
+            ajuste->suma2 = 0.0f;
+            return false;
 
-    // Parte Levenberg-Marquardt
-    for (uint8_t i = 0; i < NUM_PARAMETROS_ESFERA_MAG_CAL; i++) {
-        JTJ.m[i][i]  += calMag->ajusteLM.esferaLambda;
-        JTJ2.m[i][i] += calMag->ajusteLM.esferaLambda / lmaDamping;
-    }
+        case FASE_LM_EVALUAR:
+            for (; ajuste->muestra < fin; ajuste->muestra++) {
+                const float *muestra = buffer->magAcum[ajuste->muestra];
 
-    if (!inversaMatriz(JTJ, &JTJ, NUM_PARAMETROS_ESFERA_MAG_CAL))
-        return;
+                ajuste->suma1 += sq(calcularResiduo(muestra, &ajuste->paramFit1));
+                ajuste->suma2 += sq(calcularResiduo(muestra, &ajuste->paramFit2));
+            }
 
-    if (!inversaMatriz(JTJ2, &JTJ2, NUM_PARAMETROS_ESFERA_MAG_CAL))
-        return;
+            if (ajuste->muestra < buffer->cntMuestras)
+                return false;
 
-    // Se extraen los parametros
-    for (uint8_t fila = 0; fila < NUM_PARAMETROS_ESFERA_MAG_CAL; fila++) {
-        for (uint8_t col = 0; col < NUM_PARAMETROS_ESFERA_MAG_CAL; col++) {
-        	(&paramFit1.radio)[fila] -= JTFI[col] * JTJ.m[fila][col];
-        	(&paramFit2.radio)[fila] -= JTFI[col] * JTJ2.m[fila][col];
-        }
+            decidirAjusteLMMag(ajuste, param, buffer->cntMuestras, tipo);
+            ajuste->fase = FASE_LM_ACUMULAR;
+            ajuste->muestra = 0;
+            ajuste->pasoAjuste++;
+            return true;
+
+        default:
+            return false;
     }
+}
 
-    // Se calcula el fitness de dos posibles juegos de parametros
-    fit1 = calcularResiduoMedioCuadrado(paramFit1, calMag->buffer);
-    fit2 = calcularResiduoMedioCuadrado(paramFit2, calMag->buffer);
 
-    // Se decide cual de los dos juegos de parametros es mejor
-    if (fit1 > calMag->ajusteLM.fitness && fit2 > calMag->ajusteLM.fitness) // Si ninguno de los dos dan mejor resultado se incrementa lambda
-    	calMag->ajusteLM.esferaLambda *= lmaDamping;
-    else if (fit2 < calMag->ajusteLM.fitness && fit2 < fit1) {              // Si fit2 tiene mejor resultado se usa y se decrementa lambda
-    	calMag->ajusteLM.esferaLambda /= lmaDamping;
-    	paramFit1 = paramFit2;
-        fitness = fit2;
+/***************************************************************************************
+**  Nombre:         void acumularAjusteLMMag(ajusteLM_t *ajuste, const calParamMag_t *param,
+**                                           const bufferCalMag_t *buffer, tipoAjusteMag_e tipo,
+**                                           uint16_t fin)
+**  Descripcion:    Parte Gauss Newton. Acumula J'J (triangulo inferior) y J'r hasta la
+**                  muestra indicada
+**  Parametros:     Ajuste, parametros, buffer de muestras, esfera o elipse, muestra final
+**  Retorno:        Ninguno
+****************************************************************************************/
+void acumularAjusteLMMag(ajusteLM_t *ajuste, const calParamMag_t *param, const bufferCalMag_t *buffer, tipoAjusteMag_e tipo, uint16_t fin)
+{
+    const uint8_t numParam = tipo == AJUSTE_ESFERA_MAG ? NUM_PARAMETROS_ESFERA_MAG_CAL : NUM_PARAMETROS_ELIPSE_MAG_CAL;
+
+    if (ajuste->muestra == 0) {
+        resetearMatriz9(&ajuste->JTJ);
+        memset(ajuste->JTFI, 0, sizeof(ajuste->JTFI));
     }
-    else if (fit1 < calMag->ajusteLM.fitness)
-        fitness = fit1;
-    // Fin parte Levenberg-Marquardt
 
-    // Se guardan los nuevos parametros y se actualiza el fitness
-    if (!isnan(fitness) && fitness < calMag->ajusteLM.fitness) {
-    	calMag->ajusteLM.fitness = fitness;
-    	calMag->cal = paramFit1;
+    for (; ajuste->muestra < fin; ajuste->muestra++) {
+        const float *muestra = buffer->magAcum[ajuste->muestra];
+        float jacobiano[NUM_PARAMETROS_ELIPSE_MAG_CAL];
+
+        if (tipo == AJUSTE_ESFERA_MAG)
+            calcularJacobianoEsfera(muestra, param, jacobiano);
+        else
+            calcularJacobianoElipse(muestra, param, jacobiano);
+
+        const float residuo = calcularResiduo(muestra, param);
+
+        for (uint8_t i = 0; i < numParam; i++) {
+            for (uint8_t j = 0; j <= i; j++)
+                ajuste->JTJ.m[i][j] += jacobiano[i] * jacobiano[j];
+
+            ajuste->JTFI[i] += jacobiano[i] * residuo;
+        }
     }
 }
 
 
 /***************************************************************************************
-**  Nombre:         void ajustarElipseCalMag(calMag_t *calMag)
-**  Descripcion:    Ejecuta el algoritmo de la esferea para calcular la matriz
-**  Parametros:     Puntero al calibrador
-**  Retorno:        Ninguno
+**  Nombre:         bool resolverAjusteLMMag(ajusteLM_t *ajuste, const calParamMag_t *param,
+**                                           tipoAjusteMag_e tipo)
+**  Descripcion:    Parte Levenberg-Marquardt. Obtiene los dos juegos de parametros con
+**                  lambda y lambda / amortiguamiento resolviendo por Cholesky. La esfera
+**                  se resuelve con matrices de 4x4 y la elipse con las de 9x9
+**  Parametros:     Ajuste, parametros, esfera o elipse
+**  Retorno:        True si OK
 ****************************************************************************************/
-void ajustarElipseCalMag(calMag_t *calMag)
+bool resolverAjusteLMMag(ajusteLM_t *ajuste, const calParamMag_t *param, tipoAjusteMag_e tipo)
 {
-    const float lmaDamping = 10.0f;
-
-    // Copia de seguridad para determinar si el ajuste ha mejorado
-    float fitness = calMag->ajusteLM.fitness;
-    float fit1, fit2;
-    calParamMag_t paramFit1, paramFit2;
-    paramFit1 = calMag->cal;
-    paramFit2 = calMag->cal;
-
-    matriz_t JTJ, JTJ2;
-    memset(&JTJ, 0, sizeof(matriz_t));
-    memset(&JTJ2, 0, sizeof(matriz_t));
-    float JTFI[NUM_PARAMETROS_ELIPSE_MAG_CAL];
-    for (uint8_t i = 0; i < NUM_PARAMETROS_ELIPSE_MAG_CAL; i++)
-    	JTFI[i] = 0.0;
-
-    // Parte Gauss Newton
-    for (uint16_t k = 0; k < calMag->buffer.cntMuestras; k++) {
-        float *muestra = calMag->buffer.magAcum[k];
-        float jacobianoElipse[NUM_PARAMETROS_ELIPSE_MAG_CAL];
-
-        calcularJacobianoElipse(muestra, paramFit1, jacobianoElipse);
-
-        for (uint8_t i = 0; i < NUM_PARAMETROS_ELIPSE_MAG_CAL; i++) {
-            // Calculo JTJ
-            for (uint8_t j = 0; j < NUM_PARAMETROS_ELIPSE_MAG_CAL; j++) {
-                JTJ.m[i][j]  += jacobianoElipse[i] * jacobianoElipse[j];
-                JTJ2.m[i][j] += jacobianoElipse[i] * jacobianoElipse[j];   // Backup de JTJ
-            }
+    float delta1[NUM_PARAMETROS_ELIPSE_MAG_CAL], delta2[NUM_PARAMETROS_ELIPSE_MAG_CAL];
+    uint8_t numParam;
 
-            // Calculo JTFI
-            JTFI[i] += jacobianoElipse[i] * calcularResiduo(muestra, paramFit1);
-        }
+    if (tipo == AJUSTE_ESFERA_MAG) {
+        matriz4_t JTJ1, JTJ2;
+
+        numParam = NUM_PARAMETROS_ESFERA_MAG_CAL;
+        cargarSistemaLMMag(ajuste, ajuste->esferaLambda, numParam, &JTJ1.m[0][0], &JTJ2.m[0][0], delta1, delta2);
+
+        if (!factorizarCholeskyMatriz4(&JTJ1) || !factorizarCholeskyMatriz4(&JTJ2))
+            return false;
+
+        resolverCholeskyMatriz4(&JTJ1, delta1);
+        resolverCholeskyMatriz4(&JTJ2, delta2);
     }
+    else {
+        matriz9_t JTJ1, JTJ2;
 
-    // Parte Levenberg-Marquardt
-    for (uint8_t i = 0; i < NUM_PARAMETROS_ELIPSE_MAG_CAL; i++) {
-        JTJ.m[i][i]  += calMag->ajusteLM.elipseLambda;
-        JTJ2.m[i][i] += calMag->ajusteLM.elipseLambda / lmaDamping;
+        numParam = NUM_PARAMETROS_ELIPSE_MAG_CAL;
+        cargarSistemaLMMag(ajuste, ajuste->elipseLambda, numParam, &JTJ1.m[0][0], &JTJ2.m[0][0], delta1, delta2);
+
+        if (!factorizarCholeskyMatriz9(&JTJ1) || !factorizarCholeskyMatriz9(&JTJ2))
+            return false;
+
+        resolverCholeskyMatriz9(&JTJ1, delta1);
+        resolverCholeskyMatriz9(&JTJ2, delta2);
     }
 
-    if (!inversaMatriz(JTJ, &JTJ, NUM_PARAMETROS_ELIPSE_MAG_CAL))
-        return;
+    // La esfera ajusta desde el radio hasta el offset y la elipse desde el offset hasta el final
+    ajuste->paramFit1 = *param;
+    ajuste->paramFit2 = *param;
+    float *paramFit1 = tipo == AJUSTE_ESFERA_MAG ? &ajuste->paramFit1.radio : &ajuste->paramFit1.offset[0];
+    float *paramFit2 = tipo == AJUSTE_ESFERA_MAG ? &ajuste->paramFit2.radio : &ajuste->paramFit2.offset[0];
 
-    if (!inversaMatriz(JTJ2, &JTJ2, NUM_PARAMETROS_ELIPSE_MAG_CAL))
-        return;
+    for (uint8_t i = 0; i < numParam; i++) {
+        paramFit1[i] -= delta1[i];
+        paramFit2[i] -= delta2[i];
+    }
 
-    // Se extraen los parametros
-    for (uint8_t fila = 0; fila < NUM_PARAMETROS_ELIPSE_MAG_CAL; fila++) {
-        for (uint8_t col = 0; col < NUM_PARAMETROS_ELIPSE_MAG_CAL; col++) {
-        	(&paramFit1.offset[0])[fila] -= JTFI[col] * JTJ.m[fila][col];
-        	(&paramFit2.offset[0])[fila] -= JTFI[col] * JTJ2.m[fila][col];
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void cargarSistemaLMMag(const ajusteLM_t *ajuste, float lambda, uint8_t dim,
+**                                          float *JTJ1, float *JTJ2, float *delta1, float *delta2)
+**  Descripcion:    Copia el triangulo inferior de J'J con lambda y lambda / amortiguamiento
+**                  sumados a la diagonal en dos matrices de dim x dim, y J'r en los dos
+**                  terminos independientes
+**  Parametros:     Ajuste, lambda, dimension, primer elemento de cada matriz, terminos
+**                  independientes
+**  Retorno:        Ninguno
+****************************************************************************************/
+void cargarSistemaLMMag(const ajusteLM_t *ajuste, float lambda, uint8_t dim, float *JTJ1, float *JTJ2, float *delta1, float *delta2)
+{
+    for (uint8_t i = 0; i < dim; i++) {
+        for (uint8_t j = 0; j <= i; j++) {
+            JTJ1[i * dim + j] = ajuste->JTJ.m[i][j];
+            JTJ2[i * dim + j] = ajuste->JTJ.m[i][j];
         }
+
+        JTJ1[i * dim + i] += lambda;
+        JTJ2[i * dim + i] += lambda / AMORTIGUAMIENTO_LM_CAL_MAG;
+        delta1[i] = ajuste->JTFI[i];
+        delta2[i] = ajuste->JTFI[i];
     }
+}
 
-    // Se calcula el fitness de dos posibles juegos de parametros
-    fit1 = calcularResiduoMedioCuadrado(paramFit1, calMag->buffer);
-    fit2 = calcularResiduoMedioCuadrado(paramFit2, calMag->buffer);
 
-    // Se decide cual de los dos juegos de parametros es mejor
-    if (fit1 > calMag->ajusteLM.fitness && fit2 > calMag->ajusteLM.fitness) // Si ninguno de los dos dan mejor resultado se incrementa lambda
-    	calMag->ajusteLM.elipseLambda *= lmaDamping;
-    else if (fit2 < calMag->ajusteLM.fitness && fit2 < fit1) {              // Si fit2 tiene mejor resultado se usa y se decrementa lambda
-    	calMag->ajusteLM.elipseLambda /= lmaDamping;
-    	paramFit1 = paramFit2;
+/***************************************************************************************
+**  Nombre:         void decidirAjusteLMMag(ajusteLM_t *ajuste, calParamMag_t *param,
+**                                          uint16_t numMuestras, tipoAjusteMag_e tipo)
+**  Descripcion:    Se queda con el mejor juego de parametros y ajusta lambda
+**  Parametros:     Ajuste, parametros, numero de muestras evaluadas, esfera o elipse
+**  Retorno:        Ninguno
+****************************************************************************************/
+void decidirAjusteLMMag(ajusteLM_t *ajuste, calParamMag_t *param, uint16_t numMuestras, tipoAjusteMag_e tipo)
+{
+    float *lambda = tipo == AJUSTE_ESFERA_MAG ? &ajuste->esferaLambda : &ajuste->elipseLambda;
+    const float fit1 = numMuestras != 0 ? ajuste->suma1 / numMuestras : 1.0e30f;
+    const float fit2 = numMuestras != 0 ? ajuste->suma2 / numMuestras : 1.0e30f;
+    const calParamMag_t *paramFit = &ajuste->paramFit1;
+    float fitness = ajuste->fitness;
+
+    if (fit1 > ajuste->fitness && fit2 > ajuste->fitness)     // Si ninguno de los dos dan mejor resultado se incrementa lambda
+        *lambda *= AMORTIGUAMIENTO_LM_CAL_MAG;
+    else if (fit2 < ajuste->fitness && fit2 < fit1) {         // Si fit2 tiene mejor resultado se usa y se decrementa lambda
+        *lambda /= AMORTIGUAMIENTO_LM_CAL_MAG;
+        paramFit = &ajuste->paramFit2;
         fitness = fit2;
     }
-    else if (fit1 < calMag->ajusteLM.fitness)
+    else if (fit1 < ajuste->fitness)
         fitness = fit1;
-    // Fin parte Levenberg-Marquardt
 
     // Se guardan los nuevos parametros y se actualiza el fitness
-    if (!isnan(fitness) && fitness < calMag->ajusteLM.fitness) {
-    	calMag->ajusteLM.fitness = fitness;
-    	calMag->cal = paramFit1;
+    if (!isnan(fitness) && fitness < ajuste->fitness) {
+        ajuste->fitness = fitness;
+        *param = *paramFit;
     }
 }
 
 
 /***************************************************************************************
-**  Nombre:         void calcularJacobianoEsfera(float *muestra, calParamMag_t *param, float *j)
+**  Nombre:         void calcularJacobianoEsfera(const float *muestra, const calParamMag_t *param, float *j)
 **  Descripcion:    Calcula el jacobiano de una esfera
 **  Parametros:     Muestras en x y z, parametros de calibracion, jacobiano calculado
 **  Retorno:        Ninguno
 ****************************************************************************************/
-void calcularJacobianoEsfera(float *muestra, calParamMag_t param, float *j)
+void calcularJacobianoEsfera(const float *muestra, const calParamMag_t *param, float *j)
 {
-    const float offset[3]  = {param.offset[0],  param.offset[1],  param.offset[2]};
-    const float diag[3]    = {param.diag[0],    param.diag[1],    param.diag[2]};
-    const float offDiag[3] = {param.offDiag[0], param.offDiag[1], param.offDiag[2]};
+    const float offset[3]  = {param->offset[0],  param->offset[1],  param->offset[2]};
+    const float diag[3]    = {param->diag[0],    param->diag[1],    param->diag[2]};
+    const float offDiag[3] = {param->offDiag[0], param->offDiag[1], param->offDiag[2]};
 
     float A = (diag[0]    * (muestra[0] + offset[0])) + (offDiag[0] * (muestra[1] + offset[1])) + (offDiag[1] * (muestra[2] + offset[2]));
     float B = (offDiag[0] * (muestra[0] + offset[0])) + (diag[1]    * (muestra[1] + offset[1])) + (offDiag[2] * (muestra[2] + offset[2]));
@@ -764,16 +984,16 @@ void calcularJacobianoEsfera(float *muestra, calParamMag_t param, float *j)
 
 
 /***************************************************************************************
-**  Nombre:         void calcularJacobianoElipse(float *muestra, calParamMag_t *param, float *j)
+**  Nombre:         void calcularJacobianoElipse(const float *muestra, const calParamMag_t *param, float *j)
 **  Descripcion:    Calcula el jacobiano de una elipse
 **  Parametros:     Muestras en x y z, parametros de calibracion, jacobiano calculado
 **  Retorno:        Ninguno
 ****************************************************************************************/
-void calcularJacobianoElipse(float *muestra, calParamMag_t param, float *j)
+void calcularJacobianoElipse(const float *muestra, const calParamMag_t *param, float *j)
 {
-    const float offset[3]  = {param.offset[0],  param.offset[1],  param.offset[2]};
-    const float diag[3]    = {param.diag[0],    param.diag[1],    param.diag[2]};
-    const float offDiag[3] = {param.offDiag[0], param.offDiag[1], param.offDiag[2]};
+    const float offset[3]  = {param->offset[0],  param->offset[1],  param->offset[2]};
+    const float diag[3]    = {param->diag[0],    param->diag[1],    param->diag[2]};
+    const float offDiag[3] = {param->offDiag[0], param->offDiag[1], param->offDiag[2]};
 
     float A = (diag[0]    * (muestra[0] + offset[0])) + (offDiag[0] * (muestra[1] + offset[1])) + (offDiag[1] * (muestra[2] + offset[2]));
     float B = (offDiag[0] * (muestra[0] + offset[0])) + (diag[1]    * (muestra[1] + offset[1])) + (offDiag[2] * (muestra[2] + offset[2]));
@@ -796,46 +1016,23 @@ void calcularJacobianoElipse(float *muestra, calParamMag_t param, float *j)
 
 
 /***************************************************************************************
-**  Nombre:         float calcularResiduo(const float *muestra, const calParamMag_t param)
+**  Nombre:         float calcularResiduo(const float *muestra, const calParamMag_t *param)
 **  Descripcion:    Calcula el residuo
 **  Parametros:     Muestra, parametros
 **  Retorno:        Residuo
 ****************************************************************************************/
-float calcularResiduo(const float *muestra, const calParamMag_t param)
+float calcularResiduo(const float *muestra, const calParamMag_t *param)
 {
-    const float offset[3]  = {param.offset[0],  param.offset[1],  param.offset[2]};
-    const float diag[3]    = {param.diag[0],    param.diag[1],    param.diag[2]};
-    const float offDiag[3] = {param.offDiag[0], param.offDiag[1], param.offDiag[2]};
+    const float offset[3]  = {param->offset[0],  param->offset[1],  param->offset[2]};
+    const float diag[3]    = {param->diag[0],    param->diag[1],    param->diag[2]};
+    const float offDiag[3] = {param->offDiag[0], param->offDiag[1], param->offDiag[2]};
 
     float A = (diag[0]    * (muestra[0] + offset[0])) + (offDiag[0] * (muestra[1] + offset[1])) + (offDiag[1] * (muestra[2] + offset[2]));
     float B = (offDiag[0] * (muestra[0] + offset[0])) + (diag[1]    * (muestra[1] + offset[1])) + (offDiag[2] * (muestra[2] + offset[2]));
     float C = (offDiag[1] * (muestra[0] + offset[0])) + (offDiag[2] * (muestra[1] + offset[1])) + (diag[2]    * (muestra[2] + offset[2]));
     float longitud = sqrtf(A * A + B * B + C * C);
 
-    return param.radio - longitud;
-}
-
-
-/***************************************************************************************
-**  Nombre:         float calcularResiduoMedioCuadrado(const calParamMag_t param, bufferCalMag_t buffer)
-**  Descripcion:    Calcula el residuo medio cuadrado
-**  Parametros:     Parametros, buffer de muestras
-**  Retorno:        Residuo medio
-****************************************************************************************/
-float calcularResiduoMedioCuadrado(const calParamMag_t param, bufferCalMag_t buffer)
-{
-    if (buffer.cntMuestras == 0)
-        return 1.0e30f;
-
-    float suma = 0.0f;
-    for (uint16_t i = 0; i < buffer.cntMuestras; i++) {
-        float *muestra = buffer.magAcum[i];
-        float residuo = calcularResiduo(muestra, param);
-        suma += sq(residuo);
-    }
-
-    suma /= buffer.cntMuestras;
-    return suma;
+    return param->radio - longitud;
 }
 
 #endif
@@ -31,11 +31,28 @@
 #include <stdbool.h>
 
 #include "Sistema/plataforma.h"
+#include "Comun/matriz_fija.h"
 
 
 /***************************************************************************************
 ** AREA DE PREPROCESADOR                                                              **
 ****************************************************************************************/
+/*
+ * El ajuste Levenberg-Marquardt se reparte entre ticks del scheduler: cada iteracion
+ * acumula J'J y J'r por tramos de muestras, resuelve los dos sistemas amortiguados por
+ * Cholesky y evalua los dos juegos de parametros tambien por tramos. Ningun tick procesa
+ * mas de MUESTRAS_POR_TICK_CAL_MAG muestras
+ */
+#define NUM_MAX_MUESTRAS_MAG_CAL            500
+#define NUM_PARAMETROS_ESFERA_MAG_CAL       4
+#define NUM_PARAMETROS_ELIPSE_MAG_CAL       9
+#define MUESTRAS_POR_TICK_CAL_MAG           50
+
+/*
+ * La cobertura divide las direcciones respecto al centro de la esfera en las 6 caras de
+ * un cubo partidas en 4 cuadrantes. Hasta que hay offset ajustado el centro es la media
+ */
+#define NUM_SECTORES_COBERTURA_CAL_MAG      24
 
 
 /***************************************************************************************
@@ -48,6 +65,46 @@ typedef struct {
     float offDiag[3];
 } calParamMag_t;
 
+typedef enum {
+    AJUSTE_ESFERA_MAG,
+    AJUSTE_ELIPSE_MAG,
+} tipoAjusteMag_e;
+
+typedef enum {
+    FASE_LM_FITNESS,                       // Residuo de partida
+    FASE_LM_ACUMULAR,                      // J'J y J'r
+    FASE_LM_EVALUAR,                       // Residuo de los dos juegos de parametros
+} faseAjusteLM_e;
+
+typedef struct {
+    uint16_t cntMuestras;
+    float magAcum[NUM_MAX_MUESTRAS_MAG_CAL][3];
+} bufferCalMag_t;
+
+typedef struct {
+    uint16_t pasoAjuste;
+    float fitness;
+    float fitnessInicial;
+    float esferaLambda;
+    float elipseLambda;
+
+    // Iteracion en curso
+    faseAjusteLM_e fase;
+    uint16_t muestra;
+    matriz9_t JTJ;
+    float JTFI[NUM_PARAMETROS_ELIPSE_MAG_CAL];
+    calParamMag_t paramFit1;
+    calParamMag_t paramFit2;
+    float suma1;
+    float suma2;
+} ajusteLM_t;
+
+typedef struct {
+    uint16_t muestras;
+    uint8_t sectoresCubiertos;
+    uint8_t porcentaje;
+    uint32_t mascaraSectores;
+} coberturaCalMag_t;
 
 
 /***************************************************************************************
@@ -63,5 +120,10 @@ void terminarCalMag(void);
 void actualizarCalMag(uint32_t tiempoActual);
 bool calibracionMagExitosa(uint8_t numCal);
 calParamMag_t parametrosCalMAg(uint8_t numCal);
+uint8_t progresoCalMag(uint8_t numCal);
+void coberturaCalMag(uint8_t numCal, coberturaCalMag_t *cobertura);
+
+void iniciarAjusteLMMag(ajusteLM_t *ajuste, const bufferCalMag_t *buffer);
+bool avanzarAjusteLMMag(ajusteLM_t *ajuste, calParamMag_t *param, const bufferCalMag_t *buffer, tipoAjusteMag_e tipo, uint16_t presupuesto);
 
 #endif // __CALIBRADOR_MAG_H_
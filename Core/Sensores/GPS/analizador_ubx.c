@@ -0,0 +1,330 @@
+/***************************************************************************************
+**  analizador_ubx.c - Analizador de tramas UBX sobre tramos contiguos de bytes
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <string.h>
+
+#include "analizador_ubx.h"
+#include "Sistema/plataforma.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+uint16_t escanearUBX(analizadorUBX_t *analizador, const uint8_t *bloque, uint16_t longitud, bool *nuevosDatos);
+uint16_t completarParcialUBX(analizadorUBX_t *analizador, const uint8_t *bloque, uint16_t longitud, bool *nuevosDatos);
+bool validarTramaUBX(analizadorUBX_t *analizador, const uint8_t *trama, uint16_t longitudPayload, bool *nuevosDatos);
+void despacharTramaUBX(analizadorUBX_t *analizador, const tramaUBX_t *trama, bool *nuevosDatos);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         void iniciarAnalizadorUBX(analizadorUBX_t *analizador, const entradaTablaUBX_t *tabla,
+**                                            uint8_t numEntradas, manejadorUBX_f manejadorDefecto, void *contexto)
+**  Descripcion:    Inicia el analizador con la tabla de manejadores
+**  Parametros:     Analizador, tabla, numero de entradas, manejador para las tramas que no
+**                  estan en la tabla (puede ser NULL), contexto que se pasa a los manejadores
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarAnalizadorUBX(analizadorUBX_t *analizador, const entradaTablaUBX_t *tabla, uint8_t numEntradas,
+                          manejadorUBX_f manejadorDefecto, void *contexto)
+{
+    memset(analizador, 0, sizeof(*analizador));
+    analizador->tabla = tabla;
+    analizador->numEntradas = numEntradas;
+    analizador->manejadorDefecto = manejadorDefecto;
+    analizador->contexto = contexto;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void resetearAnalizadorUBX(analizadorUBX_t *analizador)
+**  Descripcion:    Descarta la trama partida pendiente y las estadisticas
+**  Parametros:     Analizador
+**  Retorno:        Ninguno
+****************************************************************************************/
+void resetearAnalizadorUBX(analizadorUBX_t *analizador)
+{
+    analizador->bytesParcial = 0;
+    analizador->faltan = 0;
+    memset(&analizador->estadisticas, 0, sizeof(analizador->estadisticas));
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t analizarBloqueUBX(analizadorUBX_t *analizador, const uint8_t *bloque,
+**                                             uint16_t longitud, bool *nuevosDatos)
+**  Descripcion:    Procesa un tramo contiguo de bytes. Si hay una trama partida la completa
+**                  primero y despues despacha las tramas completas del tramo sin copiarlas
+**  Parametros:     Analizador, tramo, longitud del tramo, se pone a true si algun
+**                  manejador devuelve true
+**  Retorno:        Bytes consumidos. Los que quedan son el principio de una trama incompleta
+****************************************************************************************/
+CODIGO_RAPIDO uint16_t analizarBloqueUBX(analizadorUBX_t *analizador, const uint8_t *bloque, uint16_t longitud, bool *nuevosDatos)
+{
+    uint16_t usados = 0;
+
+    if (analizador->bytesParcial > 0) {
+        usados = completarParcialUBX(analizador, bloque, longitud, nuevosDatos);
+        if (analizador->bytesParcial > 0)
+            return usados;
+    }
+
+    return usados + escanearUBX(analizador, &bloque[usados], longitud - usados, nuevosDatos);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void guardarParcialUBX(analizadorUBX_t *analizador, const uint8_t *bloque, uint16_t longitud)
+**  Descripcion:    Copia el principio de una trama que da la vuelta al anillo. Son los
+**                  bytes que analizarBloqueUBX no ha consumido
+**  Parametros:     Analizador, bytes, longitud
+**  Retorno:        Ninguno
+****************************************************************************************/
+void guardarParcialUBX(analizadorUBX_t *analizador, const uint8_t *bloque, uint16_t longitud)
+{
+    if (analizador->bytesParcial + longitud + analizador->faltan > TAM_MAX_TRAMA_UBX) {
+        analizador->estadisticas.bytesDescartados += longitud;
+        return;
+    }
+
+    memcpy(&analizador->parcial[analizador->bytesParcial], bloque, longitud);
+    analizador->bytesParcial += longitud;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void checksumUBX(const uint8_t *dato, uint16_t longitud, uint8_t *ckA, uint8_t *ckB)
+**  Descripcion:    Acumula el checksum Fletcher de 8 bits de UBX. Las sumas se hacen en 32
+**                  bits y se truncan al final, que da lo mismo que sumar modulo 256
+**  Parametros:     Datos, longitud, ck_a, ck_b
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void checksumUBX(const uint8_t *dato, uint16_t longitud, uint8_t *ckA, uint8_t *ckB)
+{
+    uint32_t a = *ckA, b = *ckB;
+
+    for (; longitud >= 4; longitud -= 4, dato += 4) {
+        a += dato[0];
+        b += a;
+        a += dato[1];
+        b += a;
+        a += dato[2];
+        b += a;
+        a += dato[3];
+        b += a;
+    }
+
+    while (longitud--) {
+        a += *dato++;
+        b += a;
+    }
+
+    *ckA = a;
+    *ckB = b;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t escanearUBX(analizadorUBX_t *analizador, const uint8_t *bloque,
+**                                       uint16_t longitud, bool *nuevosDatos)
+**  Descripcion:    Busca y despacha las tramas completas de un tramo. Si una cabecera, la
+**                  longitud o el checksum no son validos se sigue buscando desde el byte
+**                  siguiente a la sincronizacion
+**  Parametros:     Analizador, tramo, longitud, nuevos datos
+**  Retorno:        Bytes consumidos
+****************************************************************************************/
+CODIGO_RAPIDO uint16_t escanearUBX(analizadorUBX_t *analizador, const uint8_t *bloque, uint16_t longitud, bool *nuevosDatos)
+{
+    uint16_t pos = 0;
+
+    analizador->faltan = 0;
+
+    while (pos < longitud) {
+        const uint8_t *sincronizacion = memchr(&bloque[pos], SINCRONIZACION1_UBX, longitud - pos);
+
+        if (sincronizacion == NULL) {
+            analizador->estadisticas.bytesDescartados += longitud - pos;
+            return longitud;
+        }
+
+        const uint16_t inicio = sincronizacion - bloque;
+        const uint16_t disponibles = longitud - inicio;
+
+        analizador->estadisticas.bytesDescartados += inicio - pos;
+        pos = inicio;
+
+        if (disponibles >= 2 && sincronizacion[1] != SINCRONIZACION2_UBX) {
+            analizador->estadisticas.bytesDescartados++;
+            pos++;
+            continue;
+        }
+
+        if (disponibles < TAM_CABECERA_UBX) {
+            analizador->faltan = TAM_CABECERA_UBX - disponibles;
+            return pos;
+        }
+
+        const uint16_t longitudPayload = sincronizacion[4] | (uint16_t)(sincronizacion[5] << 8);
+        if (longitudPayload > TAM_MAX_PAYLOAD_UBX) {
+            analizador->estadisticas.errorLongitud++;
+            analizador->estadisticas.bytesDescartados++;
+            pos++;
+            continue;
+        }
+
+        const uint16_t tamTrama = TAM_CABECERA_UBX + longitudPayload + TAM_CHECKSUM_UBX;
+        if (disponibles < tamTrama) {
+            analizador->faltan = tamTrama - disponibles;
+            return pos;
+        }
+
+        if (validarTramaUBX(analizador, sincronizacion, longitudPayload, nuevosDatos))
+            pos += tamTrama;
+        else {
+            analizador->estadisticas.bytesDescartados++;
+            pos++;
+        }
+    }
+
+    return pos;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t completarParcialUBX(analizadorUBX_t *analizador, const uint8_t *bloque,
+**                                               uint16_t longitud, bool *nuevosDatos)
+**  Descripcion:    Copia los bytes que faltan a la trama partida y la analiza. Si no era
+**                  valida, lo que queda en el buffer se vuelve a escanear
+**  Parametros:     Analizador, tramo, longitud, nuevos datos
+**  Retorno:        Bytes consumidos del tramo
+****************************************************************************************/
+uint16_t completarParcialUBX(analizadorUBX_t *analizador, const uint8_t *bloque, uint16_t longitud, bool *nuevosDatos)
+{
+    uint16_t usados = 0;
+
+    while (analizador->bytesParcial > 0 && usados < longitud) {
+        uint16_t copiar = longitud - usados;
+        if (copiar > analizador->faltan)
+            copiar = analizador->faltan;
+
+        memcpy(&analizador->parcial[analizador->bytesParcial], &bloque[usados], copiar);
+        analizador->bytesParcial += copiar;
+        analizador->faltan -= copiar;
+        usados += copiar;
+
+        if (analizador->faltan > 0)
+            break;
+
+        const uint32_t tramas = analizador->estadisticas.tramas;
+        const uint16_t consumidos = escanearUBX(analizador, analizador->parcial, analizador->bytesParcial, nuevosDatos);
+
+        analizador->estadisticas.tramasPartidas += analizador->estadisticas.tramas - tramas;
+        analizador->bytesParcial -= consumidos;
+        memmove(analizador->parcial, &analizador->parcial[consumidos], analizador->bytesParcial);
+    }
+
+    return usados;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool validarTramaUBX(analizadorUBX_t *analizador, const uint8_t *trama,
+**                                       uint16_t longitudPayload, bool *nuevosDatos)
+**  Descripcion:    Comprueba el checksum de la trama completa y la despacha
+**  Parametros:     Analizador, inicio de la trama, longitud del payload, nuevos datos
+**  Retorno:        True si el checksum es correcto
+****************************************************************************************/
+CODIGO_RAPIDO bool validarTramaUBX(analizadorUBX_t *analizador, const uint8_t *trama, uint16_t longitudPayload, bool *nuevosDatos)
+{
+    const uint8_t *checksum = &trama[TAM_CABECERA_UBX + longitudPayload];
+    uint8_t ckA = 0, ckB = 0;
+
+    // El checksum cubre clase, id, longitud y payload
+    checksumUBX(&trama[2], TAM_CABECERA_UBX - 2 + longitudPayload, &ckA, &ckB);
+    if (ckA != checksum[0] || ckB != checksum[1]) {
+        analizador->estadisticas.errorChecksum++;
+        return false;
+    }
+
+    const tramaUBX_t vista = {
+        .clase = trama[2],
+        .id = trama[3],
+        .longitud = longitudPayload,
+        .payload = &trama[TAM_CABECERA_UBX],
+    };
+
+    analizador->estadisticas.tramas++;
+    despacharTramaUBX(analizador, &vista, nuevosDatos);
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void despacharTramaUBX(analizadorUBX_t *analizador, const tramaUBX_t *trama, bool *nuevosDatos)
+**  Descripcion:    Llama al manejador de la tabla que corresponde a la clase e id
+**  Parametros:     Analizador, trama, nuevos datos
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void despacharTramaUBX(analizadorUBX_t *analizador, const tramaUBX_t *trama, bool *nuevosDatos)
+{
+    for (uint8_t i = 0; i < analizador->numEntradas; i++) {
+        const entradaTablaUBX_t *entrada = &analizador->tabla[i];
+
+        if (entrada->clase != trama->clase || (entrada->id != trama->id && entrada->id != CUALQUIER_ID_UBX))
+            continue;
+
+        if (trama->longitud < entrada->longitudMin) {
+            analizador->estadisticas.errorLongitud++;
+            return;
+        }
+
+        if (entrada->manejador(analizador->contexto, trama))
+            *nuevosDatos = true;
+        return;
+    }
+
+    if (analizador->manejadorDefecto != NULL && analizador->manejadorDefecto(analizador->contexto, trama))
+        *nuevosDatos = true;
+}
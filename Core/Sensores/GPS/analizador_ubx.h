@@ -0,0 +1,109 @@
+/***************************************************************************************
+**  analizador_ubx.h - Analizador de tramas UBX sobre tramos contiguos de bytes
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __ANALIZADOR_UBX_H
+#define __ANALIZADOR_UBX_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+/*
+ * El analizador trabaja sobre el tramo contiguo que da el anillo de recepcion: busca la
+ * sincronizacion con memchr, comprueba longitud y checksum de la trama completa en una
+ * pasada y entrega al manejador de la tabla un puntero al payload dentro del propio
+ * anillo. Los payload se leen con las estructuras PACKED, asi que no necesitan estar
+ * alineados. Si la trama esta incompleta al final del tramo se deja sin consumir hasta
+ * que lleguen el resto de bytes, y solo si da la vuelta al anillo se copia a buffer
+ */
+#define SINCRONIZACION1_UBX             0xB5
+#define SINCRONIZACION2_UBX             0x62
+#define TAM_CABECERA_UBX                6                  // Sincronizacion, clase, id y longitud
+#define TAM_CHECKSUM_UBX                2
+#define TAM_MAX_PAYLOAD_UBX             256
+#define TAM_MAX_TRAMA_UBX               (TAM_CABECERA_UBX + TAM_MAX_PAYLOAD_UBX + TAM_CHECKSUM_UBX)
+#define CUALQUIER_ID_UBX                0xFFFF             // Entrada de la tabla para todos los id de una clase
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    uint8_t clase;
+    uint8_t id;
+    uint16_t longitud;
+    const uint8_t *payload;               // En el anillo o en el buffer de tramas partidas
+} tramaUBX_t;
+
+typedef bool (*manejadorUBX_f)(void *contexto, const tramaUBX_t *trama);
+
+typedef struct {
+    uint8_t clase;
+    uint16_t id;                          // CUALQUIER_ID_UBX para toda la clase
+    uint16_t longitudMin;                 // Las tramas mas cortas se descartan
+    manejadorUBX_f manejador;
+} entradaTablaUBX_t;
+
+typedef struct {
+    uint32_t tramas;
+    uint32_t tramasPartidas;              // Tramas copiadas por dar la vuelta al anillo
+    uint32_t errorChecksum;
+    uint32_t errorLongitud;
+    uint32_t bytesDescartados;
+} estadisticasUBX_t;
+
+typedef struct {
+    uint8_t parcial[TAM_MAX_TRAMA_UBX] __attribute__((aligned(4)));
+    uint16_t bytesParcial;                // Bytes de una trama partida pendientes de completar
+    uint16_t faltan;                      // Bytes que faltan para completar la ultima trama vista
+    const entradaTablaUBX_t *tabla;
+    uint8_t numEntradas;
+    manejadorUBX_f manejadorDefecto;      // Para las tramas validas que no estan en la tabla
+    void *contexto;
+    estadisticasUBX_t estadisticas;
+} analizadorUBX_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+void iniciarAnalizadorUBX(analizadorUBX_t *analizador, const entradaTablaUBX_t *tabla, uint8_t numEntradas,
+                          manejadorUBX_f manejadorDefecto, void *contexto);
+void resetearAnalizadorUBX(analizadorUBX_t *analizador);
+uint16_t analizarBloqueUBX(analizadorUBX_t *analizador, const uint8_t *bloque, uint16_t longitud, bool *nuevosDatos);
+void guardarParcialUBX(analizadorUBX_t *analizador, const uint8_t *bloque, uint16_t longitud);
+void checksumUBX(const uint8_t *dato, uint16_t longitud, uint8_t *ckA, uint8_t *ckB);
+
+#endif // __ANALIZADOR_UBX_H
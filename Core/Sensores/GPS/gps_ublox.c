@@ -137,12 +137,46 @@ bool detectarUblox(gps_t *dGPS, uint8_t dato);
 void solicitarPuertoGPSublox(gps_t *dGPS);
 bool solicitarFrecuenciaMensajeGPSublox(gps_t *dGPS, uint8_t msgClass, uint8_t msgId);
 bool enviarMensajeGPSublox(gps_t *dGPS, uint8_t msgClass, uint8_t msgId, void *msg, uint16_t tam);
-void actualizarChecksumGPSublox(uint8_t *dato, uint16_t len, uint8_t *ck_a, uint8_t *ck_b);
-bool analizarTramaGPSublox(gps_t *dGPS);
+void copiarPayloadGPSublox(gpsUblox_t *driver, const tramaUBX_t *trama);
+bool manejarAckGPSublox(void *contexto, const tramaUBX_t *trama);
+bool ignorarTramaGPSublox(void *contexto, const tramaUBX_t *trama);
+bool manejarCfgNavGPSublox(void *contexto, const tramaUBX_t *trama);
+bool manejarCfgGNSSGPSublox(void *contexto, const tramaUBX_t *trama);
+bool manejarCfgSBASGPSublox(void *contexto, const tramaUBX_t *trama);
+bool manejarCfgMsgGPSublox(void *contexto, const tramaUBX_t *trama);
+bool manejarCfgPrtGPSublox(void *contexto, const tramaUBX_t *trama);
+bool manejarCfgRateGPSublox(void *contexto, const tramaUBX_t *trama);
+bool manejarPosllhGPSublox(void *contexto, const tramaUBX_t *trama);
+bool manejarStatusGPSublox(void *contexto, const tramaUBX_t *trama);
+bool manejarDOPGPSublox(void *contexto, const tramaUBX_t *trama);
+bool manejarSolGPSublox(void *contexto, const tramaUBX_t *trama);
+bool manejarPVTGPSublox(void *contexto, const tramaUBX_t *trama);
+bool manejarVelnedGPSublox(void *contexto, const tramaUBX_t *trama);
+bool manejarNavDesconocidoGPSublox(void *contexto, const tramaUBX_t *trama);
+bool nuevaNavegacionGPSublox(gpsUblox_t *driver);
 void verificarFrecuenciaMensajeGPSublox(gps_t *dGPS, uint8_t clase, uint8_t id, uint8_t frec);
 bool configurarFrecuenciaMensajeGPSublox(gps_t *dGPS, uint8_t clase, uint8_t id, uint8_t frec);
 void configurarFrecuenciaNavegacionGPSublox(gps_t *dGPS);
-void mensajeInesperadoGPSublox(gps_t *dGPS);
+bool mensajeInesperadoGPSublox(void *contexto, const tramaUBX_t *trama);
+
+// Manejadores de las tramas. El resto de clases van a mensajeInesperadoGPSublox
+static const entradaTablaUBX_t tablaGPSublox[] = {
+    {CLASS_NAV, MSG_PVT,              sizeof(navPVTubx_t),         manejarPVTGPSublox},
+    {CLASS_NAV, MSG_SOL,              sizeof(navSolutionUBX_t),    manejarSolGPSublox},
+    {CLASS_NAV, MSG_VELNED,           sizeof(navVelnedUBX_t),      manejarVelnedGPSublox},
+    {CLASS_NAV, MSG_DOP,              sizeof(navDOPubx_t),         manejarDOPGPSublox},
+    {CLASS_NAV, MSG_POSLLH,           sizeof(navPosllhUBX_t),      manejarPosllhGPSublox},
+    {CLASS_NAV, MSG_STATUS,           sizeof(navStatusUBX_t),      manejarStatusGPSublox},
+    {CLASS_NAV, CUALQUIER_ID_UBX,     0,                           manejarNavDesconocidoGPSublox},
+    {CLASS_ACK, MSG_ACK_ACK,          sizeof(ackAckUBX_t),         manejarAckGPSublox},
+    {CLASS_ACK, CUALQUIER_ID_UBX,     0,                           ignorarTramaGPSublox},
+    {CLASS_CFG, MSG_CFG_NAV_SETTINGS, sizeof(cfgNavSettingsUBX_t), manejarCfgNavGPSublox},
+    {CLASS_CFG, MSG_CFG_GNSS,         4,                           manejarCfgGNSSGPSublox},
+    {CLASS_CFG, MSG_CFG_SBAS,         sizeof(cfgSBASubx_t),        manejarCfgSBASGPSublox},
+    {CLASS_CFG, MSG_CFG_MSG,          sizeof(cfgMsgRateUBX_t),     manejarCfgMsgGPSublox},
+    {CLASS_CFG, MSG_CFG_PRT,          sizeof(cfgNavRateUBX_t),     manejarCfgPrtGPSublox},
+    {CLASS_CFG, MSG_CFG_RATE,         sizeof(cfgNavRateUBX_t),     manejarCfgRateGPSublox},
+};
 
 
 /***************************************************************************************
@@ -167,6 +201,7 @@ void iniciarGPSublox(gps_t *dGPS)
     driver->mensajesNoConfig = CONFIG_TODO_GPS;
     driver->siguienteFix = NO_FIX;
     driver->puertoUblox = 255;
+    iniciarAnalizadorUBX(&driver->analizador, tablaGPSublox, LONG_ARRAY(tablaGPSublox), mensajeInesperadoGPSublox, dGPS);
 
     switch (configGPS(dGPS->numGPS)->tipoGPS) {
         case GPS_UBLOX_NEO_6M:
@@ -394,8 +429,8 @@ bool enviarMensajeGPSublox(gps_t *dGPS, uint8_t msgClass, uint8_t msgId, void *m
     header.msgId = msgId;
     header.length = tam;
 
-    actualizarChecksumGPSublox((uint8_t *)&header.msgClass, sizeof(header) - 2, &ck_a, &ck_b);
-    actualizarChecksumGPSublox((uint8_t *)msg, tam, &ck_a, &ck_b);
+    checksumUBX(&header.msgClass, sizeof(header) - 2, &ck_a, &ck_b);
+    checksumUBX((uint8_t *)msg, tam, &ck_a, &ck_b);
 
     escribirBufferUART(configGPS(dGPS->numGPS)->dispUART, (uint8_t *)&header, sizeof(header));
     escribirBufferUART(configGPS(dGPS->numGPS)->dispUART, (uint8_t *)msg, tam);
@@ -405,32 +440,18 @@ bool enviarMensajeGPSublox(gps_t *dGPS, uint8_t msgClass, uint8_t msgId, void *m
 }
 
 
-/***************************************************************************************
-**  Nombre:         void actualizarChecksumGPSublox(uint8_t *dato, uint16_t tam, uint8_t &ck_a, uint8_t &ck_b)
-**  Descripcion:    Actualiza el checksum de la trama
-**  Parametros:     Datos, longitud, ck_a, ck_b
-**  Retorno:        Ninguno
-****************************************************************************************/
-void actualizarChecksumGPSublox(uint8_t *dato, uint16_t len, uint8_t *ck_a, uint8_t *ck_b)
-{
-    while (len--) {
-        *ck_a += *dato;
-        *ck_b += *ck_a;
-        dato++;
-    }
-}
-
-
 /***************************************************************************************
 **  Nombre:         bool leerGPSublox(gps_t *dGPS)
-**  Descripcion:    Lee la trama recibida y actualiza los datos
+**  Descripcion:    Analiza los bytes recibidos sobre el anillo de la UART y despacha las
+**                  tramas a sus manejadores
 **  Parametros:     Puntero al sensor
-**  Retorno:        Trama leida
+**  Retorno:        True si hay nueva posicion y velocidad
 ****************************************************************************************/
 bool leerGPSublox(gps_t *dGPS)
 {
     gpsUblox_t *driver = dGPS->driver;
-    uint8_t dato;
+    const numUART_e uart = configGPS(dGPS->numGPS)->dispUART;
+    const uint8_t *bloque;
     uint16_t numc;
     bool analizado = false;
 
@@ -443,462 +464,600 @@ bool leerGPSublox(gps_t *dGPS)
         }
     }
 
-    numc = bytesRecibidosUART(configGPS(dGPS->numGPS)->dispUART);
+    while ((numc = bloqueRecibidoUART(uart, &bloque)) > 0) {
+        const uint16_t usados = analizarBloqueUBX(&driver->analizador, bloque, numc, &analizado);
 
-    for (uint16_t i = 0; i < numc; i++) {                          // Procesa los bytes recibidos
-        dato = leerUART(configGPS(dGPS->numGPS)->dispUART);
+        consumirBloqueUART(uart, usados);
+        if (usados == numc)
+            continue;
 
-      reset:
-        switch (driver->estadoLectura) {
-            /*
-            Deteccion del preamble del mensaje
+        // Queda el principio de una trama. Si no hay mas bytes se deja en el anillo hasta que
+        // llegue el resto y si el resto esta al principio del anillo se copia
+        if (bytesRecibidosUART(uart) <= numc - usados)
+            break;
 
-            Si no podemos hacer coincidir cualquiera de los bytes esperados, reiniciamos
-            la maquina de estado y reconsidera el byte fallido como el primer byte del preamble.
-            Esto mejora nuestras posibilidades de recuperarse de un desajuste y lo hace menos
-            probable a que nos dejemos engañar por el pramble que aparece como datos en algun otro mensaje.
-            */
-            case 1:
-                if (PREAMBLE2 == dato) {
-                    driver->estadoLectura++;
-                    break;
-                }
-                else
-                    driver->estadoLectura = 0;
-                FALLTHROUGH;
-
-            case 0:
-                if (PREAMBLE1 == dato)
-                    driver->estadoLectura++;
-                break;
+        guardarParcialUBX(&driver->analizador, &bloque[usados], numc - usados);
+        consumirBloqueUART(uart, numc - usados);
+    }
+
+    return analizado;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void copiarPayloadGPSublox(gpsUblox_t *driver, const tramaUBX_t *trama)
+**  Descripcion:    Copia el payload al buffer de recepcion para los mensajes de
+**                  configuracion que se modifican y se devuelven al GPS
+**  Parametros:     Driver, trama
+**  Retorno:        Ninguno
+****************************************************************************************/
+void copiarPayloadGPSublox(gpsUblox_t *driver, const tramaUBX_t *trama)
+{
+    memset(&driver->bufferRecepcion, 0, sizeof(driver->bufferRecepcion));
+    memcpy(&driver->bufferRecepcion, trama->payload, MIN(trama->longitud, (uint16_t)sizeof(driver->bufferRecepcion)));
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool manejarAckGPSublox(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Procesa el ACK de los mensajes de configuracion
+**  Parametros:     GPS, trama
+**  Retorno:        False
+****************************************************************************************/
+bool manejarAckGPSublox(void *contexto, const tramaUBX_t *trama)
+{
+    gps_t *dGPS = contexto;
+    gpsUblox_t *driver = dGPS->driver;
+    const ackAckUBX_t *ack = (const ackAckUBX_t *)trama->payload;
+
+    if (ack->clsID != CLASS_CFG)
+        return false;
+
+    switch (ack->msgID) {
+        case MSG_CFG_CFG:
+            driver->cfgGuardada = true;
+            driver->cfgNecesitaGuardar = false;
+            break;
+
+        case MSG_CFG_GNSS:
+            driver->mensajesNoConfig &= ~CONFIG_GNSS_GPS;
+            break;
+
+        case MSG_CFG_MSG:
             /*
-            Procesamiento del encabezado del mensaje
+            No hay forma de saber que configuración de MSG fue ack, suponemos que fue la ultima solicitada.
+            Para verificar que vuelva a solicitar la ultima configuración que enviamos.
+            Si nos olvidamos el ack lo atraparemos la proxima vez a traves del ciclo pool, pero eso
+            sera un buen pedazo de tiempo despues.
+            */
+            break;
+
+        case MSG_CFG_NAV_SETTINGS:
+            driver->mensajesNoConfig &= ~CONFIG_NAV_SETTINGS_GPS;
+            break;
 
-            Detectamos la clase y el ID del mensaje para decidir si vamos a juntar los bytes del mensaje o simplemente descartarlos
-            Siempre recolectamos la longitud para que podamos evitar ser engañados por los bytes del preamble en los mensajes.
+        case MSG_CFG_RATE:
+            /*
+            El GPS enviara ACK por una tasa de actualizacion que no es valida. para detectar esto solo acepta la
+            tasa configurada leyendo las configuraciones y validando que todos coinciden con los valores objetivo
             */
-            case 2:
-                driver->estadoLectura++;
-                driver->claseMensaje = dato;
-                driver->ckbMensaje = driver->ckaMensaje = dato;             // Resetea los acumuladores del checksum
-                break;
+            break;
 
-            case 3:
-                driver->estadoLectura++;
-                driver->ckbMensaje += (driver->ckaMensaje += dato);         // Checksum byte
-                driver->idMensaje = dato;
-                break;
+        case MSG_CFG_SBAS:
+            driver->mensajesNoConfig &= ~CONFIG_SBAS_GPS;
+            break;
 
-            case 4:
-                driver->estadoLectura++;
-                driver->ckbMensaje += (driver->ckaMensaje += dato);         // Checksum byte
-                driver->longitudPayload = dato;                             // Byte bajo de longitud del payload
-                break;
+        case MSG_CFG_TP5:
+            break;
+    }
 
-            case 5:
-                driver->estadoLectura++;
-                driver->ckbMensaje += (driver->ckaMensaje += dato);         // Checksum byte
-                driver->longitudPayload += (uint16_t)(dato << 8);
-                if (driver->longitudPayload > TAM_BUFFER_RECEPCION_GPS_UBLOX) {
-                    driver->longitudPayload = 0;
-                    driver->estadoLectura = 0;
-                    goto reset;
-                }
-                if (driver->longitudPayload == 0)
-                    driver->estadoLectura = 7;
-                driver->contadorPayload = 0;                                // Prepara para recibir el payload
-                break;
+    return false;
+}
 
-            // Recibe los datos del mensaje
-            case 6:
-                driver->ckbMensaje += (driver->ckaMensaje += dato);         // checksum byte
-                if (driver->contadorPayload < TAM_BUFFER_RECEPCION_GPS_UBLOX)
-                    driver->bufferRecepcion.buffer[driver->contadorPayload] = dato;
 
-                driver->contadorPayload++;
-                if (driver->contadorPayload == driver->longitudPayload)
-                    driver->estadoLectura++;
-                break;
+/***************************************************************************************
+**  Nombre:         bool ignorarTramaGPSublox(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Manejador de los mensajes que no se procesan (NACK)
+**  Parametros:     GPS, trama
+**  Retorno:        False
+****************************************************************************************/
+bool ignorarTramaGPSublox(void *contexto, const tramaUBX_t *trama)
+{
+    return false;
+}
 
-            // Procesamiento del checksum y el mensaje
-            case 7:
-                driver->estadoLectura++;
-                if (driver->ckaMensaje != dato) {
-                    driver->estadoLectura = 0;
-                    goto reset;
-                }
-                break;
 
-            case 8:
-                driver->estadoLectura = 0;
-                if (driver->ckbMensaje != dato)
-                    break;                                                  // Checksum incorrecto
+/***************************************************************************************
+**  Nombre:         bool manejarCfgNavGPSublox(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Comprueba el modelo dinamico y la elevacion minima y los corrige
+**  Parametros:     GPS, trama
+**  Retorno:        False
+****************************************************************************************/
+bool manejarCfgNavGPSublox(void *contexto, const tramaUBX_t *trama)
+{
+    gps_t *dGPS = contexto;
+    gpsUblox_t *driver = dGPS->driver;
+    cfgNavSettingsUBX_t *navSettings = &driver->bufferRecepcion.navSettings;
 
-                if (analizarTramaGPSublox(dGPS))
-                    analizado = true;
-                break;
-        }
+    copiarPayloadGPSublox(driver, trama);
+
+    navSettings->mask = 0;
+    if (configGPS(dGPS->numGPS)->modoConf != GPS_ENGINE_NINGUNO && navSettings->dynModel != configGPS(dGPS->numGPS)->modoConf) {
+        // Recibimos la configuracion de navegación actual, cambiamos el modelo de configuracion y lo enviamos de vuelta
+        navSettings->dynModel = configGPS(dGPS->numGPS)->modoConf;
+        navSettings->mask |= 1;
     }
-    return analizado;
+    if (configGPS(dGPS->numGPS)->elevacionMin != -100 && navSettings->minElev != configGPS(dGPS->numGPS)->elevacionMin) {
+        navSettings->minElev = configGPS(dGPS->numGPS)->elevacionMin;
+        navSettings->mask |= 2;
+    }
+    if (navSettings->mask != 0) {
+        enviarMensajeGPSublox(dGPS, CLASS_CFG, MSG_CFG_NAV_SETTINGS, navSettings, sizeof(*navSettings));
+        driver->mensajesNoConfig |= CONFIG_NAV_SETTINGS_GPS;
+        driver->cfgNecesitaGuardar = true;
+    }
+    else
+        driver->mensajesNoConfig &= ~CONFIG_NAV_SETTINGS_GPS;
+
+    return false;
 }
 
 
 /***************************************************************************************
-**  Nombre:         bool analizarTramaGPSublox(gps_t *dGPS)
-**  Descripcion:    Analiza el mensaje recibido
-**  Parametros:     Puntero al sensor
-**  Retorno:        Trama analizada
+**  Nombre:         bool manejarCfgGNSSGPSublox(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Reparte los canales entre los sistemas GNSS configurados
+**  Parametros:     GPS, trama
+**  Retorno:        False
 ****************************************************************************************/
-bool analizarTramaGPSublox(gps_t *dGPS)
+bool manejarCfgGNSSGPSublox(void *contexto, const tramaUBX_t *trama)
 {
+    gps_t *dGPS = contexto;
     gpsUblox_t *driver = dGPS->driver;
+    cfgGNSSubx_t *gnss = &driver->bufferRecepcion.gnss;
 
-    if (driver->claseMensaje == CLASS_ACK) {
-        if (driver->idMensaje == MSG_ACK_ACK) {
-            switch (driver->bufferRecepcion.ack.clsID) {
-                case CLASS_CFG:
-                    switch (driver->bufferRecepcion.ack.msgID) {
-                        case MSG_CFG_CFG:
-                            driver->cfgGuardada = true;
-                            driver->cfgNecesitaGuardar = false;
-                            break;
-
-                        case MSG_CFG_GNSS:
-                            driver->mensajesNoConfig &= ~CONFIG_GNSS_GPS;
-                            break;
-
-                        case MSG_CFG_MSG:
-                            /*
-                            No hay forma de saber que configuración de MSG fue ack, suponemos que fue la ultima solicitada.
-                            Para verificar que vuelva a solicitar la ultima configuración que enviamos.
-                            Si nos olvidamos el ack lo atraparemos la proxima vez a traves del ciclo pool, pero eso
-                            sera un buen pedazo de tiempo despues.
-                            */
-                            break;
-
-                        case MSG_CFG_NAV_SETTINGS:
-                            driver->mensajesNoConfig &= ~CONFIG_NAV_SETTINGS_GPS;
-                            break;
-
-                        case MSG_CFG_RATE:
-                            /*
-                            El GPS enviara ACK por una tasa de actualizacion que no es valida. para detectar esto solo acepta la
-                            tasa configurada leyendo las configuraciones y validando que todos coinciden con los valores objetivo
-                            */
-                            break;
-
-                        case MSG_CFG_SBAS:
-                            driver->mensajesNoConfig &= ~CONFIG_SBAS_GPS;
-                            break;
-
-                        case MSG_CFG_TP5:
-                            break;
-                    }
-                    break;
+    if (configGPS(dGPS->numGPS)->gnss == 0) {
+        driver->mensajesNoConfig &= ~CONFIG_GNSS_GPS;
+        return false;
+    }
+
+    copiarPayloadGPSublox(driver, trama);
+    gnss->numConfigBlocks = MIN(gnss->numConfigBlocks, (uint8_t)NUM_MAX_GNSS_CONFIG_BLOCKS_GPS_UBLOX);
+
+    cfgGNSSubx_t gnssInicial = *gnss;
+    uint8_t gnssCnt = 0;
+
+    for (uint8_t i = 0; i < NUM_MAX_GNSS_CONFIG_BLOCKS_GPS_UBLOX; i++) {
+        if ((configGPS(dGPS->numGPS)->gnss & (1 << i)) && i != GNSS_SBAS)
+            gnssCnt++;
+    }
+
+    for (uint8_t i = 0; i < gnss->numConfigBlocks; i++) {
+        // Reserva una porcion igual de canales para todos los sistemas habilitados
+        if (configGPS(dGPS->numGPS)->gnss & (1 << gnss->configBlock[i].gnssId)) {
+            if (GNSS_SBAS != gnss->configBlock[i].gnssId) {
+                gnss->configBlock[i].resTrkCh = (gnss->numTrkChHw - 3) / (gnssCnt * 2);
+                gnss->configBlock[i].maxTrkCh = gnss->numTrkChHw;
             }
+            else {
+                gnss->configBlock[i].resTrkCh = 1;
+                gnss->configBlock[i].maxTrkCh = 3;
+            }
+            gnss->configBlock[i].flags = gnss->configBlock[i].flags | 0x00000001;
+        }
+        else {
+            gnss->configBlock[i].resTrkCh = 0;
+            gnss->configBlock[i].maxTrkCh = 0;
+            gnss->configBlock[i].flags = gnss->configBlock[i].flags & 0xFFFFFFFE;
         }
+    }
+    if (!memcmp(&gnssInicial, gnss, sizeof(gnssInicial))) {
+        enviarMensajeGPSublox(dGPS, CLASS_CFG, MSG_CFG_GNSS, gnss, 4 + (8 * gnss->numConfigBlocks));
+        driver->mensajesNoConfig |= CONFIG_GNSS_GPS;
+        driver->cfgNecesitaGuardar = true;
+    }
+    else
+        driver->mensajesNoConfig &= ~CONFIG_GNSS_GPS;
+
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool manejarCfgSBASGPSublox(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Comprueba el modo SBAS y lo corrige
+**  Parametros:     GPS, trama
+**  Retorno:        False
+****************************************************************************************/
+bool manejarCfgSBASGPSublox(void *contexto, const tramaUBX_t *trama)
+{
+    gps_t *dGPS = contexto;
+    gpsUblox_t *driver = dGPS->driver;
+    cfgSBASubx_t *sbas = &driver->bufferRecepcion.sbas;
+
+    if (configGPS(dGPS->numGPS)->modoSBAS == SBAS_SIN_CAMBIOS) {
+        driver->mensajesNoConfig &= ~CONFIG_SBAS_GPS;
         return false;
     }
 
-    if (driver->claseMensaje == CLASS_CFG) {
-        switch (driver->idMensaje) {
-            case MSG_CFG_NAV_SETTINGS:
-                driver->bufferRecepcion.navSettings.mask = 0;
-                if (configGPS(dGPS->numGPS)->modoConf != GPS_ENGINE_NINGUNO && driver->bufferRecepcion.navSettings.dynModel != configGPS(dGPS->numGPS)->modoConf) {
-                    // Recibimos la configuracion de navegación actual, cambiamos el modelo de configuracion y lo enviamos de vuelta
-                    driver->bufferRecepcion.navSettings.dynModel = configGPS(dGPS->numGPS)->modoConf;
-                    driver->bufferRecepcion.navSettings.mask |= 1;
-                }
-                if (configGPS(dGPS->numGPS)->elevacionMin != -100 && driver->bufferRecepcion.navSettings.minElev != configGPS(dGPS->numGPS)->elevacionMin) {
-                    driver->bufferRecepcion.navSettings.minElev = configGPS(dGPS->numGPS)->elevacionMin;
-                    driver->bufferRecepcion.navSettings.mask |= 2;
-                }
-                if (driver->bufferRecepcion.navSettings.mask != 0) {
-                    enviarMensajeGPSublox(dGPS, CLASS_CFG, MSG_CFG_NAV_SETTINGS, &driver->bufferRecepcion.navSettings, sizeof(driver->bufferRecepcion.navSettings));
-                    driver->mensajesNoConfig |= CONFIG_NAV_SETTINGS_GPS;
-                    driver->cfgNecesitaGuardar = true;
-                }
-                else
-                    driver->mensajesNoConfig &= ~CONFIG_NAV_SETTINGS_GPS;
-                return false;
-
-            case MSG_CFG_GNSS:
-                if (configGPS(dGPS->numGPS)->gnss != 0) {
-                    cfgGNSSubx_t gnssInicial = driver->bufferRecepcion.gnss;
-                    uint8_t gnssCnt = 0;
-
-                    for (uint8_t i = 0; i < NUM_MAX_GNSS_CONFIG_BLOCKS_GPS_UBLOX; i++) {
-                        if ((configGPS(dGPS->numGPS)->gnss & (1 << i)) && i != GNSS_SBAS)
-                            gnssCnt++;
-                    }
+    copiarPayloadGPSublox(driver, trama);
+    if (sbas->mode != configGPS(dGPS->numGPS)->modoSBAS) {
+        sbas->mode = configGPS(dGPS->numGPS)->modoSBAS;
+        enviarMensajeGPSublox(dGPS, CLASS_CFG, MSG_CFG_SBAS, sbas, sizeof(*sbas));
+        driver->mensajesNoConfig |= CONFIG_SBAS_GPS;
+        driver->cfgNecesitaGuardar = true;
+    }
+    else
+        driver->mensajesNoConfig &= ~CONFIG_SBAS_GPS;
 
-                    for (uint8_t i = 0; i < driver->bufferRecepcion.gnss.numConfigBlocks; i++) {
-                        // Reserva una porcion igual de canales para todos los sistemas habilitados
-                        if (configGPS(dGPS->numGPS)->gnss & (1 << driver->bufferRecepcion.gnss.configBlock[i].gnssId)) {
-                            if (GNSS_SBAS != driver->bufferRecepcion.gnss.configBlock[i].gnssId) {
-                                driver->bufferRecepcion.gnss.configBlock[i].resTrkCh = (driver->bufferRecepcion.gnss.numTrkChHw - 3) / (gnssCnt * 2);
-                                driver->bufferRecepcion.gnss.configBlock[i].maxTrkCh = driver->bufferRecepcion.gnss.numTrkChHw;
-                            }
-                            else {
-                                driver->bufferRecepcion.gnss.configBlock[i].resTrkCh = 1;
-                                driver->bufferRecepcion.gnss.configBlock[i].maxTrkCh = 3;
-                            }
-                            driver->bufferRecepcion.gnss.configBlock[i].flags = driver->bufferRecepcion.gnss.configBlock[i].flags | 0x00000001;
-                        }
-                        else {
-                            driver->bufferRecepcion.gnss.configBlock[i].resTrkCh = 0;
-                            driver->bufferRecepcion.gnss.configBlock[i].maxTrkCh = 0;
-                            driver->bufferRecepcion.gnss.configBlock[i].flags = driver->bufferRecepcion.gnss.configBlock[i].flags & 0xFFFFFFFE;
-                        }
-                    }
-                    if (!memcmp(&gnssInicial, &driver->bufferRecepcion.gnss, sizeof(gnssInicial))) {
-                        enviarMensajeGPSublox(dGPS, CLASS_CFG, MSG_CFG_GNSS, &driver->bufferRecepcion.gnss, 4 + (8 * driver->bufferRecepcion.gnss.numConfigBlocks));
-                        driver->mensajesNoConfig |= CONFIG_GNSS_GPS;
-                        driver->cfgNecesitaGuardar = true;
-                    }
-                    else
-                        driver->mensajesNoConfig &= ~CONFIG_GNSS_GPS;
-                }
-                else
-                    driver->mensajesNoConfig &= ~CONFIG_GNSS_GPS;
-                return false;
-
-            case MSG_CFG_SBAS:
-                if (configGPS(dGPS->numGPS)->modoSBAS != SBAS_SIN_CAMBIOS) {
-                    if (driver->bufferRecepcion.sbas.mode != configGPS(dGPS->numGPS)->modoSBAS) {
-                        driver->bufferRecepcion.sbas.mode = configGPS(dGPS->numGPS)->modoSBAS;
-                        enviarMensajeGPSublox(dGPS, CLASS_CFG, MSG_CFG_SBAS, &driver->bufferRecepcion.sbas, sizeof(driver->bufferRecepcion.sbas));
-                        driver->mensajesNoConfig |= CONFIG_SBAS_GPS;
-                        driver->cfgNecesitaGuardar = true;
-                    }
-                    else
-                        driver->mensajesNoConfig &= ~CONFIG_SBAS_GPS;
-                }
-                else
-                    driver->mensajesNoConfig &= ~CONFIG_SBAS_GPS;
-                return false;
-
-            case MSG_CFG_MSG:
-                if (driver->longitudPayload == sizeof(cfgMsgRate6UBX_t)) {
-                    if (driver->puertoUblox >= NUM_MAX_PUERTOS_GPS_UBLOX) {
-                        solicitarPuertoGPSublox(dGPS);
-                        return false;
-                    }
-                    verificarFrecuenciaMensajeGPSublox(dGPS, driver->bufferRecepcion.msgRate6.msgClass, driver->bufferRecepcion.msgRate6.msgId, driver->bufferRecepcion.msgRate6.rates[driver->puertoUblox]);
-                }
-                else
-                    verificarFrecuenciaMensajeGPSublox(dGPS, driver->bufferRecepcion.msgRate.msgClass, driver->bufferRecepcion.msgRate.msgId, driver->bufferRecepcion.msgRate.rate);
-                return false;
-
-            case MSG_CFG_PRT:
-                driver->puertoUblox = driver->bufferRecepcion.prt.portID;
-
-            case MSG_CFG_RATE:
-                if (driver->bufferRecepcion.navRate.measureRateMs != configGPS(dGPS->numGPS)->periodoMuestreo || driver->bufferRecepcion.navRate.navRate != 1 || driver->bufferRecepcion.navRate.timeRef != 0) {
-                    configurarFrecuenciaNavegacionGPSublox(dGPS);
-                    driver->mensajesNoConfig |= CONFIG_RATE_NAV_GPS;
-                    driver->cfgNecesitaGuardar = true;
-                }
-                else
-                    driver->mensajesNoConfig &= ~CONFIG_RATE_NAV_GPS;
-
-                return false;
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool manejarCfgMsgGPSublox(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Verifica la frecuencia de un mensaje. Con 8 bytes de payload vienen
+**                  las frecuencias de los 6 puertos
+**  Parametros:     GPS, trama
+**  Retorno:        False
+****************************************************************************************/
+bool manejarCfgMsgGPSublox(void *contexto, const tramaUBX_t *trama)
+{
+    gps_t *dGPS = contexto;
+    gpsUblox_t *driver = dGPS->driver;
+
+    if (trama->longitud == sizeof(cfgMsgRate6UBX_t)) {
+        const cfgMsgRate6UBX_t *msgRate6 = (const cfgMsgRate6UBX_t *)trama->payload;
+
+        if (driver->puertoUblox >= NUM_MAX_PUERTOS_GPS_UBLOX) {
+            solicitarPuertoGPSublox(dGPS);
+            return false;
         }
+        verificarFrecuenciaMensajeGPSublox(dGPS, msgRate6->msgClass, msgRate6->msgId, msgRate6->rates[driver->puertoUblox]);
+    }
+    else {
+        const cfgMsgRateUBX_t *msgRate = (const cfgMsgRateUBX_t *)trama->payload;
+        verificarFrecuenciaMensajeGPSublox(dGPS, msgRate->msgClass, msgRate->msgId, msgRate->rate);
     }
 
-    if (driver->claseMensaje != CLASS_NAV) {
-        mensajeInesperadoGPSublox(dGPS);
-        return false;
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool manejarCfgPrtGPSublox(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Guarda el puerto al que esta conectado el GPS y sigue como CFG-RATE
+**  Parametros:     GPS, trama
+**  Retorno:        False
+****************************************************************************************/
+bool manejarCfgPrtGPSublox(void *contexto, const tramaUBX_t *trama)
+{
+    gps_t *dGPS = contexto;
+    gpsUblox_t *driver = dGPS->driver;
+
+    driver->puertoUblox = ((const cfgPrtUBX_t *)trama->payload)->portID;
+    return manejarCfgRateGPSublox(contexto, trama);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool manejarCfgRateGPSublox(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Comprueba la frecuencia de navegacion y la corrige
+**  Parametros:     GPS, trama
+**  Retorno:        False
+****************************************************************************************/
+bool manejarCfgRateGPSublox(void *contexto, const tramaUBX_t *trama)
+{
+    gps_t *dGPS = contexto;
+    gpsUblox_t *driver = dGPS->driver;
+    const cfgNavRateUBX_t *navRate = (const cfgNavRateUBX_t *)trama->payload;
+
+    if (navRate->measureRateMs != configGPS(dGPS->numGPS)->periodoMuestreo || navRate->navRate != 1 || navRate->timeRef != 0) {
+        configurarFrecuenciaNavegacionGPSublox(dGPS);
+        driver->mensajesNoConfig |= CONFIG_RATE_NAV_GPS;
+        driver->cfgNecesitaGuardar = true;
     }
+    else
+        driver->mensajesNoConfig &= ~CONFIG_RATE_NAV_GPS;
 
-    switch (driver->idMensaje) {
-        case MSG_POSLLH:
-            if (driver->tienePVTmsg) {
-                driver->mensajesNoConfig |= CONFIG_RATE_POSLLH_GPS;
-                break;
-            }
-            driver->ultimoTiempoPos = driver->bufferRecepcion.posllh.itow;
-            dGPS->localizacion.longitud = driver->bufferRecepcion.posllh.longitude;
-            dGPS->localizacion.latitud = driver->bufferRecepcion.posllh.latitude;
-            dGPS->localizacion.altitud = driver->bufferRecepcion.posllh.altitudeMsl / 10;
-            dGPS->estado.status = driver->siguienteFix;
-            driver->nuevaPosicion = true;
-            dGPS->estado.precisionHorizontal = driver->bufferRecepcion.posllh.horizontalAccuracy * 1.0e-3f;
-            dGPS->estado.precisionVertical = driver->bufferRecepcion.posllh.verticalAccuracy * 1.0e-3f;
-            dGPS->estado.tienePrecisionHorizontal = true;
-            dGPS->estado.tienePrecisionVertical = true;
-            break;
+    return false;
+}
 
-        case MSG_STATUS:
-            if (driver->tienePVTmsg) {
-                driver->mensajesNoConfig |= CONFIG_RATE_STATUS_GPS;
-                break;
-            }
-            if (driver->bufferRecepcion.status.fixStatus & NAV_STATUS_FIX_VALID) {
-                if ((driver->bufferRecepcion.status.fixType == FIX_3D) && (driver->bufferRecepcion.status.fixStatus & NAV_STATUS_DGPS_USED))
-                    driver->siguienteFix = GPS_OK_FIX_3D_DGPS;
-                else if (driver->bufferRecepcion.status.fixType == FIX_3D)
-                    driver->siguienteFix = GPS_OK_FIX_3D;
-                else if (driver->bufferRecepcion.status.fixType == FIX_2D)
-                    driver->siguienteFix = GPS_OK_FIX_2D;
-                else {
-                    driver->siguienteFix = NO_FIX;
-                    dGPS->estado.status = NO_FIX;
-                }
-            }
-            else {
-                driver->siguienteFix = NO_FIX;
-                dGPS->estado.status = NO_FIX;
-            }
-            break;
 
-        case MSG_DOP:
-            driver->hdopNoRecibido = false;
-            dGPS->estado.hdop = driver->bufferRecepcion.dop.hDOP;
-            dGPS->estado.vdop = driver->bufferRecepcion.dop.vDOP;
-            break;
+/***************************************************************************************
+**  Nombre:         bool manejarPosllhGPSublox(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Actualiza la posicion con NAV-POSLLH si no se recibe NAV-PVT
+**  Parametros:     GPS, trama
+**  Retorno:        True si hay nueva posicion y velocidad
+****************************************************************************************/
+bool manejarPosllhGPSublox(void *contexto, const tramaUBX_t *trama)
+{
+    gps_t *dGPS = contexto;
+    gpsUblox_t *driver = dGPS->driver;
+    const navPosllhUBX_t *posllh = (const navPosllhUBX_t *)trama->payload;
 
-        case MSG_SOL:
-            if (driver->tienePVTmsg) {
-            	dGPS->estado.numSemana = driver->bufferRecepcion.solution.week;
-                break;
-            }
-            if (driver->bufferRecepcion.solution.fixStatus & NAV_STATUS_FIX_VALID) {
-                if ((driver->bufferRecepcion.solution.fixType == FIX_3D) && (driver->bufferRecepcion.solution.fixStatus & NAV_STATUS_DGPS_USED))
-                    driver->siguienteFix = GPS_OK_FIX_3D_DGPS;
-                else if (driver->bufferRecepcion.solution.fixType == FIX_3D)
-                    driver->siguienteFix = GPS_OK_FIX_3D;
-                else if (driver->bufferRecepcion.solution.fixType == FIX_2D)
-                    driver->siguienteFix = GPS_OK_FIX_2D;
-                else {
-                    driver->siguienteFix = NO_FIX;
-                    dGPS->estado.status = NO_FIX;
-                }
-            }
-            else {
-                driver->siguienteFix = NO_FIX;
-                dGPS->estado.status = NO_FIX;
-            }
-            if (driver->hdopNoRecibido)
-            	dGPS->estado.hdop = driver->bufferRecepcion.solution.positionDOP;
-
-            dGPS->estado.numSats = driver->bufferRecepcion.solution.satellites;
-            if (driver->siguienteFix >= GPS_OK_FIX_2D) {
-            	dGPS->estado.ultimaHoraGPSms = millis();
-            	dGPS->estado.horaSemana = driver->bufferRecepcion.solution.itow;
-            	dGPS->estado.numSemana = driver->bufferRecepcion.solution.week;
+    if (driver->tienePVTmsg) {
+        driver->mensajesNoConfig |= CONFIG_RATE_POSLLH_GPS;
+        return nuevaNavegacionGPSublox(driver);
+    }
+
+    driver->ultimoTiempoPos = posllh->itow;
+    dGPS->localizacion.longitud = posllh->longitude;
+    dGPS->localizacion.latitud = posllh->latitude;
+    dGPS->localizacion.altitud = posllh->altitudeMsl / 10;
+    dGPS->estado.status = driver->siguienteFix;
+    driver->nuevaPosicion = true;
+    dGPS->estado.precisionHorizontal = posllh->horizontalAccuracy * 1.0e-3f;
+    dGPS->estado.precisionVertical = posllh->verticalAccuracy * 1.0e-3f;
+    dGPS->estado.tienePrecisionHorizontal = true;
+    dGPS->estado.tienePrecisionVertical = true;
+
+    return nuevaNavegacionGPSublox(driver);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool manejarStatusGPSublox(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Actualiza el tipo de fix con NAV-STATUS si no se recibe NAV-PVT
+**  Parametros:     GPS, trama
+**  Retorno:        True si hay nueva posicion y velocidad
+****************************************************************************************/
+bool manejarStatusGPSublox(void *contexto, const tramaUBX_t *trama)
+{
+    gps_t *dGPS = contexto;
+    gpsUblox_t *driver = dGPS->driver;
+    const navStatusUBX_t *status = (const navStatusUBX_t *)trama->payload;
+
+    if (driver->tienePVTmsg) {
+        driver->mensajesNoConfig |= CONFIG_RATE_STATUS_GPS;
+        return nuevaNavegacionGPSublox(driver);
+    }
+
+    if (status->fixStatus & NAV_STATUS_FIX_VALID) {
+        if ((status->fixType == FIX_3D) && (status->fixStatus & NAV_STATUS_DGPS_USED))
+            driver->siguienteFix = GPS_OK_FIX_3D_DGPS;
+        else if (status->fixType == FIX_3D)
+            driver->siguienteFix = GPS_OK_FIX_3D;
+        else if (status->fixType == FIX_2D)
+            driver->siguienteFix = GPS_OK_FIX_2D;
+        else {
+            driver->siguienteFix = NO_FIX;
+            dGPS->estado.status = NO_FIX;
+        }
+    }
+    else {
+        driver->siguienteFix = NO_FIX;
+        dGPS->estado.status = NO_FIX;
+    }
+
+    return nuevaNavegacionGPSublox(driver);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool manejarDOPGPSublox(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Actualiza HDOP y VDOP con NAV-DOP
+**  Parametros:     GPS, trama
+**  Retorno:        True si hay nueva posicion y velocidad
+****************************************************************************************/
+bool manejarDOPGPSublox(void *contexto, const tramaUBX_t *trama)
+{
+    gps_t *dGPS = contexto;
+    gpsUblox_t *driver = dGPS->driver;
+    const navDOPubx_t *dop = (const navDOPubx_t *)trama->payload;
+
+    driver->hdopNoRecibido = false;
+    dGPS->estado.hdop = dop->hDOP;
+    dGPS->estado.vdop = dop->vDOP;
+
+    return nuevaNavegacionGPSublox(driver);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool manejarSolGPSublox(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Actualiza fix, satelites y hora con NAV-SOL y ajusta el RTC
+**  Parametros:     GPS, trama
+**  Retorno:        True si hay nueva posicion y velocidad
+****************************************************************************************/
+bool manejarSolGPSublox(void *contexto, const tramaUBX_t *trama)
+{
+    gps_t *dGPS = contexto;
+    gpsUblox_t *driver = dGPS->driver;
+    const navSolutionUBX_t *solution = (const navSolutionUBX_t *)trama->payload;
+
+    if (driver->tienePVTmsg) {
+        dGPS->estado.numSemana = solution->week;
+        return nuevaNavegacionGPSublox(driver);
+    }
+
+    if (solution->fixStatus & NAV_STATUS_FIX_VALID) {
+        if ((solution->fixType == FIX_3D) && (solution->fixStatus & NAV_STATUS_DGPS_USED))
+            driver->siguienteFix = GPS_OK_FIX_3D_DGPS;
+        else if (solution->fixType == FIX_3D)
+            driver->siguienteFix = GPS_OK_FIX_3D;
+        else if (solution->fixType == FIX_2D)
+            driver->siguienteFix = GPS_OK_FIX_2D;
+        else {
+            driver->siguienteFix = NO_FIX;
+            dGPS->estado.status = NO_FIX;
+        }
+    }
+    else {
+        driver->siguienteFix = NO_FIX;
+        dGPS->estado.status = NO_FIX;
+    }
+    if (driver->hdopNoRecibido)
+        dGPS->estado.hdop = solution->positionDOP;
+
+    dGPS->estado.numSats = solution->satellites;
+    if (driver->siguienteFix >= GPS_OK_FIX_2D) {
+        dGPS->estado.ultimaHoraGPSms = millis();
+        dGPS->estado.horaSemana = solution->itow;
+        dGPS->estado.numSemana = solution->week;
 #ifdef USAR_RTC
-                // Ajustamos el RTC
-                if (!tieneHoraRTC() && (driver->bufferRecepcion.solution.fixStatus & NAV_STATUS_TIME_SECOND_VALID) && (driver->bufferRecepcion.solution.fixStatus & NAV_STATUS_TIME_WEEK_VALID)) {
-                    //Calculamos el tiempo Unix: numero de semana * ms en una semana + ms de la semana + fracciones de segundo + offset del UNIX - 18 segundos de desfase entre tiempo Unix y el GPS
-                    int64_t tiempoUnix = (((int64_t) driver->bufferRecepcion.solution.week) * 7 * 24 * 60 * 60 * 1000) + driver->bufferRecepcion.solution.itow + (driver->bufferRecepcion.solution.timeNsec / 1000000) + 315964800000LL - configRTC()->offsetGPSutc * 1000;
-                    ajustarUnixRTC(tiempoUnix);
-                }
+        // Ajustamos el RTC
+        if (!tieneHoraRTC() && (solution->fixStatus & NAV_STATUS_TIME_SECOND_VALID) && (solution->fixStatus & NAV_STATUS_TIME_WEEK_VALID)) {
+            //Calculamos el tiempo Unix: numero de semana * ms en una semana + ms de la semana + fracciones de segundo + offset del UNIX - 18 segundos de desfase entre tiempo Unix y el GPS
+            int64_t tiempoUnix = (((int64_t) solution->week) * 7 * 24 * 60 * 60 * 1000) + solution->itow + (solution->timeNsec / 1000000) + 315964800000LL - configRTC()->offsetGPSutc * 1000;
+            ajustarUnixRTC(tiempoUnix);
+        }
 #endif
-            }
-            break;
+    }
 
-        case MSG_PVT:
-            driver->tienePVTmsg = true;
-
-            // Posicion
-            driver->ultimoTiempoPos = driver->bufferRecepcion.pvt.itow;
-            dGPS->localizacion.longitud = driver->bufferRecepcion.pvt.lon;
-            dGPS->localizacion.latitud = driver->bufferRecepcion.pvt.lat;
-            dGPS->localizacion.altitud = driver->bufferRecepcion.pvt.h_msl / 10;
-            switch (driver->bufferRecepcion.pvt.fixType) {
-                case 0:
-                	dGPS->estado.status = NO_FIX;
-                    break;
+    return nuevaNavegacionGPSublox(driver);
+}
 
-                case 1:
-                	dGPS->estado.status = NO_FIX;
-                    break;
 
-                case 2:
-                	dGPS->estado.status = GPS_OK_FIX_2D;
-                    break;
+/***************************************************************************************
+**  Nombre:         bool manejarPVTGPSublox(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Actualiza posicion, velocidad, fix, DOP y hora con NAV-PVT
+**  Parametros:     GPS, trama
+**  Retorno:        True si hay nueva posicion y velocidad
+****************************************************************************************/
+bool manejarPVTGPSublox(void *contexto, const tramaUBX_t *trama)
+{
+    gps_t *dGPS = contexto;
+    gpsUblox_t *driver = dGPS->driver;
+    const navPVTubx_t *pvt = (const navPVTubx_t *)trama->payload;
 
-                case 3:
-                	dGPS->estado.status = GPS_OK_FIX_3D;
-                    if (driver->bufferRecepcion.pvt.flags & 0b00000010)  // Se han aplicado correcciones diferenciales
-                    	dGPS->estado.status = GPS_OK_FIX_3D_DGPS;
-                    if (driver->bufferRecepcion.pvt.flags & 0b01000000)  // carrsoln - float
-                    	dGPS->estado.status = GPS_OK_FIX_3D_RTK_FLOAT;
-                    if (driver->bufferRecepcion.pvt.flags & 0b10000000)  // carrsoln - fixed
-                    	dGPS->estado.status = GPS_OK_FIX_3D_RTK_FIXED;
-                    break;
+    driver->tienePVTmsg = true;
 
-                case 4:
-                	dGPS->estado.status = GPS_OK_FIX_3D;
-                    break;
+    // Posicion
+    driver->ultimoTiempoPos = pvt->itow;
+    dGPS->localizacion.longitud = pvt->lon;
+    dGPS->localizacion.latitud = pvt->lat;
+    dGPS->localizacion.altitud = pvt->h_msl / 10;
+    switch (pvt->fixType) {
+        case 0:
+            dGPS->estado.status = NO_FIX;
+            break;
 
-                case 5:
-                	dGPS->estado.status = NO_FIX;
-                    break;
+        case 1:
+            dGPS->estado.status = NO_FIX;
+            break;
 
-                default:
-                	dGPS->estado.status = NO_FIX;
-                    break;
-            }
-            driver->siguienteFix = dGPS->estado.status;
-            driver->nuevaPosicion = true;
-            dGPS->estado.precisionHorizontal = driver->bufferRecepcion.pvt.hAcc * 1.0e-3f;
-            dGPS->estado.precisionVertical = driver->bufferRecepcion.pvt.vAcc * 1.0e-3f;
-            dGPS->estado.tienePrecisionHorizontal = true;
-            dGPS->estado.tienePrecisionVertical = true;
-
-            // Satelites
-            dGPS->estado.numSats = driver->bufferRecepcion.pvt.numSv;
-
-            // Velocidad
-            driver->ultimoTiempoVel = driver->bufferRecepcion.pvt.itow;
-            dGPS->vel2d = driver->bufferRecepcion.pvt.gspeed * 0.001f;                          // m/s
-            dGPS->velAngular = envolverInt360(driver->bufferRecepcion.pvt.head_mot * 1.0e-5f, 1);  // Heading 2D deg * 100000
-            dGPS->estado.tieneVelVertical = true;
-            dGPS->velocidad.norte = driver->bufferRecepcion.pvt.velN * 0.001f;
-            dGPS->velocidad.este = driver->bufferRecepcion.pvt.velE * 0.001f;
-            dGPS->velocidad.vertical = driver->bufferRecepcion.pvt.velD * 0.001f;
-            dGPS->estado.tienePrecisionVel = true;
-            dGPS->estado.precisionVel = driver->bufferRecepcion.pvt.sAcc * 0.001f;
-            driver->nuevaVelocidad = true;
-
-            // DOP
-            if (driver->hdopNoRecibido) {
-            	dGPS->estado.hdop = driver->bufferRecepcion.pvt.pDop;
-            	dGPS->estado.vdop = driver->bufferRecepcion.pvt.pDop;
-            }
-            dGPS->estado.ultimaHoraGPSms = millis();
+        case 2:
+            dGPS->estado.status = GPS_OK_FIX_2D;
+            break;
 
-            // Tiempo
-            dGPS->estado.horaSemana = driver->bufferRecepcion.pvt.itow;
+        case 3:
+            dGPS->estado.status = GPS_OK_FIX_3D;
+            if (pvt->flags & 0b00000010)  // Se han aplicado correcciones diferenciales
+                dGPS->estado.status = GPS_OK_FIX_3D_DGPS;
+            if (pvt->flags & 0b01000000)  // carrsoln - float
+                dGPS->estado.status = GPS_OK_FIX_3D_RTK_FLOAT;
+            if (pvt->flags & 0b10000000)  // carrsoln - fixed
+                dGPS->estado.status = GPS_OK_FIX_3D_RTK_FIXED;
             break;
 
-        case MSG_VELNED:
-            if (driver->tienePVTmsg) {
-                driver->mensajesNoConfig |= CONFIG_RATE_VELNED_GPS;
-                break;
-            }
-            driver->ultimoTiempoVel = driver->bufferRecepcion.velned.itow;
-            dGPS->vel2d = driver->bufferRecepcion.velned.speed2d * 0.01f;                       // m/s
-            dGPS->velAngular = envolverInt360(driver->bufferRecepcion.velned.heading2d * 1.0e-5f, 1);    // Heading 2D deg * 100000
-            dGPS->estado.tieneVelVertical = true;
-            dGPS->velocidad.norte = driver->bufferRecepcion.velned.nedNorth * 0.01f;
-            dGPS->velocidad.este = driver->bufferRecepcion.velned.nedEast * 0.01f;
-            dGPS->velocidad.vertical = driver->bufferRecepcion.velned.nedDown * 0.01f;
-            dGPS->velAngular = envolverInt360(grados(atan2f(dGPS->velocidad.este, dGPS->velocidad.norte)), 1);
-            dGPS->vel2d = sqrtf(powf((float)dGPS->velocidad.este, 2) + powf((float)dGPS->velocidad.norte, 2));
-            dGPS->estado.tienePrecisionVel = true;
-            dGPS->estado.precisionVel = driver->bufferRecepcion.velned.speedAccuracy * 0.01f;
-            driver->nuevaVelocidad = true;
+        case 4:
+            dGPS->estado.status = GPS_OK_FIX_3D;
+            break;
+
+        case 5:
+            dGPS->estado.status = NO_FIX;
             break;
 
         default:
-            if (++driver->contadorDeshabilitacion == 0)
-                configurarFrecuenciaMensajeGPSublox(dGPS, CLASS_NAV, driver->idMensaje, 0);
-            return false;
+            dGPS->estado.status = NO_FIX;
+            break;
+    }
+    driver->siguienteFix = dGPS->estado.status;
+    driver->nuevaPosicion = true;
+    dGPS->estado.precisionHorizontal = pvt->hAcc * 1.0e-3f;
+    dGPS->estado.precisionVertical = pvt->vAcc * 1.0e-3f;
+    dGPS->estado.tienePrecisionHorizontal = true;
+    dGPS->estado.tienePrecisionVertical = true;
+
+    // Satelites
+    dGPS->estado.numSats = pvt->numSv;
+
+    // Velocidad
+    driver->ultimoTiempoVel = pvt->itow;
+    dGPS->vel2d = pvt->gspeed * 0.001f;                          // m/s
+    dGPS->velAngular = envolverInt360(pvt->head_mot * 1.0e-5f, 1);  // Heading 2D deg * 100000
+    dGPS->estado.tieneVelVertical = true;
+    dGPS->velocidad.norte = pvt->velN * 0.001f;
+    dGPS->velocidad.este = pvt->velE * 0.001f;
+    dGPS->velocidad.vertical = pvt->velD * 0.001f;
+    dGPS->estado.tienePrecisionVel = true;
+    dGPS->estado.precisionVel = pvt->sAcc * 0.001f;
+    driver->nuevaVelocidad = true;
+
+    // DOP
+    if (driver->hdopNoRecibido) {
+        dGPS->estado.hdop = pvt->pDop;
+        dGPS->estado.vdop = pvt->pDop;
     }
+    dGPS->estado.ultimaHoraGPSms = millis();
 
+    // Tiempo
+    dGPS->estado.horaSemana = pvt->itow;
+
+    return nuevaNavegacionGPSublox(driver);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool manejarVelnedGPSublox(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Actualiza la velocidad con NAV-VELNED si no se recibe NAV-PVT
+**  Parametros:     GPS, trama
+**  Retorno:        True si hay nueva posicion y velocidad
+****************************************************************************************/
+bool manejarVelnedGPSublox(void *contexto, const tramaUBX_t *trama)
+{
+    gps_t *dGPS = contexto;
+    gpsUblox_t *driver = dGPS->driver;
+    const navVelnedUBX_t *velned = (const navVelnedUBX_t *)trama->payload;
+
+    if (driver->tienePVTmsg) {
+        driver->mensajesNoConfig |= CONFIG_RATE_VELNED_GPS;
+        return nuevaNavegacionGPSublox(driver);
+    }
+
+    driver->ultimoTiempoVel = velned->itow;
+    dGPS->vel2d = velned->speed2d * 0.01f;                       // m/s
+    dGPS->velAngular = envolverInt360(velned->heading2d * 1.0e-5f, 1);    // Heading 2D deg * 100000
+    dGPS->estado.tieneVelVertical = true;
+    dGPS->velocidad.norte = velned->nedNorth * 0.01f;
+    dGPS->velocidad.este = velned->nedEast * 0.01f;
+    dGPS->velocidad.vertical = velned->nedDown * 0.01f;
+    dGPS->velAngular = envolverInt360(grados(atan2f(dGPS->velocidad.este, dGPS->velocidad.norte)), 1);
+    dGPS->vel2d = sqrtf(powf((float)dGPS->velocidad.este, 2) + powf((float)dGPS->velocidad.norte, 2));
+    dGPS->estado.tienePrecisionVel = true;
+    dGPS->estado.precisionVel = velned->speedAccuracy * 0.01f;
+    driver->nuevaVelocidad = true;
+
+    return nuevaNavegacionGPSublox(driver);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool manejarNavDesconocidoGPSublox(void *contexto, const tramaUBX_t *trama)
+**  Descripcion:    Deshabilita cada 256 mensajes los NAV que no se usan
+**  Parametros:     GPS, trama
+**  Retorno:        False
+****************************************************************************************/
+bool manejarNavDesconocidoGPSublox(void *contexto, const tramaUBX_t *trama)
+{
+    gps_t *dGPS = contexto;
+    gpsUblox_t *driver = dGPS->driver;
+
+    if (++driver->contadorDeshabilitacion == 0)
+        configurarFrecuenciaMensajeGPSublox(dGPS, CLASS_NAV, trama->id, 0);
+
+    return false;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool nuevaNavegacionGPSublox(gpsUblox_t *driver)
+**  Descripcion:    Comprueba si ya se tienen la posicion y la velocidad de la misma epoca
+**  Parametros:     Driver
+**  Retorno:        True si hay nueva posicion y velocidad
+****************************************************************************************/
+bool nuevaNavegacionGPSublox(gpsUblox_t *driver)
+{
     // solo devolvemos true cuando obtenemos nuevos datos de posición y velocidad
     if (driver->nuevaPosicion && driver->nuevaVelocidad && driver->ultimoTiempoVel == driver->ultimoTiempoPos) {
         driver->nuevaVelocidad = driver->nuevaPosicion = false;
@@ -1027,19 +1186,22 @@ void configurarFrecuenciaNavegacionGPSublox(gps_t *dGPS)
 
 
 /***************************************************************************************
-**  Nombre:         void mensajeInesperadoGPSublox(gps_t *dGPS)
+**  Nombre:         bool mensajeInesperadoGPSublox(void *contexto, const tramaUBX_t *trama)
 **  Descripcion:    Deshabilita el envio del mensaje si el contador llega a 256
-**  Parametros:     Puntero al GPS
-**  Retorno:        Ninguno
+**  Parametros:     Puntero al GPS, trama
+**  Retorno:        False
 ****************************************************************************************/
-void mensajeInesperadoGPSublox(gps_t *dGPS)
+bool mensajeInesperadoGPSublox(void *contexto, const tramaUBX_t *trama)
 {
+    gps_t *dGPS = contexto;
     gpsUblox_t *driver = dGPS->driver;
 
     // Deshabilitar futuros envios de este mensaje, pero solo se hace esto cada 256 mensajes porque algunos de
     // los tipos de mensajes no pueden ser deshabilitados y no queremos entrar en una guerra de ack
     if (++driver->contadorDeshabilitacion == 0)
-        configurarFrecuenciaMensajeGPSublox(dGPS, driver->claseMensaje, driver->idMensaje, 0);
+        configurarFrecuenciaMensajeGPSublox(dGPS, trama->clase, trama->id, 0);
+
+    return false;
 }
 
 #endif
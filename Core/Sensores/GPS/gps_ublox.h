@@ -32,6 +32,7 @@
 #include <stdbool.h>
 
 #include "gps.h"
+#include "analizador_ubx.h"
 #include "Comun/util.h"
 
 
@@ -40,7 +41,7 @@
 ****************************************************************************************/
 #define MODO_BINARIO_GPS_UBLOX                "\265\142\006\001\003\000\001\006\001\022\117$PUBX,41,1,0023,0001,115200,0*1C\r\n"
 
-#define TAM_BUFFER_RECEPCION_GPS_UBLOX         256
+#define TAM_BUFFER_RECEPCION_GPS_UBLOX         TAM_MAX_PAYLOAD_UBX
 #define NUM_MAX_PUERTOS_GPS_UBLOX              6          // Numero maximo de puertos
 #define NUM_MAX_GNSS_CONFIG_BLOCKS_GPS_UBLOX   7
 #define TIEMPO_RETARDO_CONFIG_GPS_UBLOX        300        // Tiempo entre envios de configuracion en ms
@@ -236,7 +237,7 @@ typedef struct {
     uint8_t msgID;
 } PACKED ackAckUBX_t;
 
-// Buffer de recepcion
+// Copia de los mensajes de configuracion que se modifican y se devuelven al GPS
 typedef union {
 	navPosllhUBX_t posllh;
 	navStatusUBX_t status;
@@ -259,13 +260,7 @@ typedef union {
 
 typedef struct {
     bufferRecepcion_u bufferRecepcion;
-    uint8_t estadoLectura;                            // Estado de la maquina de estados de lectura de mensajes
-    uint8_t claseMensaje;                             // Clase del mensaje recibido
-    uint8_t idMensaje;                                // Id del mensaje recibido
-    uint8_t ckaMensaje;                               // Ck_a del mensaje recibido
-    uint8_t ckbMensaje;                               // Ck_b del mensaje recibido
-    uint16_t longitudPayload;                         // Longitud del payload del mensaje recibido
-    uint16_t contadorPayload;                         // Contador para la recepcion de datos recibidos
+    analizadorUBX_t analizador;                       // Analizador de las tramas recibidas
     bool cfgGuardada;                                 // Determina si la configuracion se ha guardado
     uint32_t ultimoTiempoVel;                         // Ultimo tiempo en el que se ha obtenido la velocidad
     uint32_t ultimoTiempoPos;                         // Ultimo tiempo en el que se ha obtenido la posicion
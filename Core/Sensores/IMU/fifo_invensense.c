@@ -0,0 +1,116 @@
+/***************************************************************************************
+**  fifo_invensense.c - Funciones de decodificacion de la FIFO de las IMU Invensense
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include "fifo_invensense.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         uint16_t leerCuentaFifoInvensense(const uint8_t *cuentaRaw)
+**  Descripcion:    Obtiene el numero de bytes de la FIFO de los registros FIFO_COUNTH/L
+**  Parametros:     Registros leidos
+**  Retorno:        Bytes en la FIFO
+****************************************************************************************/
+uint16_t leerCuentaFifoInvensense(const uint8_t *cuentaRaw)
+{
+    // Los bits altos no usados de FIFO_COUNTH se leen a 0 en todos los modelos
+    return (uint16_t)((cuentaRaw[0] << 8) | cuentaRaw[1]);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool fifoInvensenseDesbordada(uint16_t bytes, uint16_t tamFifo)
+**  Descripcion:    Comprueba si la FIFO se ha llenado. Cuando no cabe una muestra mas el
+**                  sensor descarta las mas antiguas y la alineacion se pierde
+**  Parametros:     Bytes en la FIFO, tamanio de la FIFO del sensor
+**  Retorno:        True si se han perdido muestras
+****************************************************************************************/
+bool fifoInvensenseDesbordada(uint16_t bytes, uint16_t tamFifo)
+{
+    return bytes + TAM_MUESTRA_FIFO_INVENSENSE > tamFifo;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool fifoInvensenseAlineada(uint16_t bytes)
+**  Descripcion:    Comprueba que la FIFO contiene muestras completas
+**  Parametros:     Bytes en la FIFO
+**  Retorno:        True si esta alineada
+****************************************************************************************/
+bool fifoInvensenseAlineada(uint16_t bytes)
+{
+    return (bytes % TAM_MUESTRA_FIFO_INVENSENSE) == 0;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t parsearFifoInvensense(const uint8_t *buffer, uint16_t longitud,
+**                                                 muestraFifoInvensense_t *muestras, uint16_t maxMuestras)
+**  Descripcion:    Decodifica en una pasada las muestras completas de una rafaga de la FIFO.
+**                  Los bytes de una muestra incompleta al final se ignoran
+**  Parametros:     Bytes leidos, longitud, muestras decodificadas, maximo de muestras
+**  Retorno:        Numero de muestras decodificadas
+****************************************************************************************/
+uint16_t parsearFifoInvensense(const uint8_t *buffer, uint16_t longitud, muestraFifoInvensense_t *muestras, uint16_t maxMuestras)
+{
+    uint16_t numMuestras = longitud / TAM_MUESTRA_FIFO_INVENSENSE;
+
+    if (numMuestras > maxMuestras)
+        numMuestras = maxMuestras;
+
+    for (uint16_t i = 0; i < numMuestras; i++) {
+        const uint8_t *p = &buffer[i * TAM_MUESTRA_FIFO_INVENSENSE];
+
+        for (uint8_t j = 0; j < NUM_EJES_FIFO_INVENSENSE; j++)
+            muestras[i][j] = (int16_t)((p[2 * j] << 8) | p[2 * j + 1]);
+    }
+
+    return numMuestras;
+}
@@ -0,0 +1,73 @@
+/***************************************************************************************
+**  fifo_invensense.h - Funciones de decodificacion de la FIFO de las IMU Invensense
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __FIFO_INVENSENSE_H
+#define __FIFO_INVENSENSE_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define TAM_MUESTRA_FIFO_INVENSENSE        14      // Acel (6) + temperatura (2) + giro (6), big endian
+#define NUM_EJES_FIFO_INVENSENSE           7
+
+// Tamanio de la FIFO de cada sensor en bytes
+#define TAM_FIFO_MPU6000_INVENSENSE        1024
+#define TAM_FIFO_MPU9250_INVENSENSE        512
+#define TAM_FIFO_ICM20602_INVENSENSE       1008
+#define TAM_FIFO_ICM20689_INVENSENSE       4096
+#define TAM_FIFO_ICM20789_INVENSENSE       512
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+/*
+ * El modulo no depende de la HAL ni del bus para poder probar el decodificador en el PC
+ * con tramas de la FIFO grabadas. Cada muestra queda en el mismo orden que los
+ * registros: acel X, Y, Z, temperatura, giro X, Y, Z
+ */
+typedef int16_t muestraFifoInvensense_t[NUM_EJES_FIFO_INVENSENSE];
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+uint16_t leerCuentaFifoInvensense(const uint8_t *cuentaRaw);
+bool fifoInvensenseDesbordada(uint16_t bytes, uint16_t tamFifo);
+bool fifoInvensenseAlineada(uint16_t bytes);
+uint16_t parsearFifoInvensense(const uint8_t *buffer, uint16_t longitud, muestraFifoInvensense_t *muestras, uint16_t maxMuestras);
+
+#endif // __FIFO_INVENSENSE_H
@@ -33,7 +33,11 @@
 
 #ifdef USAR_IMU
 #include "GP/gp_imu.h"
-#include "Filtros/filtro_pasa_bajo.h"
+#include "Filtros/banco_biquad.h"
+#include "Filtros/analizador_espectro.h"
+#include "Filtros/banco_notch_rpm.h"
+#include "Motores/telemetria_dshot.h"
+#include "GP/gp_motor.h"
 #include "Core/led_estado.h"
 #include "Drivers/tiempo.h"
 #include "Scheduler/scheduler.h"
@@ -54,6 +58,11 @@
 
 #define TOLERANCIA_CAL_GIRO           0.5      // En º/s
 #define TOLERANCIA_CAL_ACEL           0.005    // En g
+
+#define CANALES_FILTRO_IMU            6        // Acelerometro y giroscopo de cada IMU en el banco de filtros
+#define ARMONICOS_NOTCH_DINAMICO      (NUM_MAX_ETAPAS_BANCO_BIQUAD - 1)   // Etapas del banco tras el pasa bajo
+#define LIMITE_NYQUIST_NOTCH_DINAMICO 0.48f
+#define AJUSTES_PASO_NOTCH_RPM        8        // Notch RPM reajustados en cada lectura
 //#define USAR_CORRECCION_CONING
 
 
@@ -77,8 +86,13 @@ static imu_t imu[NUM_MAX_IMU];
 static imuGen_t imuGen;
 static uint8_t cntIMUSconectadas = 0;
 static tablaFnIMU_t *tablaFnIMU[NUM_MAX_IMU];
-static filtroPasaBajo2P_t filtroAcelIMU[3][NUM_MAX_IMU];
-static filtroPasaBajo2P_t filtroGiroIMU[3][NUM_MAX_IMU];
+static bancoBiquad_t filtroIMU;
+static analizadorEspectro_t analizadorIMU;
+static bool notchDinamico;
+#ifdef USAR_SALIDA_DSHOT
+static bancoNotchRPM_t notchRPMimu;
+static bool notchRPM;
+#endif
 static bool failsafeIMU;
 
 
@@ -101,6 +115,8 @@ void actualizarDriverIMU(imu_t *dIMU);
 void corregirIMU(float *giro, float *acel, calIMU_t calIMU);
 void rotarIMU(rotacionSensor_t rotacion, float *giro, float *acel);
 void actualizarIMUoperativo(imu_t *dIMU);
+void ajustarNotchDinamicoIMU(uint8_t eje, float frecuencia);
+bool telemetriaRPMdisponibleIMU(void);
 
 
 /***************************************************************************************
@@ -123,6 +139,18 @@ bool iniciarIMU(void)
 
     // Reseteamos las variables del sensor
     memset(&imuGen, 0, sizeof(imuGen_t));
+    // Los notch dinamicos ocupan las etapas siguientes al pasa bajo y dejan pasar la senial hasta tener picos
+    notchDinamico = configNotchDinamico()->habilitado &&
+                    iniciarAnalizadorEspectro(&analizadorIMU, configIMU(0)->frecLeer, configNotchDinamico()->frecMin, configNotchDinamico()->frecMax);
+    iniciarBancoBiquad(&filtroIMU, CANALES_FILTRO_IMU * NUM_MAX_IMU, notchDinamico ? 1 + ARMONICOS_NOTCH_DINAMICO : 1);
+#ifdef USAR_SALIDA_DSHOT
+    // Los notch RPM siguen la telemetria de los motores sobre los tres ejes del giro de cada IMU. Sin DShot
+    // bidireccional no llega la frecuencia de los rotores y no se activarian nunca
+    notchRPM = configNotchRPM()->habilitado && telemetriaRPMdisponibleIMU() &&
+               iniciarBancoNotchRPM(&notchRPMimu, 3 * NUM_MAX_IMU, configMotor()->numMotores, configNotchRPM()->armonicos,
+                                    configIMU(0)->frecLeer, configNotchRPM()->frecMin, configNotchRPM()->anchoBanda,
+                                    configNotchRPM()->atenuacionDB, AJUSTES_PASO_NOTCH_RPM, frecuenciaRotorMotor);
+#endif
 
     for (uint8_t i = 0; i < NUM_MAX_IMU; i++) {
         if (configIMU(i)->tipoIMU == IMU_NINGUNO)
@@ -182,6 +210,12 @@ bool iniciarIMU(void)
                 tablaFnIMU[i] = &tablaFnIMUinvensense;
                 break;
 
+#if defined(SITL)
+            case IMU_SITL:
+                tablaFnIMU[i] = &tablaFnIMUsitl;
+                break;
+#endif
+
             default:
 #ifdef DEBUG
                 printf("Fallo en la definicion de la IMU %u\n", i + 1);
@@ -213,10 +247,10 @@ bool iniciarIMU(void)
 bool iniciarDriverIMU(imu_t *dIMU)
 {
     if (tablaFnIMU[dIMU->numIMU]->iniciarIMU(dIMU)) {
-        for (uint8_t i = 0; i < 3; i++) {
-    	    ajustarFiltroPasaBajo2P(&filtroAcelIMU[i][dIMU->numIMU], configIMU(dIMU->numIMU)->frecFiltroAcel, configIMU(dIMU->numIMU)->frecLeer);
-    	    ajustarFiltroPasaBajo2P(&filtroGiroIMU[i][dIMU->numIMU], configIMU(dIMU->numIMU)->frecFiltroGiro, configIMU(dIMU->numIMU)->frecLeer);
-        }
+        const uint8_t canal = dIMU->numIMU * CANALES_FILTRO_IMU;
+
+        ajustarPasaBajoBancoBiquad(&filtroIMU, 0, canal, 3, configIMU(dIMU->numIMU)->frecFiltroAcel, configIMU(dIMU->numIMU)->frecLeer);
+        ajustarPasaBajoBancoBiquad(&filtroIMU, 0, canal + 3, 3, configIMU(dIMU->numIMU)->frecFiltroGiro, configIMU(dIMU->numIMU)->frecLeer);
 
         return true;
     }
@@ -332,6 +366,11 @@ CODIGO_RAPIDO void leerIMU(uint32_t tiempoActual)
 {
     UNUSED(tiempoActual);
 
+#ifdef USAR_SALIDA_DSHOT
+    if (notchRPM)
+        ajustarBancoNotchRPM(&notchRPMimu);
+#endif
+
     for (uint8_t i = 0; i < NUM_MAX_IMU; i++) {
         imu_t *driver = &imu[i];
 
@@ -344,6 +383,10 @@ CODIGO_RAPIDO void leerIMU(uint32_t tiempoActual)
     if (cntIMUSconectadas > 0)
         calcularIMUGen(MEZCLADO_MEDIDAS_IMU);
 
+    // El espectro se calcula sobre el giro sin filtrar
+    if (notchDinamico && imuGen.operativa)
+        anadirMuestraAnalizadorEspectro(&analizadorIMU, imuGen.giro);
+
 
 /*
     if (tiempoActual >= 20000000 && !calIni) {
@@ -414,10 +457,23 @@ CODIGO_RAPIDO void leerDriverIMU(imu_t *dIMU)
         // Se corrigen las medidas de la IMU con la calibracion
         corregirIMU(dIMU->giro, dIMU->acel, configCalIMU(dIMU->numIMU)->calIMU);
 
-        // Filtramos las medidas
+        // Filtramos las medidas de los seis ejes en una sola pasada por el banco
+        float muestras[CANALES_FILTRO_IMU];
+
         for (uint8_t i = 0; i < 3; i++) {
-            dIMU->acelFiltrada[i] = actualizarFiltroPasaBajo2P(&filtroAcelIMU[i][dIMU->numIMU], dIMU->acel[i]);
-            dIMU->giroFiltrado[i] = actualizarFiltroPasaBajo2P(&filtroGiroIMU[i][dIMU->numIMU], dIMU->giro[i]);
+            muestras[i] = dIMU->acel[i];
+            muestras[i + 3] = dIMU->giro[i];
+        }
+
+        actualizarCanalesBancoBiquad(&filtroIMU, dIMU->numIMU * CANALES_FILTRO_IMU, CANALES_FILTRO_IMU, muestras);
+#ifdef USAR_SALIDA_DSHOT
+        if (notchRPM)
+            actualizarCanalesBancoNotchRPM(&notchRPMimu, dIMU->numIMU * 3, 3, &muestras[3]);
+#endif
+
+        for (uint8_t i = 0; i < 3; i++) {
+            dIMU->acelFiltrada[i] = muestras[i];
+            dIMU->giroFiltrado[i] = muestras[i + 3];
         }
     }
 
@@ -452,6 +508,70 @@ CODIGO_RAPIDO void actualizarIMU(uint32_t tiempoActual)
 }
 
 
+/***************************************************************************************
+**  Nombre:         void actualizarNotchDinamicoIMU(uint32_t tiempoActual)
+**  Descripcion:    Avanza un paso el analisis del espectro del giro y, al terminar un eje,
+**                  mueve los notch de ese eje al nuevo pico dominante
+**  Parametros:     Tiempo actual
+**  Retorno:        Ninguno
+****************************************************************************************/
+void actualizarNotchDinamicoIMU(uint32_t tiempoActual)
+{
+    UNUSED(tiempoActual);
+    uint8_t eje;
+
+    if (notchDinamico && actualizarAnalizadorEspectro(&analizadorIMU, &eje))
+        ajustarNotchDinamicoIMU(eje, analizadorIMU.frecDominante[eje]);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void ajustarNotchDinamicoIMU(uint8_t eje, float frecuencia)
+**  Descripcion:    Ajusta los notch de los armonicos habilitados en un eje del giro de
+**                  todas las IMUs. El ancho de banda es proporcional a la frecuencia
+**  Parametros:     Eje, frecuencia del pico dominante
+**  Retorno:        Ninguno
+****************************************************************************************/
+void ajustarNotchDinamicoIMU(uint8_t eje, float frecuencia)
+{
+    for (uint8_t i = 0; i < NUM_MAX_IMU; i++) {
+        if (!imu[i].iniciado)
+            continue;
+
+        const uint8_t canal = i * CANALES_FILTRO_IMU + 3 + eje;
+        const float frecMuestreo = configIMU(i)->frecLeer;
+
+        for (uint8_t j = 0; j < ARMONICOS_NOTCH_DINAMICO; j++) {
+            const float centroNotch = frecuencia * (j + 1);
+
+            if (frecuencia > 0 && ((1U << j) & configNotchDinamico()->armonicos) && centroNotch < LIMITE_NYQUIST_NOTCH_DINAMICO * frecMuestreo)
+                ajustarNotchBancoBiquad(&filtroIMU, j + 1, canal, 1, centroNotch, frecMuestreo,
+                                        centroNotch * configNotchDinamico()->anchoBanda, configNotchDinamico()->atenuacionDB);
+            else
+                ajustarPasoBancoBiquad(&filtroIMU, j + 1, canal, 1);
+        }
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool telemetriaRPMdisponibleIMU(void)
+**  Descripcion:    Comprueba si los motores van a mandar su eRPM por DShot bidireccional
+**  Parametros:     Ninguno
+**  Retorno:        True si llega la frecuencia de los rotores
+****************************************************************************************/
+bool telemetriaRPMdisponibleIMU(void)
+{
+#ifdef USAR_DSHOT
+    const protocoloMotor_e protocolo = configMotor()->protocolo;
+
+    return configMotor()->usarTelemetriaDshot && protocolo >= PWM_TIPO_DSHOT150 && protocolo <= PWM_TIPO_DSHOT1200;
+#else
+    return false;
+#endif
+}
+
+
 /***************************************************************************************
 **  Nombre:         void actualizarDriverIMU(imu_t *dIMU)
 **  Descripcion:    Actualiza las muestras de una IMU
@@ -694,4 +814,16 @@ float tempNumIMU(numIMU_e numIMU)
 	return imu[numIMU].temperatura;
 }
 
+
+/***************************************************************************************
+**  Nombre:         uint32_t desbordesFifoNumIMU(numIMU_e numIMU)
+**  Descripcion:    Devuelve las veces que se ha desbordado la FIFO de una IMU
+**  Parametros:     Numero de IMU
+**  Retorno:        Numero de desbordes
+****************************************************************************************/
+uint32_t desbordesFifoNumIMU(numIMU_e numIMU)
+{
+    return imu[numIMU].desbordesFifo;
+}
+
 #endif
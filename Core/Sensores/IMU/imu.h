@@ -66,6 +66,9 @@ typedef enum {
 	IMU_ICM20602,
     IMU_ICM20689,
     IMU_ICM20789,
+#if defined(SITL)
+    IMU_SITL,
+#endif
 } tipoIMU_e;
 
 typedef struct {
@@ -97,6 +100,7 @@ typedef struct {
     bool operativo;
     bool nuevaMedida;
     timingIMU_t timing;
+    uint32_t desbordesFifo;              // Veces que se ha llenado la FIFO del sensor y se han perdido muestras
 } imu_t;
 
 typedef struct {
@@ -116,6 +120,9 @@ typedef struct {
 ** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
 extern tablaFnIMU_t tablaFnIMUinvensense;
+#if defined(SITL)
+extern tablaFnIMU_t tablaFnIMUsitl;
+#endif
 
 
 /***************************************************************************************
@@ -124,6 +131,7 @@ extern tablaFnIMU_t tablaFnIMUinvensense;
 bool iniciarIMU(void);
 void leerIMU(uint32_t tiempoActual);
 void actualizarIMU(uint32_t tiempoActual);
+void actualizarNotchDinamicoIMU(uint32_t tiempoActual);
 bool imuOperativa(numIMU_e numIMU);
 bool imusOperativas(void);
 bool medidasIMUok(float *val);
@@ -136,5 +144,6 @@ float tempIMU(void);
 void giroNumIMU(numIMU_e numIMU, float *giro);
 void acelNumIMU(numIMU_e numIMU, float *acel);
 float tempNumIMU(numIMU_e numIMU);
+uint32_t desbordesFifoNumIMU(numIMU_e numIMU);
 
 #endif // __IMU_H_
@@ -31,6 +31,7 @@
 #include "imu.h"
 
 #ifdef USAR_IMU
+#include "fifo_invensense.h"
 #include "Comun/matematicas.h"
 #include "GP/gp_imu.h"
 #include "Drivers/tiempo.h"
@@ -191,12 +192,23 @@
 
 #define INVENSENSE_SAMPLE_SIZE                 14
 #define INVENSENSE_FIFO_DOWNSAMPLE_COUNT       8
-#define INVENSENSE_FIFO_BUFFER_LEN             16
+#define INVENSENSE_FIFO_BUFFER_LEN             16      // Muestras leidas como maximo en cada rafaga (224 bytes)
+
+#define INVENSENSE_PERIODO_FIFO_US             125     // Con el DLPF del giro a 0 la FIFO se llena a 8kHz
+#define INVENSENSE_TAM_RAFAGA_FIFO             256     // Registro + 16 muestras redondeado a lineas de cache
 
 
 /***************************************************************************************
 ** AREA DE DEFINICION DE TIPOS                                                        **
 ****************************************************************************************/
+typedef enum {
+    FIFO_INVENSENSE_LIBRE = 0,
+    FIFO_INVENSENSE_CUENTA,
+    FIFO_INVENSENSE_RAFAGA,
+    FIFO_INVENSENSE_DATOS,
+    FIFO_INVENSENSE_RESETEAR,
+} faseFifoInvensense_e;
+
 typedef struct {
 	uint8_t regControl;
 	float tempCero, tempSens;
@@ -204,6 +216,20 @@ typedef struct {
     float giroRaw[3], acelRaw[3];
     float tempRaw;
     acumulador7_t acumulador;
+    bool usarFifo;
+    uint16_t tamFifo;
+    uint32_t tiempoMuestra;              // Tiempo en us de la ultima muestra acumulada
+#ifdef USAR_COLA_SPI
+    // Lectura asincrona de la FIFO. El callback de la cuenta encadena la rafaga
+    uint8_t txFifo[INVENSENSE_TAM_RAFAGA_FIFO] __attribute__((aligned(32)));
+    uint8_t rxFifo[INVENSENSE_TAM_RAFAGA_FIFO] __attribute__((aligned(32)));
+    transaccionBus_t transaccion;
+    segmentoBus_t segmento;
+    volatile faseFifoInvensense_e fase;
+    uint16_t enCola;
+    uint16_t aLeer;
+    uint32_t tiempoLectura;              // Tiempo en us de la lectura del contador
+#endif
 } imuInvensense_t;
 
 
@@ -225,6 +251,14 @@ void resetearFifoIMUinvensense(bus_t *bus, uint8_t *regControl);
 bool leerAdcIMUinvensense(bus_t *bus, int16_t *adc);
 void leerIMUinvensense(imu_t *dIMU);
 void actualizarIMUinvensense(imu_t *dIMU);
+#ifdef USAR_COLA_SPI
+void actualizarFifoAsincronaIMUinvensense(imu_t *dIMU);
+void callbackFifoIMUinvensense(transaccionBus_t *transaccion, bool ok);
+#else
+void actualizarFifoIMUinvensense(imu_t *dIMU);
+#endif
+void procesarFifoIMUinvensense(imu_t *dIMU, const uint8_t *buffer, uint16_t enCola, uint16_t aLeer, uint32_t tiempoLectura);
+void acumularMuestraIMUinvensense(imu_t *dIMU, const int16_t *adc);
 bool datoDisponibleIMUinvensense(bus_t *bus);
 void calcularIMUinvensense(imu_t *dIMU);
 
@@ -251,6 +285,22 @@ bool iniciarIMUinvensense(imu_t *dIMU)
     // Reseteamos el driver
     memset(driver, 0, sizeof(*driver));
 
+#ifdef USAR_FIFO_IMU
+    // Por I2C una rafaga completa tarda varios ms, por lo que la FIFO solo se usa con SPI
+    driver->usarFifo = dIMU->bus.tipo == BUS_SPI;
+#endif
+
+#ifdef USAR_COLA_SPI
+    driver->transaccion.bus = &dIMU->bus;
+    driver->transaccion.segmentos = &driver->segmento;
+    driver->transaccion.numSegmentos = 1;
+    driver->transaccion.callback = callbackFifoIMUinvensense;
+    driver->transaccion.datoCallback = dIMU;
+    driver->segmento.datoTx = driver->txFifo;
+    driver->segmento.datoRx = driver->rxFifo;
+    driver->segmento.liberarCS = true;
+#endif
+
     if (!chequearIdIMUinvensense(&dIMU->bus, configIMU(dIMU->numIMU)->tipoIMU))
         goto error;
 
@@ -432,31 +482,37 @@ bool configurarIMUinvensense(bus_t *bus, uint8_t tipoIMU, imuInvensense_t *dIMU)
         case IMU_MPU6000:
         	dIMU->tempCero = 36.53f;
         	dIMU->tempSens = 1.0f / 340;
+        	dIMU->tamFifo = TAM_FIFO_MPU6000_INVENSENSE;
             break;
 
         case IMU_MPU9250:
         	dIMU->tempCero = 21.0f;
         	dIMU->tempSens = 1.0f / 340;
+        	dIMU->tamFifo = TAM_FIFO_MPU9250_INVENSENSE;
             break;
 
         case IMU_ICM20602:
         	dIMU->tempCero = 25.0f;
         	dIMU->tempSens = 1 / 326.8f;
+        	dIMU->tamFifo = TAM_FIFO_ICM20602_INVENSENSE;
             break;
 
         case IMU_ICM20689:
         	dIMU->tempCero = 25.0f;
         	dIMU->tempSens = 0.003f;
+        	dIMU->tamFifo = TAM_FIFO_ICM20689_INVENSENSE;
             break;
 
         case IMU_ICM20789:
         	dIMU->tempCero = 25.0f;
         	dIMU->tempSens = 0.003f;
+        	dIMU->tamFifo = TAM_FIFO_ICM20789_INVENSENSE;
             break;
     }
 
-    // Configuramos el filtro. Si tenemos la imu por SPI muestreamos a max. velocidad sin filtro. Sino ponemos el filtro mas alto
-    if (tipoIMU > IMU_MPU9250 && bus->tipo == BUS_SPI) {
+    // Configuramos el filtro. Si tenemos la imu por SPI muestreamos a max. velocidad sin filtro. Sino ponemos el filtro mas alto.
+    // Con la FIFO se limita a 8kHz para que no se llene entre lecturas
+    if (tipoIMU > IMU_MPU9250 && bus->tipo == BUS_SPI && !dIMU->usarFifo) {
         regGiro1 |= INVENSENSE_GIRO_DLPF_0;
         regGiro2 |= INVENSENSE_GYRO_FCHOICE_1;
         regAcel2 |= INVENSENSE_ACCEL_FCHOICE_1 | INVENSENSE_ACCEL_DLPF_0;
@@ -483,6 +539,18 @@ bool configurarIMUinvensense(bus_t *bus, uint8_t tipoIMU, imuInvensense_t *dIMU)
     escribirRegistroBus(bus, INVENSENSE_INT_ENABLE, 0x01);
     delay(1);
 
+    if (dIMU->usarFifo) {
+        // El pin de data ready queda activo hasta la siguiente lectura para no perder el pulso entre rafagas
+        uint8_t regInt = INVENSENSE_LATCH_INT_EN | INVENSENSE_INT_RD_CLEAR;
+        if (bus->tipo == BUS_I2C && (tipoIMU == IMU_MPU9250 || tipoIMU == IMU_ICM20789))
+            regInt |= INVENSENSE_BYPASS_EN;
+
+        escribirRegistroBus(bus, INVENSENSE_INT_PIN_CFG, regInt);
+        escribirRegistroBus(bus, INVENSENSE_FIFO_EN, INVENSENSE_TEMP_FIFO_EN | INVENSENSE_XG_FIFO_EN | INVENSENSE_YG_FIFO_EN |
+                                                     INVENSENSE_ZG_FIFO_EN | INVENSENSE_ACCEL_FIFO_EN);
+        resetearFifoIMUinvensense(bus, &dIMU->regControl);
+    }
+
     if (bus->tipo == BUS_SPI)
         ajustarRelojSPI(bus->bus_u.spi.numSPI, SPI_RELOJ_ESTANDAR);
 
@@ -490,6 +558,22 @@ bool configurarIMUinvensense(bus_t *bus, uint8_t tipoIMU, imuInvensense_t *dIMU)
 }
 
 
+/***************************************************************************************
+**  Nombre:         void resetearFifoIMUinvensense(bus_t *bus, uint8_t *regControl)
+**  Descripcion:    Vacia la FIFO y la deja habilitada
+**  Parametros:     Puntero al bus, registro de control
+**  Retorno:        Ninguno
+****************************************************************************************/
+void resetearFifoIMUinvensense(bus_t *bus, uint8_t *regControl)
+{
+    *regControl &= ~INVENSENSE_USER_FIFO_EN;
+    escribirRegistroBus(bus, INVENSENSE_USER_CTRL, *regControl | INVENSENSE_USER_FIFO_RST);
+
+    *regControl |= INVENSENSE_USER_FIFO_EN;
+    escribirRegistroBus(bus, INVENSENSE_USER_CTRL, *regControl);
+}
+
+
 /***************************************************************************************
 **  Nombre:         bool leerAdcIMUinvensense(bus_t *bus, int16_t *adc)
 **  Descripcion:    Obtiene los valores del adc
@@ -560,12 +644,20 @@ CODIGO_RAPIDO void actualizarIMUinvensense(imu_t *dIMU)
     imuInvensense_t *driver = dIMU->driver;
     bus_t *bus = &dIMU->bus;
     int16_t adc[7];
-    float imuRaw[7];
 
     numIMU_e num = dIMU->numIMU;
     if (num == IMU_3 && desactivarImu)
     	return;
 
+    if (driver->usarFifo) {
+#ifdef USAR_COLA_SPI
+        actualizarFifoAsincronaIMUinvensense(dIMU);
+#else
+        actualizarFifoIMUinvensense(dIMU);
+#endif
+        return;
+    }
+
     if (dIMU->drdy == 0) {
         if (!datoDisponibleIMUinvensense(bus))
             return;
@@ -574,6 +666,182 @@ CODIGO_RAPIDO void actualizarIMUinvensense(imu_t *dIMU)
     if (!leerAdcIMUinvensense(bus, adc))
         return;
 
+    dIMU->timing.ultimaActualizacion = micros();
+    driver->tiempoMuestra = dIMU->timing.ultimaActualizacion;
+    acumularMuestraIMUinvensense(dIMU, adc);
+}
+
+
+#ifndef USAR_COLA_SPI
+/***************************************************************************************
+**  Nombre:         void actualizarFifoIMUinvensense(imu_t *dIMU)
+**  Descripcion:    Vacia la FIFO con una rafaga bloqueante y acumula todas las muestras
+**  Parametros:     Puntero a la IMU
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void actualizarFifoIMUinvensense(imu_t *dIMU)
+{
+    imuInvensense_t *driver = dIMU->driver;
+    bus_t *bus = &dIMU->bus;
+    uint8_t cuentaRaw[2];
+    uint8_t buffer[INVENSENSE_FIFO_BUFFER_LEN * TAM_MUESTRA_FIFO_INVENSENSE];
+
+    if (!leerBufferRegistroBus(bus, INVENSENSE_FIFO_COUNTH | 0x80, cuentaRaw, 2))
+        return;
+
+    const uint32_t tiempoLectura = micros();
+    const uint16_t bytes = leerCuentaFifoInvensense(cuentaRaw);
+    dIMU->timing.ultimaActualizacion = tiempoLectura;
+
+    // Si se ha llenado o se ha perdido la alineacion las muestras no son validas
+    if (fifoInvensenseDesbordada(bytes, driver->tamFifo) || !fifoInvensenseAlineada(bytes)) {
+        dIMU->desbordesFifo++;
+        resetearFifoIMUinvensense(bus, &driver->regControl);
+        return;
+    }
+
+    const uint16_t enCola = bytes / TAM_MUESTRA_FIFO_INVENSENSE;
+    const uint16_t aLeer = MIN(enCola, INVENSENSE_FIFO_BUFFER_LEN);
+    if (aLeer == 0)
+        return;
+
+    if (!leerBufferRegistroBus(bus, INVENSENSE_FIFO_R_W | 0x80, buffer, aLeer * TAM_MUESTRA_FIFO_INVENSENSE))
+        return;
+
+    procesarFifoIMUinvensense(dIMU, buffer, enCola, aLeer, tiempoLectura);
+}
+#endif
+
+
+#ifdef USAR_COLA_SPI
+/***************************************************************************************
+**  Nombre:         void actualizarFifoAsincronaIMUinvensense(imu_t *dIMU)
+**  Descripcion:    Acumula la rafaga que dejo la transaccion anterior y lanza la siguiente
+**                  lectura del contador. La transferencia por DMA se solapa con el resto
+**                  de tareas hasta la siguiente llamada
+**  Parametros:     Puntero a la IMU
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void actualizarFifoAsincronaIMUinvensense(imu_t *dIMU)
+{
+    imuInvensense_t *driver = dIMU->driver;
+
+    switch (driver->fase) {
+        case FIFO_INVENSENSE_CUENTA:
+        case FIFO_INVENSENSE_RAFAGA:
+            // Transferencia en curso
+            return;
+
+        case FIFO_INVENSENSE_DATOS:
+            procesarFifoIMUinvensense(dIMU, &driver->rxFifo[1], driver->enCola, driver->aLeer, driver->tiempoLectura);
+            break;
+
+        case FIFO_INVENSENSE_RESETEAR:
+            dIMU->desbordesFifo++;
+            resetearFifoIMUinvensense(&dIMU->bus, &driver->regControl);
+            break;
+
+        default:
+            break;
+    }
+
+    if (driver->tiempoLectura != 0)
+        dIMU->timing.ultimaActualizacion = driver->tiempoLectura;
+
+    driver->fase = FIFO_INVENSENSE_CUENTA;
+    driver->txFifo[0] = INVENSENSE_FIFO_COUNTH | 0x80;
+    driver->segmento.longitud = 3;
+
+    if (!encolarTransaccionBus(&driver->transaccion))
+        driver->fase = FIFO_INVENSENSE_LIBRE;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void callbackFifoIMUinvensense(transaccionBus_t *transaccion, bool ok)
+**  Descripcion:    Al terminar la cuenta encola la rafaga con las muestras completas. Al
+**                  terminar la rafaga deja los datos para la tarea. Se ejecuta en la
+**                  interrupcion del DMA
+**  Parametros:     Transaccion, resultado
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void callbackFifoIMUinvensense(transaccionBus_t *transaccion, bool ok)
+{
+    imu_t *dIMU = transaccion->datoCallback;
+    imuInvensense_t *driver = dIMU->driver;
+
+    if (!ok) {
+        driver->fase = FIFO_INVENSENSE_LIBRE;
+        return;
+    }
+
+    if (driver->fase == FIFO_INVENSENSE_RAFAGA) {
+        driver->fase = FIFO_INVENSENSE_DATOS;
+        return;
+    }
+
+    driver->tiempoLectura = microsISR();
+    const uint16_t bytes = leerCuentaFifoInvensense(&driver->rxFifo[1]);
+
+    // Si se ha llenado o se ha perdido la alineacion la tarea resetea la FIFO
+    if (fifoInvensenseDesbordada(bytes, driver->tamFifo) || !fifoInvensenseAlineada(bytes)) {
+        driver->fase = FIFO_INVENSENSE_RESETEAR;
+        return;
+    }
+
+    driver->enCola = bytes / TAM_MUESTRA_FIFO_INVENSENSE;
+    driver->aLeer = MIN(driver->enCola, INVENSENSE_FIFO_BUFFER_LEN);
+    if (driver->aLeer == 0) {
+        driver->fase = FIFO_INVENSENSE_LIBRE;
+        return;
+    }
+
+    driver->fase = FIFO_INVENSENSE_RAFAGA;
+    driver->txFifo[0] = INVENSENSE_FIFO_R_W | 0x80;
+    driver->segmento.longitud = 1 + driver->aLeer * TAM_MUESTRA_FIFO_INVENSENSE;
+
+    if (!encolarTransaccionBus(transaccion))
+        driver->fase = FIFO_INVENSENSE_LIBRE;
+}
+#endif
+
+
+/***************************************************************************************
+**  Nombre:         void procesarFifoIMUinvensense(imu_t *dIMU, const uint8_t *buffer, uint16_t enCola,
+**                                                 uint16_t aLeer, uint32_t tiempoLectura)
+**  Descripcion:    Decodifica una rafaga y acumula las muestras. La mas reciente de la FIFO
+**                  corresponde al instante de la lectura del contador y el resto se separan
+**                  el periodo de muestreo
+**  Parametros:     Puntero a la IMU, bytes leidos, muestras en la FIFO, muestras leidas,
+**                  tiempo de la lectura del contador
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void procesarFifoIMUinvensense(imu_t *dIMU, const uint8_t *buffer, uint16_t enCola, uint16_t aLeer, uint32_t tiempoLectura)
+{
+    imuInvensense_t *driver = dIMU->driver;
+    muestraFifoInvensense_t muestras[INVENSENSE_FIFO_BUFFER_LEN];
+
+    const uint16_t numMuestras = parsearFifoInvensense(buffer, aLeer * TAM_MUESTRA_FIFO_INVENSENSE, muestras, INVENSENSE_FIFO_BUFFER_LEN);
+
+    // Las muestras que quedan en la FIFO se leen en la siguiente llamada
+    for (uint16_t i = 0; i < numMuestras; i++) {
+        driver->tiempoMuestra = tiempoLectura - (uint32_t)(enCola - 1 - i) * INVENSENSE_PERIODO_FIFO_US;
+        acumularMuestraIMUinvensense(dIMU, muestras[i]);
+    }
+}
+
+
+/***************************************************************************************
+**  Nombre:         void acumularMuestraIMUinvensense(imu_t *dIMU, const int16_t *adc)
+**  Descripcion:    Alinea una muestra con los ejes y la acumula
+**  Parametros:     Puntero a la IMU, valores del adc
+**  Retorno:        Ninguno
+****************************************************************************************/
+CODIGO_RAPIDO void acumularMuestraIMUinvensense(imu_t *dIMU, const int16_t *adc)
+{
+    imuInvensense_t *driver = dIMU->driver;
+    float imuRaw[7];
+
     // Se rotan las medidas para alinearlas con los ejes
     imuRaw[0] = -(float)adc[1];
     imuRaw[1] = -(float)adc[0];
@@ -583,10 +851,8 @@ CODIGO_RAPIDO void actualizarIMUinvensense(imu_t *dIMU)
     imuRaw[5] =  (float)adc[4];
     imuRaw[6] = -(float)adc[6];
 
-    dIMU->timing.ultimaActualizacion = micros();
-
     if (medidasIMUok(imuRaw))
-        acumularLecturas7(&driver->acumulador, imuRaw, 20);
+        acumularLecturas7(&driver->acumulador, imuRaw, driver->usarFifo ? 2 * INVENSENSE_FIFO_BUFFER_LEN : 20);
 }
 
 
@@ -617,7 +883,7 @@ void calcularIMUinvensense(imu_t *dIMU)
 {
     imuInvensense_t *driver = dIMU->driver;
     float medidaIMU[7];
-    uint32_t tiempo = micros();
+    uint32_t tiempo = driver->tiempoMuestra;
 
     medidaIMU[0] = driver->escalaAcel * driver->acelRaw[0];
     medidaIMU[1] = driver->escalaAcel * driver->acelRaw[1];
@@ -0,0 +1,151 @@
+/***************************************************************************************
+**  imu_sitl.c - Funciones de la IMU simulada en SITL
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <string.h>
+
+#include "imu.h"
+
+#if defined(USAR_IMU) && defined(SITL)
+#include "Drivers/tiempo.h"
+#include "SITL/modelo_quad.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    acumulador7_t acumulador;
+} imuSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static imuSITL_t imuSITL[NUM_MAX_IMU];
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool iniciarIMUsitl(imu_t *dIMU);
+void leerIMUsitl(imu_t *dIMU);
+void actualizarIMUsitl(imu_t *dIMU);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool iniciarIMUsitl(imu_t *dIMU)
+**  Descripcion:    Inicia el sensor
+**  Parametros:     Puntero al sensor
+**  Retorno:        True si ok
+****************************************************************************************/
+bool iniciarIMUsitl(imu_t *dIMU)
+{
+    imuSITL_t *driver = &imuSITL[dIMU->numIMU];
+    dIMU->driver = driver;
+
+    memset(driver, 0, sizeof(*driver));
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void leerIMUsitl(imu_t *dIMU)
+**  Descripcion:    Lee la velocidad, aceleracion y temperatura acumuladas
+**  Parametros:     Puntero a la IMU
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerIMUsitl(imu_t *dIMU)
+{
+    imuSITL_t *driver = dIMU->driver;
+    const uint8_t cuentaIMU = driver->acumulador.contador;
+    const uint32_t tiempo = micros();
+    float medidaIMU[7];
+
+    if (cuentaIMU == 0)
+        return;
+
+    for (uint8_t i = 0; i < 7; i++)
+        medidaIMU[i] = driver->acumulador.acumulado[i] / cuentaIMU;
+
+    memset(&driver->acumulador, 0, sizeof(driver->acumulador));
+
+    if (dIMU->acel[0] != medidaIMU[0] || dIMU->acel[1] != medidaIMU[1] || dIMU->acel[2] != medidaIMU[2] || dIMU->temperatura != medidaIMU[3] ||
+        dIMU->giro[0] != medidaIMU[4] || dIMU->giro[1] != medidaIMU[5] || dIMU->giro[2] != medidaIMU[6])
+        dIMU->timing.ultimoCambio = tiempo;
+
+    dIMU->acel[0] = medidaIMU[0];
+    dIMU->acel[1] = medidaIMU[1];
+    dIMU->acel[2] = medidaIMU[2];
+    dIMU->temperatura = medidaIMU[3];
+    dIMU->giro[0] = medidaIMU[4];
+    dIMU->giro[1] = medidaIMU[5];
+    dIMU->giro[2] = medidaIMU[6];
+    dIMU->timing.ultimaMedida = tiempo;
+    dIMU->nuevaMedida = true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void actualizarIMUsitl(imu_t *dIMU)
+**  Descripcion:    Toma una muestra del modelo. Usa el mismo orden que el driver Invensense
+**  Parametros:     Puntero a la IMU
+**  Retorno:        Ninguno
+****************************************************************************************/
+void actualizarIMUsitl(imu_t *dIMU)
+{
+    imuSITL_t *driver = dIMU->driver;
+    float imuRaw[7];
+
+    acelModeloQuad(&imuRaw[0]);
+    imuRaw[3] = temperaturaModeloQuad();
+    giroModeloQuad(&imuRaw[4]);
+
+    dIMU->timing.ultimaActualizacion = micros();
+    acumularLecturas7(&driver->acumulador, imuRaw, 20);
+}
+
+
+/***************************************************************************************
+**  Nombre:         tablaFnIMU_t tablaFnIMUsitl
+**  Descripcion:    Tabla de funciones de la IMU simulada
+****************************************************************************************/
+tablaFnIMU_t tablaFnIMUsitl = {
+    iniciarIMUsitl,
+    leerIMUsitl,
+    actualizarIMUsitl,
+};
+
+#endif
@@ -90,14 +90,40 @@
 
 #define VALOR_CAL_VALIDO_HONEYWELL(val) (val > 0.7f && val < 1.35f)
 
+// Por SPI los datos y el estado (registros 0x03 a 0x09) se leen en una rafaga por la cola
+// de transacciones, que encadena la peticion de la siguiente medida
+#define TAM_BUFFER_BUS_HONEYWELL         32
+
 
 /***************************************************************************************
 ** AREA DE DEFINICION DE TIPOS                                                        **
 ****************************************************************************************/
+#ifdef USAR_COLA_SPI
+typedef enum {
+    BUS_HONEYWELL_LIBRE = 0,
+    BUS_HONEYWELL_LECTURA,               // Leyendo los datos y el estado
+    BUS_HONEYWELL_COMANDO,               // Pidiendo la siguiente medida
+    BUS_HONEYWELL_DATOS,                 // Lectura pendiente de procesar por la tarea
+    BUS_HONEYWELL_ERROR,
+} faseBusHoneywell_e;
+#endif
+
 typedef struct {
     float ganancia;
     float campoMagRaw[3];
     acumulador3_t acumulador;
+#ifdef USAR_COLA_SPI
+    // Lectura asincrona del ADC. El callback de la lectura encadena el comando
+    uint8_t txBus[TAM_BUFFER_BUS_HONEYWELL] __attribute__((aligned(32)));
+    uint8_t rxBus[TAM_BUFFER_BUS_HONEYWELL] __attribute__((aligned(32)));
+    transaccionBus_t transaccion;
+    segmentoBus_t segmento;
+    volatile faseBusHoneywell_e faseBus;
+    bool usarCola;
+    bool lecturaOk;
+    int16_t adcLeido[3];
+    uint32_t tiempoLectura;
+#endif
 } magHoneywell_t;
 
 
@@ -116,8 +142,14 @@ bool chequearIdMagHoneywell(bus_t *bus);
 bool configurarMagHoneywell(bus_t *bus);
 bool calibrarMagHoneywell(mag_t *dMag);
 bool leerAdcMagHoneywell(bus_t *bus, int16_t *adc);
+bool parsearAdcMagHoneywell(const uint8_t *val, int16_t *adc);
 void leerMagHoneywell(mag_t *dMag);
 void actualizarMagHoneywell(mag_t *dMag);
+void procesarAdcMagHoneywell(mag_t *dMag, const int16_t *adc, uint32_t tiempo);
+#ifdef USAR_COLA_SPI
+void actualizarAsincronoMagHoneywell(mag_t *dMag);
+void callbackBusMagHoneywell(transaccionBus_t *transaccion, bool ok);
+#endif
 bool datoDisponibleMagHoneywell(bus_t *bus);
 void calcularMagHoneywell(mag_t *dMag);
 
@@ -144,6 +176,18 @@ bool iniciarMagHoneywell(mag_t *dMag)
     // Reseteamos el driver
     memset(driver, 0, sizeof(*driver));
 
+#ifdef USAR_COLA_SPI
+    driver->usarCola = dMag->bus.tipo == BUS_SPI;
+    driver->transaccion.bus = &dMag->bus;
+    driver->transaccion.segmentos = &driver->segmento;
+    driver->transaccion.numSegmentos = 1;
+    driver->transaccion.callback = callbackBusMagHoneywell;
+    driver->transaccion.datoCallback = dMag;
+    driver->segmento.datoTx = driver->txBus;
+    driver->segmento.datoRx = driver->rxBus;
+    driver->segmento.liberarCS = true;
+#endif
+
     if (!chequearIdMagHoneywell(&dMag->bus))
         goto error;
 
@@ -298,11 +342,24 @@ bool calibrarMagHoneywell(mag_t *dMag)
 bool leerAdcMagHoneywell(bus_t *bus, int16_t *adc)
 {
     uint8_t val[6];
-    int16_t aux[3];
 
     if (!leerBufferRegistroBus(bus, HONEYWELL_REG_DATO_X_MSB, (uint8_t *) &val, 6))
         return false;
 
+    return parsearAdcMagHoneywell(val, adc);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool parsearAdcMagHoneywell(const uint8_t *val, int16_t *adc)
+**  Descripcion:    Convierte los registros de salida y descarta las saturaciones
+**  Parametros:     Registros leidos, valores del adc
+**  Retorno:        True si ok
+****************************************************************************************/
+bool parsearAdcMagHoneywell(const uint8_t *val, int16_t *adc)
+{
+    int16_t aux[3];
+
     aux[0] = (int16_t)(val[0] << 8) | val[1];
     aux[2] = (int16_t)(val[2] << 8) | val[3];
     aux[1] = (int16_t)(val[4] << 8) | val[5];
@@ -355,9 +412,15 @@ void leerMagHoneywell(mag_t *dMag)
 ****************************************************************************************/
 void actualizarMagHoneywell(mag_t *dMag)
 {
-    magHoneywell_t *driver = dMag->driver;
     int16_t adc[3];
-    float mRaw[3];
+
+#ifdef USAR_COLA_SPI
+    magHoneywell_t *driver = dMag->driver;
+    if (driver->usarCola) {
+        actualizarAsincronoMagHoneywell(dMag);
+        return;
+    }
+#endif
 
     if (dMag->drdy == 0) {
         if (!datoDisponibleMagHoneywell(&dMag->bus))
@@ -369,21 +432,107 @@ void actualizarMagHoneywell(mag_t *dMag)
     // Pedimos una muestra
     escribirRegistroBus(&dMag->bus, HONEYWELL_REG_MODO, HONEYWELL_MODO_SINGLE);
 
-    if (!estado)
-        return;
+    if (estado)
+        procesarAdcMagHoneywell(dMag, adc, micros());
+}
+
+
+/***************************************************************************************
+**  Nombre:         void procesarAdcMagHoneywell(mag_t *dMag, const int16_t *adc, uint32_t tiempo)
+**  Descripcion:    Alinea una lectura con los ejes y la acumula
+**  Parametros:     Puntero al magnetometro, valores del adc, tiempo de la lectura
+**  Retorno:        Ninguno
+****************************************************************************************/
+void procesarAdcMagHoneywell(mag_t *dMag, const int16_t *adc, uint32_t tiempo)
+{
+    magHoneywell_t *driver = dMag->driver;
+    float mRaw[3];
 
     // Se rotan las medidas para alinearlas con los ejes
     mRaw[0] = -(float)adc[1];
     mRaw[1] =  (float)adc[0];
     mRaw[2] = -(float)adc[2];
 
-    dMag->timing.ultimaActualizacion = micros();
+    dMag->timing.ultimaActualizacion = tiempo;
 
     if (campoMagOk(dMag, mRaw))
         acumularLecturas3(&driver->acumulador, mRaw, 100);
 }
 
 
+#ifdef USAR_COLA_SPI
+/***************************************************************************************
+**  Nombre:         void actualizarAsincronoMagHoneywell(mag_t *dMag)
+**  Descripcion:    Procesa la lectura que dejo la transaccion anterior y encola la siguiente
+**  Parametros:     Puntero al magnetometro
+**  Retorno:        Ninguno
+****************************************************************************************/
+void actualizarAsincronoMagHoneywell(mag_t *dMag)
+{
+    magHoneywell_t *driver = dMag->driver;
+
+    switch (driver->faseBus) {
+        case BUS_HONEYWELL_LECTURA:
+        case BUS_HONEYWELL_COMANDO:
+            // Transferencia en curso
+            return;
+
+        case BUS_HONEYWELL_DATOS:
+            procesarAdcMagHoneywell(dMag, driver->adcLeido, driver->tiempoLectura);
+            break;
+
+        default:
+            break;
+    }
+
+    driver->faseBus = BUS_HONEYWELL_LECTURA;
+    driver->txBus[0] = HONEYWELL_REG_DATO_X_MSB;
+    driver->segmento.longitud = 1 + HONEYWELL_REG_ESTADO - HONEYWELL_REG_DATO_X_MSB + 1;
+
+    if (!encolarTransaccionBus(&driver->transaccion))
+        driver->faseBus = BUS_HONEYWELL_ERROR;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void callbackBusMagHoneywell(transaccionBus_t *transaccion, bool ok)
+**  Descripcion:    Si hay medida nueva encola la peticion de la siguiente. Al terminar la
+**                  peticion deja la lectura para la tarea. Se ejecuta en la interrupcion
+**                  del DMA
+**  Parametros:     Transaccion, resultado
+**  Retorno:        Ninguno
+****************************************************************************************/
+void callbackBusMagHoneywell(transaccionBus_t *transaccion, bool ok)
+{
+    mag_t *dMag = transaccion->datoCallback;
+    magHoneywell_t *driver = dMag->driver;
+
+    if (driver->faseBus == BUS_HONEYWELL_COMANDO) {
+        driver->faseBus = ok && driver->lecturaOk ? BUS_HONEYWELL_DATOS : BUS_HONEYWELL_ERROR;
+        return;
+    }
+
+    // Sin pin DRDY la medida solo se lee cuando el registro de estado la marca como lista
+    const uint8_t regEstado = driver->rxBus[1 + HONEYWELL_REG_ESTADO - HONEYWELL_REG_DATO_X_MSB];
+    if (!ok || (dMag->drdy == 0 && (regEstado & 0x01) == 0)) {
+        driver->faseBus = BUS_HONEYWELL_LIBRE;
+        return;
+    }
+
+    driver->lecturaOk = parsearAdcMagHoneywell(&driver->rxBus[1], driver->adcLeido);
+    driver->tiempoLectura = microsISR();
+
+    driver->faseBus = BUS_HONEYWELL_COMANDO;
+    driver->txBus[0] = HONEYWELL_REG_MODO;
+    driver->txBus[1] = HONEYWELL_MODO_SINGLE;
+    driver->segmento.longitud = 2;
+
+    if (!encolarTransaccionBus(transaccion))
+        driver->faseBus = BUS_HONEYWELL_ERROR;
+}
+#endif
+
+
 /***************************************************************************************
 **  Nombre:   bool datoDisponibleMagHoneywell(bus_t *bus)
 **  Función:  Comprueba si hay datos disponibles para leer
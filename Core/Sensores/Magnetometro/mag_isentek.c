@@ -83,15 +83,40 @@
  */
 #define IST8310_RESOLUTION               0.3
 
+// Por SPI la lectura y el comando de la siguiente medida van por la cola de transacciones
+#define TAM_BUFFER_BUS_ISENTEK           32
+
 
 /***************************************************************************************
 ** AREA DE DEFINICION DE TIPOS                                                        **
 ****************************************************************************************/
+#ifdef USAR_COLA_SPI
+typedef enum {
+    BUS_ISENTEK_LIBRE = 0,
+    BUS_ISENTEK_LECTURA,                 // Leyendo el ADC
+    BUS_ISENTEK_COMANDO,                 // Pidiendo la siguiente medida
+    BUS_ISENTEK_DATOS,                   // Lectura pendiente de procesar por la tarea
+    BUS_ISENTEK_ERROR,
+} faseBusIsentek_e;
+#endif
+
 typedef struct {
 	float ganancia;
     bool ignorarMuestra;
     float campoMagRaw[3];
     acumulador3_t acumulador;
+#ifdef USAR_COLA_SPI
+    // Lectura asincrona del ADC. El callback de la lectura encadena el comando
+    uint8_t txBus[TAM_BUFFER_BUS_ISENTEK] __attribute__((aligned(32)));
+    uint8_t rxBus[TAM_BUFFER_BUS_ISENTEK] __attribute__((aligned(32)));
+    transaccionBus_t transaccion;
+    segmentoBus_t segmento;
+    volatile faseBusIsentek_e faseBus;
+    bool usarCola;
+    bool lecturaOk;
+    int16_t adcLeido[3];
+    uint32_t tiempoLectura;
+#endif
 } magIsentek_t;
 
 
@@ -117,8 +142,14 @@ bool configurarMagIsentek(bus_t *bus);
 bool calibrarMagIsentek(mag_t *dMag);
 void iniciarConversionMagIsentek(bus_t *bus, magIsentek_t *dMag);
 bool leerAdcMagIsentek(bus_t *bus, int16_t *adc);
+bool parsearAdcMagIsentek(const uint8_t *val, int16_t *adc);
 void leerMagIsentek(mag_t *dMag);
 void actualizarMagIsentek(mag_t *dMag);
+void procesarAdcMagIsentek(mag_t *dMag, const int16_t *adc, uint32_t tiempo);
+#ifdef USAR_COLA_SPI
+void actualizarAsincronoMagIsentek(mag_t *dMag);
+void callbackBusMagIsentek(transaccionBus_t *transaccion, bool ok);
+#endif
 void calcularMagIsentek(mag_t *dMag);
 
 
@@ -144,6 +175,18 @@ bool iniciarMagIsentek(mag_t *dMag)
     // Reseteamos el driver
     memset(driver, 0, sizeof(*driver));
 
+#ifdef USAR_COLA_SPI
+    driver->usarCola = dMag->bus.tipo == BUS_SPI;
+    driver->transaccion.bus = &dMag->bus;
+    driver->transaccion.segmentos = &driver->segmento;
+    driver->transaccion.numSegmentos = 1;
+    driver->transaccion.callback = callbackBusMagIsentek;
+    driver->transaccion.datoCallback = dMag;
+    driver->segmento.datoTx = driver->txBus;
+    driver->segmento.datoRx = driver->rxBus;
+    driver->segmento.liberarCS = true;
+#endif
+
     if (!chequearIdMagIsentek(&dMag->bus))
         goto error;
 
@@ -279,11 +322,24 @@ void iniciarConversionMagIsentek(bus_t *bus, magIsentek_t *dMag)
 bool leerAdcMagIsentek(bus_t *bus, int16_t *adc)
 {
     uint8_t val[6];
-    int16_t aux[3];
 
     if (!leerBufferRegistroBus(bus, ISENTEK_OUTPUT_X_L_REG, (uint8_t *) &val, 6))
         return false;
 
+    return parsearAdcMagIsentek(val, adc);
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool parsearAdcMagIsentek(const uint8_t *val, int16_t *adc)
+**  Descripcion:    Convierte los registros de salida y descarta los valores fuera de rango
+**  Parametros:     Registros leidos, valores del adc
+**  Retorno:        True si ok
+****************************************************************************************/
+bool parsearAdcMagIsentek(const uint8_t *val, int16_t *adc)
+{
+    int16_t aux[3];
+
     aux[0] = (int16_t)(val[1] << 8) | val[0];
     aux[1] = (int16_t)(val[3] << 8) | val[2];
     aux[2] = (int16_t)(val[5] << 8) | val[4];
@@ -342,7 +398,13 @@ void actualizarMagIsentek(mag_t *dMag)
 {
     magIsentek_t *driver = dMag->driver;
     int16_t adc[3];
-    float mRaw[3];
+
+#ifdef USAR_COLA_SPI
+    if (driver->usarCola) {
+        actualizarAsincronoMagIsentek(dMag);
+        return;
+    }
+#endif
 
     if (driver->ignorarMuestra) {
         driver->ignorarMuestra = false;
@@ -354,20 +416,103 @@ void actualizarMagIsentek(mag_t *dMag)
     // Pedimos una muestra
     iniciarConversionMagIsentek(&dMag->bus, driver);
 
-    if (!estado)
-        return;
+    if (estado)
+        procesarAdcMagIsentek(dMag, adc, micros());
+}
+
+
+/***************************************************************************************
+**  Nombre:         void procesarAdcMagIsentek(mag_t *dMag, const int16_t *adc, uint32_t tiempo)
+**  Descripcion:    Alinea una lectura con los ejes y la acumula
+**  Parametros:     Puntero al magnetometro, valores del adc, tiempo de la lectura
+**  Retorno:        Ninguno
+****************************************************************************************/
+void procesarAdcMagIsentek(mag_t *dMag, const int16_t *adc, uint32_t tiempo)
+{
+    magIsentek_t *driver = dMag->driver;
+    float mRaw[3];
 
     mRaw[0] = -(float)adc[1];
     mRaw[1] =  (float)adc[0];
     mRaw[2] = -(float)adc[2];
 
-    dMag->timing.ultimaActualizacion = micros();
+    dMag->timing.ultimaActualizacion = tiempo;
 
     if (campoMagOk(dMag, mRaw))
         acumularLecturas3(&driver->acumulador, mRaw, 100);
 }
 
 
+#ifdef USAR_COLA_SPI
+/***************************************************************************************
+**  Nombre:         void actualizarAsincronoMagIsentek(mag_t *dMag)
+**  Descripcion:    Procesa la lectura que dejo la transaccion anterior y encola la siguiente
+**  Parametros:     Puntero al magnetometro
+**  Retorno:        Ninguno
+****************************************************************************************/
+void actualizarAsincronoMagIsentek(mag_t *dMag)
+{
+    magIsentek_t *driver = dMag->driver;
+
+    switch (driver->faseBus) {
+        case BUS_ISENTEK_LECTURA:
+        case BUS_ISENTEK_COMANDO:
+            // Transferencia en curso
+            return;
+
+        case BUS_ISENTEK_DATOS:
+            procesarAdcMagIsentek(dMag, driver->adcLeido, driver->tiempoLectura);
+            break;
+
+        default:
+            break;
+    }
+
+    // El comando va siempre detras de la lectura, asi que no hace falta repetirlo
+    driver->ignorarMuestra = false;
+
+    driver->faseBus = BUS_ISENTEK_LECTURA;
+    driver->txBus[0] = ISENTEK_OUTPUT_X_L_REG;
+    driver->segmento.longitud = 7;
+
+    if (!encolarTransaccionBus(&driver->transaccion))
+        driver->faseBus = BUS_ISENTEK_ERROR;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void callbackBusMagIsentek(transaccionBus_t *transaccion, bool ok)
+**  Descripcion:    Al terminar la lectura encola la peticion de la siguiente medida. Al
+**                  terminar la peticion deja la lectura para la tarea. Se ejecuta en la
+**                  interrupcion del DMA
+**  Parametros:     Transaccion, resultado
+**  Retorno:        Ninguno
+****************************************************************************************/
+void callbackBusMagIsentek(transaccionBus_t *transaccion, bool ok)
+{
+    mag_t *dMag = transaccion->datoCallback;
+    magIsentek_t *driver = dMag->driver;
+
+    if (driver->faseBus == BUS_ISENTEK_COMANDO) {
+        driver->faseBus = ok && driver->lecturaOk ? BUS_ISENTEK_DATOS : BUS_ISENTEK_ERROR;
+        return;
+    }
+
+    // Como en la lectura bloqueante, la siguiente medida se pide aunque la lectura falle
+    driver->lecturaOk = ok && parsearAdcMagIsentek(&driver->rxBus[1], driver->adcLeido);
+    driver->tiempoLectura = microsISR();
+
+    driver->faseBus = BUS_ISENTEK_COMANDO;
+    driver->txBus[0] = ISENTEK_REG_COTROL_A;
+    driver->txBus[1] = ISENTEK_SINGLE_MEASUREMENT_MODE;
+    driver->segmento.longitud = 2;
+
+    if (!encolarTransaccionBus(transaccion))
+        driver->faseBus = BUS_ISENTEK_ERROR;
+}
+#endif
+
+
 /***************************************************************************************
 **  Nombre:         void calcularMagIsentek(mag_t *dMag)
 **  Descripcion:    Convierte la medida de uT a Gauss
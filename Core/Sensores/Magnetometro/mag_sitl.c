@@ -0,0 +1,160 @@
+/***************************************************************************************
+**  mag_sitl.c - Funciones del magnetometro simulado en SITL
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+#include <string.h>
+
+#include "magnetometro.h"
+
+#if defined(USAR_MAG) && defined(SITL)
+#include "Drivers/tiempo.h"
+#include "SITL/modelo_quad.h"
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE TIPOS                                                        **
+****************************************************************************************/
+typedef struct {
+    acumulador3_t acumulador;
+} magSITL_t;
+
+
+/***************************************************************************************
+** AREA DE DECLARACION DE VARIABLES                                                   **
+****************************************************************************************/
+static magSITL_t magSITL[NUM_MAX_MAG];
+
+
+/***************************************************************************************
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
+****************************************************************************************/
+bool iniciarMagSITL(mag_t *dMag);
+bool calibrarMagSITL(mag_t *dMag);
+void leerMagSITL(mag_t *dMag);
+void actualizarMagSITL(mag_t *dMag);
+
+
+/***************************************************************************************
+** AREA DE DEFINICION DE FUNCIONES                                                    **
+****************************************************************************************/
+
+/***************************************************************************************
+**  Nombre:         bool iniciarMagSITL(mag_t *dMag)
+**  Descripcion:    Inicia el sensor
+**  Parametros:     Puntero al sensor
+**  Retorno:        True si ok
+****************************************************************************************/
+bool iniciarMagSITL(mag_t *dMag)
+{
+    magSITL_t *driver = &magSITL[dMag->numMag];
+    dMag->driver = driver;
+
+    memset(driver, 0, sizeof(*driver));
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool calibrarMagSITL(mag_t *dMag)
+**  Descripcion:    El modelo no tiene error de escala
+**  Parametros:     Puntero al magnetometro
+**  Retorno:        True si ok
+****************************************************************************************/
+bool calibrarMagSITL(mag_t *dMag)
+{
+    UNUSED(dMag);
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void leerMagSITL(mag_t *dMag)
+**  Descripcion:    Lee el campo magnetico acumulado
+**  Parametros:     Puntero al magnetometro
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerMagSITL(mag_t *dMag)
+{
+    magSITL_t *driver = dMag->driver;
+    const uint8_t cuentaM = driver->acumulador.contador;
+    const uint32_t tiempo = micros();
+    float cMag[3];
+
+    if (cuentaM == 0)
+        return;
+
+    for (uint8_t i = 0; i < 3; i++)
+        cMag[i] = driver->acumulador.acumulado[i] / cuentaM;
+
+    memset(&driver->acumulador, 0, sizeof(driver->acumulador));
+
+    if (dMag->campoMag[0] != cMag[0] || dMag->campoMag[1] != cMag[1] || dMag->campoMag[2] != cMag[2])
+        dMag->timing.ultimoCambio = tiempo;
+
+    dMag->campoMag[0] = cMag[0];
+    dMag->campoMag[1] = cMag[1];
+    dMag->campoMag[2] = cMag[2];
+    dMag->timing.ultimaMedida = tiempo;
+    dMag->nuevaMedida = true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void actualizarMagSITL(mag_t *dMag)
+**  Descripcion:    Toma una muestra del modelo
+**  Parametros:     Puntero al magnetometro
+**  Retorno:        Ninguno
+****************************************************************************************/
+void actualizarMagSITL(mag_t *dMag)
+{
+    magSITL_t *driver = dMag->driver;
+    float mRaw[3];
+
+    campoMagModeloQuad(mRaw);
+    dMag->timing.ultimaActualizacion = micros();
+
+    if (campoMagOk(dMag, mRaw))
+        acumularLecturas3(&driver->acumulador, mRaw, 100);
+}
+
+
+/***************************************************************************************
+**  Nombre:         tablaFnMag_t tablaFnMagSITL
+**  Descripcion:    Tabla de funciones del magnetometro simulado
+****************************************************************************************/
+tablaFnMag_t tablaFnMagSITL = {
+    iniciarMagSITL,
+    leerMagSITL,
+    actualizarMagSITL,
+    calibrarMagSITL,
+};
+
+#endif
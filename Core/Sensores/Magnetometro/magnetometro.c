@@ -169,6 +169,12 @@ bool iniciarMag(void)
                 tablaFnMag[i] = &tablaFnMagIsentek;
                 break;
 
+#if defined(SITL)
+            case MAG_SITL:
+                tablaFnMag[i] = &tablaFnMagSITL;
+                break;
+#endif
+
             default:
 #ifdef DEBUG
                 printf("Fallo en la definicion del Magnetometro %u\n", i + 1);
@@ -54,6 +54,10 @@
 #define USAR_DMA
 
 
+//CRC ----------------------------------------------------------------------------------
+#define USAR_CRC_HW                        // calcularCRC16 usa la unidad CRC del micro
+
+
 //TIMERS -------------------------------------------------------------------------------
 #define USAR_TIMERS
 
@@ -82,24 +86,34 @@
 //USB ----------------------------------------------------------------------------------
 #define USAR_USB
 #define TIMER_USB                TIMER_7
-#define FRECUENCIA_USB           200
+#define FRECUENCIA_USB           1000              // Entregas del buffer de transmision al endpoint
+#define USAR_TELEMETRIA                            // Canales de telemetria por el USB
 
 
 //UART ---------------------------------------------------------------------------------
 #define USAR_UART
+
+// Puertos con DMA_TX_UART_x / DMA_RX_UART_x envian por DMA y reciben con DMA circular.
+// Los streams de recepcion de los GPS solo los comparten los timers de los motores 5, 9 y
+// 11 con DShot por canal; en ese caso el puerto vuelve a recibir por interrupciones. El
+// stream de recepcion de la UART7 (radio), DMA1_Stream3, es del SPI2
 #define USAR_DMA_UART
 
 #define PIN_TX_UART_1            PB14
 #define PIN_RX_UART_1            PB15
+#define DMA_TX_UART_1            DMA2_Stream7     // Libre: TIM8 no se usa
 
 #define PIN_TX_UART_2            PD5
 #define PIN_RX_UART_2            PD6
+#define DMA_RX_UART_2            DMA1_Stream5     // GPS 1
 
 #define PIN_TX_UART_3            PD8
 #define PIN_RX_UART_3            PD9
+#define DMA_RX_UART_3            DMA1_Stream1     // GPS 3
 
 #define PIN_TX_UART_5            PB13
 #define PIN_RX_UART_5            PB12
+#define DMA_RX_UART_5            DMA1_Stream0     // GPS 2
 
 #define PIN_TX_UART_7            PE8
 #define PIN_RX_UART_7            PE7
@@ -147,6 +161,16 @@
 #define PIN_MISO_SPI_4           PE5
 #define PIN_MOSI_SPI_4           PE6
 
+// Cola de transacciones asincronas (ver Drivers/cola_spi.h). Los puertos sin DMA hacen
+// las transferencias de la cola de forma bloqueante. El SPI2 usa DMA1_Stream4/Stream3,
+// que solo piden los motores 4 (TIM3_CH1) y 1 (TIM4_CH2) con DShot por canal. En ese
+// caso el SPI2 cede los streams (ver iniciarDMAspi). El SPI1 no tiene DMA: sus streams
+// de recepcion son DMA2_Stream0 (ADC1) y DMA2_Stream2 (TIM1_CH2) y los de envio
+// DMA2_Stream3 (SDMMC RX) y DMA2_Stream5 (TIM1_UP en burst)
+#define USAR_COLA_SPI
+#define DMA_TX_SPI_2             DMA1_Stream4
+#define DMA_RX_SPI_2             DMA1_Stream3
+
 // Definicion del orden de los puertos.
 #define PUERTO_1_SPI             SPI_4
 #define PUERTO_1_SPI_CS_1        PC13
@@ -162,7 +186,7 @@
 #define PIN_D1_SDMMC             PC9
 #define PIN_D2_SDMMC             PC10
 #define PIN_D3_SDMMC             PC11
-#define DMA_TX_SDMMC             DMA2_Stream6
+#define DMA_TX_SDMMC             DMA2_Stream6     // Tambien TIM1_CH3 (motor 8) sin burst
 #define DMA_RX_SDMMC             DMA2_Stream3
 
 #if defined(DMA_TX_SDMMC) || defined(DMA_RX_SDMMC)
@@ -214,6 +238,7 @@
 
 //IMU ----------------------------------------------------------------------------------
 #define USAR_IMU
+#define USAR_FIFO_IMU                      // Las IMU por SPI se leen por rafagas de la FIFO
 // IMU 1
 #define TIPO_IMU_1               IMU_ICM20689
 #define TIPO_BUS_IMU_1           BUS_SPI
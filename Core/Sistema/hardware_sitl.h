@@ -0,0 +1,87 @@
+/***************************************************************************************
+**  hardware_sitl.h - Este fichero contiene la definicion del hardware simulado para la
+**                    compilacion SITL (Software In The Loop) en el PC
+**
+**
+**  Este fichero forma parte del proyecto URpilot.
+**  Codigo desarrollado por el grupo de investigacion ICON de la Universidad de La Rioja
+**
+**  Autor: Ramon Rico
+**  Fecha de creacion: 17/10/2026
+**  Fecha de modificacion: 17/10/2026
+**
+**  El proyecto URpilot NO es libre. No se puede distribuir y/o modificar este fichero
+**  bajo ningun concepto.
+**
+**  En caso de modificacion y/o solicitud de informacion pongase en contacto con
+**  el grupo de investigacion ICON a traves de: www.unirioja.es/urpilot
+**
+**
+**  Control de versiones del fichero
+**
+**  v1.0  Ramon Rico. Se ha liberado la primera version estable
+**
+****************************************************************************************/
+
+#ifndef __HARDWARE_SITL_H
+#define __HARDWARE_SITL_H
+
+/***************************************************************************************
+** AREA DE INCLUDES                                                                   **
+****************************************************************************************/
+
+
+/***************************************************************************************
+** AREA DE PREPROCESADOR                                                              **
+****************************************************************************************/
+#define NOMBRE_PLACA            "URSITL"
+
+// En SITL no hay perifericos reales. Solo se definen los modulos del nucleo de vuelo y
+// los sensores y actuadores se sustituyen por el modelo del vehiculo (ver SITL/sitl.h)
+
+
+//SPI ----------------------------------------------------------------------------------
+// Los puertos los simula SITL/spi_sitl.c para ejecutar la cola de transacciones en el PC
+#define USAR_SPI
+#define USAR_COLA_SPI
+
+
+//IMU ----------------------------------------------------------------------------------
+#define USAR_IMU
+// IMU 1
+#define TIPO_IMU_1               IMU_SITL
+#define TIPO_BUS_IMU_1           BUS_NINGUNO
+#define ROTACION_IMU_1           0
+
+
+//BAROMETRO ----------------------------------------------------------------------------
+#define USAR_BARO
+// Baro 1
+#define TIPO_BARO_1              BARO_SITL
+#define TIPO_BUS_BARO_1          BUS_NINGUNO
+
+
+//MAGNETOMETRO -------------------------------------------------------------------------
+#define USAR_MAG
+// Mag 1
+#define TIPO_MAG_1               MAG_SITL
+#define TIPO_BUS_MAG_1           BUS_NINGUNO
+#define ROTACION_MAG_1           0
+
+
+//RADIO --------------------------------------------------------------------------------
+#define USAR_RADIO
+#define PROTOCOLO_RADIO          RX_SITL
+
+
+//TELEMETRIA ---------------------------------------------------------------------------
+// El USB lo simula SITL/drivers_sitl.c para probar las tramas en el PC
+#define USAR_TELEMETRIA
+
+
+//MOTORES ------------------------------------------------------------------------------
+#define USAR_MOTORES
+#define NUM_MOTORES              4
+#define PROTOCOLO_MOTOR          PWM_TIPO_SITL
+
+#endif // __HARDWARE_SITL_H
@@ -29,7 +29,11 @@
 /***************************************************************************************
 ** AREA DE INCLUDES                                                                   **
 ****************************************************************************************/
-#include "hardware.h"
+#if defined(SITL)
+  #include "hardware_sitl.h"
+#else
+  #include "hardware.h"
+#endif
 
 
 /***************************************************************************************
@@ -46,9 +50,12 @@
 
 #ifdef STM32F7
   #define USAR_ESTADISTICAS_TAREAS
+  // En SITL no existen las secciones de memoria del linker del micro
+  #if !defined(SITL)
   #define USAR_ITCM_RAM
   #define USAR_SRAM2
   #define USAR_DTCM_RAM
+  #endif
 #endif
 
 #ifndef DEBUG
@@ -25,14 +25,20 @@
 /***************************************************************************************
 ** AREA DE INCLUDES                                                                   **
 ****************************************************************************************/
-#include <stdio.h>
 #include <string.h>
-#include <math.h>
 
 #include "telemetria.h"
 
-#ifdef USAR_IMU
+#ifdef USAR_TELEMETRIA
+#include "GP/gp_telemetria.h"
+#include "Comun/crc.h"
 #include "Sensores/IMU/imu.h"
+#include "Sensores/Barometro/barometro.h"
+#include "Sensores/Magnetometro/magnetometro.h"
+#include "Sensores/GPS/gps.h"
+#include "Radio/radio.h"
+#include "Motores/motor.h"
+#include "Motores/telemetria_dshot.h"
 #include "AHRS/ahrs.h"
 #include "FC/rc.h"
 #include "FC/control.h"
@@ -41,234 +47,691 @@
 /***************************************************************************************
 ** AREA DE PREPROCESADOR                                                              **
 ****************************************************************************************/
+#define TAM_TRAMA_COMANDO_TELEMETRIA   (TAM_CABECERA_TELEMETRIA + TAM_CARGA_COMANDO_TELEMETRIA + TAM_CRC_TELEMETRIA)
+
+#if defined(USAR_MOTORES) && NUM_MOTORES > NUM_MAX_VALORES_CANAL_TELEMETRIA
+  #error "Demasiados motores para el canal de telemetria"
+#endif
 
 
 /***************************************************************************************
 ** AREA DE DEFINICION DE TIPOS                                                        **
 ****************************************************************************************/
+typedef void (*leerCanalTelemetria_t)(uint8_t instancia, void *valores);
+
+typedef struct {
+    const char *nombre;
+    uint8_t numValores;
+    tipoValorTelemetria_e tipo;
+    uint8_t instancia;
+    leerCanalTelemetria_t leer;           // NULL si el canal no existe en la placa
+} defCanalTelemetria_t;
+
+typedef struct {
+    uint32_t suscritos;                   // Canales con divisor distinto de 0
+    uint16_t divisor[NUM_CANALES_TELEMETRIA];
+    uint16_t contador[NUM_CANALES_TELEMETRIA];
+    uint16_t secuencia;
+    uint32_t tramasPerdidas;
+    bool enviarEsquema;
+    uint8_t comando[TAM_TRAMA_COMANDO_TELEMETRIA];
+    uint8_t indiceComando;
+} telemetria_t;
 
 
 /***************************************************************************************
-** AREA DE DECLARACION DE VARIABLES                                                   **
+** AREA DE PROTOTIPOS DE FUNCION                                                      **
 ****************************************************************************************/
-bufferTelemetria_t telBuffer;
+void enviarDatosTelemetria(uint32_t canales, uint32_t tiempoActual);
+bool enviarEsquemaTelemetria(uint32_t tiempoActual);
+uint16_t cerrarTramaTelemetria(tipoTramaTelemetria_e tipo, uint32_t canales, uint16_t longitud, uint32_t tiempoActual);
+void recibirComandosTelemetria(void);
+void procesarComandoTelemetria(void);
+#ifdef USAR_IMU
+void leerGiroIMUTelemetria(uint8_t instancia, void *valores);
+void leerAcelIMUTelemetria(uint8_t instancia, void *valores);
+void leerGiroTelemetria(uint8_t instancia, void *valores);
+void leerAcelTelemetria(uint8_t instancia, void *valores);
+#endif
+void leerActitudTelemetria(uint8_t instancia, void *valores);
+void leerVelAngularTelemetria(uint8_t instancia, void *valores);
+void leerPosicionTelemetria(uint8_t instancia, void *valores);
+void leerVelLinealTelemetria(uint8_t instancia, void *valores);
+void leerRefRCtelemetria(uint8_t instancia, void *valores);
+void leerPIDtelemetria(uint8_t instancia, void *valores);
+#ifdef USAR_RADIO
+void leerRadioTelemetria(uint8_t instancia, void *valores);
+void leerLatenciaRadioTelemetria(uint8_t instancia, void *valores);
+#endif
+#ifdef USAR_MOTORES
+void leerMotoresTelemetria(uint8_t instancia, void *valores);
+#endif
+#ifdef USAR_SALIDA_DSHOT
+void leerRPMmotoresTelemetria(uint8_t instancia, void *valores);
+#endif
+#ifdef USAR_BARO
+void leerBaroTelemetria(uint8_t instancia, void *valores);
+#endif
+#ifdef USAR_MAG
+void leerMagTelemetria(uint8_t instancia, void *valores);
+#endif
+#ifdef USAR_GPS
+void leerGPStelemetria(uint8_t instancia, void *valores);
+void leerVelGPStelemetria(uint8_t instancia, void *valores);
+#endif
 
 
 /***************************************************************************************
-** AREA DE PROTOTIPOS DE FUNCION                                                      **
+** AREA DE DECLARACION DE VARIABLES                                                   **
 ****************************************************************************************/
-void iniciarBufferTelemetria(void);
-void terminarBufferTelemetria(void);
-void insertarDatoTelemetria(float dato);
-void insertarBufferTelemetria(float *dato, uint16_t longitud);
-uint16_t obtenerNumBytesBufferTelemetria(void);
-uint16_t obtenerNumDatosBufferTelemetria(void);
+static telemetria_t telemetria;
+static uint8_t tramaTelemetria[TAM_MAX_TRAMA_TELEMETRIA] __attribute__((aligned(4)));
+
+static const defCanalTelemetria_t canalesTelemetria[NUM_CANALES_TELEMETRIA] = {
+#ifdef USAR_IMU
+    [CANAL_TELEMETRIA_GIRO_IMU_1]  = {"giro_imu1",  3,           VALOR_TELEMETRIA_FLOAT, IMU_1, leerGiroIMUTelemetria},
+    [CANAL_TELEMETRIA_GIRO_IMU_2]  = {"giro_imu2",  3,           VALOR_TELEMETRIA_FLOAT, IMU_2, leerGiroIMUTelemetria},
+  #if NUM_MAX_IMU > 2
+    [CANAL_TELEMETRIA_GIRO_IMU_3]  = {"giro_imu3",  3,           VALOR_TELEMETRIA_FLOAT, IMU_3, leerGiroIMUTelemetria},
+  #endif
+    [CANAL_TELEMETRIA_ACEL_IMU_1]  = {"acel_imu1",  3,           VALOR_TELEMETRIA_FLOAT, IMU_1, leerAcelIMUTelemetria},
+    [CANAL_TELEMETRIA_ACEL_IMU_2]  = {"acel_imu2",  3,           VALOR_TELEMETRIA_FLOAT, IMU_2, leerAcelIMUTelemetria},
+  #if NUM_MAX_IMU > 2
+    [CANAL_TELEMETRIA_ACEL_IMU_3]  = {"acel_imu3",  3,           VALOR_TELEMETRIA_FLOAT, IMU_3, leerAcelIMUTelemetria},
+  #endif
+    [CANAL_TELEMETRIA_GIRO]        = {"giro",       3,           VALOR_TELEMETRIA_FLOAT, 0,     leerGiroTelemetria},
+    [CANAL_TELEMETRIA_ACEL]        = {"acel",       3,           VALOR_TELEMETRIA_FLOAT, 0,     leerAcelTelemetria},
+#endif
+    [CANAL_TELEMETRIA_ACTITUD]     = {"actitud",    3,           VALOR_TELEMETRIA_FLOAT, 0,     leerActitudTelemetria},
+    [CANAL_TELEMETRIA_VEL_ANGULAR] = {"vel_ang",    3,           VALOR_TELEMETRIA_FLOAT, 0,     leerVelAngularTelemetria},
+    [CANAL_TELEMETRIA_POSICION]    = {"posicion",   3,           VALOR_TELEMETRIA_FLOAT, 0,     leerPosicionTelemetria},
+    [CANAL_TELEMETRIA_VEL_LINEAL]  = {"vel_lineal", 3,           VALOR_TELEMETRIA_FLOAT, 0,     leerVelLinealTelemetria},
+    [CANAL_TELEMETRIA_REF_RC]      = {"ref_rc",     3,           VALOR_TELEMETRIA_FLOAT, 0,     leerRefRCtelemetria},
+#ifdef USAR_RADIO
+    [CANAL_TELEMETRIA_RADIO]       = {"radio",      8,           VALOR_TELEMETRIA_INT32, 0,     leerRadioTelemetria},
+#endif
+    [CANAL_TELEMETRIA_PID]         = {"pid",        4,           VALOR_TELEMETRIA_FLOAT, 0,     leerPIDtelemetria},
+#ifdef USAR_MOTORES
+    [CANAL_TELEMETRIA_MOTORES]     = {"motores",    NUM_MOTORES, VALOR_TELEMETRIA_FLOAT, 0,     leerMotoresTelemetria},
+#endif
+#ifdef USAR_BARO
+    [CANAL_TELEMETRIA_BARO]        = {"baro",       2,           VALOR_TELEMETRIA_FLOAT, 0,     leerBaroTelemetria},
+#endif
+#ifdef USAR_MAG
+    [CANAL_TELEMETRIA_MAG]         = {"mag",        3,           VALOR_TELEMETRIA_FLOAT, 0,     leerMagTelemetria},
+#endif
+#ifdef USAR_GPS
+    [CANAL_TELEMETRIA_GPS]         = {"gps",        4,           VALOR_TELEMETRIA_INT32, 0,     leerGPStelemetria},
+    [CANAL_TELEMETRIA_VEL_GPS]     = {"vel_gps",    2,           VALOR_TELEMETRIA_FLOAT, 0,     leerVelGPStelemetria},
+#endif
+#ifdef USAR_RADIO
+    [CANAL_TELEMETRIA_LATENCIA_RADIO] = {"lat_radio", 3,         VALOR_TELEMETRIA_INT32, 0,     leerLatenciaRadioTelemetria},
+#endif
+#ifdef USAR_SALIDA_DSHOT
+    [CANAL_TELEMETRIA_RPM_MOTORES] = {"rpm_motores", NUM_MOTORES, VALOR_TELEMETRIA_FLOAT, 0,   leerRPMmotoresTelemetria},
+#endif
+};
 
 
 /***************************************************************************************
 ** AREA DE DEFINICION DE FUNCIONES                                                    **
 ****************************************************************************************/
-char var[500];
-extern bool desactivarImu;
-int numBytes;
-char dato;
+
+/***************************************************************************************
+**  Nombre:         void iniciarTelemetria(void)
+**  Descripcion:    Suscribe los canales de la configuracion
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void iniciarTelemetria(void)
+{
+    memset(&telemetria, 0, sizeof(telemetria));
+
+    for (uint8_t i = 0; i < NUM_CANALES_TELEMETRIA; i++)
+        suscribirCanalesTelemetria(1UL << i, configTelemetria()->divisor[i]);
+}
 
 
-float bytesToFloat(uint8_t *bytes) {
-    float result;
-    uint32_t temp;
+/***************************************************************************************
+**  Nombre:         void actualizarTelemetria(uint32_t tiempoActual)
+**  Descripcion:    Atiende los comandos del PC y envia los canales que tocan
+**  Parametros:     Tiempo actual
+**  Retorno:        Ninguno
+****************************************************************************************/
+void actualizarTelemetria(uint32_t tiempoActual)
+{
+    uint32_t canales = 0;
 
-    temp = (bytes[3]<<24) | (bytes[2]<<16) | (bytes[1]<<8) | bytes[0];
-    // los bytes del float se interpretan como unsigned, así que los convertimos a uint32_t
-    result = *((float*)&temp); // convertimos el uint32_t a float mediante un puntero
+    recibirComandosTelemetria();
 
-    return result;
+    if (telemetria.enviarEsquema && enviarEsquemaTelemetria(tiempoActual))
+        telemetria.enviarEsquema = false;
+
+    for (uint32_t pendientes = telemetria.suscritos; pendientes != 0; pendientes &= pendientes - 1) {
+        const uint8_t canal = __builtin_ctz(pendientes);
+
+        if (++telemetria.contador[canal] >= telemetria.divisor[canal]) {
+            telemetria.contador[canal] = 0;
+            canales |= 1UL << canal;
+        }
+    }
+
+    if (canales != 0)
+        enviarDatosTelemetria(canales, tiempoActual);
 }
 
 
-float bytesToInt(uint8_t *bytes) {
-    float result;
-    uint32_t temp;
+/***************************************************************************************
+**  Nombre:         bool suscribirCanalesTelemetria(uint32_t canales, uint16_t divisor)
+**  Descripcion:    Ajusta el divisor de los canales de la mascara. Con divisor 0 se dejan
+**                  de enviar
+**  Parametros:     Mascara de canales, divisor sobre la frecuencia de la tarea
+**  Retorno:        True si existen todos los canales
+****************************************************************************************/
+bool suscribirCanalesTelemetria(uint32_t canales, uint16_t divisor)
+{
+    const uint32_t disponibles = canalesDisponiblesTelemetria();
+
+    for (uint32_t pendientes = canales & disponibles; pendientes != 0; pendientes &= pendientes - 1) {
+        const uint8_t canal = __builtin_ctz(pendientes);
+
+        // Los canales con el mismo divisor salen en la misma trama
+        telemetria.divisor[canal] = divisor;
+        telemetria.contador[canal] = 0;
 
-    temp = (bytes[3]<<24) | (bytes[2]<<16) | (bytes[1]<<8) | bytes[0];
-    // los bytes del float se interpretan como unsigned, así que los convertimos a uint32_t
-    result = *((int32_t*)&temp); // convertimos el uint32_t a float mediante un puntero
+        if (divisor > 0)
+            telemetria.suscritos |= 1UL << canal;
+        else
+            telemetria.suscritos &= ~(1UL << canal);
+    }
 
-    return result;
+    return (canales & ~disponibles) == 0;
 }
 
 
 /***************************************************************************************
-**  Nombre:         bool actualizarIMU(uint32_t tiempoActual)
-**  Descripcion:    Actualiza las muestras de las IMUs
+**  Nombre:         uint32_t canalesDisponiblesTelemetria(void)
+**  Descripcion:    Devuelve la mascara de canales que existen en la placa
+**  Parametros:     Ninguno
+**  Retorno:        Mascara de canales
+****************************************************************************************/
+uint32_t canalesDisponiblesTelemetria(void)
+{
+    uint32_t canales = 0;
+
+    for (uint8_t i = 0; i < NUM_CANALES_TELEMETRIA; i++) {
+        if (canalesTelemetria[i].leer != NULL)
+            canales |= 1UL << i;
+    }
+
+    return canales;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint32_t tramasPerdidasTelemetria(void)
+**  Descripcion:    Devuelve las tramas de datos que no cabian en el buffer del USB
+**  Parametros:     Ninguno
+**  Retorno:        Numero de tramas
+****************************************************************************************/
+uint32_t tramasPerdidasTelemetria(void)
+{
+    return telemetria.tramasPerdidas;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void enviarDatosTelemetria(uint32_t canales, uint32_t tiempoActual)
+**  Descripcion:    Construye la trama con los canales de la mascara y la encola. Cada
+**                  canal escribe sus valores directamente en la carga
+**  Parametros:     Mascara de canales, tiempo actual
+**  Retorno:        Ninguno
+****************************************************************************************/
+void enviarDatosTelemetria(uint32_t canales, uint32_t tiempoActual)
+{
+    uint8_t *carga = &tramaTelemetria[TAM_CABECERA_TELEMETRIA];
+    uint16_t longitud = 0;
+
+    for (uint32_t pendientes = canales; pendientes != 0; pendientes &= pendientes - 1)
+        longitud += canalesTelemetria[__builtin_ctz(pendientes)].numValores * sizeof(uint32_t);
+
+    // La secuencia avanza aunque se pierda la trama para que el PC lo detecte
+    if (bytesLibresBufferTxUSB() < (uint32_t)TAM_CABECERA_TELEMETRIA + longitud + TAM_CRC_TELEMETRIA) {
+        telemetria.tramasPerdidas++;
+        telemetria.secuencia++;
+        return;
+    }
+
+    for (uint32_t pendientes = canales; pendientes != 0; pendientes &= pendientes - 1) {
+        const defCanalTelemetria_t *def = &canalesTelemetria[__builtin_ctz(pendientes)];
+
+        def->leer(def->instancia, carga);
+        carga += def->numValores * sizeof(uint32_t);
+    }
+
+    escribirBufferUSB(tramaTelemetria, cerrarTramaTelemetria(TRAMA_TELEMETRIA_DATOS, canales, longitud, tiempoActual));
+    telemetria.secuencia++;
+}
+
+
+/***************************************************************************************
+**  Nombre:         bool enviarEsquemaTelemetria(uint32_t tiempoActual)
+**  Descripcion:    Envia la lista de canales disponibles. Por cada canal: identificador,
+**                  numero de valores, tipo, divisor (2 bytes), longitud del nombre y nombre
 **  Parametros:     Tiempo actual
+**  Retorno:        True si se ha encolado
+****************************************************************************************/
+bool enviarEsquemaTelemetria(uint32_t tiempoActual)
+{
+    const uint32_t canales = canalesDisponiblesTelemetria();
+    uint8_t *carga = &tramaTelemetria[TAM_CABECERA_TELEMETRIA];
+    uint16_t longitud = 0;
+
+    for (uint32_t pendientes = canales; pendientes != 0; pendientes &= pendientes - 1) {
+        const uint8_t canal = __builtin_ctz(pendientes);
+        const defCanalTelemetria_t *def = &canalesTelemetria[canal];
+        const uint8_t longNombre = strlen(def->nombre);
+
+        carga[longitud++] = canal;
+        carga[longitud++] = def->numValores;
+        carga[longitud++] = def->tipo;
+        carga[longitud++] = telemetria.divisor[canal] & 0xFF;
+        carga[longitud++] = telemetria.divisor[canal] >> 8;
+        carga[longitud++] = longNombre;
+        memcpy(&carga[longitud], def->nombre, longNombre);
+        longitud += longNombre;
+    }
+
+    const uint16_t tam = cerrarTramaTelemetria(TRAMA_TELEMETRIA_ESQUEMA, canales, longitud, tiempoActual);
+    if (bytesLibresBufferTxUSB() < tam)
+        return false;
+
+    escribirBufferUSB(tramaTelemetria, tam);
+    return true;
+}
+
+
+/***************************************************************************************
+**  Nombre:         uint16_t cerrarTramaTelemetria(tipoTramaTelemetria_e tipo, uint32_t canales,
+**                                                 uint16_t longitud, uint32_t tiempoActual)
+**  Descripcion:    Escribe la cabecera y el CRC alrededor de la carga ya escrita
+**  Parametros:     Tipo de trama, mascara de canales, bytes de carga, tiempo actual
+**  Retorno:        Bytes de la trama
+****************************************************************************************/
+uint16_t cerrarTramaTelemetria(tipoTramaTelemetria_e tipo, uint32_t canales, uint16_t longitud, uint32_t tiempoActual)
+{
+    cabeceraTelemetria_t *cabecera = (cabeceraTelemetria_t *)tramaTelemetria;
+    const uint16_t tam = TAM_CABECERA_TELEMETRIA + longitud;
+
+    cabecera->sincronismo[0] = SINCRONISMO_1_TELEMETRIA;
+    cabecera->sincronismo[1] = SINCRONISMO_2_TELEMETRIA;
+    cabecera->tipo = tipo;
+    cabecera->version = VERSION_TELEMETRIA;
+    cabecera->longitud = longitud;
+    cabecera->secuencia = telemetria.secuencia;
+    cabecera->tiempo = tiempoActual;
+    cabecera->canales = canales;
+
+    const uint16_t crc = calcularCRC16(VALOR_INICIO_CRC_TELEMETRIA, tramaTelemetria, tam);
+    tramaTelemetria[tam] = crc & 0xFF;
+    tramaTelemetria[tam + 1] = crc >> 8;
+
+    return tam + TAM_CRC_TELEMETRIA;
+}
+
+
+/***************************************************************************************
+**  Nombre:         void recibirComandosTelemetria(void)
+**  Descripcion:    Lee los bytes recibidos por el USB y ejecuta los comandos completos
+**  Parametros:     Ninguno
 **  Retorno:        Ninguno
 ****************************************************************************************/
-void actualizarTelemetria(uint32_t tiempoActual)
+void recibirComandosTelemetria(void)
 {
-    UNUSED(tiempoActual);
-    float ref[3], w1[3], w2[3], w3[3], wG[3], a1[3], a2[3], a3[3], aG[3], euler[3], u[3];
+    uint32_t numBytes = bytesRecibidosUSB();
+
+    while (numBytes-- > 0) {
+        const int16_t dato = leerUSB();
+        if (dato < 0)
+            break;
+
+        // Busqueda del sincronismo
+        if (telemetria.indiceComando == 0 && dato != SINCRONISMO_1_TELEMETRIA)
+            continue;
+
+        if (telemetria.indiceComando == 1 && dato != SINCRONISMO_2_TELEMETRIA) {
+            telemetria.indiceComando = dato == SINCRONISMO_1_TELEMETRIA ? 1 : 0;
+            continue;
+        }
+
+        telemetria.comando[telemetria.indiceComando++] = dato;
+
+        if (telemetria.indiceComando == TAM_CABECERA_TELEMETRIA) {
+            const cabeceraTelemetria_t *cabecera = (const cabeceraTelemetria_t *)telemetria.comando;
+
+            if (cabecera->tipo != TRAMA_TELEMETRIA_COMANDO || cabecera->longitud != TAM_CARGA_COMANDO_TELEMETRIA)
+                telemetria.indiceComando = 0;
+        }
+        else if (telemetria.indiceComando == TAM_TRAMA_COMANDO_TELEMETRIA) {
+            procesarComandoTelemetria();
+            telemetria.indiceComando = 0;
+        }
+    }
+}
 
-    refAngulosRC(ref);
 
-    giroNumIMU(IMU_1, w1);
-    giroNumIMU(IMU_2, w2);
-    giroNumIMU(IMU_3, w3);
-    giroIMU(wG);
+/***************************************************************************************
+**  Nombre:         void procesarComandoTelemetria(void)
+**  Descripcion:    Comprueba el CRC del comando recibido y lo ejecuta
+**  Parametros:     Ninguno
+**  Retorno:        Ninguno
+****************************************************************************************/
+void procesarComandoTelemetria(void)
+{
+    const cabeceraTelemetria_t *cabecera = (const cabeceraTelemetria_t *)telemetria.comando;
+    const uint8_t *carga = &telemetria.comando[TAM_CABECERA_TELEMETRIA];
+    const uint16_t tam = TAM_CABECERA_TELEMETRIA + TAM_CARGA_COMANDO_TELEMETRIA;
+    const uint16_t crc = telemetria.comando[tam] | (telemetria.comando[tam + 1] << 8);
 
-    acelNumIMU(IMU_1, a1);
-    acelNumIMU(IMU_2, a2);
-    acelNumIMU(IMU_3, a3);
-    acelIMU(aG);
+    if (calcularCRC16(VALOR_INICIO_CRC_TELEMETRIA, telemetria.comando, tam) != crc)
+        return;
 
-    actitudAHRS(euler);
+    const uint16_t divisor = carga[1] | (carga[2] << 8);
 
-    u[0] = uRollPID();
-    u[1] = uPitchPID();
-    u[2] = uYawPID();
+    switch (carga[0]) {
+        case COMANDO_TELEMETRIA_SUSCRIBIR:
+            suscribirCanalesTelemetria(cabecera->canales, divisor);
+            break;
 
+        case COMANDO_TELEMETRIA_CANCELAR:
+            suscribirCanalesTelemetria(UINT32_MAX, 0);
+            break;
 
-    iniciarBufferTelemetria();
+        case COMANDO_TELEMETRIA_ESQUEMA:
+        default:
+            break;
+    }
 
-    //insertarBufferTelemetria(ref, 3);
-    insertarBufferTelemetria(euler, 3);
-    /*insertarBufferTelemetria(wG, 3);
-    insertarBufferTelemetria(w1, 3);
-    insertarBufferTelemetria(w2, 3);
-    insertarBufferTelemetria(w3, 3);
-    insertarBufferTelemetria(aG, 3);
-    insertarBufferTelemetria(a1, 3);
-    insertarBufferTelemetria(a2, 3);
-    insertarBufferTelemetria(a3, 3);
-    insertarBufferTelemetria(u, 3);*/
-    terminarBufferTelemetria();
+    // El esquema con los divisores actuales sirve de respuesta
+    telemetria.enviarEsquema = true;
+}
 
-    escribirBufferUSB(telBuffer.buffer, obtenerNumBytesBufferTelemetria());
-/*
 
-    sprintf(var, "%.02f,%.02f,%.02f", ref[0], ref[1], ref[2]);
-    escribirBufferUSB((uint8_t *)var, strlen(var));
+#ifdef USAR_IMU
+/***************************************************************************************
+**  Nombre:         void leerGiroIMUTelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Velocidad angular filtrada de una IMU
+**  Parametros:     Numero de IMU, valores
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerGiroIMUTelemetria(uint8_t instancia, void *valores)
+{
+    giroNumIMU(instancia, valores);
+}
+
+
+/***************************************************************************************
+**  Nombre:         void leerAcelIMUTelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Aceleracion de una IMU
+**  Parametros:     Numero de IMU, valores
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerAcelIMUTelemetria(uint8_t instancia, void *valores)
+{
+    acelNumIMU(instancia, valores);
+}
 
-    sprintf(var, "%.02f,%.02f,%.02f", euler[0], euler[1], euler[2]);
-    escribirBufferUSB((uint8_t *)var, strlen(var));
 
-    sprintf(var, "%.02f,%.02f,%.02f", wG[0], wG[1], wG[2]);
-    escribirBufferUSB((uint8_t *)var, strlen(var));
+/***************************************************************************************
+**  Nombre:         void leerGiroTelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Velocidad angular combinada de las IMUs
+**  Parametros:     Sin uso, valores
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerGiroTelemetria(uint8_t instancia, void *valores)
+{
+    UNUSED(instancia);
+    giroIMU(valores);
+}
 
-    sprintf(var, "%.02f,%.02f,%.02f", w1[0], w1[1], w1[2]);
-    escribirBufferUSB((uint8_t *)var, strlen(var));
 
-    sprintf(var, "%.02f,%.02f,%.02f", w2[0], w2[1], w2[2]);
-    escribirBufferUSB((uint8_t *)var, strlen(var));
+/***************************************************************************************
+**  Nombre:         void leerAcelTelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Aceleracion combinada de las IMUs
+**  Parametros:     Sin uso, valores
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerAcelTelemetria(uint8_t instancia, void *valores)
+{
+    UNUSED(instancia);
+    acelIMU(valores);
+}
+#endif
 
-    sprintf(var, "%.02f,%.02f,%.02f", w3[0], w3[1], w3[2]);
-    escribirBufferUSB((uint8_t *)var, strlen(var));
 
-    sprintf(var, "%.02f,%.02f,%.02f", aG[0], aG[1], aG[2]);
-    escribirBufferUSB((uint8_t *)var, strlen(var));
+/***************************************************************************************
+**  Nombre:         void leerActitudTelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Angulos de Euler del AHRS
+**  Parametros:     Sin uso, valores
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerActitudTelemetria(uint8_t instancia, void *valores)
+{
+    UNUSED(instancia);
+    actitudAHRS(valores);
+}
 
-    sprintf(var, "%.02f,%.02f,%.02f", a1[0], a1[1], a1[2]);
-    escribirBufferUSB((uint8_t *)var, strlen(var));
 
-    sprintf(var, "%.02f,%.02f,%.02f", a2[0], a2[1], a2[2]);
-    escribirBufferUSB((uint8_t *)var, strlen(var));
+/***************************************************************************************
+**  Nombre:         void leerVelAngularTelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Velocidad angular del AHRS
+**  Parametros:     Sin uso, valores
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerVelAngularTelemetria(uint8_t instancia, void *valores)
+{
+    UNUSED(instancia);
+    velAngularAHRS(valores);
+}
 
-    sprintf(var, "%.02f,%.02f,%.02f", a3[0], a3[1], a3[2]);
-    escribirBufferUSB((uint8_t *)var, strlen(var));
 
-    sprintf(var, "%.02f,%.02f,%.02f", u[0], u[1], u[2]);
-    escribirBufferUSB((uint8_t *)var, strlen(var));
-    terminarBufferTelemetria();
-*/
-    numBytes = bytesRecibidosUSB();
-    while (numBytes > 0) {
+/***************************************************************************************
+**  Nombre:         void leerPosicionTelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Posicion del AHRS
+**  Parametros:     Sin uso, valores
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerPosicionTelemetria(uint8_t instancia, void *valores)
+{
+    UNUSED(instancia);
+    posicionAHRS(valores);
+}
 
-        dato = leerUSB();
-        numBytes = numBytes-1;
 
-    }
+/***************************************************************************************
+**  Nombre:         void leerVelLinealTelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Velocidad lineal del AHRS
+**  Parametros:     Sin uso, valores
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerVelLinealTelemetria(uint8_t instancia, void *valores)
+{
+    UNUSED(instancia);
+    velLinealAHRS(valores);
+}
+
 
+/***************************************************************************************
+**  Nombre:         void leerRefRCtelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Referencias de angulo de la RC
+**  Parametros:     Sin uso, valores
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerRefRCtelemetria(uint8_t instancia, void *valores)
+{
+    UNUSED(instancia);
+    refAngulosRC(valores);
 }
 
 
 /***************************************************************************************
-**  Nombre:         void iniciarBufferTelemetria(void)
-**  Descripcion:    Inicia el buffer de la telemetria
-**  Parametros:     Dato a insertar
+**  Nombre:         void leerPIDtelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Acciones de control de roll, pitch, yaw y altura
+**  Parametros:     Sin uso, valores
 **  Retorno:        Ninguno
 ****************************************************************************************/
-void iniciarBufferTelemetria(void)
+void leerPIDtelemetria(uint8_t instancia, void *valores)
 {
-    telBuffer.indice = 0;
+    float *u = valores;
+
+    UNUSED(instancia);
+    u[0] = uRollPID();
+    u[1] = uPitchPID();
+    u[2] = uYawPID();
+    u[3] = uAltPID();
 }
 
 
+#ifdef USAR_RADIO
 /***************************************************************************************
-**  Nombre:         void terminarBufferTelemetria(void)
-**  Descripcion:    Termina el buffer de la telemetria
-**  Parametros:     Dato a insertar
+**  Nombre:         void leerRadioTelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Primeros canales de la radio
+**  Parametros:     Sin uso, valores
 **  Retorno:        Ninguno
 ****************************************************************************************/
-void terminarBufferTelemetria(void)
+void leerRadioTelemetria(uint8_t instancia, void *valores)
 {
-    telBuffer.buffer[telBuffer.indice] = '\r';
-    telBuffer.indice++;
-    telBuffer.buffer[telBuffer.indice] = '\n';
-    telBuffer.indice++;
+    int32_t *canal = valores;
+
+    UNUSED(instancia);
+    for (uint8_t i = 0; i < canalesTelemetria[CANAL_TELEMETRIA_RADIO].numValores; i++)
+        canal[i] = canalRadio(i);
 }
 
 
 /***************************************************************************************
-**  Nombre:         void insertarDatoTelemetria(float dato)
-**  Descripcion:    Inserta un float en el buffer de telemetria
-**  Parametros:     Dato a insertar
+**  Nombre:         void leerLatenciaRadioTelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Latencia ultima, maxima y media desde la trama de radio hasta la RC
+**  Parametros:     Sin uso, valores
 **  Retorno:        Ninguno
 ****************************************************************************************/
-void insertarDatoTelemetria(float dato)
+void leerLatenciaRadioTelemetria(uint8_t instancia, void *valores)
 {
-	datoTelemetria_t datoTel;
+    const latenciaRadio_t *latencia = latenciaRadio();
+    int32_t *us = valores;
 
-	datoTel.valor = dato;
-    for (uint8_t i = 0; i < 4; i++) {
-    	telBuffer.buffer[telBuffer.indice] = datoTel.byte[i];
-    	telBuffer.indice++;
-    }
+    UNUSED(instancia);
+    us[0] = latencia->ultima;
+    us[1] = latencia->maxima;
+    us[2] = latencia->media;
 }
+#endif
 
 
+#ifdef USAR_MOTORES
 /***************************************************************************************
-**  Nombre:         void insertarBufferTelemetria(float *dato, uint16_t longitud)
-**  Descripcion:    Inserta un buffer de float en el buffer de telemetria
-**  Parametros:     Buffer a insertar, longitud del buffer
+**  Nombre:         void leerMotoresTelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Salida de los motores
+**  Parametros:     Sin uso, valores
 **  Retorno:        Ninguno
 ****************************************************************************************/
-void insertarBufferTelemetria(float *dato, uint16_t longitud)
+void leerMotoresTelemetria(uint8_t instancia, void *valores)
 {
-    for (uint8_t i = 0; i < longitud; i++)
-    	insertarDatoTelemetria(dato[i]);
+    float *motor = valores;
+
+    UNUSED(instancia);
+    for (uint8_t i = 0; i < NUM_MOTORES; i++)
+        motor[i] = valorMotor(i);
 }
+#endif
 
 
+#ifdef USAR_SALIDA_DSHOT
 /***************************************************************************************
-**  Nombre:         uint16_t obtenerNumBytesBufferTelemetria(void)
-**  Descripcion:    Devuelve el numero de bytes cargados en el buffer
-**  Parametros:     Ninguno
-**  Retorno:        Numero de bytes
+**  Nombre:         void leerRPMmotoresTelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    rpm mecanicas de los motores obtenidas del DSHOT bidireccional
+**  Parametros:     Sin uso, valores
+**  Retorno:        Ninguno
 ****************************************************************************************/
-uint16_t obtenerNumBytesBufferTelemetria(void)
+void leerRPMmotoresTelemetria(uint8_t instancia, void *valores)
 {
-	return telBuffer.indice;
+    float *rpm = valores;
+
+    UNUSED(instancia);
+    for (uint8_t i = 0; i < NUM_MOTORES; i++)
+        rpm[i] = telemetriaMotorDshot(i)->frecuencia * 60.0f;
 }
+#endif
 
 
+#ifdef USAR_BARO
 /***************************************************************************************
-**  Nombre:         uint16_t obtenerNumDatosBufferTelemetria(void)
-**  Descripcion:    Devuelve el numero de floats cargados en el buffer
-**  Parametros:     Ninguno
-**  Retorno:        Numero de datos
+**  Nombre:         void leerBaroTelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Presion y temperatura combinadas de los barometros
+**  Parametros:     Sin uso, valores
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerBaroTelemetria(uint8_t instancia, void *valores)
+{
+    float *baro = valores;
+
+    UNUSED(instancia);
+    baro[0] = presionBaro();
+    baro[1] = temperaturaBaro();
+}
+#endif
+
+
+#ifdef USAR_MAG
+/***************************************************************************************
+**  Nombre:         void leerMagTelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Campo magnetico combinado de los magnetometros
+**  Parametros:     Sin uso, valores
+**  Retorno:        Ninguno
 ****************************************************************************************/
-uint16_t obtenerNumDatosBufferTelemetria(void)
+void leerMagTelemetria(uint8_t instancia, void *valores)
 {
-	return (telBuffer.indice - 2) / 4;
+    UNUSED(instancia);
+    campoMag(valores);
 }
 #endif
+
+
+#ifdef USAR_GPS
+/***************************************************************************************
+**  Nombre:         void leerGPStelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Latitud y longitud (grados * 10^7), altitud (cm) y satelites
+**  Parametros:     Sin uso, valores
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerGPStelemetria(uint8_t instancia, void *valores)
+{
+    int32_t *gps = valores;
+    localizacion_t loc;
+
+    UNUSED(instancia);
+    localizacionGPS(&loc);
+    gps[0] = loc.latitud;
+    gps[1] = loc.longitud;
+    gps[2] = loc.altitud;
+    gps[3] = satelitesGPS();
+}
+
+
+/***************************************************************************************
+**  Nombre:         void leerVelGPStelemetria(uint8_t instancia, void *valores)
+**  Descripcion:    Velocidad horizontal y angular del GPS
+**  Parametros:     Sin uso, valores
+**  Retorno:        Ninguno
+****************************************************************************************/
+void leerVelGPStelemetria(uint8_t instancia, void *valores)
+{
+    float *vel = valores;
+
+    UNUSED(instancia);
+    vel[0] = vel2dGPS();
+    vel[1] = velAngularGPS();
+}
+#endif
+
+#endif
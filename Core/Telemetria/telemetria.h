@@ -32,26 +32,90 @@
 #include <stdbool.h>
 
 #include "Sistema/plataforma.h"
-#include "Drivers/USB.h"
+#include "Drivers/usb.h"
 
 
 /***************************************************************************************
 ** AREA DE PREPROCESADOR                                                              **
 ****************************************************************************************/
+/*
+ * Tramas por USB (little endian):
+ *   cabecera (16 bytes) | carga (longitud bytes) | CRC16 de cabecera y carga
+ * En las tramas de datos la mascara de canales indica los canales que van en la carga, en
+ * orden de identificador, cada uno con numValores valores de 4 bytes. La trama de esquema
+ * lista los canales disponibles con su nombre, numero y tipo de valores y divisor actual.
+ * El PC manda tramas de comando con la misma cabecera: la mascara son los canales a los
+ * que afecta y la carga el codigo del comando y el divisor. Cada comando se contesta con
+ * el esquema. Los divisores son sobre la frecuencia de la tarea (0 no se envia el canal)
+ */
+#define SINCRONISMO_1_TELEMETRIA              'U'
+#define SINCRONISMO_2_TELEMETRIA              'R'
+#define VERSION_TELEMETRIA                    1
+#define TAM_CABECERA_TELEMETRIA               16
+#define TAM_CRC_TELEMETRIA                    2
+#define VALOR_INICIO_CRC_TELEMETRIA           0xFFFF
+#define NUM_MAX_VALORES_CANAL_TELEMETRIA      12
+#define TAM_MAX_CARGA_TELEMETRIA              1024
+#define TAM_MAX_TRAMA_TELEMETRIA              (TAM_CABECERA_TELEMETRIA + TAM_MAX_CARGA_TELEMETRIA + TAM_CRC_TELEMETRIA)
+#define TAM_CARGA_COMANDO_TELEMETRIA          3        // Codigo y divisor
 
 
 /***************************************************************************************
 ** AREA DE DEFINICION DE TIPOS                                                        **
 ****************************************************************************************/
-typedef union {
-	float valor;
-	uint8_t byte[4];
-} datoTelemetria_t;
+typedef enum {
+    TRAMA_TELEMETRIA_DATOS = 0,
+    TRAMA_TELEMETRIA_ESQUEMA,
+    TRAMA_TELEMETRIA_COMANDO,
+} tipoTramaTelemetria_e;
+
+typedef enum {
+    COMANDO_TELEMETRIA_ESQUEMA = 0,       // Pide el esquema
+    COMANDO_TELEMETRIA_SUSCRIBIR,         // Ajusta el divisor de los canales de la mascara
+    COMANDO_TELEMETRIA_CANCELAR,          // Deja de enviar todos los canales
+} comandoTelemetria_e;
+
+typedef enum {
+    VALOR_TELEMETRIA_FLOAT = 0,
+    VALOR_TELEMETRIA_INT32,
+} tipoValorTelemetria_e;
+
+// Los identificadores no cambian entre placas: los canales que no existen no se envian
+typedef enum {
+    CANAL_TELEMETRIA_GIRO_IMU_1 = 0,
+    CANAL_TELEMETRIA_GIRO_IMU_2,
+    CANAL_TELEMETRIA_GIRO_IMU_3,
+    CANAL_TELEMETRIA_ACEL_IMU_1,
+    CANAL_TELEMETRIA_ACEL_IMU_2,
+    CANAL_TELEMETRIA_ACEL_IMU_3,
+    CANAL_TELEMETRIA_GIRO,
+    CANAL_TELEMETRIA_ACEL,
+    CANAL_TELEMETRIA_ACTITUD,
+    CANAL_TELEMETRIA_VEL_ANGULAR,
+    CANAL_TELEMETRIA_POSICION,
+    CANAL_TELEMETRIA_VEL_LINEAL,
+    CANAL_TELEMETRIA_REF_RC,
+    CANAL_TELEMETRIA_RADIO,
+    CANAL_TELEMETRIA_PID,
+    CANAL_TELEMETRIA_MOTORES,
+    CANAL_TELEMETRIA_BARO,
+    CANAL_TELEMETRIA_MAG,
+    CANAL_TELEMETRIA_GPS,
+    CANAL_TELEMETRIA_VEL_GPS,
+    CANAL_TELEMETRIA_LATENCIA_RADIO,
+    CANAL_TELEMETRIA_RPM_MOTORES,
+    NUM_CANALES_TELEMETRIA,
+} canalTelemetria_e;
 
 typedef struct {
-	uint16_t indice;
-	uint8_t buffer[500];
-} bufferTelemetria_t;
+    uint8_t sincronismo[2];
+    uint8_t tipo;                         // tipoTramaTelemetria_e
+    uint8_t version;
+    uint16_t longitud;                    // Bytes de carga
+    uint16_t secuencia;
+    uint32_t tiempo;                      // us
+    uint32_t canales;                     // Mascara de canales
+} __attribute__((packed)) cabeceraTelemetria_t;
 
 
 /***************************************************************************************
@@ -62,7 +126,10 @@ typedef struct {
 /***************************************************************************************
 ** AREA DE PROTOTIPOS DE FUNCION                                                      **
 ****************************************************************************************/
+void iniciarTelemetria(void);
 void actualizarTelemetria(uint32_t tiempoActual);
-
+bool suscribirCanalesTelemetria(uint32_t canales, uint16_t divisor);
+uint32_t canalesDisponiblesTelemetria(void);
+uint32_t tramasPerdidasTelemetria(void);
 
 #endif // __TELEMETRIA_H_